@@ -1131,6 +1131,12 @@ nvme_dump_rdma_statistics(struct spdk_nvme_transport_poll_group_stat *stat)
 		printf("\tsend_doorbell_updates: %"PRIu64"\n", device_stats->send_doorbell_updates);
 		printf("\ttotal_recv_wrs:        %"PRIu64"\n", device_stats->total_recv_wrs);
 		printf("\trecv_doorbell_updates: %"PRIu64"\n", device_stats->recv_doorbell_updates);
+		if (device_stats->srq_size != 0) {
+			printf("\tsrq_size:              %"PRIu64"\n", device_stats->srq_size);
+			printf("\tsrq_rsps:              %"PRIu64"\n", device_stats->srq_rsps);
+			printf("\tsrq_queue_depth:       %"PRIu64"\n", device_stats->srq_queue_depth);
+			printf("\tsrq_reclaimed_recvs:   %"PRIu64"\n", device_stats->srq_reclaimed_recvs);
+		}
 		printf("\t---------------------------------\n");
 	}
 }
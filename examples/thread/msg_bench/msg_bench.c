@@ -0,0 +1,371 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+/*
+ * Measures spdk_thread_send_msg() with many producer threads sending to a single consumer
+ * thread, the pattern of e.g. the blobstore metadata thread or the bdev QoS thread.
+ * Each producer keeps a fixed number of messages in flight. The consumer runs on the app
+ * thread and records how long each message waited between being sent and being executed.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/thread.h"
+#include "spdk/env.h"
+#include "spdk/event.h"
+#include "spdk/log.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+#include "spdk/histogram_data.h"
+
+struct producer;
+
+struct bench_msg {
+	struct producer		*producer;
+	uint64_t		tsc;
+};
+
+struct producer {
+	uint32_t		id;
+	struct spdk_thread	*thread;
+	struct spdk_poller	*poller;
+	struct bench_msg	*msgs;
+	/* Only updated by the producer */
+	uint64_t		sent;
+	/* Only updated by the consumer */
+	uint64_t		completed;
+	TAILQ_ENTRY(producer)	link;
+};
+
+static TAILQ_HEAD(, producer) g_producers = TAILQ_HEAD_INITIALIZER(g_producers);
+static struct spdk_thread *g_consumer;
+static struct spdk_poller *g_stop_poller;
+static struct spdk_histogram_data *g_histogram;
+static uint32_t g_num_producers;
+static uint32_t g_num_running_producers;
+static uint32_t g_queue_depth = 32;
+static uint32_t g_msg_rings = 1;
+static int g_time_in_sec = 5;
+static uint64_t g_tsc_rate;
+static uint64_t g_start_tsc;
+static uint64_t g_end_tsc;
+static uint64_t g_consumed;
+static uint64_t g_consumed_at_end;
+static int g_rc;
+
+static const double g_latency_cutoffs[] = {
+	0.5,
+	0.9,
+	0.99,
+	0.999,
+	0.9999,
+	-1,
+};
+
+static void
+usage(void)
+{
+	printf("msg_bench options:\n");
+	printf("\t[-P number of producer threads (default: one per core besides the main core)]\n");
+	printf("\t[-q messages in flight per producer (default: 32)]\n");
+	printf("\t[-N message rings per thread, a power of 2 (default: 1)]\n");
+	printf("\t[-t time in seconds (default: 5)]\n");
+}
+
+static int
+parse_args(int ch, char *arg)
+{
+	long argval;
+
+	argval = spdk_strtol(arg, 10);
+	if (argval <= 0) {
+		fprintf(stderr, "-%c option must be positive.\n", ch);
+		usage();
+		return 1;
+	}
+
+	switch (ch) {
+	case 'P':
+		g_num_producers = argval;
+		break;
+	case 'q':
+		g_queue_depth = argval;
+		break;
+	case 'N':
+		g_msg_rings = argval;
+		break;
+	case 't':
+		g_time_in_sec = argval;
+		break;
+	default:
+		usage();
+		return 1;
+	}
+
+	return 0;
+}
+
+static void
+check_cutoff(void *ctx, uint64_t start, uint64_t end, uint64_t count,
+	     uint64_t total, uint64_t so_far)
+{
+	double so_far_pct;
+	const double **cutoff = ctx;
+
+	if (count == 0) {
+		return;
+	}
+
+	so_far_pct = (double)so_far / total;
+	while (so_far_pct >= **cutoff && **cutoff > 0) {
+		printf("%9.5f%% : %9.3fus\n", **cutoff * 100, (double)end * SPDK_SEC_TO_USEC / g_tsc_rate);
+		(*cutoff)++;
+	}
+}
+
+static void
+dump_result(void)
+{
+	const double *cutoff = g_latency_cutoffs;
+	double seconds = (double)(g_end_tsc - g_start_tsc) / g_tsc_rate;
+
+	printf("Producers:                 %" PRIu32 "\n", g_num_producers);
+	printf("Messages in flight each:   %" PRIu32 "\n", g_queue_depth);
+	printf("Message rings per thread:  %" PRIu32 "\n", g_msg_rings);
+	printf("Messages:                  %" PRIu64 "\n", g_consumed_at_end);
+	printf("Messages per second:       %.0f\n", g_consumed_at_end / seconds);
+	printf("\nLatency from send to execution:\n");
+	printf("=================================\n");
+	spdk_histogram_data_iterate(g_histogram, check_cutoff, &cutoff);
+}
+
+static void
+consume_msg(void *ctx)
+{
+	struct bench_msg *msg = ctx;
+
+	spdk_histogram_data_tally(g_histogram, spdk_get_ticks() - msg->tsc);
+	g_consumed++;
+	__atomic_store_n(&msg->producer->completed, msg->producer->completed + 1, __ATOMIC_RELEASE);
+}
+
+static int
+producer_poll(void *ctx)
+{
+	struct producer *producer = ctx;
+	struct bench_msg *msg;
+	uint64_t completed;
+	int count = 0;
+
+	completed = __atomic_load_n(&producer->completed, __ATOMIC_ACQUIRE);
+	while (producer->sent - completed < g_queue_depth) {
+		/* Messages from one producer are executed in order, so the slot of the oldest
+		 * completed message is free again */
+		msg = &producer->msgs[producer->sent % g_queue_depth];
+		msg->tsc = spdk_get_ticks();
+		if (spdk_thread_send_msg(g_consumer, consume_msg, msg) != 0) {
+			break;
+		}
+		producer->sent++;
+		count++;
+	}
+
+	return count > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
+static void
+free_producers(void)
+{
+	struct producer *producer, *tmp;
+
+	TAILQ_FOREACH_SAFE(producer, &g_producers, link, tmp) {
+		TAILQ_REMOVE(&g_producers, producer, link);
+		free(producer->msgs);
+		free(producer);
+	}
+}
+
+static void
+producer_stopped(void *ctx)
+{
+	/* All messages of the producer were sent before this one, so they are all consumed */
+	assert(g_num_running_producers > 0);
+	if (--g_num_running_producers > 0) {
+		return;
+	}
+
+	if (g_rc == 0) {
+		dump_result();
+	}
+
+	free_producers();
+	spdk_histogram_data_free(g_histogram);
+	spdk_app_stop(g_rc);
+}
+
+static void
+producer_stop(void *ctx)
+{
+	struct producer *producer = ctx;
+
+	spdk_poller_unregister(&producer->poller);
+	spdk_thread_send_msg(g_consumer, producer_stopped, producer);
+	spdk_thread_exit(producer->thread);
+}
+
+static void
+producer_exit(void *ctx)
+{
+	spdk_thread_exit(spdk_get_thread());
+}
+
+static void
+producer_start(void *ctx)
+{
+	struct producer *producer = ctx;
+
+	producer->poller = SPDK_POLLER_REGISTER(producer_poll, producer, 0);
+	if (producer->poller == NULL) {
+		SPDK_ERRLOG("Failed to register poller of producer %" PRIu32 "\n", producer->id);
+		g_rc = -ENOMEM;
+	}
+}
+
+static int
+bench_stop(void *ctx)
+{
+	struct producer *producer;
+
+	spdk_poller_unregister(&g_stop_poller);
+
+	g_end_tsc = spdk_get_ticks();
+	g_consumed_at_end = g_consumed;
+
+	TAILQ_FOREACH(producer, &g_producers, link) {
+		spdk_thread_send_msg(producer->thread, producer_stop, producer);
+	}
+
+	return SPDK_POLLER_BUSY;
+}
+
+static int
+create_producers(void)
+{
+	struct spdk_cpuset cpumask;
+	struct producer *producer;
+	uint32_t main_core = spdk_env_get_current_core();
+	uint32_t core, i, j;
+	char name[32];
+
+	if (g_num_producers == 0) {
+		g_num_producers = spdk_max(spdk_env_get_core_count() - 1, 1);
+	}
+
+	core = main_core;
+	for (i = 0; i < g_num_producers; i++) {
+		/* Spread the producers over the cores other than the one of the consumer */
+		do {
+			core = spdk_env_get_next_core(core);
+			if (core == UINT32_MAX) {
+				core = spdk_env_get_first_core();
+			}
+		} while (core == main_core && spdk_env_get_core_count() > 1);
+
+		producer = calloc(1, sizeof(*producer));
+		if (producer == NULL) {
+			return -ENOMEM;
+		}
+
+		producer->id = i;
+		producer->msgs = calloc(g_queue_depth, sizeof(*producer->msgs));
+		if (producer->msgs == NULL) {
+			free(producer);
+			return -ENOMEM;
+		}
+		TAILQ_INSERT_TAIL(&g_producers, producer, link);
+
+		for (j = 0; j < g_queue_depth; j++) {
+			producer->msgs[j].producer = producer;
+		}
+
+		spdk_cpuset_zero(&cpumask);
+		spdk_cpuset_set_cpu(&cpumask, core, true);
+		snprintf(name, sizeof(name), "producer_%" PRIu32, i);
+		producer->thread = spdk_thread_create(name, &cpumask);
+		if (producer->thread == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+static void
+bench_start(void *ctx)
+{
+	struct producer *producer;
+	int rc;
+
+	g_consumer = spdk_get_thread();
+	g_tsc_rate = spdk_get_ticks_hz();
+
+	g_histogram = spdk_histogram_data_alloc();
+	if (g_histogram == NULL) {
+		spdk_app_stop(-ENOMEM);
+		return;
+	}
+
+	rc = create_producers();
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to create producers: %s\n", spdk_strerror(-rc));
+		TAILQ_FOREACH(producer, &g_producers, link) {
+			if (producer->thread != NULL) {
+				spdk_thread_send_msg(producer->thread, producer_exit, NULL);
+			}
+		}
+		free_producers();
+		spdk_histogram_data_free(g_histogram);
+		spdk_app_stop(rc);
+		return;
+	}
+
+	g_stop_poller = SPDK_POLLER_REGISTER(bench_stop, NULL, g_time_in_sec * SPDK_SEC_TO_USEC);
+
+	g_num_running_producers = g_num_producers;
+	g_start_tsc = spdk_get_ticks();
+	TAILQ_FOREACH(producer, &g_producers, link) {
+		spdk_thread_send_msg(producer->thread, producer_start, producer);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_app_opts opts = {};
+	int rc;
+
+	spdk_app_opts_init(&opts, sizeof(opts));
+	opts.name = "msg_bench";
+	opts.rpc_addr = NULL;
+
+	rc = spdk_app_parse_args(argc, argv, &opts, "P:q:N:t:", NULL, parse_args, usage);
+	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
+		return rc == SPDK_APP_PARSE_ARGS_HELP ? 0 : 1;
+	}
+
+	rc = spdk_thread_lib_set_msg_ring_count(g_msg_rings);
+	if (rc != 0) {
+		fprintf(stderr, "Invalid number of message rings %" PRIu32 "\n", g_msg_rings);
+		return 1;
+	}
+
+	rc = spdk_app_start(&opts, bench_start, NULL);
+	if (rc != 0) {
+		SPDK_ERRLOG("ERROR starting application\n");
+	}
+
+	spdk_app_fini();
+
+	return rc;
+}
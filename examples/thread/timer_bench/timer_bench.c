@@ -0,0 +1,200 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+/*
+ * Measures the cost of timed pollers with the two ways a thread can keep track of them,
+ * a tree ordered by expiration (the default) and a hierarchical timer wheel (-w). Many
+ * trivial timed pollers with periods spread over a range are registered on the app thread,
+ * so the time the thread spends per poller run is dominated by rescheduling the pollers.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/thread.h"
+#include "spdk/env.h"
+#include "spdk/event.h"
+#include "spdk/log.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+
+struct bench_poller {
+	struct spdk_poller	*poller;
+	uint64_t		runs;
+};
+
+static struct bench_poller *g_pollers;
+static struct spdk_poller *g_stop_poller;
+static uint32_t g_num_pollers = 10000;
+static uint32_t g_min_period_us = 1;
+static uint32_t g_max_period_us = 1000;
+static int g_time_in_sec = 5;
+static bool g_timer_wheel;
+static uint64_t g_tsc_rate;
+static uint64_t g_register_tsc;
+static uint64_t g_start_tsc;
+static struct spdk_thread_stats g_start_stats;
+
+static void
+usage(void)
+{
+	printf("timer_bench options:\n");
+	printf("\t[-P number of timed pollers (default: 10000)]\n");
+	printf("\t[-l shortest poller period in microseconds (default: 1)]\n");
+	printf("\t[-M longest poller period in microseconds (default: 1000)]\n");
+	printf("\t[-t time in seconds (default: 5)]\n");
+	printf("\t[-w use the timer wheel instead of the tree]\n");
+}
+
+static int
+parse_args(int ch, char *arg)
+{
+	long argval = 0;
+
+	if (ch != 'w') {
+		argval = spdk_strtol(arg, 10);
+		if (argval <= 0) {
+			fprintf(stderr, "-%c option must be positive.\n", ch);
+			usage();
+			return 1;
+		}
+	}
+
+	switch (ch) {
+	case 'P':
+		g_num_pollers = argval;
+		break;
+	case 'l':
+		g_min_period_us = argval;
+		break;
+	case 'M':
+		g_max_period_us = argval;
+		break;
+	case 't':
+		g_time_in_sec = argval;
+		break;
+	case 'w':
+		g_timer_wheel = true;
+		break;
+	default:
+		usage();
+		return 1;
+	}
+
+	return 0;
+}
+
+static int
+bench_poll(void *ctx)
+{
+	struct bench_poller *bp = ctx;
+
+	bp->runs++;
+
+	return SPDK_POLLER_BUSY;
+}
+
+static int
+bench_stop(void *ctx)
+{
+	struct spdk_thread_stats stats;
+	uint64_t end_tsc = spdk_get_ticks();
+	uint64_t runs = 0, busy_tsc;
+	double seconds = (double)(end_tsc - g_start_tsc) / g_tsc_rate;
+	uint32_t i;
+
+	spdk_poller_unregister(&g_stop_poller);
+
+	spdk_thread_get_stats(&stats);
+	busy_tsc = stats.busy_tsc - g_start_stats.busy_tsc;
+
+	for (i = 0; i < g_num_pollers; i++) {
+		runs += g_pollers[i].runs;
+		spdk_poller_unregister(&g_pollers[i].poller);
+	}
+
+	printf("Timed pollers:             %s\n", g_timer_wheel ? "timer wheel" : "tree");
+	printf("Pollers:                   %" PRIu32 "\n", g_num_pollers);
+	printf("Periods:                   %" PRIu32 "-%" PRIu32 "us\n", g_min_period_us, g_max_period_us);
+	printf("Register ticks per poller: %.1f\n", (double)g_register_tsc / g_num_pollers);
+	printf("Poller runs:               %" PRIu64 "\n", runs);
+	printf("Poller runs per second:    %.0f\n", runs / seconds);
+	printf("Busy ticks per poller run: %.1f\n", runs ? (double)busy_tsc / runs : 0.0);
+
+	free(g_pollers);
+	spdk_app_stop(0);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+bench_start(void *ctx)
+{
+	uint64_t period_us, start_tsc;
+	uint32_t i;
+
+	g_tsc_rate = spdk_get_ticks_hz();
+
+	g_pollers = calloc(g_num_pollers, sizeof(*g_pollers));
+	if (g_pollers == NULL) {
+		spdk_app_stop(-ENOMEM);
+		return;
+	}
+
+	srand(0);
+	start_tsc = spdk_get_ticks();
+	for (i = 0; i < g_num_pollers; i++) {
+		period_us = g_min_period_us + rand() % (g_max_period_us - g_min_period_us + 1);
+		g_pollers[i].poller = SPDK_POLLER_REGISTER(bench_poll, &g_pollers[i], period_us);
+		if (g_pollers[i].poller == NULL) {
+			SPDK_ERRLOG("Failed to register poller %" PRIu32 "\n", i);
+			while (i-- > 0) {
+				spdk_poller_unregister(&g_pollers[i].poller);
+			}
+			free(g_pollers);
+			spdk_app_stop(-ENOMEM);
+			return;
+		}
+	}
+	g_register_tsc = spdk_get_ticks() - start_tsc;
+
+	g_stop_poller = SPDK_POLLER_REGISTER(bench_stop, NULL, g_time_in_sec * SPDK_SEC_TO_USEC);
+
+	spdk_thread_get_stats(&g_start_stats);
+	g_start_tsc = spdk_get_ticks();
+}
+
+int
+main(int argc, char **argv)
+{
+	struct spdk_app_opts opts = {};
+	int rc;
+
+	spdk_app_opts_init(&opts, sizeof(opts));
+	opts.name = "timer_bench";
+	opts.rpc_addr = NULL;
+
+	rc = spdk_app_parse_args(argc, argv, &opts, "P:l:M:t:w", NULL, parse_args, usage);
+	if (rc != SPDK_APP_PARSE_ARGS_SUCCESS) {
+		return rc == SPDK_APP_PARSE_ARGS_HELP ? 0 : 1;
+	}
+
+	if (g_min_period_us > g_max_period_us) {
+		fprintf(stderr, "Shortest period must not be longer than the longest one\n");
+		return 1;
+	}
+
+	rc = spdk_thread_lib_set_timer_wheel(g_timer_wheel);
+	if (rc != 0) {
+		return 1;
+	}
+
+	rc = spdk_app_start(&opts, bench_start, NULL);
+	if (rc != 0) {
+		SPDK_ERRLOG("ERROR starting application\n");
+	}
+
+	spdk_app_fini();
+
+	return rc;
+}
@@ -215,8 +215,17 @@ struct spdk_bdev_opts {
 	/* Size of the per-thread iobuf caches */
 	uint32_t iobuf_small_cache_size;
 	uint32_t iobuf_large_cache_size;
+
+	/**
+	 * Meter QoS rate limits with quota that each channel draws in batches from the
+	 * bdev's shared budget, instead of charging the shared budget for every I/O.
+	 */
+	bool qos_distributed;
+
+	/* Hole at bytes 33-39. */
+	uint8_t reserved33[7];
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_opts) == 32, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_opts) == 40, "Incorrect size");
 
 /**
  * Union for controller attributes field, to list whether bdev supports fdp etc.
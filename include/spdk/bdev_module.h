@@ -421,6 +421,17 @@ typedef TAILQ_HEAD(, spdk_bdev_io) bdev_io_tailq_t;
 typedef STAILQ_HEAD(, spdk_bdev_io) bdev_io_stailq_t;
 typedef TAILQ_HEAD(, lba_range) lba_range_tailq_t;
 
+/**
+ * Interval index of locked LBA ranges, ordered by offset.  Laid out like RB_HEAD() so that
+ * the RB_* macros of spdk/tree.h can be used with it.
+ */
+struct lba_range_tree {
+	struct lba_range *rbh_root;
+
+	/** Length of the longest range in the tree, bounds the overlap lookups. */
+	uint64_t max_length;
+};
+
 struct spdk_bdev {
 	/** User context passed in by the backend */
 	void *ctxt;
@@ -460,6 +471,14 @@ struct spdk_bdev {
 	 */
 	bool split_on_write_unit;
 
+	/**
+	 * Specifies whether WRITE I/O smaller than write_unit_size is allowed
+	 * when split_on_write_unit is set. If set to true, the bdev layer will
+	 * still split WRITE I/O on write_unit_size boundaries, but will not fail
+	 * the resulting I/O that don't cover a whole write unit.
+	 */
+	bool allow_partial_write_unit;
+
 	/** Number of blocks required for write */
 	uint32_t write_unit_size;
 
@@ -751,7 +770,7 @@ struct spdk_bdev {
 		uint8_t	histogram_io_type;
 
 		/** Currently locked ranges for this bdev.  Used to populate new channels. */
-		lba_range_tailq_t locked_ranges;
+		struct lba_range_tree locked_ranges;
 
 		/** Pending locked ranges for this bdev.  These ranges are not currently
 		 *  locked due to overlapping with another locked range.
@@ -919,7 +938,10 @@ struct spdk_bdev_io_internal_fields {
 	/** The bdev I/O channel that this was handled on. */
 	struct spdk_bdev_channel *ch;
 
-	uint8_t	reserved[8];
+	/** NUMA node of the bdev_io pool this I/O was taken from. */
+	uint8_t numa_id;
+
+	uint8_t	reserved[7];
 
 	/** The bdev descriptor that was used when submitting this I/O. */
 	struct spdk_bdev_desc *desc;
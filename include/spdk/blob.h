@@ -63,6 +63,7 @@ struct spdk_bs_dev;
 struct spdk_io_channel;
 struct spdk_blob;
 struct spdk_xattr_names;
+struct spdk_bit_array;
 
 /**
  * Blobstore operation completion callback.
@@ -99,6 +100,17 @@ typedef void (*spdk_blob_op_complete)(void *cb_arg, int bserrno);
  */
 typedef void (*spdk_blob_op_with_id_complete)(void *cb_arg, spdk_blob_id blobid, int bserrno);
 
+/**
+ * Blob operation completion callback with an array of blob IDs.
+ *
+ * \param cb_arg Callback argument.
+ * \param blobids Array of blob IDs, only valid during the callback.
+ * \param count Number of entries in blobids.
+ * \param bserrno 0 if it completed successfully, or negative errno if it failed.
+ */
+typedef void (*spdk_blob_op_with_ids_complete)(void *cb_arg, const spdk_blob_id *blobids,
+		uint32_t count, int bserrno);
+
 /**
  * Blob operation completion callback with handle.
  *
@@ -314,8 +326,19 @@ struct spdk_bs_opts {
 	 * Context to pass with esnap_bs_dev_create.
 	 */
 	void *esnap_ctx;
+
+	/**
+	 * Granularity of copy-on-write from the parent of a clone, in bytes. 0 copies whole
+	 * clusters. Otherwise a first write to a cluster of a clone copies only the units of this
+	 * size that it touches. Must be a multiple of 4KiB page size dividing the cluster size
+	 * into at most 64 units. Only used by spdk_bs_init(), persisted in the blobstore.
+	 */
+	uint32_t cow_unit_size;
+
+	/* Hole at bytes 92-95. */
+	uint8_t reserved92[4];
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 88, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 96, "Incorrect size");
 
 /**
  * Initialize a spdk_bs_opts structure to the default blobstore option values.
@@ -553,6 +576,26 @@ uint64_t spdk_blob_get_next_allocated_io_unit(struct spdk_blob *blob, uint64_t o
  */
 uint64_t spdk_blob_get_next_unallocated_io_unit(struct spdk_blob *blob, uint64_t offset);
 
+/**
+ * Get the clusters that changed between a blob and one of its ancestors.
+ *
+ * A cluster is changed if it is allocated, fully or partially, to the blob or to any blob of
+ * its snapshot chain that is more recent than the ancestor. Clusters beyond the size of the
+ * ancestor are always reported as changed. The result is computed from the cluster maps of the
+ * blobs in memory, without any I/O. It must be called from the blobstore's metadata thread.
+ *
+ * \param blob Blob struct to query.
+ * \param ancestor_id The id of a snapshot in the chain of the blob, or SPDK_BLOBID_INVALID to
+ * report the clusters allocated anywhere in the chain.
+ * \param changed On success, set to a newly allocated bit array with one bit per cluster of the
+ * blob, with the bits of the changed clusters set. Caller must free it with spdk_bit_array_free().
+ *
+ * \return 0 on success, -EINVAL if ancestor_id is not an ancestor of the blob, -ENOMEM if out
+ * of memory.
+ */
+int spdk_blob_get_changed_clusters(struct spdk_blob *blob, spdk_blob_id ancestor_id,
+				   struct spdk_bit_array **changed);
+
 struct spdk_blob_xattr_opts {
 	/* Number of attributes */
 	size_t	count;
@@ -650,6 +693,30 @@ void spdk_bs_create_snapshot(struct spdk_blob_store *bs, spdk_blob_id blobid,
 			     const struct spdk_blob_xattr_opts *snapshot_xattrs,
 			     spdk_blob_op_with_id_complete cb_fn, void *cb_arg);
 
+/**
+ * Create read-only snapshots of several blobs at the same point in time.
+ *
+ * Works like spdk_bs_create_snapshot() for each blob, but the snapshot blobs are all created
+ * first, then I/O to all source blobs is frozen at once, the metadata of all of them is
+ * persisted concurrently and I/O is unfrozen only once every snapshot is complete. The
+ * snapshots are therefore consistent with each other and I/O is paused for a single window.
+ *
+ * If any blob cannot be snapshotted before I/O is frozen, no snapshot is taken. If persisting
+ * the metadata fails for some blobs, the snapshots of the others are kept and reported.
+ *
+ * \param bs blobstore.
+ * \param blobids Ids of the source blobs, must not contain duplicates.
+ * \param count Number of entries in blobids.
+ * \param snapshot_xattrs Array of count xattrs specified for each snapshot, or NULL. It and
+ * anything it references must be valid until the completion is called.
+ * \param cb_fn Called when the operation is complete with the ids of the snapshots, in the
+ * order of blobids. Entries of snapshots that were not created are SPDK_BLOBID_INVALID.
+ * \param cb_arg Argument passed to function cb_fn.
+ */
+void spdk_bs_create_snapshot_group(struct spdk_blob_store *bs, const spdk_blob_id *blobids,
+				   uint32_t count, const struct spdk_blob_xattr_opts *snapshot_xattrs,
+				   spdk_blob_op_with_ids_complete cb_fn, void *cb_arg);
+
 /**
  * Create a clone of specified read-only blob.
  *
@@ -823,6 +890,32 @@ int spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel
 			      spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
 			      spdk_blob_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Perform an incremental shallow copy of a blob to a blobstore device.
+ *
+ * Like spdk_bs_blob_shallow_copy(), but only the clusters that changed between the blob and
+ * the ancestor snapshot, as reported by spdk_blob_get_changed_clusters(), are written on the
+ * device. Copying a chain of snapshots oldest first, each one incrementally against the
+ * previous one, reproduces the content of the newest snapshot on the device.
+ *
+ * \param bs Blobstore
+ * \param channel IO channel used to copy the blob.
+ * \param blobid The id of the blob.
+ * \param ancestor_id The id of a snapshot in the chain of the blob.
+ * \param ext_dev The device to copy on
+ * \param status_cb_fn Called repeatedly during operation with status updates
+ * \param status_cb_arg Argument passed to function status_cb_fn.
+ * \param cb_fn Called when the operation is complete.
+ * \param cb_arg Argument passed to function cb_fn.
+ *
+ * \return 0 if operation starts correctly, negative errno on failure.
+ */
+int spdk_bs_blob_shallow_copy_incremental(struct spdk_blob_store *bs,
+		struct spdk_io_channel *channel, spdk_blob_id blobid,
+		spdk_blob_id ancestor_id, struct spdk_bs_dev *ext_dev,
+		spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+		spdk_blob_op_complete cb_fn, void *cb_arg);
+
 
 /**
  * Set a snapshot as the parent of a blob
@@ -1137,6 +1230,34 @@ void spdk_bs_iter_first(struct spdk_blob_store *bs,
 void spdk_bs_iter_next(struct spdk_blob_store *bs, struct spdk_blob *blob,
 		       spdk_blob_op_with_handle_complete cb_fn, void *cb_arg);
 
+/**
+ * Callback for spdk_bs_iter_blobs().
+ *
+ * \param cb_arg Argument passed to spdk_bs_iter_blobs().
+ * \param blob The open blob. It is closed by the iteration after the callback returns, so the
+ * callback must not close it and must not keep a reference to it.
+ * \return 0 to continue the iteration, any other value to stop it.
+ */
+typedef int (*spdk_blob_iter_cb)(void *cb_arg, struct spdk_blob *blob);
+
+/**
+ * Iterate over all blobs, opening several of them at once.
+ *
+ * The blobs are processed in batches of up to queue_depth. The first metadata pages of the
+ * blobs of a batch are read with a single request and the blobs are then opened in parallel.
+ * iter_fn is called for each blob of a batch in blob ID order, after all of them were opened.
+ * As with spdk_bs_iter_next(), blobs that cannot be opened are skipped.
+ *
+ * \param bs blobstore to traverse.
+ * \param queue_depth Maximum number of blobs opened at once.
+ * \param iter_fn Called for each blob.
+ * \param cb_fn Called when the iteration is complete, with the non-zero value returned by
+ * iter_fn if it stopped the iteration.
+ * \param cb_arg Argument passed to functions iter_fn and cb_fn.
+ */
+void spdk_bs_iter_blobs(struct spdk_blob_store *bs, uint32_t queue_depth,
+			spdk_blob_iter_cb iter_fn, spdk_bs_op_complete cb_fn, void *cb_arg);
+
 /**
  * Set an extended attribute for the given blob.
  *
@@ -40,6 +40,9 @@ enum lvs_clear_method {
 #define SPDK_LVS_NAME_MAX	64
 #define SPDK_LVOL_NAME_MAX	64
 
+/* Default number of blobs opened at once while loading an lvolstore */
+#define SPDK_LVS_LOAD_QUEUE_DEPTH_DEFAULT	32
+
 /**
  * Parameters for lvolstore initialization.
  */
@@ -69,8 +72,14 @@ struct spdk_lvs_opts {
 	 * is being loaded, the lvolstore will not support external snapshots.
 	 */
 	spdk_bs_esnap_dev_create esnap_bs_dev_create;
+
+	/**
+	 * Number of lvols opened at once while the lvolstore is being loaded. Their metadata is
+	 * read in batches of this size. Used only by spdk_lvs_load_ext().
+	 */
+	uint32_t		load_queue_depth;
 } __attribute__((packed));
-SPDK_STATIC_ASSERT(sizeof(struct spdk_lvs_opts) == 88, "Incorrect size");
+SPDK_STATIC_ASSERT(sizeof(struct spdk_lvs_opts) == 92, "Incorrect size");
 
 /**
  * Initialize an spdk_lvs_opts structure to the defaults.
@@ -108,6 +117,18 @@ typedef void (*spdk_lvs_op_complete)(void *cb_arg, int lvserrno);
 typedef void (*spdk_lvol_op_with_handle_complete)(void *cb_arg, struct spdk_lvol *lvol,
 		int lvolerrno);
 
+/**
+ * Callback definition for lvol operations with handles to several lvols.
+ *
+ * \param cb_arg Custom arguments
+ * \param lvols Array of handles to lvols, entries are NULL for lvols that were not created.
+ * Only valid during the callback.
+ * \param count Number of entries in lvols
+ * \param lvolerrno Error
+ */
+typedef void (*spdk_lvol_op_with_handles_complete)(void *cb_arg, struct spdk_lvol **lvols,
+		uint32_t count, int lvolerrno);
+
 /**
  * Callback definition for lvol operations without handle to lvol.
  *
@@ -205,6 +226,22 @@ int spdk_lvol_create(struct spdk_lvol_store *lvs, const char *name, uint64_t sz,
 void spdk_lvol_create_snapshot(struct spdk_lvol *lvol, const char *snapshot_name,
 			       spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg);
 
+/**
+ * Create snapshots of several lvols of the same lvolstore at the same point in time.
+ *
+ * I/O to all lvols is frozen together, for a single window, so that the snapshots are
+ * consistent with each other. See spdk_bs_create_snapshot_group().
+ *
+ * \param lvols Array of handles to lvols.
+ * \param snapshot_names Array of names of created snapshots, in the order of lvols.
+ * \param count Number of entries in lvols and snapshot_names.
+ * \param cb_fn Completion callback, with the snapshots in the order of lvols.
+ * \param cb_arg Completion callback custom arguments.
+ */
+void spdk_lvol_create_snapshot_group(struct spdk_lvol **lvols, const char **snapshot_names,
+				     uint32_t count, spdk_lvol_op_with_handles_complete cb_fn,
+				     void *cb_arg);
+
 /**
  * Create clone of given snapshot.
  *
@@ -410,6 +447,43 @@ int spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
 			   spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
 			   spdk_lvol_op_complete cb_fn, void *cb_arg);
 
+/**
+ * Make an incremental shallow copy of lvol on given bs_dev.
+ *
+ * Only the clusters that changed between the lvol and the ancestor snapshot are written, see
+ * spdk_lvol_get_changed_clusters(). Lvol must be read only and lvol size must be less or equal
+ * than bs_dev size.
+ *
+ * \param lvol Handle to lvol
+ * \param ancestor Handle to a snapshot in the chain of lvol
+ * \param ext_dev The bs_dev to copy on. This is created on the given bdev by using
+ * spdk_bdev_create_bs_dev_ext() beforehand
+ * \param status_cb_fn Called repeatedly during operation with status updates
+ * \param status_cb_arg Argument passed to function status_cb_fn.
+ * \param cb_fn Completion callback
+ * \param cb_arg Completion callback custom arguments
+ *
+ * \return 0 if operation starts correctly, negative errno on failure.
+ */
+int spdk_lvol_shallow_copy_incremental(struct spdk_lvol *lvol, struct spdk_lvol *ancestor,
+				       struct spdk_bs_dev *ext_dev,
+				       spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+				       spdk_lvol_op_complete cb_fn, void *cb_arg);
+
+/**
+ * Get the clusters that changed between an lvol and one of its ancestor snapshots.
+ *
+ * \param lvol Handle to lvol
+ * \param ancestor Handle to a snapshot in the chain of lvol, or NULL to get the clusters
+ * allocated anywhere in the chain.
+ * \param changed On success, set to a bit array with the bits of the changed clusters set.
+ * Caller must free it with spdk_bit_array_free().
+ *
+ * \return 0 on success, negative errno on failure, see spdk_blob_get_changed_clusters().
+ */
+int spdk_lvol_get_changed_clusters(struct spdk_lvol *lvol, struct spdk_lvol *ancestor,
+				   struct spdk_bit_array **changed);
+
 /**
  * Set a snapshot as the parent of a lvol
  *
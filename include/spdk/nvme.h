@@ -568,6 +568,14 @@ struct spdk_nvme_rdma_device_stat {
 	uint64_t send_doorbell_updates;
 	uint64_t total_recv_wrs;
 	uint64_t recv_doorbell_updates;
+	/* Size of the shared receive queue, 0 if it isn't used */
+	uint64_t srq_size;
+	/* Number of response buffers posted to the shared receive queue */
+	uint64_t srq_rsps;
+	/* Aggregate queue depth of the qpairs sharing the shared receive queue */
+	uint64_t srq_queue_depth;
+	/* Responses received for already destroyed qpairs, whose buffers were reposted */
+	uint64_t srq_reclaimed_recvs;
 };
 
 struct spdk_nvme_pcie_stat {
@@ -4445,7 +4453,9 @@ struct spdk_nvme_transport_opts {
 	/**
 	 * It is used for RDMA transport.
 	 *
-	 * The queue depth of a shared rdma receive queue.
+	 * The queue depth of a shared rdma receive queue.  Each poll group uses a shared receive
+	 * queue per RDMA device.  The response buffers posted to it follow the aggregate queue
+	 * depth of the qpairs using it, up to this size.
 	 */
 	uint32_t rdma_srq_size;
 
@@ -63,6 +63,10 @@ struct spdk_nvmf_target_opts {
 	uint32_t	discovery_filter;
 	uint32_t	dhchap_digests;
 	uint32_t	dhchap_dhgroups;
+	/* Maximum number of I/O commands each poll group submits at a time, the rest are queued
+	 * and dispatched fairly across controllers according to their host's weight.  0 disables
+	 * the I/O scheduler. */
+	uint32_t	io_sched_depth;
 };
 
 struct spdk_nvmf_transport_opts {
@@ -626,6 +630,11 @@ struct spdk_nvmf_host_opts {
 	struct spdk_key			*dhchap_key;
 	/** DH-HMAC-CHAP controller key */
 	struct spdk_key			*dhchap_ctrlr_key;
+	/**
+	 * Share of a poll group's I/O scheduler given to each controller of this host relative to
+	 * the other controllers, 0 means the default weight of 1.
+	 */
+	uint32_t			weight;
 };
 
 /**
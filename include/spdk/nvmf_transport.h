@@ -89,7 +89,8 @@ struct spdk_nvmf_request {
 			uint8_t data_from_pool		: 1;
 			uint8_t dif_enabled		: 1;
 			uint8_t first_fused		: 1;
-			uint8_t rsvd			: 5;
+			uint8_t io_sched		: 1;
+			uint8_t rsvd			: 4;
 		};
 	};
 	uint8_t				zcopy_phase; /* type enum spdk_nvmf_zcopy_phase */
@@ -125,8 +126,12 @@ struct spdk_nvmf_request {
 		uint32_t		remaining_length;
 	} iobuf;
 
-	/* Timeout tracked for connect and abort flows. */
-	uint64_t timeout_tsc;
+	union {
+		/* Timeout tracked for connect and abort flows. */
+		uint64_t timeout_tsc;
+		/* Time an I/O command was queued by the poll group I/O scheduler. */
+		uint64_t sched_tsc;
+	};
 };
 SPDK_STATIC_ASSERT(sizeof(struct spdk_nvmf_request) == 808, "Incorrect size");
 
@@ -142,6 +147,8 @@ enum spdk_nvmf_qpair_state {
 typedef void (*spdk_nvmf_state_change_done)(void *cb_arg, int status);
 
 struct spdk_nvmf_qpair_auth;
+struct spdk_nvmf_io_sched_flow;
+struct spdk_nvmf_io_sched;
 
 struct spdk_nvmf_qpair {
 	uint8_t					state; /* ref spdk_nvmf_qpair_state */
@@ -174,6 +181,9 @@ struct spdk_nvmf_qpair {
 	uint16_t				queue_depth;
 
 	struct spdk_nvmf_qpair_auth		*auth;
+
+	/* I/O scheduler flow of the controller, set on the first I/O command */
+	struct spdk_nvmf_io_sched_flow		*io_sched_flow;
 };
 
 struct spdk_nvmf_transport_poll_group {
@@ -207,6 +217,9 @@ struct spdk_nvmf_poll_group {
 	/* Statistics */
 	struct spdk_nvmf_poll_group_stat		stat;
 
+	/* Fair I/O scheduler, NULL if disabled */
+	struct spdk_nvmf_io_sched			*io_sched;
+
 	spdk_nvmf_poll_group_destroy_done_fn		destroy_cb_fn;
 	void						*destroy_cb_arg;
 
@@ -238,6 +238,17 @@ struct spdk_scheduler {
 	 */
 	void (*get_opts)(struct spdk_json_write_ctx *ctx);
 
+	/**
+	 * Optional function to check whether threads need to be balanced before the end
+	 * of the current scheduling period, e.g. because a core got overloaded. It is called
+	 * on the scheduling reactor on each of its iterations, so it should return quickly.
+	 *
+	 * \param now Current tick count.
+	 *
+	 * \return true to start balancing right away, false to wait for the end of the period.
+	 */
+	bool (*check_balance)(uint64_t now);
+
 	TAILQ_ENTRY(spdk_scheduler)	link;
 };
 
@@ -607,6 +607,33 @@ int spdk_sock_group_poll(struct spdk_sock_group *group);
  */
 int spdk_sock_group_poll_count(struct spdk_sock_group *group, int max_events);
 
+/**
+ * Send statistics of a socket group.
+ */
+struct spdk_sock_group_stat {
+	/**
+	 * Number of sendmsg operations issued for the sockets of the group. For io_uring based
+	 * implementations, these are the sendmsg operations submitted to the ring.
+	 */
+	uint64_t sendmsg_calls;
+
+	/** Number of write requests (see spdk_sock_writev_async()) that were completely sent. */
+	uint64_t sent_requests;
+};
+
+/**
+ * Get the send statistics of a socket group.
+ *
+ * The ratio of sent_requests to sendmsg_calls shows how many asynchronous writes were
+ * coalesced into a single sendmsg operation on average.
+ *
+ * \param group Socket group.
+ * \param stat Statistics, filled in on success.
+ *
+ * \return 0 on success, -1 on failure with errno set.
+ */
+int spdk_sock_group_get_stat(struct spdk_sock_group *group, struct spdk_sock_group_stat *stat);
+
 /**
  * Close all registered sockets of the group and then remove the group.
  *
@@ -179,6 +179,11 @@ typedef void (*spdk_channel_for_each_cpl)(struct spdk_io_channel_iter *i, int st
 /* Power of 2 minus 1 is optimal for memory consumption */
 #define SPDK_DEFAULT_MSG_MEMPOOL_SIZE (262144 - 1)
 
+/**
+ * Largest number of message rings per thread, see spdk_thread_lib_set_msg_ring_count().
+ */
+#define SPDK_THREAD_MAX_MSG_RINGS	16
+
 /**
  * Initialize the threading library. Must be called once prior to allocating any threads.
  *
@@ -210,6 +215,40 @@ int spdk_thread_lib_init_ext(spdk_thread_op_fn thread_op_fn,
 			     spdk_thread_op_supported_fn thread_op_supported_fn,
 			     size_t ctx_sz, size_t msg_mempool_size);
 
+/**
+ * Set the number of rings each thread receives its messages on. Must be called prior to
+ * spdk_thread_lib_init() or spdk_thread_lib_init_ext(), and is reset by spdk_thread_lib_fini().
+ *
+ * With a single ring (the default), all threads sending messages to the same thread
+ * contend on the head of that ring. With more rings, each sending thread always uses
+ * the same ring of the target thread, chosen by its thread ID, which spreads the senders
+ * over the rings. Messages from one sending thread are still executed in the order they
+ * were sent. The capacity of the rings is split evenly, so a thread can still hold the
+ * same number of pending messages in total.
+ *
+ * \param count Number of rings per thread, a power of 2 no larger than
+ * SPDK_THREAD_MAX_MSG_RINGS.
+ *
+ * \return 0 on success, -EINVAL if count is invalid, -EBUSY if the threading library is
+ * already initialized.
+ */
+int spdk_thread_lib_set_msg_ring_count(uint32_t count);
+
+/**
+ * Select how threads keep track of their timed pollers. Must be called prior to
+ * spdk_thread_lib_init() or spdk_thread_lib_init_ext(), and is reset by spdk_thread_lib_fini().
+ *
+ * By default, timed pollers are kept in a tree ordered by their next run time, which costs
+ * O(log n) each time a poller is rescheduled. With the timer wheel, a poller is rescheduled
+ * in O(1), which pays off for threads running many timed pollers. Pollers expiring within
+ * the same microsecond are then not necessarily run in the order of their expiration.
+ *
+ * \param enable True to use a hierarchical timer wheel, false to use the tree.
+ *
+ * \return 0 on success, -EBUSY if the threading library is already initialized.
+ */
+int spdk_thread_lib_set_timer_wheel(bool enable);
+
 /**
  * Release all resources associated with this library.
  */
@@ -772,6 +811,28 @@ struct spdk_thread *spdk_io_channel_get_thread(struct spdk_io_channel *ch);
 void spdk_for_each_channel(void *io_device, spdk_channel_msg fn, void *ctx,
 			   spdk_channel_for_each_cpl cpl);
 
+/**
+ * Call 'fn' on each channel associated with io_device, on all of them at once.
+ *
+ * Unlike spdk_for_each_channel(), the messages to all threads owning a channel
+ * are sent up front, so calls to 'fn' on different threads may overlap in time.
+ * 'fn' must call spdk_for_each_channel_continue() for its channel once done, and
+ * 'cpl' is called after that happened for all channels. A non-zero status doesn't
+ * stop the iteration, 'cpl' gets the first non-zero status reported.
+ *
+ * Channels created after this call are not visited, and
+ * spdk_io_channel_iter_get_channel() returns NULL in 'cpl'.
+ *
+ * \param io_device 'fn' will be called on each channel associated with this io_device.
+ * \param fn Called on the appropriate thread for each channel associated with io_device.
+ * \param ctx Context buffer registered to spdk_io_channel_iter that can be obtained
+ * form the function spdk_io_channel_iter_get_ctx().
+ * \param cpl Called on the thread that spdk_for_each_channel_parallel was called
+ * from when 'fn' has been called and completed on each channel.
+ */
+void spdk_for_each_channel_parallel(void *io_device, spdk_channel_msg fn, void *ctx,
+				    spdk_channel_for_each_cpl cpl);
+
 /**
  * Get io_device from the I/O channel iterator.
  *
@@ -809,7 +870,8 @@ void *spdk_io_channel_iter_get_ctx(struct spdk_io_channel_iter *i);
 void *spdk_io_channel_get_io_device(struct spdk_io_channel *ch);
 
 /**
- * Helper function to iterate all channels for spdk_for_each_channel().
+ * Helper function to iterate all channels for spdk_for_each_channel() and
+ * spdk_for_each_channel_parallel().
  *
  * \param i I/O channel iterator.
  * \param status Status for the I/O channel iterator;
@@ -1019,6 +1081,12 @@ void spdk_spin_unlock(struct spdk_spinlock *sspin);
  */
 bool spdk_spin_held(struct spdk_spinlock *sspin);
 
+/**
+ * Largest number of NUMA nodes iobuf keeps separate buffer pools for, see
+ * spdk_iobuf_opts.enable_numa.
+ */
+#define SPDK_IOBUF_MAX_NUMA_NODES	8
+
 struct spdk_iobuf_opts {
 	/** Maximum number of small buffers */
 	uint64_t small_pool_count;
@@ -1037,6 +1105,15 @@ struct spdk_iobuf_opts {
 	 */
 	size_t opts_size;
 
+	/**
+	 * Keep separate buffer pools on each NUMA node with SPDK cores, the pool counts then
+	 * apply to each node. Channels take buffers from the pools of the NUMA node of the core
+	 * they are created on, and only fall back to the pools of other nodes if those are empty.
+	 */
+	bool enable_numa;
+
+	/* Hole at bytes 33-39. */
+	uint8_t reserved33[7];
 };
 
 struct spdk_iobuf_pool_stats {
@@ -1046,12 +1123,24 @@ struct spdk_iobuf_pool_stats {
 	uint64_t	main;
 	/** Buffer missed and request to get buffer was queued */
 	uint64_t	retry;
+	/** Buffer got from the shared pool of another NUMA node */
+	uint64_t	remote;
+};
+
+struct spdk_iobuf_node_stats {
+	/** NUMA node ID */
+	uint32_t			numa_id;
+	struct spdk_iobuf_pool_stats	small_pool;
+	struct spdk_iobuf_pool_stats	large_pool;
 };
 
 struct spdk_iobuf_module_stats {
 	struct spdk_iobuf_pool_stats	small_pool;
 	struct spdk_iobuf_pool_stats	large_pool;
 	const char			*module;
+	/** Statistics of the channels on each NUMA node, only set if enable_numa is set */
+	struct spdk_iobuf_node_stats	*nodes;
+	uint32_t			num_nodes;
 };
 
 struct spdk_iobuf_entry;
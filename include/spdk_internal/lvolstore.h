@@ -61,6 +61,7 @@ struct spdk_lvs_with_handle_req {
 	struct spdk_bs_dev		*bs_dev;
 	struct spdk_bdev		*base_bdev;
 	int				lvserrno;
+	uint32_t			load_queue_depth;
 };
 
 struct spdk_lvs_destroy_req {
@@ -68,6 +68,8 @@ struct spdk_sock_group_impl {
 	struct spdk_sock_group			*group;
 	TAILQ_HEAD(, spdk_sock)			socks;
 	STAILQ_ENTRY(spdk_sock_group_impl)	link;
+	/* Updated by the net implementations, see spdk_sock_group_impl_stat_sendmsg() */
+	struct spdk_sock_group_stat		stat;
 };
 
 struct spdk_sock_map {
@@ -170,6 +172,17 @@ spdk_sock_request_pend(struct spdk_sock *sock, struct spdk_sock_request *req)
 #ifdef DEBUG
 	req->internal.curr_list = &sock->pending_reqs;
 #endif
+	if (sock->group_impl != NULL) {
+		sock->group_impl->stat.sent_requests++;
+	}
+}
+
+static inline void
+spdk_sock_group_impl_stat_sendmsg(struct spdk_sock *sock)
+{
+	if (sock->group_impl != NULL) {
+		sock->group_impl->stat.sendmsg_calls++;
+	}
 }
 
 static inline int
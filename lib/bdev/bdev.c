@@ -48,6 +48,9 @@ int __itt_init_ittlib(const char *, __itt_group_id);
 #define SPDK_BDEV_QOS_MIN_IOS_PER_SEC		1000
 #define SPDK_BDEV_QOS_MIN_BYTES_PER_SEC		(1024 * 1024)
 #define SPDK_BDEV_QOS_MAX_MBYTES_PER_SEC	(UINT64_MAX / (1024 * 1024))
+/* In distributed QoS mode, a channel draws 1/SPDK_BDEV_QOS_CHANNEL_QUOTA_DIVISOR of the
+ * per-timeslice quota from the shared budget at once. */
+#define SPDK_BDEV_QOS_CHANNEL_QUOTA_DIVISOR	8
 #define SPDK_BDEV_QOS_LIMIT_NOT_DEFINED		UINT64_MAX
 #define SPDK_BDEV_IO_POLL_INTERVAL_IN_MSEC	1000
 
@@ -91,7 +94,10 @@ bdev_name_cmp(struct spdk_bdev_name *name1, struct spdk_bdev_name *name2)
 RB_GENERATE_STATIC(bdev_name_tree, spdk_bdev_name, node, bdev_name_cmp);
 
 struct spdk_bdev_mgr {
-	struct spdk_mempool *bdev_io_pool;
+	/* Indexed by NUMA node ID, like the iobuf pools. Only node 0 is used if iobuf
+	 * does not keep pools per NUMA node.
+	 */
+	struct spdk_mempool *bdev_io_pool[SPDK_IOBUF_MAX_NUMA_NODES];
 
 	void *zero_buffer;
 
@@ -140,8 +146,12 @@ struct lba_range {
 	void				*locked_ctx;
 	struct spdk_thread		*owner_thread;
 	struct spdk_bdev_channel	*owner_ch;
+	/* Waiting for the I/O overlapping a range being locked on a channel */
+	struct spdk_bdev_channel_iter	*iter;
+	struct spdk_poller		*poller;
 	TAILQ_ENTRY(lba_range)		tailq;
 	TAILQ_ENTRY(lba_range)		tailq_module;
+	RB_ENTRY(lba_range)		node;
 };
 
 static struct spdk_bdev_opts	g_bdev_opts = {
@@ -150,6 +160,7 @@ static struct spdk_bdev_opts	g_bdev_opts = {
 	.bdev_auto_examine = SPDK_BDEV_AUTO_EXAMINE,
 	.iobuf_small_cache_size = BUF_SMALL_CACHE_SIZE,
 	.iobuf_large_cache_size = BUF_LARGE_CACHE_SIZE,
+	.qos_distributed = false,
 };
 
 static spdk_bdev_init_cb	g_init_cb_fn = NULL;
@@ -176,6 +187,11 @@ struct spdk_bdev_qos_limit {
 	/** Maximum allowed IOs or bytes to be issued in one timeslice (e.g., 1ms). */
 	uint32_t max_per_timeslice;
 
+	/** IOs or bytes a channel draws from remaining_this_timeslice at once in
+	 *  distributed mode. Zero if each IO is charged to remaining_this_timeslice.
+	 */
+	uint32_t channel_quota;
+
 	/** Function to check whether to queue the IO.
 	 * If The IO is allowed to pass, the quota will be reduced correspondingly.
 	 */
@@ -205,6 +221,12 @@ struct spdk_bdev_qos {
 
 	/** Poller that processes queued I/O commands each time slice. */
 	struct spdk_poller *poller;
+
+	/** Channels draw quota locally and submit their own queued I/O. */
+	bool distributed;
+
+	/** Incremented each time the poller starts a new timeslice. */
+	uint64_t timeslice_id;
 };
 
 struct spdk_bdev_mgmt_channel {
@@ -218,6 +240,8 @@ struct spdk_bdev_mgmt_channel {
 	bdev_io_stailq_t per_thread_cache;
 	uint32_t	per_thread_cache_count;
 	uint32_t	bdev_io_cache_size;
+	/* NUMA node of the bdev_io pool used by this thread */
+	uint32_t	numa_id;
 
 	struct spdk_iobuf_channel iobuf;
 
@@ -320,10 +344,19 @@ struct spdk_bdev_channel {
 
 	bdev_io_tailq_t		queued_resets;
 
-	lba_range_tailq_t	locked_ranges;
+	struct lba_range_tree	locked_ranges;
 
 	/** List of I/Os queued by QoS. */
 	bdev_io_tailq_t		qos_queued_io;
+
+	/** Quota drawn from the shared QoS budget, used in distributed QoS mode only. */
+	int64_t			qos_quota[SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES];
+
+	/** Timeslice the quota above was drawn in. */
+	uint64_t		qos_timeslice_id;
+
+	/** Poller submitting qos_queued_io in distributed QoS mode. */
+	struct spdk_poller	*qos_poller;
 };
 
 struct media_event_entry {
@@ -375,6 +408,8 @@ struct spdk_bdev_channel_iter {
 	spdk_bdev_for_each_channel_done cpl;
 	struct spdk_io_channel_iter *i;
 	void *ctx;
+	/* Per-channel copy made by bdev_for_each_channel_parallel() */
+	bool parallel;
 };
 
 struct spdk_bdev_io_error_stat {
@@ -403,6 +438,8 @@ static void bdev_io_push_bounce_data(struct spdk_bdev_io *bdev_io);
 static void bdev_write_zero_buffer_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg);
 static int bdev_write_zero_buffer(struct spdk_bdev_io *bdev_io);
 
+static void bdev_for_each_channel_parallel(struct spdk_bdev *bdev,
+		spdk_bdev_for_each_channel_msg fn, void *ctx, spdk_bdev_for_each_channel_done cpl);
 static void bdev_enable_qos_msg(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
 				struct spdk_io_channel *ch, void *_ctx);
 static void bdev_enable_qos_done(struct spdk_bdev *bdev, void *_ctx, int status);
@@ -480,10 +517,11 @@ spdk_bdev_get_opts(struct spdk_bdev_opts *opts, size_t opts_size)
 	SET_FIELD(bdev_auto_examine);
 	SET_FIELD(iobuf_small_cache_size);
 	SET_FIELD(iobuf_large_cache_size);
+	SET_FIELD(qos_distributed);
 
 	/* Do not remove this statement, you should always update this statement when you adding a new field,
 	 * and do not forget to add the SET_FIELD statement for your added field. */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_opts) == 32, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_bdev_opts) == 40, "Incorrect size");
 
 #undef SET_FIELD
 }
@@ -527,6 +565,7 @@ spdk_bdev_set_opts(struct spdk_bdev_opts *opts)
 	SET_FIELD(bdev_auto_examine);
 	SET_FIELD(iobuf_small_cache_size);
 	SET_FIELD(iobuf_large_cache_size);
+	SET_FIELD(qos_distributed);
 
 	g_bdev_opts.opts_size = opts->opts_size;
 
@@ -1959,6 +1998,7 @@ spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_named_bool(w, "bdev_auto_examine", g_bdev_opts.bdev_auto_examine);
 	spdk_json_write_named_uint32(w, "iobuf_small_cache_size", g_bdev_opts.iobuf_small_cache_size);
 	spdk_json_write_named_uint32(w, "iobuf_large_cache_size", g_bdev_opts.iobuf_large_cache_size);
+	spdk_json_write_named_bool(w, "qos_distributed", g_bdev_opts.qos_distributed);
 	spdk_json_write_object_end(w);
 	spdk_json_write_object_end(w);
 
@@ -1991,6 +2031,30 @@ spdk_bdev_subsystem_config_json(struct spdk_json_write_ctx *w)
 	spdk_json_write_array_end(w);
 }
 
+/* NUMA node of the calling core if it has a bdev_io pool, the first node with one otherwise. */
+static uint32_t
+bdev_get_local_numa_id(void)
+{
+	uint32_t core, numa_id;
+
+	core = spdk_env_get_current_core();
+	if (core != SPDK_ENV_LCORE_ID_ANY) {
+		numa_id = spdk_env_get_socket_id(core);
+		if (numa_id < SPDK_IOBUF_MAX_NUMA_NODES && g_bdev_mgr.bdev_io_pool[numa_id] != NULL) {
+			return numa_id;
+		}
+	}
+
+	for (numa_id = 0; numa_id < SPDK_IOBUF_MAX_NUMA_NODES; numa_id++) {
+		if (g_bdev_mgr.bdev_io_pool[numa_id] != NULL) {
+			break;
+		}
+	}
+
+	assert(numa_id < SPDK_IOBUF_MAX_NUMA_NODES);
+	return numa_id;
+}
+
 static void
 bdev_mgmt_channel_destroy(void *io_device, void *ctx_buf)
 {
@@ -2003,7 +2067,7 @@ bdev_mgmt_channel_destroy(void *io_device, void *ctx_buf)
 		bdev_io = STAILQ_FIRST(&ch->per_thread_cache);
 		STAILQ_REMOVE_HEAD(&ch->per_thread_cache, internal.buf_link);
 		ch->per_thread_cache_count--;
-		spdk_mempool_put(g_bdev_mgr.bdev_io_pool, (void *)bdev_io);
+		spdk_mempool_put(g_bdev_mgr.bdev_io_pool[bdev_io->internal.numa_id], (void *)bdev_io);
 	}
 
 	assert(ch->per_thread_cache_count == 0);
@@ -2027,17 +2091,19 @@ bdev_mgmt_channel_create(void *io_device, void *ctx_buf)
 
 	STAILQ_INIT(&ch->per_thread_cache);
 	ch->bdev_io_cache_size = g_bdev_opts.bdev_io_cache_size;
+	ch->numa_id = bdev_get_local_numa_id();
 
 	/* Pre-populate bdev_io cache to ensure this thread cannot be starved. */
 	ch->per_thread_cache_count = 0;
 	for (i = 0; i < ch->bdev_io_cache_size; i++) {
-		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool);
+		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool[ch->numa_id]);
 		if (bdev_io == NULL) {
 			SPDK_ERRLOG("You need to increase bdev_io_pool_size using bdev_set_options RPC.\n");
 			assert(false);
 			bdev_mgmt_channel_destroy(io_device, ctx_buf);
 			return -1;
 		}
+		bdev_io->internal.numa_id = ch->numa_id;
 		ch->per_thread_cache_count++;
 		STAILQ_INSERT_HEAD(&ch->per_thread_cache, bdev_io, internal.buf_link);
 	}
@@ -2183,11 +2249,65 @@ bdev_modules_init(void)
 	return 0;
 }
 
+/*
+ * Create a bdev_io pool on each NUMA node iobuf keeps pools for, or a single pool on any
+ * node if it does not.
+ */
+static int
+bdev_io_pools_create(void)
+{
+	struct spdk_iobuf_opts iobuf_opts;
+	char mempool_name[32];
+	uint32_t core, numa_id, numa_mask = 0;
+	int socket_id;
+
+	spdk_iobuf_get_opts(&iobuf_opts, sizeof(iobuf_opts));
+	if (iobuf_opts.enable_numa) {
+		SPDK_ENV_FOREACH_CORE(core) {
+			numa_id = spdk_env_get_socket_id(core);
+			if (numa_id < SPDK_IOBUF_MAX_NUMA_NODES) {
+				numa_mask |= 1U << numa_id;
+			}
+		}
+	}
+
+	for (numa_id = 0; numa_id < SPDK_IOBUF_MAX_NUMA_NODES; numa_id++) {
+		if (numa_mask == 0) {
+			socket_id = SPDK_ENV_SOCKET_ID_ANY;
+			snprintf(mempool_name, sizeof(mempool_name), "bdev_io_%d", getpid());
+		} else if (numa_mask & (1U << numa_id)) {
+			socket_id = numa_id;
+			snprintf(mempool_name, sizeof(mempool_name), "bdev_io_%d_%" PRIu32, getpid(), numa_id);
+		} else {
+			continue;
+		}
+
+		g_bdev_mgr.bdev_io_pool[numa_id] = spdk_mempool_create(mempool_name,
+						   g_bdev_opts.bdev_io_pool_size,
+						   sizeof(struct spdk_bdev_io) +
+						   bdev_module_get_max_ctx_size(),
+						   0,
+						   socket_id);
+		if (g_bdev_mgr.bdev_io_pool[numa_id] == NULL) {
+			while (numa_id-- > 0) {
+				spdk_mempool_free(g_bdev_mgr.bdev_io_pool[numa_id]);
+				g_bdev_mgr.bdev_io_pool[numa_id] = NULL;
+			}
+			return -ENOMEM;
+		}
+
+		if (numa_mask == 0) {
+			break;
+		}
+	}
+
+	return 0;
+}
+
 void
 spdk_bdev_initialize(spdk_bdev_init_cb cb_fn, void *cb_arg)
 {
 	int rc = 0;
-	char mempool_name[32];
 
 	assert(cb_fn != NULL);
 
@@ -2197,8 +2317,6 @@ spdk_bdev_initialize(spdk_bdev_init_cb cb_fn, void *cb_arg)
 	spdk_notify_type_register("bdev_register");
 	spdk_notify_type_register("bdev_unregister");
 
-	snprintf(mempool_name, sizeof(mempool_name), "bdev_io_%d", getpid());
-
 	rc = spdk_iobuf_register_module("bdev");
 	if (rc != 0) {
 		SPDK_ERRLOG("could not register bdev iobuf module: %s\n", spdk_strerror(-rc));
@@ -2206,14 +2324,8 @@ spdk_bdev_initialize(spdk_bdev_init_cb cb_fn, void *cb_arg)
 		return;
 	}
 
-	g_bdev_mgr.bdev_io_pool = spdk_mempool_create(mempool_name,
-				  g_bdev_opts.bdev_io_pool_size,
-				  sizeof(struct spdk_bdev_io) +
-				  bdev_module_get_max_ctx_size(),
-				  0,
-				  SPDK_ENV_SOCKET_ID_ANY);
-
-	if (g_bdev_mgr.bdev_io_pool == NULL) {
+	rc = bdev_io_pools_create();
+	if (rc != 0) {
 		SPDK_ERRLOG("could not allocate spdk_bdev_io pool\n");
 		bdev_init_complete(-1);
 		return;
@@ -2250,15 +2362,21 @@ static void
 bdev_mgr_unregister_cb(void *io_device)
 {
 	spdk_bdev_fini_cb cb_fn = g_fini_cb_fn;
+	uint32_t numa_id;
 
-	if (g_bdev_mgr.bdev_io_pool) {
-		if (spdk_mempool_count(g_bdev_mgr.bdev_io_pool) != g_bdev_opts.bdev_io_pool_size) {
+	for (numa_id = 0; numa_id < SPDK_IOBUF_MAX_NUMA_NODES; numa_id++) {
+		if (g_bdev_mgr.bdev_io_pool[numa_id] == NULL) {
+			continue;
+		}
+
+		if (spdk_mempool_count(g_bdev_mgr.bdev_io_pool[numa_id]) != g_bdev_opts.bdev_io_pool_size) {
 			SPDK_ERRLOG("bdev IO pool count is %zu but should be %u\n",
-				    spdk_mempool_count(g_bdev_mgr.bdev_io_pool),
+				    spdk_mempool_count(g_bdev_mgr.bdev_io_pool[numa_id]),
 				    g_bdev_opts.bdev_io_pool_size);
 		}
 
-		spdk_mempool_free(g_bdev_mgr.bdev_io_pool);
+		spdk_mempool_free(g_bdev_mgr.bdev_io_pool[numa_id]);
+		g_bdev_mgr.bdev_io_pool[numa_id] = NULL;
 	}
 
 	spdk_free(g_bdev_mgr.zero_buffer);
@@ -2472,6 +2590,28 @@ spdk_bdev_finish(spdk_bdev_fini_cb cb_fn, void *cb_arg)
 	}
 }
 
+/* Take a bdev_io from the pool of the given NUMA node, or any other one if it is empty. */
+static struct spdk_bdev_io *
+bdev_get_io_from_pools(uint32_t numa_id)
+{
+	struct spdk_bdev_io *bdev_io;
+	uint32_t i;
+
+	bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool[numa_id]);
+	for (i = 0; spdk_unlikely(bdev_io == NULL) && i < SPDK_IOBUF_MAX_NUMA_NODES; i++) {
+		if (i != numa_id && g_bdev_mgr.bdev_io_pool[i] != NULL) {
+			bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool[i]);
+			numa_id = i;
+		}
+	}
+
+	if (bdev_io != NULL) {
+		bdev_io->internal.numa_id = numa_id;
+	}
+
+	return bdev_io;
+}
+
 struct spdk_bdev_io *
 bdev_channel_get_io(struct spdk_bdev_channel *channel)
 {
@@ -2489,7 +2629,7 @@ bdev_channel_get_io(struct spdk_bdev_channel *channel)
 		 */
 		bdev_io = NULL;
 	} else {
-		bdev_io = spdk_mempool_get(g_bdev_mgr.bdev_io_pool);
+		bdev_io = bdev_get_io_from_pools(ch->numa_id);
 	}
 
 	return bdev_io;
@@ -2522,7 +2662,7 @@ spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
 	} else {
 		/* We should never have a full cache with entries on the io wait queue. */
 		assert(TAILQ_EMPTY(&ch->io_wait_queue));
-		spdk_mempool_put(g_bdev_mgr.bdev_io_pool, (void *)bdev_io);
+		spdk_mempool_put(g_bdev_mgr.bdev_io_pool[bdev_io->internal.numa_id], (void *)bdev_io);
 	}
 }
 
@@ -2614,6 +2754,47 @@ bdev_get_io_size_in_byte(struct spdk_bdev_io *bdev_io)
 	}
 }
 
+static inline int64_t *
+bdev_qos_channel_quota(struct spdk_bdev_qos_limit *limit, struct spdk_bdev_io *io)
+{
+	struct spdk_bdev_qos *qos = io->bdev->internal.qos;
+
+	return &io->internal.ch->qos_quota[limit - qos->rate_limits];
+}
+
+static bool
+bdev_qos_channel_queue_io(struct spdk_bdev_qos_limit *limit, struct spdk_bdev_io *io,
+			  uint64_t delta)
+{
+	int64_t *quota = bdev_qos_channel_quota(limit, io);
+	int64_t remaining_this_timeslice, draw;
+
+	if (spdk_likely(*quota >= (int64_t)delta)) {
+		*quota -= delta;
+		return false;
+	}
+
+	/* Refill the channel's quota from the shared budget. Like in bdev_qos_rw_queue_io(),
+	 * an IO bigger than what is left is allowed to overrun the budget as long as some
+	 * quota was still remaining.
+	 */
+	remaining_this_timeslice = __atomic_load_n(&limit->remaining_this_timeslice, __ATOMIC_RELAXED);
+	do {
+		if (remaining_this_timeslice <= 0) {
+			return true;
+		}
+
+		draw = spdk_min(remaining_this_timeslice, (int64_t)limit->channel_quota);
+		draw = spdk_max(draw, (int64_t)delta - *quota);
+	} while (!__atomic_compare_exchange_n(&limit->remaining_this_timeslice,
+					      &remaining_this_timeslice,
+					      remaining_this_timeslice - draw, true,
+					      __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	*quota += draw - delta;
+	return false;
+}
+
 static inline bool
 bdev_qos_rw_queue_io(struct spdk_bdev_qos_limit *limit, struct spdk_bdev_io *io, uint64_t delta)
 {
@@ -2624,6 +2805,10 @@ bdev_qos_rw_queue_io(struct spdk_bdev_qos_limit *limit, struct spdk_bdev_io *io,
 		return false;
 	}
 
+	if (limit->channel_quota != 0) {
+		return bdev_qos_channel_queue_io(limit, io, delta);
+	}
+
 	remaining_this_timeslice = __atomic_sub_fetch(&limit->remaining_this_timeslice, delta,
 				   __ATOMIC_RELAXED);
 	if (remaining_this_timeslice + (int64_t)delta > 0) {
@@ -2648,6 +2833,11 @@ bdev_qos_rw_queue_io(struct spdk_bdev_qos_limit *limit, struct spdk_bdev_io *io,
 static inline void
 bdev_qos_rw_rewind_io(struct spdk_bdev_qos_limit *limit, struct spdk_bdev_io *io, uint64_t delta)
 {
+	if (limit->channel_quota != 0) {
+		*bdev_qos_channel_quota(limit, io) += delta;
+		return;
+	}
+
 	__atomic_add_fetch(&limit->remaining_this_timeslice, delta, __ATOMIC_RELAXED);
 }
 
@@ -2777,6 +2967,7 @@ bdev_io_do_submit(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_i
 
 	if (spdk_unlikely(bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE &&
 			  bdev_io->bdev->split_on_write_unit &&
+			  !bdev_io->bdev->allow_partial_write_unit &&
 			  bdev_io->u.bdev.num_blocks < bdev_io->bdev->write_unit_size)) {
 		SPDK_ERRLOG("IO num_blocks %lu does not match the write_unit_size %u\n",
 			    bdev_io->u.bdev.num_blocks, bdev_io->bdev->write_unit_size);
@@ -2802,9 +2993,22 @@ bdev_io_do_submit(struct spdk_bdev_channel *bdev_ch, struct spdk_bdev_io *bdev_i
 static bool
 bdev_qos_queue_io(struct spdk_bdev_qos *qos, struct spdk_bdev_io *bdev_io)
 {
+	struct spdk_bdev_channel *ch = bdev_io->internal.ch;
+	uint64_t timeslice_id;
 	int i;
 
 	if (bdev_qos_io_to_limit(bdev_io) == true) {
+		if (qos->distributed) {
+			timeslice_id = __atomic_load_n(&qos->timeslice_id, __ATOMIC_RELAXED);
+			if (ch->qos_timeslice_id != timeslice_id) {
+				/* Quota left over from a previous timeslice is dropped, the
+				 * shared budget has been refilled in the meantime.
+				 */
+				memset(ch->qos_quota, 0, sizeof(ch->qos_quota));
+				ch->qos_timeslice_id = timeslice_id;
+			}
+		}
+
 		for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
 			if (!qos->rate_limits[i].queue_io) {
 				continue;
@@ -2845,6 +3049,20 @@ bdev_qos_io_submit(struct spdk_bdev_channel *ch, struct spdk_bdev_qos *qos)
 	return submitted_ios;
 }
 
+static int
+bdev_channel_poll_qos_queued_io(void *arg)
+{
+	struct spdk_bdev_channel *ch = arg;
+	int submitted_ios;
+
+	submitted_ios = bdev_qos_io_submit(ch, ch->bdev->internal.qos);
+	if (TAILQ_EMPTY(&ch->qos_queued_io)) {
+		spdk_poller_unregister(&ch->qos_poller);
+	}
+
+	return submitted_ios > 0 ? SPDK_POLLER_BUSY : SPDK_POLLER_IDLE;
+}
+
 static void
 bdev_queue_io_wait_with_cb(struct spdk_bdev_io *bdev_io, spdk_bdev_io_wait_cb cb_fn)
 {
@@ -3522,6 +3740,12 @@ _bdev_io_submit(void *ctx)
 		} else {
 			TAILQ_INSERT_TAIL(&bdev_ch->qos_queued_io, bdev_io, internal.link);
 			bdev_qos_io_submit(bdev_ch, bdev->internal.qos);
+			if (bdev->internal.qos->distributed && bdev_ch->qos_poller == NULL &&
+			    !TAILQ_EMPTY(&bdev_ch->qos_queued_io)) {
+				/* Retry the queued I/O each timeslice from this channel's thread */
+				bdev_ch->qos_poller = SPDK_POLLER_REGISTER(bdev_channel_poll_qos_queued_io,
+						      bdev_ch, SPDK_BDEV_QOS_TIMESLICE_IN_USEC);
+			}
 		}
 	} else {
 		SPDK_ERRLOG("unknown bdev_ch flag %x found\n", bdev_ch->flags);
@@ -3549,6 +3773,138 @@ bdev_lba_range_overlapped(struct lba_range *range1, struct lba_range *range2)
 	return true;
 }
 
+static int
+bdev_lba_range_cmp(struct lba_range *range1, struct lba_range *range2)
+{
+	if (range1->offset != range2->offset) {
+		return range1->offset < range2->offset ? -1 : 1;
+	}
+
+	/* Ranges with the same offset are kept in the order of their addresses, so
+	 * that the same range may be locked multiple times.
+	 */
+	if (range1 == range2) {
+		return 0;
+	}
+
+	return (uintptr_t)range1 < (uintptr_t)range2 ? -1 : 1;
+}
+
+RB_GENERATE_STATIC(lba_range_tree, lba_range, node, bdev_lba_range_cmp);
+
+static void
+bdev_lba_range_tree_init(struct lba_range_tree *tree)
+{
+	RB_INIT(tree);
+	tree->max_length = 0;
+}
+
+static void
+bdev_lba_range_tree_insert(struct lba_range_tree *tree, struct lba_range *range)
+{
+	RB_INSERT(lba_range_tree, tree, range);
+	tree->max_length = spdk_max(tree->max_length, range->length);
+}
+
+static void
+bdev_lba_range_tree_remove(struct lba_range_tree *tree, struct lba_range *range)
+{
+	struct lba_range *r;
+
+	RB_REMOVE(lba_range_tree, tree, range);
+
+	if (range->length == tree->max_length) {
+		/* Locking and unlocking are rare compared to I/O, keep the bound tight. */
+		tree->max_length = 0;
+		RB_FOREACH(r, lba_range_tree, tree) {
+			tree->max_length = spdk_max(tree->max_length, r->length);
+		}
+	}
+}
+
+/* Returns the first range in the tree starting at or after offset. */
+static struct lba_range *
+bdev_lba_range_tree_nfind(struct lba_range_tree *tree, uint64_t offset)
+{
+	struct lba_range *node = _RB_ROOT(tree), *range = NULL;
+
+	while (node != NULL) {
+		if (node->offset >= offset) {
+			range = node;
+			node = RB_LEFT(node, node);
+		} else {
+			node = RB_RIGHT(node, node);
+		}
+	}
+
+	return range;
+}
+
+static struct lba_range *
+bdev_lba_range_tree_next_overlap(struct lba_range_tree *tree, struct lba_range *range,
+				 uint64_t offset, uint64_t length)
+{
+	struct lba_range r = { .offset = offset, .length = length };
+
+	for (; range != NULL && range->offset < offset + length;
+	     range = RB_NEXT(lba_range_tree, tree, range)) {
+		if (bdev_lba_range_overlapped(range, &r)) {
+			return range;
+		}
+	}
+
+	return NULL;
+}
+
+/* Returns the first range in the tree overlapping [offset, offset + length).  No range
+ * in the tree is longer than max_length, so only the ranges starting after
+ * offset - max_length need to be checked.
+ */
+static struct lba_range *
+bdev_lba_range_tree_first_overlap(struct lba_range_tree *tree, uint64_t offset, uint64_t length)
+{
+	uint64_t start;
+
+	if (RB_EMPTY(tree) || length == 0) {
+		return NULL;
+	}
+
+	start = offset >= tree->max_length ? offset - tree->max_length + 1 : 0;
+
+	return bdev_lba_range_tree_next_overlap(tree, bdev_lba_range_tree_nfind(tree, start),
+						offset, length);
+}
+
+#define BDEV_LBA_RANGE_FOREACH_OVERLAP(range, tree, offset, length)				\
+	for ((range) = bdev_lba_range_tree_first_overlap(tree, offset, length);			\
+	     (range) != NULL;									\
+	     (range) = bdev_lba_range_tree_next_overlap(tree,					\
+			     RB_NEXT(lba_range_tree, tree, range), offset, length))
+
+static struct lba_range *
+bdev_lba_range_tree_first_at(struct lba_range_tree *tree, uint64_t offset)
+{
+	struct lba_range *range = bdev_lba_range_tree_nfind(tree, offset);
+
+	return range != NULL && range->offset == offset ? range : NULL;
+}
+
+static struct lba_range *
+bdev_lba_range_tree_next_at(struct lba_range_tree *tree, struct lba_range *range)
+{
+	struct lba_range *next = RB_NEXT(lba_range_tree, tree, range);
+
+	return next != NULL && next->offset == range->offset ? next : NULL;
+}
+
+/* Iterates over the ranges in the tree starting exactly at offset.  range is NULL
+ * once the iteration completes.
+ */
+#define BDEV_LBA_RANGE_FOREACH_AT(range, tree, offset)						\
+	for ((range) = bdev_lba_range_tree_first_at(tree, offset);				\
+	     (range) != NULL;									\
+	     (range) = bdev_lba_range_tree_next_at(tree, range))
+
 static bool
 bdev_io_range_is_locked(struct spdk_bdev_io *bdev_io, struct lba_range *range)
 {
@@ -3591,6 +3947,33 @@ bdev_io_range_is_locked(struct spdk_bdev_io *bdev_io, struct lba_range *range)
 	}
 }
 
+static bool
+bdev_io_ranges_are_locked(struct spdk_bdev_io *bdev_io, struct lba_range_tree *tree)
+{
+	struct lba_range *range;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_NVME_IO:
+	case SPDK_BDEV_IO_TYPE_NVME_IO_MD:
+		return !RB_EMPTY(tree);
+	case SPDK_BDEV_IO_TYPE_READ:
+	case SPDK_BDEV_IO_TYPE_WRITE:
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+	case SPDK_BDEV_IO_TYPE_COPY:
+		BDEV_LBA_RANGE_FOREACH_OVERLAP(range, tree, bdev_io->u.bdev.offset_blocks,
+					       bdev_io->u.bdev.num_blocks) {
+			if (bdev_io_range_is_locked(bdev_io, range)) {
+				return true;
+			}
+		}
+		return false;
+	default:
+		return false;
+	}
+}
+
 void
 bdev_io_submit(struct spdk_bdev_io *bdev_io)
 {
@@ -3598,14 +3981,10 @@ bdev_io_submit(struct spdk_bdev_io *bdev_io)
 
 	assert(bdev_io->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
 
-	if (!TAILQ_EMPTY(&ch->locked_ranges)) {
-		struct lba_range *range;
-
-		TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-			if (bdev_io_range_is_locked(bdev_io, range)) {
-				TAILQ_INSERT_TAIL(&ch->io_locked, bdev_io, internal.ch_link);
-				return;
-			}
+	if (!RB_EMPTY(&ch->locked_ranges)) {
+		if (bdev_io_ranges_are_locked(bdev_io, &ch->locked_ranges)) {
+			TAILQ_INSERT_TAIL(&ch->io_locked, bdev_io, internal.ch_link);
+			return;
 		}
 	}
 
@@ -3823,6 +4202,13 @@ bdev_qos_update_max_quota_per_timeslice(struct spdk_bdev_qos *qos)
 		qos->rate_limits[i].max_per_timeslice = spdk_max(max_per_timeslice,
 							qos->rate_limits[i].min_per_timeslice);
 
+		if (qos->distributed) {
+			qos->rate_limits[i].channel_quota = spdk_max(qos->rate_limits[i].max_per_timeslice /
+							    SPDK_BDEV_QOS_CHANNEL_QUOTA_DIVISOR, 1);
+		} else {
+			qos->rate_limits[i].channel_quota = 0;
+		}
+
 		__atomic_store_n(&qos->rate_limits[i].remaining_this_timeslice,
 				 qos->rate_limits[i].max_per_timeslice, __ATOMIC_RELEASE);
 	}
@@ -3876,6 +4262,9 @@ bdev_channel_poll_qos(void *arg)
 		return SPDK_POLLER_IDLE;
 	}
 
+	/* Have the channels drop the quota they drew in the last timeslice */
+	__atomic_add_fetch(&qos->timeslice_id, 1, __ATOMIC_RELAXED);
+
 	/* Reset for next round of rate limiting */
 	for (i = 0; i < SPDK_BDEV_QOS_NUM_RATE_LIMIT_TYPES; i++) {
 		/* We may have allowed the IOs or bytes to slightly overrun in the last
@@ -3903,6 +4292,11 @@ bdev_channel_poll_qos(void *arg)
 		}
 	}
 
+	if (qos->distributed) {
+		/* Channels submit their queued I/O from their own pollers */
+		return SPDK_POLLER_BUSY;
+	}
+
 	spdk_bdev_for_each_channel(bdev, bdev_channel_submit_qos_io, qos,
 				   bdev_channel_submit_qos_io_done);
 
@@ -3913,16 +4307,15 @@ static void
 bdev_channel_destroy_resource(struct spdk_bdev_channel *ch)
 {
 	struct spdk_bdev_shared_resource *shared_resource;
-	struct lba_range *range;
+	struct lba_range *range, *tmp;
 
 	bdev_free_io_stat(ch->stat);
 #ifdef SPDK_CONFIG_VTUNE
 	bdev_free_io_stat(ch->prev_stat);
 #endif
 
-	while (!TAILQ_EMPTY(&ch->locked_ranges)) {
-		range = TAILQ_FIRST(&ch->locked_ranges);
-		TAILQ_REMOVE(&ch->locked_ranges, range, tailq);
+	RB_FOREACH_SAFE(range, lba_range_tree, &ch->locked_ranges, tmp) {
+		RB_REMOVE(lba_range_tree, &ch->locked_ranges, range);
 		free(range);
 	}
 
@@ -3985,6 +4378,7 @@ bdev_enable_qos(struct spdk_bdev *bdev, struct spdk_bdev_channel *ch)
 					qos->rate_limits[i].limit = SPDK_BDEV_QOS_LIMIT_NOT_DEFINED;
 				}
 			}
+			qos->distributed = g_bdev_opts.qos_distributed;
 			bdev_qos_update_max_quota_per_timeslice(qos);
 			qos->timeslice_size =
 				SPDK_BDEV_QOS_TIMESLICE_IN_USEC * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
@@ -4199,7 +4593,7 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 
 	ch->io_outstanding = 0;
 	TAILQ_INIT(&ch->queued_resets);
-	TAILQ_INIT(&ch->locked_ranges);
+	bdev_lba_range_tree_init(&ch->locked_ranges);
 	TAILQ_INIT(&ch->qos_queued_io);
 	ch->flags = 0;
 	ch->trace_id = bdev->internal.trace_id;
@@ -4242,7 +4636,7 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 	spdk_spin_lock(&bdev->internal.spinlock);
 	bdev_enable_qos(bdev, ch);
 
-	TAILQ_FOREACH(range, &bdev->internal.locked_ranges, tailq) {
+	RB_FOREACH(range, lba_range_tree, &bdev->internal.locked_ranges) {
 		struct lba_range *new_range;
 
 		new_range = calloc(1, sizeof(*new_range));
@@ -4254,7 +4648,7 @@ bdev_channel_create(void *io_device, void *ctx_buf)
 		new_range->length = range->length;
 		new_range->offset = range->offset;
 		new_range->locked_ctx = range->locked_ctx;
-		TAILQ_INSERT_TAIL(&ch->locked_ranges, new_range, tailq);
+		bdev_lba_range_tree_insert(&ch->locked_ranges, new_range);
 	}
 
 	spdk_spin_unlock(&bdev->internal.spinlock);
@@ -4633,6 +5027,8 @@ bdev_channel_destroy(void *io_device, void *ctx_buf)
 
 	bdev_channel_abort_queued_ios(ch);
 
+	spdk_poller_unregister(&ch->qos_poller);
+
 	if (ch->histogram) {
 		spdk_histogram_data_free(ch->histogram);
 	}
@@ -7788,7 +8184,7 @@ bdev_register(struct spdk_bdev *bdev)
 	bdev->internal.qos = NULL;
 
 	TAILQ_INIT(&bdev->internal.open_descs);
-	TAILQ_INIT(&bdev->internal.locked_ranges);
+	bdev_lba_range_tree_init(&bdev->internal.locked_ranges);
 	TAILQ_INIT(&bdev->internal.pending_locked_ranges);
 	TAILQ_INIT(&bdev->aliases);
 
@@ -9314,6 +9710,7 @@ bdev_disable_qos_msg(struct spdk_bdev_channel_iter *i, struct spdk_bdev *bdev,
 	struct spdk_bdev_io *bdev_io;
 
 	bdev_ch->flags &= ~BDEV_CH_QOS_ENABLED;
+	spdk_poller_unregister(&bdev_ch->qos_poller);
 
 	while (!TAILQ_EMPTY(&bdev_ch->qos_queued_io)) {
 		/* Re-submit the queued I/O. */
@@ -9530,8 +9927,8 @@ bdev_histogram_enable_channel_cb(struct spdk_bdev *bdev, void *_ctx, int status)
 	if (status != 0) {
 		ctx->status = status;
 		ctx->bdev->internal.histogram_enabled = false;
-		spdk_bdev_for_each_channel(ctx->bdev, bdev_histogram_disable_channel, ctx,
-					   bdev_histogram_disable_channel_cb);
+		bdev_for_each_channel_parallel(ctx->bdev, bdev_histogram_disable_channel, ctx,
+					       bdev_histogram_disable_channel_cb);
 	} else {
 		spdk_spin_lock(&ctx->bdev->internal.spinlock);
 		ctx->bdev->internal.histogram_in_progress = false;
@@ -9591,11 +9988,11 @@ spdk_bdev_histogram_enable_ext(struct spdk_bdev *bdev, spdk_bdev_histogram_statu
 
 	if (enable) {
 		/* Allocate histogram for each channel */
-		spdk_bdev_for_each_channel(bdev, bdev_histogram_enable_channel, ctx,
-					   bdev_histogram_enable_channel_cb);
+		bdev_for_each_channel_parallel(bdev, bdev_histogram_enable_channel, ctx,
+					       bdev_histogram_enable_channel_cb);
 	} else {
-		spdk_bdev_for_each_channel(bdev, bdev_histogram_disable_channel, ctx,
-					   bdev_histogram_disable_channel_cb);
+		bdev_for_each_channel_parallel(bdev, bdev_histogram_disable_channel, ctx,
+					       bdev_histogram_disable_channel_cb);
 	}
 }
 
@@ -9801,9 +10198,7 @@ spdk_bdev_notify_media_management(struct spdk_bdev *bdev)
 
 struct locked_lba_range_ctx {
 	struct lba_range		range;
-	struct lba_range		*current_range;
 	struct lba_range		*owner_range;
-	struct spdk_poller		*poller;
 	lock_range_cb			cb_fn;
 	void				*cb_arg;
 };
@@ -9832,8 +10227,8 @@ bdev_lock_lba_range_cb(struct spdk_bdev *bdev, void *_ctx, int status)
 		 * the caller.  We can reuse the unlock function to do that
 		 * clean up.
 		 */
-		spdk_bdev_for_each_channel(bdev, bdev_unlock_lba_range_get_channel, ctx,
-					   bdev_lock_error_cleanup_cb);
+		bdev_for_each_channel_parallel(bdev, bdev_unlock_lba_range_get_channel, ctx,
+					       bdev_lock_error_cleanup_cb);
 		return;
 	}
 
@@ -9855,16 +10250,15 @@ bdev_lock_lba_range_cb(struct spdk_bdev *bdev, void *_ctx, int status)
 }
 
 static int
-bdev_lock_lba_range_check_io(void *_i)
+bdev_lock_lba_range_check_io(void *_range)
 {
-	struct spdk_bdev_channel_iter *i = _i;
+	struct lba_range *range = _range;
+	struct spdk_bdev_channel_iter *i = range->iter;
 	struct spdk_io_channel *_ch = spdk_io_channel_iter_get_channel(i->i);
 	struct spdk_bdev_channel *ch = __io_ch_to_bdev_ch(_ch);
-	struct locked_lba_range_ctx *ctx = i->ctx;
-	struct lba_range *range = ctx->current_range;
 	struct spdk_bdev_io *bdev_io;
 
-	spdk_poller_unregister(&ctx->poller);
+	spdk_poller_unregister(&range->poller);
 
 	/* The range is now in the locked_ranges, so no new IO can be submitted to this
 	 * range.  But we need to wait until any outstanding IO overlapping with this range
@@ -9872,11 +10266,12 @@ bdev_lock_lba_range_check_io(void *_i)
 	 */
 	TAILQ_FOREACH(bdev_io, &ch->io_submitted, internal.ch_link) {
 		if (bdev_io_range_is_locked(bdev_io, range)) {
-			ctx->poller = SPDK_POLLER_REGISTER(bdev_lock_lba_range_check_io, i, 100);
+			range->poller = SPDK_POLLER_REGISTER(bdev_lock_lba_range_check_io, range, 100);
 			return SPDK_POLLER_BUSY;
 		}
 	}
 
+	range->iter = NULL;
 	spdk_bdev_for_each_channel_continue(i, 0);
 	return SPDK_POLLER_BUSY;
 }
@@ -9889,9 +10284,8 @@ bdev_lock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bd
 	struct locked_lba_range_ctx *ctx = _ctx;
 	struct lba_range *range;
 
-	TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
+	BDEV_LBA_RANGE_FOREACH_AT(range, &ch->locked_ranges, ctx->range.offset) {
 		if (range->length == ctx->range.length &&
-		    range->offset == ctx->range.offset &&
 		    range->locked_ctx == ctx->range.locked_ctx) {
 			/* This range already exists on this channel, so don't add
 			 * it again.  This can happen when a new channel is created
@@ -9915,7 +10309,7 @@ bdev_lock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bd
 	range->offset = ctx->range.offset;
 	range->locked_ctx = ctx->range.locked_ctx;
 	range->quiesce = ctx->range.quiesce;
-	ctx->current_range = range;
+	range->iter = i;
 	if (ctx->range.owner_ch == ch) {
 		/* This is the range object for the channel that will hold
 		 * the lock.  Store it in the ctx object so that we can easily
@@ -9923,8 +10317,8 @@ bdev_lock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_bd
 		 */
 		ctx->owner_range = range;
 	}
-	TAILQ_INSERT_TAIL(&ch->locked_ranges, range, tailq);
-	bdev_lock_lba_range_check_io(i);
+	bdev_lba_range_tree_insert(&ch->locked_ranges, range);
+	bdev_lock_lba_range_check_io(range);
 }
 
 static void
@@ -9934,22 +10328,17 @@ bdev_lock_lba_range_ctx(struct spdk_bdev *bdev, struct locked_lba_range_ctx *ctx
 	assert(ctx->range.owner_ch == NULL ||
 	       spdk_io_channel_get_thread(ctx->range.owner_ch->channel) == ctx->range.owner_thread);
 
-	/* We will add a copy of this range to each channel now. */
-	spdk_bdev_for_each_channel(bdev, bdev_lock_lba_range_get_channel, ctx,
-				   bdev_lock_lba_range_cb);
+	/* We will add a copy of this range to each channel now, waiting for the I/O
+	 * overlapping it on all channels at the same time.
+	 */
+	bdev_for_each_channel_parallel(bdev, bdev_lock_lba_range_get_channel, ctx,
+				       bdev_lock_lba_range_cb);
 }
 
 static bool
-bdev_lba_range_overlaps_tailq(struct lba_range *range, lba_range_tailq_t *tailq)
+bdev_lba_range_overlaps_tree(struct lba_range *range, struct lba_range_tree *tree)
 {
-	struct lba_range *r;
-
-	TAILQ_FOREACH(r, tailq, tailq) {
-		if (bdev_lba_range_overlapped(range, r)) {
-			return true;
-		}
-	}
-	return false;
+	return bdev_lba_range_tree_first_overlap(tree, range->offset, range->length) != NULL;
 }
 
 static void bdev_quiesce_range_locked(struct lba_range *range, void *ctx, int status);
@@ -9977,14 +10366,14 @@ _bdev_lock_lba_range(struct spdk_bdev *bdev, struct spdk_bdev_channel *ch,
 	ctx->cb_arg = cb_arg;
 
 	spdk_spin_lock(&bdev->internal.spinlock);
-	if (bdev_lba_range_overlaps_tailq(&ctx->range, &bdev->internal.locked_ranges)) {
+	if (bdev_lba_range_overlaps_tree(&ctx->range, &bdev->internal.locked_ranges)) {
 		/* There is an active lock overlapping with this range.
 		 * Put it on the pending list until this range no
 		 * longer overlaps with another.
 		 */
 		TAILQ_INSERT_TAIL(&bdev->internal.pending_locked_ranges, &ctx->range, tailq);
 	} else {
-		TAILQ_INSERT_TAIL(&bdev->internal.locked_ranges, &ctx->range, tailq);
+		bdev_lba_range_tree_insert(&bdev->internal.locked_ranges, &ctx->range);
 		bdev_lock_lba_range_ctx(bdev, ctx);
 	}
 	spdk_spin_unlock(&bdev->internal.spinlock);
@@ -10030,10 +10419,10 @@ bdev_unlock_lba_range_cb(struct spdk_bdev *bdev, void *_ctx, int status)
 	 */
 	TAILQ_FOREACH_SAFE(range, &bdev->internal.pending_locked_ranges, tailq, tmp) {
 		if (bdev_lba_range_overlapped(range, &ctx->range) &&
-		    !bdev_lba_range_overlaps_tailq(range, &bdev->internal.locked_ranges)) {
+		    !bdev_lba_range_overlaps_tree(range, &bdev->internal.locked_ranges)) {
 			TAILQ_REMOVE(&bdev->internal.pending_locked_ranges, range, tailq);
 			pending_ctx = SPDK_CONTAINEROF(range, struct locked_lba_range_ctx, range);
-			TAILQ_INSERT_TAIL(&bdev->internal.locked_ranges, range, tailq);
+			bdev_lba_range_tree_insert(&bdev->internal.locked_ranges, range);
 			spdk_thread_send_msg(pending_ctx->range.owner_thread,
 					     bdev_lock_lba_range_ctx_msg, pending_ctx);
 		}
@@ -10054,11 +10443,10 @@ bdev_unlock_lba_range_get_channel(struct spdk_bdev_channel_iter *i, struct spdk_
 	struct spdk_bdev_io *bdev_io;
 	struct lba_range *range;
 
-	TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-		if (ctx->range.offset == range->offset &&
-		    ctx->range.length == range->length &&
+	BDEV_LBA_RANGE_FOREACH_AT(range, &ch->locked_ranges, ctx->range.offset) {
+		if (ctx->range.length == range->length &&
 		    ctx->range.locked_ctx == range->locked_ctx) {
-			TAILQ_REMOVE(&ch->locked_ranges, range, tailq);
+			bdev_lba_range_tree_remove(&ch->locked_ranges, range);
 			free(range);
 			break;
 		}
@@ -10102,8 +10490,8 @@ _bdev_unlock_lba_range(struct spdk_bdev *bdev, uint64_t offset, uint64_t length,
 	 * Then we will send a message to each channel to remove the range from its
 	 * per-channel list.
 	 */
-	TAILQ_FOREACH(range, &bdev->internal.locked_ranges, tailq) {
-		if (range->offset == offset && range->length == length &&
+	BDEV_LBA_RANGE_FOREACH_AT(range, &bdev->internal.locked_ranges, offset) {
+		if (range->length == length &&
 		    (range->owner_ch == NULL || range->locked_ctx == cb_arg)) {
 			break;
 		}
@@ -10113,15 +10501,15 @@ _bdev_unlock_lba_range(struct spdk_bdev *bdev, uint64_t offset, uint64_t length,
 		spdk_spin_unlock(&bdev->internal.spinlock);
 		return -EINVAL;
 	}
-	TAILQ_REMOVE(&bdev->internal.locked_ranges, range, tailq);
+	bdev_lba_range_tree_remove(&bdev->internal.locked_ranges, range);
 	ctx = SPDK_CONTAINEROF(range, struct locked_lba_range_ctx, range);
 	spdk_spin_unlock(&bdev->internal.spinlock);
 
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
 
-	spdk_bdev_for_each_channel(bdev, bdev_unlock_lba_range_get_channel, ctx,
-				   bdev_unlock_lba_range_cb);
+	bdev_for_each_channel_parallel(bdev, bdev_unlock_lba_range_get_channel, ctx,
+				       bdev_unlock_lba_range_cb);
 	return 0;
 }
 
@@ -10138,8 +10526,8 @@ bdev_unlock_lba_range(struct spdk_bdev_desc *desc, struct spdk_io_channel *_ch,
 	/* Let's make sure the specified channel actually has a lock on
 	 * the specified range.  Note that the range must match exactly.
 	 */
-	TAILQ_FOREACH(range, &ch->locked_ranges, tailq) {
-		if (range->offset == offset && range->length == length &&
+	BDEV_LBA_RANGE_FOREACH_AT(range, &ch->locked_ranges, offset) {
+		if (range->length == length &&
 		    range->owner_ch == ch && range->locked_ctx == cb_arg) {
 			range_found = true;
 			break;
@@ -10367,7 +10755,13 @@ spdk_bdev_for_each_bdev_io(struct spdk_bdev *bdev, void *_ctx, spdk_bdev_io_fn f
 void
 spdk_bdev_for_each_channel_continue(struct spdk_bdev_channel_iter *iter, int status)
 {
-	spdk_for_each_channel_continue(iter->i, status);
+	struct spdk_io_channel_iter *i = iter->i;
+
+	if (iter->parallel) {
+		free(iter);
+	}
+
+	spdk_for_each_channel_continue(i, status);
 }
 
 static struct spdk_bdev *
@@ -10424,6 +10818,54 @@ spdk_bdev_for_each_channel(struct spdk_bdev *bdev, spdk_bdev_for_each_channel_ms
 			      iter, bdev_each_channel_cpl);
 }
 
+static void
+bdev_each_channel_parallel_msg(struct spdk_io_channel_iter *i)
+{
+	struct spdk_bdev_channel_iter *parent = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_bdev *bdev = io_channel_iter_get_bdev(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct spdk_bdev_channel_iter *iter;
+
+	/* The channels are visited at the same time, so each one needs its own iterator */
+	iter = calloc(1, sizeof(*iter));
+	if (iter == NULL) {
+		SPDK_ERRLOG("Unable to allocate iterator\n");
+		spdk_for_each_channel_continue(i, -ENOMEM);
+		return;
+	}
+
+	*iter = *parent;
+	iter->i = i;
+	iter->parallel = true;
+	iter->fn(iter, bdev, ch, iter->ctx);
+}
+
+/* Like spdk_bdev_for_each_channel(), but visits all channels at the same time. Only for
+ * callers that don't depend on the channels being visited one after the other.
+ */
+static void
+bdev_for_each_channel_parallel(struct spdk_bdev *bdev, spdk_bdev_for_each_channel_msg fn,
+			       void *ctx, spdk_bdev_for_each_channel_done cpl)
+{
+	struct spdk_bdev_channel_iter *iter;
+
+	assert(bdev != NULL && fn != NULL && ctx != NULL);
+
+	iter = calloc(1, sizeof(struct spdk_bdev_channel_iter));
+	if (iter == NULL) {
+		SPDK_ERRLOG("Unable to allocate iterator\n");
+		assert(false);
+		return;
+	}
+
+	iter->fn = fn;
+	iter->cpl = cpl;
+	iter->ctx = ctx;
+
+	spdk_for_each_channel_parallel(__bdev_to_io_dev(bdev), bdev_each_channel_parallel_msg,
+				       iter, bdev_each_channel_cpl);
+}
+
 static void
 bdev_copy_do_write_done(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
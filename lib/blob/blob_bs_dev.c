@@ -179,7 +179,8 @@ blob_bs_is_zeroes(struct spdk_bs_dev *dev, uint64_t lba, uint64_t lba_count)
 	assert(lba == bs_cluster_to_lba(blob->bs, bs_lba_to_cluster(blob->bs, lba)));
 	assert(lba_count == bs_dev_byte_to_lba(dev, blob->bs->cluster_sz));
 
-	if (bs_io_unit_is_allocated(blob, lba)) {
+	if (bs_io_unit_is_allocated(blob, lba) ||
+	    blob_cluster_cow_bitmap(blob, bs_io_unit_to_cluster_number(blob, lba)) != 0) {
 		return false;
 	}
 
@@ -225,6 +226,11 @@ blob_bs_translate_lba(struct spdk_bs_dev *dev, uint64_t lba, uint64_t *base_lba)
 	bool is_valid_range;
 
 	assert(base_lba != NULL);
+	if (blob_cluster_cow_bitmap(blob, bs_io_unit_to_cluster_number(blob, lba)) != 0) {
+		/* Cluster is split between the blob and its parent */
+		return false;
+	}
+
 	if (bs_io_unit_is_allocated(blob, lba)) {
 		*base_lba = bs_blob_io_unit_to_lba(blob, lba);
 		return true;
@@ -28,8 +28,10 @@ static int bs_register_md_thread(struct spdk_blob_store *bs);
 static int bs_unregister_md_thread(struct spdk_blob_store *bs);
 static void blob_close_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno);
 static void blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
-		uint64_t cluster, uint32_t extent, struct spdk_blob_md_page *page,
+		uint64_t cluster, uint32_t extent, struct spdk_blob_md_page *page, uint64_t cow_bitmap,
 		spdk_blob_op_complete cb_fn, void *cb_arg);
+static void blob_cow_fill_claim_msg(void *arg);
+static void blob_cow_fill_update_msg(void *arg);
 static void blob_free_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
 		uint32_t extent_page, struct spdk_blob_md_page *page, spdk_blob_op_complete cb_fn, void *cb_arg);
 
@@ -171,6 +173,72 @@ blob_insert_cluster(struct spdk_blob *blob, uint32_t cluster_num, uint64_t clust
 	return 0;
 }
 
+/* Check if the blob keeps bitmaps of the copy-on-write units present in its clusters */
+static bool
+blob_has_cow_bitmaps(struct spdk_blob *blob)
+{
+	return blob->bs->cow_unit_size != 0 && (blob->invalid_flags & SPDK_BLOB_PARTIAL_COW);
+}
+
+/* Bitmaps are read by I/O threads without a lock, so the array may only grow on md thread
+ * while the blob is opened, resized or has its I/O frozen, never on the write path. */
+static int
+blob_cow_bitmaps_resize(struct spdk_blob *blob, uint64_t num_clusters)
+{
+	uint64_t *tmp;
+
+	if (blob->cow_bitmaps_size >= num_clusters) {
+		return 0;
+	}
+
+	tmp = realloc(blob->cow_bitmaps, num_clusters * sizeof(*blob->cow_bitmaps));
+	if (tmp == NULL) {
+		return -ENOMEM;
+	}
+	memset(tmp + blob->cow_bitmaps_size, 0,
+	       (num_clusters - blob->cow_bitmaps_size) * sizeof(*blob->cow_bitmaps));
+	blob->cow_bitmaps = tmp;
+	blob->cow_bitmaps_size = num_clusters;
+
+	return 0;
+}
+
+/* Set the bitmap of copy-on-write units present in a cluster about to be inserted */
+static int
+blob_insert_cow_bitmap(struct spdk_blob *blob, uint32_t cluster_num, uint64_t cow_bitmap)
+{
+	uint64_t i, start_cluster_idx, end_cluster_idx;
+	uint32_t num_partial = 0;
+
+	blob_verify_md_op(blob);
+	assert(blob->use_extent_table);
+
+	if (blob->active.clusters[cluster_num] != 0) {
+		return -EEXIST;
+	}
+
+	if (cluster_num >= blob->cow_bitmaps_size) {
+		/* No bitmap was allocated for the cluster, copy it whole */
+		return -EAGAIN;
+	}
+
+	/* Bitmaps are persisted in the extent page of the cluster, which has limited room */
+	start_cluster_idx = (cluster_num / SPDK_EXTENTS_PER_EP) * SPDK_EXTENTS_PER_EP;
+	end_cluster_idx = spdk_min(start_cluster_idx + SPDK_EXTENTS_PER_EP, blob->cow_bitmaps_size);
+	for (i = start_cluster_idx; i < end_cluster_idx; i++) {
+		if (blob->cow_bitmaps[i] != 0) {
+			num_partial++;
+		}
+	}
+	if (num_partial >= SPDK_COW_CLUSTERS_PER_EP) {
+		return -EAGAIN;
+	}
+
+	blob->cow_bitmaps[cluster_num] = cow_bitmap;
+
+	return 0;
+}
+
 static int
 bs_allocate_cluster(struct spdk_blob *blob, uint32_t cluster_num,
 		    uint64_t *cluster, uint32_t *lowest_free_md_page, bool update_map)
@@ -217,6 +285,127 @@ bs_allocate_cluster(struct spdk_blob *blob, uint32_t cluster_num,
 	return 0;
 }
 
+/*
+ * Return the clusters reserved by a channel to the free pool. Reserves are not persisted, so
+ * after a dirty shutdown the clusters they held are reclaimed by the used clusters recovery.
+ * Must be called with the used_lock held.
+ */
+static void
+bs_channel_release_reserved_clusters_locked(struct spdk_bs_channel *channel)
+{
+	struct spdk_blob_store *bs = channel->bs;
+	uint32_t i;
+
+	assert(spdk_spin_held(&bs->used_lock));
+
+	spdk_spin_lock(&channel->reserve_lock);
+	__atomic_fetch_sub(&bs->num_reserved_clusters, channel->num_reserved_clusters,
+			   __ATOMIC_RELAXED);
+	for (i = 0; i < channel->num_reserved_clusters; i++) {
+		bs_release_cluster(bs, channel->reserved_clusters[i]);
+	}
+	channel->num_reserved_clusters = 0;
+	spdk_spin_unlock(&channel->reserve_lock);
+}
+
+static void
+bs_channel_release_reserved_clusters(struct spdk_bs_channel *channel)
+{
+	struct spdk_blob_store *bs = channel->bs;
+
+	spdk_spin_lock(&bs->used_lock);
+	bs_channel_release_reserved_clusters_locked(channel);
+	spdk_spin_unlock(&bs->used_lock);
+}
+
+/*
+ * Take back the clusters reserved by all channels, so that an allocation that doesn't fit
+ * in the free pool fails only when the blobstore is really full. Must be called with the
+ * used_lock held.
+ */
+static void
+bs_release_all_reserved_clusters(struct spdk_blob_store *bs)
+{
+	struct spdk_bs_channel *channel;
+
+	assert(spdk_spin_held(&bs->used_lock));
+
+	if (__atomic_load_n(&bs->num_reserved_clusters, __ATOMIC_RELAXED) == 0) {
+		return;
+	}
+
+	TAILQ_FOREACH(channel, &bs->channels, link) {
+		bs_channel_release_reserved_clusters_locked(channel);
+	}
+}
+
+/*
+ * Allocate a cluster for the first write to a cluster of a thin blob. The cluster is taken
+ * from the channel's reserve, which is refilled with a batch of clusters under a single
+ * used_lock acquisition. While the blobstore is getting full, the batches shrink down to
+ * single clusters, so reserves can't hold back a significant part of the free space.
+ * Clusters that need a new extent page go through bs_allocate_cluster(), as the extent
+ * page has to be claimed under the used_lock anyway.
+ */
+static int
+bs_channel_allocate_cluster(struct spdk_bs_channel *channel, struct spdk_blob *blob,
+			    uint32_t cluster_num, uint64_t *cluster, uint32_t *lowest_free_md_page)
+{
+	struct spdk_blob_store *bs = blob->bs;
+	uint64_t num_reserve;
+	uint32_t i;
+	int rc;
+
+	if (blob->use_extent_table && *bs_cluster_to_extent_page(blob, cluster_num) == 0) {
+		spdk_spin_lock(&bs->used_lock);
+		if (bs->num_free_clusters == 0) {
+			bs_release_all_reserved_clusters(bs);
+		}
+		rc = bs_allocate_cluster(blob, cluster_num, cluster, lowest_free_md_page, false);
+		spdk_spin_unlock(&bs->used_lock);
+		return rc;
+	}
+
+	spdk_spin_lock(&channel->reserve_lock);
+	if (channel->num_reserved_clusters == 0) {
+		spdk_spin_unlock(&channel->reserve_lock);
+
+		spdk_spin_lock(&bs->used_lock);
+		num_reserve = spdk_min(bs->num_free_clusters / SPDK_BS_CHANNEL_RESERVE_FREE_DIVISOR,
+				       SPDK_BS_CHANNEL_MAX_RESERVED_CLUSTERS);
+		if (num_reserve == 0) {
+			if (bs->num_free_clusters == 0) {
+				/* The last free clusters may be sitting in the reserves of other channels */
+				bs_release_all_reserved_clusters(bs);
+			}
+			*cluster = bs_claim_cluster(bs);
+			spdk_spin_unlock(&bs->used_lock);
+			return *cluster == UINT32_MAX ? -ENOSPC : 0;
+		}
+
+		/* Only this channel adds to its reserve, so it is still empty here. */
+		spdk_spin_lock(&channel->reserve_lock);
+		assert(channel->num_reserved_clusters == 0);
+		/* Fill the reserve from its end, so the clusters are handed out in ascending order. */
+		for (i = num_reserve; i > 0; i--) {
+			channel->reserved_clusters[i - 1] = bs_claim_cluster(bs);
+			assert(channel->reserved_clusters[i - 1] != UINT32_MAX);
+		}
+		__atomic_fetch_add(&bs->num_reserved_clusters, num_reserve, __ATOMIC_RELAXED);
+		channel->num_reserved_clusters = num_reserve;
+		spdk_spin_unlock(&bs->used_lock);
+	}
+
+	*cluster = channel->reserved_clusters[--channel->num_reserved_clusters];
+	__atomic_fetch_sub(&bs->num_reserved_clusters, 1, __ATOMIC_RELAXED);
+	spdk_spin_unlock(&channel->reserve_lock);
+
+	SPDK_DEBUGLOG(blob, "Claiming reserved cluster %" PRIu64 " for blob 0x%" PRIx64 "\n", *cluster,
+		      blob->id);
+
+	return 0;
+}
+
 static void
 blob_xattrs_init(struct spdk_blob_xattr_opts *xattrs)
 {
@@ -325,6 +514,7 @@ blob_alloc(struct spdk_blob_store *bs, spdk_blob_id id)
 	TAILQ_INIT(&blob->xattrs_internal);
 	TAILQ_INIT(&blob->pending_persists);
 	TAILQ_INIT(&blob->persists_to_complete);
+	TAILQ_INIT(&blob->cow_fills);
 
 	return blob;
 }
@@ -348,7 +538,9 @@ blob_free(struct spdk_blob *blob)
 	assert(blob != NULL);
 	assert(TAILQ_EMPTY(&blob->pending_persists));
 	assert(TAILQ_EMPTY(&blob->persists_to_complete));
+	assert(TAILQ_EMPTY(&blob->cow_fills));
 
+	free(blob->cow_bitmaps);
 	free(blob->active.extent_pages);
 	free(blob->clean.extent_pages);
 	free(blob->active.clusters);
@@ -468,6 +660,12 @@ blob_set_back_bs_dev(struct spdk_blob *blob, struct spdk_bs_dev *back_bs_dev,
 	blob_freeze_io(blob, blob_set_back_bs_dev_frozen, ctx);
 }
 
+static inline void
+bs_chain_cache_invalidate(struct spdk_blob_store *bs)
+{
+	__atomic_fetch_add(&bs->chain_gen, 1, __ATOMIC_RELEASE);
+}
+
 struct freeze_io_ctx {
 	struct spdk_bs_cpl cpl;
 	struct spdk_blob *blob;
@@ -556,6 +754,10 @@ blob_unfreeze_io(struct spdk_blob *blob, spdk_blob_op_complete cb_fn, void *cb_a
 
 	assert(blob->frozen_refcnt > 0);
 
+	/* Snapshot create and delete, set_parent and resize all change the chain of
+	 * the blob while it is frozen. Drop whatever was resolved through it before
+	 * any I/O is resumed. */
+	bs_chain_cache_invalidate(blob->bs);
 	blob->frozen_refcnt--;
 
 	spdk_for_each_channel(blob->bs, blob_execute_queued_io, ctx, blob_io_cpl);
@@ -892,6 +1094,39 @@ blob_parse_page(const struct spdk_blob_md_page *page, struct spdk_blob *blob)
 			assert(desc_extent->start_cluster_idx + cluster_count == blob->active.num_clusters);
 			assert(blob->remaining_clusters_in_et >= cluster_count);
 			blob->remaining_clusters_in_et -= cluster_count;
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE_COW) {
+			struct spdk_blob_md_descriptor_extent_page_cow	*desc_cow;
+			unsigned int					i;
+			uint32_t					cluster_idx;
+			uint64_t					bitmap;
+
+			desc_cow = (struct spdk_blob_md_descriptor_extent_page_cow *)desc;
+			if (!(blob->invalid_flags & SPDK_BLOB_PARTIAL_COW) || blob->bs->cow_unit_size == 0 ||
+			    desc_cow->length == 0 || desc_cow->length % sizeof(desc_cow->clusters[0]) != 0 ||
+			    blob->active.num_clusters == 0) {
+				return -EINVAL;
+			}
+
+			if (blob_cow_bitmaps_resize(blob, blob->active.num_clusters) != 0) {
+				return -ENOMEM;
+			}
+
+			for (i = 0; i < desc_cow->length / sizeof(desc_cow->clusters[0]); i++) {
+				cluster_idx = desc_cow->clusters[i].cluster_idx;
+				bitmap = desc_cow->clusters[i].bitmap;
+
+				/* Bitmaps follow the extents of their extent page, so clusters
+				 * they refer to have already been parsed. */
+				if (cluster_idx >= blob->active.num_clusters ||
+				    blob->active.clusters[cluster_idx] == 0 ||
+				    bitmap == 0 || (bitmap & ~bs_cow_bitmap_full(blob->bs)) != 0) {
+					return -EINVAL;
+				}
+				if (bitmap == bs_cow_bitmap_full(blob->bs)) {
+					bitmap = 0;
+				}
+				blob->cow_bitmaps[cluster_idx] = bitmap;
+			}
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_XATTR) {
 			int rc;
 
@@ -1253,6 +1488,42 @@ blob_serialize_extents_rle(const struct spdk_blob *blob,
 	return 0;
 }
 
+static void
+blob_serialize_extent_page_cow(const struct spdk_blob *blob, uint64_t start_cluster_idx,
+			       struct spdk_blob_md_page *page, size_t offset)
+{
+	struct spdk_blob_md_descriptor_extent_page_cow *desc_cow;
+	struct spdk_blob_md_descriptor *desc_end;
+	uint64_t i, end_cluster_idx, num_clusters = 0;
+
+	desc_cow = (struct spdk_blob_md_descriptor_extent_page_cow *)((uintptr_t)page->descriptors +
+			offset);
+	end_cluster_idx = spdk_min(start_cluster_idx + SPDK_EXTENTS_PER_EP, blob->cow_bitmaps_size);
+
+	for (i = start_cluster_idx; i < end_cluster_idx; i++) {
+		if (blob->cow_bitmaps[i] == 0) {
+			continue;
+		}
+		assert(num_clusters < SPDK_COW_CLUSTERS_PER_EP);
+		desc_cow->clusters[num_clusters].cluster_idx = i;
+		desc_cow->clusters[num_clusters].bitmap = blob->cow_bitmaps[i];
+		num_clusters++;
+	}
+
+	if (num_clusters != 0) {
+		desc_cow->type = SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE_COW;
+		desc_cow->length = sizeof(desc_cow->clusters[0]) * num_clusters;
+		offset += sizeof(*desc_cow) + desc_cow->length;
+	}
+
+	/* The page may hold descriptors of an earlier serialization, terminate it. */
+	if (offset + sizeof(*desc_end) <= sizeof(page->descriptors)) {
+		desc_end = (struct spdk_blob_md_descriptor *)((uintptr_t)page->descriptors + offset);
+		desc_end->type = SPDK_MD_DESCRIPTOR_TYPE_PADDING;
+		desc_end->length = 0;
+	}
+}
+
 static void
 blob_serialize_extent_page(const struct spdk_blob *blob,
 			   uint64_t cluster, struct spdk_blob_md_page *page)
@@ -1278,6 +1549,9 @@ blob_serialize_extent_page(const struct spdk_blob *blob,
 	}
 	desc_extent->length = sizeof(desc_extent->start_cluster_idx) +
 			      sizeof(desc_extent->cluster_idx[0]) * extent_idx;
+
+	blob_serialize_extent_page_cow(blob, start_cluster_idx, page,
+				       sizeof(struct spdk_blob_md_descriptor) + desc_extent->length);
 }
 
 static void
@@ -1439,6 +1713,10 @@ blob_load_final(struct spdk_blob_load_ctx *ctx, int bserrno)
 {
 	struct spdk_blob		*blob = ctx->blob;
 
+	if (bserrno == 0 && blob_has_cow_bitmaps(blob)) {
+		bserrno = blob_cow_bitmaps_resize(blob, blob->active.num_clusters);
+	}
+
 	if (bserrno == 0) {
 		blob_mark_clean(blob);
 	}
@@ -1736,9 +2014,11 @@ blob_load_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	}
 }
 
-/* Load a blob from disk given a blobid */
+/* Load a blob from disk given a blobid. If first_page is not NULL, it holds the already
+ * read first metadata page of the blob. */
 static void
 blob_load(spdk_bs_sequence_t *seq, struct spdk_blob *blob,
+	  const struct spdk_blob_md_page *first_page,
 	  spdk_bs_sequence_cpl cb_fn, void *cb_arg)
 {
 	struct spdk_blob_load_ctx *ctx;
@@ -1773,6 +2053,12 @@ blob_load(spdk_bs_sequence_t *seq, struct spdk_blob *blob,
 
 	blob->state = SPDK_BLOB_STATE_LOADING;
 
+	if (first_page != NULL) {
+		memcpy(&ctx->pages[0], first_page, SPDK_BS_PAGE_SIZE);
+		blob_load_cpl(seq, ctx, 0);
+		return;
+	}
+
 	bs_sequence_read_dev(seq, &ctx->pages[0], lba,
 			     bs_byte_to_lba(bs, SPDK_BS_PAGE_SIZE),
 			     blob_load_cpl, ctx);
@@ -1992,6 +2278,13 @@ blob_persist_clear_clusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserr
 	}
 	spdk_spin_unlock(&bs->used_lock);
 
+	if (blob->cow_bitmaps_size > blob->active.num_clusters) {
+		/* The array may still be read by I/O threads, only clear truncated bitmaps. */
+		memset(blob->cow_bitmaps + blob->active.num_clusters, 0,
+		       (blob->cow_bitmaps_size - blob->active.num_clusters) * sizeof(*blob->cow_bitmaps));
+		blob->cow_bitmaps_size = blob->active.num_clusters;
+	}
+
 	if (blob->active.num_clusters == 0) {
 		free(blob->active.clusters);
 		blob->active.clusters = NULL;
@@ -2260,6 +2553,9 @@ blob_resize(struct spdk_blob *blob, uint64_t sz)
 	 */
 	if (sz > num_clusters && spdk_blob_is_thin_provisioned(blob) == false) {
 		spdk_spin_lock(&bs->used_lock);
+		if ((sz - num_clusters) > bs->num_free_clusters) {
+			bs_release_all_reserved_clusters(bs);
+		}
 		if ((sz - num_clusters) > bs->num_free_clusters) {
 			rc = -ENOSPC;
 			goto out;
@@ -2301,6 +2597,13 @@ blob_resize(struct spdk_blob *blob, uint64_t sz)
 			blob->active.extent_pages = ep_tmp;
 			blob->active.extent_pages_array_size = new_num_ep;
 		}
+
+		if (blob_has_cow_bitmaps(blob)) {
+			rc = blob_cow_bitmaps_resize(blob, sz);
+			if (rc != 0) {
+				goto out;
+			}
+		}
 	}
 
 	blob->state = SPDK_BLOB_STATE_DIRTY;
@@ -2619,6 +2922,25 @@ struct spdk_blob_copy_cluster_ctx {
 	uint32_t new_extent_page;
 	spdk_bs_sequence_t *seq;
 	struct spdk_blob_md_page *new_cluster_page;
+
+	/* Copy of only some copy-on-write units of the cluster */
+	struct spdk_thread *thread;
+	uint32_t cluster_num;
+	bool fill; /* Copy into a partially copied cluster */
+	bool can_copy;
+	uint64_t copy_src_lba;
+	uint64_t cow_bitmap; /* Units present in a new cluster after the copy, 0 for all */
+	uint64_t cow_request; /* Units that the user op needs in the cluster */
+	uint64_t cow_covered; /* Units that the user op overwrites whole */
+	uint64_t cow_claimed; /* Units this fill was allowed to copy on md thread */
+	uint64_t cow_copy; /* Units left to copy */
+	uint32_t cow_run_start;
+	uint32_t cow_run_len;
+	spdk_bs_user_op_t *op; /* User op written into the cluster before its units are marked present */
+	bool op_written;
+	bool op_done; /* The units were marked present, so the user op needs no re-execution */
+	int rc;
+	TAILQ_ENTRY(spdk_blob_copy_cluster_ctx) link;
 };
 
 struct spdk_blob_free_cluster_ctx {
@@ -2644,7 +2966,10 @@ blob_allocate_and_copy_cluster_cpl(void *cb_arg, int bserrno)
 	while (!TAILQ_EMPTY(&requests)) {
 		op = TAILQ_FIRST(&requests);
 		TAILQ_REMOVE(&requests, op, link);
-		if (bserrno == 0) {
+		if (bserrno == 0 && op == ctx->op && ctx->op_done) {
+			/* The user op was written along with the copy, just complete it */
+			bs_user_op_abort(op, 0);
+		} else if (bserrno == 0) {
 			bs_user_op_execute(op);
 		} else {
 			bs_user_op_abort(op, bserrno);
@@ -2720,6 +3045,8 @@ blob_insert_cluster_clear(struct spdk_blob_copy_cluster_ctx *ctx)
 	bs_batch_close(batch);
 }
 
+static void blob_copy_units_rest(struct spdk_blob_copy_cluster_ctx *ctx);
+
 static void
 blob_insert_cluster_cpl(void *cb_arg, int bserrno)
 {
@@ -2734,7 +3061,16 @@ blob_insert_cluster_cpl(void *cb_arg, int bserrno)
 			return;
 		}
 
+		if (bserrno == -EAGAIN) {
+			/* The extent page has no room left for the bitmap of
+			 * another partially copied cluster, copy it whole. */
+			blob_copy_units_rest(ctx);
+			return;
+		}
+
 		blob_insert_cluster_revert(ctx);
+	} else {
+		ctx->op_done = ctx->op_written;
 	}
 
 	bs_sequence_finish(ctx->seq, bserrno);
@@ -2755,7 +3091,7 @@ blob_write_copy_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	cluster_number = bs_page_to_cluster(ctx->blob->bs, ctx->page);
 
 	blob_insert_cluster_on_md_thread(ctx->blob, cluster_number, ctx->new_cluster,
-					 ctx->new_extent_page, ctx->new_cluster_page, blob_insert_cluster_cpl, ctx);
+					 ctx->new_extent_page, ctx->new_cluster_page, 0, blob_insert_cluster_cpl, ctx);
 }
 
 static void
@@ -2798,107 +3134,442 @@ blob_copy(struct spdk_blob_copy_cluster_ctx *ctx, spdk_bs_user_op_t *op, uint64_
 			     blob_write_copy_cpl, ctx);
 }
 
-static void
-bs_allocate_and_copy_cluster(struct spdk_blob *blob,
-			     struct spdk_io_channel *_ch,
-			     uint64_t io_unit, spdk_bs_user_op_t *op)
+static inline uint64_t
+bs_cow_units_mask(uint64_t first, uint64_t count)
 {
-	struct spdk_bs_cpl cpl;
-	struct spdk_bs_channel *ch;
-	struct spdk_blob_copy_cluster_ctx *ctx;
-	uint32_t cluster_start_page;
-	uint32_t cluster_number;
-	bool is_zeroes;
-	bool can_copy;
-	bool is_valid_range;
-	uint64_t copy_src_lba;
-	int rc;
+	return count == 64 ? UINT64_MAX : ((1ULL << count) - 1) << first;
+}
 
-	ch = spdk_io_channel_get_ctx(_ch);
+/* Copy-on-write units of its cluster that a user op touches, and the ones it overwrites whole. */
+static void
+blob_op_cow_units(struct spdk_blob *blob, spdk_bs_user_op_t *op, uint64_t *touched,
+		  uint64_t *covered)
+{
+	uint64_t io_units_per_cow_unit = bs_io_units_per_cow_unit(blob->bs);
+	uint64_t start = op->u.user_op.offset % bs_io_units_per_cluster(blob);
+	uint64_t end = start + op->u.user_op.length;
+	uint64_t first, last;
 
-	if (!TAILQ_EMPTY(&ch->need_cluster_alloc)) {
-		/* There are already operations pending. Queue this user op
-		 * and return because it will be re-executed when the outstanding
-		 * cluster allocation completes. */
-		TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
-		return;
-	}
+	assert(op->u.user_op.length != 0);
+	assert(end <= bs_io_units_per_cluster(blob));
 
-	/* Round the io_unit offset down to the first page in the cluster */
-	cluster_start_page = bs_io_unit_to_cluster_start(blob, io_unit);
+	first = start / io_units_per_cow_unit;
+	last = (end - 1) / io_units_per_cow_unit;
+	*touched = bs_cow_units_mask(first, last - first + 1);
 
-	/* Calculate which index in the metadata cluster array the corresponding
-	 * cluster is supposed to be at. */
-	cluster_number = bs_io_unit_to_cluster_number(blob, io_unit);
+	first = spdk_divide_round_up(start, io_units_per_cow_unit);
+	last = end / io_units_per_cow_unit;
+	*covered = last > first ? bs_cow_units_mask(first, last - first) : 0;
+}
 
-	ctx = calloc(1, sizeof(*ctx));
-	if (!ctx) {
-		bs_user_op_abort(op, -ENOMEM);
-		return;
+static bool
+blob_op_is_write(spdk_bs_user_op_t *op)
+{
+	if (op->u.user_op.length == 0) {
+		return false;
 	}
 
-	assert(blob->bs->cluster_sz % blob->back_bs_dev->blocklen == 0);
+	switch (op->u.user_op.type) {
+	case SPDK_BLOB_WRITE:
+	case SPDK_BLOB_WRITEV:
+	case SPDK_BLOB_WRITE_ZEROES:
+		return true;
+	default:
+		return false;
+	}
+}
 
-	ctx->blob = blob;
-	ctx->page = cluster_start_page;
-	ctx->new_cluster_page = ch->new_cluster_page;
-	memset(ctx->new_cluster_page, 0, SPDK_BS_PAGE_SIZE);
+/* Check if only the copy-on-write units touched by a user op need to be copied
+ * from the parent into a newly allocated cluster. */
+static bool
+blob_op_partial_cow(struct spdk_blob *blob, spdk_bs_user_op_t *op)
+{
+	if (blob->bs->cow_unit_size == 0 || !(blob->invalid_flags & SPDK_BLOB_PARTIAL_COW) ||
+	    !blob->use_extent_table || blob->parent_id == SPDK_BLOBID_INVALID ||
+	    blob_is_esnap_clone(blob)) {
+		return false;
+	}
 
-	/* Check if the cluster that we intend to do CoW for is valid for
-	 * the backing dev. For zeroes backing dev, it'll be always valid.
-	 * For other backing dev e.g. a snapshot, it could be invalid if
-	 * the blob has been resized after snapshot was taken. */
-	is_valid_range = blob->back_bs_dev->is_range_valid(blob->back_bs_dev,
-			 bs_dev_page_to_lba(blob->back_bs_dev, cluster_start_page),
-			 bs_dev_byte_to_lba(blob->back_bs_dev, blob->bs->cluster_sz));
+	return blob_op_is_write(op);
+}
 
-	can_copy = is_valid_range && blob_can_copy(blob, cluster_start_page, &copy_src_lba);
+static int
+blob_copy_units_alloc_buf(struct spdk_blob_copy_cluster_ctx *ctx)
+{
+	uint64_t size = __builtin_popcountll(ctx->cow_copy) * (uint64_t)ctx->blob->bs->cow_unit_size;
 
-	is_zeroes = is_valid_range && blob->back_bs_dev->is_zeroes(blob->back_bs_dev,
-			bs_dev_page_to_lba(blob->back_bs_dev, cluster_start_page),
-			bs_dev_byte_to_lba(blob->back_bs_dev, blob->bs->cluster_sz));
-	if (blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes && !can_copy) {
-		ctx->buf = spdk_malloc(blob->bs->cluster_sz, blob->back_bs_dev->blocklen,
-				       NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-		if (!ctx->buf) {
-			SPDK_ERRLOG("DMA allocation for cluster of size = %" PRIu32 " failed.\n",
-				    blob->bs->cluster_sz);
-			free(ctx);
-			bs_user_op_abort(op, -ENOMEM);
-			return;
-		}
+	spdk_free(ctx->buf);
+	ctx->buf = NULL;
+	if (ctx->can_copy || size == 0) {
+		return 0;
 	}
 
-	spdk_spin_lock(&blob->bs->used_lock);
-	rc = bs_allocate_cluster(blob, cluster_number, &ctx->new_cluster, &ctx->new_extent_page,
-				 false);
-	spdk_spin_unlock(&blob->bs->used_lock);
-	if (rc != 0) {
-		spdk_free(ctx->buf);
-		free(ctx);
-		bs_user_op_abort(op, rc);
-		return;
+	ctx->buf = spdk_malloc(size, ctx->blob->back_bs_dev->blocklen, NULL,
+			       SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (!ctx->buf) {
+		SPDK_ERRLOG("DMA allocation for copy-on-write units of size = %" PRIu64 " failed.\n", size);
+		return -ENOMEM;
 	}
 
-	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
-	cpl.u.blob_basic.cb_fn = blob_allocate_and_copy_cluster_cpl;
-	cpl.u.blob_basic.cb_arg = ctx;
+	return 0;
+}
 
-	ctx->seq = bs_sequence_start_blob(_ch, &cpl, blob);
-	if (!ctx->seq) {
-		spdk_spin_lock(&blob->bs->used_lock);
-		bs_release_cluster(blob->bs, ctx->new_cluster);
-		spdk_spin_unlock(&blob->bs->used_lock);
-		spdk_free(ctx->buf);
-		free(ctx);
-		bs_user_op_abort(op, -ENOMEM);
+static void blob_copy_units_write_op(struct spdk_blob_copy_cluster_ctx *ctx);
+
+static void
+blob_copy_units_done(struct spdk_blob_copy_cluster_ctx *ctx, int bserrno)
+{
+	if (bserrno == 0 && ctx->op != NULL && !ctx->op_written) {
+		/* Units the user op overwrites whole were not copied, so they can only
+		 * be marked present once the user data is on disk. Until then reads keep
+		 * going to the parent. */
+		blob_copy_units_write_op(ctx);
 		return;
 	}
 
-	/* Queue the user op to block other incoming operations */
-	TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
+	if (ctx->fill) {
+		/* Let the md thread mark the claimed units as present */
+		ctx->rc = bserrno;
+		spdk_thread_send_msg(ctx->blob->bs->md_thread, blob_cow_fill_update_msg, ctx);
+		return;
+	}
 
-	if (blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes) {
+	if (bserrno != 0) {
+		blob_insert_cluster_revert(ctx);
+		bs_sequence_finish(ctx->seq, bserrno);
+		return;
+	}
+
+	blob_insert_cluster_on_md_thread(ctx->blob, ctx->cluster_num, ctx->new_cluster,
+					 ctx->new_extent_page, ctx->new_cluster_page, ctx->cow_bitmap,
+					 blob_insert_cluster_cpl, ctx);
+}
+
+static void blob_copy_units_next(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno);
+
+static void
+blob_copy_units_write(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+	struct spdk_blob_store *bs = ctx->blob->bs;
+
+	if (bserrno != 0) {
+		blob_copy_units_done(ctx, bserrno);
+		return;
+	}
+
+	bs_sequence_write_dev(seq, ctx->buf,
+			      bs_cluster_to_lba(bs, ctx->new_cluster) +
+			      bs_byte_to_lba(bs, (uint64_t)ctx->cow_run_start * bs->cow_unit_size),
+			      bs_byte_to_lba(bs, (uint64_t)ctx->cow_run_len * bs->cow_unit_size),
+			      blob_copy_units_next, ctx);
+}
+
+/* Copy the runs of consecutive copy-on-write units left in ctx->cow_copy one by one */
+static void
+blob_copy_units_next(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+	struct spdk_blob *blob = ctx->blob;
+	struct spdk_blob_store *bs = blob->bs;
+	uint64_t run, offset, length;
+
+	if (bserrno != 0 || ctx->cow_copy == 0) {
+		blob_copy_units_done(ctx, bserrno);
+		return;
+	}
+
+	ctx->cow_run_start = __builtin_ctzll(ctx->cow_copy);
+	run = ctx->cow_copy >> ctx->cow_run_start;
+	ctx->cow_run_len = ~run == 0 ? 64 : __builtin_ctzll(~run);
+	ctx->cow_copy &= ~bs_cow_units_mask(ctx->cow_run_start, ctx->cow_run_len);
+
+	offset = (uint64_t)ctx->cow_run_start * bs->cow_unit_size;
+	length = (uint64_t)ctx->cow_run_len * bs->cow_unit_size;
+
+	if (ctx->can_copy) {
+		bs_sequence_copy_dev(seq,
+				     bs_cluster_to_lba(bs, ctx->new_cluster) + bs_byte_to_lba(bs, offset),
+				     ctx->copy_src_lba + bs_byte_to_lba(bs, offset),
+				     bs_byte_to_lba(bs, length),
+				     blob_copy_units_next, ctx);
+	} else {
+		bs_sequence_read_bs_dev(seq, blob->back_bs_dev, ctx->buf,
+					bs_dev_page_to_lba(blob->back_bs_dev, ctx->page) +
+					bs_dev_byte_to_lba(blob->back_bs_dev, offset),
+					bs_dev_byte_to_lba(blob->back_bs_dev, length),
+					blob_copy_units_write, ctx);
+	}
+}
+
+static void
+blob_copy_units_op_written(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+
+	seq->ext_io_opts = NULL;
+	blob_copy_units_done(ctx, bserrno);
+}
+
+/* Write the user op directly into the cluster, which is not visible to it yet */
+static void
+blob_copy_units_write_op(struct spdk_blob_copy_cluster_ctx *ctx)
+{
+	struct spdk_bs_request_set *set = (struct spdk_bs_request_set *)ctx->op;
+	struct spdk_bs_user_op_args *args = &set->u.user_op;
+	uint64_t lba;
+
+	ctx->op_written = true;
+	lba = bs_cluster_to_lba(ctx->blob->bs, ctx->new_cluster) +
+	      args->offset % bs_io_units_per_cluster(ctx->blob);
+
+	switch (args->type) {
+	case SPDK_BLOB_WRITE:
+		bs_sequence_write_dev(ctx->seq, args->payload, lba, args->length,
+				      blob_copy_units_op_written, ctx);
+		break;
+	case SPDK_BLOB_WRITEV:
+		ctx->seq->ext_io_opts = set->ext_io_opts;
+		bs_sequence_writev_dev(ctx->seq, args->payload, args->iovcnt, lba, args->length,
+				       blob_copy_units_op_written, ctx);
+		break;
+	case SPDK_BLOB_WRITE_ZEROES:
+		bs_sequence_write_zeroes_dev(ctx->seq, lba, args->length,
+					     blob_copy_units_op_written, ctx);
+		break;
+	default:
+		assert(false);
+		blob_copy_units_op_written(ctx->seq, ctx, -EINVAL);
+		break;
+	}
+}
+
+static void
+blob_copy_units_rest(struct spdk_blob_copy_cluster_ctx *ctx)
+{
+	int rc;
+
+	assert(!ctx->fill && ctx->cow_bitmap != 0);
+
+	/* The units touched by the user op were copied or written already */
+	ctx->cow_copy = bs_cow_bitmap_full(ctx->blob->bs) & ~ctx->cow_bitmap;
+	ctx->cow_bitmap = 0;
+
+	rc = blob_copy_units_alloc_buf(ctx);
+	if (rc != 0) {
+		blob_insert_cluster_revert(ctx);
+		bs_sequence_finish(ctx->seq, rc);
+		return;
+	}
+
+	blob_copy_units_next(ctx->seq, ctx, 0);
+}
+
+static void
+blob_cow_fill_claimed(void *arg)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = arg;
+	int rc;
+
+	if (ctx->cow_claimed == 0) {
+		/* All the units are present already */
+		bs_sequence_finish(ctx->seq, 0);
+		return;
+	}
+
+	ctx->cow_copy = ctx->cow_claimed & ~ctx->cow_covered;
+	rc = blob_copy_units_alloc_buf(ctx);
+	if (rc != 0) {
+		blob_copy_units_done(ctx, rc);
+		return;
+	}
+
+	blob_copy_units_next(ctx->seq, ctx, 0);
+}
+
+static void
+blob_cow_fill_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = cb_arg;
+
+	bs_sequence_finish(ctx->seq, bserrno);
+}
+
+static void
+blob_cow_fill_done(void *arg)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = arg;
+
+	bs_sequence_finish(ctx->seq, ctx->rc);
+}
+
+/* Copy the units a user op needs into a cluster that was copied from the parent only partially.
+ * Units are claimed on md thread first, so that concurrent fills never copy the same unit. */
+static void
+blob_cow_fill_cluster(struct spdk_blob_copy_cluster_ctx *ctx, struct spdk_io_channel *_ch,
+		      spdk_bs_user_op_t *op)
+{
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(_ch);
+	struct spdk_blob *blob = ctx->blob;
+	struct spdk_bs_cpl cpl;
+
+	ctx->fill = true;
+	if (op->u.user_op.length == 0) {
+		/* Dummy op used to copy all of the cluster */
+		ctx->cow_request = bs_cow_bitmap_full(blob->bs);
+		ctx->cow_covered = 0;
+	} else {
+		blob_op_cow_units(blob, op, &ctx->cow_request, &ctx->cow_covered);
+	}
+	if (blob_op_is_write(op)) {
+		ctx->op = op;
+	}
+	ctx->can_copy = blob_can_copy(blob, ctx->page, &ctx->copy_src_lba);
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = blob_allocate_and_copy_cluster_cpl;
+	cpl.u.blob_basic.cb_arg = ctx;
+
+	ctx->seq = bs_sequence_start_blob(_ch, &cpl, blob);
+	if (!ctx->seq) {
+		free(ctx);
+		bs_user_op_abort(op, -ENOMEM);
+		return;
+	}
+
+	/* Queue the user op to block other incoming operations */
+	TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
+
+	spdk_thread_send_msg(blob->bs->md_thread, blob_cow_fill_claim_msg, ctx);
+}
+
+static void
+bs_allocate_and_copy_cluster(struct spdk_blob *blob,
+			     struct spdk_io_channel *_ch,
+			     uint64_t io_unit, spdk_bs_user_op_t *op)
+{
+	struct spdk_bs_cpl cpl;
+	struct spdk_bs_channel *ch;
+	struct spdk_blob_copy_cluster_ctx *ctx;
+	uint32_t cluster_start_page;
+	uint32_t cluster_number;
+	bool is_zeroes;
+	bool can_copy;
+	bool is_valid_range;
+	bool partial;
+	uint64_t copy_src_lba;
+	int rc;
+
+	ch = spdk_io_channel_get_ctx(_ch);
+
+	if (!TAILQ_EMPTY(&ch->need_cluster_alloc)) {
+		/* There are already operations pending. Queue this user op
+		 * and return because it will be re-executed when the outstanding
+		 * cluster allocation completes. */
+		TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
+		return;
+	}
+
+	/* Round the io_unit offset down to the first page in the cluster */
+	cluster_start_page = bs_io_unit_to_cluster_start(blob, io_unit);
+
+	/* Calculate which index in the metadata cluster array the corresponding
+	 * cluster is supposed to be at. */
+	cluster_number = bs_io_unit_to_cluster_number(blob, io_unit);
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		bs_user_op_abort(op, -ENOMEM);
+		return;
+	}
+
+	assert(blob->bs->cluster_sz % blob->back_bs_dev->blocklen == 0);
+
+	ctx->blob = blob;
+	ctx->page = cluster_start_page;
+	ctx->new_cluster_page = ch->new_cluster_page;
+	memset(ctx->new_cluster_page, 0, SPDK_BS_PAGE_SIZE);
+	ctx->thread = spdk_get_thread();
+	ctx->cluster_num = cluster_number;
+
+	if (blob->active.clusters[cluster_number] != 0) {
+		/* The cluster was copied from the parent only partially */
+		blob_cow_fill_cluster(ctx, _ch, op);
+		return;
+	}
+
+	/* Check if the cluster that we intend to do CoW for is valid for
+	 * the backing dev. For zeroes backing dev, it'll be always valid.
+	 * For other backing dev e.g. a snapshot, it could be invalid if
+	 * the blob has been resized after snapshot was taken. */
+	is_valid_range = blob->back_bs_dev->is_range_valid(blob->back_bs_dev,
+			 bs_dev_page_to_lba(blob->back_bs_dev, cluster_start_page),
+			 bs_dev_byte_to_lba(blob->back_bs_dev, blob->bs->cluster_sz));
+
+	can_copy = is_valid_range && blob_can_copy(blob, cluster_start_page, &copy_src_lba);
+
+	is_zeroes = is_valid_range && blob->back_bs_dev->is_zeroes(blob->back_bs_dev,
+			bs_dev_page_to_lba(blob->back_bs_dev, cluster_start_page),
+			bs_dev_byte_to_lba(blob->back_bs_dev, blob->bs->cluster_sz));
+
+	partial = is_valid_range && !is_zeroes && blob_op_partial_cow(blob, op);
+	if (partial) {
+		blob_op_cow_units(blob, op, &ctx->cow_bitmap, &ctx->cow_covered);
+		ctx->cow_copy = ctx->cow_bitmap & ~ctx->cow_covered;
+		if (ctx->cow_bitmap == bs_cow_bitmap_full(blob->bs)) {
+			ctx->cow_bitmap = 0;
+		}
+		ctx->can_copy = can_copy;
+		ctx->copy_src_lba = copy_src_lba;
+		ctx->op = op;
+		if (blob_copy_units_alloc_buf(ctx) != 0) {
+			free(ctx);
+			bs_user_op_abort(op, -ENOMEM);
+			return;
+		}
+	} else if (blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes && !can_copy) {
+		ctx->buf = spdk_malloc(blob->bs->cluster_sz, blob->back_bs_dev->blocklen,
+				       NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+		if (!ctx->buf) {
+			SPDK_ERRLOG("DMA allocation for cluster of size = %" PRIu32 " failed.\n",
+				    blob->bs->cluster_sz);
+			free(ctx);
+			bs_user_op_abort(op, -ENOMEM);
+			return;
+		}
+	}
+
+	rc = bs_channel_allocate_cluster(ch, blob, cluster_number, &ctx->new_cluster,
+					 &ctx->new_extent_page);
+	if (rc != 0) {
+		spdk_free(ctx->buf);
+		free(ctx);
+		bs_user_op_abort(op, rc);
+		return;
+	}
+
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = blob_allocate_and_copy_cluster_cpl;
+	cpl.u.blob_basic.cb_arg = ctx;
+
+	ctx->seq = bs_sequence_start_blob(_ch, &cpl, blob);
+	if (!ctx->seq) {
+		spdk_spin_lock(&blob->bs->used_lock);
+		bs_release_cluster(blob->bs, ctx->new_cluster);
+		spdk_spin_unlock(&blob->bs->used_lock);
+		spdk_free(ctx->buf);
+		free(ctx);
+		bs_user_op_abort(op, -ENOMEM);
+		return;
+	}
+
+	/* Queue the user op to block other incoming operations */
+	TAILQ_INSERT_TAIL(&ch->need_cluster_alloc, op, link);
+
+	if (partial) {
+		/* Copy only the units touched by the user op */
+		blob_copy_units_next(ctx->seq, ctx, 0);
+	} else if (blob->parent_id != SPDK_BLOBID_INVALID && !is_zeroes) {
 		if (can_copy) {
 			blob_copy(ctx, op, copy_src_lba);
 		} else {
@@ -2911,7 +3582,7 @@ bs_allocate_and_copy_cluster(struct spdk_blob *blob,
 
 	} else {
 		blob_insert_cluster_on_md_thread(ctx->blob, cluster_number, ctx->new_cluster,
-						 ctx->new_extent_page, ctx->new_cluster_page, blob_insert_cluster_cpl, ctx);
+						 ctx->new_extent_page, ctx->new_cluster_page, 0, blob_insert_cluster_cpl, ctx);
 	}
 }
 
@@ -2932,6 +3603,104 @@ blob_calculate_lba_and_lba_count(struct spdk_blob *blob, uint64_t io_unit, uint6
 	}
 }
 
+/* Walk the snapshot chain of a clone to find the snapshot that owns a cluster. Returns false
+ * if the cluster can't be resolved without going through the chain, i.e. it is split between
+ * a snapshot and its parent, the chain ends in an external snapshot or a blob of the chain is
+ * frozen while its clusters may be moving. */
+static bool
+blob_chain_resolve_cluster(struct spdk_blob *blob, uint64_t cluster, uint64_t *cluster_lba)
+{
+	struct spdk_blob *parent = blob;
+
+	while (true) {
+		if (parent->back_bs_dev == bs_create_zeroes_dev()) {
+			*cluster_lba = SPDK_BS_CHAIN_CACHE_LBA_ZEROES;
+			return true;
+		}
+
+		if (parent->parent_id == SPDK_BLOBID_INVALID ||
+		    parent->parent_id == SPDK_BLOBID_EXTERNAL_SNAPSHOT ||
+		    parent->back_bs_dev == NULL) {
+			return false;
+		}
+
+		parent = ((struct spdk_blob_bs_dev *)parent->back_bs_dev)->blob;
+		if (parent->frozen_refcnt) {
+			return false;
+		}
+
+		if (cluster >= parent->active.num_clusters) {
+			/* The clone was resized after this snapshot was taken */
+			*cluster_lba = SPDK_BS_CHAIN_CACHE_LBA_ZEROES;
+			return true;
+		}
+
+		if (blob_cluster_cow_bitmap(parent, cluster) != 0) {
+			return false;
+		}
+
+		if (parent->active.clusters[cluster] != 0) {
+			*cluster_lba = parent->active.clusters[cluster];
+			return true;
+		}
+	}
+}
+
+/* Look up the LBA on the blobstore device that an unallocated io_unit of a clone is read from.
+ * Returns false if the read has to go through the back_bs_dev of the blob. */
+static bool
+blob_chain_cache_lookup(struct spdk_bs_channel *ch, struct spdk_blob *blob, uint64_t io_unit,
+			uint64_t *lba)
+{
+	struct spdk_bs_chain_cache_entry *entry;
+	uint64_t cluster, cluster_lba, hash, gen;
+
+	/* Only clones of snapshots have a chain to skip */
+	if (blob->parent_id == SPDK_BLOBID_INVALID ||
+	    blob->parent_id == SPDK_BLOBID_EXTERNAL_SNAPSHOT) {
+		return false;
+	}
+
+	cluster = bs_io_unit_to_cluster_number(blob, io_unit);
+	hash = (blob->id * 0x9E3779B97F4A7C15ULL) ^ cluster;
+	entry = &ch->chain_cache[hash & (SPDK_BS_CHANNEL_CHAIN_CACHE_SIZE - 1)];
+
+	/* Taken before resolving, so that a chain change during the resolve invalidates the entry */
+	gen = __atomic_load_n(&blob->bs->chain_gen, __ATOMIC_ACQUIRE);
+	if (entry->gen == gen && entry->blobid == blob->id && entry->cluster == cluster) {
+		cluster_lba = entry->lba;
+	} else {
+		if (!blob_chain_resolve_cluster(blob, cluster, &cluster_lba)) {
+			return false;
+		}
+
+		entry->blobid = blob->id;
+		entry->cluster = cluster;
+		entry->lba = cluster_lba;
+		entry->gen = gen;
+	}
+
+	if (cluster_lba == SPDK_BS_CHAIN_CACHE_LBA_ZEROES) {
+		*lba = SPDK_BS_CHAIN_CACHE_LBA_ZEROES;
+	} else {
+		*lba = cluster_lba + io_unit % bs_io_units_per_cluster(blob);
+	}
+
+	return true;
+}
+
+/* Number of io_units from an offset that a single op can cover. Unmaps release whole clusters,
+ * other ops have to stay within the copy-on-write units present in partially copied cluster. */
+static inline uint64_t
+blob_op_io_units_to_boundary(struct spdk_blob *blob, uint64_t io_unit, enum spdk_blob_op_type op_type)
+{
+	if (op_type == SPDK_BLOB_UNMAP) {
+		return bs_num_io_units_to_cluster_boundary(blob, io_unit);
+	}
+
+	return bs_num_io_units_to_alloc_boundary(blob, io_unit);
+}
+
 struct op_split_ctx {
 	struct spdk_blob *blob;
 	struct spdk_io_channel *channel;
@@ -2986,8 +3755,7 @@ blob_request_submit_op_split_next(void *cb_arg, int bserrno)
 		offset = ctx->io_unit_offset;
 		length = ctx->io_units_remaining;
 		buf = ctx->curr_payload;
-		op_length = spdk_min(length, bs_num_io_units_to_cluster_boundary(blob,
-				     offset));
+		op_length = spdk_min(length, blob_op_io_units_to_boundary(blob, offset, op_type));
 
 		/* Update length and payload for next operation */
 		ctx->io_units_remaining -= op_length;
@@ -3151,6 +3919,15 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 		if (is_allocated) {
 			/* Read from the blob */
 			bs_batch_read_dev(batch, payload, lba, lba_count);
+		} else if (blob_chain_cache_lookup(spdk_io_channel_get_ctx(_ch), blob, offset, &lba)) {
+			/* Read from the snapshot owning the cluster, skipping the rest of the chain */
+			if (lba == SPDK_BS_CHAIN_CACHE_LBA_ZEROES) {
+				bs_batch_read_bs_dev(batch, bs_create_zeroes_dev(), payload, 0,
+						     bs_dev_byte_to_lba(bs_create_zeroes_dev(),
+								     length * blob->bs->io_unit_size));
+			} else {
+				bs_batch_read_dev(batch, payload, lba, length);
+			}
 		} else {
 			/* Read from the backing block device */
 			bs_batch_read_bs_dev(batch, blob->back_bs_dev, payload, lba, lba_count);
@@ -3201,6 +3978,14 @@ blob_request_submit_op_single(struct spdk_io_channel *_ch, struct spdk_blob *blo
 		struct spdk_blob_free_cluster_ctx *ctx = NULL;
 		spdk_bs_batch_t *batch;
 
+		if (!is_allocated &&
+		    blob_cluster_cow_bitmap(blob, bs_io_unit_to_cluster_number(blob, offset)) != 0) {
+			/* Partially copied cluster is unmapped as a whole */
+			is_allocated = true;
+			lba = bs_blob_io_unit_to_lba(blob, offset);
+			lba_count = length;
+		}
+
 		/* if aligned with cluster release cluster */
 		if (spdk_blob_is_thin_provisioned(blob) && is_allocated &&
 		    bs_io_units_per_cluster(blob) == length) {
@@ -3291,7 +4076,7 @@ blob_request_submit_op(struct spdk_blob *blob, struct spdk_io_channel *_channel,
 		cb_fn(cb_arg, -EINVAL);
 		return;
 	}
-	if (length <= bs_num_io_units_to_cluster_boundary(blob, offset)) {
+	if (length <= blob_op_io_units_to_boundary(blob, offset, op_type)) {
 		blob_request_submit_op_single(_channel, blob, payload, offset, length,
 					      cb_fn, cb_arg, op_type);
 	} else {
@@ -3340,7 +4125,7 @@ rw_iov_split_next(void *cb_arg, int bserrno)
 	}
 
 	io_unit_offset = ctx->io_unit_offset;
-	io_units_to_boundary = bs_num_io_units_to_cluster_boundary(blob, io_unit_offset);
+	io_units_to_boundary = bs_num_io_units_to_alloc_boundary(blob, io_unit_offset);
 	io_units_count = spdk_min(ctx->io_units_remaining, io_units_to_boundary);
 	/*
 	 * Get index and offset into the original iov array for our current position in the I/O sequence.
@@ -3431,7 +4216,7 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 	 *  in a batch.  That would also require creating an intermediate spdk_bs_cpl that would get called
 	 *  when the batch was completed, to allow for freeing the memory for the iov arrays.
 	 */
-	if (spdk_likely(length <= bs_num_io_units_to_cluster_boundary(blob, offset))) {
+	if (spdk_likely(length <= bs_num_io_units_to_alloc_boundary(blob, offset))) {
 		uint64_t lba_count;
 		uint64_t lba;
 		bool is_allocated;
@@ -3473,6 +4258,15 @@ blob_request_submit_rw_iov(struct spdk_blob *blob, struct spdk_io_channel *_chan
 
 			if (is_allocated) {
 				bs_sequence_readv_dev(seq, iov, iovcnt, lba, lba_count, rw_iov_done, NULL);
+			} else if (blob_chain_cache_lookup(spdk_io_channel_get_ctx(_channel), blob, offset, &lba)) {
+				if (lba == SPDK_BS_CHAIN_CACHE_LBA_ZEROES) {
+					bs_sequence_readv_bs_dev(seq, bs_create_zeroes_dev(), iov, iovcnt, 0,
+								 bs_dev_byte_to_lba(bs_create_zeroes_dev(),
+										 length * blob->bs->io_unit_size),
+								 rw_iov_done, NULL);
+				} else {
+					bs_sequence_readv_dev(seq, iov, iovcnt, lba, length, rw_iov_done, NULL);
+				}
 			} else {
 				bs_sequence_readv_bs_dev(seq, blob->back_bs_dev, iov, iovcnt, lba, lba_count,
 							 rw_iov_done, NULL);
@@ -3614,10 +4408,24 @@ bs_channel_create(void *io_device, void *ctx_buf)
 		return -1;
 	}
 
+	channel->chain_cache = calloc(SPDK_BS_CHANNEL_CHAIN_CACHE_SIZE, sizeof(*channel->chain_cache));
+	if (!channel->chain_cache) {
+		SPDK_ERRLOG("Failed to allocate snapshot chain cache\n");
+		free(channel->req_mem);
+		spdk_free(channel->new_cluster_page);
+		channel->dev->destroy_channel(channel->dev, channel->dev_channel);
+		return -1;
+	}
+
 	TAILQ_INIT(&channel->need_cluster_alloc);
 	TAILQ_INIT(&channel->queued_io);
 	RB_INIT(&channel->esnap_channels);
 
+	spdk_spin_init(&channel->reserve_lock);
+	spdk_spin_lock(&bs->used_lock);
+	TAILQ_INSERT_TAIL(&bs->channels, channel, link);
+	spdk_spin_unlock(&bs->used_lock);
+
 	return 0;
 }
 
@@ -3641,7 +4449,14 @@ bs_channel_destroy(void *io_device, void *ctx_buf)
 
 	blob_esnap_destroy_bs_channel(channel);
 
+	spdk_spin_lock(&channel->bs->used_lock);
+	bs_channel_release_reserved_clusters_locked(channel);
+	TAILQ_REMOVE(&channel->bs->channels, channel, link);
+	spdk_spin_unlock(&channel->bs->used_lock);
+	spdk_spin_destroy(&channel->reserve_lock);
+
 	free(channel->req_mem);
+	free(channel->chain_cache);
 	spdk_free(channel->new_cluster_page);
 	channel->dev->destroy_channel(channel->dev, channel->dev_channel);
 }
@@ -3811,11 +4626,24 @@ spdk_bs_opts_init(struct spdk_bs_opts *opts, size_t opts_size)
 	SET_FIELD(force_recover, false);
 	SET_FIELD(esnap_bs_dev_create, NULL);
 	SET_FIELD(esnap_ctx, NULL);
+	SET_FIELD(cow_unit_size, 0);
 
 #undef FIELD_OK
 #undef SET_FIELD
 }
 
+static bool
+bs_cow_unit_size_valid(uint32_t cluster_sz, uint32_t cow_unit_size)
+{
+	if (cow_unit_size == 0) {
+		return true;
+	}
+
+	return cow_unit_size % SPDK_BS_PAGE_SIZE == 0 && cluster_sz % cow_unit_size == 0 &&
+	       cluster_sz / cow_unit_size >= 2 &&
+	       cluster_sz / cow_unit_size <= SPDK_BS_COW_UNITS_PER_CLUSTER_MAX;
+}
+
 static int
 bs_opts_verify(struct spdk_bs_opts *opts)
 {
@@ -3825,6 +4653,12 @@ bs_opts_verify(struct spdk_bs_opts *opts)
 		return -1;
 	}
 
+	if (!bs_cow_unit_size_valid(opts->cluster_sz, opts->cow_unit_size)) {
+		SPDK_ERRLOG("Copy-on-write unit size %" PRIu32 " is not valid for cluster size %" PRIu32 "\n",
+			    opts->cow_unit_size, opts->cluster_sz);
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -3832,21 +4666,55 @@ bs_opts_verify(struct spdk_bs_opts *opts)
 
 /* spdk_bs_load_ctx is used for init, load, unload and dump code paths. */
 
+enum bs_replay_page_type {
+	/* Possibly the first page of a blob, found by scanning the metadata region */
+	BS_REPLAY_PAGE_FIRST,
+	/* Page in the chain of a blob */
+	BS_REPLAY_PAGE_CHAIN,
+	/* Extent page in the extent table of a blob */
+	BS_REPLAY_PAGE_EXTENT,
+};
+
+struct bs_replay_page_ref {
+	uint32_t			page_num;
+	enum bs_replay_page_type	type;
+};
+
+struct bs_replay_page_refs {
+	struct bs_replay_page_ref	*refs;
+	uint32_t			count;
+	uint32_t			size;
+};
+
 struct spdk_bs_load_ctx {
 	struct spdk_blob_store		*bs;
 	struct spdk_bs_super_block	*super;
 
 	struct spdk_bs_md_mask		*mask;
-	bool				in_page_chain;
-	uint32_t			page_index;
 	uint32_t			cur_page;
 	struct spdk_blob_md_page	*page;
 
 	uint64_t			num_extent_pages;
 	uint32_t			*extent_page_num;
-	struct spdk_blob_md_page	*extent_pages;
 	struct spdk_bit_array		*used_clusters;
 
+	/* These fields are used when replaying the metadata during recovery. */
+	struct spdk_blob_md_page	*replay_pages;
+	uint32_t			replay_max_pages;
+	/* Pages of the metadata region scanned by the current window */
+	uint32_t			replay_start;
+	uint32_t			replay_end;
+	bool				replay_scan_done;
+	/* Pages ahead of the scan that were referenced by an already replayed page */
+	struct spdk_bit_array		*replay_want_chain;
+	struct spdk_bit_array		*replay_want_extent;
+	/* Referenced pages within the current window */
+	struct bs_replay_page_refs	replay_pending;
+	/* Referenced pages behind the scan */
+	struct bs_replay_page_refs	replay_deferred;
+	struct bs_replay_page_ref	*replay_batch;
+	uint32_t			replay_batch_count;
+
 	spdk_bs_sequence_t			*seq;
 	spdk_blob_op_with_handle_complete	iter_cb_fn;
 	void					*iter_cb_arg;
@@ -3919,6 +4787,7 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 	 *  even multiple of the cluster size.
 	 */
 	bs->cluster_sz = opts->cluster_sz;
+	bs->cow_unit_size = opts->cow_unit_size;
 	bs->total_clusters = dev->blockcnt / (bs->cluster_sz / dev->blocklen);
 	ctx->used_clusters = spdk_bit_array_create(bs->total_clusters);
 	if (!ctx->used_clusters) {
@@ -3947,6 +4816,10 @@ bs_alloc(struct spdk_bs_dev *dev, struct spdk_bs_opts *opts, struct spdk_blob_st
 	bs->open_blobids = spdk_bit_array_create(0);
 
 	spdk_spin_init(&bs->used_lock);
+	TAILQ_INIT(&bs->channels);
+	TAILQ_INIT(&bs->ep_persists);
+	/* Zeroed cache entries have a generation of 0, so they never match */
+	bs->chain_gen = 1;
 
 	spdk_io_device_register(bs, bs_channel_create, bs_channel_destroy,
 				sizeof(struct spdk_bs_channel), "blobstore");
@@ -4526,6 +5399,8 @@ bs_load_replay_md_parse_page(struct spdk_bs_load_ctx *ctx, struct spdk_blob_md_p
 			/* Skip this item */
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_FLAGS) {
 			/* Skip this item */
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE_COW) {
+			/* Skip this item */
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_TABLE) {
 			struct spdk_blob_md_descriptor_extent_table *desc_extent_table;
 			uint32_t num_extent_pages = ctx->num_extent_pages;
@@ -4609,40 +5484,31 @@ bs_load_cur_extent_page_valid(struct spdk_blob_md_page *page)
 		return false;
 	}
 
-	/* It has to be the only descriptor in the page. */
-	if (desc_len + sizeof(*desc) <= sizeof(page->descriptors)) {
-		desc = (struct spdk_blob_md_descriptor *)((uintptr_t)page->descriptors + desc_len);
-		if (desc->length != 0) {
-			return false;
-		}
+	if (desc_len + sizeof(*desc) > sizeof(page->descriptors)) {
+		return true;
 	}
 
-	return true;
-}
-
-static bool
-bs_load_cur_md_page_valid(struct spdk_bs_load_ctx *ctx)
-{
-	uint32_t crc;
-	struct spdk_blob_md_page *page = ctx->page;
-
-	crc = blob_md_page_calc_crc(page);
-	if (crc != page->crc) {
-		return false;
+	/* It may only be followed by the bitmaps of partially copied clusters. */
+	desc = (struct spdk_blob_md_descriptor *)((uintptr_t)page->descriptors + desc_len);
+	if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE_COW) {
+		desc_len += sizeof(*desc) + desc->length;
+		if (desc_len > sizeof(page->descriptors)) {
+			return false;
+		}
+		if (desc_len + sizeof(*desc) > sizeof(page->descriptors)) {
+			return true;
+		}
+		desc = (struct spdk_blob_md_descriptor *)((uintptr_t)page->descriptors + desc_len);
 	}
 
-	/* First page of a sequence should match the blobid. */
-	if (page->sequence_num == 0 &&
-	    bs_page_to_blobid(ctx->cur_page) != page->id) {
+	/* Anything else has to be the end of the page. */
+	if (desc->length != 0) {
 		return false;
 	}
-	assert(bs_load_cur_extent_page_valid(page) == false);
 
 	return true;
 }
 
-static void bs_load_replay_cur_md_page(struct spdk_bs_load_ctx *ctx);
-
 static void
 bs_load_write_used_clusters_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
@@ -4694,167 +5560,351 @@ bs_load_write_used_md(struct spdk_bs_load_ctx *ctx)
 	bs_write_used_md(ctx->seq, ctx, bs_load_write_used_pages_cpl);
 }
 
-static void
-bs_load_replay_md_chain_cpl(struct spdk_bs_load_ctx *ctx)
+/* During recovery, the metadata region is read in windows of BS_REPLAY_WINDOW_CHUNKS reads of
+ * BS_REPLAY_CHUNK_PAGES pages each, all submitted at once. */
+#define BS_REPLAY_CHUNK_PAGES	256
+#define BS_REPLAY_WINDOW_CHUNKS	4
+#define BS_REPLAY_WINDOW_PAGES	(BS_REPLAY_CHUNK_PAGES * BS_REPLAY_WINDOW_CHUNKS)
+
+static bool
+bs_load_replay_md_page_valid(uint32_t page_num, struct spdk_blob_md_page *page)
 {
-	uint64_t num_md_clusters;
-	uint64_t i;
+	uint32_t crc;
 
-	ctx->in_page_chain = false;
+	crc = blob_md_page_calc_crc(page);
+	if (crc != page->crc) {
+		return false;
+	}
 
-	do {
-		ctx->page_index++;
-	} while (spdk_bit_array_get(ctx->bs->used_md_pages, ctx->page_index) == true);
+	/* First page of a sequence should match the blobid. */
+	if (page->sequence_num == 0 &&
+	    bs_page_to_blobid(page_num) != page->id) {
+		return false;
+	}
 
-	if (ctx->page_index < ctx->super->md_len) {
-		ctx->cur_page = ctx->page_index;
-		bs_load_replay_cur_md_page(ctx);
-	} else {
-		/* Claim all of the clusters used by the metadata */
-		num_md_clusters = spdk_divide_round_up(
-					  ctx->super->md_start + ctx->super->md_len, ctx->bs->pages_per_cluster);
-		for (i = 0; i < num_md_clusters; i++) {
-			spdk_bit_array_set(ctx->used_clusters, i);
+	return true;
+}
+
+static int
+bs_load_replay_refs_push(struct bs_replay_page_refs *refs, uint32_t page_num,
+			 enum bs_replay_page_type type)
+{
+	struct bs_replay_page_ref *tmp;
+	uint32_t size;
+
+	if (refs->count == refs->size) {
+		size = spdk_max(refs->size * 2, 64);
+		tmp = realloc(refs->refs, size * sizeof(*tmp));
+		if (tmp == NULL) {
+			return -ENOMEM;
 		}
-		ctx->bs->num_free_clusters -= num_md_clusters;
-		spdk_free(ctx->page);
-		bs_load_write_used_md(ctx);
+		refs->refs = tmp;
+		refs->size = size;
 	}
+
+	refs->refs[refs->count].page_num = page_num;
+	refs->refs[refs->count].type = type;
+	refs->count++;
+
+	return 0;
 }
 
-static void
-bs_load_replay_extent_page_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+/* Schedule the replay of a page referenced by an already replayed one. */
+static int
+bs_load_replay_ref_page(struct spdk_bs_load_ctx *ctx, uint32_t page_num,
+			enum bs_replay_page_type type)
 {
-	struct spdk_bs_load_ctx *ctx = cb_arg;
-	uint32_t page_num;
+	if (page_num >= ctx->super->md_len) {
+		return -EILSEQ;
+	}
+
+	if (spdk_bit_array_get(ctx->bs->used_md_pages, page_num)) {
+		return 0;
+	}
+
+	if (ctx->replay_scan_done || page_num < ctx->replay_start) {
+		/* The page was already scanned, it has to be read again. */
+		return bs_load_replay_refs_push(&ctx->replay_deferred, page_num, type);
+	}
+
+	if (page_num < ctx->replay_end) {
+		/* The page is in memory, replay it before moving on. */
+		return bs_load_replay_refs_push(&ctx->replay_pending, page_num, type);
+	}
+
+	/* Replay the page once the scan reaches it. */
+	if (type == BS_REPLAY_PAGE_EXTENT) {
+		spdk_bit_array_set(ctx->replay_want_extent, page_num);
+	} else {
+		spdk_bit_array_set(ctx->replay_want_chain, page_num);
+	}
+
+	return 0;
+}
+
+static int
+bs_load_replay_page(struct spdk_bs_load_ctx *ctx, uint32_t page_num,
+		    struct spdk_blob_md_page *page, enum bs_replay_page_type type)
+{
+	struct spdk_blob_store *bs = ctx->bs;
 	uint64_t i;
+	int rc;
 
-	if (bserrno != 0) {
-		spdk_free(ctx->extent_pages);
-		bs_load_ctx_fail(ctx, bserrno);
-		return;
+	if (spdk_bit_array_get(bs->used_md_pages, page_num)) {
+		/* Already replayed */
+		return 0;
 	}
 
-	for (i = 0; i < ctx->num_extent_pages; i++) {
+	if (type == BS_REPLAY_PAGE_EXTENT) {
 		/* Extent pages are only read when present within in chain md.
 		 * Integrity of md is not right if that page was not a valid extent page. */
-		if (bs_load_cur_extent_page_valid(&ctx->extent_pages[i]) != true) {
-			spdk_free(ctx->extent_pages);
-			bs_load_ctx_fail(ctx, -EILSEQ);
-			return;
+		if (bs_load_cur_extent_page_valid(page) != true) {
+			return -EILSEQ;
+		}
+		spdk_bit_array_set(bs->used_md_pages, page_num);
+		if (bs_load_replay_md_parse_page(ctx, page)) {
+			return -EILSEQ;
 		}
+		return 0;
+	}
 
-		page_num = ctx->extent_page_num[i];
-		spdk_bit_array_set(ctx->bs->used_md_pages, page_num);
-		if (bs_load_replay_md_parse_page(ctx, &ctx->extent_pages[i])) {
-			spdk_free(ctx->extent_pages);
-			bs_load_ctx_fail(ctx, -EILSEQ);
-			return;
+	/* Pages other than the first one of a blob are replayed only when reached through the
+	 * chain of their blob. */
+	if (type == BS_REPLAY_PAGE_FIRST && page->sequence_num != 0) {
+		return 0;
+	}
+
+	if (bs_load_replay_md_page_valid(page_num, page) != true) {
+		return 0;
+	}
+
+	spdk_spin_lock(&bs->used_lock);
+	bs_claim_md_page(bs, page_num);
+	spdk_spin_unlock(&bs->used_lock);
+	if (page->sequence_num == 0) {
+		SPDK_NOTICELOG("Recover: blob 0x%" PRIx32 "\n", page_num);
+		spdk_bit_array_set(bs->used_blobids, page_num);
+	}
+
+	if (bs_load_replay_md_parse_page(ctx, page)) {
+		return -EILSEQ;
+	}
+
+	if (page->next != SPDK_INVALID_MD_PAGE) {
+		rc = bs_load_replay_ref_page(ctx, page->next, BS_REPLAY_PAGE_CHAIN);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	for (i = 0; i < ctx->num_extent_pages; i++) {
+		rc = bs_load_replay_ref_page(ctx, ctx->extent_page_num[i], BS_REPLAY_PAGE_EXTENT);
+		if (rc != 0) {
+			return rc;
 		}
 	}
+	ctx->num_extent_pages = 0;
+
+	return 0;
+}
 
-	spdk_free(ctx->extent_pages);
+static void
+bs_load_replay_free(struct spdk_bs_load_ctx *ctx)
+{
+	spdk_free(ctx->replay_pages);
+	ctx->replay_pages = NULL;
+	free(ctx->replay_batch);
+	ctx->replay_batch = NULL;
+	free(ctx->replay_pending.refs);
+	memset(&ctx->replay_pending, 0, sizeof(ctx->replay_pending));
+	free(ctx->replay_deferred.refs);
+	memset(&ctx->replay_deferred, 0, sizeof(ctx->replay_deferred));
+	spdk_bit_array_free(&ctx->replay_want_chain);
+	spdk_bit_array_free(&ctx->replay_want_extent);
 	free(ctx->extent_page_num);
 	ctx->extent_page_num = NULL;
 	ctx->num_extent_pages = 0;
+}
 
-	bs_load_replay_md_chain_cpl(ctx);
+static void
+bs_load_replay_fail(struct spdk_bs_load_ctx *ctx, int bserrno)
+{
+	bs_load_replay_free(ctx);
+	bs_load_ctx_fail(ctx, bserrno);
 }
 
 static void
-bs_load_replay_extent_pages(struct spdk_bs_load_ctx *ctx)
+bs_load_replay_md_done(struct spdk_bs_load_ctx *ctx)
 {
-	spdk_bs_batch_t *batch;
-	uint32_t page;
-	uint64_t lba;
+	uint64_t num_md_clusters;
 	uint64_t i;
 
-	ctx->extent_pages = spdk_zmalloc(SPDK_BS_PAGE_SIZE * ctx->num_extent_pages, 0,
-					 NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (!ctx->extent_pages) {
-		bs_load_ctx_fail(ctx, -ENOMEM);
+	bs_load_replay_free(ctx);
+
+	/* Claim all of the clusters used by the metadata */
+	num_md_clusters = spdk_divide_round_up(
+				  ctx->super->md_start + ctx->super->md_len, ctx->bs->pages_per_cluster);
+	for (i = 0; i < num_md_clusters; i++) {
+		spdk_bit_array_set(ctx->used_clusters, i);
+	}
+	ctx->bs->num_free_clusters -= num_md_clusters;
+	bs_load_write_used_md(ctx);
+}
+
+static void bs_load_replay_deferred(struct spdk_bs_load_ctx *ctx);
+
+static void
+bs_load_replay_deferred_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_bs_load_ctx *ctx = cb_arg;
+	struct bs_replay_page_ref *ref;
+	uint32_t i;
+	int rc;
+
+	if (bserrno != 0) {
+		bs_load_replay_fail(ctx, bserrno);
 		return;
 	}
 
-	batch = bs_sequence_to_batch(ctx->seq, bs_load_replay_extent_page_cpl, ctx);
+	for (i = 0; i < ctx->replay_batch_count; i++) {
+		ref = &ctx->replay_batch[i];
+		rc = bs_load_replay_page(ctx, ref->page_num, &ctx->replay_pages[i], ref->type);
+		if (rc != 0) {
+			bs_load_replay_fail(ctx, rc);
+			return;
+		}
+	}
 
-	for (i = 0; i < ctx->num_extent_pages; i++) {
-		page = ctx->extent_page_num[i];
-		assert(page < ctx->super->md_len);
-		lba = bs_md_page_to_lba(ctx->bs, page);
-		bs_batch_read_dev(batch, &ctx->extent_pages[i], lba,
+	bs_load_replay_deferred(ctx);
+}
+
+/* Replay the pages referenced from pages that were scanned after them. They are read with
+ * one request each, but all of them at once. */
+static void
+bs_load_replay_deferred(struct spdk_bs_load_ctx *ctx)
+{
+	struct bs_replay_page_ref *ref;
+	spdk_bs_batch_t *batch;
+
+	if (ctx->replay_deferred.count == 0) {
+		bs_load_replay_md_done(ctx);
+		return;
+	}
+
+	batch = bs_sequence_to_batch(ctx->seq, bs_load_replay_deferred_cpl, ctx);
+
+	ctx->replay_batch_count = 0;
+	while (ctx->replay_deferred.count > 0 && ctx->replay_batch_count < ctx->replay_max_pages) {
+		ref = &ctx->replay_deferred.refs[--ctx->replay_deferred.count];
+		if (spdk_bit_array_get(ctx->bs->used_md_pages, ref->page_num)) {
+			continue;
+		}
+		ctx->replay_batch[ctx->replay_batch_count] = *ref;
+		bs_batch_read_dev(batch, &ctx->replay_pages[ctx->replay_batch_count],
+				  bs_md_page_to_lba(ctx->bs, ref->page_num),
 				  bs_byte_to_lba(ctx->bs, SPDK_BS_PAGE_SIZE));
+		ctx->replay_batch_count++;
 	}
 
 	bs_batch_close(batch);
 }
 
+static void bs_load_replay_next_window(struct spdk_bs_load_ctx *ctx);
+
 static void
-bs_load_replay_md_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+bs_load_replay_window_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 {
 	struct spdk_bs_load_ctx *ctx = cb_arg;
+	struct bs_replay_page_ref ref;
+	enum bs_replay_page_type type;
 	uint32_t page_num;
-	struct spdk_blob_md_page *page;
+	int rc;
 
 	if (bserrno != 0) {
-		bs_load_ctx_fail(ctx, bserrno);
+		bs_load_replay_fail(ctx, bserrno);
 		return;
 	}
 
-	page_num = ctx->cur_page;
-	page = ctx->page;
-	if (bs_load_cur_md_page_valid(ctx) == true) {
-		if (page->sequence_num == 0 || ctx->in_page_chain == true) {
-			spdk_spin_lock(&ctx->bs->used_lock);
-			bs_claim_md_page(ctx->bs, page_num);
-			spdk_spin_unlock(&ctx->bs->used_lock);
-			if (page->sequence_num == 0) {
-				SPDK_NOTICELOG("Recover: blob 0x%" PRIx32 "\n", page_num);
-				spdk_bit_array_set(ctx->bs->used_blobids, page_num);
-			}
-			if (bs_load_replay_md_parse_page(ctx, page)) {
-				bs_load_ctx_fail(ctx, -EILSEQ);
-				return;
-			}
-			if (page->next != SPDK_INVALID_MD_PAGE) {
-				ctx->in_page_chain = true;
-				ctx->cur_page = page->next;
-				bs_load_replay_cur_md_page(ctx);
-				return;
-			}
-			if (ctx->num_extent_pages != 0) {
-				bs_load_replay_extent_pages(ctx);
-				return;
+	for (page_num = ctx->replay_start; page_num < ctx->replay_end; page_num++) {
+		if (spdk_bit_array_get(ctx->replay_want_extent, page_num)) {
+			type = BS_REPLAY_PAGE_EXTENT;
+		} else if (spdk_bit_array_get(ctx->replay_want_chain, page_num)) {
+			type = BS_REPLAY_PAGE_CHAIN;
+		} else {
+			type = BS_REPLAY_PAGE_FIRST;
+		}
+
+		ref.page_num = page_num;
+		ref.type = type;
+		do {
+			rc = bs_load_replay_page(ctx, ref.page_num,
+						 &ctx->replay_pages[ref.page_num - ctx->replay_start], ref.type);
+			if (rc != 0 || ctx->replay_pending.count == 0) {
+				break;
 			}
+			ref = ctx->replay_pending.refs[--ctx->replay_pending.count];
+		} while (true);
+
+		if (rc != 0) {
+			bs_load_replay_fail(ctx, rc);
+			return;
 		}
 	}
-	bs_load_replay_md_chain_cpl(ctx);
+
+	bs_load_replay_next_window(ctx);
 }
 
 static void
-bs_load_replay_cur_md_page(struct spdk_bs_load_ctx *ctx)
+bs_load_replay_next_window(struct spdk_bs_load_ctx *ctx)
 {
-	uint64_t lba;
+	spdk_bs_batch_t *batch;
+	uint32_t page_num, num_pages;
 
-	assert(ctx->cur_page < ctx->super->md_len);
-	lba = bs_md_page_to_lba(ctx->bs, ctx->cur_page);
-	bs_sequence_read_dev(ctx->seq, ctx->page, lba,
-			     bs_byte_to_lba(ctx->bs, SPDK_BS_PAGE_SIZE),
-			     bs_load_replay_md_cpl, ctx);
+	if (ctx->replay_end >= ctx->super->md_len) {
+		ctx->replay_scan_done = true;
+		bs_load_replay_deferred(ctx);
+		return;
+	}
+
+	ctx->replay_start = ctx->replay_end;
+	ctx->replay_end = spdk_min(ctx->replay_start + ctx->replay_max_pages, ctx->super->md_len);
+
+	batch = bs_sequence_to_batch(ctx->seq, bs_load_replay_window_cpl, ctx);
+
+	for (page_num = ctx->replay_start; page_num < ctx->replay_end; page_num += num_pages) {
+		num_pages = spdk_min(BS_REPLAY_CHUNK_PAGES, ctx->replay_end - page_num);
+		bs_batch_read_dev(batch, &ctx->replay_pages[page_num - ctx->replay_start],
+				  bs_md_page_to_lba(ctx->bs, page_num),
+				  bs_byte_to_lba(ctx->bs, num_pages * SPDK_BS_PAGE_SIZE));
+	}
+
+	bs_batch_close(batch);
 }
 
+/* Rebuild the used metadata page, blob ID and cluster masks from the metadata region. The
+ * region is scanned sequentially in large reads. Pages referenced by a blob are replayed
+ * while they are in memory or once the scan reaches them, and only pages the scan has
+ * already passed are read again individually. */
 static void
 bs_load_replay_md(struct spdk_bs_load_ctx *ctx)
 {
-	ctx->page_index = 0;
-	ctx->cur_page = 0;
-	ctx->page = spdk_zmalloc(SPDK_BS_PAGE_SIZE, 0,
-				 NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (!ctx->page) {
-		bs_load_ctx_fail(ctx, -ENOMEM);
+	ctx->replay_max_pages = spdk_min(BS_REPLAY_WINDOW_PAGES, ctx->super->md_len);
+	ctx->replay_start = 0;
+	ctx->replay_end = 0;
+	ctx->replay_scan_done = false;
+
+	ctx->replay_pages = spdk_zmalloc(ctx->replay_max_pages * SPDK_BS_PAGE_SIZE, 0,
+					 NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	ctx->replay_batch = calloc(ctx->replay_max_pages, sizeof(*ctx->replay_batch));
+	ctx->replay_want_chain = spdk_bit_array_create(ctx->super->md_len);
+	ctx->replay_want_extent = spdk_bit_array_create(ctx->super->md_len);
+	if (!ctx->replay_pages || !ctx->replay_batch ||
+	    !ctx->replay_want_chain || !ctx->replay_want_extent) {
+		bs_load_replay_fail(ctx, -ENOMEM);
 		return;
 	}
-	bs_load_replay_cur_md_page(ctx);
+
+	bs_load_replay_next_window(ctx);
 }
 
 static void
@@ -4912,6 +5962,11 @@ bs_parse_super(struct spdk_bs_load_ctx *ctx)
 		ctx->bs->pages_per_cluster_shift = spdk_u32log2(ctx->bs->pages_per_cluster);
 	}
 	ctx->bs->io_unit_size = ctx->super->io_unit_size;
+	if (!bs_cow_unit_size_valid(ctx->bs->cluster_sz, ctx->super->cow_unit_size)) {
+		SPDK_ERRLOG("Invalid copy-on-write unit size %" PRIu32 "\n", ctx->super->cow_unit_size);
+		return -EILSEQ;
+	}
+	ctx->bs->cow_unit_size = ctx->super->cow_unit_size;
 	rc = spdk_bit_array_resize(&ctx->used_clusters, ctx->bs->total_clusters);
 	if (rc < 0) {
 		return -ENOMEM;
@@ -4987,12 +6042,13 @@ bs_opts_copy(struct spdk_bs_opts *src, struct spdk_bs_opts *dst)
 	SET_FIELD(force_recover);
 	SET_FIELD(esnap_bs_dev_create);
 	SET_FIELD(esnap_ctx);
+	SET_FIELD(cow_unit_size);
 
 	dst->opts_size = src->opts_size;
 
 	/* You should not remove this statement, but need to update the assert statement
 	 * if you add a new field, and also add a corresponding SET_FIELD statement */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 88, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_opts) == 96, "Incorrect size");
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -5165,6 +6221,7 @@ bs_dump_print_type_flags(struct spdk_bs_load_ctx *ctx, struct spdk_blob_md_descr
 		ADD_FLAG(SPDK_BLOB_THIN_PROV),
 		ADD_FLAG(SPDK_BLOB_INTERNAL_XATTR),
 		ADD_FLAG(SPDK_BLOB_EXTENT_TABLE),
+		ADD_FLAG(SPDK_BLOB_PARTIAL_COW),
 	};
 	static struct type_flag_desc data_ro[] = {
 		ADD_FLAG(SPDK_BLOB_READ_ONLY),
@@ -5284,6 +6341,16 @@ bs_dump_print_md_page(struct spdk_bs_load_ctx *ctx)
 				}
 				fprintf(ctx->fp, "\n");
 			}
+		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE_COW) {
+			struct spdk_blob_md_descriptor_extent_page_cow	*desc_cow;
+			unsigned int					i;
+
+			desc_cow = (struct spdk_blob_md_descriptor_extent_page_cow *)desc;
+
+			for (i = 0; i < desc_cow->length / sizeof(desc_cow->clusters[0]); i++) {
+				fprintf(ctx->fp, "Partially Copied Cluster - Index: %" PRIu32 " Units: 0x%016" PRIx64 "\n",
+					desc_cow->clusters[i].cluster_idx, desc_cow->clusters[i].bitmap);
+			}
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_XATTR) {
 			bs_dump_print_xattr(ctx, desc);
 		} else if (desc->type == SPDK_MD_DESCRIPTOR_TYPE_XATTR_INTERNAL) {
@@ -5362,6 +6429,9 @@ bs_dump_super_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 		(ctx->super->crc == blob_md_page_calc_crc(ctx->super)) ? "OK" : "Mismatch");
 	fprintf(ctx->fp, "Blobstore Type: %.*s\n", SPDK_BLOBSTORE_TYPE_LENGTH, ctx->super->bstype.bstype);
 	fprintf(ctx->fp, "Cluster Size: %" PRIu32 "\n", ctx->super->cluster_size);
+	if (ctx->super->cow_unit_size != 0) {
+		fprintf(ctx->fp, "Copy-on-write Unit Size: %" PRIu32 "\n", ctx->super->cow_unit_size);
+	}
 	fprintf(ctx->fp, "Super Blob ID: ");
 	if (ctx->super->super_blob == SPDK_BLOBID_INVALID) {
 		fprintf(ctx->fp, "(None)\n");
@@ -5560,6 +6630,7 @@ spdk_bs_init(struct spdk_bs_dev *dev, struct spdk_bs_opts *o,
 	ctx->super->clean = 0;
 	ctx->super->cluster_size = bs->cluster_sz;
 	ctx->super->io_unit_size = bs->io_unit_size;
+	ctx->super->cow_unit_size = bs->cow_unit_size;
 	memcpy(&ctx->super->bstype, &bs->bstype, sizeof(bs->bstype));
 
 	/* Calculate how many pages the metadata consumes at the front
@@ -5842,6 +6913,27 @@ bs_unload_read_super_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
 	bs_write_used_md(seq, cb_arg, bs_unload_write_used_pages_cpl);
 }
 
+static void
+bs_unload_release_reserved_clusters(struct spdk_io_channel_iter *i)
+{
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+
+	bs_channel_release_reserved_clusters(spdk_io_channel_get_ctx(ch));
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+bs_unload_release_reserved_clusters_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct spdk_bs_load_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_blob_store *bs = ctx->bs;
+
+	/* Read super block */
+	bs_sequence_read_dev(ctx->seq, ctx->super, bs_page_to_lba(bs, 0),
+			     bs_byte_to_lba(bs, sizeof(*ctx->super)),
+			     bs_unload_read_super_cpl, ctx);
+}
+
 void
 spdk_bs_unload(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn, void *cb_arg)
 {
@@ -5908,10 +7000,10 @@ spdk_bs_unload(struct spdk_blob_store *bs, spdk_bs_op_complete cb_fn, void *cb_a
 		return;
 	}
 
-	/* Read super block */
-	bs_sequence_read_dev(ctx->seq, ctx->super, bs_page_to_lba(bs, 0),
-			     bs_byte_to_lba(bs, sizeof(*ctx->super)),
-			     bs_unload_read_super_cpl, ctx);
+	/* Return the clusters reserved by the channels before the used clusters mask is written,
+	 * so that they are not persisted as used. */
+	spdk_for_each_channel(bs, bs_unload_release_reserved_clusters, ctx,
+			      bs_unload_release_reserved_clusters_done);
 }
 
 /* END spdk_bs_unload */
@@ -6045,7 +7137,7 @@ spdk_bs_get_io_unit_size(struct spdk_blob_store *bs)
 uint64_t
 spdk_bs_free_cluster_count(struct spdk_blob_store *bs)
 {
-	return bs->num_free_clusters;
+	return bs->num_free_clusters + __atomic_load_n(&bs->num_reserved_clusters, __ATOMIC_RELAXED);
 }
 
 uint64_t
@@ -6124,7 +7216,7 @@ blob_find_io_unit(struct spdk_blob *blob, uint64_t offset, bool is_allocated)
 			return offset;
 		}
 
-		offset += bs_num_io_units_to_cluster_boundary(blob, offset);
+		offset += bs_num_io_units_to_alloc_boundary(blob, offset);
 	}
 
 	return UINT64_MAX;
@@ -6142,6 +7234,59 @@ spdk_blob_get_next_unallocated_io_unit(struct spdk_blob *blob, uint64_t offset)
 	return blob_find_io_unit(blob, offset, false);
 }
 
+int
+spdk_blob_get_changed_clusters(struct spdk_blob *blob, spdk_blob_id ancestor_id,
+			       struct spdk_bit_array **changed)
+{
+	struct spdk_bit_array *clusters;
+	struct spdk_blob *b;
+	uint64_t num_clusters, i;
+
+	assert(blob != NULL);
+	assert(spdk_get_thread() == blob->bs->md_thread);
+
+	if (ancestor_id == blob->id) {
+		return -EINVAL;
+	}
+
+	num_clusters = blob->active.num_clusters;
+	clusters = spdk_bit_array_create(num_clusters);
+	if (clusters == NULL) {
+		return -ENOMEM;
+	}
+
+	b = blob;
+	while (b != NULL && b->id != ancestor_id) {
+		for (i = 0; i < spdk_min(num_clusters, b->active.num_clusters); i++) {
+			if (b->active.clusters[i] != 0) {
+				spdk_bit_array_set(clusters, i);
+			}
+		}
+
+		if (b->parent_id == SPDK_BLOBID_INVALID ||
+		    b->parent_id == SPDK_BLOBID_EXTERNAL_SNAPSHOT) {
+			b = NULL;
+		} else {
+			b = ((struct spdk_blob_bs_dev *)b->back_bs_dev)->blob;
+		}
+	}
+
+	if (ancestor_id != SPDK_BLOBID_INVALID) {
+		if (b == NULL) {
+			spdk_bit_array_free(&clusters);
+			return -EINVAL;
+		}
+
+		/* Reads past the end of the ancestor return zeroes, not its data */
+		for (i = b->active.num_clusters; i < num_clusters; i++) {
+			spdk_bit_array_set(clusters, i);
+		}
+	}
+
+	*changed = clusters;
+	return 0;
+}
+
 /* START spdk_bs_create_blob */
 
 static void
@@ -6265,6 +7410,10 @@ bs_create_blob(struct spdk_blob_store *bs,
 	blob->use_extent_table = opts_local.use_extent_table;
 	if (blob->use_extent_table) {
 		blob->invalid_flags |= SPDK_BLOB_EXTENT_TABLE;
+		if (bs->cow_unit_size != 0) {
+			/* Clusters copied from a parent of the blob may be partial */
+			blob->invalid_flags |= SPDK_BLOB_PARTIAL_COW;
+		}
 	}
 
 	if (!internal_xattrs) {
@@ -6381,8 +7530,94 @@ struct spdk_clone_snapshot_ctx {
 	/* xattrs specified for snapshot/clones only. They have no impact on
 	 * the original blobs xattrs. */
 	const struct spdk_blob_xattr_opts *xattrs;
+
+	/* Set when the snapshot is part of spdk_bs_create_snapshot_group() */
+	struct bs_snapshot_group_member *group_member;
+};
+
+struct bs_snapshot_group;
+
+struct bs_snapshot_group_member {
+	struct bs_snapshot_group *group;
+	struct spdk_clone_snapshot_ctx *ctx;
+
+	/* Set while the member waits for the rest of the group to reach the same step */
+	void (*resume)(struct spdk_clone_snapshot_ctx *ctx);
+};
+
+struct bs_snapshot_group {
+	spdk_blob_op_with_ids_complete cb_fn;
+	void *cb_arg;
+	int bserrno;
+
+	/* Members that have neither completed nor reached the current step yet */
+	uint32_t outstanding;
+
+	spdk_blob_id *snapshot_ids;
+	uint32_t count;
+	struct bs_snapshot_group_member members[];
 };
 
+static void bs_snapshot_group_advance(struct bs_snapshot_group *group);
+
+static void
+bs_snapshot_group_arrive(struct bs_snapshot_group *group)
+{
+	uint32_t i;
+
+	assert(group->outstanding > 0);
+	if (--group->outstanding > 0) {
+		return;
+	}
+
+	for (i = 0; i < group->count; i++) {
+		if (group->members[i].resume != NULL) {
+			bs_snapshot_group_advance(group);
+			return;
+		}
+	}
+
+	group->cb_fn(group->cb_arg, group->snapshot_ids, group->count, group->bserrno);
+	free(group->snapshot_ids);
+	free(group);
+}
+
+static void
+bs_snapshot_group_advance(struct bs_snapshot_group *group)
+{
+	struct bs_snapshot_group_member *member;
+	void (*resume)(struct spdk_clone_snapshot_ctx *ctx);
+	uint32_t i;
+
+	/* Keep the group alive while members are resumed, some may complete synchronously */
+	group->outstanding = 1;
+	for (i = 0; i < group->count; i++) {
+		member = &group->members[i];
+		if (member->resume == NULL) {
+			continue;
+		}
+
+		resume = member->resume;
+		member->resume = NULL;
+		group->outstanding++;
+		resume(member->ctx);
+	}
+
+	bs_snapshot_group_arrive(group);
+}
+
+/* Park a member until every other member of its group has completed or reached the same step. */
+static void
+bs_snapshot_group_wait(struct spdk_clone_snapshot_ctx *ctx,
+		       void (*resume)(struct spdk_clone_snapshot_ctx *ctx))
+{
+	struct bs_snapshot_group_member *member = ctx->group_member;
+
+	assert(member->resume == NULL);
+	member->resume = resume;
+	bs_snapshot_group_arrive(member->group);
+}
+
 static void
 bs_clone_snapshot_cleanup_finish(void *cb_arg, int bserrno)
 {
@@ -6435,6 +7670,12 @@ bs_snapshot_unfreeze_cpl(void *cb_arg, int bserrno)
 	spdk_blob_close(origblob, bs_clone_snapshot_cleanup_finish, ctx);
 }
 
+static void
+bs_snapshot_group_unfreeze(struct spdk_clone_snapshot_ctx *ctx)
+{
+	blob_unfreeze_io(ctx->original.blob, bs_snapshot_unfreeze_cpl, ctx);
+}
+
 static void
 bs_clone_snapshot_origblob_cleanup(void *cb_arg, int bserrno)
 {
@@ -6449,7 +7690,10 @@ bs_clone_snapshot_origblob_cleanup(void *cb_arg, int bserrno)
 		}
 	}
 
-	if (ctx->frozen) {
+	if (ctx->frozen && ctx->group_member != NULL) {
+		/* Resume I/O on all blobs of the group together */
+		bs_snapshot_group_wait(ctx, bs_snapshot_group_unfreeze);
+	} else if (ctx->frozen) {
 		/* Unfreeze any outstanding I/O */
 		blob_unfreeze_io(origblob, bs_snapshot_unfreeze_cpl, ctx);
 	} else {
@@ -6485,6 +7729,8 @@ bs_snapshot_swap_cluster_maps(struct spdk_blob *blob1, struct spdk_blob *blob2)
 	uint64_t *cluster_temp;
 	uint64_t num_allocated_clusters_temp;
 	uint32_t *extent_page_temp;
+	uint64_t *cow_bitmaps_temp;
+	uint64_t cow_bitmaps_size_temp;
 
 	cluster_temp = blob1->active.clusters;
 	blob1->active.clusters = blob2->active.clusters;
@@ -6497,6 +7743,14 @@ bs_snapshot_swap_cluster_maps(struct spdk_blob *blob1, struct spdk_blob *blob2)
 	extent_page_temp = blob1->active.extent_pages;
 	blob1->active.extent_pages = blob2->active.extent_pages;
 	blob2->active.extent_pages = extent_page_temp;
+
+	cow_bitmaps_temp = blob1->cow_bitmaps;
+	blob1->cow_bitmaps = blob2->cow_bitmaps;
+	blob2->cow_bitmaps = cow_bitmaps_temp;
+
+	cow_bitmaps_size_temp = blob1->cow_bitmaps_size;
+	blob1->cow_bitmaps_size = blob2->cow_bitmaps_size;
+	blob2->cow_bitmaps_size = cow_bitmaps_size_temp;
 }
 
 /* Copies an internal xattr */
@@ -6629,20 +7883,12 @@ bs_snapshot_newblob_sync_cpl(void *cb_arg, int bserrno)
 }
 
 static void
-bs_snapshot_freeze_cpl(void *cb_arg, int rc)
+bs_snapshot_frozen(struct spdk_clone_snapshot_ctx *ctx)
 {
-	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
 	struct spdk_blob *origblob = ctx->original.blob;
 	struct spdk_blob *newblob = ctx->new.blob;
 	int bserrno;
 
-	if (rc != 0) {
-		bs_clone_snapshot_newblob_cleanup(ctx, rc);
-		return;
-	}
-
-	ctx->frozen = true;
-
 	if (blob_is_esnap_clone(origblob)) {
 		/* Clean up any channels associated with the original blob id because future IO will
 		 * perform IO using the snapshot blob_id.
@@ -6689,6 +7935,84 @@ bs_snapshot_freeze_cpl(void *cb_arg, int rc)
 	spdk_blob_sync_md(newblob, bs_snapshot_newblob_sync_cpl, ctx);
 }
 
+static void
+bs_snapshot_group_cancel_delete_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+
+	if (bserrno != 0) {
+		SPDK_ERRLOG("Could not delete snapshot 0x%" PRIx64 " of cancelled group, error %d\n",
+			    ctx->new.id, bserrno);
+	}
+
+	bs_clone_snapshot_origblob_cleanup(ctx, -ECANCELED);
+}
+
+static void
+bs_snapshot_group_cancel_close_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+
+	if (bserrno != 0) {
+		bs_clone_snapshot_origblob_cleanup(ctx, bserrno);
+		return;
+	}
+
+	spdk_bs_delete_blob(ctx->original.blob->bs, ctx->new.id, bs_snapshot_group_cancel_delete_cpl,
+			    ctx);
+}
+
+/* Another member of the group failed, drop the snapshot blob before it was ever used. */
+static void
+bs_snapshot_group_cancel(struct spdk_clone_snapshot_ctx *ctx)
+{
+	ctx->new.id = ctx->new.blob->id;
+	spdk_blob_close(ctx->new.blob, bs_snapshot_group_cancel_close_cpl, ctx);
+}
+
+static void
+bs_snapshot_group_frozen(struct spdk_clone_snapshot_ctx *ctx)
+{
+	if (ctx->group_member->group->bserrno != 0) {
+		bs_snapshot_group_cancel(ctx);
+		return;
+	}
+
+	bs_snapshot_frozen(ctx);
+}
+
+static void
+bs_snapshot_freeze_cpl(void *cb_arg, int rc)
+{
+	struct spdk_clone_snapshot_ctx *ctx = (struct spdk_clone_snapshot_ctx *)cb_arg;
+
+	if (rc != 0) {
+		bs_clone_snapshot_newblob_cleanup(ctx, rc);
+		return;
+	}
+
+	ctx->frozen = true;
+
+	if (ctx->group_member != NULL) {
+		/* Switch the blobs to their snapshots only once all of them are frozen */
+		bs_snapshot_group_wait(ctx, bs_snapshot_group_frozen);
+		return;
+	}
+
+	bs_snapshot_frozen(ctx);
+}
+
+static void
+bs_snapshot_group_freeze(struct spdk_clone_snapshot_ctx *ctx)
+{
+	if (ctx->group_member->group->bserrno != 0) {
+		bs_snapshot_group_cancel(ctx);
+		return;
+	}
+
+	blob_freeze_io(ctx->original.blob, bs_snapshot_freeze_cpl, ctx);
+}
+
 static void
 bs_snapshot_newblob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 {
@@ -6708,6 +8032,12 @@ bs_snapshot_newblob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 	assert(spdk_mem_all_zero(newblob->active.extent_pages,
 				 newblob->active.num_extent_pages * sizeof(*newblob->active.extent_pages)));
 
+	if (ctx->group_member != NULL) {
+		/* Freeze all blobs of the group at once, after all snapshot blobs are created */
+		bs_snapshot_group_wait(ctx, bs_snapshot_group_freeze);
+		return;
+	}
+
 	blob_freeze_io(origblob, bs_snapshot_freeze_cpl, ctx);
 }
 
@@ -6817,6 +8147,91 @@ spdk_bs_create_snapshot(struct spdk_blob_store *bs, spdk_blob_id blobid,
 
 	spdk_bs_open_blob(bs, ctx->original.id, bs_snapshot_origblob_open_cpl, ctx);
 }
+
+static void
+bs_snapshot_group_member_cpl(void *cb_arg, spdk_blob_id blobid, int bserrno)
+{
+	struct bs_snapshot_group_member *member = cb_arg;
+	struct bs_snapshot_group *group = member->group;
+
+	if (bserrno != 0) {
+		if (group->bserrno == 0) {
+			group->bserrno = bserrno;
+		}
+		blobid = SPDK_BLOBID_INVALID;
+	}
+
+	group->snapshot_ids[member - group->members] = blobid;
+	member->ctx = NULL;
+
+	bs_snapshot_group_arrive(group);
+}
+
+void
+spdk_bs_create_snapshot_group(struct spdk_blob_store *bs, const spdk_blob_id *blobids,
+			      uint32_t count, const struct spdk_blob_xattr_opts *snapshot_xattrs,
+			      spdk_blob_op_with_ids_complete cb_fn, void *cb_arg)
+{
+	struct bs_snapshot_group *group;
+	struct bs_snapshot_group_member *member;
+	struct spdk_clone_snapshot_ctx *ctx;
+	uint32_t i;
+
+	if (count == 0) {
+		cb_fn(cb_arg, NULL, 0, -EINVAL);
+		return;
+	}
+
+	group = calloc(1, sizeof(*group) + count * sizeof(group->members[0]));
+	if (!group) {
+		cb_fn(cb_arg, NULL, 0, -ENOMEM);
+		return;
+	}
+
+	group->snapshot_ids = calloc(count, sizeof(*group->snapshot_ids));
+	if (!group->snapshot_ids) {
+		free(group);
+		cb_fn(cb_arg, NULL, 0, -ENOMEM);
+		return;
+	}
+
+	group->cb_fn = cb_fn;
+	group->cb_arg = cb_arg;
+	group->count = count;
+	for (i = 0; i < count; i++) {
+		group->snapshot_ids[i] = SPDK_BLOBID_INVALID;
+		group->members[i].group = group;
+	}
+
+	/* Hold the group until all members are started */
+	group->outstanding = 1;
+	for (i = 0; i < count; i++) {
+		member = &group->members[i];
+
+		ctx = calloc(1, sizeof(*ctx));
+		if (!ctx) {
+			/* Members already started will be cancelled before freezing I/O */
+			group->bserrno = -ENOMEM;
+			break;
+		}
+
+		ctx->cpl.type = SPDK_BS_CPL_TYPE_BLOBID;
+		ctx->cpl.u.blobid.cb_fn = bs_snapshot_group_member_cpl;
+		ctx->cpl.u.blobid.cb_arg = member;
+		ctx->cpl.u.blobid.blobid = SPDK_BLOBID_INVALID;
+		ctx->bserrno = 0;
+		ctx->frozen = false;
+		ctx->original.id = blobids[i];
+		ctx->xattrs = snapshot_xattrs != NULL ? &snapshot_xattrs[i] : NULL;
+		ctx->group_member = member;
+		member->ctx = ctx;
+
+		group->outstanding++;
+		spdk_bs_open_blob(bs, ctx->original.id, bs_snapshot_origblob_open_cpl, ctx);
+	}
+
+	bs_snapshot_group_arrive(group);
+}
 /* END spdk_bs_create_snapshot */
 
 /* START spdk_bs_create_clone */
@@ -6959,6 +8374,7 @@ bs_inflate_blob_set_parent_cpl(void *cb_arg, struct spdk_blob *_parent, int bser
 
 	blob_back_bs_destroy(_blob);
 	_blob->back_bs_dev = bs_create_blob_bs_dev(_parent);
+	bs_chain_cache_invalidate(_blob->bs);
 	bs_blob_list_add(_blob);
 
 	spdk_blob_sync_md(_blob, bs_clone_snapshot_origblob_cleanup, ctx);
@@ -6982,6 +8398,7 @@ bs_inflate_blob_done(struct spdk_clone_snapshot_ctx *ctx)
 		_blob->invalid_flags = _blob->invalid_flags & ~SPDK_BLOB_THIN_PROV;
 		blob_back_bs_destroy(_blob);
 		_blob->parent_id = SPDK_BLOBID_INVALID;
+		bs_chain_cache_invalidate(_blob->bs);
 	} else {
 		/* For now, esnap clones always have allocate_all set. */
 		assert(!blob_is_esnap_clone(_blob));
@@ -6998,6 +8415,7 @@ bs_inflate_blob_done(struct spdk_clone_snapshot_ctx *ctx)
 		_blob->parent_id = SPDK_BLOBID_INVALID;
 		blob_back_bs_destroy(_blob);
 		_blob->back_bs_dev = bs_create_zeroes_dev();
+		bs_chain_cache_invalidate(_blob->bs);
 	}
 
 	/* Temporarily override md_ro flag for MD modification */
@@ -7016,6 +8434,11 @@ bs_cluster_needs_allocation(struct spdk_blob *blob, uint64_t cluster, bool alloc
 
 	assert(blob != NULL);
 
+	if (blob_cluster_cow_bitmap(blob, cluster) != 0) {
+		/* Cluster is allocated, but was copied from the parent only partially */
+		return true;
+	}
+
 	if (blob->active.clusters[cluster] != 0) {
 		/* Cluster is already allocated */
 		return false;
@@ -7135,12 +8558,14 @@ bs_inflate_blob_open_cpl(void *cb_arg, struct spdk_blob *_blob, int bserrno)
 	 */
 	clusters_needed = 0;
 	for (i = 0; i < _blob->active.num_clusters; i++) {
-		if (bs_cluster_needs_allocation(_blob, i, ctx->allocate_all)) {
+		if (bs_cluster_needs_allocation(_blob, i, ctx->allocate_all) &&
+		    _blob->active.clusters[i] == 0) {
 			clusters_needed++;
 		}
 	}
 
-	if (clusters_needed > _blob->bs->num_free_clusters) {
+	/* Clusters held in channel reserves are taken back once the free pool runs dry */
+	if (clusters_needed > spdk_bs_free_cluster_count(_blob->bs)) {
 		/* Not enough free clusters. Cannot satisfy the request. */
 		bs_clone_snapshot_origblob_cleanup(ctx, -ENOSPC);
 		return;
@@ -7205,6 +8630,11 @@ struct shallow_copy_ctx {
 	/* Current cluster for copy operation */
 	uint64_t cluster;
 
+	/* For incremental copies, the ancestor and the clusters changed since it */
+	bool incremental;
+	spdk_blob_id ancestor_id;
+	struct spdk_bit_array *changed;
+
 	/* Buffer for blob reading */
 	uint8_t *read_buff;
 
@@ -7234,6 +8664,7 @@ bs_shallow_copy_cleanup_finish(void *cb_arg, int bserrno)
 
 	ctx->ext_dev->destroy_channel(ctx->ext_dev, ctx->ext_channel);
 	spdk_free(ctx->read_buff);
+	spdk_bit_array_free(&ctx->changed);
 
 	cpl->u.blob_basic.cb_fn(cpl->u.blob_basic.cb_arg, ctx->bserrno);
 
@@ -7294,19 +8725,27 @@ bs_shallow_copy_cluster_find_next(void *cb_arg)
 	struct shallow_copy_ctx *ctx = cb_arg;
 	struct spdk_blob *_blob = ctx->blob;
 
-	while (ctx->cluster < _blob->active.num_clusters) {
-		if (_blob->active.clusters[ctx->cluster] != 0) {
-			break;
+	if (ctx->changed != NULL) {
+		ctx->cluster = spdk_bit_array_find_first_set(ctx->changed, ctx->cluster);
+		if (ctx->cluster == UINT32_MAX) {
+			ctx->cluster = _blob->active.num_clusters;
 		}
+	} else {
+		while (ctx->cluster < _blob->active.num_clusters) {
+			if (_blob->active.clusters[ctx->cluster] != 0) {
+				break;
+			}
 
-		ctx->cluster++;
+			ctx->cluster++;
+		}
 	}
 
 	if (ctx->cluster < _blob->active.num_clusters) {
-		blob_request_submit_op_single(ctx->blob_channel, _blob, ctx->read_buff,
-					      bs_cluster_to_lba(_blob->bs, ctx->cluster),
-					      bs_dev_byte_to_lba(_blob->bs->dev, _blob->bs->cluster_sz),
-					      bs_shallow_copy_blob_read_cpl, ctx, SPDK_BLOB_READ);
+		/* Partially copied clusters are split between the blob and its parent */
+		blob_request_submit_op(_blob, ctx->blob_channel, ctx->read_buff,
+				       bs_cluster_to_lba(_blob->bs, ctx->cluster),
+				       bs_dev_byte_to_lba(_blob->bs->dev, _blob->bs->cluster_sz),
+				       bs_shallow_copy_blob_read_cpl, ctx, SPDK_BLOB_READ);
 	} else {
 		_blob->locked_operation_in_progress = false;
 		spdk_blob_close(_blob, bs_shallow_copy_cleanup_finish, ctx);
@@ -7363,17 +8802,29 @@ blobstore block size\n", _blob->id);
 		return;
 	}
 
+	if (ctx->incremental) {
+		bserrno = spdk_blob_get_changed_clusters(_blob, ctx->ancestor_id, &ctx->changed);
+		if (bserrno != 0) {
+			SPDK_ERRLOG("blob 0x%" PRIx64 " shallow copy, cannot get clusters changed since 0x%"
+				    PRIx64 ", error %d\n", _blob->id, ctx->ancestor_id, bserrno);
+			ctx->bserrno = bserrno;
+			spdk_blob_close(_blob, bs_shallow_copy_cleanup_finish, ctx);
+			return;
+		}
+	}
+
 	_blob->locked_operation_in_progress = true;
 
 	ctx->cluster = 0;
 	bs_shallow_copy_cluster_find_next(ctx);
 }
 
-int
-spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
-			  spdk_blob_id blobid, struct spdk_bs_dev *ext_dev,
-			  spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
-			  spdk_blob_op_complete cb_fn, void *cb_arg)
+static int
+bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+		     spdk_blob_id blobid, bool incremental, spdk_blob_id ancestor_id,
+		     struct spdk_bs_dev *ext_dev,
+		     spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+		     spdk_blob_op_complete cb_fn, void *cb_arg)
 {
 	struct shallow_copy_ctx *ctx;
 	struct spdk_io_channel *ext_channel;
@@ -7385,6 +8836,8 @@ spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 
 	ctx->bs = bs;
 	ctx->blobid = blobid;
+	ctx->incremental = incremental;
+	ctx->ancestor_id = ancestor_id;
 	ctx->cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
 	ctx->cpl.u.bs_basic.cb_fn = cb_fn;
 	ctx->cpl.u.bs_basic.cb_arg = cb_arg;
@@ -7412,6 +8865,27 @@ spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 
 	return 0;
 }
+
+int
+spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *channel,
+			  spdk_blob_id blobid, struct spdk_bs_dev *ext_dev,
+			  spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+			  spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	return bs_blob_shallow_copy(bs, channel, blobid, false, SPDK_BLOBID_INVALID, ext_dev,
+				    status_cb_fn, status_cb_arg, cb_fn, cb_arg);
+}
+
+int
+spdk_bs_blob_shallow_copy_incremental(struct spdk_blob_store *bs,
+				      struct spdk_io_channel *channel, spdk_blob_id blobid,
+				      spdk_blob_id ancestor_id, struct spdk_bs_dev *ext_dev,
+				      spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+				      spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	return bs_blob_shallow_copy(bs, channel, blobid, true, ancestor_id, ext_dev,
+				    status_cb_fn, status_cb_arg, cb_fn, cb_arg);
+}
 /* END spdk_bs_blob_shallow_copy */
 
 /* START spdk_bs_blob_set_parent */
@@ -7958,6 +9432,7 @@ struct delete_snapshot_ctx {
 	void *cb_arg;
 	int bserrno;
 	uint32_t next_extent_page;
+	uint64_t next_cluster;
 };
 
 static void
@@ -8115,6 +9590,9 @@ delete_snapshot_sync_clone_cpl(void *cb_arg, int bserrno)
 				ctx->snapshot->active.num_allocated_clusters--;
 			}
 			ctx->snapshot->active.clusters[i] = 0;
+			if (i < ctx->snapshot->cow_bitmaps_size) {
+				ctx->snapshot->cow_bitmaps[i] = 0;
+			}
 		}
 	}
 	for (i = 0; i < ctx->snapshot->active.num_extent_pages &&
@@ -8231,6 +9709,15 @@ delete_snapshot_sync_snapshot_xattr_cpl(void *cb_arg, int bserrno)
 		return;
 	}
 
+	if (ctx->snapshot->cow_bitmaps_size != 0) {
+		bserrno = blob_cow_bitmaps_resize(ctx->clone, ctx->clone->active.num_clusters);
+		if (bserrno != 0) {
+			ctx->bserrno = bserrno;
+			delete_snapshot_cleanup_clone(ctx, 0);
+			return;
+		}
+	}
+
 	/* Copy snapshot map to clone map (only unallocated clusters in clone) */
 	for (i = 0; i < ctx->snapshot->active.num_clusters && i < ctx->clone->active.num_clusters; i++) {
 		if (ctx->clone->active.clusters[i] == 0) {
@@ -8238,6 +9725,10 @@ delete_snapshot_sync_snapshot_xattr_cpl(void *cb_arg, int bserrno)
 			if (ctx->clone->active.clusters[i] != 0) {
 				ctx->clone->active.num_allocated_clusters++;
 			}
+			if (i < ctx->snapshot->cow_bitmaps_size) {
+				/* Rest of a partially copied cluster keeps coming from the parent */
+				ctx->clone->cow_bitmaps[i] = ctx->snapshot->cow_bitmaps[i];
+			}
 		}
 	}
 	ctx->next_extent_page = 0;
@@ -8259,17 +9750,8 @@ delete_snapshot_esnap_channels_destroyed_cb(void *cb_arg, struct spdk_blob *blob
 }
 
 static void
-delete_snapshot_freeze_io_cb(void *cb_arg, int bserrno)
+delete_snapshot_fill_clone_done(struct delete_snapshot_ctx *ctx)
 {
-	struct delete_snapshot_ctx *ctx = cb_arg;
-
-	if (bserrno) {
-		SPDK_ERRLOG("Failed to freeze I/O on clone\n");
-		ctx->bserrno = bserrno;
-		delete_snapshot_cleanup_clone(ctx, 0);
-		return;
-	}
-
 	/* Temporarily override md_ro flag for snapshot for MD modification */
 	ctx->snapshot_md_ro = ctx->snapshot->md_ro;
 	ctx->snapshot->md_ro = false;
@@ -8292,6 +9774,68 @@ delete_snapshot_freeze_io_cb(void *cb_arg, int bserrno)
 	spdk_blob_sync_md(ctx->snapshot, delete_snapshot_sync_snapshot_xattr_cpl, ctx);
 }
 
+/* Clusters of the clone that were copied from the snapshot only partially are completed
+ * from it one by one, as the snapshot data goes away with it. */
+static void
+delete_snapshot_fill_clone_next(void *cb_arg, int bserrno)
+{
+	struct delete_snapshot_ctx *ctx = cb_arg;
+	struct spdk_blob *clone = ctx->clone;
+	struct spdk_bs_cpl cpl;
+	spdk_bs_user_op_t *op;
+	uint64_t offset;
+
+	if (bserrno) {
+		SPDK_ERRLOG("Failed to copy partially copied cluster of clone\n");
+		ctx->bserrno = bserrno;
+		delete_snapshot_cleanup_clone(ctx, 0);
+		return;
+	}
+
+	for (; ctx->next_cluster < clone->cow_bitmaps_size; ctx->next_cluster++) {
+		if (clone->cow_bitmaps[ctx->next_cluster] != 0) {
+			break;
+		}
+	}
+
+	if (ctx->next_cluster == clone->cow_bitmaps_size) {
+		delete_snapshot_fill_clone_done(ctx);
+		return;
+	}
+
+	offset = bs_cluster_to_lba(clone->bs, ctx->next_cluster);
+	ctx->next_cluster++;
+
+	/* Use a dummy 0B read as a context for cluster copy */
+	cpl.type = SPDK_BS_CPL_TYPE_BLOB_BASIC;
+	cpl.u.blob_basic.cb_fn = delete_snapshot_fill_clone_next;
+	cpl.u.blob_basic.cb_arg = ctx;
+
+	op = bs_user_op_alloc(clone->bs->md_channel, &cpl, SPDK_BLOB_READ, clone, NULL, 0, offset, 0);
+	if (!op) {
+		delete_snapshot_fill_clone_next(ctx, -ENOMEM);
+		return;
+	}
+
+	bs_allocate_and_copy_cluster(clone, clone->bs->md_channel, offset, op);
+}
+
+static void
+delete_snapshot_freeze_io_cb(void *cb_arg, int bserrno)
+{
+	struct delete_snapshot_ctx *ctx = cb_arg;
+
+	if (bserrno) {
+		SPDK_ERRLOG("Failed to freeze I/O on clone\n");
+		ctx->bserrno = bserrno;
+		delete_snapshot_cleanup_clone(ctx, 0);
+		return;
+	}
+
+	ctx->next_cluster = 0;
+	delete_snapshot_fill_clone_next(ctx, 0);
+}
+
 static void
 delete_snapshot_open_clone_cb(void *cb_arg, struct spdk_blob *clone, int bserrno)
 {
@@ -8474,6 +10018,8 @@ bs_delete_open_cpl(void *cb_arg, struct spdk_blob *blob, int bserrno)
 	 */
 	spdk_bit_array_clear(blob->bs->open_blobids, blob->id);
 	RB_REMOVE(spdk_blob_tree, &blob->bs->open_blobs, blob);
+	/* The id may be reused by a blob with a different chain */
+	bs_chain_cache_invalidate(blob->bs);
 
 	if (update_clone) {
 		ctx->page = spdk_zmalloc(SPDK_BS_PAGE_SIZE, 0, NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
@@ -8578,6 +10124,7 @@ static void
 bs_open_blob(struct spdk_blob_store *bs,
 	     spdk_blob_id blobid,
 	     struct spdk_blob_open_opts *opts,
+	     const struct spdk_blob_md_page *first_page,
 	     spdk_blob_op_with_handle_complete cb_fn,
 	     void *cb_arg)
 {
@@ -8630,21 +10177,21 @@ bs_open_blob(struct spdk_blob_store *bs,
 		return;
 	}
 
-	blob_load(seq, blob, bs_open_blob_cpl, blob);
+	blob_load(seq, blob, first_page, bs_open_blob_cpl, blob);
 }
 
 void
 spdk_bs_open_blob(struct spdk_blob_store *bs, spdk_blob_id blobid,
 		  spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
 {
-	bs_open_blob(bs, blobid, NULL, cb_fn, cb_arg);
+	bs_open_blob(bs, blobid, NULL, NULL, cb_fn, cb_arg);
 }
 
 void
 spdk_bs_open_blob_ext(struct spdk_blob_store *bs, spdk_blob_id blobid,
 		      struct spdk_blob_open_opts *opts, spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
 {
-	bs_open_blob(bs, blobid, opts, cb_fn, cb_arg);
+	bs_open_blob(bs, blobid, opts, NULL, cb_fn, cb_arg);
 }
 
 /* END spdk_bs_open_blob */
@@ -8721,9 +10268,24 @@ struct spdk_blob_cluster_op_ctx {
 	uint32_t		cluster;	/* cluster on disk */
 	uint32_t		extent_page;	/* extent page on disk */
 	struct spdk_blob_md_page *page; /* preallocated extent page */
+	uint64_t		cow_bitmap;	/* units present in a partially copied cluster */
 	int			rc;
 	spdk_blob_op_complete	cb_fn;
 	void			*cb_arg;
+	TAILQ_ENTRY(spdk_blob_cluster_op_ctx) link;
+};
+
+/*
+ * Write of an extent page for clusters inserted on the md thread. Clusters inserted into
+ * the same extent page while it is being written wait for the write to finish and are then
+ * persisted together by a single write of the page.
+ */
+struct spdk_bs_extent_page_persist {
+	struct spdk_blob				*blob;
+	uint32_t					extent_page;
+	TAILQ_HEAD(, spdk_blob_cluster_op_ctx)		in_progress;
+	TAILQ_HEAD(, spdk_blob_cluster_op_ctx)		pending;
+	TAILQ_ENTRY(spdk_bs_extent_page_persist)	link;
 };
 
 static void
@@ -8868,12 +10430,88 @@ blob_write_extent_page(struct spdk_blob *blob, uint32_t extent, uint64_t cluster
 	bs_mark_dirty(seq, blob->bs, blob_write_extent_page_ready, ctx);
 }
 
+static void blob_extent_page_persist_start(struct spdk_bs_extent_page_persist *persist);
+
+static void
+blob_extent_page_persist_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_extent_page_persist *persist = cb_arg;
+	struct spdk_blob_cluster_op_ctx *ctx;
+
+	while ((ctx = TAILQ_FIRST(&persist->in_progress))) {
+		TAILQ_REMOVE(&persist->in_progress, ctx, link);
+		blob_op_cluster_msg_cb(ctx, bserrno);
+	}
+
+	if (!TAILQ_EMPTY(&persist->pending)) {
+		TAILQ_SWAP(&persist->in_progress, &persist->pending, spdk_blob_cluster_op_ctx, link);
+		blob_extent_page_persist_start(persist);
+		return;
+	}
+
+	TAILQ_REMOVE(&persist->blob->bs->ep_persists, persist, link);
+	free(persist);
+}
+
+static void
+blob_extent_page_persist_start(struct spdk_bs_extent_page_persist *persist)
+{
+	struct spdk_blob_cluster_op_ctx *ctx = TAILQ_FIRST(&persist->in_progress);
+
+	/* The page of any of the waiting inserts can be used, as each of them is
+	 * only released once its insert completes. */
+	blob_write_extent_page(persist->blob, persist->extent_page, ctx->cluster_num, ctx->page,
+			       blob_extent_page_persist_cpl, persist);
+}
+
+/* Persist the extent page holding a newly inserted cluster, batching it with other
+ * inserts into the same extent page. */
+static void
+blob_extent_page_persist(struct spdk_blob_cluster_op_ctx *ctx, uint32_t extent_page)
+{
+	struct spdk_blob_store *bs = ctx->blob->bs;
+	struct spdk_bs_extent_page_persist *persist;
+
+	assert(spdk_get_thread() == bs->md_thread);
+
+	TAILQ_FOREACH(persist, &bs->ep_persists, link) {
+		if (persist->extent_page == extent_page) {
+			assert(persist->blob == ctx->blob);
+			TAILQ_INSERT_TAIL(&persist->pending, ctx, link);
+			return;
+		}
+	}
+
+	persist = calloc(1, sizeof(*persist));
+	if (persist == NULL) {
+		blob_op_cluster_msg_cb(ctx, -ENOMEM);
+		return;
+	}
+
+	persist->blob = ctx->blob;
+	persist->extent_page = extent_page;
+	TAILQ_INIT(&persist->in_progress);
+	TAILQ_INIT(&persist->pending);
+	TAILQ_INSERT_TAIL(&persist->in_progress, ctx, link);
+	TAILQ_INSERT_TAIL(&bs->ep_persists, persist, link);
+
+	blob_extent_page_persist_start(persist);
+}
+
 static void
 blob_insert_cluster_msg(void *arg)
 {
 	struct spdk_blob_cluster_op_ctx *ctx = arg;
 	uint32_t *extent_page;
 
+	if (ctx->cow_bitmap != 0) {
+		ctx->rc = blob_insert_cow_bitmap(ctx->blob, ctx->cluster_num, ctx->cow_bitmap);
+		if (ctx->rc != 0) {
+			spdk_thread_send_msg(ctx->thread, blob_op_cluster_msg_cpl, ctx);
+			return;
+		}
+	}
+
 	ctx->rc = blob_insert_cluster(ctx->blob, ctx->cluster_num, ctx->cluster);
 	if (ctx->rc != 0) {
 		spdk_thread_send_msg(ctx->thread, blob_op_cluster_msg_cpl, ctx);
@@ -8908,15 +10546,14 @@ blob_insert_cluster_msg(void *arg)
 		}
 		/* Extent page already allocated.
 		 * Every cluster allocation, requires just an update of single extent page. */
-		blob_write_extent_page(ctx->blob, *extent_page, ctx->cluster_num, ctx->page,
-				       blob_op_cluster_msg_cb, ctx);
+		blob_extent_page_persist(ctx, *extent_page);
 	}
 }
 
 static void
 blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
 				 uint64_t cluster, uint32_t extent_page, struct spdk_blob_md_page *page,
-				 spdk_blob_op_complete cb_fn, void *cb_arg)
+				 uint64_t cow_bitmap, spdk_blob_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_blob_cluster_op_ctx *ctx;
 
@@ -8932,12 +10569,100 @@ blob_insert_cluster_on_md_thread(struct spdk_blob *blob, uint32_t cluster_num,
 	ctx->cluster = cluster;
 	ctx->extent_page = extent_page;
 	ctx->page = page;
+	ctx->cow_bitmap = cow_bitmap;
 	ctx->cb_fn = cb_fn;
 	ctx->cb_arg = cb_arg;
 
 	spdk_thread_send_msg(blob->bs->md_thread, blob_insert_cluster_msg, ctx);
 }
 
+/* Hand out copy-on-write units to the fills waiting on md thread, unless another fill
+ * is copying some of the same units already. */
+static void
+blob_cow_fills_process(struct spdk_blob *blob)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx, *tmp, *other;
+	uint64_t lba, units;
+
+	TAILQ_FOREACH_SAFE(ctx, &blob->cow_fills, link, tmp) {
+		if (ctx->cow_claimed != 0) {
+			continue;
+		}
+
+		lba = blob->active.clusters[ctx->cluster_num];
+		units = ctx->cow_request & ~blob_cluster_cow_bitmap(blob, ctx->cluster_num);
+		if (lba == 0 || blob_cluster_cow_bitmap(blob, ctx->cluster_num) == 0 || units == 0) {
+			/* Cluster was released or the units were copied meanwhile,
+			 * the user op gets re-executed. */
+			TAILQ_REMOVE(&blob->cow_fills, ctx, link);
+			spdk_thread_send_msg(ctx->thread, blob_cow_fill_claimed, ctx);
+			continue;
+		}
+
+		TAILQ_FOREACH(other, &blob->cow_fills, link) {
+			if (other->cluster_num == ctx->cluster_num && (other->cow_claimed & units) != 0) {
+				break;
+			}
+		}
+		if (other != NULL) {
+			continue;
+		}
+
+		ctx->cow_claimed = units;
+		ctx->new_cluster = bs_lba_to_cluster(blob->bs, lba);
+		spdk_thread_send_msg(ctx->thread, blob_cow_fill_claimed, ctx);
+	}
+}
+
+static void
+blob_cow_fill_claim_msg(void *arg)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = arg;
+
+	TAILQ_INSERT_TAIL(&ctx->blob->cow_fills, ctx, link);
+	blob_cow_fills_process(ctx->blob);
+}
+
+static void
+blob_cow_fill_update_msg(void *arg)
+{
+	struct spdk_blob_copy_cluster_ctx *ctx = arg;
+	struct spdk_blob *blob = ctx->blob;
+	struct spdk_blob_cluster_op_ctx *op_ctx;
+	uint64_t bitmap;
+
+	TAILQ_REMOVE(&blob->cow_fills, ctx, link);
+
+	if (ctx->rc != 0 ||
+	    blob->active.clusters[ctx->cluster_num] != bs_cluster_to_lba(blob->bs, ctx->new_cluster)) {
+		/* Nothing to mark present, the user op gets re-executed or fails */
+		spdk_thread_send_msg(ctx->thread, blob_cow_fill_done, ctx);
+		blob_cow_fills_process(blob);
+		return;
+	}
+
+	bitmap = blob->cow_bitmaps[ctx->cluster_num] | ctx->cow_claimed;
+	blob->cow_bitmaps[ctx->cluster_num] = bitmap == bs_cow_bitmap_full(blob->bs) ? 0 : bitmap;
+	ctx->op_done = ctx->op_written;
+
+	op_ctx = calloc(1, sizeof(*op_ctx));
+	if (op_ctx == NULL) {
+		/* Bitmap stays updated in memory, to be persisted with the extent page later */
+		ctx->rc = -ENOMEM;
+		spdk_thread_send_msg(ctx->thread, blob_cow_fill_done, ctx);
+	} else {
+		op_ctx->thread = ctx->thread;
+		op_ctx->blob = blob;
+		op_ctx->cluster_num = ctx->cluster_num;
+		op_ctx->page = ctx->new_cluster_page;
+		op_ctx->cb_fn = blob_cow_fill_cpl;
+		op_ctx->cb_arg = ctx;
+		blob_extent_page_persist(op_ctx, *bs_cluster_to_extent_page(blob, ctx->cluster_num));
+	}
+
+	blob_cow_fills_process(blob);
+}
+
 static void
 blob_free_cluster_msg(void *arg)
 {
@@ -8959,6 +10684,9 @@ blob_free_cluster_msg(void *arg)
 	if (ctx->cluster != 0) {
 		ctx->blob->active.num_allocated_clusters--;
 	}
+	if (ctx->cluster_num < ctx->blob->cow_bitmaps_size) {
+		ctx->blob->cow_bitmaps[ctx->cluster_num] = 0;
+	}
 
 	if (ctx->blob->use_extent_table == false) {
 		/* Extent table is not used, proceed with sync of md that will only use extents_rle. */
@@ -9266,6 +10994,240 @@ spdk_bs_iter_next(struct spdk_blob_store *bs, struct spdk_blob *blob,
 	spdk_blob_close(blob, bs_iter_close_cpl, ctx);
 }
 
+/* Number of metadata pages read per blob opened at once by spdk_bs_iter_blobs(). Extent pages
+ * and additional metadata pages of the blobs are interleaved with their first pages, so a few
+ * more than one are read for each of them. */
+#define BS_ITER_BLOBS_PAGES_PER_BLOB 4
+
+struct spdk_bs_iter_blobs_ctx;
+
+struct spdk_bs_iter_blobs_slot {
+	struct spdk_bs_iter_blobs_ctx	*ctx;
+	spdk_blob_id			id;
+	struct spdk_blob		*blob;
+};
+
+struct spdk_bs_iter_blobs_ctx {
+	struct spdk_blob_store		*bs;
+	spdk_bs_sequence_t		*seq;
+	spdk_blob_iter_cb		iter_fn;
+	void				*cb_arg;
+	int				rc;
+
+	/* First metadata page to look for blobs at in the next batch */
+	uint64_t			page_num;
+
+	/* Metadata pages read for the current batch, starting at pages_start */
+	struct spdk_blob_md_page	*pages;
+	uint32_t			max_pages;
+	uint64_t			pages_start;
+
+	/* Blobs of the current batch, in blob ID order */
+	struct spdk_bs_iter_blobs_slot	*slots;
+	uint32_t			max_slots;
+	uint32_t			num_slots;
+	uint32_t			outstanding;
+};
+
+static void bs_iter_blobs_next_batch(struct spdk_bs_iter_blobs_ctx *ctx);
+
+static void
+bs_iter_blobs_finish(struct spdk_bs_iter_blobs_ctx *ctx)
+{
+	spdk_bs_sequence_t *seq = ctx->seq;
+	int rc = ctx->rc;
+
+	spdk_free(ctx->pages);
+	free(ctx->slots);
+	free(ctx);
+
+	bs_sequence_finish(seq, rc);
+}
+
+static void
+bs_iter_blobs_close_cpl(void *cb_arg, int bserrno)
+{
+	struct spdk_bs_iter_blobs_slot *slot = cb_arg;
+	struct spdk_bs_iter_blobs_ctx *ctx = slot->ctx;
+
+	if (bserrno != 0) {
+		SPDK_ERRLOG("Failed to close blob 0x%" PRIx64 ": %d\n", slot->id, bserrno);
+	}
+
+	if (--ctx->outstanding == 0) {
+		bs_iter_blobs_next_batch(ctx);
+	}
+}
+
+static void
+bs_iter_blobs_batch_opened(struct spdk_bs_iter_blobs_ctx *ctx)
+{
+	struct spdk_bs_iter_blobs_slot *slot;
+	uint32_t i;
+
+	/* Hand the blobs to the user in blob ID order, so that the order does not depend on which
+	 * of the opens completed first. */
+	for (i = 0; i < ctx->num_slots; i++) {
+		slot = &ctx->slots[i];
+		if (slot->blob != NULL && ctx->rc == 0) {
+			ctx->rc = ctx->iter_fn(ctx->cb_arg, slot->blob);
+		}
+	}
+
+	ctx->outstanding = 1;
+	for (i = 0; i < ctx->num_slots; i++) {
+		slot = &ctx->slots[i];
+		if (slot->blob != NULL) {
+			ctx->outstanding++;
+			spdk_blob_close(slot->blob, bs_iter_blobs_close_cpl, slot);
+			slot->blob = NULL;
+		}
+	}
+
+	if (--ctx->outstanding == 0) {
+		bs_iter_blobs_next_batch(ctx);
+	}
+}
+
+static void
+bs_iter_blobs_open_cpl(void *cb_arg, struct spdk_blob *blob, int bserrno)
+{
+	struct spdk_bs_iter_blobs_slot *slot = cb_arg;
+	struct spdk_bs_iter_blobs_ctx *ctx = slot->ctx;
+
+	if (bserrno == 0) {
+		slot->blob = blob;
+	} else {
+		/* Like spdk_bs_iter_next(), skip blobs that cannot be opened. */
+		SPDK_DEBUGLOG(blob, "Skipping blob 0x%" PRIx64 ": %d\n", slot->id, bserrno);
+	}
+
+	if (--ctx->outstanding == 0) {
+		bs_iter_blobs_batch_opened(ctx);
+	}
+}
+
+static void
+bs_iter_blobs_read_cpl(spdk_bs_sequence_t *seq, void *cb_arg, int bserrno)
+{
+	struct spdk_bs_iter_blobs_ctx *ctx = cb_arg;
+	struct spdk_bs_iter_blobs_slot *slot;
+	uint64_t page_num;
+	uint32_t i;
+
+	if (bserrno != 0) {
+		ctx->rc = bserrno;
+		bs_iter_blobs_finish(ctx);
+		return;
+	}
+
+	ctx->outstanding = 1;
+	for (i = 0; i < ctx->num_slots; i++) {
+		slot = &ctx->slots[i];
+		page_num = bs_blobid_to_page(slot->id);
+		ctx->outstanding++;
+		bs_open_blob(ctx->bs, slot->id, NULL, &ctx->pages[page_num - ctx->pages_start],
+			     bs_iter_blobs_open_cpl, slot);
+	}
+
+	if (--ctx->outstanding == 0) {
+		bs_iter_blobs_batch_opened(ctx);
+	}
+}
+
+static void
+bs_iter_blobs_next_batch(struct spdk_bs_iter_blobs_ctx *ctx)
+{
+	struct spdk_blob_store *bs = ctx->bs;
+	uint64_t capacity = spdk_bit_array_capacity(bs->used_blobids);
+	uint64_t page_num, last_page = 0;
+
+	if (ctx->rc != 0) {
+		bs_iter_blobs_finish(ctx);
+		return;
+	}
+
+	/* Collect the next blobs whose first metadata pages fit in a single read */
+	ctx->num_slots = 0;
+	page_num = ctx->page_num;
+	while (ctx->num_slots < ctx->max_slots) {
+		page_num = spdk_bit_array_find_first_set(bs->used_blobids, page_num);
+		if (page_num >= capacity ||
+		    (ctx->num_slots > 0 && page_num - ctx->pages_start >= ctx->max_pages)) {
+			break;
+		}
+		if (ctx->num_slots == 0) {
+			ctx->pages_start = page_num;
+		}
+		ctx->slots[ctx->num_slots].id = bs_page_to_blobid(page_num);
+		ctx->num_slots++;
+		last_page = page_num;
+		page_num++;
+	}
+
+	if (ctx->num_slots == 0) {
+		bs_iter_blobs_finish(ctx);
+		return;
+	}
+
+	ctx->page_num = last_page + 1;
+
+	bs_sequence_read_dev(ctx->seq, ctx->pages, bs_md_page_to_lba(bs, ctx->pages_start),
+			     bs_byte_to_lba(bs, (last_page - ctx->pages_start + 1) * SPDK_BS_PAGE_SIZE),
+			     bs_iter_blobs_read_cpl, ctx);
+}
+
+void
+spdk_bs_iter_blobs(struct spdk_blob_store *bs, uint32_t queue_depth,
+		   spdk_blob_iter_cb iter_fn, spdk_bs_op_complete cb_fn, void *cb_arg)
+{
+	struct spdk_bs_iter_blobs_ctx *ctx;
+	struct spdk_bs_cpl cpl;
+	uint32_t i;
+
+	assert(spdk_get_thread() == bs->md_thread);
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb_fn(cb_arg, -ENOMEM);
+		return;
+	}
+
+	ctx->bs = bs;
+	ctx->iter_fn = iter_fn;
+	ctx->cb_arg = cb_arg;
+	ctx->max_slots = spdk_max(queue_depth, 1);
+	ctx->max_pages = ctx->max_slots * BS_ITER_BLOBS_PAGES_PER_BLOB;
+
+	ctx->slots = calloc(ctx->max_slots, sizeof(*ctx->slots));
+	ctx->pages = spdk_zmalloc(ctx->max_pages * SPDK_BS_PAGE_SIZE, 0, NULL,
+				  SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (!ctx->slots || !ctx->pages) {
+		goto nomem;
+	}
+	for (i = 0; i < ctx->max_slots; i++) {
+		ctx->slots[i].ctx = ctx;
+	}
+
+	cpl.type = SPDK_BS_CPL_TYPE_BS_BASIC;
+	cpl.u.bs_basic.cb_fn = cb_fn;
+	cpl.u.bs_basic.cb_arg = cb_arg;
+
+	ctx->seq = bs_sequence_start_bs(bs->md_channel, &cpl);
+	if (!ctx->seq) {
+		goto nomem;
+	}
+
+	bs_iter_blobs_next_batch(ctx);
+	return;
+
+nomem:
+	spdk_free(ctx->pages);
+	free(ctx->slots);
+	free(ctx);
+	cb_fn(cb_arg, -ENOMEM);
+}
+
 static int
 blob_set_xattr(struct spdk_blob *blob, const char *name, const void *value,
 	       uint16_t value_len, bool internal)
@@ -9619,6 +11581,7 @@ bs_load_grow_continue(struct spdk_bs_load_ctx *ctx)
 		ctx->bs->pages_per_cluster_shift = spdk_u32log2(ctx->bs->pages_per_cluster);
 	}
 	ctx->bs->io_unit_size = ctx->super->io_unit_size;
+	ctx->bs->cow_unit_size = ctx->super->cow_unit_size;
 	rc = spdk_bit_array_resize(&ctx->used_clusters, ctx->bs->total_clusters);
 	if (rc < 0) {
 		bs_load_ctx_fail(ctx, -ENOMEM);
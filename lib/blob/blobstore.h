@@ -25,6 +25,16 @@
 #define SPDK_BLOB_OPTS_NUM_MD_PAGES UINT32_MAX
 #define SPDK_BLOB_OPTS_MAX_MD_OPS 32
 #define SPDK_BLOB_OPTS_DEFAULT_CHANNEL_OPS 512
+/* Largest number of free clusters a channel keeps reserved for first writes to thin blobs */
+#define SPDK_BS_CHANNEL_MAX_RESERVED_CLUSTERS 32
+/* A channel reserves at most this fraction of the free clusters at once */
+#define SPDK_BS_CHANNEL_RESERVE_FREE_DIVISOR 128
+/* Largest number of copy-on-write units in a cluster, one bit each in a bitmap */
+#define SPDK_BS_COW_UNITS_PER_CLUSTER_MAX 64
+/* Number of entries of the per-channel cache of clusters resolved through snapshot chains */
+#define SPDK_BS_CHANNEL_CHAIN_CACHE_SIZE 1024
+/* Cached LBA of a cluster that is not allocated anywhere in its snapshot chain */
+#define SPDK_BS_CHAIN_CACHE_LBA_ZEROES UINT64_MAX
 #define SPDK_BLOB_BLOBID_HIGH_BIT (1ULL << 32)
 
 struct spdk_xattr {
@@ -151,6 +161,16 @@ struct spdk_blob {
 	/* Number of data clusters retrieved from extent table,
 	 * that many have to be read from extent pages. */
 	uint64_t	remaining_clusters_in_et;
+
+	/* Bitmaps of copy-on-write units already copied from the parent, for clusters
+	 * that were copied only partially. Indexed by cluster number, 0 for clusters
+	 * that are unallocated or fully copied. Only modified on md thread. */
+	uint64_t	*cow_bitmaps;
+	uint64_t	cow_bitmaps_size;
+
+	/* Copy-on-write units of partially copied clusters currently being copied,
+	 * only used on md thread. */
+	TAILQ_HEAD(, spdk_blob_copy_cluster_ctx) cow_fills;
 };
 
 struct spdk_blob_store {
@@ -175,9 +195,13 @@ struct spdk_blob_store {
 	uint64_t			total_clusters;
 	uint64_t			total_data_clusters;
 	uint64_t			num_free_clusters;	/* Protected by used_lock */
+	/* Clusters claimed from used_clusters but kept in channel reserves, updated atomically. */
+	uint64_t			num_reserved_clusters;
+	TAILQ_HEAD(, spdk_bs_channel)	channels;		/* Protected by used_lock */
 	uint64_t			pages_per_cluster;
 	uint8_t				pages_per_cluster_shift;
 	uint32_t			io_unit_size;
+	uint32_t			cow_unit_size; /* 0 if clusters are copied whole */
 
 	spdk_blob_id			super_blob;
 	struct spdk_bs_type		bstype;
@@ -200,6 +224,21 @@ struct spdk_blob_store {
 	uint32_t			esnap_channels_unloading;
 	spdk_bs_op_complete		esnap_unload_cb_fn;
 	void				*esnap_unload_cb_arg;
+
+	/* Extent page writes in progress for newly inserted clusters, only used on md thread. */
+	TAILQ_HEAD(, spdk_bs_extent_page_persist) ep_persists;
+
+	/* Bumped whenever the snapshot chain of any blob changes, which invalidates
+	 * the chain caches of all channels. */
+	uint64_t			chain_gen;
+};
+
+/* Cluster of a clone resolved to the LBA of the ancestor snapshot that owns it */
+struct spdk_bs_chain_cache_entry {
+	spdk_blob_id	blobid;
+	uint64_t	cluster;
+	uint64_t	lba;
+	uint64_t	gen;
 };
 
 struct spdk_bs_channel {
@@ -214,10 +253,22 @@ struct spdk_bs_channel {
 	/* This page is only used during insert of a new cluster. */
 	struct spdk_blob_md_page	*new_cluster_page;
 
+	/* Free clusters claimed in advance, so that most first writes to thin blobs
+	 * don't need to take the used_lock. Taken under reserve_lock, which is only
+	 * contended when the blobstore runs out of free clusters and takes them back. */
+	struct spdk_spinlock		reserve_lock;
+	uint32_t			reserved_clusters[SPDK_BS_CHANNEL_MAX_RESERVED_CLUSTERS];
+	uint32_t			num_reserved_clusters;
+	TAILQ_ENTRY(spdk_bs_channel)	link;
+
 	TAILQ_HEAD(, spdk_bs_request_set) need_cluster_alloc;
 	TAILQ_HEAD(, spdk_bs_request_set) queued_io;
 
 	RB_HEAD(blob_esnap_channel_tree, blob_esnap_channel) esnap_channels;
+
+	/* Direct mapped, so that reads of unallocated clusters of clones go straight
+	 * to the owning snapshot instead of through every blob of the chain. */
+	struct spdk_bs_chain_cache_entry	*chain_cache;
 };
 
 /** operation type */
@@ -285,6 +336,11 @@ struct spdk_bs_md_mask {
  * with 0's being unallocated clusters. It is NOT part of
  * serialized metadata chain for a blob. */
 #define SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE 6
+/* EXTENT_PAGE_COW descriptor may follow the EXTENT_PAGE descriptor
+ * in an extent page. It holds bitmaps of the copy-on-write units
+ * present for the clusters of that extent page, that were copied
+ * from the parent only partially. */
+#define SPDK_MD_DESCRIPTOR_TYPE_EXTENT_PAGE_COW 7
 
 struct spdk_blob_md_descriptor_xattr {
 	uint8_t		type;
@@ -330,12 +386,24 @@ struct spdk_blob_md_descriptor_extent_page {
 	uint32_t	cluster_idx[0];
 };
 
+struct spdk_blob_md_descriptor_extent_page_cow {
+	uint8_t		type;
+	uint32_t	length;
+
+	struct {
+		uint32_t	cluster_idx; /* Cluster index in the blob */
+		uint64_t	bitmap; /* Copy-on-write units present in the cluster */
+	} clusters[0];
+};
+
 #define SPDK_BLOB_THIN_PROV		(1ULL << 0)
 #define SPDK_BLOB_INTERNAL_XATTR	(1ULL << 1)
 #define SPDK_BLOB_EXTENT_TABLE		(1ULL << 2)
 #define SPDK_BLOB_EXTERNAL_SNAPSHOT	(1ULL << 3)
+#define SPDK_BLOB_PARTIAL_COW		(1ULL << 4)
 #define SPDK_BLOB_INVALID_FLAGS_MASK	(SPDK_BLOB_THIN_PROV | SPDK_BLOB_INTERNAL_XATTR | \
-					 SPDK_BLOB_EXTENT_TABLE | SPDK_BLOB_EXTERNAL_SNAPSHOT)
+					 SPDK_BLOB_EXTENT_TABLE | SPDK_BLOB_EXTERNAL_SNAPSHOT | \
+					 SPDK_BLOB_PARTIAL_COW)
 
 #define SPDK_BLOB_READ_ONLY (1ULL << 0)
 #define SPDK_BLOB_DATA_RO_FLAGS_MASK	SPDK_BLOB_READ_ONLY
@@ -396,6 +464,14 @@ SPDK_STATIC_ASSERT(SPDK_BS_PAGE_SIZE == sizeof(struct spdk_blob_md_page), "Inval
 #define SPDK_EXTENTS_PER_EP_MAX ((SPDK_BS_MAX_DESC_SIZE - sizeof(struct spdk_blob_md_descriptor_extent_page)) / sizeof(uint32_t))
 #define SPDK_EXTENTS_PER_EP (spdk_align64pow2(SPDK_EXTENTS_PER_EP_MAX + 1) >> 1u)
 
+/* Maximum number of partially copied clusters an Extent Page can hold bitmaps for,
+ * in the space left after SPDK_EXTENTS_PER_EP extents. */
+#define SPDK_COW_CLUSTERS_PER_EP ((SPDK_BS_MAX_DESC_SIZE - \
+				   sizeof(struct spdk_blob_md_descriptor_extent_page) - \
+				   SPDK_EXTENTS_PER_EP * sizeof(uint32_t) - \
+				   sizeof(struct spdk_blob_md_descriptor_extent_page_cow)) / \
+				  SPDK_SIZEOF_MEMBER(struct spdk_blob_md_descriptor_extent_page_cow, clusters[0]))
+
 #define SPDK_BS_SUPER_BLOCK_SIG "SPDKBLOB"
 
 struct spdk_bs_super_block {
@@ -424,7 +500,9 @@ struct spdk_bs_super_block {
 	uint64_t	size; /* size of blobstore in bytes */
 	uint32_t	io_unit_size; /* Size of io unit in bytes */
 
-	uint8_t		reserved[4000];
+	uint32_t	cow_unit_size; /* Granularity of copy-on-write in bytes, 0 for whole clusters */
+
+	uint8_t		reserved[3996];
 	uint32_t	crc;
 };
 SPDK_STATIC_ASSERT(sizeof(struct spdk_bs_super_block) == 0x1000, "Invalid super block size");
@@ -663,6 +741,48 @@ bs_io_unit_to_cluster_number(struct spdk_blob *blob, uint64_t io_unit)
 	}
 }
 
+static inline uint64_t
+bs_io_units_per_cow_unit(struct spdk_blob_store *bs)
+{
+	return bs->cow_unit_size / bs->io_unit_size;
+}
+
+/* Bitmap with all copy-on-write units of a cluster set */
+static inline uint64_t
+bs_cow_bitmap_full(struct spdk_blob_store *bs)
+{
+	uint64_t num_units = bs->cluster_sz / bs->cow_unit_size;
+
+	return num_units == 64 ? UINT64_MAX : (1ULL << num_units) - 1;
+}
+
+/* Bitmap of copy-on-write units present in a partially copied cluster, 0 otherwise. */
+static inline uint64_t
+blob_cluster_cow_bitmap(struct spdk_blob *blob, uint64_t cluster_num)
+{
+	if (spdk_likely(cluster_num >= blob->cow_bitmaps_size)) {
+		return 0;
+	}
+
+	return blob->cow_bitmaps[cluster_num];
+}
+
+/* Given an io unit offset into an allocated cluster of a blob, look up if the
+ * copy-on-write unit it belongs to has already been copied into that cluster. */
+static inline bool
+bs_io_unit_is_copied(struct spdk_blob *blob, uint64_t io_unit)
+{
+	uint64_t	io_units_per_cluster = bs_io_units_per_cluster(blob);
+	uint64_t	bitmap;
+
+	bitmap = blob_cluster_cow_bitmap(blob, io_unit / io_units_per_cluster);
+	if (spdk_likely(bitmap == 0)) {
+		return true;
+	}
+
+	return (bitmap >> ((io_unit % io_units_per_cluster) / bs_io_units_per_cow_unit(blob->bs))) & 1;
+}
+
 /* Given an io unit offset into a blob, look up if it is from allocated cluster. */
 static inline bool
 bs_io_unit_is_allocated(struct spdk_blob *blob, uint64_t io_unit)
@@ -688,8 +808,38 @@ bs_io_unit_is_allocated(struct spdk_blob *blob, uint64_t io_unit)
 		assert(spdk_blob_is_thin_provisioned(blob));
 		return false;
 	} else {
-		return true;
+		return bs_io_unit_is_copied(blob, io_unit);
 	}
 }
 
+/* Given an io_unit offset into a blob, look up the number of io_units until the next
+ * cluster boundary or, within a partially copied cluster, until the next boundary between
+ * copy-on-write units present in the cluster and the ones still only in the parent.
+ */
+static inline uint32_t
+bs_num_io_units_to_alloc_boundary(struct spdk_blob *blob, uint64_t io_unit)
+{
+	uint64_t	io_units_per_cluster = bs_io_units_per_cluster(blob);
+	uint64_t	offset = io_unit % io_units_per_cluster;
+	uint64_t	bitmap, io_units_per_cow_unit, cow_unit, changes;
+
+	bitmap = blob_cluster_cow_bitmap(blob, io_unit / io_units_per_cluster);
+	if (spdk_likely(bitmap == 0)) {
+		return io_units_per_cluster - offset;
+	}
+
+	io_units_per_cow_unit = bs_io_units_per_cow_unit(blob->bs);
+	cow_unit = offset / io_units_per_cow_unit;
+
+	/* Bits set for the units with different state than the current one */
+	changes = ((bitmap >> cow_unit) & 1) ? ~bitmap : bitmap;
+	changes &= ~0ULL << cow_unit;
+	if (changes == 0) {
+		return io_units_per_cluster - offset;
+	}
+
+	return spdk_min(__builtin_ctzll(changes) * io_units_per_cow_unit,
+			io_units_per_cluster) - offset;
+}
+
 #endif
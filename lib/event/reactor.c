@@ -893,6 +893,13 @@ _reactors_scheduler_gather_metrics(void *arg1, void *arg2)
 static int _reactor_schedule_thread(struct spdk_thread *thread);
 static uint64_t g_rusage_period;
 
+static inline bool
+scheduler_check_balance(uint64_t now)
+{
+	return g_scheduler != NULL && g_scheduler->check_balance != NULL &&
+	       g_scheduler->check_balance(now);
+}
+
 static void
 _reactor_remove_lw_thread(struct spdk_reactor *reactor, struct spdk_lw_thread *lw_thread)
 {
@@ -1013,9 +1020,10 @@ reactor_run(void *arg)
 		}
 
 		if (spdk_unlikely(g_scheduler_period > 0 &&
-				  (reactor->tsc_last - last_sched) > g_scheduler_period &&
 				  reactor == g_scheduling_reactor &&
-				  !g_scheduling_in_progress)) {
+				  !g_scheduling_in_progress &&
+				  ((reactor->tsc_last - last_sched) > g_scheduler_period ||
+				   scheduler_check_balance(reactor->tsc_last)))) {
 			last_sched = reactor->tsc_last;
 			g_scheduling_in_progress = true;
 			_reactors_scheduler_gather_metrics(NULL, NULL);
@@ -197,55 +197,58 @@ bs_unload_with_error_cb(void *cb_arg, int lvolerrno)
 }
 
 static void
-load_next_lvol(void *cb_arg, struct spdk_blob *blob, int lvolerrno)
+load_lvols_cpl(void *cb_arg, int lvolerrno)
 {
 	struct spdk_lvs_with_handle_req *req = cb_arg;
 	struct spdk_lvol_store *lvs = req->lvol_store;
 	struct spdk_blob_store *bs = lvs->blobstore;
 	struct spdk_lvol *lvol, *tmp;
+
+	if (lvolerrno != 0) {
+		SPDK_ERRLOG("Failed to load lvols: %d\n", lvolerrno);
+		req->lvserrno = lvolerrno;
+	}
+
+	if (req->lvserrno == 0) {
+		lvs->load_esnaps = true;
+		req->cb_fn(req->cb_arg, lvs, req->lvserrno);
+		free(req);
+	} else {
+		TAILQ_FOREACH_SAFE(lvol, &lvs->lvols, link, tmp) {
+			TAILQ_REMOVE(&lvs->lvols, lvol, link);
+			lvol_free(lvol);
+		}
+		lvs_free(lvs);
+		spdk_bs_unload(bs, bs_unload_with_error_cb, req);
+	}
+}
+
+static int
+load_lvol(void *cb_arg, struct spdk_blob *blob)
+{
+	struct spdk_lvs_with_handle_req *req = cb_arg;
+	struct spdk_lvol_store *lvs = req->lvol_store;
+	struct spdk_lvol *lvol;
 	spdk_blob_id blob_id;
 	const char *attr;
 	size_t value_len;
 	int rc;
 
-	if (lvolerrno == -ENOENT) {
-		/* Finished iterating */
-		if (req->lvserrno == 0) {
-			lvs->load_esnaps = true;
-			req->cb_fn(req->cb_arg, lvs, req->lvserrno);
-			free(req);
-		} else {
-			TAILQ_FOREACH_SAFE(lvol, &lvs->lvols, link, tmp) {
-				TAILQ_REMOVE(&lvs->lvols, lvol, link);
-				lvol_free(lvol);
-			}
-			lvs_free(lvs);
-			spdk_bs_unload(bs, bs_unload_with_error_cb, req);
-		}
-		return;
-	} else if (lvolerrno < 0) {
-		SPDK_ERRLOG("Failed to fetch blobs list\n");
-		req->lvserrno = lvolerrno;
-		goto invalid;
-	}
-
 	blob_id = spdk_blob_get_id(blob);
 
 	if (blob_id == lvs->super_blob_id) {
 		SPDK_INFOLOG(lvol, "found superblob %"PRIu64"\n", (uint64_t)blob_id);
-		spdk_bs_iter_next(bs, blob, load_next_lvol, req);
-		return;
+		return 0;
 	}
 
 	lvol = calloc(1, sizeof(*lvol));
 	if (!lvol) {
 		SPDK_ERRLOG("Cannot alloc memory for lvol base pointer\n");
-		req->lvserrno = -ENOMEM;
-		goto invalid;
+		return -ENOMEM;
 	}
 
 	/*
-	 * Do not store a reference to blob now because spdk_bs_iter_next() will close it.
+	 * Do not store a reference to blob now because it is closed once the lvols are loaded.
 	 * Storing blob_id for future lookups is fine.
 	 */
 	lvol->blob_id = blob_id;
@@ -272,8 +275,7 @@ load_next_lvol(void *cb_arg, struct spdk_blob *blob, int lvolerrno)
 	if (rc != 0 || value_len > SPDK_LVOL_NAME_MAX) {
 		SPDK_ERRLOG("Cannot assign lvol name\n");
 		lvol_free(lvol);
-		req->lvserrno = -EINVAL;
-		goto invalid;
+		return -EINVAL;
 	}
 
 	snprintf(lvol->name, sizeof(lvol->name), "%s", attr);
@@ -284,8 +286,7 @@ load_next_lvol(void *cb_arg, struct spdk_blob *blob, int lvolerrno)
 
 	SPDK_INFOLOG(lvol, "added lvol %s (%s)\n", lvol->unique_id, lvol->uuid_str);
 
-invalid:
-	spdk_bs_iter_next(bs, blob, load_next_lvol, req);
+	return 0;
 }
 
 static void
@@ -304,7 +305,7 @@ close_super_cb(void *cb_arg, int lvolerrno)
 	}
 
 	/* Start loading lvols */
-	spdk_bs_iter_first(lvs->blobstore, load_next_lvol, req);
+	spdk_bs_iter_blobs(lvs->blobstore, req->load_queue_depth, load_lvol, load_lvols_cpl, req);
 }
 
 static void
@@ -461,6 +462,7 @@ lvs_load(struct spdk_bs_dev *bs_dev, const struct spdk_lvs_opts *_lvs_opts,
 	req->cb_fn = cb_fn;
 	req->cb_arg = cb_arg;
 	req->bs_dev = bs_dev;
+	req->load_queue_depth = lvs_opts.load_queue_depth;
 
 	lvs_bs_opts_init(&bs_opts);
 	snprintf(bs_opts.bstype.bstype, sizeof(bs_opts.bstype.bstype), "LVOLSTORE");
@@ -621,6 +623,7 @@ spdk_lvs_opts_init(struct spdk_lvs_opts *o)
 	o->cluster_sz = SPDK_LVS_OPTS_CLUSTER_SZ;
 	o->clear_method = LVS_CLEAR_WITH_UNMAP;
 	o->num_md_pages_per_cluster_ratio = 100;
+	o->load_queue_depth = SPDK_LVS_LOAD_QUEUE_DEPTH_DEFAULT;
 	o->opts_size = sizeof(*o);
 }
 
@@ -647,12 +650,13 @@ lvs_opts_copy(const struct spdk_lvs_opts *src, struct spdk_lvs_opts *dst)
 	SET_FIELD(num_md_pages_per_cluster_ratio);
 	SET_FIELD(opts_size);
 	SET_FIELD(esnap_bs_dev_create);
+	SET_FIELD(load_queue_depth);
 
 	dst->opts_size = src->opts_size;
 
 	/* You should not remove this statement, but need to update the assert statement
 	 * if you add a new field, and also add a corresponding SET_FIELD statement */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_lvs_opts) == 88, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_lvs_opts) == 92, "Incorrect size");
 
 #undef FIELD_OK
 #undef SET_FIELD
@@ -1354,6 +1358,217 @@ spdk_lvol_create_snapshot(struct spdk_lvol *origlvol, const char *snapshot_name,
 				lvol_create_cb, req);
 }
 
+struct lvol_snapshot_group_member {
+	struct lvol_snapshot_group_req	*group;
+	struct spdk_lvol		*origlvol;
+	struct spdk_lvol		*snapshot;
+};
+
+struct lvol_snapshot_group_req {
+	spdk_lvol_op_with_handles_complete	cb_fn;
+	void					*cb_arg;
+	int					lvolerrno;
+	uint32_t				outstanding;
+	char					*xattr_names[2];
+	struct spdk_blob_xattr_opts		*xattrs;
+	spdk_blob_id				*blobids;
+	struct spdk_lvol			**snapshots;
+	uint32_t				count;
+	struct lvol_snapshot_group_member	members[];
+};
+
+static void
+lvol_snapshot_group_free(struct lvol_snapshot_group_req *group)
+{
+	free(group->xattrs);
+	free(group->blobids);
+	free(group->snapshots);
+	free(group);
+}
+
+static void
+lvol_snapshot_group_put(struct lvol_snapshot_group_req *group)
+{
+	uint32_t i;
+
+	assert(group->outstanding > 0);
+	if (--group->outstanding > 0) {
+		return;
+	}
+
+	for (i = 0; i < group->count; i++) {
+		group->snapshots[i] = group->members[i].snapshot;
+	}
+
+	group->cb_fn(group->cb_arg, group->snapshots, group->count, group->lvolerrno);
+	lvol_snapshot_group_free(group);
+}
+
+static void
+lvol_snapshot_group_member_cb(void *cb_arg, struct spdk_lvol *lvol, int lvolerrno)
+{
+	struct lvol_snapshot_group_member *member = cb_arg;
+	struct lvol_snapshot_group_req *group = member->group;
+
+	if (lvolerrno != 0 && group->lvolerrno == 0) {
+		group->lvolerrno = lvolerrno;
+	}
+
+	member->snapshot = lvolerrno == 0 ? lvol : NULL;
+	lvol_snapshot_group_put(group);
+}
+
+static void
+lvol_snapshot_group_cb(void *cb_arg, const spdk_blob_id *blobids, uint32_t count, int lvolerrno)
+{
+	struct lvol_snapshot_group_req *group = cb_arg;
+	struct lvol_snapshot_group_member *member;
+	struct spdk_lvol_with_handle_req *req;
+	uint32_t i;
+
+	group->lvolerrno = lvolerrno;
+	group->outstanding = 1;
+
+	for (i = 0; i < group->count; i++) {
+		member = &group->members[i];
+
+		req = calloc(1, sizeof(*req));
+		if (!req) {
+			SPDK_ERRLOG("Cannot alloc memory for lvol request pointer\n");
+			if (group->lvolerrno == 0) {
+				group->lvolerrno = -ENOMEM;
+			}
+			TAILQ_REMOVE(&member->snapshot->lvol_store->pending_lvols, member->snapshot, link);
+			lvol_free(member->snapshot);
+			member->snapshot = NULL;
+			continue;
+		}
+
+		/* Open the snapshots that were created, release the lvols of the others */
+		req->lvol = member->snapshot;
+		req->origlvol = member->origlvol;
+		req->cb_fn = lvol_snapshot_group_member_cb;
+		req->cb_arg = member;
+		member->snapshot = NULL;
+
+		group->outstanding++;
+		lvol_create_cb(req, blobids[i], blobids[i] == SPDK_BLOBID_INVALID ?
+			       (lvolerrno != 0 ? lvolerrno : -EIO) : 0);
+	}
+
+	lvol_snapshot_group_put(group);
+}
+
+void
+spdk_lvol_create_snapshot_group(struct spdk_lvol **lvols, const char **snapshot_names,
+				uint32_t count, spdk_lvol_op_with_handles_complete cb_fn,
+				void *cb_arg)
+{
+	struct lvol_snapshot_group_req *group;
+	struct lvol_snapshot_group_member *member;
+	struct spdk_lvol_store *lvs;
+	struct spdk_lvol *newlvol;
+	uint32_t i, j;
+	int rc = 0;
+
+	if (count == 0 || lvols == NULL || snapshot_names == NULL || lvols[0] == NULL) {
+		SPDK_INFOLOG(lvol, "Lvols not provided.\n");
+		cb_fn(cb_arg, NULL, 0, -EINVAL);
+		return;
+	}
+
+	lvs = lvols[0]->lvol_store;
+	if (lvs == NULL) {
+		SPDK_ERRLOG("lvol store does not exist\n");
+		cb_fn(cb_arg, NULL, 0, -EINVAL);
+		return;
+	}
+
+	group = calloc(1, sizeof(*group) + count * sizeof(group->members[0]));
+	if (group == NULL) {
+		SPDK_ERRLOG("Cannot alloc memory for lvol request pointer\n");
+		cb_fn(cb_arg, NULL, 0, -ENOMEM);
+		return;
+	}
+
+	group->xattrs = calloc(count, sizeof(*group->xattrs));
+	group->blobids = calloc(count, sizeof(*group->blobids));
+	group->snapshots = calloc(count, sizeof(*group->snapshots));
+	if (group->xattrs == NULL || group->blobids == NULL || group->snapshots == NULL) {
+		SPDK_ERRLOG("Cannot alloc memory for lvol request pointer\n");
+		lvol_snapshot_group_free(group);
+		cb_fn(cb_arg, NULL, 0, -ENOMEM);
+		return;
+	}
+
+	group->cb_fn = cb_fn;
+	group->cb_arg = cb_arg;
+	group->count = count;
+	group->xattr_names[0] = LVOL_NAME;
+	group->xattr_names[1] = "uuid";
+
+	for (i = 0; i < count; i++) {
+		member = &group->members[i];
+		member->group = group;
+		member->origlvol = lvols[i];
+
+		if (lvols[i] == NULL || lvols[i]->lvol_store != lvs) {
+			SPDK_ERRLOG("All lvols of a snapshot group must be in the same lvol store\n");
+			rc = -EINVAL;
+			break;
+		}
+
+		for (j = 0; j < i; j++) {
+			if (lvols[j] == lvols[i]) {
+				SPDK_ERRLOG("lvol %s is given more than once in the snapshot group\n",
+					    lvols[i]->name);
+				rc = -EINVAL;
+				break;
+			}
+		}
+		if (rc != 0) {
+			break;
+		}
+
+		/* Names already taken by earlier members are pending and fail the check too */
+		rc = lvs_verify_lvol_name(lvs, snapshot_names[i]);
+		if (rc < 0) {
+			break;
+		}
+
+		newlvol = lvol_alloc(lvs, snapshot_names[i], true,
+				     (enum lvol_clear_method)lvols[i]->clear_method);
+		if (!newlvol) {
+			SPDK_ERRLOG("Cannot alloc memory for lvol base pointer\n");
+			rc = -ENOMEM;
+			break;
+		}
+
+		member->snapshot = newlvol;
+		group->blobids[i] = spdk_blob_get_id(lvols[i]->blob);
+		group->xattrs[i].count = SPDK_COUNTOF(group->xattr_names);
+		group->xattrs[i].names = group->xattr_names;
+		group->xattrs[i].ctx = newlvol;
+		group->xattrs[i].get_value = lvol_get_xattr_value;
+	}
+
+	if (rc != 0) {
+		for (i = 0; i < count; i++) {
+			newlvol = group->members[i].snapshot;
+			if (newlvol != NULL) {
+				TAILQ_REMOVE(&lvs->pending_lvols, newlvol, link);
+				lvol_free(newlvol);
+			}
+		}
+		lvol_snapshot_group_free(group);
+		cb_fn(cb_arg, NULL, 0, rc);
+		return;
+	}
+
+	spdk_bs_create_snapshot_group(lvs->blobstore, group->blobids, count, group->xattrs,
+				      lvol_snapshot_group_cb, group);
+}
+
 void
 spdk_lvol_create_clone(struct spdk_lvol *origlvol, const char *clone_name,
 		       spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg)
@@ -1798,6 +2013,7 @@ spdk_lvs_grow(struct spdk_bs_dev *bs_dev, spdk_lvs_op_with_handle_complete cb_fn
 	req->cb_fn = cb_fn;
 	req->cb_arg = cb_arg;
 	req->bs_dev = bs_dev;
+	req->load_queue_depth = SPDK_LVS_LOAD_QUEUE_DEPTH_DEFAULT;
 
 	lvs_bs_opts_init(&opts);
 	snprintf(opts.bstype.bstype, sizeof(opts.bstype.bstype), "LVOLSTORE");
@@ -1839,7 +2055,7 @@ lvs_esnap_bs_dev_create(void *bs_ctx, void *blob_ctx, struct spdk_blob *blob,
 	/*
 	 * When spdk_lvs_load() is called, it iterates through all blobs in its blobstore building
 	 * up a list of lvols (lvs->lvols). During this initial iteration, each blob is opened,
-	 * passed to load_next_lvol(), then closed. There is no need to open the external snapshot
+	 * passed to load_lvol(), then closed. There is no need to open the external snapshot
 	 * during this phase. Once the blobstore is loaded, lvs->load_esnaps is set to true so that
 	 * future lvol opens cause the external snapshot to be loaded.
 	 */
@@ -2259,10 +2475,10 @@ lvol_shallow_copy_cb(void *cb_arg, int lvolerrno)
 	free(req);
 }
 
-int
-spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
-		       spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
-		       spdk_lvol_op_complete cb_fn, void *cb_arg)
+static int
+lvol_shallow_copy_start(struct spdk_lvol *lvol, struct spdk_lvol *ancestor, struct spdk_bs_dev *ext_dev,
+			spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+			spdk_lvol_op_complete cb_fn, void *cb_arg)
 {
 	struct spdk_lvol_copy_req *req;
 	spdk_blob_id blob_id;
@@ -2300,8 +2516,14 @@ spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
 
 	blob_id = spdk_blob_get_id(lvol->blob);
 
-	rc = spdk_bs_blob_shallow_copy(lvol->lvol_store->blobstore, req->channel, blob_id, ext_dev,
-				       status_cb_fn, status_cb_arg, lvol_shallow_copy_cb, req);
+	if (ancestor != NULL) {
+		rc = spdk_bs_blob_shallow_copy_incremental(lvol->lvol_store->blobstore, req->channel,
+				blob_id, spdk_blob_get_id(ancestor->blob), ext_dev,
+				status_cb_fn, status_cb_arg, lvol_shallow_copy_cb, req);
+	} else {
+		rc = spdk_bs_blob_shallow_copy(lvol->lvol_store->blobstore, req->channel, blob_id, ext_dev,
+					       status_cb_fn, status_cb_arg, lvol_shallow_copy_cb, req);
+	}
 
 	if (rc < 0) {
 		SPDK_ERRLOG("Could not make a shallow copy of lvol %s\n", lvol->unique_id);
@@ -2312,6 +2534,48 @@ spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
 	return rc;
 }
 
+int
+spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
+		       spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+		       spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	return lvol_shallow_copy_start(lvol, NULL, ext_dev, status_cb_fn, status_cb_arg, cb_fn, cb_arg);
+}
+
+int
+spdk_lvol_shallow_copy_incremental(struct spdk_lvol *lvol, struct spdk_lvol *ancestor,
+				   struct spdk_bs_dev *ext_dev,
+				   spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+				   spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	if (ancestor == NULL) {
+		SPDK_ERRLOG("ancestor lvol must not be NULL\n");
+		return -EINVAL;
+	}
+
+	return lvol_shallow_copy_start(lvol, ancestor, ext_dev, status_cb_fn, status_cb_arg, cb_fn, cb_arg);
+}
+
+int
+spdk_lvol_get_changed_clusters(struct spdk_lvol *lvol, struct spdk_lvol *ancestor,
+			       struct spdk_bit_array **changed)
+{
+	if (lvol == NULL || lvol->blob == NULL) {
+		SPDK_ERRLOG("lvol must not be NULL\n");
+		return -EINVAL;
+	}
+
+	if (ancestor != NULL && (ancestor->lvol_store != lvol->lvol_store || ancestor->blob == NULL)) {
+		SPDK_ERRLOG("lvol %s, %s is not a valid ancestor\n", lvol->unique_id,
+			    ancestor->unique_id);
+		return -EINVAL;
+	}
+
+	return spdk_blob_get_changed_clusters(lvol->blob, ancestor != NULL ?
+					      spdk_blob_get_id(ancestor->blob) : SPDK_BLOBID_INVALID,
+					      changed);
+}
+
 static void
 lvol_set_parent_cb(void *cb_arg, int lvolerrno)
 {
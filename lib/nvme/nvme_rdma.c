@@ -119,6 +119,8 @@ struct nvme_rdma_poller_stats {
 	uint64_t idle_polls;
 	uint64_t queued_requests;
 	uint64_t completions;
+	/* Responses received on the SRQ for qpairs that were already destroyed */
+	uint64_t srq_reclaimed_recvs;
 	struct spdk_rdma_provider_qp_stats rdma_stats;
 };
 
@@ -129,12 +131,17 @@ struct nvme_rdma_poller {
 	struct ibv_context		*device;
 	struct ibv_cq			*cq;
 	struct spdk_rdma_provider_srq	*srq;
-	struct nvme_rdma_rsps		*rsps;
+	/* Response buffers shared through the SRQ, allocated in chunks as qpairs are added */
+	STAILQ_HEAD(, nvme_rdma_rsps)	rsps;
 	struct ibv_pd			*pd;
 	struct spdk_rdma_utils_mem_map	*mr_map;
 	uint32_t			refcnt;
 	int				required_num_wc;
 	int				current_num_wc;
+	uint32_t			srq_size;
+	uint32_t			num_rsps;
+	uint32_t			required_num_rsps;
+	uint32_t			current_num_recvs;
 	struct nvme_rdma_poller_stats	stats;
 	struct nvme_rdma_poll_group	*group;
 	STAILQ_ENTRY(nvme_rdma_poller)	link;
@@ -182,6 +189,8 @@ struct nvme_rdma_rsps {
 	uint16_t				current_num_recvs;
 
 	uint16_t				num_entries;
+
+	STAILQ_ENTRY(nvme_rdma_rsps)		link;
 };
 
 /* NVMe RDMA qpair extensions for spdk_nvme_qpair */
@@ -306,6 +315,7 @@ static struct nvme_rdma_poller *nvme_rdma_poll_group_get_poller(struct nvme_rdma
 		struct ibv_context *device);
 static void nvme_rdma_poll_group_put_poller(struct nvme_rdma_poll_group *group,
 		struct nvme_rdma_poller *poller);
+static int nvme_rdma_poller_add_rsps(struct nvme_rdma_poller *poller, uint32_t queue_depth);
 
 static int nvme_rdma_ctrlr_delete_io_qpair(struct spdk_nvme_ctrlr *ctrlr,
 		struct spdk_nvme_qpair *qpair);
@@ -653,13 +663,15 @@ nvme_rdma_qpair_set_poller(struct spdk_nvme_qpair *qpair)
 			nvme_rdma_poll_group_put_poller(group, poller);
 			return -EPROTO;
 		}
+	} else {
+		if (nvme_rdma_poller_add_rsps(poller, rqpair->num_entries)) {
+			nvme_rdma_poll_group_put_poller(group, poller);
+			return -ENOMEM;
+		}
 	}
 
 	rqpair->cq = poller->cq;
 	rqpair->srq = poller->srq;
-	if (rqpair->srq) {
-		rqpair->rsps = poller->rsps;
-	}
 	rqpair->poller = poller;
 	return 0;
 }
@@ -804,12 +816,28 @@ nvme_rdma_poller_submit_recvs(struct nvme_rdma_poller *poller)
 
 	rc = spdk_rdma_provider_srq_flush_recv_wrs(poller->srq, &bad_recv_wr);
 	if (spdk_unlikely(rc)) {
-		nvme_rdma_reset_failed_recvs(poller->rsps, bad_recv_wr, rc);
+		SPDK_ERRLOG("Failed to post WRs on shared receive queue, errno %d (%s), bad_wr %p\n",
+			    rc, spdk_strerror(rc), bad_recv_wr);
+		while (bad_recv_wr != NULL) {
+			assert(poller->current_num_recvs > 0);
+			poller->current_num_recvs--;
+			bad_recv_wr = bad_recv_wr->next;
+		}
 	}
 
 	return rc;
 }
 
+static inline void
+nvme_rdma_poller_recycle_rsp(struct nvme_rdma_poller *poller, struct spdk_nvme_rdma_rsp *rsp)
+{
+	assert(poller->current_num_recvs < poller->num_rsps);
+	poller->current_num_recvs++;
+
+	rsp->recv_wr->next = NULL;
+	spdk_rdma_provider_srq_queue_recv_wrs(poller->srq, rsp->recv_wr);
+}
+
 #define nvme_rdma_trace_ibv_sge(sg_list) \
 	if (sg_list) { \
 		SPDK_DEBUGLOG(nvme, "local addr %p length 0x%x lkey 0x%x\n", \
@@ -884,6 +912,12 @@ nvme_rdma_create_rsps(struct nvme_rdma_rsp_opts *opts)
 		recv_wr->next = NULL;
 		recv_wr->sg_list = rsp_sgl;
 		recv_wr->num_sge = 1;
+	}
+
+	/* Queue the WRs only once all of them are set up, so that nothing is left on the queue
+	 * if the translation of one of the buffers fails. */
+	for (i = 0; i < opts->num_entries; i++) {
+		struct ibv_recv_wr *recv_wr = &rsps->rsp_recv_wrs[i];
 
 		nvme_rdma_trace_ibv_sge(recv_wr->sg_list);
 
@@ -1818,14 +1852,17 @@ nvme_rdma_qpair_destroy(struct nvme_rdma_qpair *rqpair)
 		assert(qpair->poll_group);
 		group = nvme_rdma_poll_group(qpair->poll_group);
 
+		if (rqpair->srq) {
+			/* The response buffers stay with the poller for the qpairs added later */
+			assert(rqpair->poller->required_num_rsps >= rqpair->num_entries);
+			rqpair->poller->required_num_rsps -= rqpair->num_entries;
+			rqpair->srq = NULL;
+		}
+
 		nvme_rdma_poll_group_put_poller(group, rqpair->poller);
 
 		rqpair->poller = NULL;
 		rqpair->cq = NULL;
-		if (rqpair->srq) {
-			rqpair->srq = NULL;
-			rqpair->rsps = NULL;
-		}
 	} else if (rqpair->cq) {
 		ibv_destroy_cq(rqpair->cq);
 		rqpair->cq = NULL;
@@ -1859,7 +1896,7 @@ nvme_rdma_qpair_disconnected(struct nvme_rdma_qpair *rqpair, int ret)
 		goto quiet;
 	}
 
-	if (rqpair->rsps == NULL) {
+	if (!rqpair->srq && rqpair->rsps == NULL) {
 		goto quiet;
 	}
 
@@ -2363,16 +2400,16 @@ nvme_rdma_request_ready(struct nvme_rdma_qpair *rqpair, struct spdk_nvme_rdma_re
 
 	nvme_rdma_req_complete(rdma_req, &rdma_rsp->cpl, true);
 
-	assert(rqpair->rsps->current_num_recvs < rqpair->rsps->num_entries);
-	rqpair->rsps->current_num_recvs++;
-
-	recv_wr->next = NULL;
 	nvme_rdma_trace_ibv_sge(recv_wr->sg_list);
 
 	if (!rqpair->srq) {
+		assert(rqpair->rsps->current_num_recvs < rqpair->rsps->num_entries);
+		rqpair->rsps->current_num_recvs++;
+
+		recv_wr->next = NULL;
 		spdk_rdma_provider_qp_queue_recv_wrs(rqpair->rdma_qp, recv_wr);
 	} else {
-		spdk_rdma_provider_srq_queue_recv_wrs(rqpair->srq, recv_wr);
+		nvme_rdma_poller_recycle_rsp(rqpair->poller, rdma_rsp);
 	}
 }
 
@@ -2442,6 +2479,9 @@ nvme_rdma_process_recv_completion(struct nvme_rdma_poller *poller, struct ibv_wc
 	rdma_rsp = SPDK_CONTAINEROF(rdma_wr, struct spdk_nvme_rdma_rsp, rdma_wr);
 
 	if (poller && poller->srq) {
+		assert(poller->current_num_recvs > 0);
+		poller->current_num_recvs--;
+
 		rqpair = get_rdma_qpair_from_wc(poller->group, wc);
 		if (spdk_unlikely(!rqpair)) {
 			/* Since we do not handle the LAST_WQE_REACHED event, we do not know when
@@ -2451,7 +2491,8 @@ nvme_rdma_process_recv_completion(struct nvme_rdma_poller *poller, struct ibv_wc
 			 * However, for the SRQ, this is not any error. Hence, just re-post the
 			 * receive request to the SRQ to reuse for other QPs, and return 0.
 			 */
-			spdk_rdma_provider_srq_queue_recv_wrs(poller->srq, rdma_rsp->recv_wr);
+			poller->stats.srq_reclaimed_recvs++;
+			nvme_rdma_poller_recycle_rsp(poller, rdma_rsp);
 			return 0;
 		}
 	} else {
@@ -2463,11 +2504,10 @@ nvme_rdma_process_recv_completion(struct nvme_rdma_poller *poller, struct ibv_wc
 			SPDK_WARNLOG("QP might be already destroyed.\n");
 			return 0;
 		}
-	}
-
 
-	assert(rqpair->rsps->current_num_recvs > 0);
-	rqpair->rsps->current_num_recvs--;
+		assert(rqpair->rsps->current_num_recvs > 0);
+		rqpair->rsps->current_num_recvs--;
+	}
 
 	if (wc->status) {
 		nvme_rdma_log_wc_status(rqpair, wc);
@@ -2505,7 +2545,7 @@ nvme_rdma_process_recv_completion(struct nvme_rdma_poller *poller, struct ibv_wc
 err_wc:
 	nvme_rdma_fail_qpair(&rqpair->qpair, 0);
 	if (poller && poller->srq) {
-		spdk_rdma_provider_srq_queue_recv_wrs(poller->srq, rdma_rsp->recv_wr);
+		nvme_rdma_poller_recycle_rsp(poller, rdma_rsp);
 	}
 	return -ENXIO;
 }
@@ -2539,7 +2579,7 @@ nvme_rdma_process_send_completion(struct nvme_rdma_poller *poller,
 		nvme_rdma_log_wc_status(rqpair, wc);
 		nvme_rdma_fail_qpair(&rqpair->qpair, 0);
 		if (rdma_req->rdma_rsp && poller && poller->srq) {
-			spdk_rdma_provider_srq_queue_recv_wrs(poller->srq, rdma_req->rdma_rsp->recv_wr);
+			nvme_rdma_poller_recycle_rsp(poller, rdma_req->rdma_rsp);
 		}
 		return -ENXIO;
 	}
@@ -2811,11 +2851,14 @@ nvme_rdma_admin_qpair_abort_aers(struct spdk_nvme_qpair *qpair)
 static void
 nvme_rdma_poller_destroy(struct nvme_rdma_poller *poller)
 {
+	struct nvme_rdma_rsps *rsps;
+
 	if (poller->cq) {
 		ibv_destroy_cq(poller->cq);
 	}
-	if (poller->rsps) {
-		nvme_rdma_free_rsps(poller->rsps);
+	while ((rsps = STAILQ_FIRST(&poller->rsps)) != NULL) {
+		STAILQ_REMOVE_HEAD(&poller->rsps, link);
+		nvme_rdma_free_rsps(rsps);
 	}
 	if (poller->srq) {
 		spdk_rdma_provider_srq_destroy(poller->srq);
@@ -2835,7 +2878,6 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 	struct nvme_rdma_poller *poller;
 	struct ibv_device_attr dev_attr;
 	struct spdk_rdma_provider_srq_init_attr srq_init_attr = {};
-	struct nvme_rdma_rsp_opts opts;
 	int num_cqe, max_num_cqe;
 	int rc;
 
@@ -2847,6 +2889,7 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 
 	poller->group = group;
 	poller->device = ctx;
+	STAILQ_INIT(&poller->rsps);
 
 	if (g_spdk_nvme_transport_opts.rdma_srq_size != 0) {
 		rc = ibv_query_device(ctx, &dev_attr);
@@ -2868,10 +2911,12 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 			goto fail;
 		}
 
+		poller->srq_size = spdk_min((uint32_t)dev_attr.max_srq_wr,
+					    g_spdk_nvme_transport_opts.rdma_srq_size);
+
 		srq_init_attr.stats = &poller->stats.rdma_stats.recv;
 		srq_init_attr.pd = poller->pd;
-		srq_init_attr.srq_init_attr.attr.max_wr = spdk_min((uint32_t)dev_attr.max_srq_wr,
-				g_spdk_nvme_transport_opts.rdma_srq_size);
+		srq_init_attr.srq_init_attr.attr.max_wr = poller->srq_size;
 		srq_init_attr.srq_init_attr.attr.max_sge = spdk_min(dev_attr.max_sge,
 				NVME_RDMA_DEFAULT_RX_SGE);
 
@@ -2881,24 +2926,10 @@ nvme_rdma_poller_create(struct nvme_rdma_poll_group *group, struct ibv_context *
 			goto fail;
 		}
 
-		opts.num_entries = g_spdk_nvme_transport_opts.rdma_srq_size;
-		opts.rqpair = NULL;
-		opts.srq = poller->srq;
-		opts.mr_map = poller->mr_map;
-
-		poller->rsps = nvme_rdma_create_rsps(&opts);
-		if (poller->rsps == NULL) {
-			SPDK_ERRLOG("Unable to create poller RDMA responses.\n");
-			goto fail;
-		}
-
-		rc = nvme_rdma_poller_submit_recvs(poller);
-		if (rc) {
-			SPDK_ERRLOG("Unable to submit poller RDMA responses.\n");
-			goto fail;
-		}
-
 		/*
+		 * The response buffers are not posted here, but as qpairs are added to the poller,
+		 * see nvme_rdma_poller_add_rsps().
+		 *
 		 * When using an srq, fix the size of the completion queue at startup.
 		 * The initiator sends only send and recv WRs. Hence, the multiplier is 2.
 		 * (The target sends also data WRs. Hence, the multiplier is 3.)
@@ -2931,6 +2962,67 @@ fail:
 	return NULL;
 }
 
+/*
+ * Make sure there are enough response buffers posted to the SRQ of the poller for a qpair with
+ * queue_depth entries to be added.  The number of buffers follows the aggregate queue depth of
+ * the qpairs sharing the SRQ, up to the size of the SRQ, instead of allocating the full SRQ up
+ * front.  Buffers are never freed before the poller, a qpair going away leaves its share for
+ * the ones added later.
+ */
+static int
+nvme_rdma_poller_add_rsps(struct nvme_rdma_poller *poller, uint32_t queue_depth)
+{
+	struct nvme_rdma_rsp_opts opts;
+	struct nvme_rdma_rsps *rsps;
+	struct ibv_recv_wr *bad_recv_wr = NULL;
+	uint32_t num_rsps;
+	int rc;
+
+	assert(poller->srq != NULL);
+
+	num_rsps = spdk_min(poller->required_num_rsps + queue_depth, poller->srq_size);
+	if (poller->num_rsps < num_rsps) {
+		opts.num_entries = spdk_min(num_rsps - poller->num_rsps, UINT16_MAX);
+		opts.rqpair = NULL;
+		opts.srq = poller->srq;
+		opts.mr_map = poller->mr_map;
+
+		rsps = nvme_rdma_create_rsps(&opts);
+		if (rsps == NULL) {
+			if (poller->num_rsps == 0) {
+				SPDK_ERRLOG("Unable to create poller RDMA responses.\n");
+				return -ENOMEM;
+			}
+
+			/* The qpair can still use the buffers already posted to the SRQ */
+			SPDK_WARNLOG("Unable to grow poller RDMA responses from %u to %u.\n",
+				     poller->num_rsps, num_rsps);
+		} else {
+			SPDK_DEBUGLOG(nvme, "Grow poller RDMA responses from %u to %u\n",
+				      poller->num_rsps, poller->num_rsps + opts.num_entries);
+			STAILQ_INSERT_TAIL(&poller->rsps, rsps, link);
+			poller->num_rsps += opts.num_entries;
+			poller->current_num_recvs += opts.num_entries;
+
+			rc = spdk_rdma_provider_srq_flush_recv_wrs(poller->srq, &bad_recv_wr);
+			if (rc) {
+				SPDK_ERRLOG("Unable to submit poller RDMA responses, errno %d (%s).\n",
+					    rc, spdk_strerror(rc));
+				/* The buffers are owned by the poller, put the WRs that weren't posted
+				 * back on the queue so that they go out with the next flush instead of
+				 * being lost to the SRQ. */
+				if (bad_recv_wr != NULL) {
+					spdk_rdma_provider_srq_queue_recv_wrs(poller->srq, bad_recv_wr);
+				}
+				return -EIO;
+			}
+		}
+	}
+
+	poller->required_num_rsps += queue_depth;
+	return 0;
+}
+
 static void
 nvme_rdma_poll_group_free_pollers(struct nvme_rdma_poll_group *group)
 {
@@ -3240,6 +3332,10 @@ nvme_rdma_poll_group_get_stats(struct spdk_nvme_transport_poll_group *tgroup,
 		device_stat->send_doorbell_updates = poller->stats.rdma_stats.send.doorbell_updates;
 		device_stat->total_recv_wrs = poller->stats.rdma_stats.recv.num_submitted_wrs;
 		device_stat->recv_doorbell_updates = poller->stats.rdma_stats.recv.doorbell_updates;
+		device_stat->srq_size = poller->srq_size;
+		device_stat->srq_rsps = poller->num_rsps;
+		device_stat->srq_queue_depth = poller->required_num_rsps;
+		device_stat->srq_reclaimed_recvs = poller->stats.srq_reclaimed_recvs;
 		i++;
 	}
 
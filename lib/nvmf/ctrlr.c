@@ -3371,7 +3371,8 @@ nvmf_qpair_abort_request(struct spdk_nvmf_qpair *qpair, struct spdk_nvmf_request
 {
 	uint16_t cid = req->cmd->nvme_cmd.cdw10_bits.abort.cid;
 
-	if (nvmf_qpair_abort_aer(qpair, cid)) {
+	/* Commands held back by the I/O scheduler haven't reached the bdev yet */
+	if (nvmf_qpair_abort_aer(qpair, cid) || nvmf_io_sched_abort_request(qpair, cid)) {
 		SPDK_DEBUGLOG(nvmf, "abort ctrlr=%p sqid=%u cid=%u successful\n",
 			      qpair->ctrlr, qpair->qid, cid);
 		req->rsp->nvme_cpl.cdw0 &= ~1U; /* Command successfully aborted */
@@ -4542,7 +4543,10 @@ _nvmf_request_complete(void *ctx)
 	struct spdk_nvmf_qpair *qpair;
 	struct spdk_nvmf_subsystem_poll_group *sgroup = NULL;
 	struct spdk_nvmf_subsystem_pg_ns_info *ns_info;
+	struct spdk_nvmf_poll_group *group;
+	struct spdk_nvmf_io_sched_flow *io_sched_flow = NULL;
 	bool is_aer = false;
+	bool io_sched = false;
 	uint32_t nsid;
 	bool paused;
 	uint8_t opcode;
@@ -4554,6 +4558,7 @@ _nvmf_request_complete(void *ctx)
 	opcode = req->cmd->nvmf_cmd.opcode;
 
 	qpair = req->qpair;
+	group = qpair->group;
 	if (spdk_likely(qpair->ctrlr)) {
 		sgroup = &qpair->group->sgroups[qpair->ctrlr->subsys->id];
 		assert(sgroup != NULL);
@@ -4603,6 +4608,16 @@ _nvmf_request_complete(void *ctx)
 		break;
 	}
 
+	/* Release the I/O scheduler slot at the end of the request */
+	if (spdk_unlikely(req->io_sched) &&
+	    (req->zcopy_phase == NVMF_ZCOPY_PHASE_NONE ||
+	     req->zcopy_phase == NVMF_ZCOPY_PHASE_COMPLETE ||
+	     req->zcopy_phase == NVMF_ZCOPY_PHASE_INIT_FAILED)) {
+		req->io_sched = 0;
+		io_sched = true;
+		io_sched_flow = qpair->io_sched_flow;
+	}
+
 	if (spdk_unlikely(nvmf_transport_req_complete(req))) {
 		SPDK_ERRLOG("Transport request completion error!\n");
 	}
@@ -4649,6 +4664,10 @@ _nvmf_request_complete(void *ctx)
 
 	}
 
+	if (spdk_unlikely(io_sched)) {
+		nvmf_io_sched_complete(group, io_sched_flow);
+	}
+
 	nvmf_qpair_request_cleanup(qpair);
 }
 
@@ -4819,6 +4838,29 @@ spdk_nvmf_request_exec(struct spdk_nvmf_request *req)
 		status = nvmf_ctrlr_process_fabrics_cmd(req);
 	} else if (spdk_unlikely(nvmf_qpair_is_admin_queue(qpair))) {
 		status = nvmf_ctrlr_process_admin_cmd(req);
+	} else {
+		if (spdk_unlikely(qpair->group->io_sched != NULL) && !nvmf_io_sched_submit(req)) {
+			/* Executed once it's the controller's turn */
+			return;
+		}
+		status = nvmf_ctrlr_process_io_cmd(req);
+	}
+
+	if (status == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE) {
+		_nvmf_request_complete(req);
+	}
+}
+
+void
+nvmf_ctrlr_exec_scheduled_io(struct spdk_nvmf_request *req)
+{
+	enum spdk_nvmf_request_exec_status status;
+
+	/* The request is already on the qpair's outstanding list */
+	if (spdk_unlikely(!spdk_nvmf_qpair_is_active(req->qpair))) {
+		req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+		req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_ABORTED_SQ_DELETION;
+		status = SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 	} else {
 		status = nvmf_ctrlr_process_io_cmd(req);
 	}
@@ -4828,6 +4870,15 @@ spdk_nvmf_request_exec(struct spdk_nvmf_request *req)
 	}
 }
 
+void
+nvmf_ctrlr_abort_scheduled_io(struct spdk_nvmf_request *req)
+{
+	/* The request is already on the qpair's outstanding list */
+	req->rsp->nvme_cpl.status.sct = SPDK_NVME_SCT_GENERIC;
+	req->rsp->nvme_cpl.status.sc = SPDK_NVME_SC_ABORTED_BY_REQUEST;
+	_nvmf_request_complete(req);
+}
+
 static bool
 nvmf_ctrlr_get_dif_ctx(struct spdk_nvmf_ctrlr *ctrlr, struct spdk_nvme_cmd *cmd,
 		       struct spdk_dif_ctx *dif_ctx)
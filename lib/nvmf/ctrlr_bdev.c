@@ -22,6 +22,9 @@
 
 #include "spdk/log.h"
 
+/* Maximum number of source ranges of a copy command, the descriptors fit into 4KiB */
+#define NVMF_BDEV_CTRLR_MAX_COPY_RANGES 128
+
 static bool
 nvmf_subsystem_bdev_io_type_supported(struct spdk_nvmf_subsystem *subsystem,
 				      enum spdk_bdev_io_type io_type)
@@ -115,6 +118,19 @@ nvmf_bdev_ctrlr_complete_admin_cmd(struct spdk_bdev_io *bdev_io, bool success,
 	nvmf_bdev_ctrlr_complete_cmd(bdev_io, success, req);
 }
 
+static uint16_t
+nvmf_bdev_ctrlr_get_max_copy_range(struct spdk_bdev *bdev)
+{
+	uint32_t max_copy = spdk_bdev_get_max_copy(bdev);
+
+	/* Zero means copy size is unlimited */
+	if (max_copy == 0 || max_copy > UINT16_MAX) {
+		return UINT16_MAX;
+	}
+
+	return max_copy;
+}
+
 void
 nvmf_bdev_ctrlr_identify_ns(struct spdk_nvmf_ns *ns, struct spdk_nvme_ns_data *nsdata,
 			    bool dif_insert_or_strip)
@@ -122,7 +138,6 @@ nvmf_bdev_ctrlr_identify_ns(struct spdk_nvmf_ns *ns, struct spdk_nvme_ns_data *n
 	struct spdk_bdev *bdev = ns->bdev;
 	uint64_t num_blocks;
 	uint32_t phys_blocklen;
-	uint32_t max_copy;
 
 	num_blocks = spdk_bdev_get_num_blocks(bdev);
 
@@ -183,18 +198,10 @@ nvmf_bdev_ctrlr_identify_ns(struct spdk_nvmf_ns *ns, struct spdk_nvme_ns_data *n
 	SPDK_STATIC_ASSERT(sizeof(nsdata->eui64) == sizeof(ns->opts.eui64), "size mismatch");
 	memcpy(&nsdata->eui64, ns->opts.eui64, sizeof(nsdata->eui64));
 
-	/* For now we support just one source range for copy command */
-	nsdata->msrc = 0;
-
-	max_copy = spdk_bdev_get_max_copy(bdev);
-	if (max_copy == 0 || max_copy > UINT16_MAX) {
-		/* Zero means copy size is unlimited */
-		nsdata->mcl = UINT16_MAX;
-		nsdata->mssrl = UINT16_MAX;
-	} else {
-		nsdata->mcl = max_copy;
-		nsdata->mssrl = max_copy;
-	}
+	/* MSRC is 0's based */
+	nsdata->msrc = NVMF_BDEV_CTRLR_MAX_COPY_RANGES - 1;
+	nsdata->mssrl = nvmf_bdev_ctrlr_get_max_copy_range(bdev);
+	nsdata->mcl = nsdata->mssrl * NVMF_BDEV_CTRLR_MAX_COPY_RANGES;
 }
 
 static void
@@ -713,6 +720,119 @@ nvmf_bdev_ctrlr_dsm_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 	return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 }
 
+struct nvmf_bdev_ctrlr_copy {
+	struct spdk_nvmf_request	*req;
+	struct spdk_bdev_desc		*desc;
+	struct spdk_bdev		*bdev;
+	struct spdk_io_channel		*ch;
+	/* Number of outstanding bdev copies, plus one while waiting for a bdev_io */
+	uint32_t			count;
+	uint32_t			range_index;
+	uint32_t			num_ranges;
+	/* Destination of the range at range_index */
+	uint64_t			dst_lba;
+	/* Copy the ranges one after another, a source overlaps the destination */
+	bool				sequential;
+	struct spdk_nvme_scc_source_range ranges[];
+};
+
+static int nvmf_bdev_ctrlr_copy_submit(struct nvmf_bdev_ctrlr_copy *copy_ctx);
+
+static void
+nvmf_bdev_ctrlr_copy_finish(struct nvmf_bdev_ctrlr_copy *copy_ctx)
+{
+	struct spdk_nvmf_request *req = copy_ctx->req;
+
+	/* Submit the next range, or free the context once nothing is outstanding */
+	if (nvmf_bdev_ctrlr_copy_submit(copy_ctx) == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE) {
+		spdk_nvmf_request_complete(req);
+	}
+}
+
+static void
+nvmf_bdev_ctrlr_copy_cpl(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct nvmf_bdev_ctrlr_copy	*copy_ctx = cb_arg;
+	struct spdk_nvme_cpl		*response = &copy_ctx->req->rsp->nvme_cpl;
+	int				sc, sct;
+	uint32_t			cdw0;
+
+	copy_ctx->count--;
+
+	if (response->status.sct == SPDK_NVME_SCT_GENERIC &&
+	    response->status.sc == SPDK_NVME_SC_SUCCESS) {
+		spdk_bdev_io_get_nvme_status(bdev_io, &cdw0, &sct, &sc);
+		response->cdw0 = cdw0;
+		response->status.sc = sc;
+		response->status.sct = sct;
+	}
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		/* Don't copy the remaining ranges */
+		copy_ctx->range_index = copy_ctx->num_ranges;
+	}
+
+	if (copy_ctx->count == 0) {
+		nvmf_bdev_ctrlr_copy_finish(copy_ctx);
+	}
+}
+
+static void
+nvmf_bdev_ctrlr_copy_resubmit(void *arg)
+{
+	struct nvmf_bdev_ctrlr_copy *copy_ctx = arg;
+
+	/* Dequeued */
+	copy_ctx->count--;
+	nvmf_bdev_ctrlr_copy_finish(copy_ctx);
+}
+
+static int
+nvmf_bdev_ctrlr_copy_submit(struct nvmf_bdev_ctrlr_copy *copy_ctx)
+{
+	struct spdk_nvmf_request *req = copy_ctx->req;
+	struct spdk_nvme_cpl *response = &req->rsp->nvme_cpl;
+	struct spdk_nvme_scc_source_range *range;
+	int rc;
+
+	while (copy_ctx->range_index < copy_ctx->num_ranges) {
+		if (copy_ctx->sequential && copy_ctx->count > 0) {
+			break;
+		}
+
+		range = &copy_ctx->ranges[copy_ctx->range_index];
+		rc = spdk_bdev_copy_blocks(copy_ctx->desc, copy_ctx->ch, copy_ctx->dst_lba, range->slba,
+					   range->nlb + 1, nvmf_bdev_ctrlr_copy_cpl, copy_ctx);
+		if (spdk_unlikely(rc)) {
+			if (rc == -ENOMEM) {
+				/* Keep the context alive until the request is dequeued */
+				copy_ctx->count++;
+				nvmf_bdev_ctrl_queue_io(req, copy_ctx->bdev, copy_ctx->ch,
+							nvmf_bdev_ctrlr_copy_resubmit, copy_ctx);
+				return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+			}
+
+			response->status.sct = SPDK_NVME_SCT_GENERIC;
+			response->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+			/* Wait for the copies already submitted to complete */
+			copy_ctx->range_index = copy_ctx->num_ranges;
+			break;
+		}
+
+		copy_ctx->count++;
+		copy_ctx->dst_lba += range->nlb + 1;
+		copy_ctx->range_index++;
+	}
+
+	if (copy_ctx->count == 0) {
+		free(copy_ctx);
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
+	return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+}
+
 int
 nvmf_bdev_ctrlr_copy_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 			 struct spdk_io_channel *ch, struct spdk_nvmf_request *req)
@@ -720,9 +840,13 @@ nvmf_bdev_ctrlr_copy_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 	struct spdk_nvme_cmd *cmd = &req->cmd->nvme_cmd;
 	struct spdk_nvme_cpl *response = &req->rsp->nvme_cpl;
 	uint64_t sdlba = ((uint64_t)cmd->cdw11 << 32) + cmd->cdw10;
-	struct spdk_nvme_scc_source_range range = { 0 };
+	uint64_t bdev_num_blocks = spdk_bdev_get_num_blocks(bdev);
+	uint16_t max_range_blocks = nvmf_bdev_ctrlr_get_max_copy_range(bdev);
+	struct nvmf_bdev_ctrlr_copy *copy_ctx;
+	struct spdk_nvme_scc_source_range *range;
 	struct spdk_iov_xfer ix;
-	int rc;
+	uint32_t num_ranges, i;
+	uint64_t num_blocks = 0;
 
 	SPDK_DEBUGLOG(nvmf, "Copy command: SDLBA %lu, NR %u, desc format %u, PRINFOR %u, "
 		      "DTYPE %u, STCW %u, PRINFOW %u, FUA %u, LR %u\n",
@@ -736,18 +860,14 @@ nvmf_bdev_ctrlr_copy_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 		      cmd->cdw12_bits.copy.fua,
 		      cmd->cdw12_bits.copy.lr);
 
-	if (spdk_unlikely(req->length != (cmd->cdw12_bits.copy.nr + 1) *
-			  sizeof(struct spdk_nvme_scc_source_range))) {
+	num_ranges = cmd->cdw12_bits.copy.nr + 1;
+	if (spdk_unlikely(req->length != num_ranges * sizeof(struct spdk_nvme_scc_source_range))) {
 		response->status.sct = SPDK_NVME_SCT_GENERIC;
 		response->status.sc = SPDK_NVME_SC_DATA_SGL_LENGTH_INVALID;
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 	}
 
-	/*
-	 * We support only one source range, and rely on this with the xfer
-	 * below.
-	 */
-	if (cmd->cdw12_bits.copy.nr > 0) {
+	if (num_ranges > NVMF_BDEV_CTRLR_MAX_COPY_RANGES) {
 		response->status.sct = SPDK_NVME_SCT_COMMAND_SPECIFIC;
 		response->status.sc = SPDK_NVME_SC_CMD_SIZE_LIMIT_SIZE_EXCEEDED;
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
@@ -759,23 +879,64 @@ nvmf_bdev_ctrlr_copy_cmd(struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 	}
 
+	copy_ctx = calloc(1, sizeof(*copy_ctx) + num_ranges * sizeof(*range));
+	if (spdk_unlikely(copy_ctx == NULL)) {
+		response->status.sct = SPDK_NVME_SCT_GENERIC;
+		response->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+	}
+
 	spdk_iov_xfer_init(&ix, req->iov, req->iovcnt);
-	spdk_iov_xfer_to_buf(&ix, &range, sizeof(range));
+	spdk_iov_xfer_to_buf(&ix, copy_ctx->ranges, num_ranges * sizeof(*range));
 
-	rc = spdk_bdev_copy_blocks(desc, ch, sdlba, range.slba, range.nlb + 1,
-				   nvmf_bdev_ctrlr_complete_cmd, req);
-	if (spdk_unlikely(rc)) {
-		if (rc == -ENOMEM) {
-			nvmf_bdev_ctrl_queue_io(req, bdev, ch, nvmf_ctrlr_process_io_cmd_resubmit, req);
-			return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+	for (i = 0; i < num_ranges; i++) {
+		range = &copy_ctx->ranges[i];
+
+		if (spdk_unlikely((uint32_t)range->nlb + 1 > max_range_blocks)) {
+			response->status.sct = SPDK_NVME_SCT_COMMAND_SPECIFIC;
+			response->status.sc = SPDK_NVME_SC_CMD_SIZE_LIMIT_SIZE_EXCEEDED;
+			free(copy_ctx);
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 		}
 
+		if (spdk_unlikely(!nvmf_bdev_ctrlr_lba_in_range(bdev_num_blocks, range->slba,
+				  range->nlb + 1))) {
+			response->status.sct = SPDK_NVME_SCT_GENERIC;
+			response->status.sc = SPDK_NVME_SC_LBA_OUT_OF_RANGE;
+			free(copy_ctx);
+			return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
+		}
+
+		num_blocks += range->nlb + 1;
+	}
+
+	if (spdk_unlikely(!nvmf_bdev_ctrlr_lba_in_range(bdev_num_blocks, sdlba, num_blocks))) {
 		response->status.sct = SPDK_NVME_SCT_GENERIC;
-		response->status.sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+		response->status.sc = SPDK_NVME_SC_LBA_OUT_OF_RANGE;
+		free(copy_ctx);
 		return SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE;
 	}
 
-	return SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS;
+	/* The ranges are copied in parallel, unless one of them is also written by the command */
+	for (i = 0; i < num_ranges; i++) {
+		range = &copy_ctx->ranges[i];
+		if (range->slba < sdlba + num_blocks && sdlba < range->slba + range->nlb + 1) {
+			copy_ctx->sequential = true;
+			break;
+		}
+	}
+
+	copy_ctx->req = req;
+	copy_ctx->desc = desc;
+	copy_ctx->bdev = bdev;
+	copy_ctx->ch = ch;
+	copy_ctx->num_ranges = num_ranges;
+	copy_ctx->dst_lba = sdlba;
+
+	response->status.sct = SPDK_NVME_SCT_GENERIC;
+	response->status.sc = SPDK_NVME_SC_SUCCESS;
+
+	return nvmf_bdev_ctrlr_copy_submit(copy_ctx);
 }
 
 int
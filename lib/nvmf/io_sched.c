@@ -0,0 +1,397 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+/*
+ * Poll group I/O scheduler.  It limits the number of I/O commands a poll group has submitted
+ * at a time and shares the submission slots between the controllers connected to the poll
+ * group using deficit round robin.  Each controller forms a flow, which is given a quantum of
+ * bytes proportional to its host's weight every round, so a host with a high queue depth or
+ * with large I/Os can't starve the other hosts of the poll group.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk/json.h"
+#include "spdk/likely.h"
+#include "spdk/log.h"
+#include "spdk/util.h"
+
+#include "nvmf_internal.h"
+
+/* Bytes a flow of weight 1 is allowed to submit per round */
+#define NVMF_IO_SCHED_QUANTUM	(128 * 1024)
+/* Minimal cost of a command, so that commands without data aren't free */
+#define NVMF_IO_SCHED_MIN_COST	4096
+
+struct spdk_nvmf_io_sched_flow {
+	struct spdk_nvmf_ctrlr				*ctrlr;
+	uint32_t					num_qpairs;
+	uint32_t					weight;
+	uint64_t					quantum;
+	uint64_t					deficit;
+	bool						active;
+
+	/* Commands waiting for their turn, linked through buf_link */
+	STAILQ_HEAD(, spdk_nvmf_request)		queued;
+	uint32_t					num_queued;
+	uint32_t					max_queued;
+	uint32_t					outstanding;
+
+	/* Statistics */
+	uint64_t					dispatched;
+	uint64_t					delayed;
+	uint64_t					wait_ticks;
+	uint64_t					max_wait_ticks;
+
+	TAILQ_ENTRY(spdk_nvmf_io_sched_flow)		active_link;
+	TAILQ_ENTRY(spdk_nvmf_io_sched_flow)		link;
+};
+
+struct spdk_nvmf_io_sched {
+	uint32_t					depth;
+	uint32_t					outstanding;
+	bool						dispatching;
+
+	/* Flows with queued commands, in round robin order */
+	TAILQ_HEAD(, spdk_nvmf_io_sched_flow)		active;
+	TAILQ_HEAD(, spdk_nvmf_io_sched_flow)		flows;
+};
+
+int
+nvmf_io_sched_create(struct spdk_nvmf_poll_group *group, uint32_t depth)
+{
+	struct spdk_nvmf_io_sched *sched;
+
+	assert(depth > 0);
+
+	sched = calloc(1, sizeof(*sched));
+	if (sched == NULL) {
+		return -ENOMEM;
+	}
+
+	sched->depth = depth;
+	TAILQ_INIT(&sched->active);
+	TAILQ_INIT(&sched->flows);
+	group->io_sched = sched;
+
+	return 0;
+}
+
+void
+nvmf_io_sched_destroy(struct spdk_nvmf_poll_group *group)
+{
+	struct spdk_nvmf_io_sched *sched = group->io_sched;
+	struct spdk_nvmf_io_sched_flow *flow, *tmp;
+
+	if (sched == NULL) {
+		return;
+	}
+
+	TAILQ_FOREACH_SAFE(flow, &sched->flows, link, tmp) {
+		assert(STAILQ_EMPTY(&flow->queued));
+		TAILQ_REMOVE(&sched->flows, flow, link);
+		free(flow);
+	}
+
+	free(sched);
+	group->io_sched = NULL;
+}
+
+static struct spdk_nvmf_io_sched_flow *
+nvmf_io_sched_get_flow(struct spdk_nvmf_io_sched *sched, struct spdk_nvmf_qpair *qpair)
+{
+	struct spdk_nvmf_io_sched_flow *flow;
+
+	TAILQ_FOREACH(flow, &sched->flows, link) {
+		if (flow->ctrlr == qpair->ctrlr) {
+			break;
+		}
+	}
+
+	if (flow == NULL) {
+		flow = calloc(1, sizeof(*flow));
+		if (flow == NULL) {
+			return NULL;
+		}
+
+		flow->ctrlr = qpair->ctrlr;
+		flow->weight = nvmf_subsystem_get_host_weight(qpair->ctrlr->subsys,
+				qpair->ctrlr->hostnqn);
+		flow->quantum = (uint64_t)flow->weight * NVMF_IO_SCHED_QUANTUM;
+		STAILQ_INIT(&flow->queued);
+		TAILQ_INSERT_TAIL(&sched->flows, flow, link);
+	}
+
+	flow->num_qpairs++;
+	qpair->io_sched_flow = flow;
+
+	return flow;
+}
+
+void
+nvmf_io_sched_qpair_remove(struct spdk_nvmf_qpair *qpair)
+{
+	struct spdk_nvmf_io_sched_flow *flow = qpair->io_sched_flow;
+
+	if (flow == NULL) {
+		return;
+	}
+
+	qpair->io_sched_flow = NULL;
+
+	assert(flow->num_qpairs > 0);
+	if (--flow->num_qpairs > 0) {
+		return;
+	}
+
+	/* The qpairs only get removed once all of their commands completed */
+	assert(STAILQ_EMPTY(&flow->queued));
+	assert(!flow->active);
+	TAILQ_REMOVE(&qpair->group->io_sched->flows, flow, link);
+	free(flow);
+}
+
+static inline void
+nvmf_io_sched_start(struct spdk_nvmf_io_sched *sched, struct spdk_nvmf_io_sched_flow *flow,
+		    struct spdk_nvmf_request *req)
+{
+	req->io_sched = 1;
+	sched->outstanding++;
+	flow->outstanding++;
+	flow->dispatched++;
+}
+
+static inline uint64_t
+nvmf_io_sched_cost(struct spdk_nvmf_request *req)
+{
+	return spdk_max(req->length, NVMF_IO_SCHED_MIN_COST);
+}
+
+static inline bool
+nvmf_io_sched_is_fused_second(struct spdk_nvmf_request *req, struct spdk_nvmf_request *first)
+{
+	return req != NULL && req->qpair == first->qpair &&
+	       req->cmd->nvme_cmd.fuse == SPDK_NVME_CMD_FUSE_SECOND;
+}
+
+static void
+nvmf_io_sched_dispatch(struct spdk_nvmf_io_sched *sched)
+{
+	struct spdk_nvmf_io_sched_flow *flow;
+	struct spdk_nvmf_request *req, *second;
+	uint64_t cost, wait_ticks;
+
+	/* Commands completing synchronously call back into the scheduler, the loop below picks
+	 * up the freed slots. */
+	if (sched->dispatching) {
+		return;
+	}
+
+	sched->dispatching = true;
+
+	while (sched->outstanding < sched->depth && !TAILQ_EMPTY(&sched->active)) {
+		flow = TAILQ_FIRST(&sched->active);
+		req = STAILQ_FIRST(&flow->queued);
+		cost = nvmf_io_sched_cost(req);
+
+		if (flow->deficit < cost) {
+			/* The flow used up its share of this round, move on to the next one */
+			flow->deficit += flow->quantum;
+			TAILQ_REMOVE(&sched->active, flow, active_link);
+			TAILQ_INSERT_TAIL(&sched->active, flow, active_link);
+			continue;
+		}
+
+		flow->deficit -= cost;
+		STAILQ_REMOVE_HEAD(&flow->queued, buf_link);
+		flow->num_queued--;
+
+		/* The second command of a fused operation goes along with the first one, which
+		 * holds the slot for both of them */
+		second = NULL;
+		if (spdk_unlikely(req->cmd->nvme_cmd.fuse == SPDK_NVME_CMD_FUSE_FIRST) &&
+		    nvmf_io_sched_is_fused_second(STAILQ_FIRST(&flow->queued), req)) {
+			second = STAILQ_FIRST(&flow->queued);
+			STAILQ_REMOVE_HEAD(&flow->queued, buf_link);
+			flow->num_queued--;
+		}
+
+		if (STAILQ_EMPTY(&flow->queued)) {
+			/* An idle flow doesn't keep credit for later rounds */
+			TAILQ_REMOVE(&sched->active, flow, active_link);
+			flow->active = false;
+			flow->deficit = 0;
+		}
+
+		wait_ticks = spdk_get_ticks() - req->sched_tsc;
+		flow->wait_ticks += wait_ticks;
+		flow->max_wait_ticks = spdk_max(flow->max_wait_ticks, wait_ticks);
+
+		nvmf_io_sched_start(sched, flow, req);
+		nvmf_ctrlr_exec_scheduled_io(req);
+		if (spdk_unlikely(second != NULL)) {
+			nvmf_ctrlr_exec_scheduled_io(second);
+		}
+	}
+
+	sched->dispatching = false;
+}
+
+bool
+nvmf_io_sched_submit(struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_qpair *qpair = req->qpair;
+	struct spdk_nvmf_io_sched *sched = qpair->group->io_sched;
+	struct spdk_nvmf_io_sched_flow *flow = qpair->io_sched_flow;
+
+	if (spdk_unlikely(flow == NULL)) {
+		flow = nvmf_io_sched_get_flow(sched, qpair);
+		if (spdk_unlikely(flow == NULL)) {
+			/* Don't fail the I/O, just execute it outside of the scheduler */
+			SPDK_ERRLOG("Failed to allocate I/O scheduler flow\n");
+			return true;
+		}
+	}
+
+	if (spdk_unlikely(req->cmd->nvme_cmd.fuse == SPDK_NVME_CMD_FUSE_SECOND)) {
+		struct spdk_nvmf_request *first = NULL, *tmp;
+
+		/* The second command of a fused operation takes no slot of its own. If the first
+		 * one was already dispatched, it waits for this one while holding its slot. */
+		STAILQ_FOREACH(tmp, &flow->queued, buf_link) {
+			if (tmp->qpair == qpair) {
+				first = tmp;
+			}
+		}
+		if (first == NULL || first->cmd->nvme_cmd.fuse != SPDK_NVME_CMD_FUSE_FIRST) {
+			return true;
+		}
+
+		STAILQ_INSERT_AFTER(&flow->queued, first, req, buf_link);
+		flow->num_queued++;
+		return false;
+	}
+
+	if (spdk_likely(sched->outstanding < sched->depth && TAILQ_EMPTY(&sched->active))) {
+		nvmf_io_sched_start(sched, flow, req);
+		return true;
+	}
+
+	req->sched_tsc = spdk_get_ticks();
+	STAILQ_INSERT_TAIL(&flow->queued, req, buf_link);
+	flow->num_queued++;
+	flow->max_queued = spdk_max(flow->max_queued, flow->num_queued);
+	flow->delayed++;
+
+	if (!flow->active) {
+		flow->active = true;
+		TAILQ_INSERT_TAIL(&sched->active, flow, active_link);
+	}
+
+	return false;
+}
+
+bool
+nvmf_io_sched_abort_request(struct spdk_nvmf_qpair *qpair, uint16_t cid)
+{
+	struct spdk_nvmf_io_sched *sched = qpair->group->io_sched;
+	struct spdk_nvmf_io_sched_flow *flow = qpair->io_sched_flow;
+	struct spdk_nvmf_request *req, *prev = NULL, *second = NULL;
+
+	if (sched == NULL || flow == NULL) {
+		return false;
+	}
+
+	STAILQ_FOREACH(req, &flow->queued, buf_link) {
+		if (req->qpair == qpair && req->cmd->nvme_cmd.cid == cid) {
+			break;
+		}
+		prev = req;
+	}
+
+	if (req == NULL) {
+		/* Not queued, it's up to the transport and the bdev to abort it */
+		return false;
+	}
+
+	/* A fused operation is aborted as a whole. A queued second command always directly
+	 * follows its first one. */
+	if (req->cmd->nvme_cmd.fuse == SPDK_NVME_CMD_FUSE_SECOND) {
+		assert(prev != NULL && prev->cmd->nvme_cmd.fuse == SPDK_NVME_CMD_FUSE_FIRST);
+		second = req;
+		req = prev;
+	} else if (req->cmd->nvme_cmd.fuse == SPDK_NVME_CMD_FUSE_FIRST &&
+		   nvmf_io_sched_is_fused_second(STAILQ_NEXT(req, buf_link), req)) {
+		second = STAILQ_NEXT(req, buf_link);
+	}
+
+	STAILQ_REMOVE(&flow->queued, req, spdk_nvmf_request, buf_link);
+	flow->num_queued--;
+	if (second != NULL) {
+		STAILQ_REMOVE(&flow->queued, second, spdk_nvmf_request, buf_link);
+		flow->num_queued--;
+	}
+
+	assert(flow->active);
+	if (STAILQ_EMPTY(&flow->queued)) {
+		TAILQ_REMOVE(&sched->active, flow, active_link);
+		flow->active = false;
+		flow->deficit = 0;
+	}
+
+	nvmf_ctrlr_abort_scheduled_io(req);
+	if (second != NULL) {
+		nvmf_ctrlr_abort_scheduled_io(second);
+	}
+
+	return true;
+}
+
+void
+nvmf_io_sched_complete(struct spdk_nvmf_poll_group *group, struct spdk_nvmf_io_sched_flow *flow)
+{
+	struct spdk_nvmf_io_sched *sched = group->io_sched;
+
+	assert(sched->outstanding > 0);
+	sched->outstanding--;
+	if (spdk_likely(flow != NULL)) {
+		assert(flow->outstanding > 0);
+		flow->outstanding--;
+	}
+
+	if (!TAILQ_EMPTY(&sched->active)) {
+		nvmf_io_sched_dispatch(sched);
+	}
+}
+
+void
+nvmf_io_sched_dump_stat(struct spdk_nvmf_poll_group *group, struct spdk_json_write_ctx *w)
+{
+	struct spdk_nvmf_io_sched *sched = group->io_sched;
+	struct spdk_nvmf_io_sched_flow *flow;
+
+	spdk_json_write_named_object_begin(w, "io_sched");
+	spdk_json_write_named_uint32(w, "depth", sched->depth);
+	spdk_json_write_named_uint32(w, "outstanding", sched->outstanding);
+
+	spdk_json_write_named_array_begin(w, "hosts");
+	TAILQ_FOREACH(flow, &sched->flows, link) {
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "hostnqn", flow->ctrlr->hostnqn);
+		spdk_json_write_named_string(w, "subnqn", flow->ctrlr->subsys->subnqn);
+		spdk_json_write_named_uint32(w, "cntlid", flow->ctrlr->cntlid);
+		spdk_json_write_named_uint32(w, "weight", flow->weight);
+		spdk_json_write_named_uint32(w, "outstanding", flow->outstanding);
+		spdk_json_write_named_uint32(w, "queued", flow->num_queued);
+		spdk_json_write_named_uint32(w, "max_queued", flow->max_queued);
+		spdk_json_write_named_uint64(w, "dispatched", flow->dispatched);
+		spdk_json_write_named_uint64(w, "delayed", flow->delayed);
+		spdk_json_write_named_uint64(w, "wait_ticks", flow->wait_ticks);
+		spdk_json_write_named_uint64(w, "max_wait_ticks", flow->max_wait_ticks);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+
+	spdk_json_write_object_end(w);
+}
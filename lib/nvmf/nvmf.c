@@ -197,6 +197,8 @@ nvmf_tgt_cleanup_poll_group(struct spdk_nvmf_poll_group *group)
 
 	free(group->sgroups);
 
+	nvmf_io_sched_destroy(group);
+
 	spdk_poller_unregister(&group->poller);
 
 	if (group->destroy_cb_fn) {
@@ -295,6 +297,14 @@ nvmf_tgt_create_poll_group(void *io_device, void *ctx_buf)
 		TAILQ_INIT(&group->sgroups[i].queued);
 	}
 
+	if (tgt->io_sched_depth > 0) {
+		rc = nvmf_io_sched_create(group, tgt->io_sched_depth);
+		if (rc != 0) {
+			nvmf_tgt_cleanup_poll_group(group);
+			return rc;
+		}
+	}
+
 	for (subsystem = spdk_nvmf_subsystem_get_first(tgt);
 	     subsystem != NULL;
 	     subsystem = spdk_nvmf_subsystem_get_next(subsystem)) {
@@ -399,6 +409,7 @@ spdk_nvmf_tgt_create(struct spdk_nvmf_target_opts *_opts)
 	tgt->discovery_genctr = 0;
 	tgt->dhchap_digests = opts.dhchap_digests;
 	tgt->dhchap_dhgroups = opts.dhchap_dhgroups;
+	tgt->io_sched_depth = opts.io_sched_depth;
 	TAILQ_INIT(&tgt->transports);
 	TAILQ_INIT(&tgt->poll_groups);
 	TAILQ_INIT(&tgt->referrals);
@@ -608,6 +619,9 @@ nvmf_write_nvme_subsystem_config(struct spdk_json_write_ctx *w,
 			spdk_json_write_named_string(w, "dhchap_ctrlr_key",
 						     spdk_key_get_name(host->dhchap_ctrlr_key));
 		}
+		if (host->weight > 1) {
+			spdk_json_write_named_uint32(w, "weight", host->weight);
+		}
 		TAILQ_FOREACH(transport, &subsystem->tgt->transports, link) {
 			if (transport->ops->subsystem_dump_host != NULL) {
 				transport->ops->subsystem_dump_host(transport, subsystem, host->nqn, w);
@@ -1323,6 +1337,8 @@ spdk_nvmf_poll_group_remove(struct spdk_nvmf_qpair *qpair)
 		}
 	}
 
+	nvmf_io_sched_qpair_remove(qpair);
+
 	TAILQ_REMOVE(&qpair->group->qpairs, qpair, link);
 	qpair->group = NULL;
 }
@@ -1907,6 +1923,10 @@ spdk_nvmf_poll_group_dump_stat(struct spdk_nvmf_poll_group *group, struct spdk_j
 	spdk_json_write_named_uint64(w, "pending_bdev_io", group->stat.pending_bdev_io);
 	spdk_json_write_named_uint64(w, "completed_nvme_io", group->stat.completed_nvme_io);
 
+	if (group->io_sched != NULL) {
+		nvmf_io_sched_dump_stat(group, w);
+	}
+
 	spdk_json_write_named_array_begin(w, "transports");
 
 	TAILQ_FOREACH(tgroup, &group->tgroups, link) {
@@ -82,6 +82,9 @@ struct spdk_nvmf_tgt {
 	uint32_t				dhchap_digests;
 	uint32_t				dhchap_dhgroups;
 
+	/* Per poll group I/O scheduler depth, 0 if disabled */
+	uint32_t				io_sched_depth;
+
 	TAILQ_ENTRY(spdk_nvmf_tgt)		link;
 };
 
@@ -89,6 +92,7 @@ struct spdk_nvmf_host {
 	char				nqn[SPDK_NVMF_NQN_MAX_LEN + 1];
 	struct spdk_key			*dhchap_key;
 	struct spdk_key			*dhchap_ctrlr_key;
+	uint32_t			weight;
 	TAILQ_ENTRY(spdk_nvmf_host)	link;
 };
 
@@ -383,6 +387,8 @@ void nvmf_get_discovery_log_page(struct spdk_nvmf_tgt *tgt, const char *hostnqn,
 void nvmf_ctrlr_destruct(struct spdk_nvmf_ctrlr *ctrlr);
 int nvmf_ctrlr_process_admin_cmd(struct spdk_nvmf_request *req);
 int nvmf_ctrlr_process_io_cmd(struct spdk_nvmf_request *req);
+void nvmf_ctrlr_exec_scheduled_io(struct spdk_nvmf_request *req);
+void nvmf_ctrlr_abort_scheduled_io(struct spdk_nvmf_request *req);
 bool nvmf_ctrlr_dsm_supported(struct spdk_nvmf_ctrlr *ctrlr);
 bool nvmf_ctrlr_write_zeroes_supported(struct spdk_nvmf_ctrlr *ctrlr);
 bool nvmf_ctrlr_copy_supported(struct spdk_nvmf_ctrlr *ctrlr);
@@ -428,6 +434,7 @@ enum nvmf_auth_key_type {
 };
 struct spdk_key *nvmf_subsystem_get_dhchap_key(struct spdk_nvmf_subsystem *subsys, const char *nqn,
 		enum nvmf_auth_key_type type);
+uint32_t nvmf_subsystem_get_host_weight(struct spdk_nvmf_subsystem *subsystem, const char *hostnqn);
 struct spdk_nvmf_subsystem_listener *nvmf_subsystem_find_listener(
 	struct spdk_nvmf_subsystem *subsystem,
 	const struct spdk_nvme_transport_id *trid);
@@ -527,6 +534,24 @@ void nvmf_qpair_auth_dump(struct spdk_nvmf_qpair *qpair, struct spdk_json_write_
 int nvmf_auth_request_exec(struct spdk_nvmf_request *req);
 bool nvmf_auth_is_supported(void);
 
+int nvmf_io_sched_create(struct spdk_nvmf_poll_group *group, uint32_t depth);
+void nvmf_io_sched_destroy(struct spdk_nvmf_poll_group *group);
+/*
+ * Passes an I/O command to the poll group's I/O scheduler.  Returns true if the command can be
+ * executed right away, false if it was queued to be executed by nvmf_ctrlr_exec_scheduled_io()
+ * once it's the controller's turn.
+ */
+bool nvmf_io_sched_submit(struct spdk_nvmf_request *req);
+void nvmf_io_sched_complete(struct spdk_nvmf_poll_group *group,
+			    struct spdk_nvmf_io_sched_flow *flow);
+void nvmf_io_sched_qpair_remove(struct spdk_nvmf_qpair *qpair);
+/*
+ * Aborts the command with the given cid if it is still waiting for its turn.  Returns true if
+ * it was found and completed through nvmf_ctrlr_abort_scheduled_io().
+ */
+bool nvmf_io_sched_abort_request(struct spdk_nvmf_qpair *qpair, uint16_t cid);
+void nvmf_io_sched_dump_stat(struct spdk_nvmf_poll_group *group, struct spdk_json_write_ctx *w);
+
 static inline bool
 nvmf_request_is_fabric_connect(struct spdk_nvmf_request *req)
 {
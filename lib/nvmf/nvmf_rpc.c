@@ -1892,6 +1892,7 @@ struct nvmf_rpc_host_ctx {
 	char *tgt_name;
 	char *dhchap_key;
 	char *dhchap_ctrlr_key;
+	uint32_t weight;
 	bool allow_any_host;
 };
 
@@ -1901,6 +1902,7 @@ static const struct spdk_json_object_decoder nvmf_rpc_subsystem_host_decoder[] =
 	{"tgt_name", offsetof(struct nvmf_rpc_host_ctx, tgt_name), spdk_json_decode_string, true},
 	{"dhchap_key", offsetof(struct nvmf_rpc_host_ctx, dhchap_key), spdk_json_decode_string, true},
 	{"dhchap_ctrlr_key", offsetof(struct nvmf_rpc_host_ctx, dhchap_ctrlr_key), spdk_json_decode_string, true},
+	{"weight", offsetof(struct nvmf_rpc_host_ctx, weight), spdk_json_decode_uint32, true},
 };
 
 static void
@@ -1968,10 +1970,11 @@ rpc_nvmf_subsystem_add_host(struct spdk_jsonrpc_request *request,
 		}
 	}
 
-	opts.size = SPDK_SIZEOF(&opts, dhchap_ctrlr_key);
+	opts.size = SPDK_SIZEOF(&opts, weight);
 	opts.params = params;
 	opts.dhchap_key = key;
 	opts.dhchap_ctrlr_key = ckey;
+	opts.weight = ctx.weight;
 	rc = spdk_nvmf_subsystem_add_host_ext(subsystem, ctx.host, &opts);
 	if (rc != 0) {
 		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR, "Internal error");
@@ -656,10 +656,10 @@ subsystem_state_change_done(struct spdk_io_channel_iter *i, int status)
 			goto out;
 		}
 		ctx->requested_state = ctx->original_state;
-		spdk_for_each_channel(ctx->subsystem->tgt,
-				      subsystem_state_change_on_pg,
-				      ctx,
-				      subsystem_state_change_revert_done);
+		spdk_for_each_channel_parallel(ctx->subsystem->tgt,
+					       subsystem_state_change_on_pg,
+					       ctx,
+					       subsystem_state_change_revert_done);
 		return;
 	}
 
@@ -741,10 +741,13 @@ nvmf_subsystem_do_state_change(struct nvmf_subsystem_state_change_ctx *ctx)
 		return;
 	}
 
-	spdk_for_each_channel(subsystem->tgt,
-			      subsystem_state_change_on_pg,
-			      ctx,
-			      subsystem_state_change_done);
+	/* The poll groups change their state independently of each other, so do it on all of
+	 * them at once instead of waiting for e.g. the outstanding I/O of one to pause the next.
+	 */
+	spdk_for_each_channel_parallel(subsystem->tgt,
+				       subsystem_state_change_on_pg,
+				       ctx,
+				       subsystem_state_change_done);
 }
 
 
@@ -1037,6 +1040,7 @@ spdk_nvmf_subsystem_add_host_ext(struct spdk_nvmf_subsystem *subsystem,
 	}
 
 	snprintf(host->nqn, sizeof(host->nqn), "%s", hostnqn);
+	host->weight = spdk_max(SPDK_GET_FIELD(opts, weight, 0), 1);
 
 	SPDK_DTRACE_PROBE2(nvmf_subsystem_add_host, subsystem->subnqn, host->nqn);
 
@@ -1284,6 +1288,22 @@ nvmf_subsystem_get_dhchap_key(struct spdk_nvmf_subsystem *subsystem, const char
 	return key;
 }
 
+uint32_t
+nvmf_subsystem_get_host_weight(struct spdk_nvmf_subsystem *subsystem, const char *hostnqn)
+{
+	struct spdk_nvmf_host *host;
+	uint32_t weight = 1;
+
+	pthread_mutex_lock(&subsystem->mutex);
+	host = nvmf_subsystem_find_host(subsystem, hostnqn);
+	if (host != NULL) {
+		weight = host->weight;
+	}
+	pthread_mutex_unlock(&subsystem->mutex);
+
+	return weight;
+}
+
 struct spdk_nvmf_host *
 spdk_nvmf_subsystem_get_first_host(struct spdk_nvmf_subsystem *subsystem)
 {
@@ -31,6 +31,9 @@
 #define SPDK_NVMF_TCP_DEFAULT_SOCK_PRIORITY 0
 #define SPDK_NVMF_TCP_DEFAULT_CONTROL_MSG_NUM 32
 #define SPDK_NVMF_TCP_DEFAULT_SUCCESS_OPTIMIZATION true
+#define SPDK_NVMF_TCP_DEFAULT_PROVIDED_BUF_COUNT 0
+#define SPDK_NVMF_TCP_DEFAULT_PROVIDED_BUF_SIZE 262144
+#define SPDK_NVMF_TCP_MIN_PROVIDED_BUF_SIZE 4096
 
 #define SPDK_NVMF_TCP_MIN_IO_QUEUE_DEPTH 2
 #define SPDK_NVMF_TCP_MAX_IO_QUEUE_DEPTH 65535
@@ -239,6 +242,10 @@ struct spdk_nvmf_tcp_req  {
 	bool					has_in_capsule_data;
 	bool					fused_failed;
 
+	/* Set when the data of the request was received directly into a buffer provided
+	 * to the sock group, instead of being copied into buf or the iobuf buffers. */
+	struct spdk_nvmf_tcp_provided_buf	*provided_buf;
+
 	/* transfer_tag */
 	uint16_t				ttag;
 
@@ -254,6 +261,14 @@ struct spdk_nvmf_tcp_req  {
 	STAILQ_ENTRY(spdk_nvmf_tcp_req)		control_msg_link;
 };
 
+struct spdk_nvmf_tcp_provided_buf {
+	void					*buf;
+	/* One reference is held by the qpair receiving into the buffer and one by each
+	 * request whose data is in the buffer. */
+	uint32_t				ref;
+	struct spdk_nvmf_tcp_poll_group		*group;
+};
+
 struct spdk_nvmf_tcp_qpair {
 	struct spdk_nvmf_qpair			qpair;
 	struct spdk_nvmf_tcp_poll_group		*group;
@@ -282,6 +297,15 @@ struct spdk_nvmf_tcp_qpair {
 	bool					host_hdgst_enable;
 	bool					host_ddgst_enable;
 
+	/* The qpair receives through spdk_sock_recv_next() into the buffers provided by
+	 * its poll group. recv_data and recv_len describe the part of recv_buf that
+	 * hasn't been consumed yet. */
+	bool					recv_next;
+	bool					recv_pending;
+	struct spdk_nvmf_tcp_provided_buf	*recv_buf;
+	uint8_t					*recv_data;
+	uint32_t				recv_len;
+
 	/* This is a spare PDU used for sending special management
 	 * operations. Primarily, this is used for the initial
 	 * connection response and c2h termination request. */
@@ -317,6 +341,7 @@ struct spdk_nvmf_tcp_qpair {
 	void					*fini_cb_arg;
 
 	TAILQ_ENTRY(spdk_nvmf_tcp_qpair)	link;
+	TAILQ_ENTRY(spdk_nvmf_tcp_qpair)	recv_link;
 };
 
 struct spdk_nvmf_tcp_control_msg {
@@ -335,10 +360,17 @@ struct spdk_nvmf_tcp_poll_group {
 
 	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	qpairs;
 	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	await_req;
+	/* Qpairs with received data left in their recv_buf */
+	TAILQ_HEAD(, spdk_nvmf_tcp_qpair)	recv_pending;
 
 	struct spdk_io_channel			*accel_channel;
 	struct spdk_nvmf_tcp_control_msg_list	*control_msg_list;
 
+	/* Receive buffers provided to sock_group */
+	void					*provided_bufs_mem;
+	struct spdk_nvmf_tcp_provided_buf	*provided_bufs;
+	uint32_t				provided_buf_size;
+
 	TAILQ_ENTRY(spdk_nvmf_tcp_poll_group)	link;
 };
 
@@ -353,6 +385,8 @@ struct tcp_transport_opts {
 	bool		c2h_success;
 	uint16_t	control_msg_num;
 	uint32_t	sock_priority;
+	uint32_t	provided_buf_count;
+	uint32_t	provided_buf_size;
 };
 
 struct tcp_psk_entry {
@@ -398,11 +432,20 @@ static const struct spdk_json_object_decoder tcp_transport_opts_decoder[] = {
 		"sock_priority", offsetof(struct tcp_transport_opts, sock_priority),
 		spdk_json_decode_uint32, true
 	},
+	{
+		"provided_buf_count", offsetof(struct tcp_transport_opts, provided_buf_count),
+		spdk_json_decode_uint32, true
+	},
+	{
+		"provided_buf_size", offsetof(struct tcp_transport_opts, provided_buf_size),
+		spdk_json_decode_uint32, true
+	},
 };
 
 static bool nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 				 struct spdk_nvmf_tcp_req *tcp_req);
 static void nvmf_tcp_poll_group_destroy(struct spdk_nvmf_transport_poll_group *group);
+static void nvmf_tcp_provided_buf_put(struct spdk_nvmf_tcp_provided_buf *pbuf);
 
 static void _nvmf_tcp_send_c2h_data(struct spdk_nvmf_tcp_qpair *tqpair,
 				    struct spdk_nvmf_tcp_req *tcp_req);
@@ -606,6 +649,11 @@ _nvmf_tcp_qpair_destroy(void *_tqpair)
 	assert(err == 0);
 	nvmf_tcp_cleanup_all_states(tqpair);
 
+	if (tqpair->recv_buf != NULL) {
+		nvmf_tcp_provided_buf_put(tqpair->recv_buf);
+		tqpair->recv_buf = NULL;
+	}
+
 	if (tqpair->state_cntr[TCP_REQUEST_STATE_FREE] != tqpair->resource_count) {
 		SPDK_ERRLOG("tqpair(%p) free tcp request num is %u but should be %u\n", tqpair,
 			    tqpair->state_cntr[TCP_REQUEST_STATE_FREE],
@@ -653,6 +701,8 @@ nvmf_tcp_dump_opts(struct spdk_nvmf_transport *transport, struct spdk_json_write
 	ttransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_tcp_transport, transport);
 	spdk_json_write_named_bool(w, "c2h_success", ttransport->tcp_opts.c2h_success);
 	spdk_json_write_named_uint32(w, "sock_priority", ttransport->tcp_opts.sock_priority);
+	spdk_json_write_named_uint32(w, "provided_buf_count", ttransport->tcp_opts.provided_buf_count);
+	spdk_json_write_named_uint32(w, "provided_buf_size", ttransport->tcp_opts.provided_buf_size);
 }
 
 static void
@@ -717,6 +767,8 @@ nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 	ttransport->tcp_opts.c2h_success = SPDK_NVMF_TCP_DEFAULT_SUCCESS_OPTIMIZATION;
 	ttransport->tcp_opts.sock_priority = SPDK_NVMF_TCP_DEFAULT_SOCK_PRIORITY;
 	ttransport->tcp_opts.control_msg_num = SPDK_NVMF_TCP_DEFAULT_CONTROL_MSG_NUM;
+	ttransport->tcp_opts.provided_buf_count = SPDK_NVMF_TCP_DEFAULT_PROVIDED_BUF_COUNT;
+	ttransport->tcp_opts.provided_buf_size = SPDK_NVMF_TCP_DEFAULT_PROVIDED_BUF_SIZE;
 	if (opts->transport_specific != NULL &&
 	    spdk_json_decode_object_relaxed(opts->transport_specific, tcp_transport_opts_decoder,
 					    SPDK_COUNTOF(tcp_transport_opts_decoder),
@@ -735,7 +787,7 @@ nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		     "  num_shared_buffers=%d, c2h_success=%d,\n"
 		     "  dif_insert_or_strip=%d, sock_priority=%d\n"
 		     "  abort_timeout_sec=%d, control_msg_num=%hu\n"
-		     "  ack_timeout=%d\n",
+		     "  ack_timeout=%d, provided_buf_count=%d, provided_buf_size=%d\n",
 		     opts->max_queue_depth,
 		     opts->max_io_size,
 		     opts->max_qpairs_per_ctrlr - 1,
@@ -748,7 +800,9 @@ nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		     ttransport->tcp_opts.sock_priority,
 		     opts->abort_timeout_sec,
 		     ttransport->tcp_opts.control_msg_num,
-		     opts->ack_timeout);
+		     opts->ack_timeout,
+		     ttransport->tcp_opts.provided_buf_count,
+		     ttransport->tcp_opts.provided_buf_size);
 
 	if (ttransport->tcp_opts.sock_priority > SPDK_NVMF_TCP_DEFAULT_MAX_SOCK_PRIORITY) {
 		SPDK_ERRLOG("Unsupported socket_priority=%d, the current range is: 0 to %d\n"
@@ -758,6 +812,14 @@ nvmf_tcp_create(struct spdk_nvmf_transport_opts *opts)
 		return NULL;
 	}
 
+	if (ttransport->tcp_opts.provided_buf_count > 0 &&
+	    ttransport->tcp_opts.provided_buf_size < SPDK_NVMF_TCP_MIN_PROVIDED_BUF_SIZE) {
+		SPDK_ERRLOG("TCP param provided_buf_size %u can't be smaller than %u\n",
+			    ttransport->tcp_opts.provided_buf_size, SPDK_NVMF_TCP_MIN_PROVIDED_BUF_SIZE);
+		free(ttransport);
+		return NULL;
+	}
+
 	if (ttransport->tcp_opts.control_msg_num == 0 &&
 	    opts->in_capsule_data_size < SPDK_NVME_TCP_IN_CAPSULE_DATA_MAX_SIZE) {
 		SPDK_WARNLOG("TCP param control_msg_num can't be 0 if ICD is less than %u bytes. Using default value %u\n",
@@ -1569,6 +1631,52 @@ nvmf_tcp_control_msg_list_free(struct spdk_nvmf_tcp_control_msg_list *list)
 	free(list);
 }
 
+static void
+nvmf_tcp_provided_buf_put(struct spdk_nvmf_tcp_provided_buf *pbuf)
+{
+	struct spdk_nvmf_tcp_poll_group *tgroup = pbuf->group;
+
+	assert(pbuf->ref > 0);
+	if (--pbuf->ref > 0) {
+		return;
+	}
+
+	spdk_sock_group_provide_buf(tgroup->sock_group, pbuf->buf, tgroup->provided_buf_size, pbuf);
+}
+
+static int
+nvmf_tcp_provided_bufs_create(struct spdk_nvmf_tcp_poll_group *tgroup, uint32_t count,
+			      uint32_t size)
+{
+	struct spdk_nvmf_tcp_provided_buf *pbuf;
+	uint32_t i;
+
+	/* The buffers are handed to the bdevs as the data of write requests, so they have to
+	 * come from DMA-able memory, just like the iobuf buffers. */
+	tgroup->provided_bufs_mem = spdk_zmalloc((size_t)count * size, NVMF_DATA_BUFFER_ALIGNMENT,
+				    NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
+	if (!tgroup->provided_bufs_mem) {
+		SPDK_ERRLOG("Unable to allocate %u receive buffers of %u bytes\n", count, size);
+		return -ENOMEM;
+	}
+
+	tgroup->provided_bufs = calloc(count, sizeof(*tgroup->provided_bufs));
+	if (!tgroup->provided_bufs) {
+		return -ENOMEM;
+	}
+
+	tgroup->provided_buf_size = size;
+	for (i = 0; i < count; i++) {
+		pbuf = &tgroup->provided_bufs[i];
+		pbuf->buf = (uint8_t *)tgroup->provided_bufs_mem + (size_t)i * size;
+		pbuf->group = tgroup;
+		pbuf->ref = 1;
+		nvmf_tcp_provided_buf_put(pbuf);
+	}
+
+	return 0;
+}
+
 static struct spdk_nvmf_transport_poll_group *
 nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 			   struct spdk_nvmf_poll_group *group)
@@ -1593,6 +1701,7 @@ nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 
 	TAILQ_INIT(&tgroup->qpairs);
 	TAILQ_INIT(&tgroup->await_req);
+	TAILQ_INIT(&tgroup->recv_pending);
 
 	ttransport = SPDK_CONTAINEROF(transport, struct spdk_nvmf_tcp_transport, transport);
 
@@ -1606,6 +1715,12 @@ nvmf_tcp_poll_group_create(struct spdk_nvmf_transport *transport,
 		}
 	}
 
+	if (ttransport->tcp_opts.provided_buf_count > 0 &&
+	    nvmf_tcp_provided_bufs_create(tgroup, ttransport->tcp_opts.provided_buf_count,
+					  ttransport->tcp_opts.provided_buf_size) != 0) {
+		goto cleanup;
+	}
+
 	tgroup->accel_channel = spdk_accel_get_io_channel();
 	if (spdk_unlikely(!tgroup->accel_channel)) {
 		SPDK_ERRLOG("Cannot create accel_channel for tgroup=%p\n", tgroup);
@@ -1673,6 +1788,9 @@ nvmf_tcp_poll_group_destroy(struct spdk_nvmf_transport_poll_group *group)
 		nvmf_tcp_control_msg_list_free(tgroup->control_msg_list);
 	}
 
+	free(tgroup->provided_bufs);
+	spdk_free(tgroup->provided_bufs_mem);
+
 	if (tgroup->accel_channel) {
 		spdk_put_io_channel(tgroup->accel_channel);
 	}
@@ -2246,8 +2364,18 @@ nvmf_tcp_icreq_handle(struct spdk_nvmf_tcp_transport *ttransport,
 	}
 
 	tqpair->recv_buf_size = spdk_max(tqpair->recv_buf_size, MIN_SOCK_PIPE_SIZE);
+	if (tqpair->group != NULL && tqpair->group->provided_bufs != NULL) {
+		/* The host waits for the ICResp before sending anything else, so the receive pipe
+		 * is empty and can be dropped in favor of the group's provided buffers. */
+		if (spdk_sock_set_recvbuf(tqpair->sock, 0) == 0) {
+			tqpair->recv_next = true;
+		} else {
+			SPDK_WARNLOG("Unable to disable the receive buffer on tqpair=%p, "
+				     "not using the provided buffers\n", tqpair);
+		}
+	}
 	/* Now that we know whether digests are enabled, properly size the receive buffer */
-	if (spdk_sock_set_recvbuf(tqpair->sock, tqpair->recv_buf_size) < 0) {
+	if (!tqpair->recv_next && spdk_sock_set_recvbuf(tqpair->sock, tqpair->recv_buf_size) < 0) {
 		SPDK_WARNLOG("Unable to allocate enough memory for receive buffer on tqpair=%p with size=%d\n",
 			     tqpair,
 			     tqpair->recv_buf_size);
@@ -2425,7 +2553,176 @@ err:
 }
 
 static int
-nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
+nvmf_tcp_recv_next(struct spdk_nvmf_tcp_qpair *tqpair)
+{
+	void *buf, *ctx;
+	int rc;
+
+	if (tqpair->recv_buf != NULL) {
+		nvmf_tcp_provided_buf_put(tqpair->recv_buf);
+		tqpair->recv_buf = NULL;
+		tqpair->recv_data = NULL;
+		tqpair->recv_len = 0;
+	}
+
+	rc = spdk_sock_recv_next(tqpair->sock, &buf, &ctx);
+	if (rc > 0) {
+		tqpair->recv_buf = ctx;
+		tqpair->recv_buf->ref++;
+		tqpair->recv_data = buf;
+		tqpair->recv_len = rc;
+		return rc;
+	}
+
+	if (rc < 0) {
+		/* If the group ran out of buffers, the socket will be reported again once the
+		 * completed requests have returned theirs */
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+			return 0;
+		}
+
+		/* For connect reset issue, do not output error log */
+		if (errno != ECONNRESET) {
+			SPDK_ERRLOG("spdk_sock_recv_next() failed, errno %d: %s\n",
+				    errno, spdk_strerror(errno));
+		}
+	}
+
+	/* connection closed */
+	return NVME_TCP_CONNECTION_FATAL;
+}
+
+/* Copy the received data out of the provided buffers, returns the same values as
+ * nvme_tcp_readv_data(). */
+static int
+nvmf_tcp_recv_next_readv(struct spdk_nvmf_tcp_qpair *tqpair, struct iovec *iov, int iovcnt)
+{
+	uint32_t offset, len;
+	int i, rc, total = 0;
+
+	for (i = 0; i < iovcnt; i++) {
+		offset = 0;
+		while (offset < iov[i].iov_len) {
+			if (tqpair->recv_len == 0) {
+				rc = nvmf_tcp_recv_next(tqpair);
+				if (rc <= 0) {
+					return total > 0 ? total : rc;
+				}
+			}
+
+			len = spdk_min(tqpair->recv_len, iov[i].iov_len - offset);
+			memcpy((uint8_t *)iov[i].iov_base + offset, tqpair->recv_data, len);
+			tqpair->recv_data += len;
+			tqpair->recv_len -= len;
+			offset += len;
+			total += len;
+		}
+	}
+
+	return total;
+}
+
+static int
+nvmf_tcp_read_data(struct spdk_nvmf_tcp_qpair *tqpair, int bytes, void *buf)
+{
+	struct iovec iov = { .iov_base = buf, .iov_len = bytes };
+
+	if (tqpair->recv_next) {
+		return nvmf_tcp_recv_next_readv(tqpair, &iov, 1);
+	}
+
+	return nvme_tcp_read_data(tqpair->sock, bytes, buf);
+}
+
+static int
+nvmf_tcp_read_payload_data(struct spdk_nvmf_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu)
+{
+	struct iovec iov[NVME_TCP_MAX_SGL_DESCRIPTORS + 1];
+	int iovcnt;
+
+	if (!tqpair->recv_next) {
+		return nvme_tcp_read_payload_data(tqpair->sock, pdu);
+	}
+
+	iovcnt = nvme_tcp_build_payload_iovs(iov, NVME_TCP_MAX_SGL_DESCRIPTORS + 1, pdu,
+					     pdu->ddgst_enable, NULL);
+	assert(iovcnt >= 0);
+
+	return nvmf_tcp_recv_next_readv(tqpair, iov, iovcnt);
+}
+
+/*
+ * If the whole payload of a write PDU is already in the current receive buffer, hand that
+ * part of the buffer to the request instead of copying it.  This is done for in-capsule
+ * data and for H2C data transferred in a single PDU, which is what the hosts send for
+ * writes up to maxh2cdata.  Payloads split across receive buffers or needing DIF
+ * insertion are copied as before.  Returns the number of bytes consumed, 0 if the payload
+ * needs to be copied, or a negative value if the connection failed.
+ */
+static int
+nvmf_tcp_recv_next_payload_zcopy(struct spdk_nvmf_tcp_qpair *tqpair, struct nvme_tcp_pdu *pdu,
+				 uint32_t data_len)
+{
+	struct spdk_nvmf_tcp_req *tcp_req = pdu->req;
+	struct spdk_nvmf_request *req;
+	int rc;
+
+	if (tcp_req == NULL || pdu->dif_ctx != NULL || pdu->rw_offset != 0) {
+		return 0;
+	}
+
+	req = &tcp_req->req;
+	switch (pdu->hdr.common.pdu_type) {
+	case SPDK_NVME_TCP_PDU_TYPE_CAPSULE_CMD:
+		/* Leave the data received into the control message buffers alone */
+		if (req->iovcnt != 1 || req->iov[0].iov_base != tcp_req->buf) {
+			return 0;
+		}
+		break;
+	case SPDK_NVME_TCP_PDU_TYPE_H2C_DATA:
+		if (!req->data_from_pool || pdu->data_len != req->length) {
+			return 0;
+		}
+		break;
+	default:
+		return 0;
+	}
+
+	if (tqpair->recv_len == 0) {
+		/* The header ended with the previous buffer, the payload starts the next one */
+		rc = nvmf_tcp_recv_next(tqpair);
+		if (rc <= 0) {
+			return rc;
+		}
+	}
+
+	if (tqpair->recv_len < data_len) {
+		return 0;
+	}
+
+	if (req->data_from_pool) {
+		spdk_nvmf_request_free_buffers(req, &tqpair->group->group, tqpair->qpair.transport);
+	}
+
+	req->iov[0].iov_base = tqpair->recv_data;
+	req->iov[0].iov_len = pdu->data_len;
+	req->iovcnt = 1;
+	tcp_req->provided_buf = tqpair->recv_buf;
+	tcp_req->provided_buf->ref++;
+
+	_nvme_tcp_pdu_set_data(pdu, tqpair->recv_data, pdu->data_len);
+	if (pdu->ddgst_enable) {
+		memcpy(pdu->data_digest, tqpair->recv_data + pdu->data_len, SPDK_NVME_TCP_DIGEST_LEN);
+	}
+
+	tqpair->recv_data += data_len;
+	tqpair->recv_len -= data_len;
+
+	return data_len;
+}
+
+static int
+_nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
 {
 	int rc = 0;
 	struct nvme_tcp_pdu *pdu;
@@ -2465,7 +2762,7 @@ nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
 				return rc;
 			}
 
-			rc = nvme_tcp_read_data(tqpair->sock,
+			rc = nvmf_tcp_read_data(tqpair,
 						sizeof(struct spdk_nvme_tcp_common_pdu_hdr) - pdu->ch_valid_bytes,
 						(void *)&pdu->hdr.common + pdu->ch_valid_bytes);
 			if (rc < 0) {
@@ -2486,7 +2783,7 @@ nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
 			break;
 		/* Wait for the pdu specific header  */
 		case NVME_TCP_PDU_RECV_STATE_AWAIT_PDU_PSH:
-			rc = nvme_tcp_read_data(tqpair->sock,
+			rc = nvmf_tcp_read_data(tqpair,
 						pdu->psh_len - pdu->psh_valid_bytes,
 						(void *)&pdu->hdr.raw + sizeof(struct spdk_nvme_tcp_common_pdu_hdr) + pdu->psh_valid_bytes);
 			if (rc < 0) {
@@ -2525,7 +2822,13 @@ nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
 				pdu->ddgst_enable = true;
 			}
 
-			rc = nvme_tcp_read_payload_data(tqpair->sock, pdu);
+			rc = 0;
+			if (tqpair->recv_next) {
+				rc = nvmf_tcp_recv_next_payload_zcopy(tqpair, pdu, data_len);
+			}
+			if (rc == 0) {
+				rc = nvmf_tcp_read_payload_data(tqpair, pdu);
+			}
 			if (rc < 0) {
 				nvmf_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
 				break;
@@ -2569,6 +2872,25 @@ nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
 	return rc;
 }
 
+static int
+nvmf_tcp_sock_process(struct spdk_nvmf_tcp_qpair *tqpair)
+{
+	int rc;
+
+	rc = _nvmf_tcp_sock_process(tqpair);
+
+	/* Unlike the data in the sock's receive pipe, the data left in a provided buffer won't
+	 * trigger another sock event, so the poll group has to come back to this qpair. */
+	if (tqpair->recv_len > 0 && !tqpair->recv_pending && rc >= 0 &&
+	    tqpair->recv_state != NVME_TCP_PDU_RECV_STATE_QUIESCING &&
+	    tqpair->recv_state != NVME_TCP_PDU_RECV_STATE_ERROR) {
+		TAILQ_INSERT_TAIL(&tqpair->group->recv_pending, tqpair, recv_link);
+		tqpair->recv_pending = true;
+	}
+
+	return rc;
+}
+
 static inline void *
 nvmf_tcp_control_msg_get(struct spdk_nvmf_tcp_control_msg_list *list,
 			 struct spdk_nvmf_tcp_req *tcp_req)
@@ -3271,7 +3593,10 @@ nvmf_tcp_req_process(struct spdk_nvmf_tcp_transport *ttransport,
 				break;
 			}
 
-			if (tcp_req->req.data_from_pool) {
+			if (tcp_req->provided_buf != NULL) {
+				nvmf_tcp_provided_buf_put(tcp_req->provided_buf);
+				tcp_req->provided_buf = NULL;
+			} else if (tcp_req->req.data_from_pool) {
 				spdk_nvmf_request_free_buffers(&tcp_req->req, group, transport);
 			} else if (spdk_unlikely(tcp_req->has_in_capsule_data &&
 						 (tcp_req->cmd.opc == SPDK_NVME_OPC_FABRIC ||
@@ -3403,6 +3728,10 @@ nvmf_tcp_poll_group_remove(struct spdk_nvmf_transport_poll_group *group,
 		nvmf_tcp_qpair_set_recv_state(tqpair, NVME_TCP_PDU_RECV_STATE_QUIESCING);
 	}
 	TAILQ_REMOVE(&tgroup->qpairs, tqpair, link);
+	if (tqpair->recv_pending) {
+		TAILQ_REMOVE(&tgroup->recv_pending, tqpair, recv_link);
+		tqpair->recv_pending = false;
+	}
 
 	/* Try to force out any pending writes */
 	spdk_sock_flush(tqpair->sock);
@@ -3472,10 +3801,12 @@ nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 	struct spdk_nvmf_tcp_poll_group *tgroup;
 	int num_events, rc = 0, rc2;
 	struct spdk_nvmf_tcp_qpair *tqpair, *tqpair_tmp;
+	TAILQ_HEAD(, spdk_nvmf_tcp_qpair) recv_pending;
 
 	tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
 
-	if (spdk_unlikely(TAILQ_EMPTY(&tgroup->qpairs) && TAILQ_EMPTY(&tgroup->await_req))) {
+	if (spdk_unlikely(TAILQ_EMPTY(&tgroup->qpairs) && TAILQ_EMPTY(&tgroup->await_req) &&
+			  TAILQ_EMPTY(&tgroup->recv_pending))) {
 		return 0;
 	}
 
@@ -3496,6 +3827,23 @@ nvmf_tcp_poll_group_poll(struct spdk_nvmf_transport_poll_group *group)
 		}
 	}
 
+	if (!TAILQ_EMPTY(&tgroup->recv_pending)) {
+		TAILQ_INIT(&recv_pending);
+		TAILQ_SWAP(&tgroup->recv_pending, &recv_pending, spdk_nvmf_tcp_qpair, recv_link);
+		while ((tqpair = TAILQ_FIRST(&recv_pending)) != NULL) {
+			TAILQ_REMOVE(&recv_pending, tqpair, recv_link);
+			tqpair->recv_pending = false;
+
+			rc2 = nvmf_tcp_sock_process(tqpair);
+			if (spdk_unlikely(rc2 < 0)) {
+				nvmf_tcp_qpair_disconnect(tqpair);
+				if (rc == 0) {
+					rc = rc2;
+				}
+			}
+		}
+	}
+
 	return rc == 0 ? num_events : rc;
 }
 
@@ -3903,6 +4251,27 @@ nvmf_tcp_subsystem_dump_host(struct spdk_nvmf_transport *transport,
 	}
 }
 
+static void
+nvmf_tcp_poll_group_dump_stat(struct spdk_nvmf_transport_poll_group *group,
+			      struct spdk_json_write_ctx *w)
+{
+	struct spdk_nvmf_tcp_poll_group *tgroup;
+	struct spdk_sock_group_stat stat;
+
+	assert(w != NULL);
+
+	tgroup = SPDK_CONTAINEROF(group, struct spdk_nvmf_tcp_poll_group, group);
+
+	/* Each PDU is written with its own asynchronous write request, the sock layer
+	 * coalesces the requests queued on a socket into as few sendmsg calls as it can. */
+	if (spdk_sock_group_get_stat(tgroup->sock_group, &stat) != 0) {
+		return;
+	}
+
+	spdk_json_write_named_uint64(w, "pdus_sent", stat.sent_requests);
+	spdk_json_write_named_uint64(w, "sendmsg_calls", stat.sendmsg_calls);
+}
+
 static void
 nvmf_tcp_opts_init(struct spdk_nvmf_transport_opts *opts)
 {
@@ -3951,6 +4320,8 @@ const struct spdk_nvmf_transport_ops spdk_nvmf_transport_tcp = {
 	.subsystem_add_host = nvmf_tcp_subsystem_add_host,
 	.subsystem_remove_host = nvmf_tcp_subsystem_remove_host,
 	.subsystem_dump_host = nvmf_tcp_subsystem_dump_host,
+
+	.poll_group_dump_stat = nvmf_tcp_poll_group_dump_stat,
 };
 
 SPDK_NVMF_TRANSPORT_REGISTER(tcp, &spdk_nvmf_transport_tcp);
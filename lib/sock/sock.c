@@ -801,6 +801,25 @@ spdk_sock_group_poll_count(struct spdk_sock_group *group, int max_events)
 	return num_events;
 }
 
+int
+spdk_sock_group_get_stat(struct spdk_sock_group *group, struct spdk_sock_group_stat *stat)
+{
+	struct spdk_sock_group_impl *group_impl;
+
+	if (group == NULL || stat == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	memset(stat, 0, sizeof(*stat));
+	STAILQ_FOREACH(group_impl, &group->group_impls, link) {
+		stat->sendmsg_calls += group_impl->stat.sendmsg_calls;
+		stat->sent_requests += group_impl->stat.sent_requests;
+	}
+
+	return 0;
+}
+
 int
 spdk_sock_group_close(struct spdk_sock_group **group)
 {
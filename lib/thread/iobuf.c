@@ -33,6 +33,8 @@ struct iobuf_channel {
 	spdk_iobuf_entry_stailq_t	small_queue;
 	spdk_iobuf_entry_stailq_t	large_queue;
 	struct spdk_iobuf_channel	*channels[IOBUF_MAX_CHANNELS];
+	/* NUMA node whose pools the channels of this thread take buffers from */
+	uint32_t			numa_id;
 };
 
 struct iobuf_module {
@@ -40,11 +42,21 @@ struct iobuf_module {
 	TAILQ_ENTRY(iobuf_module)	tailq;
 };
 
-struct iobuf {
+struct iobuf_node {
 	struct spdk_ring		*small_pool;
 	struct spdk_ring		*large_pool;
 	void				*small_pool_base;
 	void				*large_pool_base;
+};
+
+struct iobuf {
+	/* Indexed by NUMA node ID. Without enable_numa, there is only node 0 and its
+	 * buffers are allocated on any node.
+	 */
+	struct iobuf_node		node[SPDK_IOBUF_MAX_NUMA_NODES];
+	/* Bit mask of the NUMA nodes with pools */
+	uint32_t			numa_mask;
+	uint32_t			num_nodes;
 	struct spdk_iobuf_opts		opts;
 	TAILQ_HEAD(, iobuf_module)	modules;
 	spdk_iobuf_finish_cb		finish_cb;
@@ -53,10 +65,6 @@ struct iobuf {
 
 static struct iobuf g_iobuf = {
 	.modules = TAILQ_HEAD_INITIALIZER(g_iobuf.modules),
-	.small_pool = NULL,
-	.large_pool = NULL,
-	.small_pool_base = NULL,
-	.large_pool_base = NULL,
 	.opts = {
 		.small_pool_count = IOBUF_DEFAULT_SMALL_POOL_SIZE,
 		.large_pool_count = IOBUF_DEFAULT_LARGE_POOL_SIZE,
@@ -65,13 +73,34 @@ static struct iobuf g_iobuf = {
 	},
 };
 
+SPDK_STATIC_ASSERT(SPDK_IOBUF_MAX_NUMA_NODES <= 32, "NUMA node mask too small");
+
 struct iobuf_get_stats_ctx {
 	struct spdk_iobuf_module_stats	*modules;
 	uint32_t			num_modules;
+	struct spdk_iobuf_node_stats	*nodes;
 	spdk_iobuf_get_stats_cb		cb_fn;
 	void				*cb_arg;
 };
 
+/* NUMA node of the calling core if it has pools, the first node with pools otherwise. */
+static uint32_t
+iobuf_get_local_numa_id(void)
+{
+	uint32_t core, numa_id;
+
+	core = spdk_env_get_current_core();
+	if (core != SPDK_ENV_LCORE_ID_ANY) {
+		numa_id = spdk_env_get_socket_id(core);
+		if (numa_id < SPDK_IOBUF_MAX_NUMA_NODES && (g_iobuf.numa_mask & (1U << numa_id))) {
+			return numa_id;
+		}
+	}
+
+	assert(g_iobuf.numa_mask != 0);
+	return __builtin_ctz(g_iobuf.numa_mask);
+}
+
 static int
 iobuf_channel_create_cb(void *io_device, void *ctx)
 {
@@ -79,6 +108,7 @@ iobuf_channel_create_cb(void *io_device, void *ctx)
 
 	STAILQ_INIT(&ch->small_queue);
 	STAILQ_INIT(&ch->large_queue);
+	ch->numa_id = iobuf_get_local_numa_id();
 
 	return 0;
 }
@@ -92,58 +122,123 @@ iobuf_channel_destroy_cb(void *io_device, void *ctx)
 	assert(STAILQ_EMPTY(&ch->large_queue));
 }
 
-int
-spdk_iobuf_initialize(void)
+static void
+iobuf_node_free(struct iobuf_node *node)
+{
+	spdk_free(node->small_pool_base);
+	node->small_pool_base = NULL;
+	spdk_ring_free(node->small_pool);
+	node->small_pool = NULL;
+
+	spdk_free(node->large_pool_base);
+	node->large_pool_base = NULL;
+	spdk_ring_free(node->large_pool);
+	node->large_pool = NULL;
+}
+
+static int
+iobuf_node_init(uint32_t numa_id, int socket_id)
 {
 	struct spdk_iobuf_opts *opts = &g_iobuf.opts;
-	int rc = 0;
-	uint64_t i;
+	struct iobuf_node *node = &g_iobuf.node[numa_id];
 	struct spdk_iobuf_buffer *buf;
+	uint64_t i;
 
-	g_iobuf.small_pool = spdk_ring_create(SPDK_RING_TYPE_MP_MC, opts->small_pool_count,
-					      SPDK_ENV_SOCKET_ID_ANY);
-	if (!g_iobuf.small_pool) {
+	node->small_pool = spdk_ring_create(SPDK_RING_TYPE_MP_MC, opts->small_pool_count, socket_id);
+	if (!node->small_pool) {
 		SPDK_ERRLOG("Failed to create small iobuf pool\n");
-		rc = -ENOMEM;
 		goto error;
 	}
 
-	/* Round up to the nearest alignment so that each element remains aligned */
-	opts->small_bufsize = SPDK_ALIGN_CEIL(opts->small_bufsize, IOBUF_ALIGNMENT);
-	g_iobuf.small_pool_base = spdk_malloc(opts->small_bufsize * opts->small_pool_count, IOBUF_ALIGNMENT,
-					      NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (g_iobuf.small_pool_base == NULL) {
+	node->small_pool_base = spdk_malloc(opts->small_bufsize * opts->small_pool_count, IOBUF_ALIGNMENT,
+					    NULL, socket_id, SPDK_MALLOC_DMA);
+	if (node->small_pool_base == NULL) {
 		SPDK_ERRLOG("Unable to allocate requested small iobuf pool size\n");
-		rc = -ENOMEM;
 		goto error;
 	}
 
-	g_iobuf.large_pool = spdk_ring_create(SPDK_RING_TYPE_MP_MC, opts->large_pool_count,
-					      SPDK_ENV_SOCKET_ID_ANY);
-	if (!g_iobuf.large_pool) {
+	node->large_pool = spdk_ring_create(SPDK_RING_TYPE_MP_MC, opts->large_pool_count, socket_id);
+	if (!node->large_pool) {
 		SPDK_ERRLOG("Failed to create large iobuf pool\n");
-		rc = -ENOMEM;
 		goto error;
 	}
 
-	/* Round up to the nearest alignment so that each element remains aligned */
-	opts->large_bufsize = SPDK_ALIGN_CEIL(opts->large_bufsize, IOBUF_ALIGNMENT);
-	g_iobuf.large_pool_base = spdk_malloc(opts->large_bufsize * opts->large_pool_count, IOBUF_ALIGNMENT,
-					      NULL, SPDK_ENV_SOCKET_ID_ANY, SPDK_MALLOC_DMA);
-	if (g_iobuf.large_pool_base == NULL) {
+	node->large_pool_base = spdk_malloc(opts->large_bufsize * opts->large_pool_count, IOBUF_ALIGNMENT,
+					    NULL, socket_id, SPDK_MALLOC_DMA);
+	if (node->large_pool_base == NULL) {
 		SPDK_ERRLOG("Unable to allocate requested large iobuf pool size\n");
-		rc = -ENOMEM;
 		goto error;
 	}
 
 	for (i = 0; i < opts->small_pool_count; i++) {
-		buf = g_iobuf.small_pool_base + i * opts->small_bufsize;
-		spdk_ring_enqueue(g_iobuf.small_pool, (void **)&buf, 1, NULL);
+		buf = node->small_pool_base + i * opts->small_bufsize;
+		spdk_ring_enqueue(node->small_pool, (void **)&buf, 1, NULL);
 	}
 
 	for (i = 0; i < opts->large_pool_count; i++) {
-		buf = g_iobuf.large_pool_base + i * opts->large_bufsize;
-		spdk_ring_enqueue(g_iobuf.large_pool, (void **)&buf, 1, NULL);
+		buf = node->large_pool_base + i * opts->large_bufsize;
+		spdk_ring_enqueue(node->large_pool, (void **)&buf, 1, NULL);
+	}
+
+	g_iobuf.numa_mask |= 1U << numa_id;
+	g_iobuf.num_nodes++;
+
+	return 0;
+error:
+	iobuf_node_free(node);
+
+	return -ENOMEM;
+}
+
+static void
+iobuf_free_nodes(void)
+{
+	uint32_t numa_id;
+
+	for (numa_id = 0; numa_id < SPDK_IOBUF_MAX_NUMA_NODES; numa_id++) {
+		iobuf_node_free(&g_iobuf.node[numa_id]);
+	}
+
+	g_iobuf.numa_mask = 0;
+	g_iobuf.num_nodes = 0;
+}
+
+int
+spdk_iobuf_initialize(void)
+{
+	struct spdk_iobuf_opts *opts = &g_iobuf.opts;
+	uint32_t core, numa_id, numa_mask = 0;
+	int rc = 0;
+
+	/* Round up to the nearest alignment so that each element remains aligned */
+	opts->small_bufsize = SPDK_ALIGN_CEIL(opts->small_bufsize, IOBUF_ALIGNMENT);
+	opts->large_bufsize = SPDK_ALIGN_CEIL(opts->large_bufsize, IOBUF_ALIGNMENT);
+
+	if (opts->enable_numa) {
+		SPDK_ENV_FOREACH_CORE(core) {
+			numa_id = spdk_env_get_socket_id(core);
+			if (numa_id < SPDK_IOBUF_MAX_NUMA_NODES) {
+				numa_mask |= 1U << numa_id;
+			} else if (numa_id != (uint32_t)SPDK_ENV_SOCKET_ID_ANY) {
+				SPDK_WARNLOG("No iobuf pools for NUMA node %" PRIu32 " of core %" PRIu32 "\n",
+					     numa_id, core);
+			}
+		}
+	}
+
+	if (numa_mask == 0) {
+		rc = iobuf_node_init(0, SPDK_ENV_SOCKET_ID_ANY);
+	} else {
+		for (numa_id = 0; numa_id < SPDK_IOBUF_MAX_NUMA_NODES && rc == 0; numa_id++) {
+			if (numa_mask & (1U << numa_id)) {
+				rc = iobuf_node_init(numa_id, numa_id);
+			}
+		}
+	}
+
+	if (rc != 0) {
+		iobuf_free_nodes();
+		return rc;
 	}
 
 	spdk_io_device_register(&g_iobuf, iobuf_channel_create_cb, iobuf_channel_destroy_cb,
@@ -151,19 +246,14 @@ spdk_iobuf_initialize(void)
 	g_iobuf_is_initialized = true;
 
 	return 0;
-error:
-	spdk_free(g_iobuf.small_pool_base);
-	spdk_ring_free(g_iobuf.small_pool);
-	spdk_free(g_iobuf.large_pool_base);
-	spdk_ring_free(g_iobuf.large_pool);
-
-	return rc;
 }
 
 static void
 iobuf_unregister_cb(void *io_device)
 {
 	struct iobuf_module *module;
+	struct iobuf_node *node;
+	uint32_t numa_id;
 
 	while (!TAILQ_EMPTY(&g_iobuf.modules)) {
 		module = TAILQ_FIRST(&g_iobuf.modules);
@@ -172,25 +262,24 @@ iobuf_unregister_cb(void *io_device)
 		free(module);
 	}
 
-	if (spdk_ring_count(g_iobuf.small_pool) != g_iobuf.opts.small_pool_count) {
-		SPDK_ERRLOG("small iobuf pool count is %zu, expected %"PRIu64"\n",
-			    spdk_ring_count(g_iobuf.small_pool), g_iobuf.opts.small_pool_count);
-	}
+	for (numa_id = 0; numa_id < SPDK_IOBUF_MAX_NUMA_NODES; numa_id++) {
+		node = &g_iobuf.node[numa_id];
+		if (!(g_iobuf.numa_mask & (1U << numa_id))) {
+			continue;
+		}
 
-	if (spdk_ring_count(g_iobuf.large_pool) != g_iobuf.opts.large_pool_count) {
-		SPDK_ERRLOG("large iobuf pool count is %zu, expected %"PRIu64"\n",
-			    spdk_ring_count(g_iobuf.large_pool), g_iobuf.opts.large_pool_count);
-	}
+		if (spdk_ring_count(node->small_pool) != g_iobuf.opts.small_pool_count) {
+			SPDK_ERRLOG("small iobuf pool count on NUMA node %" PRIu32 " is %zu, expected %"PRIu64"\n",
+				    numa_id, spdk_ring_count(node->small_pool), g_iobuf.opts.small_pool_count);
+		}
 
-	spdk_free(g_iobuf.small_pool_base);
-	g_iobuf.small_pool_base = NULL;
-	spdk_ring_free(g_iobuf.small_pool);
-	g_iobuf.small_pool = NULL;
+		if (spdk_ring_count(node->large_pool) != g_iobuf.opts.large_pool_count) {
+			SPDK_ERRLOG("large iobuf pool count on NUMA node %" PRIu32 " is %zu, expected %"PRIu64"\n",
+				    numa_id, spdk_ring_count(node->large_pool), g_iobuf.opts.large_pool_count);
+		}
+	}
 
-	spdk_free(g_iobuf.large_pool_base);
-	g_iobuf.large_pool_base = NULL;
-	spdk_ring_free(g_iobuf.large_pool);
-	g_iobuf.large_pool = NULL;
+	iobuf_free_nodes();
 
 	if (g_iobuf.finish_cb != NULL) {
 		g_iobuf.finish_cb(g_iobuf.finish_arg);
@@ -257,6 +346,7 @@ spdk_iobuf_set_opts(const struct spdk_iobuf_opts *opts)
 	SET_FIELD(large_pool_count);
 	SET_FIELD(small_bufsize);
 	SET_FIELD(large_bufsize);
+	SET_FIELD(enable_numa);
 
 	g_iobuf.opts.opts_size = opts->opts_size;
 
@@ -289,12 +379,13 @@ spdk_iobuf_get_opts(struct spdk_iobuf_opts *opts, size_t opts_size)
 	SET_FIELD(large_pool_count);
 	SET_FIELD(small_bufsize);
 	SET_FIELD(large_bufsize);
+	SET_FIELD(enable_numa);
 
 #undef SET_FIELD
 
 	/* Do not remove this statement, you should always update this statement when you adding a new field,
 	 * and do not forget to add the SET_FIELD statement for your added field. */
-	SPDK_STATIC_ASSERT(sizeof(struct spdk_iobuf_opts) == 32, "Incorrect size");
+	SPDK_STATIC_ASSERT(sizeof(struct spdk_iobuf_opts) == 40, "Incorrect size");
 }
 
 
@@ -341,8 +432,8 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 
 	ch->small.queue = &iobuf_ch->small_queue;
 	ch->large.queue = &iobuf_ch->large_queue;
-	ch->small.pool = g_iobuf.small_pool;
-	ch->large.pool = g_iobuf.large_pool;
+	ch->small.pool = g_iobuf.node[iobuf_ch->numa_id].small_pool;
+	ch->large.pool = g_iobuf.node[iobuf_ch->numa_id].large_pool;
 	ch->small.bufsize = g_iobuf.opts.small_bufsize;
 	ch->large.bufsize = g_iobuf.opts.large_bufsize;
 	ch->parent = ioch;
@@ -356,7 +447,7 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 	STAILQ_INIT(&ch->large.cache);
 
 	for (i = 0; i < small_cache_size; ++i) {
-		if (spdk_ring_dequeue(g_iobuf.small_pool, (void **)&buf, 1) == 0) {
+		if (spdk_ring_dequeue(ch->small.pool, (void **)&buf, 1) == 0) {
 			SPDK_ERRLOG("Failed to populate '%s' iobuf small buffer cache at %d/%d entries. "
 				    "You may need to increase spdk_iobuf_opts.small_pool_count (%"PRIu64")\n",
 				    name, i, small_cache_size, g_iobuf.opts.small_pool_count);
@@ -368,7 +459,7 @@ spdk_iobuf_channel_init(struct spdk_iobuf_channel *ch, const char *name,
 		ch->small.cache_count++;
 	}
 	for (i = 0; i < large_cache_size; ++i) {
-		if (spdk_ring_dequeue(g_iobuf.large_pool, (void **)&buf, 1) == 0) {
+		if (spdk_ring_dequeue(ch->large.pool, (void **)&buf, 1) == 0) {
 			SPDK_ERRLOG("Failed to populate '%s' iobuf large buffer cache at %d/%d entries. "
 				    "You may need to increase spdk_iobuf_opts.large_pool_count (%"PRIu64")\n",
 				    name, i, large_cache_size, g_iobuf.opts.large_pool_count);
@@ -407,13 +498,13 @@ spdk_iobuf_channel_fini(struct spdk_iobuf_channel *ch)
 	while (!STAILQ_EMPTY(&ch->small.cache)) {
 		buf = STAILQ_FIRST(&ch->small.cache);
 		STAILQ_REMOVE_HEAD(&ch->small.cache, stailq);
-		spdk_ring_enqueue(g_iobuf.small_pool, (void **)&buf, 1, NULL);
+		spdk_ring_enqueue(ch->small.pool, (void **)&buf, 1, NULL);
 		ch->small.cache_count--;
 	}
 	while (!STAILQ_EMPTY(&ch->large.cache)) {
 		buf = STAILQ_FIRST(&ch->large.cache);
 		STAILQ_REMOVE_HEAD(&ch->large.cache, stailq);
-		spdk_ring_enqueue(g_iobuf.large_pool, (void **)&buf, 1, NULL);
+		spdk_ring_enqueue(ch->large.pool, (void **)&buf, 1, NULL);
 		ch->large.cache_count--;
 	}
 
@@ -516,6 +607,63 @@ spdk_iobuf_entry_abort(struct spdk_iobuf_channel *ch, struct spdk_iobuf_entry *e
 
 #define IOBUF_BATCH_SIZE 32
 
+/* Take a single buffer from the pools of the other NUMA nodes once the local pool is empty. */
+static void *
+iobuf_get_remote(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool *pool)
+{
+	struct iobuf_node *node;
+	struct spdk_ring *ring;
+	uint32_t numa_id;
+	void *buf;
+
+	for (numa_id = 0; numa_id < SPDK_IOBUF_MAX_NUMA_NODES; numa_id++) {
+		if (!(g_iobuf.numa_mask & (1U << numa_id))) {
+			continue;
+		}
+
+		node = &g_iobuf.node[numa_id];
+		ring = pool == &ch->small ? node->small_pool : node->large_pool;
+		if (ring != pool->pool && spdk_ring_dequeue(ring, &buf, 1) == 1) {
+			return buf;
+		}
+	}
+
+	return NULL;
+}
+
+/* Return the pool a buffer belongs to, found by the address ranges of the nodes. */
+static struct spdk_ring *
+iobuf_get_owner_pool(struct spdk_iobuf_channel *ch, struct spdk_iobuf_pool *pool, void *buf)
+{
+	struct spdk_iobuf_opts *opts = &g_iobuf.opts;
+	struct iobuf_node *node;
+	uint64_t size;
+	uint32_t numa_id;
+	char *base;
+
+	for (numa_id = 0; numa_id < SPDK_IOBUF_MAX_NUMA_NODES; numa_id++) {
+		if (!(g_iobuf.numa_mask & (1U << numa_id))) {
+			continue;
+		}
+
+		node = &g_iobuf.node[numa_id];
+		if (pool == &ch->small) {
+			base = node->small_pool_base;
+			size = opts->small_bufsize * opts->small_pool_count;
+		} else {
+			base = node->large_pool_base;
+			size = opts->large_bufsize * opts->large_pool_count;
+		}
+
+		if ((char *)buf >= base && (char *)buf < base + size) {
+			return pool == &ch->small ? node->small_pool : node->large_pool;
+		}
+	}
+
+	assert(false);
+	return pool->pool;
+}
+
 void *
 spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len,
 	       struct spdk_iobuf_entry *entry, spdk_iobuf_get_cb cb_fn)
@@ -544,6 +692,14 @@ spdk_iobuf_get(struct spdk_iobuf_channel *ch, uint64_t len,
 		/* If we're going to dequeue, we may as well dequeue a batch. */
 		sz = spdk_ring_dequeue(pool->pool, (void **)bufs, spdk_min(IOBUF_BATCH_SIZE,
 				       spdk_max(pool->cache_size, 1)));
+		if (sz == 0 && spdk_unlikely(g_iobuf.num_nodes > 1)) {
+			buf = iobuf_get_remote(ch, pool);
+			if (buf != NULL) {
+				pool->stats.remote++;
+				return buf;
+			}
+		}
+
 		if (sz == 0) {
 			if (entry) {
 				STAILQ_INSERT_TAIL(pool->queue, entry, stailq);
@@ -574,6 +730,7 @@ spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len)
 	struct spdk_iobuf_entry *entry;
 	struct spdk_iobuf_buffer *iobuf_buf;
 	struct spdk_iobuf_pool *pool;
+	struct spdk_ring *owner;
 	size_t sz;
 
 	assert(spdk_io_channel_get_thread(ch->parent) == spdk_get_thread());
@@ -584,6 +741,15 @@ spdk_iobuf_put(struct spdk_iobuf_channel *ch, void *buf, uint64_t len)
 	}
 
 	if (STAILQ_EMPTY(pool->queue)) {
+		if (spdk_unlikely(g_iobuf.num_nodes > 1)) {
+			/* Buffers of other nodes go straight back, the cache only holds local ones */
+			owner = iobuf_get_owner_pool(ch, pool, buf);
+			if (owner != pool->pool) {
+				spdk_ring_enqueue(owner, (void **)&buf, 1, NULL);
+				return;
+			}
+		}
+
 		if (pool->cache_size == 0) {
 			spdk_ring_enqueue(pool->pool, (void **)&buf, 1, NULL);
 			return;
@@ -628,6 +794,7 @@ iobuf_get_channel_stats_done(struct spdk_io_channel_iter *iter, int status)
 	struct iobuf_get_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(iter);
 
 	ctx->cb_fn(ctx->modules, ctx->num_modules, ctx->cb_arg);
+	free(ctx->nodes);
 	free(ctx->modules);
 	free(ctx);
 }
@@ -641,7 +808,8 @@ iobuf_get_channel_stats(struct spdk_io_channel_iter *iter)
 	struct spdk_iobuf_channel *channel;
 	struct iobuf_module *module;
 	struct spdk_iobuf_module_stats *it;
-	uint32_t i, j;
+	struct spdk_iobuf_node_stats *node;
+	uint32_t i, j, k;
 
 	for (i = 0; i < ctx->num_modules; ++i) {
 		for (j = 0; j < IOBUF_MAX_CHANNELS; ++j) {
@@ -659,6 +827,25 @@ iobuf_get_channel_stats(struct spdk_io_channel_iter *iter)
 				it->large_pool.cache += channel->large.stats.cache;
 				it->large_pool.main += channel->large.stats.main;
 				it->large_pool.retry += channel->large.stats.retry;
+				it->small_pool.remote += channel->small.stats.remote;
+				it->large_pool.remote += channel->large.stats.remote;
+
+				for (k = 0; k < it->num_nodes; k++) {
+					node = &it->nodes[k];
+					if (node->numa_id != iobuf_ch->numa_id) {
+						continue;
+					}
+
+					node->small_pool.cache += channel->small.stats.cache;
+					node->small_pool.main += channel->small.stats.main;
+					node->small_pool.retry += channel->small.stats.retry;
+					node->small_pool.remote += channel->small.stats.remote;
+					node->large_pool.cache += channel->large.stats.cache;
+					node->large_pool.main += channel->large.stats.main;
+					node->large_pool.retry += channel->large.stats.retry;
+					node->large_pool.remote += channel->large.stats.remote;
+					break;
+				}
 				break;
 			}
 		}
@@ -672,7 +859,7 @@ spdk_iobuf_get_stats(spdk_iobuf_get_stats_cb cb_fn, void *cb_arg)
 {
 	struct iobuf_module *module;
 	struct iobuf_get_stats_ctx *ctx;
-	uint32_t i;
+	uint32_t i, j, numa_id, num_nodes;
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx == NULL) {
@@ -689,9 +876,30 @@ spdk_iobuf_get_stats(spdk_iobuf_get_stats_cb cb_fn, void *cb_arg)
 		return -ENOMEM;
 	}
 
+	num_nodes = g_iobuf.opts.enable_numa ? g_iobuf.num_nodes : 0;
+	if (num_nodes > 0 && ctx->num_modules > 0) {
+		ctx->nodes = calloc(ctx->num_modules * num_nodes, sizeof(struct spdk_iobuf_node_stats));
+		if (ctx->nodes == NULL) {
+			free(ctx->modules);
+			free(ctx);
+			return -ENOMEM;
+		}
+	}
+
 	i = 0;
 	TAILQ_FOREACH(module, &g_iobuf.modules, tailq) {
 		ctx->modules[i].module = module->name;
+		if (ctx->nodes != NULL) {
+			ctx->modules[i].nodes = &ctx->nodes[i * num_nodes];
+			ctx->modules[i].num_nodes = num_nodes;
+
+			j = 0;
+			for (numa_id = 0; numa_id < SPDK_IOBUF_MAX_NUMA_NODES; numa_id++) {
+				if (g_iobuf.numa_mask & (1U << numa_id)) {
+					ctx->modules[i].nodes[j++].numa_id = numa_id;
+				}
+			}
+		}
 		++i;
 	}
 
@@ -32,6 +32,8 @@
 #endif
 
 #define SPDK_MSG_BATCH_SIZE		8
+/* Total number of entries of the message rings of a thread */
+#define SPDK_MSG_RING_SIZE		65536
 #define SPDK_MAX_DEVICE_NAME_LEN	256
 #define SPDK_THREAD_EXIT_TIMEOUT_SEC	5
 #define SPDK_MAX_POLLER_NAME_LEN	256
@@ -71,6 +73,8 @@ enum spdk_poller_state {
 struct spdk_poller {
 	TAILQ_ENTRY(spdk_poller)	tailq;
 	RB_ENTRY(spdk_poller)		node;
+	/* Slot of the thread's timer wheel the poller is on, if the thread uses one */
+	uint32_t			wheel_slot;
 
 	/* Current state of the poller; should only be accessed from the poller's thread. */
 	enum spdk_poller_state		state;
@@ -118,13 +122,19 @@ struct spdk_thread {
 	 */
 	RB_HEAD(timed_pollers_tree, spdk_poller)	timed_pollers;
 	struct spdk_poller				*first_timed_poller;
+	/* Replaces the timed_pollers tree if set */
+	struct timer_wheel				*timer_wheel;
 	/*
 	 * Contains paused pollers.  Pollers on this queue are waiting until
 	 * they are resumed (in which case they're put onto the active/timer
 	 * queues) or unregistered.
 	 */
 	TAILQ_HEAD(paused_pollers_head, spdk_poller)	paused_pollers;
-	struct spdk_ring		*messages;
+	/* Senders are spread over the rings by their thread ID */
+	struct spdk_ring		*messages[SPDK_THREAD_MAX_MSG_RINGS];
+	uint32_t			num_msg_rings;
+	/* Ring the next batch of messages is taken from first */
+	uint32_t			next_msg_ring;
 	int				msg_fd;
 	SLIST_HEAD(, spdk_msg)		msg_cache;
 	size_t				msg_cache_count;
@@ -162,6 +172,8 @@ static spdk_new_thread_fn g_new_thread_fn = NULL;
 static spdk_thread_op_fn g_thread_op_fn = NULL;
 static spdk_thread_op_supported_fn g_thread_op_supported_fn;
 static size_t g_ctx_sz = 0;
+static uint32_t g_num_msg_rings = 1;
+static bool g_timer_wheel = false;
 /* Monotonic increasing ID is set to each created thread beginning at 1. Once the
  * ID exceeds UINT64_MAX, further thread creation is not allowed and restarting
  * SPDK application is required.
@@ -327,6 +339,244 @@ timed_poller_compare(struct spdk_poller *poller1, struct spdk_poller *poller2)
 
 RB_GENERATE_STATIC(timed_pollers_tree, spdk_poller, node, timed_poller_compare);
 
+/*
+ * Hierarchical timer wheel used instead of the timed_pollers tree if enabled by
+ * spdk_thread_lib_set_timer_wheel().
+ *
+ * Time is counted in units of 1 << shift ticks, roughly a microsecond. Level 0 has one
+ * slot per unit and each slot of level n covers a full rotation of level n - 1. A poller
+ * is put on the lowest level whose range covers its expiration, so inserting and removing
+ * it is O(1). Once the wheel reaches the start of a slot of a higher level, the pollers
+ * in it are cascaded to lower levels. Pollers expiring beyond the range of the last level
+ * (about 19 hours at 1 GHz) are parked in its furthest slot and placed again when that
+ * slot is cascaded.
+ */
+#define TIMER_WHEEL_LEVEL_BITS	6
+#define TIMER_WHEEL_SLOTS	(1U << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_SLOT_MASK	(TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS	6
+
+struct timer_wheel {
+	/* Ticks per time unit of the wheel, as a shift */
+	uint32_t			shift;
+	uint32_t			count;
+	/* Time unit the wheel is at. The level 0 slot of it may still hold pollers
+	 * expiring later within the unit.
+	 */
+	uint64_t			now;
+	/* No poller expires before this tick */
+	uint64_t			next_expiry;
+	/* Bit mask of non-empty slots per level */
+	uint64_t			occupied[TIMER_WHEEL_LEVELS];
+	TAILQ_HEAD(, spdk_poller)	slots[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+};
+
+static struct timer_wheel *
+timer_wheel_create(uint64_t now_tick)
+{
+	struct timer_wheel *tw;
+	uint64_t ticks_per_us = spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	uint32_t i;
+
+	tw = calloc(1, sizeof(*tw));
+	if (tw == NULL) {
+		return NULL;
+	}
+
+	tw->shift = ticks_per_us > 1 ? spdk_u64log2(ticks_per_us) : 0;
+	tw->now = now_tick >> tw->shift;
+	tw->next_expiry = UINT64_MAX;
+	for (i = 0; i < SPDK_COUNTOF(tw->slots); i++) {
+		TAILQ_INIT(&tw->slots[i]);
+	}
+
+	return tw;
+}
+
+static void
+timer_wheel_place(struct timer_wheel *tw, struct spdk_poller *poller)
+{
+	uint64_t expires, delta;
+	uint32_t level, idx;
+
+	expires = spdk_max(poller->next_run_tick >> tw->shift, tw->now);
+	delta = expires - tw->now;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+		if (delta < 1ULL << (TIMER_WHEEL_LEVEL_BITS * (level + 1))) {
+			break;
+		}
+	}
+
+	if (delta >= 1ULL << (TIMER_WHEEL_LEVEL_BITS * TIMER_WHEEL_LEVELS)) {
+		/* Beyond the range of the wheel, park it in the slot cascaded last */
+		expires = tw->now + (TIMER_WHEEL_SLOT_MASK * (1ULL << (TIMER_WHEEL_LEVEL_BITS * level)));
+	}
+
+	idx = (expires >> (TIMER_WHEEL_LEVEL_BITS * level)) & TIMER_WHEEL_SLOT_MASK;
+	poller->wheel_slot = level * TIMER_WHEEL_SLOTS + idx;
+	TAILQ_INSERT_TAIL(&tw->slots[poller->wheel_slot], poller, tailq);
+	tw->occupied[level] |= 1ULL << idx;
+}
+
+static void
+timer_wheel_insert(struct timer_wheel *tw, struct spdk_poller *poller)
+{
+	timer_wheel_place(tw, poller);
+	tw->count++;
+	tw->next_expiry = spdk_min(tw->next_expiry, poller->next_run_tick);
+}
+
+static void
+timer_wheel_remove(struct timer_wheel *tw, struct spdk_poller *poller)
+{
+	uint32_t slot = poller->wheel_slot;
+
+	TAILQ_REMOVE(&tw->slots[slot], poller, tailq);
+	if (TAILQ_EMPTY(&tw->slots[slot])) {
+		tw->occupied[slot / TIMER_WHEEL_SLOTS] &= ~(1ULL << (slot & TIMER_WHEEL_SLOT_MASK));
+	}
+
+	assert(tw->count > 0);
+	if (--tw->count == 0) {
+		tw->next_expiry = UINT64_MAX;
+	}
+}
+
+/*
+ * Return the first time unit after tw->now at which a level 0 slot expires or a slot of
+ * a higher level has to be cascaded, UINT64_MAX if there is none. If the result is a
+ * level 0 slot, it is returned in level0_slot.
+ */
+static uint64_t
+timer_wheel_next_event(struct timer_wheel *tw, uint32_t *level0_slot)
+{
+	uint64_t next = UINT64_MAX, base, bits, t;
+	uint32_t level, shift, cur;
+
+	*level0_slot = UINT32_MAX;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		bits = tw->occupied[level];
+		if (level == 0) {
+			/* Pollers in the current slot are not an event */
+			bits &= ~(1ULL << (tw->now & TIMER_WHEEL_SLOT_MASK));
+		}
+		if (bits == 0) {
+			continue;
+		}
+
+		shift = TIMER_WHEEL_LEVEL_BITS * level;
+		cur = (tw->now >> shift) & TIMER_WHEEL_SLOT_MASK;
+		base = tw->now >> (shift + TIMER_WHEEL_LEVEL_BITS) << (shift + TIMER_WHEEL_LEVEL_BITS);
+
+		/* Slots up to the current one belong to the next rotation. The current slot
+		 * of a higher level was cascaded already when the wheel entered it.
+		 */
+		if (bits & ~((2ULL << cur) - 1)) {
+			t = base + ((uint64_t)__builtin_ctzll(bits & ~((2ULL << cur) - 1)) << shift);
+		} else {
+			t = base + (1ULL << (shift + TIMER_WHEEL_LEVEL_BITS)) +
+			    ((uint64_t)__builtin_ctzll(bits) << shift);
+		}
+
+		if (t < next) {
+			next = t;
+			*level0_slot = level == 0 ? (uint32_t)(t & TIMER_WHEEL_SLOT_MASK) : UINT32_MAX;
+		}
+	}
+
+	return next;
+}
+
+/* Cascade the slots of the higher levels starting at tw->now to the lower levels. */
+static void
+timer_wheel_cascade(struct timer_wheel *tw)
+{
+	TAILQ_HEAD(, spdk_poller) pollers = TAILQ_HEAD_INITIALIZER(pollers);
+	struct spdk_poller *poller;
+	uint32_t level, idx, shift;
+
+	for (level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+		shift = TIMER_WHEEL_LEVEL_BITS * level;
+		if (tw->now & ((1ULL << shift) - 1)) {
+			break;
+		}
+
+		idx = (tw->now >> shift) & TIMER_WHEEL_SLOT_MASK;
+		if (!(tw->occupied[level] & (1ULL << idx))) {
+			continue;
+		}
+
+		TAILQ_CONCAT(&pollers, &tw->slots[level * TIMER_WHEEL_SLOTS + idx], tailq);
+		tw->occupied[level] &= ~(1ULL << idx);
+
+		while ((poller = TAILQ_FIRST(&pollers)) != NULL) {
+			TAILQ_REMOVE(&pollers, poller, tailq);
+			timer_wheel_place(tw, poller);
+		}
+	}
+}
+
+static uint64_t
+timer_wheel_slot_min_tick(struct timer_wheel *tw, uint32_t slot)
+{
+	struct spdk_poller *poller;
+	uint64_t tick = UINT64_MAX;
+
+	TAILQ_FOREACH(poller, &tw->slots[slot], tailq) {
+		tick = spdk_min(tick, poller->next_run_tick);
+	}
+
+	return tick;
+}
+
+/* Recalculate the earliest tick a poller may expire at, after the wheel advanced. */
+static void
+timer_wheel_update_next_expiry(struct timer_wheel *tw)
+{
+	uint64_t next;
+	uint32_t level0_slot;
+
+	if (tw->count == 0) {
+		tw->next_expiry = UINT64_MAX;
+		return;
+	}
+
+	next = timer_wheel_next_event(tw, &level0_slot);
+	if (level0_slot != UINT32_MAX) {
+		next = timer_wheel_slot_min_tick(tw, level0_slot);
+	} else if (next != UINT64_MAX) {
+		next <<= tw->shift;
+	}
+
+	tw->next_expiry = spdk_min(next, timer_wheel_slot_min_tick(tw, tw->now & TIMER_WHEEL_SLOT_MASK));
+}
+
+static struct spdk_poller *
+timer_wheel_first_from(struct timer_wheel *tw, uint32_t slot)
+{
+	uint64_t bits;
+	uint32_t level;
+
+	for (level = slot / TIMER_WHEEL_SLOTS; level < TIMER_WHEEL_LEVELS; level++) {
+		bits = tw->occupied[level];
+		if (level == slot / TIMER_WHEEL_SLOTS) {
+			bits &= ~((1ULL << (slot & TIMER_WHEEL_SLOT_MASK)) - 1);
+		}
+		if (bits != 0) {
+			return TAILQ_FIRST(&tw->slots[level * TIMER_WHEEL_SLOTS + __builtin_ctzll(bits)]);
+		}
+	}
+
+	return NULL;
+}
+
+#define TIMED_POLLER_FOREACH_SAFE(poller, thread, tmp)					\
+	for ((poller) = spdk_thread_get_first_timed_poller(thread);			\
+	     (poller) != NULL && ((tmp) = spdk_thread_get_next_timed_poller(poller), true);	\
+	     (poller) = (tmp))
+
 static inline struct spdk_thread *
 _get_thread(void)
 {
@@ -366,6 +616,7 @@ _free_thread(struct spdk_thread *thread)
 	struct spdk_io_channel *ch;
 	struct spdk_msg *msg;
 	struct spdk_poller *poller, *ptmp;
+	uint32_t i;
 
 	RB_FOREACH(ch, io_channel_tree, &thread->io_channels) {
 		SPDK_ERRLOG("thread %s still has channel for io_device %s\n",
@@ -381,12 +632,14 @@ _free_thread(struct spdk_thread *thread)
 		free(poller);
 	}
 
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, ptmp) {
+	TIMED_POLLER_FOREACH_SAFE(poller, thread, ptmp) {
 		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
 			SPDK_WARNLOG("timed_poller %s still registered at thread exit\n",
 				     poller->name);
 		}
-		RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
+		if (thread->timer_wheel == NULL) {
+			RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
+		}
 		free(poller);
 	}
 
@@ -419,7 +672,10 @@ _free_thread(struct spdk_thread *thread)
 		thread_interrupt_destroy(thread);
 	}
 
-	spdk_ring_free(thread->messages);
+	for (i = 0; i < thread->num_msg_rings; i++) {
+		spdk_ring_free(thread->messages[i]);
+	}
+	free(thread->timer_wheel);
 	free(thread);
 }
 
@@ -462,6 +718,37 @@ spdk_thread_lib_init_ext(spdk_thread_op_fn thread_op_fn,
 	return _thread_lib_init(ctx_sz, msg_mempool_sz);
 }
 
+int
+spdk_thread_lib_set_msg_ring_count(uint32_t count)
+{
+	if (count == 0 || count > SPDK_THREAD_MAX_MSG_RINGS || !spdk_u32_is_pow2(count)) {
+		SPDK_ERRLOG("Invalid number of message rings %" PRIu32 "\n", count);
+		return -EINVAL;
+	}
+
+	if (g_spdk_msg_mempool != NULL) {
+		SPDK_ERRLOG("Number of message rings must be set before the library is initialized\n");
+		return -EBUSY;
+	}
+
+	g_num_msg_rings = count;
+
+	return 0;
+}
+
+int
+spdk_thread_lib_set_timer_wheel(bool enable)
+{
+	if (g_spdk_msg_mempool != NULL) {
+		SPDK_ERRLOG("Timer wheel must be selected before the library is initialized\n");
+		return -EBUSY;
+	}
+
+	g_timer_wheel = enable;
+
+	return 0;
+}
+
 void
 spdk_thread_lib_fini(void)
 {
@@ -475,6 +762,8 @@ spdk_thread_lib_fini(void)
 	g_thread_op_fn = NULL;
 	g_thread_op_supported_fn = NULL;
 	g_ctx_sz = 0;
+	g_num_msg_rings = 1;
+	g_timer_wheel = false;
 	if (g_app_thread != NULL) {
 		_free_thread(g_app_thread);
 		g_app_thread = NULL;
@@ -518,17 +807,35 @@ spdk_thread_create(const char *name, const struct spdk_cpuset *cpumask)
 
 	thread->tsc_last = spdk_get_ticks();
 
+	if (g_timer_wheel) {
+		thread->timer_wheel = timer_wheel_create(thread->tsc_last);
+		if (thread->timer_wheel == NULL) {
+			SPDK_ERRLOG("Unable to allocate memory for timer wheel\n");
+			free(thread);
+			return NULL;
+		}
+	}
+
 	/* Monotonic increasing ID is set to each created poller beginning at 1. Once the
 	 * ID exceeds UINT64_MAX a warning message is logged
 	 */
 	thread->next_poller_id = 1;
 
-	thread->messages = spdk_ring_create(SPDK_RING_TYPE_MP_SC, 65536, SPDK_ENV_SOCKET_ID_ANY);
-	if (!thread->messages) {
-		SPDK_ERRLOG("Unable to allocate memory for message ring\n");
-		free(thread);
-		return NULL;
+	for (i = 0; i < (int)g_num_msg_rings; i++) {
+		thread->messages[i] = spdk_ring_create(SPDK_RING_TYPE_MP_SC,
+						       SPDK_MSG_RING_SIZE / g_num_msg_rings,
+						       SPDK_ENV_SOCKET_ID_ANY);
+		if (!thread->messages[i]) {
+			SPDK_ERRLOG("Unable to allocate memory for message ring\n");
+			while (--i >= 0) {
+				spdk_ring_free(thread->messages[i]);
+			}
+			free(thread->timer_wheel);
+			free(thread);
+			return NULL;
+		}
 	}
+	thread->num_msg_rings = g_num_msg_rings;
 
 	/* Fill the local message pool cache. */
 	rc = spdk_mempool_get_bulk(g_spdk_msg_mempool, (void **)msgs, SPDK_MSG_MEMPOOL_CACHE_SIZE);
@@ -629,6 +936,39 @@ spdk_set_thread(struct spdk_thread *thread)
 	tls_thread = thread;
 }
 
+static inline size_t
+msg_queue_count(struct spdk_thread *thread)
+{
+	size_t count = 0;
+	uint32_t i;
+
+	for (i = 0; i < thread->num_msg_rings; i++) {
+		count += spdk_ring_count(thread->messages[i]);
+	}
+
+	return count;
+}
+
+static inline uint32_t
+msg_queue_dequeue(struct spdk_thread *thread, void **messages, uint32_t max_msgs)
+{
+	uint32_t count = 0, i, ring;
+
+	if (spdk_likely(thread->num_msg_rings == 1)) {
+		return spdk_ring_dequeue(thread->messages[0], messages, max_msgs);
+	}
+
+	/* Start from a different ring each time, so that a busy sender can't starve the others */
+	ring = thread->next_msg_ring;
+	for (i = 0; i < thread->num_msg_rings && count < max_msgs; i++) {
+		count += spdk_ring_dequeue(thread->messages[ring], &messages[count], max_msgs - count);
+		ring = (ring + 1) & (thread->num_msg_rings - 1);
+	}
+	thread->next_msg_ring = (thread->next_msg_ring + 1) & (thread->num_msg_rings - 1);
+
+	return count;
+}
+
 static void
 thread_exit(struct spdk_thread *thread, uint64_t now)
 {
@@ -641,7 +981,7 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 		goto exited;
 	}
 
-	if (spdk_ring_count(thread->messages) > 0) {
+	if (msg_queue_count(thread) > 0) {
 		SPDK_INFOLOG(thread, "thread %s still has messages\n", thread->name);
 		return;
 	}
@@ -661,7 +1001,8 @@ thread_exit(struct spdk_thread *thread, uint64_t now)
 		}
 	}
 
-	RB_FOREACH(poller, timed_pollers_tree, &thread->timed_pollers) {
+	for (poller = spdk_thread_get_first_timed_poller(thread); poller != NULL;
+	     poller = spdk_thread_get_next_timed_poller(poller)) {
 		if (poller->state != SPDK_POLLER_STATE_UNREGISTERED) {
 			SPDK_INFOLOG(thread,
 				     "thread %s still has active timed poller %s\n",
@@ -836,9 +1177,9 @@ msg_queue_run_batch(struct spdk_thread *thread, uint32_t max_msgs)
 		max_msgs = SPDK_MSG_BATCH_SIZE;
 	}
 
-	count = spdk_ring_dequeue(thread->messages, messages, max_msgs);
+	count = msg_queue_dequeue(thread, messages, max_msgs);
 	if (spdk_unlikely(thread->in_interrupt) &&
-	    spdk_ring_count(thread->messages) != 0) {
+	    msg_queue_count(thread) != 0) {
 		rc = write(thread->msg_fd, &notify, sizeof(notify));
 		if (rc < 0) {
 			SPDK_ERRLOG("failed to notify msg_queue: %s.\n", spdk_strerror(errno));
@@ -879,6 +1220,11 @@ poller_insert_timer(struct spdk_thread *thread, struct spdk_poller *poller, uint
 
 	poller->next_run_tick = now + poller->period_ticks;
 
+	if (thread->timer_wheel != NULL) {
+		timer_wheel_insert(thread->timer_wheel, poller);
+		return;
+	}
+
 	/*
 	 * Insert poller in the thread's timed_pollers tree by next scheduled run time
 	 * as its key.
@@ -901,6 +1247,11 @@ poller_remove_timer(struct spdk_thread *thread, struct spdk_poller *poller)
 {
 	struct spdk_poller *tmp __attribute__((unused));
 
+	if (thread->timer_wheel != NULL) {
+		timer_wheel_remove(thread->timer_wheel, poller);
+		return;
+	}
+
 	tmp = RB_REMOVE(timed_pollers_tree, &thread->timed_pollers, poller);
 	assert(tmp != NULL);
 
@@ -1060,6 +1411,50 @@ thread_execute_timed_poller(struct spdk_thread *thread, struct spdk_poller *poll
 	return rc;
 }
 
+static int
+thread_run_timer_wheel(struct spdk_thread *thread, uint64_t now)
+{
+	struct timer_wheel *tw = thread->timer_wheel;
+	struct spdk_poller *poller, *tmp;
+	uint64_t target = now >> tw->shift, next;
+	uint32_t level0_slot;
+	int rc = 0, timer_rc;
+
+	while (true) {
+		/* Pollers re-inserted by thread_execute_timed_poller() expire after now, so
+		 * they are skipped if they land behind tmp in the same slot.
+		 */
+		TAILQ_FOREACH_SAFE(poller, &tw->slots[tw->now & TIMER_WHEEL_SLOT_MASK], tailq, tmp) {
+			if (now < poller->next_run_tick) {
+				continue;
+			}
+
+			timer_wheel_remove(tw, poller);
+			timer_rc = thread_execute_timed_poller(thread, poller, now);
+			if (timer_rc > rc) {
+				rc = timer_rc;
+			}
+		}
+
+		if (tw->now >= target) {
+			break;
+		}
+
+		next = timer_wheel_next_event(tw, &level0_slot);
+		if (next > target) {
+			tw->now = target;
+			break;
+		}
+
+		tw->now = next;
+		timer_wheel_cascade(tw);
+	}
+
+	timer_wheel_update_next_expiry(tw);
+
+	return rc;
+}
+
 static int
 thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 {
@@ -1092,6 +1487,18 @@ thread_poll(struct spdk_thread *thread, uint32_t max_msgs, uint64_t now)
 		}
 	}
 
+	if (thread->timer_wheel != NULL) {
+		if (now >= thread->timer_wheel->next_expiry) {
+			int timer_rc = thread_run_timer_wheel(thread, now);
+
+			if (timer_rc > rc) {
+				rc = timer_rc;
+			}
+		}
+
+		return rc;
+	}
+
 	poller = thread->first_timed_poller;
 	while (poller != NULL) {
 		int timer_rc = 0;
@@ -1136,7 +1543,7 @@ _thread_remove_pollers(void *ctx)
 		}
 	}
 
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, tmp) {
+	TIMED_POLLER_FOREACH_SAFE(poller, thread, tmp) {
 		if (poller->state == SPDK_POLLER_STATE_UNREGISTERED) {
 			poller_remove_timer(thread, poller);
 			free(poller);
@@ -1203,6 +1610,10 @@ spdk_thread_next_poller_expiration(struct spdk_thread *thread)
 {
 	struct spdk_poller *poller;
 
+	if (thread->timer_wheel != NULL) {
+		return thread->timer_wheel->count > 0 ? thread->timer_wheel->next_expiry : 0;
+	}
+
 	poller = thread->first_timed_poller;
 	if (poller) {
 		return poller->next_run_tick;
@@ -1221,7 +1632,7 @@ static bool
 thread_has_unpaused_pollers(struct spdk_thread *thread)
 {
 	if (TAILQ_EMPTY(&thread->active_pollers) &&
-	    RB_EMPTY(&thread->timed_pollers)) {
+	    spdk_thread_get_first_timed_poller(thread) == NULL) {
 		return false;
 	}
 
@@ -1242,7 +1653,7 @@ spdk_thread_has_pollers(struct spdk_thread *thread)
 bool
 spdk_thread_is_idle(struct spdk_thread *thread)
 {
-	if (spdk_ring_count(thread->messages) ||
+	if (msg_queue_count(thread) ||
 	    thread_has_unpaused_pollers(thread) ||
 	    thread->critical_msg != NULL) {
 		return false;
@@ -1360,6 +1771,7 @@ spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx
 {
 	struct spdk_thread *local_thread;
 	struct spdk_msg *msg;
+	uint32_t ring;
 	int rc;
 
 	assert(thread != NULL);
@@ -1392,7 +1804,9 @@ spdk_thread_send_msg(const struct spdk_thread *thread, spdk_msg_fn fn, void *ctx
 	msg->fn = fn;
 	msg->arg = ctx;
 
-	rc = spdk_ring_enqueue(thread->messages, (void **)&msg, 1, NULL);
+	/* Messages from outside of SPDK threads all go to the first ring */
+	ring = local_thread != NULL ? local_thread->id & (thread->num_msg_rings - 1) : 0;
+	rc = spdk_ring_enqueue(thread->messages[ring], (void **)&msg, 1, NULL);
 	if (rc != 1) {
 		SPDK_ERRLOG("msg could not be enqueued\n");
 		spdk_mempool_put(g_spdk_msg_mempool, msg);
@@ -1947,12 +2361,27 @@ spdk_thread_get_next_active_poller(struct spdk_poller *prev)
 struct spdk_poller *
 spdk_thread_get_first_timed_poller(struct spdk_thread *thread)
 {
+	if (thread->timer_wheel != NULL) {
+		return timer_wheel_first_from(thread->timer_wheel, 0);
+	}
+
 	return RB_MIN(timed_pollers_tree, &thread->timed_pollers);
 }
 
 struct spdk_poller *
 spdk_thread_get_next_timed_poller(struct spdk_poller *prev)
 {
+	struct spdk_poller *poller;
+
+	if (prev->thread->timer_wheel != NULL) {
+		poller = TAILQ_NEXT(prev, tailq);
+		if (poller != NULL) {
+			return poller;
+		}
+
+		return timer_wheel_first_from(prev->thread->timer_wheel, prev->wheel_slot + 1);
+	}
+
 	return RB_NEXT(timed_pollers_tree, &thread->timed_pollers, prev);
 }
 
@@ -2105,7 +2534,7 @@ spdk_thread_set_interrupt_mode(bool enable_interrupt)
 	}
 
 	/* Set pollers to expected mode */
-	RB_FOREACH_SAFE(poller, timed_pollers_tree, &thread->timed_pollers, tmp) {
+	TIMED_POLLER_FOREACH_SAFE(poller, thread, tmp) {
 		poller_set_interrupt_mode(poller, enable_interrupt);
 	}
 	TAILQ_FOREACH_SAFE(poller, &thread->active_pollers, tailq, tmp) {
@@ -2513,6 +2942,11 @@ struct spdk_io_channel_iter {
 
 	struct spdk_thread *orig_thread;
 	spdk_channel_for_each_cpl cpl;
+
+	/* Iterators of the channels visited by spdk_for_each_channel_parallel() */
+	struct spdk_io_channel_iter *children;
+	struct spdk_io_channel_iter *parent;
+	uint32_t outstanding;
 };
 
 void *
@@ -2544,6 +2978,7 @@ _call_completion(void *ctx)
 	if (i->cpl != NULL) {
 		i->cpl(i, i->status);
 	}
+	free(i->children);
 	free(i);
 }
 
@@ -2641,6 +3076,140 @@ __pending_unregister(void *arg)
 	spdk_io_device_unregister(dev->io_device, dev->unregister_cb);
 }
 
+/* Called with g_devlist_mutex held, which is released. */
+static void
+for_each_channel_complete(struct spdk_io_channel_iter *i)
+{
+	struct io_device *dev = i->dev;
+	int rc __attribute__((unused));
+
+	dev->for_each_count--;
+	i->ch = NULL;
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	rc = spdk_thread_send_msg(i->orig_thread, _call_completion, i);
+	assert(rc == 0);
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	if (dev->pending_unregister && dev->for_each_count == 0) {
+		rc = spdk_thread_send_msg(dev->unregister_thread, __pending_unregister, dev);
+		assert(rc == 0);
+	}
+	pthread_mutex_unlock(&g_devlist_mutex);
+}
+
+void
+spdk_for_each_channel_parallel(void *io_device, spdk_channel_msg fn, void *ctx,
+			       spdk_channel_for_each_cpl cpl)
+{
+	struct spdk_thread *thread;
+	struct spdk_io_channel *ch;
+	struct spdk_io_channel_iter *i, *child;
+	uint32_t count = 0, n;
+	int rc __attribute__((unused));
+
+	i = calloc(1, sizeof(*i));
+	if (!i) {
+		SPDK_ERRLOG("Unable to allocate iterator\n");
+		assert(false);
+		return;
+	}
+
+	i->io_device = io_device;
+	i->fn = fn;
+	i->ctx = ctx;
+	i->cpl = cpl;
+	i->orig_thread = _get_thread();
+
+	i->orig_thread->for_each_count++;
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	i->dev = io_device_get(io_device);
+	if (i->dev == NULL) {
+		SPDK_ERRLOG("could not find io_device %p\n", io_device);
+		assert(false);
+		i->status = -ENODEV;
+		goto end;
+	}
+
+	if (i->dev->pending_unregister) {
+		SPDK_ERRLOG("io_device %p has a pending unregister\n", io_device);
+		i->status = -ENODEV;
+		goto end;
+	}
+
+	TAILQ_FOREACH(thread, &g_threads, tailq) {
+		if (thread_get_io_channel(thread, i->dev) != NULL) {
+			count++;
+		}
+	}
+
+	if (count == 0) {
+		goto end;
+	}
+
+	i->children = calloc(count, sizeof(*i->children));
+	if (i->children == NULL) {
+		SPDK_ERRLOG("Unable to allocate iterators\n");
+		i->status = -ENOMEM;
+		goto end;
+	}
+
+	n = 0;
+	TAILQ_FOREACH(thread, &g_threads, tailq) {
+		ch = thread_get_io_channel(thread, i->dev);
+		if (ch != NULL) {
+			child = &i->children[n++];
+			child->io_device = io_device;
+			child->dev = i->dev;
+			child->fn = fn;
+			child->ctx = ctx;
+			child->ch = ch;
+			child->cur_thread = thread;
+			child->orig_thread = i->orig_thread;
+			child->parent = i;
+		}
+	}
+
+	i->dev->for_each_count++;
+	i->outstanding = count;
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	/* The iterator can't be freed before we return, as it is completed on this thread */
+	for (n = 0; n < count; n++) {
+		rc = spdk_thread_send_msg(i->children[n].cur_thread, _call_channel, &i->children[n]);
+		assert(rc == 0);
+	}
+
+	return;
+end:
+	pthread_mutex_unlock(&g_devlist_mutex);
+
+	rc = spdk_thread_send_msg(i->orig_thread, _call_completion, i);
+	assert(rc == 0);
+}
+
+static void
+for_each_channel_parallel_continue(struct spdk_io_channel_iter *i, int status)
+{
+	struct spdk_io_channel_iter *parent = i->parent;
+	int expected = 0;
+
+	/* Report the first failure, the other channels are visited anyway */
+	if (status != 0) {
+		__atomic_compare_exchange_n(&parent->status, &expected, status, false,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	}
+
+	i->ch = NULL;
+	if (__atomic_sub_fetch(&parent->outstanding, 1, __ATOMIC_ACQ_REL) > 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&g_devlist_mutex);
+	for_each_channel_complete(parent);
+}
+
 void
 spdk_for_each_channel_continue(struct spdk_io_channel_iter *i, int status)
 {
@@ -2651,6 +3220,11 @@ spdk_for_each_channel_continue(struct spdk_io_channel_iter *i, int status)
 
 	assert(i->cur_thread == spdk_get_thread());
 
+	if (i->parent != NULL) {
+		for_each_channel_parallel_continue(i, status);
+		return;
+	}
+
 	i->status = status;
 
 	pthread_mutex_lock(&g_devlist_mutex);
@@ -2674,19 +3248,7 @@ spdk_for_each_channel_continue(struct spdk_io_channel_iter *i, int status)
 	}
 
 end:
-	dev->for_each_count--;
-	i->ch = NULL;
-	pthread_mutex_unlock(&g_devlist_mutex);
-
-	rc = spdk_thread_send_msg(i->orig_thread, _call_completion, i);
-	assert(rc == 0);
-
-	pthread_mutex_lock(&g_devlist_mutex);
-	if (dev->pending_unregister && dev->for_each_count == 0) {
-		rc = spdk_thread_send_msg(dev->unregister_thread, __pending_unregister, dev);
-		assert(rc == 0);
-	}
-	pthread_mutex_unlock(&g_devlist_mutex);
+	for_each_channel_complete(i);
 }
 
 static void
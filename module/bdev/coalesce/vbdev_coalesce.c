@@ -0,0 +1,1126 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+/*
+ * Virtual block device that coalesces small reads and writes. Each channel holds
+ * incoming I/O for a short while and merges I/O that continue exactly where the
+ * previous one ended into a single multi-iovec request to the base bdev. The
+ * completion of that request is fanned out to every I/O it carries.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "vbdev_coalesce.h"
+#include "spdk/env.h"
+#include "spdk/string.h"
+#include "spdk/thread.h"
+#include "spdk/util.h"
+
+#include "spdk/bdev_module.h"
+#include "spdk/log.h"
+
+/* This namespace UUID was generated using uuid_generate() method. */
+#define BDEV_COALESCE_NAMESPACE_UUID "0b8f4bd6-3c55-4f55-9d1e-6a3e8c2f7d41"
+
+/* Largest number of iovecs a merged request can carry. */
+#define VBDEV_COALESCE_MAX_IOVS	64
+
+/* The held requests are checked this many times per max_delay_us, so they are held
+ * at most a quarter longer than the configured delay.
+ */
+#define VBDEV_COALESCE_POLLS_PER_DELAY	4
+
+static int vbdev_coalesce_init(void);
+static int vbdev_coalesce_get_ctx_size(void);
+static void vbdev_coalesce_examine(struct spdk_bdev *bdev);
+static void vbdev_coalesce_finish(void);
+static int vbdev_coalesce_config_json(struct spdk_json_write_ctx *w);
+
+static struct spdk_bdev_module coalesce_if = {
+	.name = "coalesce",
+	.module_init = vbdev_coalesce_init,
+	.get_ctx_size = vbdev_coalesce_get_ctx_size,
+	.examine_config = vbdev_coalesce_examine,
+	.module_fini = vbdev_coalesce_finish,
+	.config_json = vbdev_coalesce_config_json
+};
+
+SPDK_BDEV_MODULE_REGISTER(coalesce, &coalesce_if)
+
+/* List of coalesce bdev names and their base bdevs, so the vbdev can be created
+ * in examine() once the base bdev shows up.
+ */
+struct bdev_names {
+	char				*vbdev_name;
+	char				*bdev_name;
+	struct spdk_uuid		uuid;
+	struct vbdev_coalesce_opts	opts;
+	TAILQ_ENTRY(bdev_names)		link;
+};
+static TAILQ_HEAD(, bdev_names) g_bdev_names = TAILQ_HEAD_INITIALIZER(g_bdev_names);
+
+struct vbdev_coalesce {
+	struct spdk_bdev		*base_bdev; /* the thing we're attaching to */
+	struct spdk_bdev_desc		*base_desc; /* its descriptor we get from open */
+	struct spdk_bdev		coalesce_bdev;
+	struct vbdev_coalesce_opts	opts;
+	uint64_t			max_delay_ticks;
+	uint64_t			max_blocks;
+	TAILQ_ENTRY(vbdev_coalesce)	link;
+	struct spdk_thread		*thread;    /* thread where base device is opened */
+};
+static TAILQ_HEAD(, vbdev_coalesce) g_coalesce_nodes = TAILQ_HEAD_INITIALIZER(g_coalesce_nodes);
+
+enum coalesce_queue {
+	COALESCE_QUEUE_READ,
+	COALESCE_QUEUE_WRITE,
+	COALESCE_QUEUE_COUNT
+};
+
+struct coalesce_bdev_io {
+	/* Tick at which the I/O entered the coalescing queue. */
+	uint64_t submit_tick;
+
+	struct spdk_io_channel *ch;
+
+	struct spdk_bdev_io_wait_entry bdev_io_wait;
+
+	TAILQ_ENTRY(coalesce_bdev_io) link;
+};
+
+/* A merged request. While it is the open request of its queue it accepts I/O
+ * continuing at offset_blocks + num_blocks, after that it's in flight to the
+ * base bdev.
+ */
+struct coalesce_req {
+	struct coalesce_io_channel		*ch;
+	enum coalesce_queue			queue;
+	uint64_t				offset_blocks;
+	uint64_t				num_blocks;
+	uint64_t				start_tick;
+	uint32_t				num_ios;
+	int					iovcnt;
+	TAILQ_HEAD(, coalesce_bdev_io)		ios;
+	struct spdk_bdev_io_wait_entry		bdev_io_wait;
+	TAILQ_ENTRY(coalesce_req)		link;
+	struct iovec				iovs[VBDEV_COALESCE_MAX_IOVS];
+};
+
+struct coalesce_io_channel {
+	struct spdk_io_channel		*base_ch; /* IO channel of base device */
+	struct vbdev_coalesce		*node;
+	struct coalesce_req		*open[COALESCE_QUEUE_COUNT];
+	TAILQ_HEAD(, coalesce_req)	free_reqs;
+	struct spdk_poller		*poller;
+	struct vbdev_coalesce_stats	stats;
+};
+
+static void vbdev_coalesce_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io);
+
+void
+bdev_coalesce_get_default_opts(struct vbdev_coalesce_opts *opts)
+{
+	opts->max_delay_us = VBDEV_COALESCE_DEFAULT_MAX_DELAY_US;
+	opts->max_ios = VBDEV_COALESCE_DEFAULT_MAX_IOS;
+	opts->max_io_size_kib = VBDEV_COALESCE_DEFAULT_MAX_IO_SIZE_KIB;
+}
+
+/* Callback for unregistering the IO device. */
+static void
+_device_unregister_cb(void *io_device)
+{
+	struct vbdev_coalesce *coalesce_node = io_device;
+
+	free(coalesce_node->coalesce_bdev.name);
+	free(coalesce_node);
+}
+
+static void
+_vbdev_coalesce_destruct(void *ctx)
+{
+	struct spdk_bdev_desc *desc = ctx;
+
+	spdk_bdev_close(desc);
+}
+
+static int
+vbdev_coalesce_destruct(void *ctx)
+{
+	struct vbdev_coalesce *coalesce_node = (struct vbdev_coalesce *)ctx;
+
+	TAILQ_REMOVE(&g_coalesce_nodes, coalesce_node, link);
+
+	/* Unclaim the underlying bdev. */
+	spdk_bdev_module_release_bdev(coalesce_node->base_bdev);
+
+	/* Close the underlying bdev on its same opened thread. */
+	if (coalesce_node->thread && coalesce_node->thread != spdk_get_thread()) {
+		spdk_thread_send_msg(coalesce_node->thread, _vbdev_coalesce_destruct,
+				     coalesce_node->base_desc);
+	} else {
+		spdk_bdev_close(coalesce_node->base_desc);
+	}
+
+	spdk_io_device_unregister(coalesce_node, _device_unregister_cb);
+
+	return 0;
+}
+
+static void
+coalesce_put_req(struct coalesce_req *req)
+{
+	TAILQ_INSERT_HEAD(&req->ch->free_reqs, req, link);
+}
+
+/* Completion callback for a merged request. The status of the base I/O is copied
+ * to all of the I/O it was built from.
+ */
+static void
+_coalesce_complete_req(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct coalesce_req *req = cb_arg;
+	struct coalesce_bdev_io *io_ctx;
+
+	while ((io_ctx = TAILQ_FIRST(&req->ios))) {
+		TAILQ_REMOVE(&req->ios, io_ctx, link);
+		spdk_bdev_io_complete_base_io_status(spdk_bdev_io_from_ctx(io_ctx), bdev_io);
+	}
+
+	coalesce_put_req(req);
+	spdk_bdev_free_io(bdev_io);
+}
+
+static void
+_coalesce_complete_io(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct spdk_bdev_io *orig_io = cb_arg;
+
+	spdk_bdev_io_complete_base_io_status(orig_io, bdev_io);
+	spdk_bdev_free_io(bdev_io);
+}
+
+static void
+coalesce_req_fail(struct coalesce_req *req)
+{
+	struct coalesce_bdev_io *io_ctx;
+
+	while ((io_ctx = TAILQ_FIRST(&req->ios))) {
+		TAILQ_REMOVE(&req->ios, io_ctx, link);
+		spdk_bdev_io_complete(spdk_bdev_io_from_ctx(io_ctx), SPDK_BDEV_IO_STATUS_FAILED);
+	}
+
+	coalesce_put_req(req);
+}
+
+static void
+coalesce_submit_req(void *arg)
+{
+	struct coalesce_req *req = arg;
+	struct coalesce_io_channel *coalesce_ch = req->ch;
+	struct vbdev_coalesce *coalesce_node = coalesce_ch->node;
+	int rc;
+
+	if (req->queue == COALESCE_QUEUE_READ) {
+		rc = spdk_bdev_readv_blocks(coalesce_node->base_desc, coalesce_ch->base_ch, req->iovs,
+					    req->iovcnt, req->offset_blocks, req->num_blocks,
+					    _coalesce_complete_req, req);
+	} else {
+		rc = spdk_bdev_writev_blocks(coalesce_node->base_desc, coalesce_ch->base_ch, req->iovs,
+					     req->iovcnt, req->offset_blocks, req->num_blocks,
+					     _coalesce_complete_req, req);
+	}
+
+	if (rc == -ENOMEM) {
+		req->bdev_io_wait.bdev = coalesce_node->base_bdev;
+		req->bdev_io_wait.cb_fn = coalesce_submit_req;
+		req->bdev_io_wait.cb_arg = req;
+		rc = spdk_bdev_queue_io_wait(coalesce_node->base_bdev, coalesce_ch->base_ch,
+					     &req->bdev_io_wait);
+	}
+	if (rc != 0) {
+		SPDK_ERRLOG("ERROR on coalesced bdev_io submission, rc=%d\n", rc);
+		coalesce_req_fail(req);
+	}
+}
+
+/* Close the open request of a queue and send it down to the base bdev. */
+static void
+coalesce_flush_queue(struct coalesce_io_channel *coalesce_ch, enum coalesce_queue queue)
+{
+	struct coalesce_req *req = coalesce_ch->open[queue];
+	struct vbdev_coalesce_stats *stats = &coalesce_ch->stats;
+	struct coalesce_bdev_io *io_ctx;
+	uint64_t now, latency;
+
+	if (req == NULL) {
+		return;
+	}
+
+	coalesce_ch->open[queue] = NULL;
+
+	now = spdk_get_ticks();
+	TAILQ_FOREACH(io_ctx, &req->ios, link) {
+		latency = now - io_ctx->submit_tick;
+		stats->added_latency_ticks += latency;
+		stats->max_added_latency_ticks = spdk_max(stats->max_added_latency_ticks, latency);
+	}
+
+	if (queue == COALESCE_QUEUE_READ) {
+		stats->num_read_ops += req->num_ios;
+		stats->num_child_read_ops++;
+	} else {
+		stats->num_write_ops += req->num_ios;
+		stats->num_child_write_ops++;
+	}
+
+	coalesce_submit_req(req);
+}
+
+static void
+coalesce_flush_all(struct coalesce_io_channel *coalesce_ch)
+{
+	coalesce_flush_queue(coalesce_ch, COALESCE_QUEUE_READ);
+	coalesce_flush_queue(coalesce_ch, COALESCE_QUEUE_WRITE);
+}
+
+static int
+coalesce_poll(void *arg)
+{
+	struct coalesce_io_channel *coalesce_ch = arg;
+	uint64_t now = spdk_get_ticks();
+	int i, count = 0;
+
+	for (i = 0; i < COALESCE_QUEUE_COUNT; i++) {
+		if (coalesce_ch->open[i] != NULL &&
+		    now - coalesce_ch->open[i]->start_tick >= coalesce_ch->node->max_delay_ticks) {
+			coalesce_flush_queue(coalesce_ch, i);
+			count++;
+		}
+	}
+
+	/* Nothing is held anymore, the poller is armed again by the next open request */
+	if (coalesce_ch->open[COALESCE_QUEUE_READ] == NULL &&
+	    coalesce_ch->open[COALESCE_QUEUE_WRITE] == NULL) {
+		spdk_poller_pause(coalesce_ch->poller);
+	}
+
+	return count == 0 ? SPDK_POLLER_IDLE : SPDK_POLLER_BUSY;
+}
+
+static void
+vbdev_coalesce_resubmit_io(void *arg)
+{
+	struct spdk_bdev_io *bdev_io = (struct spdk_bdev_io *)arg;
+	struct coalesce_bdev_io *io_ctx = (struct coalesce_bdev_io *)bdev_io->driver_ctx;
+
+	vbdev_coalesce_submit_request(io_ctx->ch, bdev_io);
+}
+
+static void
+vbdev_coalesce_queue_io(struct spdk_bdev_io *bdev_io)
+{
+	struct coalesce_bdev_io *io_ctx = (struct coalesce_bdev_io *)bdev_io->driver_ctx;
+	struct coalesce_io_channel *coalesce_ch = spdk_io_channel_get_ctx(io_ctx->ch);
+	int rc;
+
+	io_ctx->bdev_io_wait.bdev = bdev_io->bdev;
+	io_ctx->bdev_io_wait.cb_fn = vbdev_coalesce_resubmit_io;
+	io_ctx->bdev_io_wait.cb_arg = bdev_io;
+
+	/* Queue the IO using the channel of the base device. */
+	rc = spdk_bdev_queue_io_wait(bdev_io->bdev, coalesce_ch->base_ch, &io_ctx->bdev_io_wait);
+	if (rc != 0) {
+		SPDK_ERRLOG("Queue io failed in vbdev_coalesce_queue_io, rc=%d.\n", rc);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+coalesce_init_ext_io_opts(struct spdk_bdev_io *bdev_io, struct spdk_bdev_ext_io_opts *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->size = sizeof(*opts);
+	opts->memory_domain = bdev_io->u.bdev.memory_domain;
+	opts->memory_domain_ctx = bdev_io->u.bdev.memory_domain_ctx;
+	opts->metadata = bdev_io->u.bdev.md_buf;
+}
+
+/* Pass a read or write that can't be merged straight to the base bdev. */
+static int
+coalesce_submit_rw_direct(struct coalesce_io_channel *coalesce_ch, struct spdk_bdev_io *bdev_io)
+{
+	struct vbdev_coalesce *coalesce_node = coalesce_ch->node;
+	struct spdk_bdev_ext_io_opts io_opts;
+
+	coalesce_init_ext_io_opts(bdev_io, &io_opts);
+	if (bdev_io->type == SPDK_BDEV_IO_TYPE_READ) {
+		return spdk_bdev_readv_blocks_ext(coalesce_node->base_desc, coalesce_ch->base_ch,
+						  bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+						  bdev_io->u.bdev.offset_blocks,
+						  bdev_io->u.bdev.num_blocks, _coalesce_complete_io,
+						  bdev_io, &io_opts);
+	} else {
+		return spdk_bdev_writev_blocks_ext(coalesce_node->base_desc, coalesce_ch->base_ch,
+						   bdev_io->u.bdev.iovs, bdev_io->u.bdev.iovcnt,
+						   bdev_io->u.bdev.offset_blocks,
+						   bdev_io->u.bdev.num_blocks, _coalesce_complete_io,
+						   bdev_io, &io_opts);
+	}
+}
+
+static bool
+coalesce_io_is_mergeable(struct vbdev_coalesce *coalesce_node, struct spdk_bdev_io *bdev_io)
+{
+	return bdev_io->u.bdev.md_buf == NULL &&
+	       bdev_io->u.bdev.memory_domain == NULL &&
+	       bdev_io->u.bdev.iovcnt <= VBDEV_COALESCE_MAX_IOVS &&
+	       bdev_io->u.bdev.num_blocks < coalesce_node->max_blocks;
+}
+
+static bool
+coalesce_req_can_append(struct vbdev_coalesce *coalesce_node, struct coalesce_req *req,
+			struct spdk_bdev_io *bdev_io)
+{
+	return req->offset_blocks + req->num_blocks == bdev_io->u.bdev.offset_blocks &&
+	       req->num_blocks + bdev_io->u.bdev.num_blocks <= coalesce_node->max_blocks &&
+	       req->iovcnt + bdev_io->u.bdev.iovcnt <= VBDEV_COALESCE_MAX_IOVS;
+}
+
+static struct coalesce_req *
+coalesce_get_req(struct coalesce_io_channel *coalesce_ch)
+{
+	struct coalesce_req *req;
+
+	req = TAILQ_FIRST(&coalesce_ch->free_reqs);
+	if (req != NULL) {
+		TAILQ_REMOVE(&coalesce_ch->free_reqs, req, link);
+		return req;
+	}
+
+	req = calloc(1, sizeof(*req));
+	if (req != NULL) {
+		req->ch = coalesce_ch;
+	}
+
+	return req;
+}
+
+/* Add a read or write to the open request of its queue, starting a new request
+ * if it doesn't continue the open one. Returns a negative errno if the I/O has to be
+ * submitted some other way.
+ */
+static int
+coalesce_queue_rw(struct coalesce_io_channel *coalesce_ch, struct spdk_bdev_io *bdev_io)
+{
+	struct vbdev_coalesce *coalesce_node = coalesce_ch->node;
+	struct coalesce_bdev_io *io_ctx = (struct coalesce_bdev_io *)bdev_io->driver_ctx;
+	enum coalesce_queue queue;
+	struct coalesce_req *req;
+	int i;
+
+	queue = bdev_io->type == SPDK_BDEV_IO_TYPE_READ ? COALESCE_QUEUE_READ : COALESCE_QUEUE_WRITE;
+	req = coalesce_ch->open[queue];
+	if (req != NULL && !coalesce_req_can_append(coalesce_node, req, bdev_io)) {
+		coalesce_flush_queue(coalesce_ch, queue);
+		req = NULL;
+	}
+
+	if (req == NULL) {
+		req = coalesce_get_req(coalesce_ch);
+		if (req == NULL) {
+			return -ENOMEM;
+		}
+
+		req->queue = queue;
+		req->offset_blocks = bdev_io->u.bdev.offset_blocks;
+		req->num_blocks = 0;
+		req->num_ios = 0;
+		req->iovcnt = 0;
+		req->start_tick = io_ctx->submit_tick;
+		TAILQ_INIT(&req->ios);
+		coalesce_ch->open[queue] = req;
+		spdk_poller_resume(coalesce_ch->poller);
+	}
+
+	for (i = 0; i < bdev_io->u.bdev.iovcnt; i++) {
+		req->iovs[req->iovcnt++] = bdev_io->u.bdev.iovs[i];
+	}
+	req->num_blocks += bdev_io->u.bdev.num_blocks;
+	req->num_ios++;
+	TAILQ_INSERT_TAIL(&req->ios, io_ctx, link);
+
+	if (req->num_ios >= coalesce_node->opts.max_ios ||
+	    req->num_blocks >= coalesce_node->max_blocks) {
+		coalesce_flush_queue(coalesce_ch, queue);
+	}
+
+	return 0;
+}
+
+static void
+coalesce_submit_rw(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct coalesce_io_channel *coalesce_ch = spdk_io_channel_get_ctx(ch);
+	struct coalesce_bdev_io *io_ctx = (struct coalesce_bdev_io *)bdev_io->driver_ctx;
+	int rc = -EINVAL;
+
+	io_ctx->ch = ch;
+	io_ctx->submit_tick = spdk_get_ticks();
+
+	if (coalesce_io_is_mergeable(coalesce_ch->node, bdev_io)) {
+		rc = coalesce_queue_rw(coalesce_ch, bdev_io);
+	}
+	if (rc == 0) {
+		return;
+	}
+
+	rc = coalesce_submit_rw_direct(coalesce_ch, bdev_io);
+	if (rc != 0) {
+		if (rc == -ENOMEM) {
+			SPDK_ERRLOG("No memory, start to queue io for coalesce.\n");
+			vbdev_coalesce_queue_io(bdev_io);
+		} else {
+			SPDK_ERRLOG("ERROR on bdev_io submission!\n");
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		}
+	}
+}
+
+static void
+coalesce_read_get_buf_cb(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io, bool success)
+{
+	if (!success) {
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	coalesce_submit_rw(ch, bdev_io);
+}
+
+/* Abort an I/O that is still waiting in an open request of this channel. The other
+ * I/O of that request are queued again, which may split it into several requests.
+ */
+static bool
+coalesce_abort_queued_io(struct coalesce_io_channel *coalesce_ch, struct spdk_bdev_io *bio_to_abort)
+{
+	struct coalesce_bdev_io *io_ctx = (struct coalesce_bdev_io *)bio_to_abort->driver_ctx;
+	struct coalesce_bdev_io *tmp_ctx;
+	struct coalesce_req *req;
+	TAILQ_HEAD(, coalesce_bdev_io) ios;
+	int i;
+
+	for (i = 0; i < COALESCE_QUEUE_COUNT; i++) {
+		req = coalesce_ch->open[i];
+		if (req == NULL) {
+			continue;
+		}
+
+		TAILQ_FOREACH(tmp_ctx, &req->ios, link) {
+			if (tmp_ctx == io_ctx) {
+				break;
+			}
+		}
+		if (tmp_ctx == NULL) {
+			continue;
+		}
+
+		TAILQ_INIT(&ios);
+		TAILQ_CONCAT(&ios, &req->ios, link);
+		TAILQ_REMOVE(&ios, io_ctx, link);
+		coalesce_ch->open[i] = NULL;
+		coalesce_put_req(req);
+
+		while ((tmp_ctx = TAILQ_FIRST(&ios))) {
+			TAILQ_REMOVE(&ios, tmp_ctx, link);
+			if (coalesce_queue_rw(coalesce_ch, spdk_bdev_io_from_ctx(tmp_ctx)) != 0) {
+				spdk_bdev_io_complete(spdk_bdev_io_from_ctx(tmp_ctx),
+						      SPDK_BDEV_IO_STATUS_FAILED);
+			}
+		}
+
+		spdk_bdev_io_complete(bio_to_abort, SPDK_BDEV_IO_STATUS_ABORTED);
+		return true;
+	}
+
+	return false;
+}
+
+static void
+vbdev_coalesce_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_io)
+{
+	struct vbdev_coalesce *coalesce_node = SPDK_CONTAINEROF(bdev_io->bdev, struct vbdev_coalesce,
+					       coalesce_bdev);
+	struct coalesce_io_channel *coalesce_ch = spdk_io_channel_get_ctx(ch);
+	struct coalesce_bdev_io *io_ctx = (struct coalesce_bdev_io *)bdev_io->driver_ctx;
+	int rc = 0;
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		spdk_bdev_io_get_buf(bdev_io, coalesce_read_get_buf_cb,
+				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
+		return;
+	case SPDK_BDEV_IO_TYPE_WRITE:
+		coalesce_submit_rw(ch, bdev_io);
+		return;
+	case SPDK_BDEV_IO_TYPE_ABORT:
+		if (coalesce_abort_queued_io(coalesce_ch, bdev_io->u.abort.bio_to_abort)) {
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+			return;
+		}
+		break;
+	default:
+		break;
+	}
+
+	/* Everything else is ordered after the reads and writes held on this channel. */
+	coalesce_flush_all(coalesce_ch);
+
+	switch (bdev_io->type) {
+	case SPDK_BDEV_IO_TYPE_WRITE_ZEROES:
+		rc = spdk_bdev_write_zeroes_blocks(coalesce_node->base_desc, coalesce_ch->base_ch,
+						   bdev_io->u.bdev.offset_blocks,
+						   bdev_io->u.bdev.num_blocks,
+						   _coalesce_complete_io, bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_UNMAP:
+		rc = spdk_bdev_unmap_blocks(coalesce_node->base_desc, coalesce_ch->base_ch,
+					    bdev_io->u.bdev.offset_blocks,
+					    bdev_io->u.bdev.num_blocks,
+					    _coalesce_complete_io, bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_FLUSH:
+		rc = spdk_bdev_flush_blocks(coalesce_node->base_desc, coalesce_ch->base_ch,
+					    bdev_io->u.bdev.offset_blocks,
+					    bdev_io->u.bdev.num_blocks,
+					    _coalesce_complete_io, bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_RESET:
+		rc = spdk_bdev_reset(coalesce_node->base_desc, coalesce_ch->base_ch,
+				     _coalesce_complete_io, bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_ABORT:
+		/* Only I/O that were passed down on their own can be found by the base bdev. */
+		rc = spdk_bdev_abort(coalesce_node->base_desc, coalesce_ch->base_ch,
+				     bdev_io->u.abort.bio_to_abort, _coalesce_complete_io, bdev_io);
+		break;
+	case SPDK_BDEV_IO_TYPE_COPY:
+		rc = spdk_bdev_copy_blocks(coalesce_node->base_desc, coalesce_ch->base_ch,
+					   bdev_io->u.bdev.offset_blocks,
+					   bdev_io->u.bdev.copy.src_offset_blocks,
+					   bdev_io->u.bdev.num_blocks,
+					   _coalesce_complete_io, bdev_io);
+		break;
+	default:
+		SPDK_ERRLOG("coalesce: unknown I/O type %d\n", bdev_io->type);
+		spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+	if (rc != 0) {
+		if (rc == -ENOMEM) {
+			SPDK_ERRLOG("No memory, start to queue io for coalesce.\n");
+			io_ctx->ch = ch;
+			vbdev_coalesce_queue_io(bdev_io);
+		} else {
+			SPDK_ERRLOG("ERROR on bdev_io submission!\n");
+			spdk_bdev_io_complete(bdev_io, SPDK_BDEV_IO_STATUS_FAILED);
+		}
+	}
+}
+
+static bool
+vbdev_coalesce_io_type_supported(void *ctx, enum spdk_bdev_io_type io_type)
+{
+	struct vbdev_coalesce *coalesce_node = (struct vbdev_coalesce *)ctx;
+
+	switch (io_type) {
+	case SPDK_BDEV_IO_TYPE_ZCOPY:
+		/* Zero copy buffers would bypass the coalescing queues. */
+		return false;
+	case SPDK_BDEV_IO_TYPE_ABORT:
+		/* I/O held in the coalescing queues can always be aborted. */
+		return true;
+	default:
+		return spdk_bdev_io_type_supported(coalesce_node->base_bdev, io_type);
+	}
+}
+
+static struct spdk_io_channel *
+vbdev_coalesce_get_io_channel(void *ctx)
+{
+	struct vbdev_coalesce *coalesce_node = (struct vbdev_coalesce *)ctx;
+
+	return spdk_get_io_channel(coalesce_node);
+}
+
+static void
+coalesce_write_opts_json(struct vbdev_coalesce *coalesce_node, struct spdk_json_write_ctx *w)
+{
+	spdk_json_write_named_uint64(w, "max_delay_us", coalesce_node->opts.max_delay_us);
+	spdk_json_write_named_uint32(w, "max_ios", coalesce_node->opts.max_ios);
+	spdk_json_write_named_uint32(w, "max_io_size_kib", coalesce_node->opts.max_io_size_kib);
+}
+
+/* This is the output for bdev_get_bdevs() for this vbdev */
+static int
+vbdev_coalesce_dump_info_json(void *ctx, struct spdk_json_write_ctx *w)
+{
+	struct vbdev_coalesce *coalesce_node = (struct vbdev_coalesce *)ctx;
+
+	spdk_json_write_name(w, "coalesce");
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&coalesce_node->coalesce_bdev));
+	spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(coalesce_node->base_bdev));
+	coalesce_write_opts_json(coalesce_node, w);
+	spdk_json_write_object_end(w);
+
+	return 0;
+}
+
+/* This is used to generate JSON that can configure this module to its current state. */
+static int
+vbdev_coalesce_config_json(struct spdk_json_write_ctx *w)
+{
+	struct vbdev_coalesce *coalesce_node;
+
+	TAILQ_FOREACH(coalesce_node, &g_coalesce_nodes, link) {
+		const struct spdk_uuid *uuid = spdk_bdev_get_uuid(&coalesce_node->coalesce_bdev);
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_string(w, "method", "bdev_coalesce_create");
+		spdk_json_write_named_object_begin(w, "params");
+		spdk_json_write_named_string(w, "base_bdev_name", spdk_bdev_get_name(coalesce_node->base_bdev));
+		spdk_json_write_named_string(w, "name", spdk_bdev_get_name(&coalesce_node->coalesce_bdev));
+		if (!spdk_uuid_is_null(uuid)) {
+			spdk_json_write_named_uuid(w, "uuid", uuid);
+		}
+		coalesce_write_opts_json(coalesce_node, w);
+		spdk_json_write_object_end(w);
+		spdk_json_write_object_end(w);
+	}
+	return 0;
+}
+
+static int
+coalesce_bdev_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	struct coalesce_io_channel *coalesce_ch = ctx_buf;
+	struct vbdev_coalesce *coalesce_node = io_device;
+	uint64_t period_us;
+
+	coalesce_ch->base_ch = spdk_bdev_get_io_channel(coalesce_node->base_desc);
+	if (coalesce_ch->base_ch == NULL) {
+		return -ENOMEM;
+	}
+
+	/* A period of 0 would make it a busy poller */
+	period_us = spdk_max(coalesce_node->opts.max_delay_us / VBDEV_COALESCE_POLLS_PER_DELAY, 1);
+	coalesce_ch->poller = SPDK_POLLER_REGISTER(coalesce_poll, coalesce_ch, period_us);
+	if (coalesce_ch->poller == NULL) {
+		spdk_put_io_channel(coalesce_ch->base_ch);
+		return -ENOMEM;
+	}
+	/* Only runs while there are held requests */
+	spdk_poller_pause(coalesce_ch->poller);
+
+	coalesce_ch->node = coalesce_node;
+	TAILQ_INIT(&coalesce_ch->free_reqs);
+
+	return 0;
+}
+
+static void
+coalesce_bdev_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+	struct coalesce_io_channel *coalesce_ch = ctx_buf;
+	struct coalesce_req *req;
+
+	/* Held I/O are outstanding for the bdev layer, so the channel can't go away while
+	 * there are any.
+	 */
+	assert(coalesce_ch->open[COALESCE_QUEUE_READ] == NULL);
+	assert(coalesce_ch->open[COALESCE_QUEUE_WRITE] == NULL);
+
+	while ((req = TAILQ_FIRST(&coalesce_ch->free_reqs))) {
+		TAILQ_REMOVE(&coalesce_ch->free_reqs, req, link);
+		free(req);
+	}
+
+	spdk_poller_unregister(&coalesce_ch->poller);
+	spdk_put_io_channel(coalesce_ch->base_ch);
+}
+
+static int
+vbdev_coalesce_insert_name(const char *bdev_name, const char *vbdev_name,
+			   const struct spdk_uuid *uuid, const struct vbdev_coalesce_opts *opts)
+{
+	struct bdev_names *name;
+
+	TAILQ_FOREACH(name, &g_bdev_names, link) {
+		if (strcmp(vbdev_name, name->vbdev_name) == 0) {
+			SPDK_ERRLOG("coalesce bdev %s already exists\n", vbdev_name);
+			return -EEXIST;
+		}
+	}
+
+	name = calloc(1, sizeof(struct bdev_names));
+	if (!name) {
+		SPDK_ERRLOG("could not allocate bdev_names\n");
+		return -ENOMEM;
+	}
+
+	name->bdev_name = strdup(bdev_name);
+	if (!name->bdev_name) {
+		SPDK_ERRLOG("could not allocate name->bdev_name\n");
+		free(name);
+		return -ENOMEM;
+	}
+
+	name->vbdev_name = strdup(vbdev_name);
+	if (!name->vbdev_name) {
+		SPDK_ERRLOG("could not allocate name->vbdev_name\n");
+		free(name->bdev_name);
+		free(name);
+		return -ENOMEM;
+	}
+
+	spdk_uuid_copy(&name->uuid, uuid);
+	name->opts = *opts;
+	TAILQ_INSERT_TAIL(&g_bdev_names, name, link);
+
+	return 0;
+}
+
+static int
+vbdev_coalesce_init(void)
+{
+	return 0;
+}
+
+static void
+vbdev_coalesce_finish(void)
+{
+	struct bdev_names *name;
+
+	while ((name = TAILQ_FIRST(&g_bdev_names))) {
+		TAILQ_REMOVE(&g_bdev_names, name, link);
+		free(name->bdev_name);
+		free(name->vbdev_name);
+		free(name);
+	}
+}
+
+static int
+vbdev_coalesce_get_ctx_size(void)
+{
+	return sizeof(struct coalesce_bdev_io);
+}
+
+static void
+vbdev_coalesce_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *w)
+{
+	/* No config per bdev needed */
+}
+
+static int
+vbdev_coalesce_get_memory_domains(void *ctx, struct spdk_memory_domain **domains, int array_size)
+{
+	struct vbdev_coalesce *coalesce_node = (struct vbdev_coalesce *)ctx;
+
+	/* I/O with a memory domain are passed to the base bdev as they are */
+	return spdk_bdev_get_memory_domains(coalesce_node->base_bdev, domains, array_size);
+}
+
+static const struct spdk_bdev_fn_table vbdev_coalesce_fn_table = {
+	.destruct		= vbdev_coalesce_destruct,
+	.submit_request		= vbdev_coalesce_submit_request,
+	.io_type_supported	= vbdev_coalesce_io_type_supported,
+	.get_io_channel		= vbdev_coalesce_get_io_channel,
+	.dump_info_json		= vbdev_coalesce_dump_info_json,
+	.write_config_json	= vbdev_coalesce_write_config_json,
+	.get_memory_domains	= vbdev_coalesce_get_memory_domains,
+};
+
+static void
+vbdev_coalesce_base_bdev_hotremove_cb(struct spdk_bdev *bdev_find)
+{
+	struct vbdev_coalesce *coalesce_node, *tmp;
+
+	TAILQ_FOREACH_SAFE(coalesce_node, &g_coalesce_nodes, link, tmp) {
+		if (bdev_find == coalesce_node->base_bdev) {
+			spdk_bdev_unregister(&coalesce_node->coalesce_bdev, NULL, NULL);
+		}
+	}
+}
+
+static void
+vbdev_coalesce_base_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev,
+				  void *event_ctx)
+{
+	switch (type) {
+	case SPDK_BDEV_EVENT_REMOVE:
+		vbdev_coalesce_base_bdev_hotremove_cb(bdev);
+		break;
+	default:
+		SPDK_NOTICELOG("Unsupported bdev event: type %d\n", type);
+		break;
+	}
+}
+
+/* Create and register the coalesce vbdev if we find it in our list of bdev names.
+ * This can be called either by the examine path or RPC method.
+ */
+static int
+vbdev_coalesce_register(const char *bdev_name)
+{
+	struct bdev_names *name;
+	struct vbdev_coalesce *coalesce_node;
+	struct spdk_bdev *bdev;
+	struct spdk_uuid ns_uuid;
+	int rc = 0;
+
+	spdk_uuid_parse(&ns_uuid, BDEV_COALESCE_NAMESPACE_UUID);
+
+	TAILQ_FOREACH(name, &g_bdev_names, link) {
+		if (strcmp(name->bdev_name, bdev_name) != 0) {
+			continue;
+		}
+
+		coalesce_node = calloc(1, sizeof(struct vbdev_coalesce));
+		if (!coalesce_node) {
+			rc = -ENOMEM;
+			SPDK_ERRLOG("could not allocate coalesce_node\n");
+			break;
+		}
+
+		coalesce_node->coalesce_bdev.name = strdup(name->vbdev_name);
+		if (!coalesce_node->coalesce_bdev.name) {
+			rc = -ENOMEM;
+			SPDK_ERRLOG("could not allocate coalesce_bdev name\n");
+			free(coalesce_node);
+			break;
+		}
+		coalesce_node->coalesce_bdev.product_name = "coalesce";
+
+		rc = spdk_bdev_open_ext(bdev_name, true, vbdev_coalesce_base_bdev_event_cb,
+					NULL, &coalesce_node->base_desc);
+		if (rc) {
+			if (rc != -ENODEV) {
+				SPDK_ERRLOG("could not open bdev %s\n", bdev_name);
+			}
+			free(coalesce_node->coalesce_bdev.name);
+			free(coalesce_node);
+			break;
+		}
+
+		bdev = spdk_bdev_desc_get_bdev(coalesce_node->base_desc);
+		coalesce_node->base_bdev = bdev;
+
+		if (!spdk_uuid_is_null(&name->uuid)) {
+			/* Use the configured UUID */
+			spdk_uuid_copy(&coalesce_node->coalesce_bdev.uuid, &name->uuid);
+		} else {
+			/* Generate UUID based on namespace UUID + base bdev UUID. */
+			rc = spdk_uuid_generate_sha1(&coalesce_node->coalesce_bdev.uuid, &ns_uuid,
+						     (const char *)&coalesce_node->base_bdev->uuid,
+						     sizeof(struct spdk_uuid));
+			if (rc) {
+				SPDK_ERRLOG("Unable to generate new UUID for coalesce bdev\n");
+				spdk_bdev_close(coalesce_node->base_desc);
+				free(coalesce_node->coalesce_bdev.name);
+				free(coalesce_node);
+				break;
+			}
+		}
+
+		coalesce_node->opts = name->opts;
+		coalesce_node->max_delay_ticks = name->opts.max_delay_us * spdk_get_ticks_hz() /
+						 SPDK_SEC_TO_USEC;
+		coalesce_node->max_blocks = spdk_max((uint64_t)name->opts.max_io_size_kib * 1024 /
+						     bdev->blocklen, 1);
+
+		/* Copy some properties from the underlying base bdev. */
+		coalesce_node->coalesce_bdev.write_cache = bdev->write_cache;
+		coalesce_node->coalesce_bdev.required_alignment = bdev->required_alignment;
+		coalesce_node->coalesce_bdev.optimal_io_boundary = bdev->optimal_io_boundary;
+		coalesce_node->coalesce_bdev.blocklen = bdev->blocklen;
+		coalesce_node->coalesce_bdev.blockcnt = bdev->blockcnt;
+
+		coalesce_node->coalesce_bdev.md_interleave = bdev->md_interleave;
+		coalesce_node->coalesce_bdev.md_len = bdev->md_len;
+		coalesce_node->coalesce_bdev.dif_type = bdev->dif_type;
+		coalesce_node->coalesce_bdev.dif_is_head_of_md = bdev->dif_is_head_of_md;
+		coalesce_node->coalesce_bdev.dif_check_flags = bdev->dif_check_flags;
+		coalesce_node->coalesce_bdev.dif_pi_format = bdev->dif_pi_format;
+
+		coalesce_node->coalesce_bdev.ctxt = coalesce_node;
+		coalesce_node->coalesce_bdev.fn_table = &vbdev_coalesce_fn_table;
+		coalesce_node->coalesce_bdev.module = &coalesce_if;
+		TAILQ_INSERT_TAIL(&g_coalesce_nodes, coalesce_node, link);
+
+		spdk_io_device_register(coalesce_node, coalesce_bdev_ch_create_cb,
+					coalesce_bdev_ch_destroy_cb,
+					sizeof(struct coalesce_io_channel),
+					name->vbdev_name);
+
+		/* Save the thread where the base device is opened */
+		coalesce_node->thread = spdk_get_thread();
+
+		rc = spdk_bdev_module_claim_bdev(bdev, coalesce_node->base_desc,
+						 coalesce_node->coalesce_bdev.module);
+		if (rc) {
+			SPDK_ERRLOG("could not claim bdev %s\n", bdev_name);
+			spdk_bdev_close(coalesce_node->base_desc);
+			TAILQ_REMOVE(&g_coalesce_nodes, coalesce_node, link);
+			spdk_io_device_unregister(coalesce_node, NULL);
+			free(coalesce_node->coalesce_bdev.name);
+			free(coalesce_node);
+			break;
+		}
+
+		rc = spdk_bdev_register(&coalesce_node->coalesce_bdev);
+		if (rc) {
+			SPDK_ERRLOG("could not register coalesce_bdev\n");
+			spdk_bdev_module_release_bdev(bdev);
+			spdk_bdev_close(coalesce_node->base_desc);
+			TAILQ_REMOVE(&g_coalesce_nodes, coalesce_node, link);
+			spdk_io_device_unregister(coalesce_node, NULL);
+			free(coalesce_node->coalesce_bdev.name);
+			free(coalesce_node);
+			break;
+		}
+		SPDK_NOTICELOG("created coalesce_bdev for: %s\n", name->vbdev_name);
+	}
+
+	return rc;
+}
+
+int
+bdev_coalesce_create_disk(const char *bdev_name, const char *vbdev_name,
+			  const struct spdk_uuid *uuid, const struct vbdev_coalesce_opts *opts)
+{
+	int rc;
+
+	if (opts->max_ios == 0 || opts->max_io_size_kib == 0) {
+		SPDK_ERRLOG("max_ios and max_io_size_kib must be greater than 0\n");
+		return -EINVAL;
+	}
+
+	/* Insert the bdev name into our global name list even if it doesn't exist yet,
+	 * it may show up soon...
+	 */
+	rc = vbdev_coalesce_insert_name(bdev_name, vbdev_name, uuid, opts);
+	if (rc) {
+		return rc;
+	}
+
+	rc = vbdev_coalesce_register(bdev_name);
+	if (rc == -ENODEV) {
+		/* This is not an error, we tracked the name above and it still
+		 * may show up later.
+		 */
+		SPDK_NOTICELOG("vbdev creation deferred pending base bdev arrival\n");
+		rc = 0;
+	}
+
+	return rc;
+}
+
+void
+bdev_coalesce_delete_disk(const char *bdev_name, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	struct bdev_names *name;
+	int rc;
+
+	/* Some cleanup happens in the destruct callback. */
+	rc = spdk_bdev_unregister_by_name(bdev_name, &coalesce_if, cb_fn, cb_arg);
+	if (rc == 0) {
+		/* Remove the association (vbdev, bdev) from g_bdev_names. This is required so that the
+		 * vbdev does not get re-created if the same bdev is constructed at some other time,
+		 * unless the underlying bdev was hot-removed.
+		 */
+		TAILQ_FOREACH(name, &g_bdev_names, link) {
+			if (strcmp(name->vbdev_name, bdev_name) == 0) {
+				TAILQ_REMOVE(&g_bdev_names, name, link);
+				free(name->bdev_name);
+				free(name->vbdev_name);
+				free(name);
+				break;
+			}
+		}
+	} else {
+		cb_fn(cb_arg, rc);
+	}
+}
+
+struct coalesce_get_stats_ctx {
+	struct vbdev_coalesce_stats	stats;
+	vbdev_coalesce_get_stats_cb	cb_fn;
+	void				*cb_arg;
+};
+
+static void
+coalesce_get_stats_channel(struct spdk_io_channel_iter *i)
+{
+	struct coalesce_get_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct coalesce_io_channel *coalesce_ch = spdk_io_channel_get_ctx(ch);
+	struct vbdev_coalesce_stats *stats = &coalesce_ch->stats;
+
+	ctx->stats.num_read_ops += stats->num_read_ops;
+	ctx->stats.num_write_ops += stats->num_write_ops;
+	ctx->stats.num_child_read_ops += stats->num_child_read_ops;
+	ctx->stats.num_child_write_ops += stats->num_child_write_ops;
+	ctx->stats.added_latency_ticks += stats->added_latency_ticks;
+	ctx->stats.max_added_latency_ticks = spdk_max(ctx->stats.max_added_latency_ticks,
+					     stats->max_added_latency_ticks);
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+coalesce_get_stats_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct coalesce_get_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	ctx->cb_fn(ctx->cb_arg, &ctx->stats, status);
+	free(ctx);
+}
+
+int
+bdev_coalesce_get_stats(const char *bdev_name, vbdev_coalesce_get_stats_cb cb_fn, void *cb_arg)
+{
+	struct vbdev_coalesce *coalesce_node;
+	struct coalesce_get_stats_ctx *ctx;
+
+	TAILQ_FOREACH(coalesce_node, &g_coalesce_nodes, link) {
+		if (strcmp(spdk_bdev_get_name(&coalesce_node->coalesce_bdev), bdev_name) == 0) {
+			break;
+		}
+	}
+	if (coalesce_node == NULL) {
+		return -ENODEV;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->cb_fn = cb_fn;
+	ctx->cb_arg = cb_arg;
+	spdk_for_each_channel(coalesce_node, coalesce_get_stats_channel, ctx, coalesce_get_stats_done);
+
+	return 0;
+}
+
+static void
+vbdev_coalesce_examine(struct spdk_bdev *bdev)
+{
+	vbdev_coalesce_register(bdev->name);
+
+	spdk_bdev_module_examine_done(&coalesce_if);
+}
+
+SPDK_LOG_REGISTER_COMPONENT(vbdev_coalesce)
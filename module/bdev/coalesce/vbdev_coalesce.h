@@ -0,0 +1,83 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+#ifndef SPDK_VBDEV_COALESCE_H
+#define SPDK_VBDEV_COALESCE_H
+
+#include "spdk/stdinc.h"
+
+#include "spdk/bdev.h"
+#include "spdk/bdev_module.h"
+
+#define VBDEV_COALESCE_DEFAULT_MAX_DELAY_US	10
+#define VBDEV_COALESCE_DEFAULT_MAX_IOS		32
+#define VBDEV_COALESCE_DEFAULT_MAX_IO_SIZE_KIB	128
+
+struct vbdev_coalesce_opts {
+	/* Longest time an I/O is held back waiting for adjacent I/O, in microseconds. */
+	uint64_t max_delay_us;
+	/* Number of I/O merged into one request after which it is submitted immediately. */
+	uint32_t max_ios;
+	/* Largest merged request, in KiB. */
+	uint32_t max_io_size_kib;
+};
+
+struct vbdev_coalesce_stats {
+	/* I/O received from the upper layer that went through the coalescing queues. */
+	uint64_t num_read_ops;
+	uint64_t num_write_ops;
+	/* Requests submitted to the base bdev for them. */
+	uint64_t num_child_read_ops;
+	uint64_t num_child_write_ops;
+	/* Time the I/O spent waiting in the coalescing queues. */
+	uint64_t added_latency_ticks;
+	uint64_t max_added_latency_ticks;
+};
+
+typedef void (*vbdev_coalesce_get_stats_cb)(void *cb_arg, const struct vbdev_coalesce_stats *stats,
+		int rc);
+
+/**
+ * Initialize coalesce options with their default values.
+ *
+ * \param opts Options to initialize.
+ */
+void bdev_coalesce_get_default_opts(struct vbdev_coalesce_opts *opts);
+
+/**
+ * Create new coalesce bdev.
+ *
+ * \param bdev_name Bdev on which coalesce vbdev will be created.
+ * \param vbdev_name Name of the coalesce bdev.
+ * \param uuid Optional UUID to assign to the coalesce bdev.
+ * \param opts Coalescing parameters.
+ * \return 0 on success, other on failure.
+ */
+int bdev_coalesce_create_disk(const char *bdev_name, const char *vbdev_name,
+			      const struct spdk_uuid *uuid, const struct vbdev_coalesce_opts *opts);
+
+/**
+ * Delete coalesce bdev.
+ *
+ * \param bdev_name Name of the coalesce bdev.
+ * \param cb_fn Function to call after deletion.
+ * \param cb_arg Argument to pass to cb_fn.
+ */
+void bdev_coalesce_delete_disk(const char *bdev_name, spdk_bdev_unregister_cb cb_fn,
+			       void *cb_arg);
+
+/**
+ * Collect the coalescing statistics of a coalesce bdev from all of its channels.
+ *
+ * \param bdev_name Name of the coalesce bdev.
+ * \param cb_fn Function to call with the statistics.
+ * \param cb_arg Argument to pass to cb_fn.
+ * \return 0 if the collection was started, -ENODEV if the bdev is not a coalesce bdev,
+ * -ENOMEM if out of memory.
+ */
+int bdev_coalesce_get_stats(const char *bdev_name, vbdev_coalesce_get_stats_cb cb_fn,
+			    void *cb_arg);
+
+#endif /* SPDK_VBDEV_COALESCE_H */
@@ -0,0 +1,180 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+#include "vbdev_coalesce.h"
+#include "spdk/env.h"
+#include "spdk/rpc.h"
+#include "spdk/util.h"
+#include "spdk/string.h"
+#include "spdk/log.h"
+
+struct rpc_bdev_coalesce_create {
+	char *base_bdev_name;
+	char *name;
+	struct spdk_uuid uuid;
+	struct vbdev_coalesce_opts opts;
+};
+
+static void
+free_rpc_bdev_coalesce_create(struct rpc_bdev_coalesce_create *r)
+{
+	free(r->base_bdev_name);
+	free(r->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_coalesce_create_decoders[] = {
+	{"base_bdev_name", offsetof(struct rpc_bdev_coalesce_create, base_bdev_name), spdk_json_decode_string},
+	{"name", offsetof(struct rpc_bdev_coalesce_create, name), spdk_json_decode_string},
+	{"uuid", offsetof(struct rpc_bdev_coalesce_create, uuid), spdk_json_decode_uuid, true},
+	{"max_delay_us", offsetof(struct rpc_bdev_coalesce_create, opts.max_delay_us), spdk_json_decode_uint64, true},
+	{"max_ios", offsetof(struct rpc_bdev_coalesce_create, opts.max_ios), spdk_json_decode_uint32, true},
+	{"max_io_size_kib", offsetof(struct rpc_bdev_coalesce_create, opts.max_io_size_kib), spdk_json_decode_uint32, true},
+};
+
+static void
+rpc_bdev_coalesce_create(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct rpc_bdev_coalesce_create req = {NULL};
+	struct spdk_json_write_ctx *w;
+	int rc;
+
+	bdev_coalesce_get_default_opts(&req.opts);
+
+	if (spdk_json_decode_object(params, rpc_bdev_coalesce_create_decoders,
+				    SPDK_COUNTOF(rpc_bdev_coalesce_create_decoders),
+				    &req)) {
+		SPDK_DEBUGLOG(vbdev_coalesce, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = bdev_coalesce_create_disk(req.base_bdev_name, req.name, &req.uuid, &req.opts);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_string(w, req.name);
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	free_rpc_bdev_coalesce_create(&req);
+}
+SPDK_RPC_REGISTER("bdev_coalesce_create", rpc_bdev_coalesce_create, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_coalesce_delete {
+	char *name;
+};
+
+static void
+free_rpc_bdev_coalesce_delete(struct rpc_bdev_coalesce_delete *req)
+{
+	free(req->name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_coalesce_delete_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_coalesce_delete, name), spdk_json_decode_string},
+};
+
+static void
+rpc_bdev_coalesce_delete_cb(void *cb_arg, int bdeverrno)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+
+	if (bdeverrno == 0) {
+		spdk_jsonrpc_send_bool_response(request, true);
+	} else {
+		spdk_jsonrpc_send_error_response(request, bdeverrno, spdk_strerror(-bdeverrno));
+	}
+}
+
+static void
+rpc_bdev_coalesce_delete(struct spdk_jsonrpc_request *request,
+			 const struct spdk_json_val *params)
+{
+	struct rpc_bdev_coalesce_delete req = {NULL};
+
+	if (spdk_json_decode_object(params, rpc_bdev_coalesce_delete_decoders,
+				    SPDK_COUNTOF(rpc_bdev_coalesce_delete_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	bdev_coalesce_delete_disk(req.name, rpc_bdev_coalesce_delete_cb, request);
+
+cleanup:
+	free_rpc_bdev_coalesce_delete(&req);
+}
+SPDK_RPC_REGISTER("bdev_coalesce_delete", rpc_bdev_coalesce_delete, SPDK_RPC_RUNTIME)
+
+struct rpc_bdev_coalesce_get_stats {
+	char *name;
+};
+
+static const struct spdk_json_object_decoder rpc_bdev_coalesce_get_stats_decoders[] = {
+	{"name", offsetof(struct rpc_bdev_coalesce_get_stats, name), spdk_json_decode_string},
+};
+
+static void
+rpc_bdev_coalesce_get_stats_cb(void *cb_arg, const struct vbdev_coalesce_stats *stats, int rc)
+{
+	struct spdk_jsonrpc_request *request = cb_arg;
+	struct spdk_json_write_ctx *w;
+	uint64_t num_ops, num_child_ops, ticks_hz = spdk_get_ticks_hz();
+
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+		return;
+	}
+
+	num_ops = stats->num_read_ops + stats->num_write_ops;
+	num_child_ops = stats->num_child_read_ops + stats->num_child_write_ops;
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "num_read_ops", stats->num_read_ops);
+	spdk_json_write_named_uint64(w, "num_write_ops", stats->num_write_ops);
+	spdk_json_write_named_uint64(w, "num_child_read_ops", stats->num_child_read_ops);
+	spdk_json_write_named_uint64(w, "num_child_write_ops", stats->num_child_write_ops);
+	spdk_json_write_named_double(w, "merge_ratio",
+				     num_child_ops ? (double)num_ops / num_child_ops : 0.0);
+	spdk_json_write_named_double(w, "avg_added_latency_us",
+				     num_ops ? (double)stats->added_latency_ticks * SPDK_SEC_TO_USEC /
+				     ticks_hz / num_ops : 0.0);
+	spdk_json_write_named_double(w, "max_added_latency_us",
+				     (double)stats->max_added_latency_ticks * SPDK_SEC_TO_USEC / ticks_hz);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+rpc_bdev_coalesce_get_stats(struct spdk_jsonrpc_request *request,
+			    const struct spdk_json_val *params)
+{
+	struct rpc_bdev_coalesce_get_stats req = {NULL};
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_coalesce_get_stats_decoders,
+				    SPDK_COUNTOF(rpc_bdev_coalesce_get_stats_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	rc = bdev_coalesce_get_stats(req.name, rpc_bdev_coalesce_get_stats_cb, request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	}
+
+cleanup:
+	free(req.name);
+}
+SPDK_RPC_REGISTER("bdev_coalesce_get_stats", rpc_bdev_coalesce_get_stats, SPDK_RPC_RUNTIME)
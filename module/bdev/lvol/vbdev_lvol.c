@@ -1241,6 +1241,54 @@ vbdev_lvol_create_snapshot(struct spdk_lvol *lvol, const char *snapshot_name,
 	spdk_lvol_create_snapshot(lvol, snapshot_name, _vbdev_lvol_create_cb, req);
 }
 
+struct vbdev_lvol_snapshot_group_req {
+	spdk_lvol_op_with_handles_complete	cb_fn;
+	void					*cb_arg;
+};
+
+static void
+_vbdev_lvol_create_snapshot_group_cb(void *cb_arg, struct spdk_lvol **lvols, uint32_t count,
+				     int lvolerrno)
+{
+	struct vbdev_lvol_snapshot_group_req *req = cb_arg;
+	uint32_t i;
+	int rc;
+
+	for (i = 0; i < count; i++) {
+		if (lvols[i] == NULL) {
+			continue;
+		}
+
+		rc = _create_lvol_disk(lvols[i], true);
+		if (rc != 0 && lvolerrno == 0) {
+			lvolerrno = rc;
+		}
+	}
+
+	req->cb_fn(req->cb_arg, lvols, count, lvolerrno);
+	free(req);
+}
+
+void
+vbdev_lvol_create_snapshot_group(struct spdk_lvol **lvols, const char **snapshot_names,
+				 uint32_t count, spdk_lvol_op_with_handles_complete cb_fn,
+				 void *cb_arg)
+{
+	struct vbdev_lvol_snapshot_group_req *req;
+
+	req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		cb_fn(cb_arg, NULL, 0, -ENOMEM);
+		return;
+	}
+
+	req->cb_fn = cb_fn;
+	req->cb_arg = cb_arg;
+
+	spdk_lvol_create_snapshot_group(lvols, snapshot_names, count,
+					_vbdev_lvol_create_snapshot_group_cb, req);
+}
+
 void
 vbdev_lvol_create_clone(struct spdk_lvol *lvol, const char *clone_name,
 			spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg)
@@ -1965,7 +2013,8 @@ _vbdev_lvol_shallow_copy_cb(void *cb_arg, int lvolerrno)
 }
 
 int
-vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, const char *bdev_name,
+vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_lvol *ancestor,
+			const char *bdev_name,
 			spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
 			spdk_lvol_op_complete cb_fn, void *cb_arg)
 {
@@ -2012,8 +2061,13 @@ vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, const char *bdev_name,
 	req->lvol = lvol;
 	req->ext_dev = ext_dev;
 
-	rc = spdk_lvol_shallow_copy(lvol, ext_dev, status_cb_fn, status_cb_arg, _vbdev_lvol_shallow_copy_cb,
-				    req);
+	if (ancestor != NULL) {
+		rc = spdk_lvol_shallow_copy_incremental(lvol, ancestor, ext_dev, status_cb_fn, status_cb_arg,
+							_vbdev_lvol_shallow_copy_cb, req);
+	} else {
+		rc = spdk_lvol_shallow_copy(lvol, ext_dev, status_cb_fn, status_cb_arg,
+					    _vbdev_lvol_shallow_copy_cb, req);
+	}
 
 	if (rc < 0) {
 		ext_dev->destroy(ext_dev);
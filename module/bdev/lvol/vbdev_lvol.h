@@ -42,6 +42,10 @@ int vbdev_lvol_create(struct spdk_lvol_store *lvs, const char *name, uint64_t sz
 void vbdev_lvol_create_snapshot(struct spdk_lvol *lvol, const char *snapshot_name,
 				spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg);
 
+void vbdev_lvol_create_snapshot_group(struct spdk_lvol **lvols, const char **snapshot_names,
+				      uint32_t count, spdk_lvol_op_with_handles_complete cb_fn,
+				      void *cb_arg);
+
 void vbdev_lvol_create_clone(struct spdk_lvol *lvol, const char *clone_name,
 			     spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg);
 void vbdev_lvol_create_bdev_clone(const char *esnap_uuid,
@@ -120,6 +124,8 @@ int vbdev_lvol_esnap_dev_create(void *bs_ctx, void *blob_ctx, struct spdk_blob *
  * \brief Make a shallow copy of lvol over a bdev
  *
  * \param lvol Handle to lvol
+ * \param ancestor Handle to a snapshot in the chain of lvol to copy only the clusters changed
+ * since it, or NULL to copy all the clusters allocated to lvol
  * \param bdev_name Name of the bdev to copy on
  * \param status_cb_fn Called repeatedly during operation with status updates
  * \param status_cb_arg Argument passed to function status_cb_fn.
@@ -128,7 +134,8 @@ int vbdev_lvol_esnap_dev_create(void *bs_ctx, void *blob_ctx, struct spdk_blob *
  *
  * \return 0 if operation starts correctly, negative errno on failure.
  */
-int vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, const char *bdev_name,
+int vbdev_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_lvol *ancestor,
+			    const char *bdev_name,
 			    spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
 			    spdk_lvol_op_complete cb_fn, void *cb_arg);
 
@@ -7,6 +7,7 @@
 #include "spdk/rpc.h"
 #include "spdk/bdev.h"
 #include "spdk/util.h"
+#include "spdk/bit_array.h"
 #include "vbdev_lvol.h"
 #include "spdk/string.h"
 #include "spdk/log.h"
@@ -457,6 +458,135 @@ cleanup:
 
 SPDK_RPC_REGISTER("bdev_lvol_snapshot", rpc_bdev_lvol_snapshot, SPDK_RPC_RUNTIME)
 
+#define RPC_MAX_SNAPSHOT_GROUP_SIZE 256
+
+struct rpc_bdev_lvol_snapshot_group {
+	size_t				num_snapshots;
+	struct rpc_bdev_lvol_snapshot	snapshots[RPC_MAX_SNAPSHOT_GROUP_SIZE];
+};
+
+static void
+free_rpc_bdev_lvol_snapshot_group(struct rpc_bdev_lvol_snapshot_group *req)
+{
+	size_t i;
+
+	for (i = 0; i < req->num_snapshots; i++) {
+		free_rpc_bdev_lvol_snapshot(&req->snapshots[i]);
+	}
+}
+
+static int
+decode_rpc_bdev_lvol_snapshot(const struct spdk_json_val *val, void *out)
+{
+	return spdk_json_decode_object(val, rpc_bdev_lvol_snapshot_decoders,
+				       SPDK_COUNTOF(rpc_bdev_lvol_snapshot_decoders), out);
+}
+
+static int
+decode_rpc_bdev_lvol_snapshots(const struct spdk_json_val *val, void *out)
+{
+	struct rpc_bdev_lvol_snapshot_group *req = out;
+
+	return spdk_json_decode_array(val, decode_rpc_bdev_lvol_snapshot, req->snapshots,
+				      RPC_MAX_SNAPSHOT_GROUP_SIZE, &req->num_snapshots,
+				      sizeof(struct rpc_bdev_lvol_snapshot));
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_snapshot_group_decoders[] = {
+	{"snapshots", 0, decode_rpc_bdev_lvol_snapshots},
+};
+
+static void
+rpc_bdev_lvol_snapshot_group_cb(void *cb_arg, struct spdk_lvol **lvols, uint32_t count,
+				int lvolerrno)
+{
+	struct spdk_json_write_ctx *w;
+	struct spdk_jsonrpc_request *request = cb_arg;
+	uint32_t i;
+
+	if (lvolerrno != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 spdk_strerror(-lvolerrno));
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_array_begin(w);
+	for (i = 0; i < count; i++) {
+		spdk_json_write_string(w, lvols[i]->unique_id);
+	}
+	spdk_json_write_array_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+static void
+rpc_bdev_lvol_snapshot_group(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_snapshot_group *req;
+	struct spdk_lvol *lvols[RPC_MAX_SNAPSHOT_GROUP_SIZE];
+	const char *snapshot_names[RPC_MAX_SNAPSHOT_GROUP_SIZE];
+	struct spdk_bdev *bdev;
+	size_t i, j;
+
+	SPDK_INFOLOG(lvol_rpc, "Snapshotting a group of blobs\n");
+
+	req = calloc(1, sizeof(*req));
+	if (req == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENOMEM, spdk_strerror(ENOMEM));
+		return;
+	}
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_snapshot_group_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_snapshot_group_decoders),
+				    req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	if (req->num_snapshots == 0) {
+		spdk_jsonrpc_send_error_response(request, -EINVAL, spdk_strerror(EINVAL));
+		goto cleanup;
+	}
+
+	for (i = 0; i < req->num_snapshots; i++) {
+		bdev = spdk_bdev_get_by_name(req->snapshots[i].lvol_name);
+		if (bdev == NULL) {
+			SPDK_INFOLOG(lvol_rpc, "bdev '%s' does not exist\n", req->snapshots[i].lvol_name);
+			spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+			goto cleanup;
+		}
+
+		lvols[i] = vbdev_lvol_get_from_bdev(bdev);
+		if (lvols[i] == NULL) {
+			SPDK_ERRLOG("lvol does not exist\n");
+			spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+			goto cleanup;
+		}
+
+		for (j = 0; j < i; j++) {
+			if (lvols[j] == lvols[i]) {
+				SPDK_ERRLOG("lvol '%s' is given more than once\n", req->snapshots[i].lvol_name);
+				spdk_jsonrpc_send_error_response(request, -EINVAL, spdk_strerror(EINVAL));
+				goto cleanup;
+			}
+		}
+
+		snapshot_names[i] = req->snapshots[i].snapshot_name;
+	}
+
+	vbdev_lvol_create_snapshot_group(lvols, snapshot_names, req->num_snapshots,
+					 rpc_bdev_lvol_snapshot_group_cb, request);
+
+cleanup:
+	free_rpc_bdev_lvol_snapshot_group(req);
+	free(req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_snapshot_group", rpc_bdev_lvol_snapshot_group, SPDK_RPC_RUNTIME)
+
 struct rpc_bdev_lvol_clone {
 	char *snapshot_name;
 	char *clone_name;
@@ -1315,6 +1445,7 @@ SPDK_RPC_REGISTER("bdev_lvol_grow_lvstore", rpc_bdev_lvol_grow_lvstore, SPDK_RPC
 struct rpc_bdev_lvol_shallow_copy {
 	char *src_lvol_name;
 	char *dst_bdev_name;
+	char *ancestor_lvol_name;
 };
 
 struct rpc_bdev_lvol_shallow_copy_ctx {
@@ -1327,11 +1458,13 @@ free_rpc_bdev_lvol_shallow_copy(struct rpc_bdev_lvol_shallow_copy *req)
 {
 	free(req->src_lvol_name);
 	free(req->dst_bdev_name);
+	free(req->ancestor_lvol_name);
 }
 
 static const struct spdk_json_object_decoder rpc_bdev_lvol_shallow_copy_decoders[] = {
 	{"src_lvol_name", offsetof(struct rpc_bdev_lvol_shallow_copy, src_lvol_name), spdk_json_decode_string},
 	{"dst_bdev_name", offsetof(struct rpc_bdev_lvol_shallow_copy, dst_bdev_name), spdk_json_decode_string},
+	{"ancestor_lvol_name", offsetof(struct rpc_bdev_lvol_shallow_copy, ancestor_lvol_name), spdk_json_decode_string, true},
 };
 
 static void
@@ -1358,8 +1491,9 @@ rpc_bdev_lvol_start_shallow_copy(struct spdk_jsonrpc_request *request,
 {
 	struct rpc_bdev_lvol_shallow_copy req = {};
 	struct rpc_bdev_lvol_shallow_copy_ctx *ctx;
-	struct spdk_lvol *src_lvol;
-	struct spdk_bdev *src_lvol_bdev;
+	struct spdk_lvol *src_lvol, *ancestor_lvol = NULL;
+	struct spdk_bdev *src_lvol_bdev, *ancestor_lvol_bdev;
+	struct spdk_bit_array *changed = NULL;
 	struct rpc_shallow_copy_status *status;
 	struct spdk_json_write_ctx *w;
 	int rc;
@@ -1389,6 +1523,29 @@ rpc_bdev_lvol_start_shallow_copy(struct spdk_jsonrpc_request *request,
 		goto cleanup;
 	}
 
+	if (req.ancestor_lvol_name != NULL) {
+		ancestor_lvol_bdev = spdk_bdev_get_by_name(req.ancestor_lvol_name);
+		if (ancestor_lvol_bdev == NULL) {
+			SPDK_ERRLOG("lvol bdev '%s' does not exist\n", req.ancestor_lvol_name);
+			spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+			goto cleanup;
+		}
+
+		ancestor_lvol = vbdev_lvol_get_from_bdev(ancestor_lvol_bdev);
+		if (ancestor_lvol == NULL) {
+			SPDK_ERRLOG("ancestor lvol does not exist\n");
+			spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+			goto cleanup;
+		}
+
+		rc = spdk_lvol_get_changed_clusters(src_lvol, ancestor_lvol, &changed);
+		if (rc != 0) {
+			spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+							 spdk_strerror(-rc));
+			goto cleanup;
+		}
+	}
+
 	status = calloc(1, sizeof(*status));
 	if (status == NULL) {
 		SPDK_ERRLOG("Cannot allocate status entry for shallow copy of '%s'\n", req.src_lvol_name);
@@ -1397,7 +1554,11 @@ rpc_bdev_lvol_start_shallow_copy(struct spdk_jsonrpc_request *request,
 	}
 
 	status->operation_id = ++g_shallow_copy_count;
-	status->total_clusters = spdk_blob_get_num_allocated_clusters(src_lvol->blob);
+	if (changed != NULL) {
+		status->total_clusters = spdk_bit_array_count_set(changed);
+	} else {
+		status->total_clusters = spdk_blob_get_num_allocated_clusters(src_lvol->blob);
+	}
 
 	ctx = calloc(1, sizeof(*ctx));
 	if (ctx == NULL) {
@@ -1410,7 +1571,7 @@ rpc_bdev_lvol_start_shallow_copy(struct spdk_jsonrpc_request *request,
 	ctx->status = status;
 
 	LIST_INSERT_HEAD(&g_shallow_copy_status_list, status, link);
-	rc = vbdev_lvol_shallow_copy(src_lvol, req.dst_bdev_name,
+	rc = vbdev_lvol_shallow_copy(src_lvol, ancestor_lvol, req.dst_bdev_name,
 				     rpc_bdev_lvol_shallow_copy_status_cb, status,
 				     rpc_bdev_lvol_shallow_copy_cb, ctx);
 
@@ -1431,6 +1592,7 @@ rpc_bdev_lvol_start_shallow_copy(struct spdk_jsonrpc_request *request,
 	}
 
 cleanup:
+	spdk_bit_array_free(&changed);
 	free_rpc_bdev_lvol_shallow_copy(&req);
 }
 
@@ -1519,6 +1681,120 @@ cleanup:
 SPDK_RPC_REGISTER("bdev_lvol_check_shallow_copy", rpc_bdev_lvol_check_shallow_copy,
 		  SPDK_RPC_RUNTIME)
 
+struct rpc_bdev_lvol_get_changed_clusters {
+	char *lvol_name;
+	char *ancestor_name;
+};
+
+static void
+free_rpc_bdev_lvol_get_changed_clusters(struct rpc_bdev_lvol_get_changed_clusters *req)
+{
+	free(req->lvol_name);
+	free(req->ancestor_name);
+}
+
+static const struct spdk_json_object_decoder rpc_bdev_lvol_get_changed_clusters_decoders[] = {
+	{"lvol_name", offsetof(struct rpc_bdev_lvol_get_changed_clusters, lvol_name), spdk_json_decode_string},
+	{"ancestor_name", offsetof(struct rpc_bdev_lvol_get_changed_clusters, ancestor_name), spdk_json_decode_string, true},
+};
+
+static void
+rpc_bdev_lvol_get_changed_clusters(struct spdk_jsonrpc_request *request,
+				   const struct spdk_json_val *params)
+{
+	struct rpc_bdev_lvol_get_changed_clusters req = {};
+	struct spdk_lvol *lvol, *ancestor = NULL;
+	struct spdk_bdev *lvol_bdev, *ancestor_bdev;
+	struct spdk_bit_array *changed = NULL;
+	struct spdk_json_write_ctx *w;
+	uint32_t start, end;
+	int rc;
+
+	SPDK_INFOLOG(lvol_rpc, "Getting changed clusters of lvol\n");
+
+	if (spdk_json_decode_object(params, rpc_bdev_lvol_get_changed_clusters_decoders,
+				    SPDK_COUNTOF(rpc_bdev_lvol_get_changed_clusters_decoders),
+				    &req)) {
+		SPDK_INFOLOG(lvol_rpc, "spdk_json_decode_object failed\n");
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	lvol_bdev = spdk_bdev_get_by_name(req.lvol_name);
+	if (lvol_bdev == NULL) {
+		SPDK_ERRLOG("lvol bdev '%s' does not exist\n", req.lvol_name);
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	lvol = vbdev_lvol_get_from_bdev(lvol_bdev);
+	if (lvol == NULL) {
+		SPDK_ERRLOG("lvol does not exist\n");
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		goto cleanup;
+	}
+
+	if (req.ancestor_name != NULL) {
+		ancestor_bdev = spdk_bdev_get_by_name(req.ancestor_name);
+		if (ancestor_bdev == NULL) {
+			SPDK_ERRLOG("lvol bdev '%s' does not exist\n", req.ancestor_name);
+			spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+			goto cleanup;
+		}
+
+		ancestor = vbdev_lvol_get_from_bdev(ancestor_bdev);
+		if (ancestor == NULL) {
+			SPDK_ERRLOG("ancestor lvol does not exist\n");
+			spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+			goto cleanup;
+		}
+	}
+
+	rc = spdk_lvol_get_changed_clusters(lvol, ancestor, &changed);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INVALID_PARAMS,
+						 spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_uint64(w, "cluster_size",
+				     spdk_bs_get_cluster_size(lvol->lvol_store->blobstore));
+	spdk_json_write_named_uint64(w, "num_clusters", spdk_blob_get_num_clusters(lvol->blob));
+	spdk_json_write_named_uint64(w, "num_changed_clusters", spdk_bit_array_count_set(changed));
+
+	/* Report runs of consecutive clusters rather than single clusters to keep the answer small */
+	spdk_json_write_named_array_begin(w, "changed_clusters");
+	start = spdk_bit_array_find_first_set(changed, 0);
+	while (start != UINT32_MAX) {
+		end = spdk_bit_array_find_first_clear(changed, start);
+		if (end == UINT32_MAX) {
+			end = spdk_bit_array_capacity(changed);
+		}
+
+		spdk_json_write_object_begin(w);
+		spdk_json_write_named_uint32(w, "start", start);
+		spdk_json_write_named_uint32(w, "count", end - start);
+		spdk_json_write_object_end(w);
+
+		start = spdk_bit_array_find_first_set(changed, end);
+	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+
+	spdk_jsonrpc_end_result(request, w);
+
+cleanup:
+	spdk_bit_array_free(&changed);
+	free_rpc_bdev_lvol_get_changed_clusters(&req);
+}
+
+SPDK_RPC_REGISTER("bdev_lvol_get_changed_clusters", rpc_bdev_lvol_get_changed_clusters,
+		  SPDK_RPC_RUNTIME)
+
 struct rpc_bdev_lvol_set_parent {
 	char *lvol_name;
 	char *parent_name;
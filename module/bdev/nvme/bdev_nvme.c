@@ -1539,10 +1539,10 @@ bdev_nvme_clear_io_path_caches(struct nvme_ctrlr *nvme_ctrlr)
 	nvme_ctrlr->io_path_cache_clearing = true;
 	pthread_mutex_unlock(&nvme_ctrlr->mutex);
 
-	spdk_for_each_channel(nvme_ctrlr,
-			      bdev_nvme_clear_io_path_cache,
-			      NULL,
-			      bdev_nvme_clear_io_path_caches_done);
+	spdk_for_each_channel_parallel(nvme_ctrlr,
+				       bdev_nvme_clear_io_path_cache,
+				       NULL,
+				       bdev_nvme_clear_io_path_caches_done);
 }
 
 static struct nvme_qpair *
@@ -1189,6 +1189,12 @@ rpc_bdev_nvme_rdma_stats(struct spdk_json_write_ctx *w,
 		spdk_json_write_named_uint64(w, "send_doorbell_updates", device_stats->send_doorbell_updates);
 		spdk_json_write_named_uint64(w, "total_recv_wrs", device_stats->total_recv_wrs);
 		spdk_json_write_named_uint64(w, "recv_doorbell_updates", device_stats->recv_doorbell_updates);
+		if (device_stats->srq_size != 0) {
+			spdk_json_write_named_uint64(w, "srq_size", device_stats->srq_size);
+			spdk_json_write_named_uint64(w, "srq_rsps", device_stats->srq_rsps);
+			spdk_json_write_named_uint64(w, "srq_queue_depth", device_stats->srq_queue_depth);
+			spdk_json_write_named_uint64(w, "srq_reclaimed_recvs", device_stats->srq_reclaimed_recvs);
+		}
 		spdk_json_write_object_end(w);
 	}
 	spdk_json_write_array_end(w);
@@ -19,6 +19,8 @@
 #define RAID_BDEV_PROCESS_WINDOW_SIZE_KB_DEFAULT	1024
 #define RAID_BDEV_PROCESS_MAX_BANDWIDTH_MB_SEC_DEFAULT	0
 
+#define RAID_BDEV_WI_BITMAP_CLEAR_PERIOD_US	(5 * 1000 * 1000)
+
 static bool g_shutdown_started = false;
 
 /* List of all raid bdevs */
@@ -34,6 +36,9 @@ struct raid_bdev_io_channel {
 	/* Array of IO channels of base bdevs */
 	struct spdk_io_channel	**base_channel;
 
+	/* Number of entries in base_channel, may lag behind num_base_bdevs while growing */
+	uint8_t			num_base_channels;
+
 	/* Private raid module IO channel */
 	struct spdk_io_channel	*module_channel;
 
@@ -73,7 +78,9 @@ struct raid_bdev_process {
 	uint64_t			window_remaining;
 	int				window_status;
 	uint64_t			window_offset;
+	uint64_t			window_range_size;
 	bool				window_range_locked;
+	bool				wi_bitmap_resync;
 	struct raid_base_bdev_info	*target;
 	int				status;
 	TAILQ_HEAD(, raid_process_finish_action) finish_actions;
@@ -168,6 +175,23 @@ raid_bdev_channel_get_base_info(struct raid_bdev_io_channel *raid_ch, struct spd
 	return NULL;
 }
 
+/*
+ * Returns the number of base bdevs the data of the raid_io is laid out across. This is
+ * the number from before the reshape if the raid_io targets the range not yet restriped.
+ */
+uint8_t
+raid_bdev_io_get_num_base_bdevs(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+
+	if (spdk_unlikely(raid_bdev->reshape.num_base_bdevs_old != 0) &&
+	    raid_io->raid_ch->process.offset != RAID_OFFSET_BLOCKS_INVALID) {
+		return raid_bdev->reshape.num_base_bdevs_old;
+	}
+
+	return raid_bdev->num_base_bdevs;
+}
+
 /* Function declarations */
 static void	raid_bdev_examine(struct spdk_bdev *bdev);
 static int	raid_bdev_init(void);
@@ -191,23 +215,26 @@ raid_bdev_ch_process_cleanup(struct raid_bdev_io_channel *raid_ch)
 	}
 }
 
+/*
+ * Split the channel into the processed and unprocessed ranges. A reshape has no process
+ * target and the split is at the reshape offset, which is advanced before the channels
+ * are updated. The process is NULL if the reshape is pending but not running.
+ */
 static int
 raid_bdev_ch_process_setup(struct raid_bdev_io_channel *raid_ch, struct raid_bdev_process *process)
 {
-	struct raid_bdev *raid_bdev = process->raid_bdev;
+	struct raid_bdev *raid_bdev = spdk_io_channel_get_io_device(spdk_io_channel_from_ctx(raid_ch));
+	struct raid_base_bdev_info *target = process ? process->target : NULL;
 	struct raid_bdev_io_channel *raid_ch_processed;
 	struct raid_base_bdev_info *base_info;
 
-	raid_ch->process.offset = process->window_offset;
+	raid_ch->process.offset = target ? process->window_offset : raid_bdev->reshape.offset;
 
-	/* In the future we may have other types of processes which don't use a target bdev,
-	 * like data scrubbing or strip size migration. Until then, expect that there always is
-	 * a process target. */
-	assert(process->target != NULL);
-
-	raid_ch->process.target_ch = spdk_bdev_get_io_channel(process->target->desc);
-	if (raid_ch->process.target_ch == NULL) {
-		goto err;
+	if (target != NULL) {
+		raid_ch->process.target_ch = spdk_bdev_get_io_channel(target->desc);
+		if (raid_ch->process.target_ch == NULL) {
+			goto err;
+		}
 	}
 
 	raid_ch_processed = calloc(1, sizeof(*raid_ch_processed));
@@ -225,7 +252,7 @@ raid_bdev_ch_process_setup(struct raid_bdev_io_channel *raid_ch, struct raid_bde
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
 		uint8_t slot = raid_bdev_base_bdev_slot(base_info);
 
-		if (base_info != process->target) {
+		if (base_info != target) {
 			raid_ch_processed->base_channel[slot] = raid_ch->base_channel[slot];
 		} else {
 			raid_ch_processed->base_channel[slot] = raid_ch->process.target_ch;
@@ -270,6 +297,7 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 		SPDK_ERRLOG("Unable to allocate base bdevs io channel\n");
 		return -ENOMEM;
 	}
+	raid_ch->num_base_channels = raid_bdev->num_base_bdevs;
 
 	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
 		/*
@@ -299,7 +327,7 @@ raid_bdev_create_cb(void *io_device, void *ctx_buf)
 		}
 	}
 
-	if (raid_bdev->process != NULL) {
+	if (raid_bdev->process != NULL || raid_bdev->reshape.num_base_bdevs_old != 0) {
 		ret = raid_bdev_ch_process_setup(raid_ch, raid_bdev->process);
 		if (ret != 0) {
 			SPDK_ERRLOG("Failed to setup process io channel\n");
@@ -336,7 +364,6 @@ err:
 static void
 raid_bdev_destroy_cb(void *io_device, void *ctx_buf)
 {
-	struct raid_bdev *raid_bdev = io_device;
 	struct raid_bdev_io_channel *raid_ch = ctx_buf;
 	uint8_t i;
 
@@ -349,7 +376,7 @@ raid_bdev_destroy_cb(void *io_device, void *ctx_buf)
 		spdk_put_io_channel(raid_ch->module_channel);
 	}
 
-	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+	for (i = 0; i < raid_ch->num_base_channels; i++) {
 		/* Free base bdev channels */
 		if (raid_ch->base_channel[i] != NULL) {
 			spdk_put_io_channel(raid_ch->base_channel[i]);
@@ -388,9 +415,12 @@ raid_bdev_cleanup(struct raid_bdev *raid_bdev)
 	TAILQ_REMOVE(&g_raid_bdev_list, raid_bdev, global_link);
 }
 
+static void raid_bdev_wi_bitmap_stop(struct raid_bdev *raid_bdev);
+
 static void
 raid_bdev_free(struct raid_bdev *raid_bdev)
 {
+	raid_bdev_wi_bitmap_stop(raid_bdev);
 	raid_bdev_free_superblock(raid_bdev);
 	free(raid_bdev->base_bdev_info);
 	free(raid_bdev->bdev.name);
@@ -438,6 +468,7 @@ raid_bdev_free_base_bdev_resource(struct raid_base_bdev_info *base_info)
 		spdk_uuid_set_null(&base_info->uuid);
 	}
 	base_info->is_failed = false;
+	base_info->wi_bitmap_resync = false;
 
 	/* clear `data_offset` to allow it to be recalculated during configuration */
 	base_info->data_offset = 0;
@@ -600,6 +631,170 @@ raid_bdev_verify_dix_reftag(struct iovec *iovs, int iovcnt, void *md_buf,
 	return rc;
 }
 
+static inline uint64_t
+raid_bdev_wi_bitmap_region(const struct raid_bdev_wi_bitmap *wi_bitmap, uint64_t offset_blocks)
+{
+	/* the last region also covers the blocks added by growing the raid bdev */
+	return spdk_min(offset_blocks >> wi_bitmap->region_shift, wi_bitmap->num_regions - 1);
+}
+
+static inline bool
+raid_bdev_wi_bitmap_test(struct raid_bdev_wi_bitmap *wi_bitmap, uint64_t region)
+{
+	return __atomic_load_n(&wi_bitmap->bits[region / 64], __ATOMIC_SEQ_CST) &
+	       (1ULL << (region % 64));
+}
+
+static void
+raid_bdev_wi_bitmap_buf_update(struct raid_bdev_wi_bitmap *wi_bitmap, uint64_t region, bool set)
+{
+	uint64_t block = (region / 64) * sizeof(uint64_t) / wi_bitmap->block_size;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	if (set) {
+		wi_bitmap->buf[region / 64] |= 1ULL << (region % 64);
+	} else {
+		wi_bitmap->buf[region / 64] &= ~(1ULL << (region % 64));
+	}
+
+	wi_bitmap->dirty_start = spdk_min(wi_bitmap->dirty_start, block);
+	wi_bitmap->dirty_end = spdk_max(wi_bitmap->dirty_end, block + 1);
+}
+
+static void raid_bdev_wi_bitmap_flush(struct raid_bdev *raid_bdev);
+
+static void
+raid_bdev_wi_bitmap_flush_done(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	struct raid_bdev_wi_bitmap *wi_bitmap = raid_bdev->wi_bitmap;
+	struct spdk_bdev_io_wait_entry *entry;
+	struct raid_bdev_io *raid_io;
+	uint64_t region, last;
+
+	if (status != 0) {
+		/*
+		 * Writes are not held back on error - a base bdev that failed to persist the
+		 * bitmap will fail the data writes as well and get removed from the raid.
+		 */
+		SPDK_ERRLOG("Failed to write raid bdev '%s' write-intent bitmap: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+	}
+
+	wi_bitmap->write_in_progress = false;
+
+	while ((entry = TAILQ_FIRST(&wi_bitmap->waiters_writing)) != NULL) {
+		TAILQ_REMOVE(&wi_bitmap->waiters_writing, entry, link);
+		raid_io = entry->cb_arg;
+
+		region = raid_bdev_wi_bitmap_region(wi_bitmap, raid_io->offset_blocks);
+		last = raid_bdev_wi_bitmap_region(wi_bitmap, raid_io->offset_blocks + raid_io->num_blocks - 1);
+		for (; region <= last; region++) {
+			__atomic_fetch_or(&wi_bitmap->bits[region / 64], 1ULL << (region % 64), __ATOMIC_SEQ_CST);
+		}
+
+		spdk_thread_send_msg(spdk_io_channel_get_thread(spdk_io_channel_from_ctx(raid_io->raid_ch)),
+				     entry->cb_fn, raid_io);
+	}
+
+	raid_bdev_wi_bitmap_flush(raid_bdev);
+}
+
+static void
+raid_bdev_wi_bitmap_flush(struct raid_bdev *raid_bdev)
+{
+	struct raid_bdev_wi_bitmap *wi_bitmap = raid_bdev->wi_bitmap;
+
+	if (wi_bitmap->write_in_progress ||
+	    (TAILQ_EMPTY(&wi_bitmap->waiters) && wi_bitmap->dirty_start >= wi_bitmap->dirty_end)) {
+		return;
+	}
+
+	wi_bitmap->write_in_progress = true;
+	TAILQ_SWAP(&wi_bitmap->waiters, &wi_bitmap->waiters_writing, spdk_bdev_io_wait_entry, link);
+
+	raid_bdev_write_wi_bitmap(raid_bdev, raid_bdev_wi_bitmap_flush_done, NULL);
+}
+
+static void raid_bdev_submit_rw_request(struct raid_bdev_io *raid_io);
+
+static void
+_raid_bdev_wi_bitmap_write_resume(void *ctx)
+{
+	struct raid_bdev_io *raid_io = ctx;
+
+	raid_bdev_submit_rw_request(raid_io);
+}
+
+static void
+raid_bdev_wi_bitmap_mark_dirty(void *ctx)
+{
+	struct raid_bdev_io *raid_io = ctx;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_bdev_wi_bitmap *wi_bitmap = raid_bdev->wi_bitmap;
+	uint64_t region, last;
+
+	region = raid_bdev_wi_bitmap_region(wi_bitmap, raid_io->offset_blocks);
+	last = raid_bdev_wi_bitmap_region(wi_bitmap, raid_io->offset_blocks + raid_io->num_blocks - 1);
+	for (; region <= last; region++) {
+		if ((wi_bitmap->buf[region / 64] & (1ULL << (region % 64))) == 0) {
+			raid_bdev_wi_bitmap_buf_update(wi_bitmap, region, true);
+		}
+	}
+
+	raid_io->waitq_entry.cb_fn = _raid_bdev_wi_bitmap_write_resume;
+	raid_io->waitq_entry.cb_arg = raid_io;
+	TAILQ_INSERT_TAIL(&wi_bitmap->waiters, &raid_io->waitq_entry, link);
+
+	raid_bdev_wi_bitmap_flush(raid_bdev);
+}
+
+/*
+ * Submit the write once the bits of all regions it touches are persisted. The
+ * pending counters are raised first so that the bits can't be cleared concurrently.
+ */
+static void
+raid_bdev_wi_bitmap_start_write(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev_wi_bitmap *wi_bitmap = raid_io->raid_bdev->wi_bitmap;
+	uint64_t region, last;
+	bool marked = true;
+	int rc;
+
+	region = raid_bdev_wi_bitmap_region(wi_bitmap, raid_io->offset_blocks);
+	last = raid_bdev_wi_bitmap_region(wi_bitmap, raid_io->offset_blocks + raid_io->num_blocks - 1);
+	for (; region <= last; region++) {
+		__atomic_fetch_add(&wi_bitmap->pending[region], 1, __ATOMIC_SEQ_CST);
+		if (!raid_bdev_wi_bitmap_test(wi_bitmap, region)) {
+			marked = false;
+		}
+	}
+
+	if (spdk_likely(marked)) {
+		raid_bdev_submit_rw_request(raid_io);
+		return;
+	}
+
+	rc = spdk_thread_send_msg(spdk_thread_get_app_thread(), raid_bdev_wi_bitmap_mark_dirty, raid_io);
+	if (spdk_unlikely(rc != 0)) {
+		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_NOMEM);
+	}
+}
+
+static void
+raid_bdev_wi_bitmap_end_write(struct raid_bdev_wi_bitmap *wi_bitmap, uint64_t offset_blocks,
+			      uint64_t num_blocks)
+{
+	uint64_t region, last;
+
+	region = raid_bdev_wi_bitmap_region(wi_bitmap, offset_blocks);
+	last = raid_bdev_wi_bitmap_region(wi_bitmap, offset_blocks + num_blocks - 1);
+	for (; region <= last; region++) {
+		assert(wi_bitmap->pending[region] > 0);
+		__atomic_fetch_sub(&wi_bitmap->pending[region], 1, __ATOMIC_SEQ_CST);
+	}
+}
+
 void
 raid_bdev_io_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
 {
@@ -648,6 +843,11 @@ raid_bdev_io_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status sta
 	if (spdk_unlikely(raid_io->completion_cb != NULL)) {
 		raid_io->completion_cb(raid_io, status);
 	} else {
+		if (bdev_io->type == SPDK_BDEV_IO_TYPE_WRITE && raid_io->raid_bdev->wi_bitmap != NULL) {
+			raid_bdev_wi_bitmap_end_write(raid_io->raid_bdev->wi_bitmap,
+						      bdev_io->u.bdev.offset_blocks,
+						      bdev_io->u.bdev.num_blocks);
+		}
 		if (spdk_unlikely(bdev_io->type == SPDK_BDEV_IO_TYPE_READ &&
 				  spdk_bdev_get_dif_type(bdev_io->bdev) != SPDK_DIF_DISABLE &&
 				  bdev_io->bdev->dif_check_flags & SPDK_DIF_FLAGS_REFTAG_CHECK &&
@@ -944,7 +1144,11 @@ raid_bdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 				     bdev_io->u.bdev.num_blocks * bdev_io->bdev->blocklen);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
-		raid_bdev_submit_rw_request(raid_io);
+		if (raid_io->raid_bdev->wi_bitmap != NULL) {
+			raid_bdev_wi_bitmap_start_write(raid_io);
+		} else {
+			raid_bdev_submit_rw_request(raid_io);
+		}
 		break;
 
 	case SPDK_BDEV_IO_TYPE_RESET:
@@ -953,8 +1157,9 @@ raid_bdev_submit_request(struct spdk_io_channel *ch, struct spdk_bdev_io *bdev_i
 
 	case SPDK_BDEV_IO_TYPE_FLUSH:
 	case SPDK_BDEV_IO_TYPE_UNMAP:
-		if (raid_io->raid_bdev->process != NULL) {
-			/* TODO: rebuild support */
+		if (raid_io->raid_bdev->process != NULL ||
+		    raid_io->raid_bdev->reshape.num_base_bdevs_old != 0) {
+			/* TODO: rebuild and reshape support */
 			raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
 			return;
 		}
@@ -1067,6 +1272,10 @@ raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ct
 	spdk_json_write_named_uint32(w, "strip_size_kb", raid_bdev->strip_size_kb);
 	spdk_json_write_named_string(w, "state", raid_bdev_state_to_str(raid_bdev->state));
 	spdk_json_write_named_string(w, "raid_level", raid_bdev_level_to_str(raid_bdev->level));
+	if (raid_bdev->level == RAID1) {
+		spdk_json_write_named_string(w, "read_policy",
+					     raid_bdev_read_policy_to_str(raid_bdev->read_policy));
+	}
 	spdk_json_write_named_bool(w, "superblock", raid_bdev->superblock_enabled);
 	spdk_json_write_named_uint32(w, "num_base_bdevs", raid_bdev->num_base_bdevs);
 	spdk_json_write_named_uint32(w, "num_base_bdevs_discovered", raid_bdev->num_base_bdevs_discovered);
@@ -1079,7 +1288,9 @@ raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ct
 		spdk_json_write_named_object_begin(w, "process");
 		spdk_json_write_name(w, "type");
 		spdk_json_write_string(w, raid_bdev_process_to_str(process->type));
-		spdk_json_write_named_string(w, "target", process->target->name);
+		if (process->target != NULL) {
+			spdk_json_write_named_string(w, "target", process->target->name);
+		}
 		spdk_json_write_named_object_begin(w, "progress");
 		spdk_json_write_named_uint64(w, "blocks", offset);
 		spdk_json_write_named_uint32(w, "percent", offset * 100.0 / raid_bdev->bdev.blockcnt);
@@ -1163,6 +1374,10 @@ raid_bdev_write_config_json(struct spdk_bdev *bdev, struct spdk_json_write_ctx *
 		spdk_json_write_named_uint32(w, "strip_size_kb", raid_bdev->strip_size_kb);
 	}
 	spdk_json_write_named_string(w, "raid_level", raid_bdev_level_to_str(raid_bdev->level));
+	if (raid_bdev->read_policy != RAID_READ_POLICY_LEAST_OUTSTANDING) {
+		spdk_json_write_named_string(w, "read_policy",
+					     raid_bdev_read_policy_to_str(raid_bdev->read_policy));
+	}
 
 	spdk_json_write_named_array_begin(w, "base_bdevs");
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
@@ -1270,12 +1485,21 @@ static struct {
 	{ "0", RAID0 },
 	{ "raid1", RAID1 },
 	{ "1", RAID1 },
+	{ "raid6", RAID6 },
+	{ "6", RAID6 },
 	{ "raid5f", RAID5F },
 	{ "5f", RAID5F },
 	{ "concat", CONCAT },
 	{ }
 };
 
+static const char *g_raid_read_policy_names[] = {
+	[RAID_READ_POLICY_LEAST_OUTSTANDING]	= "least_outstanding",
+	[RAID_READ_POLICY_LATENCY]		= "latency",
+	[RAID_READ_POLICY_SEQUENTIAL]		= "sequential",
+	[RAID_READ_POLICY_MAX]			= NULL
+};
+
 const char *g_raid_state_names[] = {
 	[RAID_BDEV_STATE_ONLINE]	= "online",
 	[RAID_BDEV_STATE_CONFIGURING]	= "configuring",
@@ -1286,12 +1510,14 @@ const char *g_raid_state_names[] = {
 static const char *g_raid_process_type_names[] = {
 	[RAID_PROCESS_NONE]	= "none",
 	[RAID_PROCESS_REBUILD]	= "rebuild",
+	[RAID_PROCESS_RESHAPE]	= "reshape",
 	[RAID_PROCESS_MAX]	= NULL
 };
 
 /* We have to use the typedef in the function declaration to appease astyle. */
 typedef enum raid_level raid_level_t;
 typedef enum raid_bdev_state raid_bdev_state_t;
+typedef enum raid_read_policy raid_read_policy_t;
 
 raid_level_t
 raid_bdev_str_to_level(const char *str)
@@ -1323,6 +1549,32 @@ raid_bdev_level_to_str(enum raid_level level)
 	return "";
 }
 
+raid_read_policy_t
+raid_bdev_str_to_read_policy(const char *str)
+{
+	unsigned int i;
+
+	assert(str != NULL);
+
+	for (i = 0; i < RAID_READ_POLICY_MAX; i++) {
+		if (strcasecmp(g_raid_read_policy_names[i], str) == 0) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+const char *
+raid_bdev_read_policy_to_str(enum raid_read_policy read_policy)
+{
+	if (read_policy >= RAID_READ_POLICY_MAX) {
+		return "";
+	}
+
+	return g_raid_read_policy_names[read_policy];
+}
+
 raid_bdev_state_t
 raid_bdev_str_to_state(const char *str)
 {
@@ -1478,7 +1730,7 @@ raid_bdev_init(void)
 static int
 _raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
 		  enum raid_level level, bool superblock_enabled, const struct spdk_uuid *uuid,
-		  struct raid_bdev **raid_bdev_out)
+		  enum raid_read_policy read_policy, struct raid_bdev **raid_bdev_out)
 {
 	struct raid_bdev *raid_bdev;
 	struct spdk_bdev *raid_bdev_gen;
@@ -1506,6 +1758,14 @@ _raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
 		return -EINVAL;
 	}
 
+	if (read_policy >= RAID_READ_POLICY_MAX) {
+		SPDK_ERRLOG("Invalid read policy %d\n", read_policy);
+		return -EINVAL;
+	} else if (read_policy != RAID_READ_POLICY_LEAST_OUTSTANDING && level != RAID1) {
+		SPDK_ERRLOG("Read policy is not supported by %s\n", raid_bdev_level_to_str(level));
+		return -EINVAL;
+	}
+
 	module = raid_bdev_module_find(level);
 	if (module == NULL) {
 		SPDK_ERRLOG("Unsupported raid level '%d'\n", level);
@@ -1575,6 +1835,7 @@ _raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
 	raid_bdev->strip_size_kb = strip_size;
 	raid_bdev->state = RAID_BDEV_STATE_CONFIGURING;
 	raid_bdev->level = level;
+	raid_bdev->read_policy = read_policy;
 	raid_bdev->min_base_bdevs_operational = min_operational;
 	raid_bdev->superblock_enabled = superblock_enabled;
 
@@ -1611,6 +1872,7 @@ _raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
  * level - raid level
  * superblock_enabled - true if raid should have superblock
  * uuid - uuid to set for the bdev
+ * read_policy - read policy, only raid1 supports other than the default
  * raid_bdev_out - the created raid bdev
  * returns:
  * 0 - success
@@ -1619,7 +1881,7 @@ _raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
 int
 raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
 		 enum raid_level level, bool superblock_enabled, const struct spdk_uuid *uuid,
-		 struct raid_bdev **raid_bdev_out)
+		 enum raid_read_policy read_policy, struct raid_bdev **raid_bdev_out)
 {
 	struct raid_bdev *raid_bdev;
 	int rc;
@@ -1627,7 +1889,7 @@ raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
 	assert(uuid != NULL);
 
 	rc = _raid_bdev_create(name, strip_size, num_base_bdevs, level, superblock_enabled, uuid,
-			       &raid_bdev);
+			       read_policy, &raid_bdev);
 	if (rc != 0) {
 		return rc;
 	}
@@ -1714,6 +1976,8 @@ raid_bdev_event_cb(enum spdk_bdev_event_type type, struct spdk_bdev *bdev, void
 	}
 }
 
+static int raid_bdev_start_reshape(struct raid_bdev *raid_bdev);
+
 static void
 raid_bdev_configure_cont(struct raid_bdev *raid_bdev)
 {
@@ -1754,6 +2018,13 @@ raid_bdev_configure_cont(struct raid_bdev *raid_bdev)
 	SPDK_DEBUGLOG(bdev_raid, "raid bdev generic %p\n", raid_bdev_gen);
 	SPDK_DEBUGLOG(bdev_raid, "raid bdev is created with name %s, raid_bdev %p\n",
 		      raid_bdev_gen->name, raid_bdev);
+
+	if (raid_bdev->reshape.num_base_bdevs_old != 0) {
+		/* resume the reshape that was interrupted */
+		if (raid_bdev_start_reshape(raid_bdev) != 0) {
+			SPDK_ERRLOG("Failed to resume reshape of raid bdev '%s'\n", raid_bdev_gen->name);
+		}
+	}
 out:
 	if (rc != 0) {
 		if (raid_bdev->module->stop != NULL) {
@@ -1787,6 +2058,132 @@ raid_bdev_configure_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *c
 	}
 }
 
+static int
+raid_bdev_wi_bitmap_clear_poll(void *arg)
+{
+	struct raid_bdev *raid_bdev = arg;
+	struct raid_bdev_wi_bitmap *wi_bitmap = raid_bdev->wi_bitmap;
+	struct raid_base_bdev_info *base_info;
+	uint64_t i, word, mask, region;
+	int cleared = 0;
+
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (!base_info->is_configured || base_info->remove_scheduled || base_info->is_failed) {
+			/* the bits must be kept while degraded, any failed write is accounted for now */
+			__atomic_store_n(&wi_bitmap->clear_blocked, false, __ATOMIC_SEQ_CST);
+			return SPDK_POLLER_IDLE;
+		}
+	}
+
+	if (raid_bdev->process != NULL || wi_bitmap->write_in_progress ||
+	    __atomic_load_n(&wi_bitmap->clear_blocked, __ATOMIC_SEQ_CST)) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	for (i = 0; i < spdk_divide_round_up(wi_bitmap->num_regions, 64); i++) {
+		word = __atomic_load_n(&wi_bitmap->bits[i], __ATOMIC_SEQ_CST);
+		while (word != 0) {
+			region = i * 64 + __builtin_ctzll(word);
+			mask = 1ULL << (region % 64);
+			word &= word - 1;
+
+			if (__atomic_load_n(&wi_bitmap->pending[region], __ATOMIC_SEQ_CST) != 0) {
+				continue;
+			}
+
+			/*
+			 * A write raises the pending count before checking the bit, so either it
+			 * sees the bit cleared and waits for it to be persisted again, or the
+			 * count is seen here and the bit is restored.
+			 */
+			__atomic_fetch_and(&wi_bitmap->bits[i], ~mask, __ATOMIC_SEQ_CST);
+			if (__atomic_load_n(&wi_bitmap->pending[region], __ATOMIC_SEQ_CST) != 0) {
+				__atomic_fetch_or(&wi_bitmap->bits[i], mask, __ATOMIC_SEQ_CST);
+				continue;
+			}
+
+			raid_bdev_wi_bitmap_buf_update(wi_bitmap, region, false);
+			cleared++;
+		}
+	}
+
+	if (cleared == 0) {
+		return SPDK_POLLER_IDLE;
+	}
+
+	raid_bdev_wi_bitmap_flush(raid_bdev);
+
+	return SPDK_POLLER_BUSY;
+}
+
+static void
+raid_bdev_wi_bitmap_stop(struct raid_bdev *raid_bdev)
+{
+	if (raid_bdev->wi_bitmap == NULL) {
+		return;
+	}
+
+	spdk_poller_unregister(&raid_bdev->wi_bitmap->clear_poller);
+	raid_bdev_free_wi_bitmap(raid_bdev);
+}
+
+static void
+raid_bdev_wi_bitmap_disable(struct raid_bdev *raid_bdev)
+{
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	uint8_t i;
+
+	raid_bdev_wi_bitmap_stop(raid_bdev);
+
+	sb->flags &= ~RAID_BDEV_SB_FLAG_WI_BITMAP;
+	for (i = 0; i < sb->base_bdevs_size; i++) {
+		sb->base_bdevs[i].flags &= ~RAID_SB_BASE_BDEV_FLAG_WI_BITMAP;
+	}
+}
+
+static void
+raid_bdev_configure_wi_bitmap_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to initialize raid bdev '%s' write-intent bitmap: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+		raid_bdev_wi_bitmap_disable(raid_bdev);
+	}
+
+	raid_bdev_write_superblock(raid_bdev, raid_bdev_configure_write_sb_cb, NULL);
+}
+
+static void
+raid_bdev_configure_wi_bitmap(struct raid_bdev *raid_bdev)
+{
+	bool load = raid_bdev->sb->flags & RAID_BDEV_SB_FLAG_WI_BITMAP;
+	int rc;
+
+	raid_bdev_wi_bitmap_stop(raid_bdev);
+
+	rc = raid_bdev_alloc_wi_bitmap(raid_bdev);
+	if (rc != 0) {
+		SPDK_NOTICELOG("Write-intent bitmap not enabled on raid bdev %s: %s\n",
+			       raid_bdev->bdev.name, spdk_strerror(-rc));
+		raid_bdev_wi_bitmap_disable(raid_bdev);
+		raid_bdev_write_superblock(raid_bdev, raid_bdev_configure_write_sb_cb, NULL);
+		return;
+	}
+
+	raid_bdev->wi_bitmap->clear_poller = SPDK_POLLER_REGISTER(raid_bdev_wi_bitmap_clear_poll,
+					     raid_bdev, RAID_BDEV_WI_BITMAP_CLEAR_PERIOD_US);
+
+	if (load) {
+		raid_bdev_load_wi_bitmap(raid_bdev, raid_bdev_configure_wi_bitmap_cb, NULL);
+	} else {
+		raid_bdev_write_wi_bitmap(raid_bdev, raid_bdev_configure_wi_bitmap_cb, NULL);
+	}
+}
+
 /*
  * brief:
  * If raid bdev config is complete, then only register the raid bdev to
@@ -1854,7 +2251,11 @@ raid_bdev_configure(struct raid_bdev *raid_bdev, raid_bdev_configure_cb cb, void
 			return rc;
 		}
 
-		raid_bdev_write_superblock(raid_bdev, raid_bdev_configure_write_sb_cb, NULL);
+		if (raid_bdev->module->wi_bitmap_supported) {
+			raid_bdev_configure_wi_bitmap(raid_bdev);
+		} else {
+			raid_bdev_write_superblock(raid_bdev, raid_bdev_configure_write_sb_cb, NULL);
+		}
 	} else {
 		raid_bdev_configure_cont(raid_bdev);
 	}
@@ -2241,59 +2642,172 @@ raid_bdev_remove_base_bdev(struct spdk_bdev *base_bdev, raid_base_bdev_cb cb_fn,
 	return _raid_bdev_remove_base_bdev(base_info, cb_fn, cb_ctx);
 }
 
+struct raid_bdev_get_read_stats_ctx {
+	struct raid_bdev *raid_bdev;
+	struct raid_base_bdev_read_stats *stats;
+	raid_bdev_get_read_stats_cb cb_fn;
+	void *cb_ctx;
+};
+
 static void
-raid_bdev_fail_base_remove_cb(void *ctx, int status)
+raid_bdev_channel_get_read_stats(struct spdk_io_channel_iter *i)
 {
-	struct raid_base_bdev_info *base_info = ctx;
+	struct raid_bdev_get_read_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
 
-	if (status != 0) {
-		SPDK_WARNLOG("Failed to remove base bdev %s\n", base_info->name);
-		base_info->is_failed = false;
+	if (raid_ch->module_channel != NULL) {
+		ctx->raid_bdev->module->get_read_stats(ctx->raid_bdev, raid_ch, ctx->stats);
 	}
+
+	spdk_for_each_channel_continue(i, 0);
 }
 
 static void
-_raid_bdev_fail_base_bdev(void *ctx)
+raid_bdev_get_read_stats_done(struct spdk_io_channel_iter *i, int status)
 {
-	struct raid_base_bdev_info *base_info = ctx;
-	int rc;
+	struct raid_bdev_get_read_stats_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
 
-	if (base_info->is_failed) {
-		return;
+	if (status == 0 && raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
+		status = -ENODEV;
 	}
-	base_info->is_failed = true;
-
-	SPDK_NOTICELOG("Failing base bdev in slot %d ('%s') of raid bdev '%s'\n",
-		       raid_bdev_base_bdev_slot(base_info), base_info->name, base_info->raid_bdev->bdev.name);
 
-	rc = _raid_bdev_remove_base_bdev(base_info, raid_bdev_fail_base_remove_cb, base_info);
-	if (rc != 0) {
-		raid_bdev_fail_base_remove_cb(base_info, rc);
+	if (status == 0) {
+		raid_bdev->module->get_read_stats(raid_bdev, NULL, ctx->stats);
 	}
-}
 
-void
-raid_bdev_fail_base_bdev(struct raid_base_bdev_info *base_info)
-{
-	spdk_thread_exec_msg(spdk_thread_get_app_thread(), _raid_bdev_fail_base_bdev, base_info);
-}
+	ctx->cb_fn(raid_bdev, ctx->stats, status, ctx->cb_ctx);
 
-static void
-raid_bdev_resize_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
-{
-	if (status != 0) {
-		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock after resizing the bdev: %s\n",
-			    raid_bdev->bdev.name, spdk_strerror(-status));
-	}
+	free(ctx->stats);
+	free(ctx);
 }
 
 /*
  * brief:
- * raid_bdev_resize_base_bdev function is called by below layers when base_bdev
- * is resized. This function checks if the smallest size of the base_bdevs is changed.
- * If yes, call module handler to resize the raid_bdev if implemented.
+ * raid_bdev_get_read_stats collects the per base bdev read statistics of an
+ * online raid bdev from all of its io channels
  * params:
- * base_bdev - pointer to base bdev which got resized.
+ * raid_bdev - pointer to raid bdev
+ * cb_fn - callback called with an array of num_base_bdevs statistics
+ * cb_ctx - argument to callback function
+ * returns:
+ * 0 - success
+ * non zero - failure
+ */
+int
+raid_bdev_get_read_stats(struct raid_bdev *raid_bdev, raid_bdev_get_read_stats_cb cb_fn,
+			 void *cb_ctx)
+{
+	struct raid_bdev_get_read_stats_ctx *ctx;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	if (raid_bdev->module->get_read_stats == NULL) {
+		return -ENOTSUP;
+	}
+
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE) {
+		return -ENODEV;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->stats = calloc(raid_bdev->num_base_bdevs, sizeof(*ctx->stats));
+	if (ctx->stats == NULL) {
+		free(ctx);
+		return -ENOMEM;
+	}
+
+	ctx->raid_bdev = raid_bdev;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_ctx = cb_ctx;
+
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_get_read_stats, ctx,
+			      raid_bdev_get_read_stats_done);
+
+	return 0;
+}
+
+static void
+raid_bdev_fail_base_remove_cb(void *ctx, int status)
+{
+	struct raid_base_bdev_info *base_info = ctx;
+
+	if (status != 0) {
+		SPDK_WARNLOG("Failed to remove base bdev %s\n", base_info->name);
+		base_info->is_failed = false;
+	}
+}
+
+static void
+_raid_bdev_fail_base_bdev(void *ctx)
+{
+	struct raid_base_bdev_info *base_info = ctx;
+	int rc;
+
+	if (base_info->is_failed) {
+		return;
+	}
+	base_info->is_failed = true;
+
+	SPDK_NOTICELOG("Failing base bdev in slot %d ('%s') of raid bdev '%s'\n",
+		       raid_bdev_base_bdev_slot(base_info), base_info->name, base_info->raid_bdev->bdev.name);
+
+	rc = _raid_bdev_remove_base_bdev(base_info, raid_bdev_fail_base_remove_cb, base_info);
+	if (rc != 0) {
+		raid_bdev_fail_base_remove_cb(base_info, rc);
+	}
+}
+
+void
+raid_bdev_fail_base_bdev(struct raid_base_bdev_info *base_info)
+{
+	struct raid_bdev_wi_bitmap *wi_bitmap = base_info->raid_bdev->wi_bitmap;
+
+	if (wi_bitmap != NULL) {
+		/* the base bdev missed a write, keep the bits set until it is removed */
+		__atomic_store_n(&wi_bitmap->clear_blocked, true, __ATOMIC_SEQ_CST);
+	}
+
+	spdk_thread_exec_msg(spdk_thread_get_app_thread(), _raid_bdev_fail_base_bdev, base_info);
+}
+
+static void
+raid_bdev_sb_update_size(struct raid_bdev *raid_bdev)
+{
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	uint8_t i;
+
+	for (i = 0; i < sb->base_bdevs_size; i++) {
+		struct raid_bdev_sb_base_bdev *sb_base_bdev = &sb->base_bdevs[i];
+
+		if (sb_base_bdev->slot < raid_bdev->num_base_bdevs) {
+			sb_base_bdev->data_size = raid_bdev->base_bdev_info[sb_base_bdev->slot].data_size;
+		}
+	}
+	sb->raid_size = raid_bdev->bdev.blockcnt;
+}
+
+static void
+raid_bdev_resize_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock after resizing the bdev: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+	}
+}
+
+/*
+ * brief:
+ * raid_bdev_resize_base_bdev function is called by below layers when base_bdev
+ * is resized. This function checks if the smallest size of the base_bdevs is changed.
+ * If yes, call module handler to resize the raid_bdev if implemented.
+ * params:
+ * base_bdev - pointer to base bdev which got resized.
  * returns:
  * none
  */
@@ -2322,7 +2836,8 @@ raid_bdev_resize_base_bdev(struct spdk_bdev *base_bdev)
 
 	base_info->blockcnt = base_bdev->blockcnt;
 
-	if (!raid_bdev->module->resize) {
+	if (!raid_bdev->module->resize || raid_bdev->reshape.num_base_bdevs_old != 0) {
+		/* with a pending reshape the raid bdev is resized when the reshape completes */
 		return;
 	}
 
@@ -2335,18 +2850,7 @@ raid_bdev_resize_base_bdev(struct spdk_bdev *base_bdev)
 		       raid_bdev->bdev.name, blockcnt_old, raid_bdev->bdev.blockcnt);
 
 	if (raid_bdev->superblock_enabled) {
-		struct raid_bdev_superblock *sb = raid_bdev->sb;
-		uint8_t i;
-
-		for (i = 0; i < sb->base_bdevs_size; i++) {
-			struct raid_bdev_sb_base_bdev *sb_base_bdev = &sb->base_bdevs[i];
-
-			if (sb_base_bdev->slot < raid_bdev->num_base_bdevs) {
-				base_info = &raid_bdev->base_bdev_info[sb_base_bdev->slot];
-				sb_base_bdev->data_size = base_info->data_size;
-			}
-		}
-		sb->raid_size = raid_bdev->bdev.blockcnt;
+		raid_bdev_sb_update_size(raid_bdev);
 		raid_bdev_write_superblock(raid_bdev, raid_bdev_resize_write_sb_cb, NULL);
 	}
 }
@@ -2462,6 +2966,11 @@ raid_bdev_process_finish_write_sb(void *ctx)
 				sb_base_bdev->state = RAID_SB_BASE_BDEV_CONFIGURED;
 				sb_base_bdev->data_offset = base_info->data_offset;
 				spdk_uuid_copy(&sb_base_bdev->uuid, &base_info->uuid);
+				if (raid_bdev->wi_bitmap != NULL) {
+					sb_base_bdev->flags |= RAID_SB_BASE_BDEV_FLAG_WI_BITMAP;
+				} else {
+					sb_base_bdev->flags &= ~RAID_SB_BASE_BDEV_FLAG_WI_BITMAP;
+				}
 			}
 		}
 	}
@@ -2511,7 +3020,7 @@ raid_bdev_process_finish_unquiesced(void *ctx, int status)
 		SPDK_ERRLOG("Failed to unquiesce bdev: %s\n", spdk_strerror(-status));
 	}
 
-	if (process->status != 0) {
+	if (process->status != 0 && process->target != NULL) {
 		status = _raid_bdev_remove_base_bdev(process->target, raid_bdev_process_finish_target_removed,
 						     process);
 		if (status != 0) {
@@ -2583,6 +3092,15 @@ raid_bdev_channel_process_finish(struct spdk_io_channel_iter *i)
 	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
 	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
 
+	if (process->target == NULL) {
+		/* keep the channels split at the reshape offset if the reshape did not complete */
+		if (process->status == 0) {
+			raid_bdev_ch_process_cleanup(raid_ch);
+		}
+		spdk_for_each_channel_continue(i, 0);
+		return;
+	}
+
 	if (process->status == 0) {
 		uint8_t slot = raid_bdev_base_bdev_slot(process->target);
 
@@ -2595,6 +3113,28 @@ raid_bdev_channel_process_finish(struct spdk_io_channel_iter *i)
 	spdk_for_each_channel_continue(i, 0);
 }
 
+static void
+raid_bdev_reshape_complete(struct raid_bdev *raid_bdev)
+{
+	uint64_t blockcnt_old = raid_bdev->bdev.blockcnt;
+
+	raid_bdev->reshape.num_base_bdevs_old = 0;
+	raid_bdev->reshape.offset = 0;
+
+	if (!raid_bdev->module->resize(raid_bdev)) {
+		SPDK_WARNLOG("raid bdev '%s': block count was not changed after reshape\n",
+			     raid_bdev->bdev.name);
+	} else {
+		SPDK_NOTICELOG("raid bdev '%s': block count was changed from %" PRIu64 " to %" PRIu64 "\n",
+			       raid_bdev->bdev.name, blockcnt_old, raid_bdev->bdev.blockcnt);
+	}
+
+	/* written by raid_bdev_process_finish_write_sb() */
+	raid_bdev->sb->reshape_num_base_bdevs_old = 0;
+	raid_bdev->sb->reshape_offset = 0;
+	raid_bdev_sb_update_size(raid_bdev);
+}
+
 static void
 raid_bdev_process_finish_quiesced(void *ctx, int status)
 {
@@ -2607,7 +3147,13 @@ raid_bdev_process_finish_quiesced(void *ctx, int status)
 	}
 
 	raid_bdev->process = NULL;
-	process->target->is_process_target = false;
+	if (process->target != NULL) {
+		process->target->is_process_target = false;
+	}
+
+	if (process->type == RAID_PROCESS_RESHAPE && process->status == 0) {
+		raid_bdev_reshape_complete(raid_bdev);
+	}
 
 	spdk_for_each_channel(process->raid_bdev, raid_bdev_channel_process_finish, process,
 			      __raid_bdev_process_finish);
@@ -2683,7 +3229,7 @@ raid_bdev_process_unlock_window_range(struct raid_bdev_process *process)
 	assert(process->window_range_locked == true);
 
 	rc = spdk_bdev_unquiesce_range(&process->raid_bdev->bdev, &g_raid_if,
-				       process->window_offset, process->max_window_size,
+				       process->window_offset, process->window_range_size,
 				       raid_bdev_process_window_range_unlocked, process);
 	if (rc != 0) {
 		raid_bdev_process_window_range_unlocked(process, rc);
@@ -2710,6 +3256,52 @@ raid_bdev_process_channel_update(struct spdk_io_channel_iter *i)
 	spdk_for_each_channel_continue(i, 0);
 }
 
+static void
+_raid_bdev_reshape_checkpoint_done(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (process->window_status != 0) {
+		raid_bdev_process_finish(process, process->window_status);
+		return;
+	}
+
+	spdk_for_each_channel(process->raid_bdev, raid_bdev_process_channel_update, process,
+			      raid_bdev_process_channels_update_done);
+}
+
+static void
+raid_bdev_reshape_checkpoint_done(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock with reshape progress: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+		raid_bdev->reshape.offset = process->window_offset;
+		raid_bdev->sb->reshape_offset = raid_bdev->reshape.offset;
+		process->window_status = status;
+	}
+
+	spdk_thread_send_msg(process->thread, _raid_bdev_reshape_checkpoint_done, process);
+}
+
+/*
+ * Persist the reshape progress before the restriped window is unlocked. Until then the
+ * window's data is valid in both layouts, so a restart resumes from a consistent offset.
+ */
+static void
+raid_bdev_reshape_checkpoint(void *ctx)
+{
+	struct raid_bdev_process *process = ctx;
+	struct raid_bdev *raid_bdev = process->raid_bdev;
+
+	raid_bdev->reshape.offset = process->window_offset + process->window_size;
+	raid_bdev->sb->reshape_offset = raid_bdev->reshape.offset;
+
+	raid_bdev_write_superblock(raid_bdev, raid_bdev_reshape_checkpoint_done, process);
+}
+
 void
 raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
 {
@@ -2731,6 +3323,12 @@ raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req
 			return;
 		}
 
+		if (process->type == RAID_PROCESS_RESHAPE) {
+			spdk_thread_send_msg(spdk_thread_get_app_thread(), raid_bdev_reshape_checkpoint,
+					     process);
+			return;
+		}
+
 		spdk_for_each_channel(process->raid_bdev, raid_bdev_process_channel_update, process,
 				      raid_bdev_process_channels_update_done);
 	}
@@ -2777,7 +3375,8 @@ _raid_bdev_process_thread_run(struct raid_bdev_process *process)
 {
 	struct raid_bdev *raid_bdev = process->raid_bdev;
 	uint64_t offset = process->window_offset;
-	const uint64_t offset_end = spdk_min(offset + process->max_window_size, raid_bdev->bdev.blockcnt);
+	const uint64_t offset_end = spdk_min(offset + spdk_min(process->max_window_size,
+					     process->window_range_size), raid_bdev->bdev.blockcnt);
 	int ret;
 
 	while (offset < offset_end) {
@@ -2788,6 +3387,15 @@ _raid_bdev_process_thread_run(struct raid_bdev_process *process)
 
 		process->window_remaining += ret;
 		offset += ret;
+
+		/*
+		 * Reshape requests move data in place, so a request must complete before the
+		 * next one may overwrite what it reads. The module limits each request to a
+		 * range that is safe to redo after a restart and it is persisted per window.
+		 */
+		if (process->type == RAID_PROCESS_RESHAPE) {
+			break;
+		}
 	}
 
 	if (process->window_remaining > 0) {
@@ -2797,6 +3405,30 @@ _raid_bdev_process_thread_run(struct raid_bdev_process *process)
 	}
 }
 
+/*
+ * Returns the number of blocks from offset_blocks, up to num_blocks, that belong to
+ * regions not marked in the write-intent bitmap.
+ */
+static uint64_t
+raid_bdev_wi_bitmap_get_clean_blocks(struct raid_bdev_wi_bitmap *wi_bitmap, uint64_t offset_blocks,
+				     uint64_t num_blocks)
+{
+	uint64_t region = raid_bdev_wi_bitmap_region(wi_bitmap, offset_blocks);
+	uint64_t offset_end = offset_blocks + num_blocks;
+	uint64_t clean_end = offset_blocks;
+
+	while (clean_end < offset_end && !raid_bdev_wi_bitmap_test(wi_bitmap, region)) {
+		if (region == wi_bitmap->num_regions - 1) {
+			clean_end = offset_end;
+			break;
+		}
+		region++;
+		clean_end = region << wi_bitmap->region_shift;
+	}
+
+	return spdk_min(clean_end, offset_end) - offset_blocks;
+}
+
 static void
 raid_bdev_process_window_range_locked(void *ctx, int status)
 {
@@ -2815,6 +3447,25 @@ raid_bdev_process_window_range_locked(void *ctx, int status)
 		return;
 	}
 
+	if (process->wi_bitmap_resync) {
+		uint64_t clean_blocks;
+
+		/*
+		 * No writes are in progress in the locked range now, so the bitmap is accurate.
+		 * The clean part of the range does not need to be copied, only the channels
+		 * are updated to include it in the processed range.
+		 */
+		clean_blocks = raid_bdev_wi_bitmap_get_clean_blocks(process->raid_bdev->wi_bitmap,
+				process->window_offset,
+				process->window_range_size);
+		if (clean_blocks > 0) {
+			process->window_size = clean_blocks;
+			spdk_for_each_channel(process->raid_bdev, raid_bdev_process_channel_update, process,
+					      raid_bdev_process_channels_update_done);
+			return;
+		}
+	}
+
 	_raid_bdev_process_thread_run(process);
 }
 
@@ -2829,7 +3480,8 @@ raid_bdev_process_consume_token(struct raid_bdev_process *process)
 						(now - process->qos.last_tsc) * process->qos.bytes_per_tsc);
 	process->qos.last_tsc = now;
 	if (process->qos.bytes_available > 0.0) {
-		process->qos.bytes_available -= process->window_size * raid_bdev->bdev.blocklen;
+		process->qos.bytes_available -= spdk_min(process->window_size, process->max_window_size) *
+						raid_bdev->bdev.blocklen;
 		return true;
 	}
 	return false;
@@ -2839,11 +3491,21 @@ static bool
 raid_bdev_process_lock_window_range(struct raid_bdev_process *process)
 {
 	struct raid_bdev *raid_bdev = process->raid_bdev;
+	uint64_t clean_blocks = 0;
 	int rc;
 
 	assert(process->window_range_locked == false);
 
-	if (process->qos.enable_qos) {
+	if (process->wi_bitmap_resync) {
+		clean_blocks = raid_bdev_wi_bitmap_get_clean_blocks(raid_bdev->wi_bitmap,
+				process->window_offset,
+				raid_bdev->bdev.blockcnt - process->window_offset);
+	}
+
+	if (clean_blocks > 0) {
+		/* skip the whole clean range at once, it is not subject to QoS */
+		process->window_range_size = clean_blocks;
+	} else if (process->qos.enable_qos) {
 		if (raid_bdev_process_consume_token(process)) {
 			spdk_poller_pause(process->qos.process_continue_poller);
 		} else {
@@ -2853,7 +3515,7 @@ raid_bdev_process_lock_window_range(struct raid_bdev_process *process)
 	}
 
 	rc = spdk_bdev_quiesce_range(&raid_bdev->bdev, &g_raid_if,
-				     process->window_offset, process->max_window_size,
+				     process->window_offset, process->window_range_size,
 				     raid_bdev_process_window_range_locked, process);
 	if (rc != 0) {
 		raid_bdev_process_window_range_locked(process, rc);
@@ -2894,6 +3556,7 @@ raid_bdev_process_thread_run(struct raid_bdev_process *process)
 
 	process->max_window_size = spdk_min(raid_bdev->bdev.blockcnt - process->window_offset,
 					    process->max_window_size);
+	process->window_range_size = process->max_window_size;
 	raid_bdev_process_lock_window_range(process);
 }
 
@@ -2922,8 +3585,9 @@ raid_bdev_process_thread_init(void *ctx)
 		spdk_poller_pause(process->qos.process_continue_poller);
 	}
 
-	SPDK_NOTICELOG("Started %s on raid bdev %s\n",
-		       raid_bdev_process_to_str(process->type), raid_bdev->bdev.name);
+	SPDK_NOTICELOG("Started %s on raid bdev %s%s\n",
+		       raid_bdev_process_to_str(process->type), raid_bdev->bdev.name,
+		       process->wi_bitmap_resync ? " using write-intent bitmap" : "");
 
 	raid_bdev_process_thread_run(process);
 }
@@ -2933,7 +3597,9 @@ raid_bdev_channels_abort_start_process_done(struct spdk_io_channel_iter *i, int
 {
 	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
 
-	_raid_bdev_remove_base_bdev(process->target, NULL, NULL);
+	if (process->target != NULL) {
+		_raid_bdev_remove_base_bdev(process->target, NULL, NULL);
+	}
 	raid_bdev_process_free(process);
 
 	/* TODO: update sb */
@@ -2942,10 +3608,13 @@ raid_bdev_channels_abort_start_process_done(struct spdk_io_channel_iter *i, int
 static void
 raid_bdev_channel_abort_start_process(struct spdk_io_channel_iter *i)
 {
+	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
 	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
 	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
 
-	raid_bdev_ch_process_cleanup(raid_ch);
+	if (process->target != NULL) {
+		raid_bdev_ch_process_cleanup(raid_ch);
+	}
 
 	spdk_for_each_channel_continue(i, 0);
 }
@@ -2958,7 +3627,7 @@ raid_bdev_channels_start_process_done(struct spdk_io_channel_iter *i, int status
 	struct spdk_thread *thread;
 	char thread_name[RAID_BDEV_SB_NAME_SIZE + 16];
 
-	if (status == 0 &&
+	if (status == 0 && process->target != NULL &&
 	    (process->target->remove_scheduled || !process->target->is_configured ||
 	     raid_bdev->num_base_bdevs_operational <= raid_bdev->min_base_bdevs_operational)) {
 		/* a base bdev was removed before we got here */
@@ -2998,9 +3667,12 @@ raid_bdev_channel_start_process(struct spdk_io_channel_iter *i)
 	struct raid_bdev_process *process = spdk_io_channel_iter_get_ctx(i);
 	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
 	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
-	int rc;
+	int rc = 0;
 
-	rc = raid_bdev_ch_process_setup(raid_ch, process);
+	/* with a pending reshape the channels are already split at the reshape offset */
+	if (process->target != NULL) {
+		rc = raid_bdev_ch_process_setup(raid_ch, process);
+	}
 
 	spdk_for_each_channel_continue(i, rc);
 }
@@ -3082,6 +3754,8 @@ raid_bdev_process_alloc(struct raid_bdev *raid_bdev, enum raid_process_type type
 	process->raid_bdev = raid_bdev;
 	process->type = type;
 	process->target = target;
+	process->wi_bitmap_resync = target != NULL && target->wi_bitmap_resync &&
+				    raid_bdev->wi_bitmap != NULL;
 	process->max_window_size = spdk_max(spdk_divide_round_up(g_opts.process_window_size_kb * 1024UL,
 					    spdk_bdev_get_data_block_size(&raid_bdev->bdev)),
 					    raid_bdev->bdev.write_unit_size);
@@ -3127,7 +3801,28 @@ raid_bdev_start_rebuild(struct raid_base_bdev_info *target)
 	return 0;
 }
 
+static int
+raid_bdev_start_reshape(struct raid_bdev *raid_bdev)
+{
+	struct raid_bdev_process *process;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(raid_bdev->reshape.num_base_bdevs_old != 0);
+
+	process = raid_bdev_process_alloc(raid_bdev, RAID_PROCESS_RESHAPE, NULL);
+	if (process == NULL) {
+		return -ENOMEM;
+	}
+
+	process->window_offset = raid_bdev->reshape.offset;
+
+	raid_bdev_process_start(process);
+
+	return 0;
+}
+
 static void raid_bdev_configure_base_bdev_cont(struct raid_base_bdev_info *base_info);
+static void raid_bdev_grow_base_bdev_cont(struct raid_base_bdev_info *base_info);
 
 static void
 _raid_bdev_configure_base_bdev_cont(struct spdk_io_channel_iter *i, int status)
@@ -3150,6 +3845,11 @@ raid_bdev_configure_base_bdev_cont(struct raid_base_bdev_info *base_info)
 	raid_base_bdev_cb configure_cb;
 	int rc;
 
+	if (base_info->grow_pending) {
+		raid_bdev_grow_base_bdev_cont(base_info);
+		return;
+	}
+
 	if (raid_bdev->num_base_bdevs_discovered == raid_bdev->num_base_bdevs_operational &&
 	    base_info->is_process_target == false) {
 		/* TODO: defer if rebuild in progress on another base bdev */
@@ -3213,6 +3913,12 @@ raid_bdev_configure_base_bdev_check_sb_cb(const struct raid_bdev_superblock *sb,
 	case 0:
 		/* valid superblock found */
 		base_info->configure_cb = NULL;
+		if (base_info->grow_pending) {
+			SPDK_ERRLOG("Superblock of a raid bdev found on bdev %s\n", base_info->name);
+			status = -EEXIST;
+			raid_bdev_free_base_bdev_resource(base_info);
+			break;
+		}
 		if (spdk_uuid_compare(&base_info->raid_bdev->bdev.uuid, &sb->uuid) == 0) {
 			struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(base_info->desc);
 
@@ -3485,6 +4191,7 @@ raid_bdev_add_base_bdev(struct raid_bdev *raid_bdev, const char *name,
 	if (base_info->name == NULL) {
 		return -ENOMEM;
 	}
+	base_info->wi_bitmap_resync = false;
 
 	rc = raid_bdev_configure_base_bdev(base_info, false, cb_fn, cb_ctx);
 	if (rc != 0 && (rc != -ENODEV || raid_bdev->state != RAID_BDEV_STATE_CONFIGURING)) {
@@ -3496,6 +4203,379 @@ raid_bdev_add_base_bdev(struct raid_bdev *raid_bdev, const char *name,
 	return rc;
 }
 
+struct raid_bdev_grow_ctx {
+	struct raid_bdev		*raid_bdev;
+	struct raid_base_bdev_info	*base_info;
+	raid_base_bdev_cb		cb_fn;
+	void				*cb_ctx;
+	int				status;
+	char				name[];
+};
+
+static void
+raid_bdev_grow_base_bdev_unquiesced(void *_ctx, int status)
+{
+	struct raid_bdev_grow_ctx *ctx = _ctx;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	int rc;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to unquiesce raid bdev %s: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+	}
+
+	raid_bdev->grow_started = false;
+
+	if (ctx->status == 0 && raid_bdev->reshape.num_base_bdevs_old != 0) {
+		rc = raid_bdev_start_reshape(raid_bdev);
+		if (rc != 0) {
+			SPDK_ERRLOG("Failed to start reshape of raid bdev '%s': %s\n",
+				    raid_bdev->bdev.name, spdk_strerror(-rc));
+		}
+	}
+
+	if (ctx->cb_fn != NULL) {
+		ctx->cb_fn(ctx->cb_ctx, ctx->status);
+	}
+
+	free(ctx);
+}
+
+static void
+raid_bdev_grow_base_bdev_done(struct raid_bdev_grow_ctx *ctx, int status)
+{
+	int rc;
+
+	if (ctx->status == 0) {
+		ctx->status = status;
+	}
+
+	rc = spdk_bdev_unquiesce(&ctx->raid_bdev->bdev, &g_raid_if,
+				 raid_bdev_grow_base_bdev_unquiesced, ctx);
+	if (rc != 0) {
+		raid_bdev_grow_base_bdev_unquiesced(ctx, rc);
+	}
+}
+
+static void
+raid_bdev_grow_base_bdev_write_sb_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to write raid bdev '%s' superblock after adding base bdev: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+	}
+
+	raid_bdev_grow_base_bdev_done(ctx, status);
+}
+
+static void
+raid_bdev_grow_base_bdev_configured(void *_ctx, int status)
+{
+	struct raid_bdev_grow_ctx *ctx = _ctx;
+	struct raid_base_bdev_info *base_info = ctx->base_info;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to configure base bdev '%s': %s\n",
+			    ctx->name, spdk_strerror(-status));
+		free(base_info->name);
+		base_info->name = NULL;
+	}
+
+	base_info->grow_pending = false;
+
+	raid_bdev_grow_base_bdev_done(ctx, status);
+}
+
+static void
+raid_bdev_channel_grow_rollback(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_grow_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	uint8_t slot = raid_bdev_base_bdev_slot(ctx->base_info);
+
+	if (slot < raid_ch->num_base_channels && raid_ch->base_channel[slot] != NULL) {
+		spdk_put_io_channel(raid_ch->base_channel[slot]);
+		raid_ch->base_channel[slot] = NULL;
+	}
+
+	raid_bdev_ch_process_cleanup(raid_ch);
+
+	spdk_for_each_channel_continue(i, 0);
+}
+
+static void
+raid_bdev_channels_grow_rollback_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_grow_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_base_bdev_info *base_info = ctx->base_info;
+	raid_base_bdev_cb configure_cb = base_info->configure_cb;
+
+	raid_bdev->num_base_bdevs--;
+	if (raid_bdev->module->base_bdevs_constraint.type != CONSTRAINT_MIN_BASE_BDEVS_OPERATIONAL) {
+		raid_bdev->min_base_bdevs_operational--;
+	}
+	raid_bdev->num_base_bdevs_discovered--;
+	raid_bdev->num_base_bdevs_operational--;
+	raid_bdev->reshape.num_base_bdevs_old = 0;
+	raid_bdev->reshape.offset = 0;
+
+	base_info->is_configured = false;
+	base_info->configure_cb = NULL;
+	raid_bdev_free_base_bdev_resource(base_info);
+
+	configure_cb(base_info->configure_cb_ctx, ctx->status);
+}
+
+static void
+raid_bdev_grow_base_bdev_rollback(struct raid_bdev_grow_ctx *ctx, int status)
+{
+	ctx->status = status;
+
+	spdk_for_each_channel(ctx->raid_bdev, raid_bdev_channel_grow_rollback, ctx,
+			      raid_bdev_channels_grow_rollback_done);
+}
+
+static void
+raid_bdev_channels_grow_done(struct spdk_io_channel_iter *i, int status)
+{
+	struct raid_bdev_grow_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_base_bdev_info *base_info = ctx->base_info;
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	raid_base_bdev_cb configure_cb;
+
+	if (status == 0 && raid_bdev->module->grow != NULL) {
+		status = raid_bdev->module->grow(raid_bdev);
+	}
+
+	if (status != 0) {
+		raid_bdev_grow_base_bdev_rollback(ctx, status);
+		return;
+	}
+
+	SPDK_NOTICELOG("Base bdev '%s' added to raid bdev '%s'%s\n", base_info->name,
+		       raid_bdev->bdev.name,
+		       raid_bdev->reshape.num_base_bdevs_old != 0 ? ", starting reshape" : "");
+
+	configure_cb = base_info->configure_cb;
+	base_info->configure_cb = NULL;
+	base_info->grow_pending = false;
+
+	if (raid_bdev->superblock_enabled) {
+		raid_bdev_superblock_add_base_bdev(raid_bdev, base_info);
+		sb->reshape_num_base_bdevs_old = raid_bdev->reshape.num_base_bdevs_old;
+		sb->reshape_offset = raid_bdev->reshape.offset;
+		raid_bdev_sb_update_size(raid_bdev);
+		raid_bdev_write_superblock(raid_bdev, raid_bdev_grow_base_bdev_write_sb_cb, ctx);
+	} else {
+		configure_cb(base_info->configure_cb_ctx, 0);
+	}
+}
+
+static void
+raid_bdev_channel_grow(struct spdk_io_channel_iter *i)
+{
+	struct raid_bdev_grow_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	struct raid_bdev_io_channel *raid_ch = spdk_io_channel_get_ctx(ch);
+	uint8_t slot = raid_bdev_base_bdev_slot(ctx->base_info);
+	struct spdk_io_channel **base_channel;
+	int rc = 0;
+
+	/* channels created after the base bdev was added are already complete */
+	if (raid_ch->num_base_channels < raid_bdev->num_base_bdevs) {
+		base_channel = realloc(raid_ch->base_channel,
+				       raid_bdev->num_base_bdevs * sizeof(*base_channel));
+		if (base_channel == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+		raid_ch->base_channel = base_channel;
+		raid_ch->num_base_channels = raid_bdev->num_base_bdevs;
+		base_channel[slot] = NULL;
+	}
+
+	if (raid_ch->base_channel[slot] == NULL) {
+		raid_ch->base_channel[slot] = spdk_bdev_get_io_channel(ctx->base_info->desc);
+		if (raid_ch->base_channel[slot] == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+	}
+
+	if (raid_bdev->reshape.num_base_bdevs_old != 0 && raid_ch->process.ch_processed == NULL) {
+		rc = raid_bdev_ch_process_setup(raid_ch, NULL);
+	}
+out:
+	spdk_for_each_channel_continue(i, rc);
+}
+
+static void
+raid_bdev_grow_base_bdev_cont(struct raid_base_bdev_info *base_info)
+{
+	struct raid_bdev *raid_bdev = base_info->raid_bdev;
+	struct raid_bdev_grow_ctx *ctx = base_info->configure_cb_ctx;
+	uint8_t num_base_bdevs_old = raid_bdev->num_base_bdevs;
+
+	assert(raid_bdev_base_bdev_slot(base_info) == raid_bdev->num_base_bdevs);
+
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE || raid_bdev->destroy_started) {
+		raid_base_bdev_cb configure_cb = base_info->configure_cb;
+
+		base_info->configure_cb = NULL;
+		raid_bdev_free_base_bdev_resource(base_info);
+		configure_cb(ctx, -ENODEV);
+		return;
+	}
+
+	base_info->is_configured = true;
+	raid_bdev->num_base_bdevs++;
+	if (raid_bdev->module->base_bdevs_constraint.type != CONSTRAINT_MIN_BASE_BDEVS_OPERATIONAL) {
+		raid_bdev->min_base_bdevs_operational++;
+	}
+	raid_bdev->num_base_bdevs_discovered++;
+	raid_bdev->num_base_bdevs_operational++;
+
+	if (raid_bdev->module->grow_restripe) {
+		raid_bdev->reshape.num_base_bdevs_old = num_base_bdevs_old;
+		raid_bdev->reshape.offset = 0;
+	}
+
+	spdk_for_each_channel(raid_bdev, raid_bdev_channel_grow, ctx, raid_bdev_channels_grow_done);
+}
+
+static void
+raid_bdev_grow_base_bdev_on_quiesced(void *_ctx, int status)
+{
+	struct raid_bdev_grow_ctx *ctx = _ctx;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_base_bdev_info *base_info_array;
+	struct raid_base_bdev_info *base_info;
+	int rc;
+
+	if (status != 0) {
+		SPDK_ERRLOG("Failed to quiesce raid bdev %s: %s\n",
+			    raid_bdev->bdev.name, spdk_strerror(-status));
+		raid_bdev->grow_started = false;
+		if (ctx->cb_fn != NULL) {
+			ctx->cb_fn(ctx->cb_ctx, status);
+		}
+		free(ctx);
+		return;
+	}
+
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE || raid_bdev->destroy_started) {
+		raid_bdev_grow_base_bdev_done(ctx, -ENODEV);
+		return;
+	}
+
+	/* no I/O may reference the base bdevs array while it is reallocated */
+	base_info_array = realloc(raid_bdev->base_bdev_info,
+				  (raid_bdev->num_base_bdevs + 1) * sizeof(*base_info_array));
+	if (base_info_array == NULL) {
+		raid_bdev_grow_base_bdev_done(ctx, -ENOMEM);
+		return;
+	}
+	raid_bdev->base_bdev_info = base_info_array;
+
+	base_info = &raid_bdev->base_bdev_info[raid_bdev->num_base_bdevs];
+	memset(base_info, 0, sizeof(*base_info));
+	base_info->raid_bdev = raid_bdev;
+	base_info->grow_pending = true;
+	ctx->base_info = base_info;
+
+	base_info->name = strdup(ctx->name);
+	if (base_info->name == NULL) {
+		raid_bdev_grow_base_bdev_configured(ctx, -ENOMEM);
+		return;
+	}
+
+	rc = raid_bdev_configure_base_bdev(base_info, false, raid_bdev_grow_base_bdev_configured, ctx);
+	if (rc != 0) {
+		raid_bdev_grow_base_bdev_configured(ctx, rc);
+	}
+}
+
+/*
+ * Add a new base bdev to an online raid bdev, increasing its capacity. If the module needs
+ * to restripe the existing data, a reshape process is started after the base bdev is added
+ * and the additional capacity becomes available when it completes.
+ */
+int
+raid_bdev_grow_base_bdev(struct raid_bdev *raid_bdev, const char *name,
+			 raid_base_bdev_cb cb_fn, void *cb_ctx)
+{
+	struct raid_bdev_grow_ctx *ctx;
+	struct raid_base_bdev_info *base_info;
+	int rc;
+
+	assert(name != NULL);
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+
+	if (raid_bdev->state != RAID_BDEV_STATE_ONLINE || raid_bdev->destroy_started) {
+		SPDK_ERRLOG("raid bdev '%s' is not online\n", raid_bdev->bdev.name);
+		return -EINVAL;
+	}
+
+	if (raid_bdev->module->grow == NULL) {
+		SPDK_ERRLOG("raid bdev '%s' of level %s does not support growing\n",
+			    raid_bdev->bdev.name, raid_bdev_level_to_str(raid_bdev->level));
+		return -ENOTSUP;
+	}
+
+	if (raid_bdev->module->grow_restripe && !raid_bdev->superblock_enabled) {
+		SPDK_ERRLOG("raid bdev '%s' requires a superblock to be grown\n",
+			    raid_bdev->bdev.name);
+		return -EINVAL;
+	}
+
+	if (raid_bdev->process != NULL || raid_bdev->reshape.num_base_bdevs_old != 0 ||
+	    raid_bdev->grow_started) {
+		SPDK_ERRLOG("raid bdev '%s' is in process\n", raid_bdev->bdev.name);
+		return -EBUSY;
+	}
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		if (base_info->remove_scheduled) {
+			SPDK_ERRLOG("raid bdev '%s' has a base bdev being removed\n",
+				    raid_bdev->bdev.name);
+			return -EBUSY;
+		}
+	}
+
+	if (raid_bdev->num_base_bdevs == UINT8_MAX ||
+	    raid_bdev->num_base_bdevs_discovered != raid_bdev->num_base_bdevs) {
+		SPDK_ERRLOG("raid bdev '%s' can't be grown with %u of %u base bdevs\n",
+			    raid_bdev->bdev.name, raid_bdev->num_base_bdevs_discovered,
+			    raid_bdev->num_base_bdevs);
+		return -EINVAL;
+	}
+
+	ctx = calloc(1, sizeof(*ctx) + strlen(name) + 1);
+	if (ctx == NULL) {
+		return -ENOMEM;
+	}
+
+	ctx->raid_bdev = raid_bdev;
+	ctx->cb_fn = cb_fn;
+	ctx->cb_ctx = cb_ctx;
+	strcpy(ctx->name, name);
+
+	raid_bdev->grow_started = true;
+
+	rc = spdk_bdev_quiesce(&raid_bdev->bdev, &g_raid_if, raid_bdev_grow_base_bdev_on_quiesced, ctx);
+	if (rc != 0) {
+		raid_bdev->grow_started = false;
+		free(ctx);
+		return rc;
+	}
+
+	return 0;
+}
+
 static int
 raid_bdev_create_from_sb(const struct raid_bdev_superblock *sb, struct raid_bdev **raid_bdev_out)
 {
@@ -3504,7 +4584,7 @@ raid_bdev_create_from_sb(const struct raid_bdev_superblock *sb, struct raid_bdev
 	int rc;
 
 	rc = _raid_bdev_create(sb->name, (sb->strip_size * sb->block_size) / 1024, sb->num_base_bdevs,
-			       sb->level, true, &sb->uuid, &raid_bdev);
+			       sb->level, true, &sb->uuid, sb->read_policy, &raid_bdev);
 	if (rc != 0) {
 		return rc;
 	}
@@ -3531,6 +4611,9 @@ raid_bdev_create_from_sb(const struct raid_bdev_superblock *sb, struct raid_bdev
 		base_info->data_size = sb_base_bdev->data_size;
 	}
 
+	raid_bdev->reshape.num_base_bdevs_old = sb->reshape_num_base_bdevs_old;
+	raid_bdev->reshape.offset = sb->reshape_offset;
+
 	*raid_bdev_out = raid_bdev;
 	return 0;
 }
@@ -3739,9 +4822,16 @@ raid_bdev_examine_sb(const struct raid_bdev_superblock *sb, struct spdk_bdev *bd
 		       sb_base_bdev->state == RAID_SB_BASE_BDEV_FAILED);
 		assert(spdk_uuid_is_null(&base_info->uuid));
 		spdk_uuid_copy(&base_info->uuid, &sb_base_bdev->uuid);
+		/*
+		 * The bitmap has been maintained since the base bdev was last in sync, so only
+		 * the regions marked in it need to be rebuilt.
+		 */
+		base_info->wi_bitmap_resync = raid_bdev->wi_bitmap != NULL &&
+					      (sb_base_bdev->flags & RAID_SB_BASE_BDEV_FLAG_WI_BITMAP);
 		SPDK_NOTICELOG("Re-adding bdev %s to raid bdev %s.\n", bdev->name, raid_bdev->bdev.name);
 		rc = raid_bdev_configure_base_bdev(base_info, true, cb_fn, cb_ctx);
 		if (rc != 0) {
+			base_info->wi_bitmap_resync = false;
 			SPDK_ERRLOG("Failed to configure bdev %s as base bdev of raid %s: %s\n",
 				    bdev->name, raid_bdev->bdev.name, spdk_strerror(-rc));
 		}
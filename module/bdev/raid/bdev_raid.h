@@ -15,10 +15,25 @@ enum raid_level {
 	INVALID_RAID_LEVEL	= -1,
 	RAID0			= 0,
 	RAID1			= 1,
+	RAID6			= 6,
 	RAID5F			= 95, /* 0x5f */
 	CONCAT			= 99,
 };
 
+/*
+ * Policy used by raid levels with mirrored data to select the base bdev that
+ * serves a read request.
+ */
+enum raid_read_policy {
+	/* The base bdev with the fewest outstanding read blocks on the channel */
+	RAID_READ_POLICY_LEAST_OUTSTANDING	= 0,
+	/* The base bdev with the lowest expected latency based on past completions */
+	RAID_READ_POLICY_LATENCY		= 1,
+	/* The base bdev already serving a sequential stream close to the read offset */
+	RAID_READ_POLICY_SEQUENTIAL		= 2,
+	RAID_READ_POLICY_MAX,
+};
+
 /*
  * Raid state describes the state of the raid. This raid bdev can be either in
  * configured list or configuring list
@@ -46,6 +61,7 @@ enum raid_bdev_state {
 enum raid_process_type {
 	RAID_PROCESS_NONE,
 	RAID_PROCESS_REBUILD,
+	RAID_PROCESS_RESHAPE,
 	RAID_PROCESS_MAX
 };
 
@@ -106,6 +122,15 @@ struct raid_base_bdev_info {
 	/* Set to true to indicate that the base bdev is being removed because of a failure */
 	bool			is_failed;
 
+	/*
+	 * Set to true if this base bdev is re-added and only the regions marked in the
+	 * write-intent bitmap need to be rebuilt
+	 */
+	bool			wi_bitmap_resync;
+
+	/* Set to true if this base bdev is being added to grow the raid bdev */
+	bool			grow_pending;
+
 	/* callback for base bdev configuration */
 	raid_base_bdev_cb	configure_cb;
 
@@ -153,6 +178,9 @@ struct raid_bdev_io {
 	/* Custom completion callback. Overrides bdev_io completion if set. */
 	raid_bdev_io_completion_cb	completion_cb;
 
+	/* Time of submission to the base bdev(s), for modules tracking base bdev latency */
+	uint64_t			base_bdev_io_submit_tsc;
+
 	struct {
 		uint64_t		offset;
 		struct iovec		*iov;
@@ -225,9 +253,15 @@ struct raid_bdev {
 	/* Raid Level of this raid bdev */
 	enum raid_level			level;
 
+	/* Read policy of this raid bdev, used by levels that support it */
+	enum raid_read_policy		read_policy;
+
 	/* Set to true if destroy of this raid bdev is started. */
 	bool				destroy_started;
 
+	/* Set to true while a base bdev is being added to grow this raid bdev. */
+	bool				grow_started;
+
 	/* Module for RAID-level specific operations */
 	struct raid_bdev_module		*module;
 
@@ -242,9 +276,22 @@ struct raid_bdev {
 	void				*sb_io_buf;
 	uint32_t			sb_io_buf_size;
 
+	/* Write-intent bitmap, NULL if not enabled */
+	struct raid_bdev_wi_bitmap	*wi_bitmap;
+
 	/* Raid bdev background process, e.g. rebuild */
 	struct raid_bdev_process	*process;
 
+	/*
+	 * Reshape state. num_base_bdevs_old is 0 if no reshape is pending. Otherwise, data
+	 * below offset is laid out across all num_base_bdevs and the rest across the first
+	 * num_base_bdevs_old base bdevs.
+	 */
+	struct {
+		uint8_t			num_base_bdevs_old;
+		uint64_t		offset;
+	} reshape;
+
 	/* Callback and context for raid_bdev configuration */
 	raid_bdev_configure_cb		configure_cb;
 	void				*configure_cb_ctx;
@@ -264,19 +311,38 @@ typedef void (*raid_bdev_destruct_cb)(void *cb_ctx, int rc);
 
 int raid_bdev_create(const char *name, uint32_t strip_size, uint8_t num_base_bdevs,
 		     enum raid_level level, bool superblock, const struct spdk_uuid *uuid,
-		     struct raid_bdev **raid_bdev_out);
+		     enum raid_read_policy read_policy, struct raid_bdev **raid_bdev_out);
 void raid_bdev_delete(struct raid_bdev *raid_bdev, raid_bdev_destruct_cb cb_fn, void *cb_ctx);
 int raid_bdev_add_base_bdev(struct raid_bdev *raid_bdev, const char *name,
 			    raid_base_bdev_cb cb_fn, void *cb_ctx);
+int raid_bdev_grow_base_bdev(struct raid_bdev *raid_bdev, const char *name,
+			     raid_base_bdev_cb cb_fn, void *cb_ctx);
 struct raid_bdev *raid_bdev_find_by_name(const char *name);
 enum raid_level raid_bdev_str_to_level(const char *str);
 const char *raid_bdev_level_to_str(enum raid_level level);
+enum raid_read_policy raid_bdev_str_to_read_policy(const char *str);
+const char *raid_bdev_read_policy_to_str(enum raid_read_policy read_policy);
 enum raid_bdev_state raid_bdev_str_to_state(const char *str);
 const char *raid_bdev_state_to_str(enum raid_bdev_state state);
 const char *raid_bdev_process_to_str(enum raid_process_type value);
 void raid_bdev_write_info_json(struct raid_bdev *raid_bdev, struct spdk_json_write_ctx *w);
 int raid_bdev_remove_base_bdev(struct spdk_bdev *base_bdev, raid_base_bdev_cb cb_fn, void *cb_ctx);
 
+/* Per base bdev read statistics */
+struct raid_base_bdev_read_stats {
+	/* Number of completed read requests */
+	uint64_t	num_read_ops;
+	/* Number of bytes read */
+	uint64_t	bytes_read;
+	/* Sum of read latencies in ticks */
+	uint64_t	read_latency_ticks;
+};
+
+typedef void (*raid_bdev_get_read_stats_cb)(struct raid_bdev *raid_bdev,
+		struct raid_base_bdev_read_stats *stats, int status, void *cb_ctx);
+int raid_bdev_get_read_stats(struct raid_bdev *raid_bdev, raid_bdev_get_read_stats_cb cb_fn,
+			     void *cb_ctx);
+
 /*
  * RAID module descriptor
  */
@@ -306,6 +372,20 @@ struct raid_bdev_module {
 	/* Set to true if this module supports DIF/DIX */
 	bool dif_supported;
 
+	/*
+	 * Set to true if this module supports the write-intent bitmap. It is then
+	 * maintained for all writes when the superblock is enabled and used to limit
+	 * rebuild of a re-added base bdev to the regions written while it was missing.
+	 */
+	bool wi_bitmap_supported;
+
+	/*
+	 * Set to true if growing the raid requires restriping the existing data across
+	 * all base bdevs. It is then done by a background reshape process, which requires
+	 * the superblock to record its progress, and submit_process_request must be set.
+	 */
+	bool grow_restripe;
+
 	/*
 	 * Called when the raid is starting, right before changing the state to
 	 * online and registering the bdev. Parameters of the bdev like blockcnt
@@ -345,10 +425,30 @@ struct raid_bdev_module {
 	 */
 	bool (*resize)(struct raid_bdev *raid_bdev);
 
+	/*
+	 * Called with the raid bdev quiesced after a base bdev has been appended to grow the
+	 * raid. num_base_bdevs already includes the new base bdev, which is the last one.
+	 * Modules without grow_restripe should update the bdev's blockcnt here. With
+	 * grow_restripe, reshape.num_base_bdevs_old is the previous number of base bdevs and
+	 * resize is called after the reshape completes. Optional.
+	 *
+	 * Non-zero return value will abort growing the raid.
+	 */
+	int (*grow)(struct raid_bdev *raid_bdev);
+
 	/* Handler for raid process requests. Required for raid modules with redundancy. */
 	int (*submit_process_request)(struct raid_bdev_process_request *process_req,
 				      struct raid_bdev_io_channel *raid_ch);
 
+	/*
+	 * Add the per base bdev read statistics collected on raid_ch to stats, an array of
+	 * num_base_bdevs elements. Called on the thread of each raid bdev io channel and then
+	 * once with raid_ch set to NULL to add statistics of channels that were destroyed.
+	 * Optional.
+	 */
+	void (*get_read_stats)(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+			       struct raid_base_bdev_read_stats *stats);
+
 	TAILQ_ENTRY(raid_bdev_module) link;
 };
 
@@ -381,6 +481,7 @@ void raid_bdev_io_init(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel
 		       uint64_t num_blocks, struct iovec *iovs, int iovcnt, void *md_buf,
 		       struct spdk_memory_domain *memory_domain, void *memory_domain_ctx);
 void raid_bdev_fail_base_bdev(struct raid_base_bdev_info *base_info);
+uint8_t raid_bdev_io_get_num_base_bdevs(struct raid_bdev_io *raid_io);
 
 static inline uint8_t
 raid_bdev_base_bdev_slot(struct raid_base_bdev_info *base_info)
@@ -468,7 +569,7 @@ raid_bdev_flush_blocks(struct raid_base_bdev_info *base_info, struct spdk_io_cha
  */
 
 #define RAID_BDEV_SB_VERSION_MAJOR	1
-#define RAID_BDEV_SB_VERSION_MINOR	0
+#define RAID_BDEV_SB_VERSION_MINOR	2
 
 #define RAID_BDEV_SB_NAME_SIZE		64
 
@@ -479,6 +580,9 @@ enum raid_bdev_sb_base_bdev_state {
 	RAID_SB_BASE_BDEV_SPARE		= 3,
 };
 
+/* The base bdev was in sync when the write-intent bitmap was active */
+#define RAID_SB_BASE_BDEV_FLAG_WI_BITMAP	(1 << 0)
+
 struct raid_bdev_sb_base_bdev {
 	/* uuid of the base bdev */
 	struct spdk_uuid	uuid;
@@ -511,6 +615,7 @@ struct raid_bdev_superblock {
 	/* crc32c checksum of the entire superblock */
 	uint32_t		crc;
 	/* feature/status flags */
+#define RAID_BDEV_SB_FLAG_WI_BITMAP	(1 << 0)
 	uint32_t		flags;
 	/* unique id of the raid bdev */
 	struct spdk_uuid	uuid;
@@ -530,8 +635,23 @@ struct raid_bdev_superblock {
 	uint64_t		seq_number;
 	/* number of raid base devices */
 	uint8_t			num_base_bdevs;
+	/* read policy of the raid */
+	uint8_t			read_policy;
 
-	uint8_t			reserved[118];
+	uint8_t			reserved1[6];
+
+	/* offset in blocks from base device start to the write-intent bitmap */
+	uint64_t		wi_bitmap_offset;
+	/* size in blocks of the region tracked by one write-intent bitmap bit */
+	uint64_t		wi_bitmap_region_size;
+	/* number of regions tracked by the write-intent bitmap */
+	uint64_t		wi_bitmap_num_regions;
+	/* offset in blocks up to which the data was restriped by a pending reshape */
+	uint64_t		reshape_offset;
+	/* number of base bdevs before the reshape, 0 if there is no reshape pending */
+	uint8_t			reshape_num_base_bdevs_old;
+
+	uint8_t			reserved[78];
 
 	/* size of the base bdevs array */
 	uint8_t			base_bdevs_size;
@@ -545,8 +665,64 @@ SPDK_STATIC_ASSERT(sizeof(struct raid_bdev_superblock) == 256, "incorrect size")
 SPDK_STATIC_ASSERT(RAID_BDEV_SB_MAX_LENGTH < RAID_BDEV_MIN_DATA_OFFSET_SIZE,
 		   "Incorrect min data offset");
 
+/*
+ * Definitions related to raid bdev write-intent bitmap
+ */
+
+/* offset in bytes from base device start to the write-intent bitmap */
+#define RAID_BDEV_WI_BITMAP_OFFSET		(64 * 1024)
+#define RAID_BDEV_WI_BITMAP_MAX_SIZE		(128 * 1024)
+#define RAID_BDEV_WI_BITMAP_REGION_SIZE_DEFAULT	(64 * 1024 * 1024)
+
+SPDK_STATIC_ASSERT(RAID_BDEV_SB_MAX_LENGTH <= RAID_BDEV_WI_BITMAP_OFFSET,
+		   "Incorrect write-intent bitmap offset");
+SPDK_STATIC_ASSERT(RAID_BDEV_WI_BITMAP_OFFSET + RAID_BDEV_WI_BITMAP_MAX_SIZE <=
+		   RAID_BDEV_MIN_DATA_OFFSET_SIZE, "Incorrect min data offset");
+
+/*
+ * The write-intent bitmap has one bit per region of the raid bdev. A bit is set and
+ * persisted on all base bdevs before a write to its region is submitted and it is
+ * cleared lazily when the raid bdev is not degraded and there are no writes pending.
+ */
+struct raid_bdev_wi_bitmap {
+	/* bit shift of the region size in blocks */
+	uint32_t			region_shift;
+
+	/* number of regions, the last one also covers any blocks past the end */
+	uint64_t			num_regions;
+
+	/* location of the bitmap on the base bdevs */
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+	uint32_t			block_size;
+
+	/* bits persisted on the base bdevs, accessed atomically from any thread */
+	uint64_t			*bits;
+
+	/* per region count of outstanding writes, accessed atomically from any thread */
+	uint32_t			*pending;
+
+	/* set on a base bdev write failure to prevent clearing bits until the raid is degraded */
+	bool				clear_blocked;
+
+	/* the following fields are accessed only on the app thread */
+
+	/* I/O buffer and the range of its blocks modified since the last write */
+	uint64_t			*buf;
+	uint64_t			dirty_start;
+	uint64_t			dirty_end;
+
+	/* writes waiting for the bitmap to be persisted */
+	TAILQ_HEAD(, spdk_bdev_io_wait_entry) waiters;
+	TAILQ_HEAD(, spdk_bdev_io_wait_entry) waiters_writing;
+	bool				write_in_progress;
+
+	struct spdk_poller		*clear_poller;
+};
+
 typedef void (*raid_bdev_write_sb_cb)(int status, struct raid_bdev *raid_bdev, void *ctx);
 typedef void (*raid_bdev_load_sb_cb)(const struct raid_bdev_superblock *sb, int status, void *ctx);
+typedef void (*raid_bdev_wi_bitmap_cb)(int status, struct raid_bdev *raid_bdev, void *ctx);
 
 int raid_bdev_alloc_superblock(struct raid_bdev *raid_bdev, uint32_t block_size);
 void raid_bdev_free_superblock(struct raid_bdev *raid_bdev);
@@ -555,6 +731,14 @@ void raid_bdev_write_superblock(struct raid_bdev *raid_bdev, raid_bdev_write_sb_
 				void *cb_ctx);
 int raid_bdev_load_base_bdev_superblock(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 					raid_bdev_load_sb_cb cb, void *cb_ctx);
+void raid_bdev_superblock_add_base_bdev(struct raid_bdev *raid_bdev,
+					struct raid_base_bdev_info *base_info);
+int raid_bdev_alloc_wi_bitmap(struct raid_bdev *raid_bdev);
+void raid_bdev_free_wi_bitmap(struct raid_bdev *raid_bdev);
+void raid_bdev_load_wi_bitmap(struct raid_bdev *raid_bdev, raid_bdev_wi_bitmap_cb cb,
+			      void *cb_ctx);
+void raid_bdev_write_wi_bitmap(struct raid_bdev *raid_bdev, raid_bdev_wi_bitmap_cb cb,
+			       void *cb_ctx);
 
 struct spdk_raid_bdev_opts {
 	/* Size of the background process window in KiB */
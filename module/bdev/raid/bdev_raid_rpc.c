@@ -137,6 +137,9 @@ struct rpc_bdev_raid_create {
 
 	/* If set, information about raid bdev will be stored in superblock on each base bdev */
 	bool                                 superblock_enabled;
+
+	/* Read policy */
+	enum raid_read_policy                read_policy;
 };
 
 /*
@@ -163,6 +166,30 @@ decode_raid_level(const struct spdk_json_val *val, void *out)
 	return ret;
 }
 
+/*
+ * Decoder function for RPC bdev_raid_create to decode read policy
+ */
+static int
+decode_read_policy(const struct spdk_json_val *val, void *out)
+{
+	int ret;
+	char *str = NULL;
+	enum raid_read_policy read_policy;
+
+	ret = spdk_json_decode_string(val, &str);
+	if (ret == 0 && str != NULL) {
+		read_policy = raid_bdev_str_to_read_policy(str);
+		if (read_policy == RAID_READ_POLICY_MAX) {
+			ret = -EINVAL;
+		} else {
+			*(enum raid_read_policy *)out = read_policy;
+		}
+	}
+
+	free(str);
+	return ret;
+}
+
 /*
  * Decoder function for RPC bdev_raid_create to decode base bdevs list
  */
@@ -184,6 +211,7 @@ static const struct spdk_json_object_decoder rpc_bdev_raid_create_decoders[] = {
 	{"base_bdevs", offsetof(struct rpc_bdev_raid_create, base_bdevs), decode_base_bdevs},
 	{"uuid", offsetof(struct rpc_bdev_raid_create, uuid), spdk_json_decode_uuid, true},
 	{"superblock", offsetof(struct rpc_bdev_raid_create, superblock_enabled), spdk_json_decode_bool, true},
+	{"read_policy", offsetof(struct rpc_bdev_raid_create, read_policy), decode_read_policy, true},
 };
 
 struct rpc_bdev_raid_create_ctx {
@@ -288,7 +316,8 @@ rpc_bdev_raid_create(struct spdk_jsonrpc_request *request,
 	}
 
 	rc = raid_bdev_create(req->name, req->strip_size_kb, num_base_bdevs,
-			      req->level, req->superblock_enabled, &req->uuid, &raid_bdev);
+			      req->level, req->superblock_enabled, &req->uuid, req->read_policy,
+			      &raid_bdev);
 	if (rc != 0) {
 		spdk_jsonrpc_send_error_response_fmt(request, rc,
 						     "Failed to create RAID bdev %s: %s",
@@ -540,6 +569,68 @@ cleanup:
 }
 SPDK_RPC_REGISTER("bdev_raid_add_base_bdev", rpc_bdev_raid_add_base_bdev, SPDK_RPC_RUNTIME)
 
+static void
+rpc_bdev_raid_grow_base_bdev_done(void *ctx, int status)
+{
+	struct spdk_jsonrpc_request *request = ctx;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, status, "Failed to grow RAID bdev: %s",
+						     spdk_strerror(-status));
+		return;
+	}
+
+	spdk_jsonrpc_send_bool_response(request, true);
+}
+
+/*
+ * brief:
+ * bdev_raid_grow_base_bdev function is the RPC for adding a new base bdev to an online
+ * raid bdev to increase its capacity. It takes base bdev and raid bdev names as input.
+ * params:
+ * request - pointer to json rpc request
+ * params - pointer to request parameters
+ * returns:
+ * none
+ */
+static void
+rpc_bdev_raid_grow_base_bdev(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct rpc_bdev_raid_add_base_bdev req = {};
+	struct raid_bdev *raid_bdev;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_raid_add_base_bdev_decoders,
+				    SPDK_COUNTOF(rpc_bdev_raid_add_base_bdev_decoders),
+				    &req)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_INTERNAL_ERROR,
+						 "spdk_json_decode_object failed");
+		goto cleanup;
+	}
+
+	raid_bdev = raid_bdev_find_by_name(req.raid_bdev);
+	if (raid_bdev == NULL) {
+		spdk_jsonrpc_send_error_response_fmt(request, -ENODEV, "raid bdev %s is not found in config",
+						     req.raid_bdev);
+		goto cleanup;
+	}
+
+	rc = raid_bdev_grow_base_bdev(raid_bdev, req.base_bdev, rpc_bdev_raid_grow_base_bdev_done,
+				      request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response_fmt(request, rc,
+						     "Failed to grow RAID bdev %s with base bdev %s: %s",
+						     req.raid_bdev, req.base_bdev,
+						     spdk_strerror(-rc));
+		goto cleanup;
+	}
+
+cleanup:
+	free_rpc_bdev_raid_add_base_bdev(&req);
+}
+SPDK_RPC_REGISTER("bdev_raid_grow_base_bdev", rpc_bdev_raid_grow_base_bdev, SPDK_RPC_RUNTIME)
+
 /*
  * Decoder object for RPC bdev_raid_remove_base_bdev
  */
@@ -636,3 +727,91 @@ rpc_bdev_raid_set_options(struct spdk_jsonrpc_request *request, const struct spd
 }
 SPDK_RPC_REGISTER("bdev_raid_set_options", rpc_bdev_raid_set_options,
 		  SPDK_RPC_STARTUP | SPDK_RPC_RUNTIME)
+
+/*
+ * Decoder object for RPC bdev_raid_get_read_stats
+ */
+static const struct spdk_json_object_decoder rpc_bdev_raid_get_read_stats_decoders[] = {
+	{"name", 0, spdk_json_decode_string},
+};
+
+static void
+rpc_bdev_raid_get_read_stats_done(struct raid_bdev *raid_bdev,
+				  struct raid_base_bdev_read_stats *stats, int status, void *ctx)
+{
+	struct spdk_jsonrpc_request *request = ctx;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_json_write_ctx *w;
+
+	if (status != 0) {
+		spdk_jsonrpc_send_error_response(request, status, spdk_strerror(-status));
+		return;
+	}
+
+	w = spdk_jsonrpc_begin_result(request);
+	spdk_json_write_object_begin(w);
+	spdk_json_write_named_string(w, "name", raid_bdev->bdev.name);
+	spdk_json_write_named_string(w, "read_policy",
+				     raid_bdev_read_policy_to_str(raid_bdev->read_policy));
+	spdk_json_write_named_uint64(w, "tick_rate", spdk_get_ticks_hz());
+	spdk_json_write_named_array_begin(w, "base_bdevs");
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		struct raid_base_bdev_read_stats *base_stats;
+
+		base_stats = &stats[raid_bdev_base_bdev_slot(base_info)];
+		spdk_json_write_object_begin(w);
+		spdk_json_write_name(w, "name");
+		if (base_info->name) {
+			spdk_json_write_string(w, base_info->name);
+		} else {
+			spdk_json_write_null(w);
+		}
+		spdk_json_write_named_uint64(w, "num_read_ops", base_stats->num_read_ops);
+		spdk_json_write_named_uint64(w, "bytes_read", base_stats->bytes_read);
+		spdk_json_write_named_uint64(w, "read_latency_ticks", base_stats->read_latency_ticks);
+		spdk_json_write_object_end(w);
+	}
+	spdk_json_write_array_end(w);
+	spdk_json_write_object_end(w);
+	spdk_jsonrpc_end_result(request, w);
+}
+
+/*
+ * brief:
+ * rpc_bdev_raid_get_read_stats function is the RPC for getting the per base bdev read
+ * statistics of a raid bdev. It takes the raid bdev name as input.
+ * params:
+ * request - pointer to json rpc request
+ * params - pointer to request parameters
+ * returns:
+ * none
+ */
+static void
+rpc_bdev_raid_get_read_stats(struct spdk_jsonrpc_request *request,
+			     const struct spdk_json_val *params)
+{
+	struct raid_bdev *raid_bdev;
+	char *name = NULL;
+	int rc;
+
+	if (spdk_json_decode_object(params, rpc_bdev_raid_get_read_stats_decoders,
+				    SPDK_COUNTOF(rpc_bdev_raid_get_read_stats_decoders),
+				    &name)) {
+		spdk_jsonrpc_send_error_response(request, SPDK_JSONRPC_ERROR_PARSE_ERROR,
+						 "spdk_json_decode_object failed");
+		return;
+	}
+
+	raid_bdev = raid_bdev_find_by_name(name);
+	free(name);
+	if (raid_bdev == NULL) {
+		spdk_jsonrpc_send_error_response(request, -ENODEV, spdk_strerror(ENODEV));
+		return;
+	}
+
+	rc = raid_bdev_get_read_stats(raid_bdev, rpc_bdev_raid_get_read_stats_done, request);
+	if (rc != 0) {
+		spdk_jsonrpc_send_error_response(request, rc, spdk_strerror(-rc));
+	}
+}
+SPDK_RPC_REGISTER("bdev_raid_get_read_stats", rpc_bdev_raid_get_read_stats, SPDK_RPC_RUNTIME)
@@ -31,6 +31,19 @@ struct raid_bdev_read_sb_ctx {
 	uint32_t buf_size;
 };
 
+struct raid_bdev_wi_bitmap_io_ctx {
+	struct raid_bdev *raid_bdev;
+	int status;
+	uint8_t submitted;
+	uint8_t remaining;
+	uint64_t offset_blocks;
+	uint64_t num_blocks;
+	void *buf;
+	raid_bdev_wi_bitmap_cb cb;
+	void *cb_ctx;
+	struct spdk_bdev_io_wait_entry wait_entry;
+};
+
 int
 raid_bdev_alloc_superblock(struct raid_bdev *raid_bdev, uint32_t block_size)
 {
@@ -77,6 +90,7 @@ raid_bdev_init_superblock(struct raid_bdev *raid_bdev)
 	sb->block_size = spdk_bdev_get_data_block_size(&raid_bdev->bdev);
 	sb->level = raid_bdev->level;
 	sb->strip_size = raid_bdev->strip_size;
+	sb->read_policy = raid_bdev->read_policy;
 	/* TODO: sb->state */
 	sb->num_base_bdevs = sb->base_bdevs_size = raid_bdev->num_base_bdevs;
 	sb->length = sizeof(*sb) + sizeof(*sb_base_bdev) * sb->base_bdevs_size;
@@ -92,6 +106,34 @@ raid_bdev_init_superblock(struct raid_bdev *raid_bdev)
 	}
 }
 
+void
+raid_bdev_superblock_add_base_bdev(struct raid_bdev *raid_bdev,
+				   struct raid_base_bdev_info *base_info)
+{
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	struct raid_bdev_sb_base_bdev *sb_base_bdev;
+
+	assert(sb->base_bdevs_size < UINT8_MAX);
+
+	sb_base_bdev = &sb->base_bdevs[sb->base_bdevs_size];
+	memset(sb_base_bdev, 0, sizeof(*sb_base_bdev));
+	spdk_uuid_copy(&sb_base_bdev->uuid, &base_info->uuid);
+	sb_base_bdev->data_offset = base_info->data_offset;
+	sb_base_bdev->data_size = base_info->data_size;
+	sb_base_bdev->state = RAID_SB_BASE_BDEV_CONFIGURED;
+	sb_base_bdev->slot = raid_bdev_base_bdev_slot(base_info);
+
+	sb->num_base_bdevs++;
+	sb->base_bdevs_size++;
+	sb->length = sizeof(*sb) + sizeof(*sb_base_bdev) * sb->base_bdevs_size;
+
+	/* the I/O buffer is sized for the previous length, let the next write reallocate it */
+	if (raid_bdev->sb_io_buf != NULL && raid_bdev->sb_io_buf != sb) {
+		spdk_dma_free(raid_bdev->sb_io_buf);
+	}
+	raid_bdev->sb_io_buf = NULL;
+}
+
 static int
 raid_bdev_alloc_sb_io_buf(struct raid_bdev *raid_bdev)
 {
@@ -427,4 +469,366 @@ err:
 	cb(rc, raid_bdev, cb_ctx);
 }
 
+static int
+raid_bdev_init_superblock_wi_bitmap(struct raid_bdev *raid_bdev)
+{
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	struct raid_bdev_sb_base_bdev *sb_base_bdev;
+	uint64_t region_size, num_regions, num_blocks, offset_blocks;
+	uint8_t i;
+
+	if (RAID_BDEV_WI_BITMAP_OFFSET % sb->block_size != 0) {
+		return -EINVAL;
+	}
+
+	region_size = spdk_max(1, RAID_BDEV_WI_BITMAP_REGION_SIZE_DEFAULT / sb->block_size);
+	region_size = spdk_align64pow2(region_size);
+	while ((num_regions = spdk_divide_round_up(sb->raid_size, region_size)) >
+	       RAID_BDEV_WI_BITMAP_MAX_SIZE * 8) {
+		region_size <<= 1;
+	}
+
+	offset_blocks = RAID_BDEV_WI_BITMAP_OFFSET / sb->block_size;
+	num_blocks = spdk_divide_round_up(spdk_divide_round_up(num_regions, 64) * sizeof(uint64_t),
+					  sb->block_size);
+
+	for (i = 0; i < sb->base_bdevs_size; i++) {
+		sb_base_bdev = &sb->base_bdevs[i];
+		if (sb_base_bdev->state == RAID_SB_BASE_BDEV_CONFIGURED &&
+		    sb_base_bdev->data_offset < offset_blocks + num_blocks) {
+			return -ENOSPC;
+		}
+	}
+
+	for (i = 0; i < sb->base_bdevs_size; i++) {
+		sb_base_bdev = &sb->base_bdevs[i];
+		/* only the base bdevs that are currently in sync can be resynced using this bitmap */
+		if (sb_base_bdev->state == RAID_SB_BASE_BDEV_CONFIGURED) {
+			sb_base_bdev->flags |= RAID_SB_BASE_BDEV_FLAG_WI_BITMAP;
+		} else {
+			sb_base_bdev->flags &= ~RAID_SB_BASE_BDEV_FLAG_WI_BITMAP;
+		}
+	}
+
+	sb->wi_bitmap_offset = offset_blocks;
+	sb->wi_bitmap_region_size = region_size;
+	sb->wi_bitmap_num_regions = num_regions;
+	sb->flags |= RAID_BDEV_SB_FLAG_WI_BITMAP;
+
+	return 0;
+}
+
+int
+raid_bdev_alloc_wi_bitmap(struct raid_bdev *raid_bdev)
+{
+	struct raid_bdev_superblock *sb = raid_bdev->sb;
+	struct raid_bdev_wi_bitmap *wi_bitmap;
+	uint64_t num_words;
+	int rc;
+
+	assert(sb != NULL);
+	assert(raid_bdev->wi_bitmap == NULL);
+
+	if (spdk_bdev_is_md_interleaved(&raid_bdev->bdev)) {
+		return -ENOTSUP;
+	}
+
+	if ((sb->flags & RAID_BDEV_SB_FLAG_WI_BITMAP) == 0) {
+		rc = raid_bdev_init_superblock_wi_bitmap(raid_bdev);
+		if (rc != 0) {
+			return rc;
+		}
+	}
+
+	if (!spdk_u64_is_pow2(sb->wi_bitmap_region_size) || sb->wi_bitmap_num_regions == 0 ||
+	    sb->wi_bitmap_num_regions > RAID_BDEV_WI_BITMAP_MAX_SIZE * 8) {
+		SPDK_ERRLOG("Invalid write-intent bitmap parameters in raid bdev %s superblock\n",
+			    raid_bdev->bdev.name);
+		return -EINVAL;
+	}
+
+	wi_bitmap = calloc(1, sizeof(*wi_bitmap));
+	if (wi_bitmap == NULL) {
+		return -ENOMEM;
+	}
+
+	num_words = spdk_divide_round_up(sb->wi_bitmap_num_regions, 64);
+
+	wi_bitmap->region_shift = spdk_u64log2(sb->wi_bitmap_region_size);
+	wi_bitmap->num_regions = sb->wi_bitmap_num_regions;
+	wi_bitmap->offset_blocks = sb->wi_bitmap_offset;
+	wi_bitmap->block_size = sb->block_size;
+	wi_bitmap->num_blocks = spdk_divide_round_up(num_words * sizeof(uint64_t), sb->block_size);
+	TAILQ_INIT(&wi_bitmap->waiters);
+	TAILQ_INIT(&wi_bitmap->waiters_writing);
+
+	/* the whole bitmap is written on the first flush */
+	wi_bitmap->dirty_start = 0;
+	wi_bitmap->dirty_end = wi_bitmap->num_blocks;
+
+	wi_bitmap->bits = calloc(num_words, sizeof(uint64_t));
+	wi_bitmap->pending = calloc(wi_bitmap->num_regions, sizeof(uint32_t));
+	wi_bitmap->buf = spdk_dma_zmalloc(wi_bitmap->num_blocks * wi_bitmap->block_size, 0x1000, NULL);
+	if (wi_bitmap->bits == NULL || wi_bitmap->pending == NULL || wi_bitmap->buf == NULL) {
+		free(wi_bitmap->bits);
+		free(wi_bitmap->pending);
+		spdk_dma_free(wi_bitmap->buf);
+		free(wi_bitmap);
+		return -ENOMEM;
+	}
+
+	raid_bdev->wi_bitmap = wi_bitmap;
+
+	return 0;
+}
+
+void
+raid_bdev_free_wi_bitmap(struct raid_bdev *raid_bdev)
+{
+	struct raid_bdev_wi_bitmap *wi_bitmap = raid_bdev->wi_bitmap;
+
+	if (wi_bitmap == NULL) {
+		return;
+	}
+
+	assert(TAILQ_EMPTY(&wi_bitmap->waiters));
+	assert(TAILQ_EMPTY(&wi_bitmap->waiters_writing));
+
+	free(wi_bitmap->bits);
+	free(wi_bitmap->pending);
+	spdk_dma_free(wi_bitmap->buf);
+	free(wi_bitmap);
+	raid_bdev->wi_bitmap = NULL;
+}
+
+static void
+raid_bdev_wi_bitmap_io_done(struct raid_bdev_wi_bitmap_io_ctx *ctx)
+{
+	ctx->cb(ctx->status, ctx->raid_bdev, ctx->cb_ctx);
+	spdk_dma_free(ctx->buf);
+	free(ctx);
+}
+
+static void _raid_bdev_load_wi_bitmap(void *_ctx);
+
+static void
+raid_bdev_load_wi_bitmap_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_wi_bitmap_io_ctx *ctx = cb_arg;
+	struct raid_bdev_wi_bitmap *wi_bitmap = ctx->raid_bdev->wi_bitmap;
+	uint64_t *bits = ctx->buf;
+	uint64_t i;
+
+	if (!success) {
+		SPDK_ERRLOG("Failed to load write-intent bitmap from bdev %s\n", bdev_io->bdev->name);
+		spdk_bdev_free_io(bdev_io);
+		ctx->status = -EIO;
+		raid_bdev_wi_bitmap_io_done(ctx);
+		return;
+	}
+
+	spdk_bdev_free_io(bdev_io);
+
+	/* a region is dirty if it is marked on any of the base bdevs */
+	for (i = 0; i < wi_bitmap->num_blocks * wi_bitmap->block_size / sizeof(uint64_t); i++) {
+		wi_bitmap->buf[i] |= bits[i];
+	}
+
+	ctx->submitted++;
+	_raid_bdev_load_wi_bitmap(ctx);
+}
+
+static void
+_raid_bdev_load_wi_bitmap(void *_ctx)
+{
+	struct raid_bdev_wi_bitmap_io_ctx *ctx = _ctx;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_bdev_wi_bitmap *wi_bitmap = raid_bdev->wi_bitmap;
+	struct raid_base_bdev_info *base_info;
+	int rc;
+
+	for (; ctx->submitted < raid_bdev->num_base_bdevs; ctx->submitted++) {
+		base_info = &raid_bdev->base_bdev_info[ctx->submitted];
+
+		if (!base_info->is_configured || base_info->remove_scheduled) {
+			continue;
+		}
+
+		rc = spdk_bdev_read_blocks(base_info->desc, base_info->app_thread_ch, ctx->buf,
+					   wi_bitmap->offset_blocks, wi_bitmap->num_blocks,
+					   raid_bdev_load_wi_bitmap_cb, ctx);
+		if (rc != 0) {
+			struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(base_info->desc);
+
+			if (rc == -ENOMEM) {
+				ctx->wait_entry.bdev = bdev;
+				ctx->wait_entry.cb_fn = _raid_bdev_load_wi_bitmap;
+				ctx->wait_entry.cb_arg = ctx;
+				spdk_bdev_queue_io_wait(bdev, base_info->app_thread_ch, &ctx->wait_entry);
+				return;
+			}
+
+			SPDK_ERRLOG("Failed to load write-intent bitmap from bdev %s: %s\n",
+				    spdk_bdev_get_name(bdev), spdk_strerror(-rc));
+			ctx->status = rc;
+			break;
+		}
+		return;
+	}
+
+	if (ctx->status == 0) {
+		memcpy(wi_bitmap->bits, wi_bitmap->buf,
+		       spdk_divide_round_up(wi_bitmap->num_regions, 64) * sizeof(uint64_t));
+	}
+
+	raid_bdev_wi_bitmap_io_done(ctx);
+}
+
+void
+raid_bdev_load_wi_bitmap(struct raid_bdev *raid_bdev, raid_bdev_wi_bitmap_cb cb, void *cb_ctx)
+{
+	struct raid_bdev_wi_bitmap *wi_bitmap = raid_bdev->wi_bitmap;
+	struct raid_bdev_wi_bitmap_io_ctx *ctx;
+	int rc;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(wi_bitmap != NULL);
+	assert(cb != NULL);
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	ctx->raid_bdev = raid_bdev;
+	ctx->cb = cb;
+	ctx->cb_ctx = cb_ctx;
+	ctx->buf = spdk_dma_malloc(wi_bitmap->num_blocks * wi_bitmap->block_size, 0x1000, NULL);
+	if (!ctx->buf) {
+		free(ctx);
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	memset(wi_bitmap->buf, 0, wi_bitmap->num_blocks * wi_bitmap->block_size);
+
+	_raid_bdev_load_wi_bitmap(ctx);
+	return;
+err:
+	cb(rc, raid_bdev, cb_ctx);
+}
+
+static void
+raid_bdev_write_wi_bitmap_base_bdev_done(int status, struct raid_bdev_wi_bitmap_io_ctx *ctx)
+{
+	if (status != 0) {
+		ctx->status = status;
+	}
+
+	if (--ctx->remaining == 0) {
+		ctx->cb(ctx->status, ctx->raid_bdev, ctx->cb_ctx);
+		free(ctx);
+	}
+}
+
+static void
+raid_bdev_write_wi_bitmap_cb(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_wi_bitmap_io_ctx *ctx = cb_arg;
+	int status = 0;
+
+	if (!success) {
+		SPDK_ERRLOG("Failed to save write-intent bitmap on bdev %s\n", bdev_io->bdev->name);
+		status = -EIO;
+	}
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_write_wi_bitmap_base_bdev_done(status, ctx);
+}
+
+static void
+_raid_bdev_write_wi_bitmap(void *_ctx)
+{
+	struct raid_bdev_wi_bitmap_io_ctx *ctx = _ctx;
+	struct raid_bdev *raid_bdev = ctx->raid_bdev;
+	struct raid_bdev_wi_bitmap *wi_bitmap = raid_bdev->wi_bitmap;
+	struct raid_base_bdev_info *base_info;
+	uint8_t i;
+	int rc;
+
+	for (i = ctx->submitted; i < raid_bdev->num_base_bdevs; i++) {
+		base_info = &raid_bdev->base_bdev_info[i];
+
+		if (!base_info->is_configured || base_info->remove_scheduled) {
+			assert(ctx->remaining > 1);
+			raid_bdev_write_wi_bitmap_base_bdev_done(0, ctx);
+			ctx->submitted++;
+			continue;
+		}
+
+		rc = spdk_bdev_write_blocks(base_info->desc, base_info->app_thread_ch, ctx->buf,
+					    wi_bitmap->offset_blocks + ctx->offset_blocks, ctx->num_blocks,
+					    raid_bdev_write_wi_bitmap_cb, ctx);
+		if (rc != 0) {
+			struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(base_info->desc);
+
+			if (rc == -ENOMEM) {
+				ctx->wait_entry.bdev = bdev;
+				ctx->wait_entry.cb_fn = _raid_bdev_write_wi_bitmap;
+				ctx->wait_entry.cb_arg = ctx;
+				spdk_bdev_queue_io_wait(bdev, base_info->app_thread_ch, &ctx->wait_entry);
+				return;
+			}
+
+			assert(ctx->remaining > 1);
+			raid_bdev_write_wi_bitmap_base_bdev_done(rc, ctx);
+		}
+
+		ctx->submitted++;
+	}
+
+	raid_bdev_write_wi_bitmap_base_bdev_done(0, ctx);
+}
+
+/*
+ * Writes the blocks of the write-intent bitmap modified since the previous write
+ * to all configured base bdevs.
+ */
+void
+raid_bdev_write_wi_bitmap(struct raid_bdev *raid_bdev, raid_bdev_wi_bitmap_cb cb, void *cb_ctx)
+{
+	struct raid_bdev_wi_bitmap *wi_bitmap = raid_bdev->wi_bitmap;
+	struct raid_bdev_wi_bitmap_io_ctx *ctx;
+
+	assert(spdk_get_thread() == spdk_thread_get_app_thread());
+	assert(wi_bitmap != NULL);
+	assert(cb != NULL);
+
+	if (wi_bitmap->dirty_start >= wi_bitmap->dirty_end) {
+		cb(0, raid_bdev, cb_ctx);
+		return;
+	}
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx) {
+		cb(-ENOMEM, raid_bdev, cb_ctx);
+		return;
+	}
+
+	ctx->raid_bdev = raid_bdev;
+	ctx->remaining = raid_bdev->num_base_bdevs + 1;
+	ctx->offset_blocks = wi_bitmap->dirty_start;
+	ctx->num_blocks = wi_bitmap->dirty_end - wi_bitmap->dirty_start;
+	ctx->buf = (uint8_t *)wi_bitmap->buf + ctx->offset_blocks * wi_bitmap->block_size;
+	ctx->cb = cb;
+	ctx->cb_ctx = cb_ctx;
+
+	wi_bitmap->dirty_start = UINT64_MAX;
+	wi_bitmap->dirty_end = 0;
+
+	_raid_bdev_write_wi_bitmap(ctx);
+}
+
 SPDK_LOG_REGISTER_COMPONENT(bdev_raid_sb)
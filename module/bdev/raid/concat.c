@@ -316,12 +316,52 @@ concat_stop(struct raid_bdev *raid_bdev)
 	return true;
 }
 
+static int
+concat_grow(struct raid_bdev *raid_bdev)
+{
+	struct concat_block_range *block_range = raid_bdev->module_private;
+	uint8_t idx = raid_bdev->num_base_bdevs - 1;
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[idx];
+	uint64_t pd_block_cnt = (base_info->data_size >> raid_bdev->strip_size_shift) <<
+				raid_bdev->strip_size_shift;
+	uint64_t blockcnt = raid_bdev->bdev.blockcnt + pd_block_cnt;
+	int rc;
+
+	if (pd_block_cnt == 0) {
+		SPDK_ERRLOG("Base bdev '%s' is smaller than the strip size\n", base_info->name);
+		return -EINVAL;
+	}
+
+	block_range = realloc(block_range, raid_bdev->num_base_bdevs * sizeof(*block_range));
+	if (!block_range) {
+		return -ENOMEM;
+	}
+	raid_bdev->module_private = block_range;
+
+	rc = spdk_bdev_notify_blockcnt_change(&raid_bdev->bdev, blockcnt);
+	if (rc != 0) {
+		SPDK_ERRLOG("Failed to notify blockcount change\n");
+		return rc;
+	}
+
+	/* The new base bdev is appended, the existing data does not move */
+	block_range[idx].start = blockcnt - pd_block_cnt;
+	block_range[idx].length = pd_block_cnt;
+	base_info->data_size = pd_block_cnt;
+
+	SPDK_DEBUGLOG(bdev_concat, "total blockcount %" PRIu64 ",  numbasedev %u\n",
+		      blockcnt, raid_bdev->num_base_bdevs);
+
+	return 0;
+}
+
 static struct raid_bdev_module g_concat_module = {
 	.level = CONCAT,
 	.base_bdevs_min = 1,
 	.memory_domains_supported = true,
 	.start = concat_start,
 	.stop = concat_stop,
+	.grow = concat_grow,
 	.submit_rw_request = concat_submit_rw_request,
 	.submit_null_payload_request = concat_submit_null_payload_request,
 };
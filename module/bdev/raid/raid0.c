@@ -53,6 +53,22 @@ raid0_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *cb_ar
 	spdk_bdev_free_io(bdev_io);
 }
 
+/*
+ * Map a raid bdev offset to the member disk and its offset for the given number of
+ * base bdevs. The number differs from raid_bdev->num_base_bdevs while reshaping.
+ */
+static inline void
+raid0_map_offset(struct raid_bdev *raid_bdev, uint8_t num_base_bdevs, uint64_t offset_blocks,
+		 uint8_t *_pd_idx, uint64_t *_pd_lba)
+{
+	uint64_t strip = offset_blocks >> raid_bdev->strip_size_shift;
+	uint64_t pd_strip = strip / num_base_bdevs;
+
+	*_pd_idx = strip % num_base_bdevs;
+	*_pd_lba = (pd_strip << raid_bdev->strip_size_shift) +
+		   (offset_blocks & (raid_bdev->strip_size - 1));
+}
+
 static void raid0_submit_rw_request(struct raid_bdev_io *raid_io);
 
 static void
@@ -78,8 +94,6 @@ raid0_submit_rw_request(struct raid_bdev_io *raid_io)
 	struct spdk_bdev_ext_io_opts	io_opts = {};
 	struct raid_bdev_io_channel	*raid_ch = raid_io->raid_ch;
 	struct raid_bdev		*raid_bdev = raid_io->raid_bdev;
-	uint64_t			pd_strip;
-	uint32_t			offset_in_strip;
 	uint64_t			pd_lba;
 	uint64_t			pd_blocks;
 	uint8_t				pd_idx;
@@ -92,17 +106,15 @@ raid0_submit_rw_request(struct raid_bdev_io *raid_io)
 	start_strip = raid_io->offset_blocks >> raid_bdev->strip_size_shift;
 	end_strip = (raid_io->offset_blocks + raid_io->num_blocks - 1) >>
 		    raid_bdev->strip_size_shift;
-	if (start_strip != end_strip && raid_bdev->num_base_bdevs > 1) {
+	if (start_strip != end_strip && raid_bdev_io_get_num_base_bdevs(raid_io) > 1) {
 		assert(false);
 		SPDK_ERRLOG("I/O spans strip boundary!\n");
 		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
 		return;
 	}
 
-	pd_strip = start_strip / raid_bdev->num_base_bdevs;
-	pd_idx = start_strip % raid_bdev->num_base_bdevs;
-	offset_in_strip = raid_io->offset_blocks & (raid_bdev->strip_size - 1);
-	pd_lba = (pd_strip << raid_bdev->strip_size_shift) + offset_in_strip;
+	raid0_map_offset(raid_bdev, raid_bdev_io_get_num_base_bdevs(raid_io), raid_io->offset_blocks,
+			 &pd_idx, &pd_lba);
 	pd_blocks = raid_io->num_blocks;
 	base_info = &raid_bdev->base_bdev_info[pd_idx];
 	if (base_info->desc == NULL) {
@@ -380,12 +392,16 @@ raid0_start(struct raid_bdev *raid_bdev)
 	/*
 	 * Take the minimum block count based approach where total block count
 	 * of raid bdev is the number of base bdev times the minimum block count
-	 * of any base bdev.
+	 * of any base bdev. An unfinished reshape exposes only the previous capacity.
 	 */
 	SPDK_DEBUGLOG(bdev_raid0, "min blockcount %" PRIu64 ",  numbasedev %u, strip size shift %u\n",
 		      min_blockcnt, raid_bdev->num_base_bdevs, raid_bdev->strip_size_shift);
 
-	raid_bdev->bdev.blockcnt = base_bdev_data_size * raid_bdev->num_base_bdevs;
+	if (raid_bdev->reshape.num_base_bdevs_old != 0) {
+		raid_bdev->bdev.blockcnt = base_bdev_data_size * raid_bdev->reshape.num_base_bdevs_old;
+	} else {
+		raid_bdev->bdev.blockcnt = base_bdev_data_size * raid_bdev->num_base_bdevs;
+	}
 
 	if (raid_bdev->num_base_bdevs > 1) {
 		raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
@@ -434,15 +450,208 @@ raid0_resize(struct raid_bdev *raid_bdev)
 	return true;
 }
 
+static int
+raid0_grow(struct raid_bdev *raid_bdev)
+{
+	struct raid_base_bdev_info *base_info;
+	uint64_t data_size = raid_bdev->base_bdev_info[0].data_size;
+
+	base_info = &raid_bdev->base_bdev_info[raid_bdev->num_base_bdevs - 1];
+	if (base_info->data_size < data_size) {
+		SPDK_ERRLOG("Base bdev '%s' is too small: %" PRIu64 " < %" PRIu64 " blocks\n",
+			    base_info->name, base_info->data_size, data_size);
+		return -EINVAL;
+	}
+	base_info->data_size = data_size;
+
+	raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
+	raid_bdev->bdev.split_on_optimal_io_boundary = true;
+
+	return 0;
+}
+
+/*
+ * Reshape moves the strips of a window one at a time: each one is read from its location
+ * in the old layout and written to its location in the new one. raid_io->offset_blocks and
+ * raid_io->num_blocks describe the whole request, base_bdev_io_remaining counts the blocks
+ * left to move.
+ */
+static inline void
+raid0_process_get_strip(struct raid_bdev_io *raid_io, uint64_t *_offset_blocks,
+			uint64_t *_num_blocks)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint64_t offset_blocks = raid_io->offset_blocks + raid_io->num_blocks -
+				 raid_io->base_bdev_io_remaining;
+
+	*_offset_blocks = offset_blocks;
+	*_num_blocks = spdk_min(raid_bdev->strip_size - (offset_blocks & (raid_bdev->strip_size - 1)),
+				raid_io->base_bdev_io_remaining);
+}
+
+static void raid0_process_submit_read(struct raid_bdev_io *raid_io);
+static void raid0_process_submit_write(struct raid_bdev_io *raid_io);
+
+static void
+_raid0_process_submit_read(void *_raid_io)
+{
+	raid0_process_submit_read(_raid_io);
+}
+
+static void
+_raid0_process_submit_write(void *_raid_io)
+{
+	raid0_process_submit_write(_raid_io);
+}
+
+static void
+raid0_process_write_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+	uint64_t offset_blocks, num_blocks;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		raid_bdev_process_request_complete(process_req, -EIO);
+		return;
+	}
+
+	raid0_process_get_strip(raid_io, &offset_blocks, &num_blocks);
+	raid_io->base_bdev_io_remaining -= num_blocks;
+
+	if (raid_io->base_bdev_io_remaining > 0) {
+		raid0_process_submit_read(raid_io);
+	} else {
+		raid_bdev_process_request_complete(process_req, 0);
+	}
+}
+
+static void
+raid0_process_read_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (!success) {
+		raid_bdev_process_request_complete(process_req, -EIO);
+		return;
+	}
+
+	raid0_process_submit_write(raid_io);
+}
+
+static void
+raid0_process_submit_io(struct raid_bdev_io *raid_io, bool write)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+	struct spdk_bdev_ext_io_opts io_opts = {};
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	uint64_t offset_blocks, num_blocks;
+	uint64_t pd_lba;
+	uint8_t pd_idx;
+	int ret;
+
+	raid0_process_get_strip(raid_io, &offset_blocks, &num_blocks);
+	raid0_map_offset(raid_bdev, write ? raid_bdev->num_base_bdevs :
+			 raid_bdev->reshape.num_base_bdevs_old, offset_blocks, &pd_idx, &pd_lba);
+
+	base_info = &raid_bdev->base_bdev_info[pd_idx];
+	base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, pd_idx);
+
+	process_req->iov.iov_len = num_blocks * raid_bdev->bdev.blocklen;
+
+	io_opts.size = sizeof(io_opts);
+	io_opts.metadata = raid_io->md_buf;
+
+	if (write) {
+		ret = raid_bdev_writev_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
+						  pd_lba, num_blocks, raid0_process_write_complete,
+						  raid_io, &io_opts);
+	} else {
+		ret = raid_bdev_readv_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
+						 pd_lba, num_blocks, raid0_process_read_complete,
+						 raid_io, &io_opts);
+	}
+
+	if (spdk_unlikely(ret != 0)) {
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc), base_ch,
+						write ? _raid0_process_submit_write : _raid0_process_submit_read);
+		} else {
+			raid_bdev_process_request_complete(process_req, ret);
+		}
+	}
+}
+
+static void
+raid0_process_submit_read(struct raid_bdev_io *raid_io)
+{
+	raid0_process_submit_io(raid_io, false);
+}
+
+static void
+raid0_process_submit_write(struct raid_bdev_io *raid_io)
+{
+	raid0_process_submit_io(raid_io, true);
+}
+
+static int
+raid0_submit_process_request(struct raid_bdev_process_request *process_req,
+			     struct raid_bdev_io_channel *raid_ch)
+{
+	struct spdk_io_channel *ch = spdk_io_channel_from_ctx(raid_ch);
+	struct raid_bdev *raid_bdev = spdk_io_channel_get_io_device(ch);
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	uint64_t offset_blocks = process_req->offset_blocks;
+	uint64_t row_old = (uint64_t)raid_bdev->reshape.num_base_bdevs_old << raid_bdev->strip_size_shift;
+	uint64_t row_new = (uint64_t)raid_bdev->num_base_bdevs << raid_bdev->strip_size_shift;
+	uint64_t safe_end;
+	uint64_t num_blocks;
+
+	assert(raid_bdev->reshape.num_base_bdevs_old != 0);
+
+	/*
+	 * The data is moved in place towards lower offsets on the members. Limit the request
+	 * to blocks whose new locations only overlap old locations of blocks that were already
+	 * moved, so the request can be safely repeated if it is interrupted.
+	 */
+	if (offset_blocks < row_old) {
+		safe_end = row_new;
+	} else {
+		safe_end = offset_blocks / row_old * row_new + offset_blocks % row_old;
+	}
+	num_blocks = spdk_min(process_req->num_blocks, safe_end - offset_blocks);
+
+	raid_bdev_io_init(raid_io, raid_ch, SPDK_BDEV_IO_TYPE_READ, offset_blocks, num_blocks,
+			  &process_req->iov, 1, process_req->md_buf, NULL, NULL);
+	raid_io->base_bdev_io_remaining = num_blocks;
+
+	raid0_process_submit_read(raid_io);
+
+	return num_blocks;
+}
+
 static struct raid_bdev_module g_raid0_module = {
 	.level = RAID0,
 	.base_bdevs_min = 1,
 	.memory_domains_supported = true,
 	.dif_supported = true,
+	.grow_restripe = true,
 	.start = raid0_start,
 	.submit_rw_request = raid0_submit_rw_request,
 	.submit_null_payload_request = raid0_submit_null_payload_request,
 	.resize = raid0_resize,
+	.grow = raid0_grow,
+	.submit_process_request = raid0_submit_process_request,
 };
 RAID_MODULE_REGISTER(&g_raid0_module)
 
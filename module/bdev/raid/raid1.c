@@ -5,27 +5,61 @@
 
 #include "bdev_raid.h"
 
+#include "spdk/env.h"
 #include "spdk/likely.h"
 #include "spdk/log.h"
 
+/* Weight of a new sample in the read latency moving average, as a shift: 1/8 */
+#define RAID1_READ_LATENCY_EWMA_SHIFT	3
+
+/* Distance from the end of the previous read within which a read is considered sequential */
+#define RAID1_SEQUENTIAL_READ_WINDOW_KB	128
+
 struct raid1_info {
 	/* The parent raid bdev */
 	struct raid_bdev *raid_bdev;
+
+	/* Read window of the sequential read policy in blocks */
+	uint64_t sequential_read_window;
+
+	/* Read statistics of io channels that were destroyed */
+	struct spdk_spinlock stats_lock;
+	struct raid_base_bdev_read_stats *stats;
+};
+
+/* Read state of a base bdev on an io channel */
+struct raid1_base_read_ctx {
+	/* Number of outstanding read requests */
+	uint64_t reads_outstanding;
+
+	/* Moving average of read latency in ticks, 0 until the first read completes */
+	uint64_t latency_ewma;
+
+	/* Offset following the last read submitted to the base bdev */
+	uint64_t next_offset;
+
+	struct raid_base_bdev_read_stats stats;
 };
 
 struct raid1_io_channel {
+	/* Array of per-base_bdev read state on this channel */
+	struct raid1_base_read_ctx *base_read;
+
 	/* Array of per-base_bdev counters of outstanding read blocks on this channel */
 	uint64_t read_blocks_outstanding[0];
 };
 
 static void
 raid1_channel_inc_read_counters(struct raid_bdev_io_channel *raid_ch, uint8_t idx,
-				uint64_t num_blocks)
+				uint64_t offset_blocks, uint64_t num_blocks)
 {
 	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	struct raid1_base_read_ctx *base_read = &raid1_ch->base_read[idx];
 
 	assert(raid1_ch->read_blocks_outstanding[idx] <= UINT64_MAX - num_blocks);
 	raid1_ch->read_blocks_outstanding[idx] += num_blocks;
+	base_read->reads_outstanding++;
+	base_read->next_offset = offset_blocks + num_blocks;
 }
 
 static void
@@ -36,6 +70,30 @@ raid1_channel_dec_read_counters(struct raid_bdev_io_channel *raid_ch, uint8_t id
 
 	assert(raid1_ch->read_blocks_outstanding[idx] >= num_blocks);
 	raid1_ch->read_blocks_outstanding[idx] -= num_blocks;
+	assert(raid1_ch->base_read[idx].reads_outstanding > 0);
+	raid1_ch->base_read[idx].reads_outstanding--;
+}
+
+static void
+raid1_channel_update_read_stats(struct raid_bdev_io *raid_io, uint8_t idx)
+{
+	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	struct raid1_base_read_ctx *base_read = &raid1_ch->base_read[idx];
+	uint64_t latency = spdk_get_ticks() - raid_io->base_bdev_io_submit_tsc;
+
+	base_read->stats.num_read_ops++;
+	base_read->stats.bytes_read += raid_io->num_blocks * raid_io->raid_bdev->bdev.blocklen;
+	base_read->stats.read_latency_ticks += latency;
+
+	if (base_read->latency_ewma == 0) {
+		base_read->latency_ewma = spdk_max(latency, 1);
+	} else if (latency > base_read->latency_ewma) {
+		base_read->latency_ewma += (latency - base_read->latency_ewma) >>
+					   RAID1_READ_LATENCY_EWMA_SHIFT;
+	} else {
+		base_read->latency_ewma -= (base_read->latency_ewma - latency) >>
+					   RAID1_READ_LATENCY_EWMA_SHIFT;
+	}
 }
 
 static void
@@ -203,6 +261,8 @@ raid1_read_bdev_io_completion(struct spdk_bdev_io *bdev_io, bool success, void *
 		return;
 	}
 
+	raid1_channel_update_read_stats(raid_io, raid_io->base_bdev_io_submitted);
+
 	raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
 }
 
@@ -235,6 +295,81 @@ raid1_channel_next_read_base_bdev(struct raid_bdev *raid_bdev, struct raid_bdev_
 	return idx;
 }
 
+/*
+ * Select the base bdev with the lowest expected completion time, estimated as its average
+ * read latency multiplied by the number of reads that would be outstanding on it. A base bdev
+ * without a latency sample yet gets a single read to measure it and is otherwise used last.
+ */
+static uint8_t
+raid1_channel_next_read_base_bdev_latency(struct raid_bdev *raid_bdev,
+		struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	uint64_t cost, cost_min = UINT64_MAX;
+	uint8_t idx = UINT8_MAX;
+	uint8_t i;
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		struct raid1_base_read_ctx *base_read = &raid1_ch->base_read[i];
+
+		if (raid_bdev_channel_get_base_channel(raid_ch, i) == NULL) {
+			continue;
+		}
+
+		if (base_read->latency_ewma == 0) {
+			if (base_read->reads_outstanding == 0) {
+				return i;
+			}
+			cost = UINT64_MAX - 1;
+		} else {
+			cost = base_read->latency_ewma * (base_read->reads_outstanding + 1);
+		}
+
+		if (cost < cost_min) {
+			cost_min = cost;
+			idx = i;
+		}
+	}
+
+	return idx;
+}
+
+/*
+ * Keep reads that continue a stream on the base bdev that served the previous part of it,
+ * so that the device readahead is effective. Other reads are balanced by outstanding blocks.
+ */
+static uint8_t
+raid1_channel_next_read_base_bdev_sequential(struct raid_bdev *raid_bdev,
+		struct raid_bdev_io_channel *raid_ch, uint64_t offset_blocks)
+{
+	struct raid1_info *r1info = raid_bdev->module_private;
+	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	uint64_t distance, distance_min = UINT64_MAX;
+	uint8_t idx = UINT8_MAX;
+	uint8_t i;
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		uint64_t next_offset = raid1_ch->base_read[i].next_offset;
+
+		if (raid_bdev_channel_get_base_channel(raid_ch, i) == NULL || next_offset == 0) {
+			continue;
+		}
+
+		distance = offset_blocks > next_offset ? offset_blocks - next_offset :
+			   next_offset - offset_blocks;
+		if (distance <= r1info->sequential_read_window && distance < distance_min) {
+			distance_min = distance;
+			idx = i;
+		}
+	}
+
+	if (idx == UINT8_MAX) {
+		idx = raid1_channel_next_read_base_bdev(raid_bdev, raid_ch);
+	}
+
+	return idx;
+}
+
 static int
 raid1_submit_read_request(struct raid_bdev_io *raid_io)
 {
@@ -246,7 +381,18 @@ raid1_submit_read_request(struct raid_bdev_io *raid_io)
 	uint8_t idx;
 	int ret;
 
-	idx = raid1_channel_next_read_base_bdev(raid_bdev, raid_ch);
+	switch (raid_bdev->read_policy) {
+	case RAID_READ_POLICY_LATENCY:
+		idx = raid1_channel_next_read_base_bdev_latency(raid_bdev, raid_ch);
+		break;
+	case RAID_READ_POLICY_SEQUENTIAL:
+		idx = raid1_channel_next_read_base_bdev_sequential(raid_bdev, raid_ch,
+				raid_io->offset_blocks);
+		break;
+	default:
+		idx = raid1_channel_next_read_base_bdev(raid_bdev, raid_ch);
+		break;
+	}
 	if (spdk_unlikely(idx == UINT8_MAX)) {
 		raid_bdev_io_complete(raid_io, SPDK_BDEV_IO_STATUS_FAILED);
 		return 0;
@@ -256,12 +402,14 @@ raid1_submit_read_request(struct raid_bdev_io *raid_io)
 	base_ch = raid_bdev_channel_get_base_channel(raid_ch, idx);
 
 	raid1_init_ext_io_opts(&io_opts, raid_io);
+	raid_io->base_bdev_io_submit_tsc = spdk_get_ticks();
 	ret = raid_bdev_readv_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
 					 raid_io->offset_blocks, raid_io->num_blocks,
 					 raid1_read_bdev_io_completion, raid_io, &io_opts);
 
 	if (spdk_likely(ret == 0)) {
-		raid1_channel_inc_read_counters(raid_ch, idx, raid_io->num_blocks);
+		raid1_channel_inc_read_counters(raid_ch, idx, raid_io->offset_blocks,
+						raid_io->num_blocks);
 		raid_io->base_bdev_io_submitted = idx;
 	} else if (spdk_unlikely(ret == -ENOMEM)) {
 		raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
@@ -349,17 +497,55 @@ raid1_submit_rw_request(struct raid_bdev_io *raid_io)
 	}
 }
 
+static void
+raid1_add_read_stats(struct raid_base_bdev_read_stats *stats,
+		     const struct raid_base_bdev_read_stats *add)
+{
+	stats->num_read_ops += add->num_read_ops;
+	stats->bytes_read += add->bytes_read;
+	stats->read_latency_ticks += add->read_latency_ticks;
+}
+
 static void
 raid1_ioch_destroy(void *io_device, void *ctx_buf)
 {
+	struct raid1_info *r1info = io_device;
+	struct raid1_io_channel *raid1_ch = ctx_buf;
+	uint8_t i;
+
+	spdk_spin_lock(&r1info->stats_lock);
+	for (i = 0; i < r1info->raid_bdev->num_base_bdevs; i++) {
+		raid1_add_read_stats(&r1info->stats[i], &raid1_ch->base_read[i].stats);
+	}
+	spdk_spin_unlock(&r1info->stats_lock);
+
+	free(raid1_ch->base_read);
 }
 
 static int
 raid1_ioch_create(void *io_device, void *ctx_buf)
 {
+	struct raid1_info *r1info = io_device;
+	struct raid1_io_channel *raid1_ch = ctx_buf;
+
+	raid1_ch->base_read = calloc(r1info->raid_bdev->num_base_bdevs,
+				     sizeof(*raid1_ch->base_read));
+	if (raid1_ch->base_read == NULL) {
+		SPDK_ERRLOG("Failed to allocate RAID1 channel read state\n");
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 
+static void
+raid1_info_free(struct raid1_info *r1info)
+{
+	spdk_spin_destroy(&r1info->stats_lock);
+	free(r1info->stats);
+	free(r1info);
+}
+
 static void
 raid1_io_device_unregister_done(void *io_device)
 {
@@ -367,7 +553,7 @@ raid1_io_device_unregister_done(void *io_device)
 
 	raid_bdev_module_stop_done(r1info->raid_bdev);
 
-	free(r1info);
+	raid1_info_free(r1info);
 }
 
 static int
@@ -384,6 +570,17 @@ raid1_start(struct raid_bdev *raid_bdev)
 		return -ENOMEM;
 	}
 	r1info->raid_bdev = raid_bdev;
+	spdk_spin_init(&r1info->stats_lock);
+
+	r1info->stats = calloc(raid_bdev->num_base_bdevs, sizeof(*r1info->stats));
+	if (!r1info->stats) {
+		SPDK_ERRLOG("Failed to allocate RAID1 read statistics\n");
+		raid1_info_free(r1info);
+		return -ENOMEM;
+	}
+
+	r1info->sequential_read_window = spdk_max(RAID1_SEQUENTIAL_READ_WINDOW_KB * 1024 /
+					 raid_bdev->bdev.blocklen, 1);
 
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
 		min_blockcnt = spdk_min(min_blockcnt, base_info->data_size);
@@ -500,6 +697,29 @@ raid1_submit_process_request(struct raid_bdev_process_request *process_req,
 	}
 }
 
+static void
+raid1_get_read_stats(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+		     struct raid_base_bdev_read_stats *stats)
+{
+	struct raid1_info *r1info = raid_bdev->module_private;
+	struct raid1_io_channel *raid1_ch;
+	uint8_t i;
+
+	if (raid_ch == NULL) {
+		spdk_spin_lock(&r1info->stats_lock);
+		for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+			raid1_add_read_stats(&stats[i], &r1info->stats[i]);
+		}
+		spdk_spin_unlock(&r1info->stats_lock);
+		return;
+	}
+
+	raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		raid1_add_read_stats(&stats[i], &raid1_ch->base_read[i].stats);
+	}
+}
+
 static bool
 raid1_resize(struct raid_bdev *raid_bdev)
 {
@@ -538,11 +758,13 @@ static struct raid_bdev_module g_raid1_module = {
 	.base_bdevs_min = 2,
 	.base_bdevs_constraint = {CONSTRAINT_MIN_BASE_BDEVS_OPERATIONAL, 1},
 	.memory_domains_supported = true,
+	.wi_bitmap_supported = true,
 	.start = raid1_start,
 	.stop = raid1_stop,
 	.submit_rw_request = raid1_submit_rw_request,
 	.get_io_channel = raid1_get_io_channel,
 	.submit_process_request = raid1_submit_process_request,
+	.get_read_stats = raid1_get_read_stats,
 	.resize = raid1_resize,
 };
 RAID_MODULE_REGISTER(&g_raid1_module)
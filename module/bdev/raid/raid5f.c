@@ -16,6 +16,9 @@
 /* Maximum concurrent full stripe writes per io channel */
 #define RAID5F_MAX_STRIPES 32
 
+/* Number of hash buckets for looking up the stripe requests in progress */
+#define RAID5F_ACTIVE_STRIPE_BUCKETS 256
+
 struct chunk {
 	/* Corresponds to base_bdev index */
 	uint8_t index;
@@ -31,6 +34,10 @@ struct chunk {
 
 	/* Pointer to buffer with I/O metadata */
 	void *md_buf;
+
+	/* Range of blocks within the chunk written by a partial stripe write */
+	uint64_t req_offset;
+	uint64_t req_blocks;
 };
 
 struct stripe_request;
@@ -40,6 +47,7 @@ struct stripe_request {
 	enum stripe_request_type {
 		STRIPE_REQ_WRITE,
 		STRIPE_REQ_RECONSTRUCT,
+		STRIPE_REQ_PARTIAL_WRITE,
 	} type;
 
 	struct raid5f_io_channel *r5ch;
@@ -75,6 +83,43 @@ struct stripe_request {
 			/* Offset from chunk start */
 			uint64_t chunk_offset;
 		} reconstruct;
+
+		struct {
+			/* Buffer for the updated stripe parity */
+			void *parity_buf;
+
+			/* Buffer for the updated stripe io metadata parity */
+			void *parity_md_buf;
+
+			/* Array of buffers for reading chunk data, one for each base bdev */
+			void **chunk_buffers;
+
+			/* Array of buffers for reading chunk metadata, one for each base bdev */
+			void **chunk_md_buffers;
+
+			/* Array of buffers for assembling updated chunk metadata */
+			void **chunk_new_md_buffers;
+
+			/* Array of iovecs describing chunk_buffers */
+			struct iovec *chunk_buf_iovs;
+
+			/* Range of blocks within the chunks that is covered by the parity update */
+			uint64_t offset;
+			uint64_t blocks;
+
+			enum raid5f_partial_write_mode {
+				/* Update the parity with the difference between old and new data */
+				RAID5F_PARTIAL_WRITE_RMW,
+				/* Calculate the parity from the new data and the untouched chunks */
+				RAID5F_PARTIAL_WRITE_RCW,
+			} mode;
+
+			/* Set while reading the chunks, cleared when writing them */
+			bool reading;
+
+			/* Missing data chunk that must be reconstructed before calculating the parity */
+			struct chunk *reconstruct_chunk;
+		} partial;
 	};
 
 	/* Array of iovec iterators for each chunk */
@@ -90,12 +135,16 @@ struct stripe_request {
 		size_t len;
 		size_t remaining;
 		size_t remaining_md;
+		uint8_t n_src;
 		int status;
 		stripe_req_xor_cb cb;
 	} xor;
 
 	TAILQ_ENTRY(stripe_request) link;
 
+	/* Link in the list of stripe requests in progress on the raid bdev */
+	TAILQ_ENTRY(stripe_request) active_link;
+
 	/* Array of chunks corresponding to base_bdevs */
 	struct chunk chunks[0];
 };
@@ -115,6 +164,16 @@ struct raid5f_info {
 
 	/* block length bit shift for optimized calculation, only valid when no interleaved md */
 	uint32_t blocklen_shift;
+
+	/*
+	 * Stripe requests in progress on all io channels, hashed by stripe index. Used to
+	 * serialize conflicting I/O to a stripe across the whole raid bdev.
+	 */
+	struct spdk_spinlock active_stripe_requests_lock;
+	TAILQ_HEAD(, stripe_request) active_stripe_requests[RAID5F_ACTIVE_STRIPE_BUCKETS];
+
+	/* io channels with I/O waiting for a stripe, protected by active_stripe_requests_lock */
+	TAILQ_HEAD(, raid5f_io_channel) stripe_waiters;
 };
 
 struct raid5f_io_channel {
@@ -122,8 +181,25 @@ struct raid5f_io_channel {
 	struct {
 		TAILQ_HEAD(, stripe_request) write;
 		TAILQ_HEAD(, stripe_request) reconstruct;
+		TAILQ_HEAD(, stripe_request) partial_write;
 	} free_stripe_requests;
 
+	/* Number of partial write stripe requests, allocated on first use */
+	int num_partial_write_reqs;
+
+	/* I/O waiting for a conflicting stripe request to complete */
+	TAILQ_HEAD(, spdk_bdev_io_wait_entry) stripe_wait_queue;
+	bool stripe_wait_queue_resuming;
+	bool stripe_wait_queue_resume_again;
+
+	/*
+	 * Set while the channel is on the stripe_waiters list of the raid5f_info, which holds a
+	 * reference to the channel. Stripe requests released on other channels take it off the
+	 * list and pass the reference to a message that resumes the wait queue on its thread.
+	 */
+	bool stripe_waiting;
+	TAILQ_ENTRY(raid5f_io_channel) stripe_waiter_link;
+
 	/* accel_fw channel */
 	struct spdk_io_channel *accel_ch;
 
@@ -176,16 +252,211 @@ raid5f_stripe_parity_chunk_index(const struct raid_bdev *raid_bdev, uint64_t str
 	return raid5f_stripe_data_chunks_num(raid_bdev) - stripe_index % raid_bdev->num_base_bdevs;
 }
 
-static inline void
+static inline uint32_t
+raid5f_stripe_bucket(uint64_t stripe_index)
+{
+	return stripe_index % RAID5F_ACTIVE_STRIPE_BUCKETS;
+}
+
+/* Must be called with active_stripe_requests_lock held */
+static bool
+raid5f_stripe_is_busy(struct raid5f_info *r5f_info, uint64_t stripe_index, bool write)
+{
+	struct stripe_request *stripe_req;
+
+	TAILQ_FOREACH(stripe_req, &r5f_info->active_stripe_requests[raid5f_stripe_bucket(stripe_index)],
+		      active_link) {
+		if (stripe_req->stripe_index == stripe_index &&
+		    (write || stripe_req->type != STRIPE_REQ_RECONSTRUCT)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Put the channel on the list of channels to be woken up when a stripe request is released.
+ * Must be called with active_stripe_requests_lock held, returns true if the caller has to take
+ * the reference for the list after unlocking.
+ */
+static bool
+raid5f_stripe_waiter_add(struct raid5f_info *r5f_info, struct raid5f_io_channel *r5ch)
+{
+	if (r5ch->stripe_waiting) {
+		return false;
+	}
+
+	r5ch->stripe_waiting = true;
+	TAILQ_INSERT_TAIL(&r5f_info->stripe_waiters, r5ch, stripe_waiter_link);
+
+	return true;
+}
+
+static void
+raid5f_stripe_waiter_get_ref(struct raid5f_info *r5f_info, struct raid5f_io_channel *r5ch)
+{
+	struct spdk_io_channel *ch __attribute__((unused));
+
+	/* The channel has I/O waiting, so it can't be going away */
+	ch = spdk_get_io_channel(r5f_info);
+	assert(ch == spdk_io_channel_from_ctx(r5ch));
+}
+
+static void
+raid5f_stripe_waiter_remove(struct raid5f_io_channel *r5ch)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(r5ch);
+	bool put;
+
+	spdk_spin_lock(&r5f_info->active_stripe_requests_lock);
+	put = r5ch->stripe_waiting;
+	if (put) {
+		TAILQ_REMOVE(&r5f_info->stripe_waiters, r5ch, stripe_waiter_link);
+		r5ch->stripe_waiting = false;
+	}
+	spdk_spin_unlock(&r5f_info->active_stripe_requests_lock);
+
+	if (put) {
+		spdk_put_io_channel(spdk_io_channel_from_ctx(r5ch));
+	}
+}
+
+static bool
+raid5f_raid_io_is_blocked(struct raid_bdev_io *raid_io)
+{
+	struct raid5f_info *r5f_info = raid_io->raid_bdev->module_private;
+	struct raid5f_io_channel *r5ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	bool busy, get_ref = false;
+
+	spdk_spin_lock(&r5f_info->active_stripe_requests_lock);
+	busy = raid5f_stripe_is_busy(r5f_info, raid_io->offset_blocks / r5f_info->stripe_blocks,
+				     raid_io->type == SPDK_BDEV_IO_TYPE_WRITE);
+	if (busy) {
+		get_ref = raid5f_stripe_waiter_add(r5f_info, r5ch);
+	}
+	spdk_spin_unlock(&r5f_info->active_stripe_requests_lock);
+
+	if (get_ref) {
+		raid5f_stripe_waiter_get_ref(r5f_info, r5ch);
+	}
+
+	return busy;
+}
+
+/*
+ * Mark the stripe request in progress, unless it conflicts with another one in progress on
+ * any io channel of the raid bdev. Writes conflict with all other requests to the stripe,
+ * reconstruct reads only with writes. On conflict, the channel is signed up for a wake-up
+ * when the conflicting request is released.
+ */
+static bool
+raid5f_stripe_request_activate(struct stripe_request *stripe_req)
+{
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+	uint64_t stripe_index = stripe_req->stripe_index;
+	bool busy, get_ref = false;
+
+	spdk_spin_lock(&r5f_info->active_stripe_requests_lock);
+	busy = raid5f_stripe_is_busy(r5f_info, stripe_index, stripe_req->type != STRIPE_REQ_RECONSTRUCT);
+	if (!busy) {
+		TAILQ_INSERT_TAIL(&r5f_info->active_stripe_requests[raid5f_stripe_bucket(stripe_index)],
+				  stripe_req, active_link);
+	} else {
+		get_ref = raid5f_stripe_waiter_add(r5f_info, stripe_req->r5ch);
+	}
+	spdk_spin_unlock(&r5f_info->active_stripe_requests_lock);
+
+	if (get_ref) {
+		raid5f_stripe_waiter_get_ref(r5f_info, stripe_req->r5ch);
+	}
+
+	return !busy;
+}
+
+static void
+raid5f_stripe_wait_queue_resume(struct raid5f_io_channel *r5ch)
+{
+	struct spdk_bdev_io_wait_entry *entry, *tmp;
+
+	/* Resubmitted I/O may complete (and release a stripe) inline - let the outer loop handle it */
+	if (r5ch->stripe_wait_queue_resuming) {
+		r5ch->stripe_wait_queue_resume_again = true;
+		return;
+	}
+
+	r5ch->stripe_wait_queue_resuming = true;
+
+	do {
+		r5ch->stripe_wait_queue_resume_again = false;
+
+		/* I/O that is blocked again is put back at the tail and skipped in this pass */
+		TAILQ_FOREACH_SAFE(entry, &r5ch->stripe_wait_queue, link, tmp) {
+			if (!raid5f_raid_io_is_blocked(entry->cb_arg)) {
+				TAILQ_REMOVE(&r5ch->stripe_wait_queue, entry, link);
+				entry->cb_fn(entry->cb_arg);
+			}
+		}
+	} while (r5ch->stripe_wait_queue_resume_again);
+
+	r5ch->stripe_wait_queue_resuming = false;
+
+	if (TAILQ_EMPTY(&r5ch->stripe_wait_queue)) {
+		raid5f_stripe_waiter_remove(r5ch);
+	}
+}
+
+static void
+raid5f_stripe_wait_queue_resume_msg(void *ctx)
+{
+	struct raid5f_io_channel *r5ch = ctx;
+
+	raid5f_stripe_wait_queue_resume(r5ch);
+
+	/* Drop the reference the channel had on the waiters list */
+	spdk_put_io_channel(spdk_io_channel_from_ctx(r5ch));
+}
+
+static void
 raid5f_stripe_request_release(struct stripe_request *stripe_req)
 {
+	struct raid5f_io_channel *r5ch = stripe_req->r5ch;
+	struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(r5ch);
+	struct raid5f_io_channel *waiter, *tmp;
+	int rc;
+
+	spdk_spin_lock(&r5f_info->active_stripe_requests_lock);
+	TAILQ_REMOVE(&r5f_info->active_stripe_requests[raid5f_stripe_bucket(stripe_req->stripe_index)],
+		     stripe_req, active_link);
+	TAILQ_FOREACH_SAFE(waiter, &r5f_info->stripe_waiters, stripe_waiter_link, tmp) {
+		if (waiter == r5ch) {
+			continue;
+		}
+		rc = spdk_thread_send_msg(spdk_io_channel_get_thread(spdk_io_channel_from_ctx(waiter)),
+					  raid5f_stripe_wait_queue_resume_msg, waiter);
+		if (spdk_unlikely(rc != 0)) {
+			/* Stays on the list, the next released stripe request retries */
+			SPDK_ERRLOG("Failed to wake up stripe waiters: %s\n", spdk_strerror(-rc));
+			continue;
+		}
+		TAILQ_REMOVE(&r5f_info->stripe_waiters, waiter, stripe_waiter_link);
+		waiter->stripe_waiting = false;
+	}
+	spdk_spin_unlock(&r5f_info->active_stripe_requests_lock);
+
 	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
-		TAILQ_INSERT_HEAD(&stripe_req->r5ch->free_stripe_requests.write, stripe_req, link);
+		TAILQ_INSERT_HEAD(&r5ch->free_stripe_requests.write, stripe_req, link);
 	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
-		TAILQ_INSERT_HEAD(&stripe_req->r5ch->free_stripe_requests.reconstruct, stripe_req, link);
+		TAILQ_INSERT_HEAD(&r5ch->free_stripe_requests.reconstruct, stripe_req, link);
+	} else if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+		TAILQ_INSERT_HEAD(&r5ch->free_stripe_requests.partial_write, stripe_req, link);
 	} else {
 		assert(false);
 	}
+
+	if (spdk_unlikely(!TAILQ_EMPTY(&r5ch->stripe_wait_queue))) {
+		raid5f_stripe_wait_queue_resume(r5ch);
+	}
 }
 
 static void raid5f_xor_stripe_retry(struct stripe_request *stripe_req);
@@ -252,9 +523,7 @@ static void
 raid5f_xor_stripe_continue(struct stripe_request *stripe_req)
 {
 	struct raid5f_io_channel *r5ch = stripe_req->r5ch;
-	struct raid_bdev_io *raid_io = stripe_req->raid_io;
-	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
-	uint8_t n_src = raid5f_stripe_data_chunks_num(raid_bdev);
+	uint8_t n_src = stripe_req->xor.n_src;
 	uint8_t i;
 	int ret;
 
@@ -277,6 +546,121 @@ raid5f_xor_stripe_continue(struct stripe_request *stripe_req)
 	}
 }
 
+static inline bool
+raid5f_partial_write_chunk_covers_parity_range(struct stripe_request *stripe_req,
+		struct chunk *chunk)
+{
+	return chunk->req_offset == stripe_req->partial.offset &&
+	       chunk->req_blocks == stripe_req->partial.blocks;
+}
+
+static void *
+raid5f_partial_write_chunk_new_md(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	uint32_t md_len = raid_bdev->bdev.md_len;
+	void *new_md;
+
+	if (raid5f_partial_write_chunk_covers_parity_range(stripe_req, chunk)) {
+		return chunk->md_buf;
+	}
+
+	new_md = stripe_req->partial.chunk_new_md_buffers[chunk->index];
+	memcpy(new_md, stripe_req->partial.chunk_md_buffers[chunk->index],
+	       stripe_req->partial.blocks * md_len);
+	memcpy(new_md + (chunk->req_offset - stripe_req->partial.offset) * md_len, chunk->md_buf,
+	       chunk->req_blocks * md_len);
+
+	return new_md;
+}
+
+/*
+ * Prepare the xor sources for a partial stripe write. Sets up r5ch->chunk_xor_iovs with
+ * the destination last and returns the number of sources.
+ */
+static uint8_t
+raid5f_partial_write_xor_setup(struct stripe_request *stripe_req, void **dest_md_buf)
+{
+	struct raid5f_io_channel *r5ch = stripe_req->r5ch;
+	struct iovec *buf_iovs = stripe_req->partial.chunk_buf_iovs;
+	void **md_bufs = stripe_req->partial.chunk_md_buffers;
+	struct chunk *reconstruct_chunk = stripe_req->partial.reconstruct_chunk;
+	bool md = stripe_req->raid_io->md_buf != NULL;
+	struct chunk *chunk;
+	uint8_t c = 0;
+
+	if (reconstruct_chunk != NULL) {
+		/* Recover the missing chunk's data from all the others, including the old parity */
+		FOR_EACH_CHUNK(stripe_req, chunk) {
+			if (chunk == reconstruct_chunk) {
+				continue;
+			}
+			r5ch->chunk_xor_iovs[c] = &buf_iovs[chunk->index];
+			r5ch->chunk_xor_iovcnt[c] = 1;
+			if (md) {
+				stripe_req->chunk_xor_md_buffers[c] = md_bufs[chunk->index];
+			}
+			c++;
+		}
+		r5ch->chunk_xor_iovs[c] = &buf_iovs[reconstruct_chunk->index];
+		r5ch->chunk_xor_iovcnt[c] = 1;
+		*dest_md_buf = md ? md_bufs[reconstruct_chunk->index] : NULL;
+
+		return c;
+	}
+
+	if (stripe_req->partial.mode == RAID5F_PARTIAL_WRITE_RMW) {
+		/* new parity = old parity ^ old data ^ new data of the written chunks */
+		r5ch->chunk_xor_iovs[c] = &buf_iovs[stripe_req->parity_chunk->index];
+		r5ch->chunk_xor_iovcnt[c] = 1;
+		if (md) {
+			stripe_req->chunk_xor_md_buffers[c] = md_bufs[stripe_req->parity_chunk->index];
+		}
+		c++;
+
+		FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+			if (chunk->req_blocks == 0) {
+				continue;
+			}
+			r5ch->chunk_xor_iovs[c] = &buf_iovs[chunk->index];
+			r5ch->chunk_xor_iovcnt[c] = 1;
+			r5ch->chunk_xor_iovs[c + 1] = chunk->iovs;
+			r5ch->chunk_xor_iovcnt[c + 1] = chunk->iovcnt;
+			if (md) {
+				stripe_req->chunk_xor_md_buffers[c] = md_bufs[chunk->index];
+				stripe_req->chunk_xor_md_buffers[c + 1] = raid5f_partial_write_chunk_new_md(stripe_req,
+						chunk);
+			}
+			c += 2;
+		}
+	} else {
+		/* new parity = xor of the new data of all the data chunks */
+		FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+			if (chunk->req_blocks == 0) {
+				r5ch->chunk_xor_iovs[c] = &buf_iovs[chunk->index];
+				r5ch->chunk_xor_iovcnt[c] = 1;
+				if (md) {
+					stripe_req->chunk_xor_md_buffers[c] = md_bufs[chunk->index];
+				}
+			} else {
+				r5ch->chunk_xor_iovs[c] = chunk->iovs;
+				r5ch->chunk_xor_iovcnt[c] = chunk->iovcnt;
+				if (md) {
+					stripe_req->chunk_xor_md_buffers[c] = raid5f_partial_write_chunk_new_md(stripe_req,
+							chunk);
+				}
+			}
+			c++;
+		}
+	}
+
+	r5ch->chunk_xor_iovs[c] = stripe_req->parity_chunk->iovs;
+	r5ch->chunk_xor_iovcnt[c] = stripe_req->parity_chunk->iovcnt;
+	*dest_md_buf = stripe_req->parity_chunk->md_buf;
+
+	return c;
+}
+
 static void
 raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 {
@@ -285,7 +669,9 @@ raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
 	struct chunk *chunk;
 	struct chunk *dest_chunk = NULL;
+	void *dest_md_buf = NULL;
 	uint64_t num_blocks = 0;
+	uint8_t n_src;
 	uint8_t c;
 
 	assert(cb != NULL);
@@ -296,24 +682,34 @@ raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
 		num_blocks = raid_io->num_blocks;
 		dest_chunk = stripe_req->reconstruct.chunk;
+	} else if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+		num_blocks = stripe_req->partial.blocks;
 	} else {
 		assert(false);
 	}
 
-	c = 0;
-	FOR_EACH_CHUNK(stripe_req, chunk) {
-		if (chunk == dest_chunk) {
-			continue;
+	if (dest_chunk != NULL) {
+		c = 0;
+		FOR_EACH_CHUNK(stripe_req, chunk) {
+			if (chunk == dest_chunk) {
+				continue;
+			}
+			r5ch->chunk_xor_iovs[c] = chunk->iovs;
+			r5ch->chunk_xor_iovcnt[c] = chunk->iovcnt;
+			stripe_req->chunk_xor_md_buffers[c] = chunk->md_buf;
+			c++;
 		}
-		r5ch->chunk_xor_iovs[c] = chunk->iovs;
-		r5ch->chunk_xor_iovcnt[c] = chunk->iovcnt;
-		c++;
+		r5ch->chunk_xor_iovs[c] = dest_chunk->iovs;
+		r5ch->chunk_xor_iovcnt[c] = dest_chunk->iovcnt;
+		dest_md_buf = dest_chunk->md_buf;
+		n_src = c;
+	} else {
+		n_src = raid5f_partial_write_xor_setup(stripe_req, &dest_md_buf);
 	}
-	r5ch->chunk_xor_iovs[c] = dest_chunk->iovs;
-	r5ch->chunk_xor_iovcnt[c] = dest_chunk->iovcnt;
 
+	stripe_req->xor.n_src = n_src;
 	stripe_req->xor.len = spdk_ioviter_firstv(stripe_req->chunk_iov_iters,
-			      raid_bdev->num_base_bdevs,
+			      n_src + 1,
 			      r5ch->chunk_xor_iovs,
 			      r5ch->chunk_xor_iovcnt,
 			      r5ch->chunk_xor_buffers);
@@ -322,21 +718,12 @@ raid5f_xor_stripe(struct stripe_request *stripe_req, stripe_req_xor_cb cb)
 	stripe_req->xor.cb = cb;
 
 	if (raid_io->md_buf != NULL) {
-		uint8_t n_src = raid5f_stripe_data_chunks_num(raid_bdev);
 		uint64_t len = num_blocks * raid_bdev->bdev.md_len;
 		int ret;
 
 		stripe_req->xor.remaining_md = len;
 
-		c = 0;
-		FOR_EACH_CHUNK(stripe_req, chunk) {
-			if (chunk != dest_chunk) {
-				stripe_req->chunk_xor_md_buffers[c] = chunk->md_buf;
-				c++;
-			}
-		}
-
-		ret = spdk_accel_submit_xor(stripe_req->r5ch->accel_ch, dest_chunk->md_buf,
+		ret = spdk_accel_submit_xor(stripe_req->r5ch->accel_ch, dest_md_buf,
 					    stripe_req->chunk_xor_md_buffers, n_src, len,
 					    raid5f_xor_stripe_md_cb, stripe_req);
 		if (spdk_unlikely(ret)) {
@@ -395,6 +782,9 @@ raid5f_chunk_complete_bdev_io(struct spdk_bdev_io *bdev_io, bool success, void *
 		raid5f_stripe_request_chunk_write_complete(stripe_req, status);
 	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
 		raid5f_stripe_request_chunk_read_complete(stripe_req, status);
+	} else if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+		/* The stripe request is released by the raid_io completion callback */
+		raid_bdev_io_complete_part(stripe_req->raid_io, 1, status);
 	} else {
 		assert(false);
 	}
@@ -421,6 +811,27 @@ raid5f_init_ext_io_opts(struct spdk_bdev_ext_io_opts *opts, struct raid_bdev_io
 	opts->metadata = raid_io->md_buf;
 }
 
+static bool
+raid5f_partial_write_chunk_needs_read(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	struct raid_bdev_io_channel *raid_ch = stripe_req->raid_io->raid_ch;
+
+	if (raid_bdev_channel_get_base_channel(raid_ch, chunk->index) == NULL) {
+		return false;
+	}
+
+	if (stripe_req->partial.reconstruct_chunk != NULL) {
+		return true;
+	}
+
+	if (stripe_req->partial.mode == RAID5F_PARTIAL_WRITE_RMW) {
+		return chunk == stripe_req->parity_chunk || chunk->req_blocks > 0;
+	} else {
+		return chunk != stripe_req->parity_chunk &&
+		       !raid5f_partial_write_chunk_covers_parity_range(stripe_req, chunk);
+	}
+}
+
 static int
 raid5f_chunk_submit(struct chunk *chunk)
 {
@@ -462,6 +873,52 @@ raid5f_chunk_submit(struct chunk *chunk)
 						 base_offset_blocks, raid_io->num_blocks,
 						 raid5f_chunk_complete_bdev_io, chunk, &io_opts);
 		break;
+	case STRIPE_REQ_PARTIAL_WRITE:
+		if (stripe_req->partial.reading) {
+			if (!raid5f_partial_write_chunk_needs_read(stripe_req, chunk)) {
+				raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+				return 0;
+			}
+
+			if (raid_io->md_buf != NULL) {
+				io_opts.metadata = stripe_req->partial.chunk_md_buffers[chunk->index];
+			}
+
+			ret = raid_bdev_readv_blocks_ext(base_info, base_ch,
+							 &stripe_req->partial.chunk_buf_iovs[chunk->index], 1,
+							 base_offset_blocks + stripe_req->partial.offset,
+							 stripe_req->partial.blocks,
+							 raid5f_chunk_complete_bdev_io, chunk, &io_opts);
+		} else if (chunk == stripe_req->parity_chunk) {
+			if (base_ch == NULL) {
+				raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+				return 0;
+			}
+
+			ret = raid_bdev_writev_blocks_ext(base_info, base_ch, chunk->iovs, chunk->iovcnt,
+							  base_offset_blocks + stripe_req->partial.offset,
+							  stripe_req->partial.blocks,
+							  raid5f_chunk_complete_bdev_io, chunk, &io_opts);
+		} else {
+			int iov_idx = chunk->req_offset > stripe_req->partial.offset ? 1 : 0;
+			int iovcnt = chunk->iovcnt - iov_idx;
+
+			if (base_ch == NULL || chunk->req_blocks == 0) {
+				raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+				return 0;
+			}
+
+			/* Skip the iovecs pointing to the old data around the written range */
+			if (chunk->req_offset + chunk->req_blocks <
+			    stripe_req->partial.offset + stripe_req->partial.blocks) {
+				iovcnt--;
+			}
+
+			ret = raid_bdev_writev_blocks_ext(base_info, base_ch, &chunk->iovs[iov_idx], iovcnt,
+							  base_offset_blocks + chunk->req_offset, chunk->req_blocks,
+							  raid5f_chunk_complete_bdev_io, chunk, &io_opts);
+		}
+		break;
 	default:
 		assert(false);
 		ret = -EINVAL;
@@ -481,6 +938,14 @@ raid5f_chunk_submit(struct chunk *chunk)
 			 */
 			uint64_t base_bdev_io_not_submitted;
 
+			if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+				/* The stripe request is released by the raid_io completion callback */
+				raid_bdev_io_complete_part(raid_io, raid_bdev->num_base_bdevs -
+							   raid_io->base_bdev_io_submitted,
+							   SPDK_BDEV_IO_STATUS_FAILED);
+				return ret;
+			}
+
 			if (stripe_req->type == STRIPE_REQ_WRITE) {
 				base_bdev_io_not_submitted = raid_bdev->num_base_bdevs -
 							     raid_io->base_bdev_io_submitted;
@@ -641,6 +1106,10 @@ raid5f_submit_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index)
 		return ret;
 	}
 
+	if (spdk_unlikely(!raid5f_stripe_request_activate(stripe_req))) {
+		return -EBUSY;
+	}
+
 	TAILQ_REMOVE(&r5ch->free_stripe_requests.write, stripe_req, link);
 
 	raid_io->module_private = stripe_req;
@@ -655,6 +1124,307 @@ raid5f_submit_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index)
 	return 0;
 }
 
+static int
+raid5f_partial_write_map_chunk_iovecs(struct stripe_request *stripe_req, struct chunk *chunk,
+				      uint64_t raid_io_offset_blocks)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	struct iovec *buf_iov = &stripe_req->partial.chunk_buf_iovs[chunk->index];
+	uint64_t head_blocks = chunk->req_offset - stripe_req->partial.offset;
+	uint64_t tail_blocks = stripe_req->partial.offset + stripe_req->partial.blocks -
+			       chunk->req_offset - chunk->req_blocks;
+	size_t raid_io_offset = raid_io_offset_blocks * blocklen;
+	size_t len = chunk->req_blocks * blocklen;
+	size_t iov_offset = 0;
+	int raid_io_iov_idx;
+	int iovcnt = 0;
+	int i, ret;
+
+	for (raid_io_iov_idx = 0; raid_io_iov_idx < raid_io->iovcnt; raid_io_iov_idx++) {
+		if (raid_io_offset < iov_offset + raid_io->iovs[raid_io_iov_idx].iov_len) {
+			break;
+		}
+		iov_offset += raid_io->iovs[raid_io_iov_idx].iov_len;
+	}
+	raid_io_offset -= iov_offset;
+
+	iov_offset = 0;
+	for (i = raid_io_iov_idx; i < raid_io->iovcnt && iov_offset < raid_io_offset + len; i++) {
+		iov_offset += raid_io->iovs[i].iov_len;
+		iovcnt++;
+	}
+
+	if (spdk_unlikely(iov_offset < raid_io_offset + len)) {
+		return -EINVAL;
+	}
+
+	/*
+	 * The chunk iovecs describe the new data of the whole parity range - the written part
+	 * comes from the raid_io and the rest of it from the old data read into the chunk buffer.
+	 */
+	ret = raid5f_chunk_set_iovcnt(chunk, iovcnt + (head_blocks ? 1 : 0) + (tail_blocks ? 1 : 0));
+	if (ret) {
+		return ret;
+	}
+
+	i = 0;
+	if (head_blocks) {
+		chunk->iovs[i].iov_base = buf_iov->iov_base;
+		chunk->iovs[i].iov_len = head_blocks * blocklen;
+		i++;
+	}
+
+	for (; len > 0; i++, raid_io_iov_idx++) {
+		const struct iovec *raid_io_iov = &raid_io->iovs[raid_io_iov_idx];
+
+		chunk->iovs[i].iov_base = raid_io_iov->iov_base + raid_io_offset;
+		chunk->iovs[i].iov_len = spdk_min(len, raid_io_iov->iov_len - raid_io_offset);
+		len -= chunk->iovs[i].iov_len;
+		raid_io_offset = 0;
+	}
+
+	if (tail_blocks) {
+		chunk->iovs[i].iov_base = buf_iov->iov_base + (head_blocks + chunk->req_blocks) * blocklen;
+		chunk->iovs[i].iov_len = tail_blocks * blocklen;
+	}
+
+	if (raid_io->md_buf != NULL) {
+		chunk->md_buf = raid_io->md_buf + raid_io_offset_blocks * raid_bdev->bdev.md_len;
+	}
+
+	return 0;
+}
+
+static int
+raid5f_partial_write_map(struct stripe_request *stripe_req, uint64_t stripe_offset)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_bdev_io_channel *raid_ch = raid_io->raid_ch;
+	uint64_t req_start = stripe_offset;
+	uint64_t req_end = stripe_offset + raid_io->num_blocks;
+	uint64_t range_start = UINT64_MAX;
+	uint64_t range_end = 0;
+	uint64_t chunk_start = 0;
+	uint8_t n_data = raid5f_stripe_data_chunks_num(raid_bdev);
+	uint8_t n_touched = 0;
+	struct chunk *missing = NULL;
+	struct chunk *chunk;
+	int ret;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		chunk->req_offset = 0;
+		chunk->req_blocks = 0;
+		if (raid_bdev_channel_get_base_channel(raid_ch, chunk->index) == NULL) {
+			missing = chunk;
+		}
+	}
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		uint64_t chunk_end = chunk_start + raid_bdev->strip_size;
+
+		if (req_start < chunk_end && req_end > chunk_start) {
+			chunk->req_offset = spdk_max(req_start, chunk_start) - chunk_start;
+			chunk->req_blocks = spdk_min(req_end, chunk_end) - chunk_start - chunk->req_offset;
+			range_start = spdk_min(range_start, chunk->req_offset);
+			range_end = spdk_max(range_end, chunk->req_offset + chunk->req_blocks);
+			n_touched++;
+		}
+		chunk_start = chunk_end;
+	}
+
+	assert(n_touched > 0);
+
+	stripe_req->partial.offset = range_start;
+	stripe_req->partial.blocks = range_end - range_start;
+	stripe_req->partial.reconstruct_chunk = NULL;
+
+	/*
+	 * Read-modify-write reads the old data of the written chunks and the old parity,
+	 * reconstruct-write reads the chunks that are not written. Pick the one that reads
+	 * fewer chunks.
+	 */
+	if (n_touched + 1 < n_data - n_touched) {
+		stripe_req->partial.mode = RAID5F_PARTIAL_WRITE_RMW;
+	} else {
+		stripe_req->partial.mode = RAID5F_PARTIAL_WRITE_RCW;
+	}
+
+	if (missing != NULL && missing != stripe_req->parity_chunk) {
+		if (missing->req_blocks > 0) {
+			/* The old data of a missing chunk can't be read for read-modify-write */
+			stripe_req->partial.mode = RAID5F_PARTIAL_WRITE_RCW;
+		}
+
+		if (stripe_req->partial.mode == RAID5F_PARTIAL_WRITE_RCW &&
+		    !raid5f_partial_write_chunk_covers_parity_range(stripe_req, missing)) {
+			stripe_req->partial.reconstruct_chunk = missing;
+		}
+	}
+
+	chunk_start = 0;
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		struct iovec *buf_iov = &stripe_req->partial.chunk_buf_iovs[chunk->index];
+
+		buf_iov->iov_len = stripe_req->partial.blocks * raid_bdev->bdev.blocklen;
+
+		if (chunk->req_blocks > 0) {
+			ret = raid5f_partial_write_map_chunk_iovecs(stripe_req, chunk,
+					chunk_start + chunk->req_offset - req_start);
+			if (ret) {
+				return ret;
+			}
+		}
+		chunk_start += raid_bdev->strip_size;
+	}
+
+	stripe_req->partial.chunk_buf_iovs[stripe_req->parity_chunk->index].iov_len =
+		stripe_req->partial.blocks * raid_bdev->bdev.blocklen;
+
+	stripe_req->parity_chunk->iovs[0].iov_base = stripe_req->partial.parity_buf;
+	stripe_req->parity_chunk->iovs[0].iov_len = stripe_req->partial.blocks * raid_bdev->bdev.blocklen;
+	stripe_req->parity_chunk->iovcnt = 1;
+	stripe_req->parity_chunk->md_buf = stripe_req->partial.parity_md_buf;
+
+	return 0;
+}
+
+static void
+raid5f_partial_write_complete(struct stripe_request *stripe_req, enum spdk_bdev_io_status status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	raid_io->completion_cb = NULL;
+
+	raid5f_stripe_request_release(stripe_req);
+
+	raid_bdev_io_complete(raid_io, status);
+}
+
+static void
+raid5f_partial_write_writes_completed_cb(struct raid_bdev_io *raid_io,
+		enum spdk_bdev_io_status status)
+{
+	raid5f_partial_write_complete(raid_io->module_private, status);
+}
+
+static void
+raid5f_partial_write_submit_writes(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	stripe_req->partial.reading = false;
+
+	raid_io->base_bdev_io_submitted = 0;
+	raid_io->base_bdev_io_remaining = raid_io->raid_bdev->num_base_bdevs;
+	raid_io->completion_cb = raid5f_partial_write_writes_completed_cb;
+	raid_bdev_io_set_default_status(raid_io, SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	raid5f_stripe_request_submit_chunks(stripe_req);
+}
+
+static void
+raid5f_partial_write_xor_done(struct stripe_request *stripe_req, int status)
+{
+	if (status != 0) {
+		raid5f_partial_write_complete(stripe_req, SPDK_BDEV_IO_STATUS_FAILED);
+	} else {
+		raid5f_partial_write_submit_writes(stripe_req);
+	}
+}
+
+static void
+raid5f_partial_write_reconstruct_xor_done(struct stripe_request *stripe_req, int status)
+{
+	if (status != 0) {
+		raid5f_partial_write_complete(stripe_req, SPDK_BDEV_IO_STATUS_FAILED);
+		return;
+	}
+
+	stripe_req->partial.reconstruct_chunk = NULL;
+
+	raid5f_xor_stripe(stripe_req, raid5f_partial_write_xor_done);
+}
+
+static void
+raid5f_partial_write_reads_completed_cb(struct raid_bdev_io *raid_io,
+					enum spdk_bdev_io_status status)
+{
+	struct stripe_request *stripe_req = raid_io->module_private;
+
+	raid_io->completion_cb = NULL;
+
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		raid5f_partial_write_complete(stripe_req, status);
+	} else if (stripe_req->partial.reconstruct_chunk != NULL) {
+		raid5f_xor_stripe(stripe_req, raid5f_partial_write_reconstruct_xor_done);
+	} else {
+		raid5f_xor_stripe(stripe_req, raid5f_partial_write_xor_done);
+	}
+}
+
+static struct stripe_request *raid5f_stripe_request_alloc(struct raid5f_io_channel *r5ch,
+		enum stripe_request_type type);
+
+static int
+raid5f_submit_partial_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+				    uint64_t stripe_offset)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid5f_io_channel *r5ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	struct stripe_request *stripe_req;
+	int ret;
+
+	stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.partial_write);
+	if (!stripe_req) {
+		/* Their buffers take as much memory as the full stripe writes, so only workloads
+		 * that actually do partial writes get them. */
+		if (r5ch->num_partial_write_reqs == RAID5F_MAX_STRIPES) {
+			return -ENOMEM;
+		}
+
+		stripe_req = raid5f_stripe_request_alloc(r5ch, STRIPE_REQ_PARTIAL_WRITE);
+		if (!stripe_req) {
+			return -ENOMEM;
+		}
+
+		r5ch->num_partial_write_reqs++;
+		TAILQ_INSERT_HEAD(&r5ch->free_stripe_requests.partial_write, stripe_req, link);
+	}
+
+	raid5f_stripe_request_init(stripe_req, raid_io, stripe_index);
+
+	ret = raid5f_partial_write_map(stripe_req, stripe_offset);
+	if (spdk_unlikely(ret)) {
+		return ret;
+	}
+
+	if (spdk_unlikely(!raid5f_stripe_request_activate(stripe_req))) {
+		return -EBUSY;
+	}
+
+	TAILQ_REMOVE(&r5ch->free_stripe_requests.partial_write, stripe_req, link);
+
+	raid_io->module_private = stripe_req;
+
+	if (raid_bdev_channel_get_base_channel(raid_io->raid_ch, stripe_req->parity_chunk->index) == NULL) {
+		/* Without the parity chunk there is nothing to update, just write the data */
+		raid5f_partial_write_submit_writes(stripe_req);
+		return 0;
+	}
+
+	stripe_req->partial.reading = true;
+
+	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
+	raid_io->completion_cb = raid5f_partial_write_reads_completed_cb;
+
+	raid5f_stripe_request_submit_chunks(stripe_req);
+
+	return 0;
+}
+
 static void
 raid5f_chunk_read_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
 {
@@ -676,6 +1446,15 @@ _raid5f_submit_rw_request(void *_raid_io)
 	raid5f_submit_rw_request(raid_io);
 }
 
+static void
+raid5f_stripe_wait(struct raid5f_io_channel *r5ch, struct raid_bdev_io *raid_io)
+{
+	raid_io->waitq_entry.bdev = &raid_io->raid_bdev->bdev;
+	raid_io->waitq_entry.cb_fn = _raid5f_submit_rw_request;
+	raid_io->waitq_entry.cb_arg = raid_io;
+	TAILQ_INSERT_TAIL(&r5ch->stripe_wait_queue, &raid_io->waitq_entry, link);
+}
+
 static void
 raid5f_stripe_request_reconstruct_xor_done(struct stripe_request *stripe_req, int status)
 {
@@ -757,6 +1536,10 @@ raid5f_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_ind
 		}
 	}
 
+	if (spdk_unlikely(!raid5f_stripe_request_activate(stripe_req))) {
+		return -EBUSY;
+	}
+
 	raid_io->module_private = stripe_req;
 	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
 	raid_io->completion_cb = raid5f_reconstruct_reads_completed_cb;
@@ -785,6 +1568,8 @@ raid5f_submit_read_request(struct raid_bdev_io *raid_io, uint64_t stripe_index,
 
 	raid5f_init_ext_io_opts(&io_opts, raid_io);
 	if (base_ch == NULL) {
+		/* Reconstruction needs the parity to be consistent with the data, so it waits for
+		 * writes to the stripe (-EBUSY) */
 		return raid5f_submit_reconstruct_read(raid_io, stripe_index, chunk_idx, chunk_offset,
 						      raid5f_stripe_request_reconstruct_xor_done);
 	}
@@ -816,16 +1601,26 @@ raid5f_submit_rw_request(struct raid_bdev_io *raid_io)
 		ret = raid5f_submit_read_request(raid_io, stripe_index, stripe_offset);
 		break;
 	case SPDK_BDEV_IO_TYPE_WRITE:
-		assert(stripe_offset == 0);
-		assert(raid_io->num_blocks == r5f_info->stripe_blocks);
-		ret = raid5f_submit_write_request(raid_io, stripe_index);
+		assert(stripe_offset + raid_io->num_blocks <= r5f_info->stripe_blocks);
+
+		/*
+		 * Writes to the same stripe are serialized (-EBUSY) on all io channels because
+		 * a partial stripe write must not read the stripe while another write is updating it.
+		 */
+		if (spdk_likely(raid_io->num_blocks == r5f_info->stripe_blocks)) {
+			ret = raid5f_submit_write_request(raid_io, stripe_index);
+		} else {
+			ret = raid5f_submit_partial_write_request(raid_io, stripe_index, stripe_offset);
+		}
 		break;
 	default:
 		ret = -EINVAL;
 		break;
 	}
 
-	if (spdk_unlikely(ret)) {
+	if (spdk_unlikely(ret == -EBUSY)) {
+		raid5f_stripe_wait(raid_bdev_channel_get_module_ctx(raid_io->raid_ch), raid_io);
+	} else if (spdk_unlikely(ret)) {
 		raid_bdev_io_complete(raid_io, ret == -ENOMEM ? SPDK_BDEV_IO_STATUS_NOMEM :
 				      SPDK_BDEV_IO_STATUS_FAILED);
 	}
@@ -861,6 +1656,36 @@ raid5f_stripe_request_free(struct stripe_request *stripe_req)
 			}
 			free(stripe_req->reconstruct.chunk_md_buffers);
 		}
+	} else if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+		struct raid5f_info *r5f_info = raid5f_ch_to_r5f_info(stripe_req->r5ch);
+		struct raid_bdev *raid_bdev = r5f_info->raid_bdev;
+		uint8_t i;
+
+		spdk_dma_free(stripe_req->partial.parity_buf);
+		spdk_dma_free(stripe_req->partial.parity_md_buf);
+
+		if (stripe_req->partial.chunk_buffers) {
+			for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+				spdk_dma_free(stripe_req->partial.chunk_buffers[i]);
+			}
+			free(stripe_req->partial.chunk_buffers);
+		}
+
+		if (stripe_req->partial.chunk_md_buffers) {
+			for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+				spdk_dma_free(stripe_req->partial.chunk_md_buffers[i]);
+			}
+			free(stripe_req->partial.chunk_md_buffers);
+		}
+
+		if (stripe_req->partial.chunk_new_md_buffers) {
+			for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+				spdk_dma_free(stripe_req->partial.chunk_new_md_buffers[i]);
+			}
+			free(stripe_req->partial.chunk_new_md_buffers);
+		}
+
+		free(stripe_req->partial.chunk_buf_iovs);
 	} else {
 		assert(false);
 	}
@@ -946,6 +1771,66 @@ raid5f_stripe_request_alloc(struct raid5f_io_channel *r5ch, enum stripe_request_
 				stripe_req->reconstruct.chunk_md_buffers[i] = buf;
 			}
 		}
+	} else if (type == STRIPE_REQ_PARTIAL_WRITE) {
+		uint8_t n = raid_bdev->num_base_bdevs;
+		void *buf;
+		uint8_t i;
+
+		stripe_req->partial.parity_buf = spdk_dma_malloc(chunk_len, r5f_info->buf_alignment, NULL);
+		if (!stripe_req->partial.parity_buf) {
+			goto err;
+		}
+
+		stripe_req->partial.chunk_buffers = calloc(n, sizeof(void *));
+		if (!stripe_req->partial.chunk_buffers) {
+			goto err;
+		}
+
+		stripe_req->partial.chunk_buf_iovs = calloc(n, sizeof(struct iovec));
+		if (!stripe_req->partial.chunk_buf_iovs) {
+			goto err;
+		}
+
+		for (i = 0; i < n; i++) {
+			buf = spdk_dma_malloc(chunk_len, r5f_info->buf_alignment, NULL);
+			if (!buf) {
+				goto err;
+			}
+			stripe_req->partial.chunk_buffers[i] = buf;
+			stripe_req->partial.chunk_buf_iovs[i].iov_base = buf;
+		}
+
+		if (raid_io_md_size != 0) {
+			stripe_req->partial.parity_md_buf = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size,
+							    r5f_info->buf_alignment, NULL);
+			if (!stripe_req->partial.parity_md_buf) {
+				goto err;
+			}
+
+			stripe_req->partial.chunk_md_buffers = calloc(n, sizeof(void *));
+			if (!stripe_req->partial.chunk_md_buffers) {
+				goto err;
+			}
+
+			stripe_req->partial.chunk_new_md_buffers = calloc(n, sizeof(void *));
+			if (!stripe_req->partial.chunk_new_md_buffers) {
+				goto err;
+			}
+
+			for (i = 0; i < n; i++) {
+				buf = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size, r5f_info->buf_alignment, NULL);
+				if (!buf) {
+					goto err;
+				}
+				stripe_req->partial.chunk_md_buffers[i] = buf;
+
+				buf = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size, r5f_info->buf_alignment, NULL);
+				if (!buf) {
+					goto err;
+				}
+				stripe_req->partial.chunk_new_md_buffers[i] = buf;
+			}
+		}
 	} else {
 		assert(false);
 		return NULL;
@@ -981,6 +1866,8 @@ raid5f_ioch_destroy(void *io_device, void *ctx_buf)
 	struct stripe_request *stripe_req;
 
 	assert(TAILQ_EMPTY(&r5ch->xor_retry_queue));
+	assert(TAILQ_EMPTY(&r5ch->stripe_wait_queue));
+	assert(!r5ch->stripe_waiting);
 
 	while ((stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.write))) {
 		TAILQ_REMOVE(&r5ch->free_stripe_requests.write, stripe_req, link);
@@ -992,6 +1879,11 @@ raid5f_ioch_destroy(void *io_device, void *ctx_buf)
 		raid5f_stripe_request_free(stripe_req);
 	}
 
+	while ((stripe_req = TAILQ_FIRST(&r5ch->free_stripe_requests.partial_write))) {
+		TAILQ_REMOVE(&r5ch->free_stripe_requests.partial_write, stripe_req, link);
+		raid5f_stripe_request_free(stripe_req);
+	}
+
 	if (r5ch->accel_ch) {
 		spdk_put_io_channel(r5ch->accel_ch);
 	}
@@ -1012,6 +1904,8 @@ raid5f_ioch_create(void *io_device, void *ctx_buf)
 
 	TAILQ_INIT(&r5ch->free_stripe_requests.write);
 	TAILQ_INIT(&r5ch->free_stripe_requests.reconstruct);
+	TAILQ_INIT(&r5ch->free_stripe_requests.partial_write);
+	TAILQ_INIT(&r5ch->stripe_wait_queue);
 	TAILQ_INIT(&r5ch->xor_retry_queue);
 
 	for (i = 0; i < RAID5F_MAX_STRIPES; i++) {
@@ -1069,6 +1963,7 @@ raid5f_start(struct raid_bdev *raid_bdev)
 	struct spdk_bdev *base_bdev;
 	struct raid5f_info *r5f_info;
 	size_t alignment = 0;
+	int i;
 
 	r5f_info = calloc(1, sizeof(*r5f_info));
 	if (!r5f_info) {
@@ -1077,6 +1972,12 @@ raid5f_start(struct raid_bdev *raid_bdev)
 	}
 	r5f_info->raid_bdev = raid_bdev;
 
+	spdk_spin_init(&r5f_info->active_stripe_requests_lock);
+	for (i = 0; i < RAID5F_ACTIVE_STRIPE_BUCKETS; i++) {
+		TAILQ_INIT(&r5f_info->active_stripe_requests[i]);
+	}
+	TAILQ_INIT(&r5f_info->stripe_waiters);
+
 	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
 		min_blockcnt = spdk_min(min_blockcnt, base_info->data_size);
 		if (base_info->desc) {
@@ -1103,6 +2004,7 @@ raid5f_start(struct raid_bdev *raid_bdev)
 	raid_bdev->bdev.split_on_optimal_io_boundary = true;
 	raid_bdev->bdev.write_unit_size = r5f_info->stripe_blocks;
 	raid_bdev->bdev.split_on_write_unit = true;
+	raid_bdev->bdev.allow_partial_write_unit = true;
 
 	raid_bdev->module_private = r5f_info;
 
@@ -1119,6 +2021,7 @@ raid5f_io_device_unregister_done(void *io_device)
 
 	raid_bdev_module_stop_done(r5f_info->raid_bdev);
 
+	spdk_spin_destroy(&r5f_info->active_stripe_requests_lock);
 	free(r5f_info);
 }
 
@@ -1224,6 +2127,7 @@ raid5f_submit_process_request(struct raid_bdev_process_request *process_req,
 			  process_req->offset_blocks, raid_bdev->strip_size,
 			  &process_req->iov, 1, process_req->md_buf, NULL, NULL);
 
+	/* The range of the process is quiesced, so no write can make this fail with -EBUSY */
 	ret = raid5f_submit_reconstruct_read(raid_io, stripe_index, chunk_idx, 0,
 					     raid5f_process_stripe_request_reconstruct_xor_done);
 	if (spdk_likely(ret == 0)) {
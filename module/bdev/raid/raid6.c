@@ -0,0 +1,1611 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+#include "bdev_raid.h"
+
+#include "spdk/config.h"
+#include "spdk/env.h"
+#include "spdk/thread.h"
+#include "spdk/string.h"
+#include "spdk/util.h"
+#include "spdk/likely.h"
+#include "spdk/log.h"
+
+/* Maximum concurrent full stripe writes per io channel */
+#define RAID6_MAX_STRIPES 32
+
+/*
+ * P and Q are calculated over GF(2^8) with the generator polynomial 0x11d:
+ *
+ *   P = D_0 + D_1 + ... + D_(k-1)
+ *   Q = g^0 * D_0 + g^1 * D_1 + ... + g^(k-1) * D_(k-1), g = 2
+ *
+ * Both parities and the recovery of up to two missing chunks are expressed as
+ * multiplication by a coefficient matrix, which ISA-L performs with vectorized
+ * table lookups (ec_encode_data()). When ISA-L is not available a lookup table
+ * based implementation is used instead.
+ */
+#ifdef SPDK_CONFIG_ISAL
+#include "isa-l/include/erasure_code.h"
+
+/* Size of the ISA-L expanded multiplication table for a single coefficient */
+#define RAID6_GF_TBL_SIZE 32
+
+static inline uint8_t
+raid6_gf_mul(uint8_t a, uint8_t b)
+{
+	return gf_mul(a, b);
+}
+
+static inline int
+raid6_gf_invert_matrix(uint8_t *in, uint8_t *out, int n)
+{
+	return gf_invert_matrix(in, out, n);
+}
+
+static inline void
+raid6_gf_init_tables(int k, int rows, uint8_t *coeffs, uint8_t *tables)
+{
+	ec_init_tables(k, rows, coeffs, tables);
+}
+
+static inline void
+raid6_gf_encode(int len, int k, int rows, uint8_t *tables, uint8_t **src, uint8_t **dest)
+{
+	ec_encode_data(len, k, rows, tables, src, dest);
+}
+
+#else
+
+/* Size of the full multiplication table for a single coefficient */
+#define RAID6_GF_TBL_SIZE 256
+
+static uint8_t
+raid6_gf_mul(uint8_t a, uint8_t b)
+{
+	uint8_t p = 0;
+
+	while (b) {
+		if (b & 1) {
+			p ^= a;
+		}
+		a = (a << 1) ^ ((a & 0x80) ? 0x1d : 0);
+		b >>= 1;
+	}
+
+	return p;
+}
+
+static uint8_t
+raid6_gf_inv(uint8_t a)
+{
+	uint8_t inv = 1;
+	int i;
+
+	/* a^254 == a^-1 */
+	for (i = 0; i < 254; i++) {
+		inv = raid6_gf_mul(inv, a);
+	}
+
+	return inv;
+}
+
+static int
+raid6_gf_invert_matrix(uint8_t *in, uint8_t *out, int n)
+{
+	uint8_t tmp;
+	int i, j, k;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < n; j++) {
+			out[i * n + j] = i == j ? 1 : 0;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		if (in[i * n + i] == 0) {
+			for (j = i + 1; j < n; j++) {
+				if (in[j * n + i] != 0) {
+					break;
+				}
+			}
+			if (j == n) {
+				return -1;
+			}
+			for (k = 0; k < n; k++) {
+				tmp = in[i * n + k];
+				in[i * n + k] = in[j * n + k];
+				in[j * n + k] = tmp;
+				tmp = out[i * n + k];
+				out[i * n + k] = out[j * n + k];
+				out[j * n + k] = tmp;
+			}
+		}
+
+		tmp = raid6_gf_inv(in[i * n + i]);
+		for (k = 0; k < n; k++) {
+			in[i * n + k] = raid6_gf_mul(in[i * n + k], tmp);
+			out[i * n + k] = raid6_gf_mul(out[i * n + k], tmp);
+		}
+
+		for (j = 0; j < n; j++) {
+			if (j == i || in[j * n + i] == 0) {
+				continue;
+			}
+			tmp = in[j * n + i];
+			for (k = 0; k < n; k++) {
+				in[j * n + k] ^= raid6_gf_mul(tmp, in[i * n + k]);
+				out[j * n + k] ^= raid6_gf_mul(tmp, out[i * n + k]);
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void
+raid6_gf_init_tables(int k, int rows, uint8_t *coeffs, uint8_t *tables)
+{
+	int i, b;
+
+	for (i = 0; i < k * rows; i++) {
+		for (b = 0; b < 256; b++) {
+			tables[i * RAID6_GF_TBL_SIZE + b] = raid6_gf_mul(coeffs[i], b);
+		}
+	}
+}
+
+static void
+raid6_gf_encode(int len, int k, int rows, uint8_t *tables, uint8_t **src, uint8_t **dest)
+{
+	int r, i, b;
+
+	for (r = 0; r < rows; r++) {
+		uint8_t *tbl = tables + r * k * RAID6_GF_TBL_SIZE;
+
+		for (b = 0; b < len; b++) {
+			uint8_t v = 0;
+
+			for (i = 0; i < k; i++) {
+				v ^= tbl[i * RAID6_GF_TBL_SIZE + src[i][b]];
+			}
+			dest[r][b] = v;
+		}
+	}
+}
+
+#endif
+
+struct chunk {
+	/* Corresponds to base_bdev index */
+	uint8_t index;
+
+	/* Array of iovecs */
+	struct iovec *iovs;
+
+	/* Number of used iovecs */
+	int iovcnt;
+
+	/* Total number of available iovecs in the array */
+	int iovcnt_max;
+
+	/* Pointer to buffer with I/O metadata */
+	void *md_buf;
+};
+
+struct stripe_request;
+typedef void (*stripe_req_gf_cb)(struct stripe_request *stripe_req, int status);
+
+struct stripe_request {
+	enum stripe_request_type {
+		STRIPE_REQ_WRITE,
+		STRIPE_REQ_RECONSTRUCT,
+	} type;
+
+	struct raid6_io_channel *r6ch;
+
+	/* The associated raid_bdev_io */
+	struct raid_bdev_io *raid_io;
+
+	/* The stripe's index in the raid array. */
+	uint64_t stripe_index;
+
+	/* The stripe's parity chunks */
+	struct chunk *p_chunk;
+	struct chunk *q_chunk;
+
+	union {
+		struct {
+			/* Buffers for stripe parity */
+			void *p_buf;
+			void *q_buf;
+
+			/* Buffers for stripe io metadata parity */
+			void *p_md_buf;
+			void *q_md_buf;
+		} write;
+
+		struct {
+			/* Array of buffers for reading chunk data */
+			void **chunk_buffers;
+
+			/* Array of buffers for reading chunk metadata */
+			void **chunk_md_buffers;
+
+			/* Chunks read to reconstruct the missing chunk */
+			struct chunk **sources;
+
+			/* Chunk to reconstruct */
+			struct chunk *chunk;
+
+			/* Offset from chunk start */
+			uint64_t chunk_offset;
+
+			/* Expanded coefficients for reconstructing the chunk from the sources */
+			uint8_t *gf_tables;
+
+			/* Called when the chunk is reconstructed */
+			stripe_req_gf_cb cb;
+		} reconstruct;
+	};
+
+	/* Array of iovec iterators for each chunk */
+	struct spdk_ioviter *chunk_iov_iters;
+
+	TAILQ_ENTRY(stripe_request) link;
+
+	/* Link in the list of stripe requests in progress on the io channel */
+	TAILQ_ENTRY(stripe_request) active_link;
+
+	/* Array of chunks corresponding to base_bdevs */
+	struct chunk chunks[0];
+};
+
+struct raid6_info {
+	/* The parent raid bdev */
+	struct raid_bdev *raid_bdev;
+
+	/* Number of data blocks in a stripe (without parity) */
+	uint64_t stripe_blocks;
+
+	/* Number of stripes on this array */
+	uint64_t total_stripes;
+
+	/* Alignment for buffer allocation */
+	size_t buf_alignment;
+
+	/* block length bit shift for optimized calculation, only valid when no interleaved md */
+	uint32_t blocklen_shift;
+
+	/* Coefficient matrix of the whole stripe - data rows followed by the P and Q rows */
+	uint8_t *gf_matrix;
+
+	/* Expanded coefficients of the P and Q rows */
+	uint8_t *gf_encode_tables;
+};
+
+struct raid6_io_channel {
+	/* All available stripe requests on this channel */
+	struct {
+		TAILQ_HEAD(, stripe_request) write;
+		TAILQ_HEAD(, stripe_request) reconstruct;
+	} free_stripe_requests;
+
+	/* Stripe requests in progress, used to serialize reconstruction with writes to a stripe */
+	TAILQ_HEAD(, stripe_request) active_stripe_requests;
+
+	/* I/O waiting for a conflicting stripe request to complete */
+	TAILQ_HEAD(, spdk_bdev_io_wait_entry) stripe_wait_queue;
+	bool stripe_wait_queue_resuming;
+
+	/* For iterating over chunk iovecs during parity calculation */
+	void **chunk_gf_buffers;
+	struct iovec **chunk_gf_iovs;
+	size_t *chunk_gf_iovcnt;
+
+	/* Chunk metadata buffers for parity calculation */
+	void **chunk_gf_md_buffers;
+
+	/* Scratch space for calculating the reconstruction coefficients */
+	uint8_t *gf_matrix;
+	uint8_t *gf_matrix_inv;
+};
+
+#define __CHUNK_IN_RANGE(req, c) \
+	c < req->chunks + raid6_ch_to_r6_info(req->r6ch)->raid_bdev->num_base_bdevs
+
+#define FOR_EACH_CHUNK_FROM(req, c, from) \
+	for (c = from; __CHUNK_IN_RANGE(req, c); c++)
+
+#define FOR_EACH_CHUNK(req, c) \
+	FOR_EACH_CHUNK_FROM(req, c, req->chunks)
+
+#define __NEXT_DATA_CHUNK(req, c) \
+	raid6_next_data_chunk(req, c)
+
+#define FOR_EACH_DATA_CHUNK(req, c) \
+	for (c = __NEXT_DATA_CHUNK(req, req->chunks); __CHUNK_IN_RANGE(req, c); \
+	     c = __NEXT_DATA_CHUNK(req, c+1))
+
+static inline struct raid6_info *
+raid6_ch_to_r6_info(struct raid6_io_channel *r6ch)
+{
+	return spdk_io_channel_get_io_device(spdk_io_channel_from_ctx(r6ch));
+}
+
+static inline struct stripe_request *
+raid6_chunk_stripe_req(struct chunk *chunk)
+{
+	return SPDK_CONTAINEROF((chunk - chunk->index), struct stripe_request, chunks);
+}
+
+static inline struct chunk *
+raid6_next_data_chunk(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	while (chunk == stripe_req->p_chunk || chunk == stripe_req->q_chunk) {
+		chunk++;
+	}
+
+	return chunk;
+}
+
+static inline uint8_t
+raid6_stripe_data_chunks_num(const struct raid_bdev *raid_bdev)
+{
+	return raid_bdev->min_base_bdevs_operational;
+}
+
+static inline uint8_t
+raid6_stripe_q_chunk_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index)
+{
+	return raid_bdev->num_base_bdevs - 1 - stripe_index % raid_bdev->num_base_bdevs;
+}
+
+static inline uint8_t
+raid6_stripe_p_chunk_index(const struct raid_bdev *raid_bdev, uint64_t stripe_index)
+{
+	uint8_t q_idx = raid6_stripe_q_chunk_index(raid_bdev, stripe_index);
+
+	return q_idx == 0 ? raid_bdev->num_base_bdevs - 1 : q_idx - 1;
+}
+
+/* Get the chunk's row in the stripe coefficient matrix */
+static uint8_t
+raid6_chunk_gf_row(struct stripe_request *stripe_req, struct chunk *chunk)
+{
+	uint8_t n_data = raid6_stripe_data_chunks_num(stripe_req->raid_io->raid_bdev);
+	uint8_t row = chunk->index;
+
+	if (chunk == stripe_req->p_chunk) {
+		return n_data;
+	} else if (chunk == stripe_req->q_chunk) {
+		return n_data + 1;
+	}
+
+	if (chunk > stripe_req->p_chunk) {
+		row--;
+	}
+	if (chunk > stripe_req->q_chunk) {
+		row--;
+	}
+
+	return row;
+}
+
+static bool
+raid6_stripe_is_busy(struct raid6_io_channel *r6ch, uint64_t stripe_index, bool write)
+{
+	struct stripe_request *stripe_req;
+
+	TAILQ_FOREACH(stripe_req, &r6ch->active_stripe_requests, active_link) {
+		if (stripe_req->stripe_index == stripe_index &&
+		    (write || stripe_req->type != STRIPE_REQ_RECONSTRUCT)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool
+raid6_raid_io_is_blocked(struct raid6_io_channel *r6ch, struct raid_bdev_io *raid_io)
+{
+	struct raid6_info *r6_info = raid_io->raid_bdev->module_private;
+
+	return raid6_stripe_is_busy(r6ch, raid_io->offset_blocks / r6_info->stripe_blocks,
+				    raid_io->type == SPDK_BDEV_IO_TYPE_WRITE);
+}
+
+static void
+raid6_stripe_wait_queue_resume(struct raid6_io_channel *r6ch)
+{
+	struct spdk_bdev_io_wait_entry *entry;
+	bool resumed;
+
+	/* Resubmitted I/O may complete (and release a stripe) inline - let the outer loop handle it */
+	if (r6ch->stripe_wait_queue_resuming) {
+		return;
+	}
+
+	r6ch->stripe_wait_queue_resuming = true;
+
+	do {
+		resumed = false;
+
+		TAILQ_FOREACH(entry, &r6ch->stripe_wait_queue, link) {
+			if (!raid6_raid_io_is_blocked(r6ch, entry->cb_arg)) {
+				TAILQ_REMOVE(&r6ch->stripe_wait_queue, entry, link);
+				entry->cb_fn(entry->cb_arg);
+				resumed = true;
+				break;
+			}
+		}
+	} while (resumed);
+
+	r6ch->stripe_wait_queue_resuming = false;
+}
+
+static void
+raid6_stripe_request_release(struct stripe_request *stripe_req)
+{
+	struct raid6_io_channel *r6ch = stripe_req->r6ch;
+
+	TAILQ_REMOVE(&r6ch->active_stripe_requests, stripe_req, active_link);
+
+	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
+		TAILQ_INSERT_HEAD(&r6ch->free_stripe_requests.write, stripe_req, link);
+	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+		TAILQ_INSERT_HEAD(&r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+	} else {
+		assert(false);
+	}
+
+	if (spdk_unlikely(!TAILQ_EMPTY(&r6ch->stripe_wait_queue))) {
+		raid6_stripe_wait_queue_resume(r6ch);
+	}
+}
+
+/*
+ * Multiply the n_src source chunks by the expanded coefficients in tables and store the
+ * results in the n_dest destination chunks. r6ch->chunk_gf_iovs must be set up with the
+ * sources followed by the destinations.
+ */
+static void
+raid6_gf_stripe(struct stripe_request *stripe_req, uint8_t n_src, uint8_t n_dest,
+		uint8_t *tables, void **src_md_bufs, void **dest_md_bufs, uint64_t num_blocks)
+{
+	struct raid6_io_channel *r6ch = stripe_req->r6ch;
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	uint8_t **bufs = (uint8_t **)r6ch->chunk_gf_buffers;
+	size_t len;
+
+	for (len = spdk_ioviter_firstv(stripe_req->chunk_iov_iters, n_src + n_dest,
+				       r6ch->chunk_gf_iovs, r6ch->chunk_gf_iovcnt,
+				       r6ch->chunk_gf_buffers);
+	     len > 0;
+	     len = spdk_ioviter_nextv(stripe_req->chunk_iov_iters, r6ch->chunk_gf_buffers)) {
+		raid6_gf_encode(len, n_src, n_dest, tables, bufs, bufs + n_src);
+	}
+
+	if (src_md_bufs != NULL) {
+		raid6_gf_encode(num_blocks * raid_bdev->bdev.md_len, n_src, n_dest, tables,
+				(uint8_t **)src_md_bufs, (uint8_t **)dest_md_bufs);
+	}
+}
+
+static void
+raid6_gen_pq(struct stripe_request *stripe_req)
+{
+	struct raid6_io_channel *r6ch = stripe_req->r6ch;
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6_info *r6_info = raid_bdev->module_private;
+	uint8_t n_data = raid6_stripe_data_chunks_num(raid_bdev);
+	void **md_bufs = r6ch->chunk_gf_md_buffers;
+	struct chunk *chunk;
+	uint8_t c = 0;
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		r6ch->chunk_gf_iovs[c] = chunk->iovs;
+		r6ch->chunk_gf_iovcnt[c] = chunk->iovcnt;
+		md_bufs[c] = chunk->md_buf;
+		c++;
+	}
+
+	r6ch->chunk_gf_iovs[n_data] = stripe_req->p_chunk->iovs;
+	r6ch->chunk_gf_iovcnt[n_data] = stripe_req->p_chunk->iovcnt;
+	md_bufs[n_data] = stripe_req->p_chunk->md_buf;
+	r6ch->chunk_gf_iovs[n_data + 1] = stripe_req->q_chunk->iovs;
+	r6ch->chunk_gf_iovcnt[n_data + 1] = stripe_req->q_chunk->iovcnt;
+	md_bufs[n_data + 1] = stripe_req->q_chunk->md_buf;
+
+	raid6_gf_stripe(stripe_req, n_data, 2, r6_info->gf_encode_tables,
+			raid_io->md_buf != NULL ? md_bufs : NULL, md_bufs + n_data,
+			raid_bdev->strip_size);
+}
+
+/*
+ * Calculate the coefficients for reconstructing the chunk from the source chunks. The
+ * source rows of the stripe matrix are inverted to get the data chunks from the sources
+ * and, if the chunk is a parity chunk, multiplied by its row.
+ */
+static int
+raid6_reconstruct_init_tables(struct stripe_request *stripe_req)
+{
+	struct raid6_io_channel *r6ch = stripe_req->r6ch;
+	struct raid_bdev *raid_bdev = stripe_req->raid_io->raid_bdev;
+	struct raid6_info *r6_info = raid_bdev->module_private;
+	uint8_t n_data = raid6_stripe_data_chunks_num(raid_bdev);
+	uint8_t coeffs[UINT8_MAX];
+	uint8_t row;
+	uint8_t i, j;
+
+	for (i = 0; i < n_data; i++) {
+		row = raid6_chunk_gf_row(stripe_req, stripe_req->reconstruct.sources[i]);
+		memcpy(&r6ch->gf_matrix[i * n_data], &r6_info->gf_matrix[row * n_data], n_data);
+	}
+
+	if (raid6_gf_invert_matrix(r6ch->gf_matrix, r6ch->gf_matrix_inv, n_data) != 0) {
+		return -EINVAL;
+	}
+
+	row = raid6_chunk_gf_row(stripe_req, stripe_req->reconstruct.chunk);
+	if (row < n_data) {
+		memcpy(coeffs, &r6ch->gf_matrix_inv[row * n_data], n_data);
+	} else {
+		for (i = 0; i < n_data; i++) {
+			coeffs[i] = 0;
+			for (j = 0; j < n_data; j++) {
+				coeffs[i] ^= raid6_gf_mul(r6_info->gf_matrix[row * n_data + j],
+							  r6ch->gf_matrix_inv[j * n_data + i]);
+			}
+		}
+	}
+
+	raid6_gf_init_tables(n_data, 1, coeffs, stripe_req->reconstruct.gf_tables);
+
+	return 0;
+}
+
+static int
+raid6_reconstruct_chunk(struct stripe_request *stripe_req)
+{
+	struct raid6_io_channel *r6ch = stripe_req->r6ch;
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	uint8_t n_data = raid6_stripe_data_chunks_num(raid_io->raid_bdev);
+	struct chunk *chunk = stripe_req->reconstruct.chunk;
+	void **md_bufs = r6ch->chunk_gf_md_buffers;
+	uint8_t i;
+	int ret;
+
+	ret = raid6_reconstruct_init_tables(stripe_req);
+	if (spdk_unlikely(ret != 0)) {
+		return ret;
+	}
+
+	for (i = 0; i < n_data; i++) {
+		r6ch->chunk_gf_iovs[i] = stripe_req->reconstruct.sources[i]->iovs;
+		r6ch->chunk_gf_iovcnt[i] = stripe_req->reconstruct.sources[i]->iovcnt;
+		md_bufs[i] = stripe_req->reconstruct.sources[i]->md_buf;
+	}
+	r6ch->chunk_gf_iovs[n_data] = chunk->iovs;
+	r6ch->chunk_gf_iovcnt[n_data] = chunk->iovcnt;
+	md_bufs[n_data] = chunk->md_buf;
+
+	raid6_gf_stripe(stripe_req, n_data, 1, stripe_req->reconstruct.gf_tables,
+			raid_io->md_buf != NULL ? md_bufs : NULL, md_bufs + n_data,
+			raid_io->num_blocks);
+
+	return 0;
+}
+
+static void
+raid6_stripe_request_chunk_write_complete(struct stripe_request *stripe_req,
+		enum spdk_bdev_io_status status)
+{
+	if (raid_bdev_io_complete_part(stripe_req->raid_io, 1, status)) {
+		raid6_stripe_request_release(stripe_req);
+	}
+}
+
+static void
+raid6_stripe_request_chunk_read_complete(struct stripe_request *stripe_req,
+		enum spdk_bdev_io_status status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	raid_bdev_io_complete_part(raid_io, 1, status);
+}
+
+static void
+raid6_chunk_complete_bdev_io(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct chunk *chunk = cb_arg;
+	struct stripe_request *stripe_req = raid6_chunk_stripe_req(chunk);
+	enum spdk_bdev_io_status status = success ? SPDK_BDEV_IO_STATUS_SUCCESS :
+					  SPDK_BDEV_IO_STATUS_FAILED;
+
+	spdk_bdev_free_io(bdev_io);
+
+	if (spdk_likely(stripe_req->type == STRIPE_REQ_WRITE)) {
+		raid6_stripe_request_chunk_write_complete(stripe_req, status);
+	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+		raid6_stripe_request_chunk_read_complete(stripe_req, status);
+	} else {
+		assert(false);
+	}
+}
+
+static void raid6_stripe_request_submit_chunks(struct stripe_request *stripe_req);
+
+static void
+raid6_chunk_submit_retry(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+	struct stripe_request *stripe_req = raid_io->module_private;
+
+	raid6_stripe_request_submit_chunks(stripe_req);
+}
+
+static inline void
+raid6_init_ext_io_opts(struct spdk_bdev_ext_io_opts *opts, struct raid_bdev_io *raid_io)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->size = sizeof(*opts);
+	opts->memory_domain = raid_io->memory_domain;
+	opts->memory_domain_ctx = raid_io->memory_domain_ctx;
+	opts->metadata = raid_io->md_buf;
+}
+
+static int
+raid6_chunk_submit(struct chunk *chunk)
+{
+	struct stripe_request *stripe_req = raid6_chunk_stripe_req(chunk);
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid_base_bdev_info *base_info = &raid_bdev->base_bdev_info[chunk->index];
+	struct spdk_io_channel *base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch,
+					  chunk->index);
+	uint64_t base_offset_blocks = (stripe_req->stripe_index << raid_bdev->strip_size_shift);
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	raid6_init_ext_io_opts(&io_opts, raid_io);
+	io_opts.metadata = chunk->md_buf;
+
+	raid_io->base_bdev_io_submitted++;
+
+	switch (stripe_req->type) {
+	case STRIPE_REQ_WRITE:
+		if (base_ch == NULL) {
+			raid_bdev_io_complete_part(raid_io, 1, SPDK_BDEV_IO_STATUS_SUCCESS);
+			return 0;
+		}
+
+		ret = raid_bdev_writev_blocks_ext(base_info, base_ch, chunk->iovs, chunk->iovcnt,
+						  base_offset_blocks, raid_bdev->strip_size,
+						  raid6_chunk_complete_bdev_io, chunk, &io_opts);
+		break;
+	case STRIPE_REQ_RECONSTRUCT:
+		base_offset_blocks += stripe_req->reconstruct.chunk_offset;
+
+		ret = raid_bdev_readv_blocks_ext(base_info, base_ch, chunk->iovs, chunk->iovcnt,
+						 base_offset_blocks, raid_io->num_blocks,
+						 raid6_chunk_complete_bdev_io, chunk, &io_opts);
+		break;
+	default:
+		assert(false);
+		ret = -EINVAL;
+		break;
+	}
+
+	if (spdk_unlikely(ret)) {
+		raid_io->base_bdev_io_submitted--;
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+						base_ch, raid6_chunk_submit_retry);
+		} else {
+			/*
+			 * Implicitly complete any I/Os not yet submitted as FAILED. If completing
+			 * these means there are no more to complete for the stripe request, we can
+			 * release the stripe request as well.
+			 */
+			uint64_t base_bdev_io_not_submitted;
+
+			if (stripe_req->type == STRIPE_REQ_WRITE) {
+				base_bdev_io_not_submitted = raid_bdev->num_base_bdevs -
+							     raid_io->base_bdev_io_submitted;
+			} else {
+				base_bdev_io_not_submitted = raid6_stripe_data_chunks_num(raid_bdev) -
+							     raid_io->base_bdev_io_submitted;
+			}
+
+			if (raid_bdev_io_complete_part(raid_io, base_bdev_io_not_submitted,
+						       SPDK_BDEV_IO_STATUS_FAILED) &&
+			    stripe_req->type == STRIPE_REQ_WRITE) {
+				raid6_stripe_request_release(stripe_req);
+			}
+		}
+	}
+
+	return ret;
+}
+
+static int
+raid6_chunk_set_iovcnt(struct chunk *chunk, int iovcnt)
+{
+	if (iovcnt > chunk->iovcnt_max) {
+		struct iovec *iovs = chunk->iovs;
+
+		iovs = realloc(iovs, iovcnt * sizeof(*iovs));
+		if (!iovs) {
+			return -ENOMEM;
+		}
+		chunk->iovs = iovs;
+		chunk->iovcnt_max = iovcnt;
+	}
+	chunk->iovcnt = iovcnt;
+
+	return 0;
+}
+
+static int
+raid6_stripe_request_map_iovecs(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6_info *r6_info = raid_bdev->module_private;
+	struct chunk *chunk;
+	int raid_io_iov_idx = 0;
+	size_t raid_io_offset = 0;
+	size_t raid_io_iov_offset = 0;
+	int i;
+
+	FOR_EACH_DATA_CHUNK(stripe_req, chunk) {
+		int chunk_iovcnt = 0;
+		uint64_t len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+		size_t off = raid_io_iov_offset;
+		int ret;
+
+		for (i = raid_io_iov_idx; i < raid_io->iovcnt; i++) {
+			chunk_iovcnt++;
+			off += raid_io->iovs[i].iov_len;
+			if (off >= raid_io_offset + len) {
+				break;
+			}
+		}
+
+		assert(raid_io_iov_idx + chunk_iovcnt <= raid_io->iovcnt);
+
+		ret = raid6_chunk_set_iovcnt(chunk, chunk_iovcnt);
+		if (ret) {
+			return ret;
+		}
+
+		if (raid_io->md_buf != NULL) {
+			chunk->md_buf = raid_io->md_buf +
+					(raid_io_offset >> r6_info->blocklen_shift) * raid_bdev->bdev.md_len;
+		}
+
+		for (i = 0; i < chunk_iovcnt; i++) {
+			struct iovec *chunk_iov = &chunk->iovs[i];
+			const struct iovec *raid_io_iov = &raid_io->iovs[raid_io_iov_idx];
+			size_t chunk_iov_offset = raid_io_offset - raid_io_iov_offset;
+
+			chunk_iov->iov_base = raid_io_iov->iov_base + chunk_iov_offset;
+			chunk_iov->iov_len = spdk_min(len, raid_io_iov->iov_len - chunk_iov_offset);
+			raid_io_offset += chunk_iov->iov_len;
+			len -= chunk_iov->iov_len;
+
+			if (raid_io_offset >= raid_io_iov_offset + raid_io_iov->iov_len) {
+				raid_io_iov_idx++;
+				raid_io_iov_offset += raid_io_iov->iov_len;
+			}
+		}
+
+		if (spdk_unlikely(len > 0)) {
+			return -EINVAL;
+		}
+	}
+
+	stripe_req->p_chunk->iovs[0].iov_base = stripe_req->write.p_buf;
+	stripe_req->p_chunk->iovs[0].iov_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	stripe_req->p_chunk->iovcnt = 1;
+	stripe_req->p_chunk->md_buf = stripe_req->write.p_md_buf;
+
+	stripe_req->q_chunk->iovs[0].iov_base = stripe_req->write.q_buf;
+	stripe_req->q_chunk->iovs[0].iov_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	stripe_req->q_chunk->iovcnt = 1;
+	stripe_req->q_chunk->md_buf = stripe_req->write.q_md_buf;
+
+	return 0;
+}
+
+static void
+raid6_stripe_request_submit_chunks(struct stripe_request *stripe_req)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	uint8_t i = raid_io->base_bdev_io_submitted;
+	struct chunk *chunk;
+
+	if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+		for (; i < raid6_stripe_data_chunks_num(raid_io->raid_bdev); i++) {
+			if (spdk_unlikely(raid6_chunk_submit(stripe_req->reconstruct.sources[i]) != 0)) {
+				break;
+			}
+		}
+		return;
+	}
+
+	FOR_EACH_CHUNK_FROM(stripe_req, chunk, &stripe_req->chunks[i]) {
+		if (spdk_unlikely(raid6_chunk_submit(chunk) != 0)) {
+			break;
+		}
+	}
+}
+
+static inline void
+raid6_stripe_request_init(struct stripe_request *stripe_req, struct raid_bdev_io *raid_io,
+			  uint64_t stripe_index)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+
+	stripe_req->raid_io = raid_io;
+	stripe_req->stripe_index = stripe_index;
+	stripe_req->p_chunk = &stripe_req->chunks[raid6_stripe_p_chunk_index(raid_bdev, stripe_index)];
+	stripe_req->q_chunk = &stripe_req->chunks[raid6_stripe_q_chunk_index(raid_bdev, stripe_index)];
+}
+
+static int
+raid6_submit_write_request(struct raid_bdev_io *raid_io, uint64_t stripe_index)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6_io_channel *r6ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	struct stripe_request *stripe_req;
+	int ret;
+
+	stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.write);
+	if (!stripe_req) {
+		return -ENOMEM;
+	}
+
+	raid6_stripe_request_init(stripe_req, raid_io, stripe_index);
+
+	ret = raid6_stripe_request_map_iovecs(stripe_req);
+	if (spdk_unlikely(ret)) {
+		return ret;
+	}
+
+	TAILQ_REMOVE(&r6ch->free_stripe_requests.write, stripe_req, link);
+	TAILQ_INSERT_TAIL(&r6ch->active_stripe_requests, stripe_req, active_link);
+
+	raid_io->module_private = stripe_req;
+	raid_io->base_bdev_io_remaining = raid_bdev->num_base_bdevs;
+
+	if (raid_bdev_channel_get_base_channel(raid_io->raid_ch, stripe_req->p_chunk->index) != NULL ||
+	    raid_bdev_channel_get_base_channel(raid_io->raid_ch, stripe_req->q_chunk->index) != NULL) {
+		raid6_gen_pq(stripe_req);
+	}
+
+	raid6_stripe_request_submit_chunks(stripe_req);
+
+	return 0;
+}
+
+static void
+raid6_chunk_read_complete(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_io *raid_io = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_io_complete(raid_io, success ? SPDK_BDEV_IO_STATUS_SUCCESS :
+			      SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void raid6_submit_rw_request(struct raid_bdev_io *raid_io);
+
+static void
+_raid6_submit_rw_request(void *_raid_io)
+{
+	struct raid_bdev_io *raid_io = _raid_io;
+
+	raid6_submit_rw_request(raid_io);
+}
+
+static void
+raid6_stripe_wait(struct raid6_io_channel *r6ch, struct raid_bdev_io *raid_io)
+{
+	raid_io->waitq_entry.bdev = &raid_io->raid_bdev->bdev;
+	raid_io->waitq_entry.cb_fn = _raid6_submit_rw_request;
+	raid_io->waitq_entry.cb_arg = raid_io;
+	TAILQ_INSERT_TAIL(&r6ch->stripe_wait_queue, &raid_io->waitq_entry, link);
+}
+
+static void
+raid6_stripe_request_reconstruct_done(struct stripe_request *stripe_req, int status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+
+	raid6_stripe_request_release(stripe_req);
+
+	raid_bdev_io_complete(raid_io,
+			      status == 0 ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED);
+}
+
+static void
+raid6_reconstruct_reads_completed_cb(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+{
+	struct stripe_request *stripe_req = raid_io->module_private;
+	int ret;
+
+	raid_io->completion_cb = NULL;
+
+	if (status != SPDK_BDEV_IO_STATUS_SUCCESS) {
+		stripe_req->reconstruct.cb(stripe_req, -EIO);
+		return;
+	}
+
+	ret = raid6_reconstruct_chunk(stripe_req);
+	if (spdk_unlikely(ret != 0)) {
+		SPDK_ERRLOG("stripe reconstruction failed: %s\n", spdk_strerror(-ret));
+	}
+
+	stripe_req->reconstruct.cb(stripe_req, ret);
+}
+
+static int
+raid6_submit_reconstruct_read(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+			      uint8_t chunk_idx, uint64_t chunk_offset, stripe_req_gf_cb cb)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6_io_channel *r6ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+	uint8_t n_data = raid6_stripe_data_chunks_num(raid_bdev);
+	void *raid_io_md = raid_io->md_buf;
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+	uint8_t n_src = 0;
+	int i;
+	int ret;
+
+	assert(cb != NULL);
+
+	stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.reconstruct);
+	if (!stripe_req) {
+		return -ENOMEM;
+	}
+
+	raid6_stripe_request_init(stripe_req, raid_io, stripe_index);
+
+	stripe_req->reconstruct.chunk = &stripe_req->chunks[chunk_idx];
+	stripe_req->reconstruct.chunk_offset = chunk_offset;
+	stripe_req->reconstruct.cb = cb;
+
+	/* Any n_data of the remaining chunks are enough to reconstruct the missing one */
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		struct iovec *iov = &chunk->iovs[0];
+
+		if (chunk == stripe_req->reconstruct.chunk ||
+		    raid_bdev_channel_get_base_channel(raid_io->raid_ch, chunk->index) == NULL) {
+			continue;
+		}
+
+		iov->iov_base = stripe_req->reconstruct.chunk_buffers[n_src];
+		iov->iov_len = raid_io->num_blocks * raid_bdev->bdev.blocklen;
+		chunk->iovcnt = 1;
+
+		if (raid_io_md) {
+			chunk->md_buf = stripe_req->reconstruct.chunk_md_buffers[n_src];
+		}
+
+		stripe_req->reconstruct.sources[n_src++] = chunk;
+		if (n_src == n_data) {
+			break;
+		}
+	}
+
+	if (spdk_unlikely(n_src < n_data)) {
+		return -EIO;
+	}
+
+	chunk = stripe_req->reconstruct.chunk;
+	ret = raid6_chunk_set_iovcnt(chunk, raid_io->iovcnt);
+	if (ret) {
+		return ret;
+	}
+
+	for (i = 0; i < raid_io->iovcnt; i++) {
+		chunk->iovs[i] = raid_io->iovs[i];
+	}
+
+	chunk->md_buf = raid_io_md;
+
+	raid_io->module_private = stripe_req;
+	raid_io->base_bdev_io_remaining = n_data;
+	raid_io->completion_cb = raid6_reconstruct_reads_completed_cb;
+
+	TAILQ_REMOVE(&r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+	TAILQ_INSERT_TAIL(&r6ch->active_stripe_requests, stripe_req, active_link);
+
+	raid6_stripe_request_submit_chunks(stripe_req);
+
+	return 0;
+}
+
+static int
+raid6_submit_read_request(struct raid_bdev_io *raid_io, uint64_t stripe_index,
+			  uint64_t stripe_offset)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	uint8_t chunk_data_idx = stripe_offset >> raid_bdev->strip_size_shift;
+	uint8_t p_idx = raid6_stripe_p_chunk_index(raid_bdev, stripe_index);
+	uint8_t q_idx = raid6_stripe_q_chunk_index(raid_bdev, stripe_index);
+	uint8_t chunk_idx = chunk_data_idx;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_io_channel *base_ch;
+	uint64_t chunk_offset = stripe_offset - (chunk_data_idx << raid_bdev->strip_size_shift);
+	uint64_t base_offset_blocks = (stripe_index << raid_bdev->strip_size_shift) + chunk_offset;
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	/* Skip the parity chunks, in the index order */
+	if (chunk_idx >= spdk_min(p_idx, q_idx)) {
+		chunk_idx++;
+	}
+	if (chunk_idx >= spdk_max(p_idx, q_idx)) {
+		chunk_idx++;
+	}
+
+	base_info = &raid_bdev->base_bdev_info[chunk_idx];
+	base_ch = raid_bdev_channel_get_base_channel(raid_io->raid_ch, chunk_idx);
+
+	raid6_init_ext_io_opts(&io_opts, raid_io);
+	if (base_ch == NULL) {
+		struct raid6_io_channel *r6ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+
+		/* Reconstruction needs the parity to be consistent with the data */
+		if (spdk_unlikely(raid6_stripe_is_busy(r6ch, stripe_index, false))) {
+			raid6_stripe_wait(r6ch, raid_io);
+			return 0;
+		}
+
+		return raid6_submit_reconstruct_read(raid_io, stripe_index, chunk_idx, chunk_offset,
+						     raid6_stripe_request_reconstruct_done);
+	}
+
+	ret = raid_bdev_readv_blocks_ext(base_info, base_ch, raid_io->iovs, raid_io->iovcnt,
+					 base_offset_blocks, raid_io->num_blocks,
+					 raid6_chunk_read_complete, raid_io, &io_opts);
+	if (spdk_unlikely(ret == -ENOMEM)) {
+		raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(base_info->desc),
+					base_ch, _raid6_submit_rw_request);
+		return 0;
+	}
+
+	return ret;
+}
+
+static void
+raid6_submit_rw_request(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6_info *r6_info = raid_bdev->module_private;
+	uint64_t stripe_index = raid_io->offset_blocks / r6_info->stripe_blocks;
+	uint64_t stripe_offset = raid_io->offset_blocks % r6_info->stripe_blocks;
+	int ret;
+
+	switch (raid_io->type) {
+	case SPDK_BDEV_IO_TYPE_READ:
+		assert(raid_io->num_blocks <= raid_bdev->strip_size);
+		ret = raid6_submit_read_request(raid_io, stripe_index, stripe_offset);
+		break;
+	case SPDK_BDEV_IO_TYPE_WRITE: {
+		struct raid6_io_channel *r6ch = raid_bdev_channel_get_module_ctx(raid_io->raid_ch);
+
+		assert(stripe_offset == 0);
+		assert(raid_io->num_blocks == r6_info->stripe_blocks);
+
+		/* A write must not modify the stripe while it is being read for reconstruction */
+		if (spdk_unlikely(raid6_stripe_is_busy(r6ch, stripe_index, true))) {
+			raid6_stripe_wait(r6ch, raid_io);
+			return;
+		}
+
+		ret = raid6_submit_write_request(raid_io, stripe_index);
+		break;
+	}
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	if (spdk_unlikely(ret)) {
+		raid_bdev_io_complete(raid_io, ret == -ENOMEM ? SPDK_BDEV_IO_STATUS_NOMEM :
+				      SPDK_BDEV_IO_STATUS_FAILED);
+	}
+}
+
+static void
+raid6_stripe_request_free(struct stripe_request *stripe_req)
+{
+	struct chunk *chunk;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		free(chunk->iovs);
+	}
+
+	if (stripe_req->type == STRIPE_REQ_WRITE) {
+		spdk_dma_free(stripe_req->write.p_buf);
+		spdk_dma_free(stripe_req->write.q_buf);
+		spdk_dma_free(stripe_req->write.p_md_buf);
+		spdk_dma_free(stripe_req->write.q_md_buf);
+	} else if (stripe_req->type == STRIPE_REQ_RECONSTRUCT) {
+		struct raid6_info *r6_info = raid6_ch_to_r6_info(stripe_req->r6ch);
+		struct raid_bdev *raid_bdev = r6_info->raid_bdev;
+		uint8_t i;
+
+		if (stripe_req->reconstruct.chunk_buffers) {
+			for (i = 0; i < raid6_stripe_data_chunks_num(raid_bdev); i++) {
+				spdk_dma_free(stripe_req->reconstruct.chunk_buffers[i]);
+			}
+			free(stripe_req->reconstruct.chunk_buffers);
+		}
+
+		if (stripe_req->reconstruct.chunk_md_buffers) {
+			for (i = 0; i < raid6_stripe_data_chunks_num(raid_bdev); i++) {
+				spdk_dma_free(stripe_req->reconstruct.chunk_md_buffers[i]);
+			}
+			free(stripe_req->reconstruct.chunk_md_buffers);
+		}
+
+		free(stripe_req->reconstruct.sources);
+		free(stripe_req->reconstruct.gf_tables);
+	} else {
+		assert(false);
+	}
+
+	free(stripe_req->chunk_iov_iters);
+
+	free(stripe_req);
+}
+
+static struct stripe_request *
+raid6_stripe_request_alloc(struct raid6_io_channel *r6ch, enum stripe_request_type type)
+{
+	struct raid6_info *r6_info = raid6_ch_to_r6_info(r6ch);
+	struct raid_bdev *raid_bdev = r6_info->raid_bdev;
+	uint32_t raid_io_md_size = raid_bdev->bdev.md_interleave ? 0 : raid_bdev->bdev.md_len;
+	struct stripe_request *stripe_req;
+	struct chunk *chunk;
+	size_t chunk_len;
+
+	stripe_req = calloc(1, sizeof(*stripe_req) + sizeof(*chunk) * raid_bdev->num_base_bdevs);
+	if (!stripe_req) {
+		return NULL;
+	}
+
+	stripe_req->r6ch = r6ch;
+	stripe_req->type = type;
+
+	FOR_EACH_CHUNK(stripe_req, chunk) {
+		chunk->index = chunk - stripe_req->chunks;
+		chunk->iovcnt_max = 4;
+		chunk->iovs = calloc(chunk->iovcnt_max, sizeof(chunk->iovs[0]));
+		if (!chunk->iovs) {
+			goto err;
+		}
+	}
+
+	chunk_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+
+	if (type == STRIPE_REQ_WRITE) {
+		stripe_req->write.p_buf = spdk_dma_malloc(chunk_len, r6_info->buf_alignment, NULL);
+		stripe_req->write.q_buf = spdk_dma_malloc(chunk_len, r6_info->buf_alignment, NULL);
+		if (!stripe_req->write.p_buf || !stripe_req->write.q_buf) {
+			goto err;
+		}
+
+		if (raid_io_md_size != 0) {
+			stripe_req->write.p_md_buf = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size,
+						     r6_info->buf_alignment, NULL);
+			stripe_req->write.q_md_buf = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size,
+						     r6_info->buf_alignment, NULL);
+			if (!stripe_req->write.p_md_buf || !stripe_req->write.q_md_buf) {
+				goto err;
+			}
+		}
+	} else if (type == STRIPE_REQ_RECONSTRUCT) {
+		uint8_t n = raid6_stripe_data_chunks_num(raid_bdev);
+		void *buf;
+		uint8_t i;
+
+		stripe_req->reconstruct.chunk_buffers = calloc(n, sizeof(void *));
+		if (!stripe_req->reconstruct.chunk_buffers) {
+			goto err;
+		}
+
+		for (i = 0; i < n; i++) {
+			buf = spdk_dma_malloc(chunk_len, r6_info->buf_alignment, NULL);
+			if (!buf) {
+				goto err;
+			}
+			stripe_req->reconstruct.chunk_buffers[i] = buf;
+		}
+
+		if (raid_io_md_size != 0) {
+			stripe_req->reconstruct.chunk_md_buffers = calloc(n, sizeof(void *));
+			if (!stripe_req->reconstruct.chunk_md_buffers) {
+				goto err;
+			}
+
+			for (i = 0; i < n; i++) {
+				buf = spdk_dma_malloc(raid_bdev->strip_size * raid_io_md_size, r6_info->buf_alignment, NULL);
+				if (!buf) {
+					goto err;
+				}
+				stripe_req->reconstruct.chunk_md_buffers[i] = buf;
+			}
+		}
+
+		stripe_req->reconstruct.sources = calloc(n, sizeof(struct chunk *));
+		if (!stripe_req->reconstruct.sources) {
+			goto err;
+		}
+
+		stripe_req->reconstruct.gf_tables = calloc(n, RAID6_GF_TBL_SIZE);
+		if (!stripe_req->reconstruct.gf_tables) {
+			goto err;
+		}
+	} else {
+		assert(false);
+		return NULL;
+	}
+
+	stripe_req->chunk_iov_iters = malloc(SPDK_IOVITER_SIZE(raid_bdev->num_base_bdevs));
+	if (!stripe_req->chunk_iov_iters) {
+		goto err;
+	}
+
+	return stripe_req;
+err:
+	raid6_stripe_request_free(stripe_req);
+	return NULL;
+}
+
+static void
+raid6_ioch_destroy(void *io_device, void *ctx_buf)
+{
+	struct raid6_io_channel *r6ch = ctx_buf;
+	struct stripe_request *stripe_req;
+
+	assert(TAILQ_EMPTY(&r6ch->active_stripe_requests));
+	assert(TAILQ_EMPTY(&r6ch->stripe_wait_queue));
+
+	while ((stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.write))) {
+		TAILQ_REMOVE(&r6ch->free_stripe_requests.write, stripe_req, link);
+		raid6_stripe_request_free(stripe_req);
+	}
+
+	while ((stripe_req = TAILQ_FIRST(&r6ch->free_stripe_requests.reconstruct))) {
+		TAILQ_REMOVE(&r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+		raid6_stripe_request_free(stripe_req);
+	}
+
+	free(r6ch->chunk_gf_buffers);
+	free(r6ch->chunk_gf_iovs);
+	free(r6ch->chunk_gf_iovcnt);
+	free(r6ch->chunk_gf_md_buffers);
+	free(r6ch->gf_matrix);
+	free(r6ch->gf_matrix_inv);
+}
+
+static int
+raid6_ioch_create(void *io_device, void *ctx_buf)
+{
+	struct raid6_io_channel *r6ch = ctx_buf;
+	struct raid6_info *r6_info = io_device;
+	struct raid_bdev *raid_bdev = r6_info->raid_bdev;
+	uint8_t n_data = raid6_stripe_data_chunks_num(raid_bdev);
+	struct stripe_request *stripe_req;
+	int i;
+
+	TAILQ_INIT(&r6ch->free_stripe_requests.write);
+	TAILQ_INIT(&r6ch->free_stripe_requests.reconstruct);
+	TAILQ_INIT(&r6ch->active_stripe_requests);
+	TAILQ_INIT(&r6ch->stripe_wait_queue);
+
+	for (i = 0; i < RAID6_MAX_STRIPES; i++) {
+		stripe_req = raid6_stripe_request_alloc(r6ch, STRIPE_REQ_WRITE);
+		if (!stripe_req) {
+			goto err;
+		}
+
+		TAILQ_INSERT_HEAD(&r6ch->free_stripe_requests.write, stripe_req, link);
+	}
+
+	for (i = 0; i < RAID6_MAX_STRIPES; i++) {
+		stripe_req = raid6_stripe_request_alloc(r6ch, STRIPE_REQ_RECONSTRUCT);
+		if (!stripe_req) {
+			goto err;
+		}
+
+		TAILQ_INSERT_HEAD(&r6ch->free_stripe_requests.reconstruct, stripe_req, link);
+	}
+
+	r6ch->chunk_gf_buffers = calloc(raid_bdev->num_base_bdevs, sizeof(*r6ch->chunk_gf_buffers));
+	if (!r6ch->chunk_gf_buffers) {
+		goto err;
+	}
+
+	r6ch->chunk_gf_iovs = calloc(raid_bdev->num_base_bdevs, sizeof(*r6ch->chunk_gf_iovs));
+	if (!r6ch->chunk_gf_iovs) {
+		goto err;
+	}
+
+	r6ch->chunk_gf_iovcnt = calloc(raid_bdev->num_base_bdevs, sizeof(*r6ch->chunk_gf_iovcnt));
+	if (!r6ch->chunk_gf_iovcnt) {
+		goto err;
+	}
+
+	r6ch->chunk_gf_md_buffers = calloc(raid_bdev->num_base_bdevs,
+					   sizeof(*r6ch->chunk_gf_md_buffers));
+	if (!r6ch->chunk_gf_md_buffers) {
+		goto err;
+	}
+
+	r6ch->gf_matrix = calloc(n_data, n_data);
+	if (!r6ch->gf_matrix) {
+		goto err;
+	}
+
+	r6ch->gf_matrix_inv = calloc(n_data, n_data);
+	if (!r6ch->gf_matrix_inv) {
+		goto err;
+	}
+
+	return 0;
+err:
+	SPDK_ERRLOG("Failed to initialize io channel\n");
+	raid6_ioch_destroy(r6_info, r6ch);
+	return -ENOMEM;
+}
+
+static int
+raid6_init_gf_tables(struct raid6_info *r6_info)
+{
+	uint8_t n_data = raid6_stripe_data_chunks_num(r6_info->raid_bdev);
+	uint8_t *matrix;
+	uint8_t g = 1;
+	uint8_t i;
+
+	matrix = calloc(n_data + 2, n_data);
+	if (!matrix) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < n_data; i++) {
+		matrix[i * n_data + i] = 1;
+		matrix[n_data * n_data + i] = 1;
+		matrix[(n_data + 1) * n_data + i] = g;
+		g = raid6_gf_mul(g, 2);
+	}
+
+	r6_info->gf_encode_tables = calloc(n_data * 2, RAID6_GF_TBL_SIZE);
+	if (!r6_info->gf_encode_tables) {
+		free(matrix);
+		return -ENOMEM;
+	}
+
+	raid6_gf_init_tables(n_data, 2, &matrix[n_data * n_data], r6_info->gf_encode_tables);
+
+	r6_info->gf_matrix = matrix;
+
+	return 0;
+}
+
+static void
+raid6_info_free(struct raid6_info *r6_info)
+{
+	free(r6_info->gf_matrix);
+	free(r6_info->gf_encode_tables);
+	free(r6_info);
+}
+
+static int
+raid6_start(struct raid_bdev *raid_bdev)
+{
+	uint64_t min_blockcnt = UINT64_MAX;
+	uint64_t base_bdev_data_size;
+	struct raid_base_bdev_info *base_info;
+	struct spdk_bdev *base_bdev;
+	struct raid6_info *r6_info;
+	size_t alignment = 0;
+	int ret;
+
+	r6_info = calloc(1, sizeof(*r6_info));
+	if (!r6_info) {
+		SPDK_ERRLOG("Failed to allocate r6_info\n");
+		return -ENOMEM;
+	}
+	r6_info->raid_bdev = raid_bdev;
+
+	ret = raid6_init_gf_tables(r6_info);
+	if (ret) {
+		SPDK_ERRLOG("Failed to initialize GF tables\n");
+		free(r6_info);
+		return ret;
+	}
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		min_blockcnt = spdk_min(min_blockcnt, base_info->data_size);
+		if (base_info->desc) {
+			base_bdev = spdk_bdev_desc_get_bdev(base_info->desc);
+			alignment = spdk_max(alignment, spdk_bdev_get_buf_align(base_bdev));
+		}
+	}
+
+	base_bdev_data_size = (min_blockcnt / raid_bdev->strip_size) * raid_bdev->strip_size;
+
+	RAID_FOR_EACH_BASE_BDEV(raid_bdev, base_info) {
+		base_info->data_size = base_bdev_data_size;
+	}
+
+	r6_info->total_stripes = min_blockcnt / raid_bdev->strip_size;
+	r6_info->stripe_blocks = raid_bdev->strip_size * raid6_stripe_data_chunks_num(raid_bdev);
+	r6_info->buf_alignment = alignment;
+	if (!raid_bdev->bdev.md_interleave) {
+		r6_info->blocklen_shift = spdk_u32log2(raid_bdev->bdev.blocklen);
+	}
+
+	raid_bdev->bdev.blockcnt = r6_info->stripe_blocks * r6_info->total_stripes;
+	raid_bdev->bdev.optimal_io_boundary = raid_bdev->strip_size;
+	raid_bdev->bdev.split_on_optimal_io_boundary = true;
+	raid_bdev->bdev.write_unit_size = r6_info->stripe_blocks;
+	raid_bdev->bdev.split_on_write_unit = true;
+
+	raid_bdev->module_private = r6_info;
+
+	spdk_io_device_register(r6_info, raid6_ioch_create, raid6_ioch_destroy,
+				sizeof(struct raid6_io_channel), NULL);
+
+	return 0;
+}
+
+static void
+raid6_io_device_unregister_done(void *io_device)
+{
+	struct raid6_info *r6_info = io_device;
+
+	raid_bdev_module_stop_done(r6_info->raid_bdev);
+
+	raid6_info_free(r6_info);
+}
+
+static bool
+raid6_stop(struct raid_bdev *raid_bdev)
+{
+	struct raid6_info *r6_info = raid_bdev->module_private;
+
+	spdk_io_device_unregister(r6_info, raid6_io_device_unregister_done);
+
+	return false;
+}
+
+static struct spdk_io_channel *
+raid6_get_io_channel(struct raid_bdev *raid_bdev)
+{
+	struct raid6_info *r6_info = raid_bdev->module_private;
+
+	return spdk_get_io_channel(r6_info);
+}
+
+static void
+raid6_process_write_completed(struct spdk_bdev_io *bdev_io, bool success, void *cb_arg)
+{
+	struct raid_bdev_process_request *process_req = cb_arg;
+
+	spdk_bdev_free_io(bdev_io);
+
+	raid_bdev_process_request_complete(process_req, success ? 0 : -EIO);
+}
+
+static void raid6_process_submit_write(struct raid_bdev_process_request *process_req);
+
+static void
+_raid6_process_submit_write(void *ctx)
+{
+	struct raid_bdev_process_request *process_req = ctx;
+
+	raid6_process_submit_write(process_req);
+}
+
+static void
+raid6_process_submit_write(struct raid_bdev_process_request *process_req)
+{
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+	struct raid6_info *r6_info = raid_bdev->module_private;
+	uint64_t stripe_index = process_req->offset_blocks / r6_info->stripe_blocks;
+	struct spdk_bdev_ext_io_opts io_opts;
+	int ret;
+
+	raid6_init_ext_io_opts(&io_opts, raid_io);
+	ret = raid_bdev_writev_blocks_ext(process_req->target, process_req->target_ch,
+					  raid_io->iovs, raid_io->iovcnt,
+					  stripe_index << raid_bdev->strip_size_shift, raid_bdev->strip_size,
+					  raid6_process_write_completed, process_req, &io_opts);
+	if (spdk_unlikely(ret != 0)) {
+		if (ret == -ENOMEM) {
+			raid_bdev_queue_io_wait(raid_io, spdk_bdev_desc_get_bdev(process_req->target->desc),
+						process_req->target_ch, _raid6_process_submit_write);
+		} else {
+			raid_bdev_process_request_complete(process_req, ret);
+		}
+	}
+}
+
+static void
+raid6_process_stripe_request_reconstruct_done(struct stripe_request *stripe_req, int status)
+{
+	struct raid_bdev_io *raid_io = stripe_req->raid_io;
+	struct raid_bdev_process_request *process_req = SPDK_CONTAINEROF(raid_io,
+			struct raid_bdev_process_request, raid_io);
+
+	raid6_stripe_request_release(stripe_req);
+
+	if (status != 0) {
+		raid_bdev_process_request_complete(process_req, status);
+		return;
+	}
+
+	raid6_process_submit_write(process_req);
+}
+
+static int
+raid6_submit_process_request(struct raid_bdev_process_request *process_req,
+			     struct raid_bdev_io_channel *raid_ch)
+{
+	struct spdk_io_channel *ch = spdk_io_channel_from_ctx(raid_ch);
+	struct raid_bdev *raid_bdev = spdk_io_channel_get_io_device(ch);
+	struct raid6_info *r6_info = raid_bdev->module_private;
+	struct raid_bdev_io *raid_io = &process_req->raid_io;
+	uint8_t chunk_idx = raid_bdev_base_bdev_slot(process_req->target);
+	uint64_t stripe_index = process_req->offset_blocks / r6_info->stripe_blocks;
+	int ret;
+
+	assert((process_req->offset_blocks % r6_info->stripe_blocks) == 0);
+
+	if (process_req->num_blocks < r6_info->stripe_blocks) {
+		return 0;
+	}
+
+	raid_bdev_io_init(raid_io, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			  process_req->offset_blocks, raid_bdev->strip_size,
+			  &process_req->iov, 1, process_req->md_buf, NULL, NULL);
+
+	ret = raid6_submit_reconstruct_read(raid_io, stripe_index, chunk_idx, 0,
+					    raid6_process_stripe_request_reconstruct_done);
+	if (spdk_likely(ret == 0)) {
+		return r6_info->stripe_blocks;
+	} else if (ret < 0) {
+		return ret;
+	} else {
+		return -EINVAL;
+	}
+}
+
+static struct raid_bdev_module g_raid6_module = {
+	.level = RAID6,
+	.base_bdevs_min = 4,
+	.base_bdevs_constraint = {CONSTRAINT_MAX_BASE_BDEVS_REMOVED, 2},
+	.start = raid6_start,
+	.stop = raid6_stop,
+	.submit_rw_request = raid6_submit_rw_request,
+	.get_io_channel = raid6_get_io_channel,
+	.submit_process_request = raid6_submit_process_request,
+};
+RAID_MODULE_REGISTER(&g_raid6_module)
+
+SPDK_LOG_REGISTER_COMPONENT(bdev_raid6)
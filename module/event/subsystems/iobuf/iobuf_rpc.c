@@ -14,6 +14,7 @@ static const struct spdk_json_object_decoder rpc_iobuf_set_options_decoders[] =
 	{"large_pool_count", offsetof(struct spdk_iobuf_opts, large_pool_count), spdk_json_decode_uint64, true},
 	{"small_bufsize", offsetof(struct spdk_iobuf_opts, small_bufsize), spdk_json_decode_uint32, true},
 	{"large_bufsize", offsetof(struct spdk_iobuf_opts, large_bufsize), spdk_json_decode_uint32, true},
+	{"enable_numa", offsetof(struct spdk_iobuf_opts, enable_numa), spdk_json_decode_bool, true},
 };
 
 static void
@@ -41,6 +42,18 @@ rpc_iobuf_set_options(struct spdk_jsonrpc_request *request, const struct spdk_js
 }
 SPDK_RPC_REGISTER("iobuf_set_options", rpc_iobuf_set_options, SPDK_RPC_STARTUP)
 
+static void
+rpc_iobuf_write_pool_stats(struct spdk_json_write_ctx *w, const char *name,
+			   const struct spdk_iobuf_pool_stats *stats)
+{
+	spdk_json_write_named_object_begin(w, name);
+	spdk_json_write_named_uint64(w, "cache", stats->cache);
+	spdk_json_write_named_uint64(w, "main", stats->main);
+	spdk_json_write_named_uint64(w, "retry", stats->retry);
+	spdk_json_write_named_uint64(w, "remote", stats->remote);
+	spdk_json_write_object_end(w);
+}
+
 static void
 rpc_iobuf_get_stats_done(struct spdk_iobuf_module_stats *modules, uint32_t num_modules,
 			 void *cb_arg)
@@ -48,7 +61,7 @@ rpc_iobuf_get_stats_done(struct spdk_iobuf_module_stats *modules, uint32_t num_m
 	struct spdk_jsonrpc_request *request = cb_arg;
 	struct spdk_json_write_ctx *w;
 	struct spdk_iobuf_module_stats *it;
-	uint32_t i;
+	uint32_t i, j;
 
 	w = spdk_jsonrpc_begin_result(request);
 	spdk_json_write_array_begin(w);
@@ -59,17 +72,20 @@ rpc_iobuf_get_stats_done(struct spdk_iobuf_module_stats *modules, uint32_t num_m
 		spdk_json_write_object_begin(w);
 		spdk_json_write_named_string(w, "module", it->module);
 
-		spdk_json_write_named_object_begin(w, "small_pool");
-		spdk_json_write_named_uint64(w, "cache", it->small_pool.cache);
-		spdk_json_write_named_uint64(w, "main", it->small_pool.main);
-		spdk_json_write_named_uint64(w, "retry", it->small_pool.retry);
-		spdk_json_write_object_end(w);
-
-		spdk_json_write_named_object_begin(w, "large_pool");
-		spdk_json_write_named_uint64(w, "cache", it->large_pool.cache);
-		spdk_json_write_named_uint64(w, "main", it->large_pool.main);
-		spdk_json_write_named_uint64(w, "retry", it->large_pool.retry);
-		spdk_json_write_object_end(w);
+		rpc_iobuf_write_pool_stats(w, "small_pool", &it->small_pool);
+		rpc_iobuf_write_pool_stats(w, "large_pool", &it->large_pool);
+
+		if (it->num_nodes > 0) {
+			spdk_json_write_named_array_begin(w, "numa_nodes");
+			for (j = 0; j < it->num_nodes; j++) {
+				spdk_json_write_object_begin(w);
+				spdk_json_write_named_uint32(w, "numa_id", it->nodes[j].numa_id);
+				rpc_iobuf_write_pool_stats(w, "small_pool", &it->nodes[j].small_pool);
+				rpc_iobuf_write_pool_stats(w, "large_pool", &it->nodes[j].large_pool);
+				spdk_json_write_object_end(w);
+			}
+			spdk_json_write_array_end(w);
+		}
 
 		spdk_json_write_object_end(w);
 	}
@@ -36,13 +36,14 @@ struct nvmf_tgt_poll_group {
 
 struct spdk_nvmf_tgt_conf g_spdk_nvmf_tgt_conf = {
 	.opts = {
-		.size = SPDK_SIZEOF(&g_spdk_nvmf_tgt_conf.opts, dhchap_dhgroups),
+		.size = SPDK_SIZEOF(&g_spdk_nvmf_tgt_conf.opts, io_sched_depth),
 		.name = "nvmf_tgt",
 		.max_subsystems = 0,
 		.crdt = { 0, 0, 0 },
 		.discovery_filter = SPDK_NVMF_TGT_DISCOVERY_MATCH_ANY,
 		.dhchap_digests = UINT32_MAX,
 		.dhchap_dhgroups = UINT32_MAX,
+		.io_sched_depth = 0,
 	},
 	.admin_passthru.identify_ctrlr = false
 };
@@ -566,6 +567,9 @@ nvmf_subsystem_write_config_json(struct spdk_json_write_ctx *w)
 	if (g_poll_groups_mask) {
 		spdk_json_write_named_string(w, "poll_groups_mask", spdk_cpuset_fmt(g_poll_groups_mask));
 	}
+	if (g_spdk_nvmf_tgt_conf.opts.io_sched_depth > 0) {
+		spdk_json_write_named_uint32(w, "io_sched_depth", g_spdk_nvmf_tgt_conf.opts.io_sched_depth);
+	}
 	spdk_json_write_object_end(w);
 	spdk_json_write_object_end(w);
 
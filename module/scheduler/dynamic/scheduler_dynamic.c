@@ -21,6 +21,13 @@ struct core_stats {
 	uint64_t idle;
 	uint32_t thread_count;
 	bool isolated;
+
+	/* Reactive mode: reactor's busy/idle tsc at the start of the current window */
+	uint64_t window_busy;
+	uint64_t window_idle;
+	/* Number of consecutive windows the core was overloaded in */
+	uint32_t overloaded_windows;
+	bool overloaded;
 };
 
 static struct core_stats *g_cores;
@@ -29,6 +36,22 @@ uint8_t g_scheduler_load_limit = 20;
 uint8_t g_scheduler_core_limit = 80;
 uint8_t g_scheduler_core_busy = 95;
 
+/* Reactive mode, disabled if the period is 0 */
+uint32_t g_scheduler_reactive_period = 0;
+uint8_t g_scheduler_reactive_count = 3;
+
+static struct {
+	uint64_t period_tsc;
+	uint64_t window_start;
+	/* Set when the current scheduling round was started by check_balance() */
+	bool balance_pending;
+	uint64_t balances;
+	uint64_t moves;
+	uint64_t last_thread_id;
+	uint32_t last_src_core;
+	uint32_t last_dst_core;
+} g_reactive;
+
 static uint8_t
 _busy_pct(uint64_t busy, uint64_t idle)
 {
@@ -271,6 +294,134 @@ _find_optimal_core(struct spdk_scheduler_thread_info *thread_info)
 	return current_lcore;
 }
 
+/* Least busy core other than its current one that can fit the thread, or the current one. */
+static uint32_t
+_find_least_busy_core(struct spdk_scheduler_thread_info *thread_info)
+{
+	struct spdk_thread *thread;
+	struct spdk_cpuset *cpumask;
+	uint32_t i, dst_core = thread_info->lcore;
+
+	thread = spdk_thread_get_by_id(thread_info->thread_id);
+	if (thread == NULL) {
+		return dst_core;
+	}
+	cpumask = spdk_thread_get_cpumask(thread);
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		if (i == thread_info->lcore || g_cores[i].isolated || !spdk_cpuset_get_cpu(cpumask, i) ||
+		    !_can_core_fit_thread(thread_info, i)) {
+			continue;
+		}
+		if (dst_core == thread_info->lcore || g_cores[i].busy < g_cores[dst_core].busy) {
+			dst_core = i;
+		}
+	}
+
+	return dst_core;
+}
+
+/* Move the heaviest thread that can run elsewhere off each core found overloaded by
+ * check_balance(). */
+static void
+_balance_overloaded(struct spdk_scheduler_core_info *cores_info)
+{
+	struct spdk_scheduler_core_info *core;
+	struct spdk_scheduler_thread_info *thread_info, *heaviest;
+	uint32_t i, j, core_id, dst_core;
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		core = &cores_info[i];
+		if (!g_cores[i].overloaded || core->isolated) {
+			continue;
+		}
+		g_cores[i].overloaded = false;
+
+		heaviest = NULL;
+		dst_core = i;
+		for (j = 0; j < core->threads_count; j++) {
+			thread_info = &core->thread_infos[j];
+			if (heaviest != NULL &&
+			    thread_info->current_stats.busy_tsc <= heaviest->current_stats.busy_tsc) {
+				continue;
+			}
+
+			core_id = _find_least_busy_core(thread_info);
+			if (core_id != i) {
+				heaviest = thread_info;
+				dst_core = core_id;
+			}
+		}
+
+		if (heaviest == NULL) {
+			continue;
+		}
+
+		_move_thread(heaviest, dst_core);
+		g_reactive.moves++;
+		g_reactive.last_thread_id = heaviest->thread_id;
+		g_reactive.last_src_core = i;
+		g_reactive.last_dst_core = dst_core;
+	}
+}
+
+static bool
+check_balance(uint64_t now)
+{
+	struct spdk_reactor *reactor;
+	struct core_stats *core;
+	uint64_t busy, idle;
+	uint32_t i;
+	uint8_t busy_pct;
+	bool overloaded = false, spare = false;
+
+	if (g_reactive.period_tsc == 0 || now - g_reactive.window_start < g_reactive.period_tsc) {
+		return false;
+	}
+	g_reactive.window_start = now;
+
+	SPDK_ENV_FOREACH_CORE(i) {
+		reactor = spdk_reactor_get(i);
+		core = &g_cores[i];
+
+		/* The counters are only updated by their own reactor, so they may be slightly stale */
+		busy = __atomic_load_n(&reactor->busy_tsc, __ATOMIC_RELAXED);
+		idle = __atomic_load_n(&reactor->idle_tsc, __ATOMIC_RELAXED);
+
+		busy_pct = _busy_pct(busy - core->window_busy, idle - core->window_idle);
+		core->window_busy = busy;
+		core->window_idle = idle;
+
+		if (core->isolated) {
+			core->overloaded_windows = 0;
+		} else if (busy_pct >= g_scheduler_core_busy &&
+			   __atomic_load_n(&reactor->thread_count, __ATOMIC_RELAXED) > 1) {
+			/* A core with a single thread can't be relieved by moving it */
+			core->overloaded_windows++;
+		} else {
+			core->overloaded_windows = 0;
+			spare |= busy_pct < g_scheduler_core_limit;
+		}
+		core->overloaded = core->overloaded_windows >= g_scheduler_reactive_count;
+		overloaded |= core->overloaded;
+	}
+
+	if (!overloaded || !spare) {
+		return false;
+	}
+
+	/* Start over counting the windows after rebalancing, so that a core has to stay
+	 * overloaded for another g_scheduler_reactive_count windows to trigger it again. */
+	SPDK_ENV_FOREACH_CORE(i) {
+		g_cores[i].overloaded_windows = 0;
+	}
+
+	g_reactive.balance_pending = true;
+	g_reactive.balances++;
+
+	return true;
+}
+
 static int
 init(void)
 {
@@ -286,6 +437,9 @@ init(void)
 		return -ENOMEM;
 	}
 
+	memset(&g_reactive, 0, sizeof(g_reactive));
+	g_reactive.period_tsc = g_scheduler_reactive_period * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+
 	return 0;
 }
 
@@ -343,11 +497,17 @@ balance(struct spdk_scheduler_core_info *cores_info, uint32_t cores_count)
 	}
 	main_core = &g_cores[g_main_lcore];
 
-	/* Distribute threads in two passes, to make sure updated core stats are considered on each pass.
-	 * 1) Move all idle threads to main core. */
-	_foreach_thread(cores_info, _balance_idle);
-	/* 2) Distribute active threads across all cores. */
-	_foreach_thread(cores_info, _balance_active);
+	if (g_reactive.balance_pending) {
+		/* Started early because of an overloaded core, only relieve that one. */
+		g_reactive.balance_pending = false;
+		_balance_overloaded(cores_info);
+	} else {
+		/* Distribute threads in two passes, to make sure updated core stats are considered on each pass.
+		 * 1) Move all idle threads to main core. */
+		_foreach_thread(cores_info, _balance_idle);
+		/* 2) Distribute active threads across all cores. */
+		_foreach_thread(cores_info, _balance_active);
+	}
 
 	/* Switch unused cores to interrupt mode and switch cores to polled mode
 	 * if they will be used after rebalancing */
@@ -399,12 +559,16 @@ struct json_scheduler_opts {
 	uint8_t load_limit;
 	uint8_t core_limit;
 	uint8_t core_busy;
+	uint32_t reactive_period;
+	uint8_t reactive_count;
 };
 
 static const struct spdk_json_object_decoder sched_decoders[] = {
 	{"load_limit", offsetof(struct json_scheduler_opts, load_limit), spdk_json_decode_uint8, true},
 	{"core_limit", offsetof(struct json_scheduler_opts, core_limit), spdk_json_decode_uint8, true},
 	{"core_busy", offsetof(struct json_scheduler_opts, core_busy), spdk_json_decode_uint8, true},
+	{"reactive_period", offsetof(struct json_scheduler_opts, reactive_period), spdk_json_decode_uint32, true},
+	{"reactive_count", offsetof(struct json_scheduler_opts, reactive_count), spdk_json_decode_uint8, true},
 };
 
 static int
@@ -415,6 +579,8 @@ set_opts(const struct spdk_json_val *opts)
 	scheduler_opts.load_limit = g_scheduler_load_limit;
 	scheduler_opts.core_limit = g_scheduler_core_limit;
 	scheduler_opts.core_busy = g_scheduler_core_busy;
+	scheduler_opts.reactive_period = g_scheduler_reactive_period;
+	scheduler_opts.reactive_count = g_scheduler_reactive_count;
 
 	if (opts != NULL) {
 		if (spdk_json_decode_object_relaxed(opts, sched_decoders,
@@ -424,12 +590,23 @@ set_opts(const struct spdk_json_val *opts)
 		}
 	}
 
+	if (scheduler_opts.reactive_count == 0) {
+		SPDK_ERRLOG("Scheduler reactive count must be positive\n");
+		return -EINVAL;
+	}
+
 	SPDK_NOTICELOG("Setting scheduler load limit to %d\n", scheduler_opts.load_limit);
 	g_scheduler_load_limit = scheduler_opts.load_limit;
 	SPDK_NOTICELOG("Setting scheduler core limit to %d\n", scheduler_opts.core_limit);
 	g_scheduler_core_limit = scheduler_opts.core_limit;
 	SPDK_NOTICELOG("Setting scheduler core busy to %d\n", scheduler_opts.core_busy);
 	g_scheduler_core_busy = scheduler_opts.core_busy;
+	SPDK_NOTICELOG("Setting scheduler reactive period to %" PRIu32 "\n",
+		       scheduler_opts.reactive_period);
+	g_scheduler_reactive_period = scheduler_opts.reactive_period;
+	g_reactive.period_tsc = g_scheduler_reactive_period * spdk_get_ticks_hz() / SPDK_SEC_TO_USEC;
+	SPDK_NOTICELOG("Setting scheduler reactive count to %d\n", scheduler_opts.reactive_count);
+	g_scheduler_reactive_count = scheduler_opts.reactive_count;
 
 	return 0;
 }
@@ -440,6 +617,20 @@ get_opts(struct spdk_json_write_ctx *ctx)
 	spdk_json_write_named_uint8(ctx, "load_limit", g_scheduler_load_limit);
 	spdk_json_write_named_uint8(ctx, "core_limit", g_scheduler_core_limit);
 	spdk_json_write_named_uint8(ctx, "core_busy", g_scheduler_core_busy);
+	spdk_json_write_named_uint32(ctx, "reactive_period", g_scheduler_reactive_period);
+	spdk_json_write_named_uint8(ctx, "reactive_count", g_scheduler_reactive_count);
+
+	spdk_json_write_named_object_begin(ctx, "reactive_stats");
+	spdk_json_write_named_uint64(ctx, "balances", g_reactive.balances);
+	spdk_json_write_named_uint64(ctx, "moves", g_reactive.moves);
+	if (g_reactive.moves > 0) {
+		spdk_json_write_named_object_begin(ctx, "last_move");
+		spdk_json_write_named_uint64(ctx, "thread_id", g_reactive.last_thread_id);
+		spdk_json_write_named_uint32(ctx, "src_core", g_reactive.last_src_core);
+		spdk_json_write_named_uint32(ctx, "dst_core", g_reactive.last_dst_core);
+		spdk_json_write_object_end(ctx);
+	}
+	spdk_json_write_object_end(ctx);
 }
 
 static struct spdk_scheduler scheduler_dynamic = {
@@ -449,6 +640,7 @@ static struct spdk_scheduler scheduler_dynamic = {
 	.balance = balance,
 	.set_opts = set_opts,
 	.get_opts = get_opts,
+	.check_balance = check_balance,
 };
 
 SPDK_SCHEDULER_REGISTER(scheduler_dynamic);
@@ -1392,6 +1392,7 @@ _sock_flush(struct spdk_sock *sock)
 	} else {
 		rc = sendmsg(psock->fd, &msg, flags);
 	}
+	spdk_sock_group_impl_stat_sendmsg(sock);
 	if (rc <= 0) {
 		if (rc == 0 || errno == EAGAIN || errno == EWOULDBLOCK || (errno == ENOBUFS && psock->zcopy)) {
 			errno = EAGAIN;
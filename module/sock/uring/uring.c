@@ -1271,6 +1271,7 @@ _sock_flush(struct spdk_sock *_sock)
 	io_uring_prep_sendmsg(sqe, sock->fd, &sock->write_task.msg, flags);
 	io_uring_sqe_set_data(sqe, task);
 	task->status = SPDK_URING_SOCK_TASK_IN_PROCESS;
+	spdk_sock_group_impl_stat_sendmsg(_sock);
 }
 
 static void
@@ -2003,6 +2004,7 @@ uring_sock_flush(struct spdk_sock *_sock)
 	msg.msg_iov = iovs;
 	msg.msg_iovlen = iovcnt;
 	rc = sendmsg(sock->fd, &msg, flags | MSG_DONTWAIT);
+	spdk_sock_group_impl_stat_sendmsg(_sock);
 	if (rc <= 0) {
 		if (rc == 0 || errno == EAGAIN || errno == EWOULDBLOCK || (errno == ENOBUFS && sock->zcopy)) {
 			errno = EAGAIN;
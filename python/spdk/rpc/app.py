@@ -38,7 +38,7 @@ def framework_get_reactors(client):
 
 
 def framework_set_scheduler(client, name, period=None, load_limit=None, core_limit=None,
-                            core_busy=None):
+                            core_busy=None, reactive_period=None, reactive_count=None):
     """Select threads scheduler that will be activated and its period.
 
     Args:
@@ -56,6 +56,10 @@ def framework_set_scheduler(client, name, period=None, load_limit=None, core_lim
         params['core_limit'] = core_limit
     if core_busy is not None:
         params['core_busy'] = core_busy
+    if reactive_period is not None:
+        params['reactive_period'] = reactive_period
+    if reactive_count is not None:
+        params['reactive_count'] = reactive_count
     return client.call('framework_set_scheduler', params)
 
 
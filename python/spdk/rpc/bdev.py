@@ -7,7 +7,7 @@
 
 def bdev_set_options(client, bdev_io_pool_size=None, bdev_io_cache_size=None,
                      bdev_auto_examine=None, iobuf_small_cache_size=None,
-                     iobuf_large_cache_size=None):
+                     iobuf_large_cache_size=None, qos_distributed=None):
     """Set parameters for the bdev subsystem.
     Args:
         bdev_io_pool_size: number of bdev_io structures in shared buffer pool (optional)
@@ -15,6 +15,7 @@ def bdev_set_options(client, bdev_io_pool_size=None, bdev_io_cache_size=None,
         bdev_auto_examine: if set to false, the bdev layer will not examine every disks automatically (optional)
         iobuf_small_cache_size: size of the small iobuf per thread cache
         iobuf_large_cache_size: size of the large iobuf per thread cache
+        qos_distributed: meter QoS rate limits with quota drawn in batches by each channel (optional)
     """
     params = dict()
     if bdev_io_pool_size is not None:
@@ -27,6 +28,8 @@ def bdev_set_options(client, bdev_io_pool_size=None, bdev_io_cache_size=None,
         params['iobuf_small_cache_size'] = iobuf_small_cache_size
     if iobuf_large_cache_size is not None:
         params['iobuf_large_cache_size'] = iobuf_large_cache_size
+    if qos_distributed is not None:
+        params['qos_distributed'] = qos_distributed
     return client.call('bdev_set_options', params)
 
 
@@ -385,7 +388,8 @@ def bdev_raid_get_bdevs(client, category):
     return client.call('bdev_raid_get_bdevs', params)
 
 
-def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size_kb=None, uuid=None, superblock=None):
+def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size_kb=None, uuid=None, superblock=None,
+                     read_policy=None):
     """Create raid bdev. Either strip size arg will work but one is required.
     Args:
         name: user defined raid bdev name
@@ -395,6 +399,7 @@ def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size_kb=None, u
         uuid: UUID for this raid bdev (optional)
         superblock: information about raid bdev will be stored in superblock on each base bdev,
                     disabled by default due to backward compatibility
+        read_policy: read policy of raid1: least_outstanding (default), latency or sequential (optional)
     Returns:
         None
     """
@@ -408,9 +413,23 @@ def bdev_raid_create(client, name, raid_level, base_bdevs, strip_size_kb=None, u
         params['uuid'] = uuid
     if superblock is not None:
         params['superblock'] = superblock
+    if read_policy is not None:
+        params['read_policy'] = read_policy
     return client.call('bdev_raid_create', params)
 
 
+def bdev_raid_get_read_stats(client, name):
+    """Get per base bdev read statistics of a raid bdev
+    Args:
+        name: raid bdev name
+    Returns:
+        Read statistics of the raid bdev's base bdevs
+    """
+    params = dict()
+    params['name'] = name
+    return client.call('bdev_raid_get_read_stats', params)
+
+
 def bdev_raid_delete(client, name):
     """Delete raid bdev
     Args:
@@ -437,6 +456,20 @@ def bdev_raid_add_base_bdev(client, base_bdev, raid_bdev):
     return client.call('bdev_raid_add_base_bdev', params)
 
 
+def bdev_raid_grow_base_bdev(client, base_bdev, raid_bdev):
+    """Add a new base bdev to an online raid bdev to increase its capacity
+    Args:
+        base_bdev: base bdev name
+        raid_bdev: raid bdev name
+    Returns:
+        None
+    """
+    params = dict()
+    params['base_bdev'] = base_bdev
+    params['raid_bdev'] = raid_bdev
+    return client.call('bdev_raid_grow_base_bdev', params)
+
+
 def bdev_raid_remove_base_bdev(client, name):
     """Remove base bdev from existing raid bdev
     Args:
@@ -1287,6 +1320,55 @@ def bdev_passthru_delete(client, name):
     return client.call('bdev_passthru_delete', params)
 
 
+def bdev_coalesce_create(client, base_bdev_name, name, uuid=None, max_delay_us=None, max_ios=None,
+                         max_io_size_kib=None):
+    """Construct a coalesce block device that merges adjacent reads and writes.
+    Args:
+        base_bdev_name: name of the existing bdev
+        name: name of block device
+        uuid: UUID of block device (optional)
+        max_delay_us: longest time an I/O is held back, in microseconds (optional)
+        max_ios: number of I/O after which a merged request is submitted (optional)
+        max_io_size_kib: largest merged request, in KiB (optional)
+    Returns:
+        Name of created block device.
+    """
+    params = dict()
+    params['base_bdev_name'] = base_bdev_name
+    params['name'] = name
+    if uuid is not None:
+        params['uuid'] = uuid
+    if max_delay_us is not None:
+        params['max_delay_us'] = max_delay_us
+    if max_ios is not None:
+        params['max_ios'] = max_ios
+    if max_io_size_kib is not None:
+        params['max_io_size_kib'] = max_io_size_kib
+    return client.call('bdev_coalesce_create', params)
+
+
+def bdev_coalesce_delete(client, name):
+    """Remove coalesce bdev from the system.
+    Args:
+        name: name of coalesce bdev to delete
+    """
+    params = dict()
+    params['name'] = name
+    return client.call('bdev_coalesce_delete', params)
+
+
+def bdev_coalesce_get_stats(client, name):
+    """Get the coalescing statistics of a coalesce bdev.
+    Args:
+        name: name of coalesce bdev
+    Returns:
+        Merge ratio and added latency of the coalesce bdev.
+    """
+    params = dict()
+    params['name'] = name
+    return client.call('bdev_coalesce_get_stats', params)
+
+
 def bdev_opal_create(client, nvme_ctrlr_name, nsid, locking_range_id, range_start, range_length, password):
     """Create opal virtual block devices from a base nvme bdev.
     Args:
@@ -106,6 +106,21 @@ def bdev_lvol_snapshot(client, lvol_name, snapshot_name):
     return client.call('bdev_lvol_snapshot', params)
 
 
+def bdev_lvol_snapshot_group(client, snapshots):
+    """Capture a snapshot of a group of logical volumes with a single freeze of their I/O.
+
+    Args:
+        snapshots: list of dicts with 'lvol_name' and 'snapshot_name'
+
+    Returns:
+        List of UUIDs of the created logical volume snapshots.
+    """
+    params = {
+        'snapshots': snapshots
+    }
+    return client.call('bdev_lvol_snapshot_group', params)
+
+
 def bdev_lvol_clone(client, snapshot_name, clone_name):
     """Create a logical volume based on a snapshot.
 
@@ -223,18 +238,22 @@ def bdev_lvol_decouple_parent(client, name):
     return client.call('bdev_lvol_decouple_parent', params)
 
 
-def bdev_lvol_start_shallow_copy(client, src_lvol_name, dst_bdev_name):
+def bdev_lvol_start_shallow_copy(client, src_lvol_name, dst_bdev_name, ancestor_lvol_name=None):
     """Start a shallow copy of an lvol over a given bdev. The status of the operation
     can be obtained with bdev_lvol_check_shallow_copy
 
     Args:
         src_lvol_name: name of lvol to create a copy from
         bdev_name: name of the bdev that acts as destination for the copy
+        ancestor_lvol_name: name of a snapshot in the chain of the lvol; only the clusters
+        changed since it are copied (optional)
     """
     params = {
         'src_lvol_name': src_lvol_name,
         'dst_bdev_name': dst_bdev_name
     }
+    if ancestor_lvol_name:
+        params['ancestor_lvol_name'] = ancestor_lvol_name
     return client.call('bdev_lvol_start_shallow_copy', params)
 
 
@@ -250,6 +269,22 @@ def bdev_lvol_check_shallow_copy(client, operation_id):
     return client.call('bdev_lvol_check_shallow_copy', params)
 
 
+def bdev_lvol_get_changed_clusters(client, lvol_name, ancestor_name=None):
+    """Get the clusters that changed between an lvol and one of its ancestor snapshots
+
+    Args:
+        lvol_name: name of the lvol
+        ancestor_name: name of a snapshot in the chain of the lvol; if not given, the clusters
+        allocated anywhere in the chain are reported (optional)
+    """
+    params = {
+        'lvol_name': lvol_name
+    }
+    if ancestor_name:
+        params['ancestor_name'] = ancestor_name
+    return client.call('bdev_lvol_get_changed_clusters', params)
+
+
 def bdev_lvol_set_parent(client, lvol_name, snapshot_name):
     """Set the parent snapshot of a lvol
 
@@ -24,7 +24,8 @@ def nvmf_set_max_subsystems(client,
 def nvmf_set_config(client,
                     passthru_identify_ctrlr=None,
                     poll_groups_mask=None,
-                    discovery_filter=None, dhchap_digests=None, dhchap_dhgroups=None):
+                    discovery_filter=None, dhchap_digests=None, dhchap_dhgroups=None,
+                    io_sched_depth=None):
     """Set NVMe-oF target subsystem configuration.
 
     Args:
@@ -32,6 +33,8 @@ def nvmf_set_config(client,
          comma separated values: `transport`, `address`, `svcid`
         dhchap_digests: List of allowed DH-HMAC-CHAP digests. (optional)
         dhchap_dhgroups: List of allowed DH-HMAC-CHAP DH groups. (optional)
+        io_sched_depth: Maximum number of I/O commands each poll group executes at a time,
+         0 disables the I/O scheduler. (optional)
     Returns:
         True or False
     """
@@ -49,6 +52,8 @@ def nvmf_set_config(client,
         params['dhchap_digests'] = dhchap_digests
     if dhchap_dhgroups is not None:
         params['dhchap_dhgroups'] = dhchap_dhgroups
+    if io_sched_depth is not None:
+        params['io_sched_depth'] = io_sched_depth
 
     return client.call('nvmf_set_config', params)
 
@@ -125,6 +130,8 @@ def nvmf_create_transport(client, **params):
         abort_timeout_sec: Abort execution timeout value, in seconds (optional)
         no_wr_batching: Boolean flag to disable work requests batching - RDMA specific (optional)
         control_msg_num: The number of control messages per poll group - TCP specific (optional)
+        provided_buf_count: The number of receive buffers provided by each poll group - TCP specific (optional)
+        provided_buf_size: The size of the receive buffers provided by the poll groups - TCP specific (optional)
         disable_mappable_bar0: disable client mmap() of BAR0 - VFIO-USER specific (optional)
         disable_adaptive_irq: Disable adaptive interrupt feature - VFIO-USER specific (optional)
         disable_shadow_doorbells: disable shadow doorbell support - VFIO-USER specific (optional)
@@ -534,7 +541,7 @@ def nvmf_ns_visible(visible, client, nqn, nsid, host, tgt_name=None):
 
 
 def nvmf_subsystem_add_host(client, nqn, host, tgt_name=None, psk=None, dhchap_key=None,
-                            dhchap_ctrlr_key=None):
+                            dhchap_ctrlr_key=None, weight=None):
     """Add a host NQN to the list of allowed hosts.
 
     Args:
@@ -544,6 +551,7 @@ def nvmf_subsystem_add_host(client, nqn, host, tgt_name=None, psk=None, dhchap_k
         psk: PSK file path for TLS (optional)
         dhchap_key: DH-HMAC-CHAP key name (optional)
         dhchap_ctrlr_key: DH-HMAC-CHAP controller key name (optional)
+        weight: share of the poll group I/O scheduler given to the host's controllers (optional)
 
     Returns:
         True or False
@@ -559,6 +567,8 @@ def nvmf_subsystem_add_host(client, nqn, host, tgt_name=None, psk=None, dhchap_k
         params['dhchap_key'] = dhchap_key
     if dhchap_ctrlr_key is not None:
         params['dhchap_ctrlr_key'] = dhchap_ctrlr_key
+    if weight is not None:
+        params['weight'] = weight
 
     return client.call('nvmf_subsystem_add_host', params)
 
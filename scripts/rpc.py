@@ -169,7 +169,9 @@ if __name__ == "__main__":
                                         period=args.period,
                                         load_limit=args.load_limit,
                                         core_limit=args.core_limit,
-                                        core_busy=args.core_busy)
+                                        core_busy=args.core_busy,
+                                        reactive_period=args.reactive_period,
+                                        reactive_count=args.reactive_count)
 
     p = subparsers.add_parser(
         'framework_set_scheduler', help='Select thread scheduler that will be activated and its period (experimental)')
@@ -178,6 +180,10 @@ if __name__ == "__main__":
     p.add_argument('--load-limit', help="Scheduler load limit. Reserved for dynamic scheduler", type=int)
     p.add_argument('--core-limit', help="Scheduler core limit. Reserved for dynamic scheduler", type=int)
     p.add_argument('--core-busy', help="Scheduler core busy limit. Reserved for dynamic scheduler", type=int)
+    p.add_argument('--reactive-period', help="""Window in microseconds to check cores for overload between scheduler
+                   periods, 0 to disable. Reserved for dynamic scheduler""", type=int)
+    p.add_argument('--reactive-count', help="""Consecutive overloaded windows before moving a thread off a core.
+                   Reserved for dynamic scheduler""", type=int)
     p.set_defaults(func=framework_set_scheduler)
 
     def framework_get_scheduler(args):
@@ -225,7 +231,8 @@ if __name__ == "__main__":
                                   bdev_io_cache_size=args.bdev_io_cache_size,
                                   bdev_auto_examine=args.bdev_auto_examine,
                                   iobuf_small_cache_size=args.iobuf_small_cache_size,
-                                  iobuf_large_cache_size=args.iobuf_large_cache_size)
+                                  iobuf_large_cache_size=args.iobuf_large_cache_size,
+                                  qos_distributed=args.qos_distributed)
 
     p = subparsers.add_parser('bdev_set_options',
                               help="""Set options of bdev subsystem""")
@@ -236,6 +243,8 @@ if __name__ == "__main__":
     group.add_argument('-d', '--disable-auto-examine', dest='bdev_auto_examine', help='Not allow to auto examine', action='store_false')
     p.add_argument('--iobuf-small-cache-size', help='Size of the small iobuf per thread cache', type=int)
     p.add_argument('--iobuf-large-cache-size', help='Size of the large iobuf per thread cache', type=int)
+    p.add_argument('--qos-distributed', help='Meter QoS rate limits with quota drawn in batches by each channel',
+                   action='store_true')
     p.set_defaults(bdev_auto_examine=True)
     p.set_defaults(func=bdev_set_options)
 
@@ -1233,6 +1242,44 @@ if __name__ == "__main__":
     p.add_argument('name', help='pass through bdev name')
     p.set_defaults(func=bdev_passthru_delete)
 
+    def bdev_coalesce_create(args):
+        print_json(rpc.bdev.bdev_coalesce_create(args.client,
+                                                 base_bdev_name=args.base_bdev_name,
+                                                 name=args.name,
+                                                 uuid=args.uuid,
+                                                 max_delay_us=args.max_delay_us,
+                                                 max_ios=args.max_ios,
+                                                 max_io_size_kib=args.max_io_size_kib))
+
+    p = subparsers.add_parser('bdev_coalesce_create',
+                              help='Add a bdev merging adjacent reads and writes on existing bdev')
+    p.add_argument('-b', '--base-bdev-name', help="Name of the existing bdev", required=True)
+    p.add_argument('-p', '--name', help="Name of the coalesce bdev", required=True)
+    p.add_argument('-u', '--uuid', help="UUID of the bdev")
+    p.add_argument('-d', '--max-delay-us', help="Longest time an I/O is held back, in microseconds",
+                   type=int)
+    p.add_argument('-q', '--max-ios', help="Number of I/O after which a merged request is submitted",
+                   type=int)
+    p.add_argument('-s', '--max-io-size-kib', help="Largest merged request, in KiB", type=int)
+    p.set_defaults(func=bdev_coalesce_create)
+
+    def bdev_coalesce_delete(args):
+        rpc.bdev.bdev_coalesce_delete(args.client,
+                                      name=args.name)
+
+    p = subparsers.add_parser('bdev_coalesce_delete', help='Delete a coalesce bdev')
+    p.add_argument('name', help='coalesce bdev name')
+    p.set_defaults(func=bdev_coalesce_delete)
+
+    def bdev_coalesce_get_stats(args):
+        print_dict(rpc.bdev.bdev_coalesce_get_stats(args.client,
+                                                    name=args.name))
+
+    p = subparsers.add_parser('bdev_coalesce_get_stats',
+                              help='Display the merge ratio and added latency of a coalesce bdev')
+    p.add_argument('name', help='coalesce bdev name')
+    p.set_defaults(func=bdev_coalesce_get_stats)
+
     def bdev_get_bdevs(args):
         print_dict(rpc.bdev.bdev_get_bdevs(args.client,
                                            name=args.name, timeout=args.timeout_ms))
@@ -2086,6 +2133,21 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('snapshot_name', help='lvol snapshot name')
     p.set_defaults(func=bdev_lvol_snapshot)
 
+    def bdev_lvol_snapshot_group(args):
+        snapshots = []
+        for pair in args.snapshots:
+            lvol_name, sep, snapshot_name = pair.rpartition(':')
+            if not sep or not lvol_name or not snapshot_name:
+                raise ValueError(f"Invalid snapshot '{pair}', expected lvol_name:snapshot_name")
+            snapshots.append({'lvol_name': lvol_name, 'snapshot_name': snapshot_name})
+        print_json(rpc.lvol.bdev_lvol_snapshot_group(args.client,
+                                                     snapshots=snapshots))
+
+    p = subparsers.add_parser('bdev_lvol_snapshot_group',
+                              help='Create snapshots of a group of lvol bdevs with a single I/O freeze')
+    p.add_argument('snapshots', nargs='+', help='lvol bdev and snapshot names as lvol_name:snapshot_name')
+    p.set_defaults(func=bdev_lvol_snapshot_group)
+
     def bdev_lvol_clone(args):
         print_json(rpc.lvol.bdev_lvol_clone(args.client,
                                             snapshot_name=args.snapshot_name,
@@ -2164,13 +2226,15 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     def bdev_lvol_start_shallow_copy(args):
         print_json(rpc.lvol.bdev_lvol_start_shallow_copy(args.client,
                                                          src_lvol_name=args.src_lvol_name,
-                                                         dst_bdev_name=args.dst_bdev_name))
+                                                         dst_bdev_name=args.dst_bdev_name,
+                                                         ancestor_lvol_name=args.ancestor_lvol_name))
 
     p = subparsers.add_parser('bdev_lvol_start_shallow_copy',
                               help="""Start a shallow copy of an lvol over a given bdev.  The status of the operation
     can be obtained with bdev_lvol_check_shallow_copy""")
     p.add_argument('src_lvol_name', help='source lvol name')
     p.add_argument('dst_bdev_name', help='destination bdev name')
+    p.add_argument('-a', '--ancestor-lvol-name', help='only copy the clusters changed since this snapshot')
     p.set_defaults(func=bdev_lvol_start_shallow_copy)
 
     def bdev_lvol_check_shallow_copy(args):
@@ -2181,6 +2245,17 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('operation_id', help='operation identifier', type=int)
     p.set_defaults(func=bdev_lvol_check_shallow_copy)
 
+    def bdev_lvol_get_changed_clusters(args):
+        print_json(rpc.lvol.bdev_lvol_get_changed_clusters(args.client,
+                                                           lvol_name=args.lvol_name,
+                                                           ancestor_name=args.ancestor_name))
+
+    p = subparsers.add_parser('bdev_lvol_get_changed_clusters',
+                              help='Get the clusters changed between an lvol and one of its ancestor snapshots')
+    p.add_argument('lvol_name', help='lvol name')
+    p.add_argument('-a', '--ancestor-name', help='ancestor snapshot name')
+    p.set_defaults(func=bdev_lvol_get_changed_clusters)
+
     def bdev_lvol_set_parent(args):
         rpc.lvol.bdev_lvol_set_parent(args.client,
                                       lvol_name=args.lvol_name,
@@ -2269,7 +2344,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                   raid_level=args.raid_level,
                                   base_bdevs=base_bdevs,
                                   uuid=args.uuid,
-                                  superblock=args.superblock)
+                                  superblock=args.superblock,
+                                  read_policy=args.read_policy)
     p = subparsers.add_parser('bdev_raid_create', help='Create new raid bdev')
     p.add_argument('-n', '--name', help='raid bdev name', required=True)
     p.add_argument('-z', '--strip-size-kb', help='strip size in KB', type=int)
@@ -2278,8 +2354,17 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('--uuid', help='UUID for this raid bdev')
     p.add_argument('-s', '--superblock', help='information about raid bdev will be stored in superblock on each base bdev, '
                                               'disabled by default due to backward compatibility', action='store_true')
+    p.add_argument('-p', '--read-policy', help='raid1 read policy: least_outstanding (default), latency or sequential',
+                   choices=['least_outstanding', 'latency', 'sequential'])
     p.set_defaults(func=bdev_raid_create)
 
+    def bdev_raid_get_read_stats(args):
+        print_json(rpc.bdev.bdev_raid_get_read_stats(args.client,
+                                                     name=args.name))
+    p = subparsers.add_parser('bdev_raid_get_read_stats', help='Get per base bdev read statistics of a raid bdev')
+    p.add_argument('name', help='raid bdev name')
+    p.set_defaults(func=bdev_raid_get_read_stats)
+
     def bdev_raid_delete(args):
         rpc.bdev.bdev_raid_delete(args.client,
                                   name=args.name)
@@ -2296,6 +2381,16 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('base_bdev', help='base bdev name')
     p.set_defaults(func=bdev_raid_add_base_bdev)
 
+    def bdev_raid_grow_base_bdev(args):
+        rpc.bdev.bdev_raid_grow_base_bdev(args.client,
+                                          raid_bdev=args.raid_bdev,
+                                          base_bdev=args.base_bdev)
+    p = subparsers.add_parser('bdev_raid_grow_base_bdev',
+                              help='Add a new base bdev to an online raid bdev to increase its capacity')
+    p.add_argument('raid_bdev', help='raid bdev name')
+    p.add_argument('base_bdev', help='base bdev name')
+    p.set_defaults(func=bdev_raid_grow_base_bdev)
+
     def bdev_raid_remove_base_bdev(args):
         rpc.bdev.bdev_raid_remove_base_bdev(args.client,
                                             name=args.name)
@@ -2563,7 +2658,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                  poll_groups_mask=args.poll_groups_mask,
                                  discovery_filter=args.discovery_filter,
                                  dhchap_digests=args.dhchap_digests,
-                                 dhchap_dhgroups=args.dhchap_dhgroups)
+                                 dhchap_dhgroups=args.dhchap_dhgroups,
+                                 io_sched_depth=args.io_sched_depth)
 
     p = subparsers.add_parser('nvmf_set_config', help='Set NVMf target config')
     p.add_argument('-i', '--passthru-identify-ctrlr', help="""Passthrough fields like serial number and model number
@@ -2575,6 +2671,9 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                    type=lambda d: d.split(','))
     p.add_argument('--dhchap-dhgroups', help='Comma-separated list of allowed DH-HMAC-CHAP DH groups',
                    type=lambda d: d.split(','))
+    p.add_argument('--io-sched-depth', help='Maximum number of I/O commands each poll group executes at a time, '
+                   'further commands are shared fairly between hosts according to their weight. 0 (default) disables it',
+                   type=int)
     p.set_defaults(func=nvmf_set_config)
 
     def nvmf_create_transport(args):
@@ -2613,6 +2712,9 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     Relevant only for VFIO-USER transport""")
     p.add_argument('--acceptor-poll-rate', help='Polling interval of the acceptor for incoming connections (usec)', type=int)
     p.add_argument('--ack-timeout', help='ACK timeout in milliseconds', type=int)
+    p.add_argument('--provided-buf-count', help="""The number of receive buffers each poll group provides to its sockets.
+    Written data received in full in one of them is passed to the bdev without a copy. Relevant only for TCP transport""", type=int)
+    p.add_argument('--provided-buf-size', help='The size of the provided receive buffers. Relevant only for TCP transport', type=int)
     p.add_argument('--data-wr-pool-size', help='RDMA data WR pool size. Relevant only for RDMA transport', type=int)
     p.add_argument('--disable-command-passthru', help='Disallow command passthru', action='store_true')
     p.set_defaults(func=nvmf_create_transport)
@@ -2842,7 +2944,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                          tgt_name=args.tgt_name,
                                          psk=args.psk,
                                          dhchap_key=args.dhchap_key,
-                                         dhchap_ctrlr_key=args.dhchap_ctrlr_key)
+                                         dhchap_ctrlr_key=args.dhchap_ctrlr_key,
+                                         weight=args.weight)
 
     p = subparsers.add_parser('nvmf_subsystem_add_host', help='Add a host to an NVMe-oF subsystem')
     p.add_argument('nqn', help='NVMe-oF subsystem NQN')
@@ -2851,6 +2954,8 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
     p.add_argument('--psk', help='Path to PSK file for TLS authentication (optional). Only applicable for TCP transport.', type=str)
     p.add_argument('--dhchap-key', help='DH-HMAC-CHAP key name (optional)')
     p.add_argument('--dhchap-ctrlr-key', help='DH-HMAC-CHAP controller key name (optional)')
+    p.add_argument('-w', '--weight', help='Share of the poll group I/O scheduler given to each controller of '
+                   'this host relative to other controllers (optional, default: 1)', type=int)
     p.set_defaults(func=nvmf_subsystem_add_host)
 
     def nvmf_subsystem_remove_host(args):
@@ -3804,12 +3909,15 @@ Format: 'user:u1 secret:s1 muser:mu1 msecret:ms1,user:u2 secret:s2 muser:mu2 mse
                                     small_pool_count=args.small_pool_count,
                                     large_pool_count=args.large_pool_count,
                                     small_bufsize=args.small_bufsize,
-                                    large_bufsize=args.large_bufsize)
+                                    large_bufsize=args.large_bufsize,
+                                    enable_numa=args.enable_numa)
     p = subparsers.add_parser('iobuf_set_options', help='Set iobuf pool options')
     p.add_argument('--small-pool-count', help='number of small buffers in the global pool', type=int)
     p.add_argument('--large-pool-count', help='number of large buffers in the global pool', type=int)
     p.add_argument('--small-bufsize', help='size of a small buffer', type=int)
     p.add_argument('--large-bufsize', help='size of a large buffer', type=int)
+    p.add_argument('--enable-numa', help='keep separate pools on each NUMA node, the counts then apply per node',
+                   action='store_true', default=None)
     p.set_defaults(func=iobuf_set_options)
 
     def iobuf_get_stats(args):
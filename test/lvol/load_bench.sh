@@ -0,0 +1,81 @@
+#!/usr/bin/env bash
+#  SPDX-License-Identifier: BSD-3-Clause
+#  Copyright (C) 2024 simplyblock GmbH.
+#  All rights reserved.
+#
+# Measure how long it takes to load an lvolstore depending on the number of lvols it holds.
+# For each count in LVOL_COUNTS, an lvolstore with that many thin provisioned lvols is created
+# on an aio bdev, the aio bdev is detached, and the time from re-attaching it until the examine
+# of the lvolstore and all of its lvols is complete is reported.
+#
+# Usage: load_bench.sh [lvol_count...]
+#
+testdir=$(readlink -f $(dirname $0))
+rootdir=$(readlink -f $testdir/../..)
+source $rootdir/test/common/autotest_common.sh
+source $rootdir/test/lvol/common.sh
+
+LVOL_COUNTS=("${@:-1000 2000 5000 10000}")
+# Big enough for the metadata of the largest count, the file is sparse
+BENCH_AIO_SIZE_MB=$((16 * 1024))
+BENCH_CLUSTER_SIZE=$((1024 * 1024))
+
+aio_file=$testdir/aio_bdev_load_bench
+
+function now_us() {
+	echo $(($(date +%s%N) / 1000))
+}
+
+function create_lvols() {
+	local lvs_uuid=$1 count=$2
+	local i
+
+	# Send all requests through a single rpc.py instance, creating them one by one through
+	# rpc_cmd would dominate the run time.
+	for ((i = 0; i < count; i++)); do
+		echo "bdev_lvol_create -t -u $lvs_uuid lvol_$i 1"
+	done | $rootdir/scripts/rpc.py > /dev/null
+}
+
+function bench_load() {
+	local count=$1
+	local lvs_uuid start end lvols
+
+	rm -f "$aio_file"
+	truncate -s "${BENCH_AIO_SIZE_MB}M" "$aio_file"
+
+	rpc_cmd bdev_aio_create "$aio_file" aio_bdev "$AIO_BS"
+	lvs_uuid=$(rpc_cmd bdev_lvol_create_lvstore aio_bdev lvs_bench -c "$BENCH_CLUSTER_SIZE")
+	create_lvols "$lvs_uuid" "$count"
+
+	rpc_cmd bdev_aio_delete aio_bdev
+	rpc_cmd bdev_wait_for_examine
+
+	start=$(now_us)
+	rpc_cmd bdev_aio_create "$aio_file" aio_bdev "$AIO_BS"
+	rpc_cmd bdev_wait_for_examine
+	end=$(now_us)
+
+	lvols=$(rpc_cmd bdev_get_bdevs | jq -r '[ .[] | select(.product_name == "Logical Volume") ] | length')
+	[ "$lvols" == "$count" ]
+
+	printf '%10d %15d %15.3f\n' "$count" "$((end - start))" \
+		"$(calc "($end - $start) / $count")"
+
+	rpc_cmd bdev_lvol_delete_lvstore -u "$lvs_uuid"
+	rpc_cmd bdev_aio_delete aio_bdev
+	rm -f "$aio_file"
+}
+
+$SPDK_BIN_DIR/spdk_tgt &
+spdk_pid=$!
+trap 'killprocess "$spdk_pid"; rm -f "$aio_file"; exit 1' SIGINT SIGTERM EXIT
+waitforlisten $spdk_pid
+
+printf '%10s %15s %15s\n' "lvols" "load time [us]" "per lvol [us]"
+for count in ${LVOL_COUNTS[*]}; do
+	bench_load "$count"
+done
+
+trap - SIGINT SIGTERM EXIT
+killprocess $spdk_pid
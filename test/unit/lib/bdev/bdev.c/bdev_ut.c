@@ -4927,7 +4927,7 @@ lock_lba_range_check_ranges(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -4945,7 +4945,7 @@ lock_lba_range_check_ranges(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 
 	spdk_put_io_channel(io_ch);
 	spdk_bdev_close(desc);
@@ -4990,7 +4990,7 @@ lock_lba_range_with_io_outstanding(void)
 	 */
 	CU_ASSERT(g_io_done == false);
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5003,7 +5003,7 @@ lock_lba_range_with_io_outstanding(void)
 	spdk_delay_us(100);
 	poll_threads();
 
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 
 	/* Now try again, but with a write I/O. */
 	g_io_done = false;
@@ -5021,7 +5021,7 @@ lock_lba_range_with_io_outstanding(void)
 	 */
 	CU_ASSERT(g_io_done == false);
 	CU_ASSERT(g_lock_lba_range_done == false);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5039,7 +5039,7 @@ lock_lba_range_with_io_outstanding(void)
 	CU_ASSERT(rc == 0);
 	poll_threads();
 
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 
 	spdk_put_io_channel(io_ch);
 	spdk_bdev_close(desc);
@@ -5047,6 +5047,68 @@ lock_lba_range_with_io_outstanding(void)
 	ut_fini_bdev();
 }
 
+static void
+lock_lba_range_tree(void)
+{
+	struct lba_range_tree tree;
+	struct lba_range ranges[5] = {
+		{ .offset = 0, .length = 10 },
+		{ .offset = 20, .length = 100 },
+		{ .offset = 40, .length = 10 },
+		{ .offset = 40, .length = 10 },
+		{ .offset = 60, .length = 0 },
+	};
+	struct lba_range *range;
+	int i, count;
+
+	bdev_lba_range_tree_init(&tree);
+	CU_ASSERT(bdev_lba_range_tree_first_overlap(&tree, 0, 1000) == NULL);
+
+	for (i = 0; i < 5; i++) {
+		bdev_lba_range_tree_insert(&tree, &ranges[i]);
+	}
+	CU_ASSERT(tree.max_length == 100);
+
+	/* 20-119 starts way before 100, it still has to be found */
+	range = bdev_lba_range_tree_first_overlap(&tree, 100, 1);
+	CU_ASSERT(range == &ranges[1]);
+	CU_ASSERT(bdev_lba_range_tree_first_overlap(&tree, 10, 10) == NULL);
+	CU_ASSERT(bdev_lba_range_tree_first_overlap(&tree, 120, 10) == NULL);
+
+	/* Both copies of 40-49 are found, the zero length range never overlaps */
+	count = 0;
+	BDEV_LBA_RANGE_FOREACH_OVERLAP(range, &tree, 45, 20) {
+		CU_ASSERT(range == &ranges[1] || range == &ranges[2] || range == &ranges[3]);
+		count++;
+	}
+	CU_ASSERT(count == 3);
+
+	count = 0;
+	BDEV_LBA_RANGE_FOREACH_AT(range, &tree, 40) {
+		CU_ASSERT(range->offset == 40);
+		count++;
+	}
+	CU_ASSERT(count == 2);
+	BDEV_LBA_RANGE_FOREACH_AT(range, &tree, 41) {
+		CU_ASSERT(false);
+	}
+	CU_ASSERT(range == NULL);
+
+	/* Removing the longest range shrinks the lookup bound */
+	bdev_lba_range_tree_remove(&tree, &ranges[1]);
+	CU_ASSERT(tree.max_length == 10);
+	CU_ASSERT(bdev_lba_range_tree_first_overlap(&tree, 100, 1) == NULL);
+	CU_ASSERT(bdev_lba_range_tree_first_overlap(&tree, 9, 1) == &ranges[0]);
+
+	for (i = 0; i < 5; i++) {
+		if (i != 1) {
+			bdev_lba_range_tree_remove(&tree, &ranges[i]);
+		}
+	}
+	CU_ASSERT(RB_EMPTY(&tree));
+	CU_ASSERT(tree.max_length == 0);
+}
+
 static void
 lock_lba_range_overlapped(void)
 {
@@ -5076,7 +5138,7 @@ lock_lba_range_overlapped(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5105,7 +5167,7 @@ lock_lba_range_overlapped(void)
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
 	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.pending_locked_ranges));
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 25);
 	CU_ASSERT(range->length == 15);
@@ -5119,9 +5181,9 @@ lock_lba_range_overlapped(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&bdev->internal.locked_ranges);
+	range = RB_MIN(lba_range_tree, &bdev->internal.locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
-	range = TAILQ_NEXT(range, tailq);
+	range = RB_NEXT(lba_range_tree, &bdev->internal.locked_ranges, range);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 40);
 	CU_ASSERT(range->length == 20);
@@ -5164,7 +5226,7 @@ lock_lba_range_overlapped(void)
 	CU_ASSERT(g_unlock_lba_range_done == true);
 	CU_ASSERT(g_lock_lba_range_done == true);
 	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.pending_locked_ranges));
-	range = TAILQ_FIRST(&bdev->internal.locked_ranges);
+	range = RB_MIN(lba_range_tree, &bdev->internal.locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 35);
 	CU_ASSERT(range->length == 10);
@@ -5176,7 +5238,7 @@ lock_lba_range_overlapped(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&bdev->internal.locked_ranges));
+	CU_ASSERT(RB_EMPTY(&bdev->internal.locked_ranges));
 
 	spdk_put_io_channel(io_ch);
 	spdk_bdev_close(desc);
@@ -5237,7 +5299,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 0);
 	CU_ASSERT(range->length == bdev->blockcnt);
@@ -5255,7 +5317,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ut_if.internal.quiesced_ranges));
 
 	g_lock_lba_range_done = false;
@@ -5264,7 +5326,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -5287,7 +5349,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ut_if.internal.quiesced_ranges));
 
 	/* Test unquiesce from quiesce cb */
@@ -5313,7 +5375,7 @@ bdev_quiesce(void)
 
 	CU_ASSERT(g_io_done == false);
 	CU_ASSERT(g_lock_lba_range_done == false);
-	range = TAILQ_FIRST(&channel->locked_ranges);
+	range = RB_MIN(lba_range_tree, &channel->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 
 	stub_complete_io(1);
@@ -5338,7 +5400,7 @@ bdev_quiesce(void)
 	poll_threads();
 
 	CU_ASSERT(g_unlock_lba_range_done == true);
-	CU_ASSERT(TAILQ_EMPTY(&channel->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&channel->locked_ranges));
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ut_if.internal.quiesced_ranges));
 
 	CU_ASSERT(TAILQ_EMPTY(&channel->io_locked));
@@ -7494,6 +7556,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, lock_lba_range_check_ranges);
 	CU_ADD_TEST(suite, lock_lba_range_with_io_outstanding);
 	CU_ADD_TEST(suite, lock_lba_range_overlapped);
+	CU_ADD_TEST(suite, lock_lba_range_tree);
 	CU_ADD_TEST(suite, bdev_quiesce);
 	CU_ADD_TEST(suite, bdev_io_abort);
 	CU_ADD_TEST(suite, bdev_unmap);
@@ -0,0 +1,197 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+/*
+ * Measures the cost of checking an I/O against the locked LBA ranges of a bdev channel,
+ * as done by bdev_io_submit(), while the number of locked ranges grows.  The same check
+ * is done with a linear walk over a list of the ranges for comparison.
+ */
+
+#include "spdk/stdinc.h"
+
+#include "common/lib/ut_multithread.c"
+#include "unit/lib/json_mock.c"
+
+#include "spdk/config.h"
+/* HACK: disable VTune integration so the benchmark doesn't need VTune headers and libs to build */
+#undef SPDK_CONFIG_VTUNE
+
+#include "bdev/bdev.c"
+
+DEFINE_STUB(spdk_notify_send, uint64_t, (const char *type, const char *ctx), 0);
+DEFINE_STUB(spdk_notify_type_register, struct spdk_notify_type *, (const char *type), NULL);
+DEFINE_STUB_V(spdk_scsi_nvme_translate, (const struct spdk_bdev_io *bdev_io, int *sc, int *sk,
+		int *asc, int *ascq));
+DEFINE_STUB(spdk_memory_domain_get_dma_device_id, const char *, (struct spdk_memory_domain *domain),
+	    "test_domain");
+DEFINE_STUB(spdk_memory_domain_get_dma_device_type, enum spdk_dma_device_type,
+	    (struct spdk_memory_domain *domain), 0);
+DEFINE_STUB(spdk_memory_domain_pull_data, int,
+	    (struct spdk_memory_domain *src_domain, void *src_domain_ctx,
+	     struct iovec *src_iov, uint32_t src_iov_cnt, struct iovec *dst_iov, uint32_t dst_iov_cnt,
+	     spdk_memory_domain_data_cpl_cb cpl_cb, void *cpl_cb_arg), 0);
+DEFINE_STUB(spdk_memory_domain_push_data, int,
+	    (struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+	     struct iovec *dst_iov, uint32_t dst_iovcnt, struct iovec *src_iov, uint32_t src_iovcnt,
+	     spdk_memory_domain_data_cpl_cb cpl_cb, void *cpl_cb_arg), 0);
+DEFINE_STUB_V(spdk_accel_sequence_finish,
+	      (struct spdk_accel_sequence *seq, spdk_accel_completion_cb cb_fn, void *cb_arg));
+DEFINE_STUB_V(spdk_accel_sequence_abort, (struct spdk_accel_sequence *seq));
+DEFINE_STUB_V(spdk_accel_sequence_reverse, (struct spdk_accel_sequence *seq));
+DEFINE_STUB(spdk_accel_append_copy, int,
+	    (struct spdk_accel_sequence **seq, struct spdk_io_channel *ch, struct iovec *dst_iovs,
+	     uint32_t dst_iovcnt, struct spdk_memory_domain *dst_domain, void *dst_domain_ctx,
+	     struct iovec *src_iovs, uint32_t src_iovcnt, struct spdk_memory_domain *src_domain,
+	     void *src_domain_ctx, spdk_accel_step_cb cb_fn, void *cb_arg), 0);
+DEFINE_STUB(spdk_accel_get_memory_domain, struct spdk_memory_domain *, (void), NULL);
+DEFINE_STUB(spdk_accel_get_io_channel, struct spdk_io_channel *, (void), NULL);
+
+/* Each locked range covers the first half of its stride, so about half of the I/O
+ * hit a locked range.
+ */
+#define BENCH_RANGE_BLOCKS	64
+#define BENCH_RANGE_STRIDE	128
+#define BENCH_IO_BLOCKS		8
+
+static const uint32_t g_num_ranges[] = { 0, 1, 10, 50, 100, 200, 500, 1000 };
+static uint64_t g_num_ios = 1000000;
+
+static uint64_t
+bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * SPDK_SEC_TO_NSEC + ts.tv_nsec;
+}
+
+static bool
+bench_list_is_locked(struct spdk_bdev_io *bdev_io, lba_range_tailq_t *list)
+{
+	struct lba_range *range;
+
+	TAILQ_FOREACH(range, list, tailq) {
+		if (bdev_io_range_is_locked(bdev_io, range)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int
+bench_run(uint32_t num_ranges)
+{
+	struct spdk_bdev_channel ch = {};
+	struct spdk_bdev_io *bdev_io;
+	struct lba_range *ranges;
+	lba_range_tailq_t list;
+	uint64_t *offsets, span, start, tree_ns, list_ns, tree_locked = 0, list_locked = 0, i;
+	unsigned int seed = 0;
+	int rc = 0;
+
+	bdev_io = calloc(1, sizeof(*bdev_io));
+	ranges = calloc(spdk_max(num_ranges, 1), sizeof(*ranges));
+	offsets = calloc(g_num_ios, sizeof(*offsets));
+	if (bdev_io == NULL || ranges == NULL || offsets == NULL) {
+		fprintf(stderr, "Unable to allocate memory\n");
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	bdev_lba_range_tree_init(&ch.locked_ranges);
+	TAILQ_INIT(&list);
+
+	/* Lock the ranges in a shuffled order, like independent users would. */
+	for (i = 0; i < num_ranges; i++) {
+		ranges[i].offset = ((i * 7919) % num_ranges) * BENCH_RANGE_STRIDE;
+		ranges[i].length = BENCH_RANGE_BLOCKS;
+		ranges[i].locked_ctx = &ranges[i];
+		bdev_lba_range_tree_insert(&ch.locked_ranges, &ranges[i]);
+		TAILQ_INSERT_TAIL(&list, &ranges[i], tailq);
+	}
+
+	span = spdk_max(num_ranges, 1) * BENCH_RANGE_STRIDE - BENCH_IO_BLOCKS;
+	for (i = 0; i < g_num_ios; i++) {
+		offsets[i] = ((uint64_t)rand_r(&seed) << 31 | rand_r(&seed)) % span;
+	}
+
+	bdev_io->type = SPDK_BDEV_IO_TYPE_WRITE;
+	bdev_io->internal.ch = &ch;
+	bdev_io->u.bdev.num_blocks = BENCH_IO_BLOCKS;
+
+	start = bench_now_ns();
+	for (i = 0; i < g_num_ios; i++) {
+		bdev_io->u.bdev.offset_blocks = offsets[i];
+		if (!RB_EMPTY(&ch.locked_ranges) &&
+		    bdev_io_ranges_are_locked(bdev_io, &ch.locked_ranges)) {
+			tree_locked++;
+		}
+	}
+	tree_ns = bench_now_ns() - start;
+
+	start = bench_now_ns();
+	for (i = 0; i < g_num_ios; i++) {
+		bdev_io->u.bdev.offset_blocks = offsets[i];
+		if (!TAILQ_EMPTY(&list) && bench_list_is_locked(bdev_io, &list)) {
+			list_locked++;
+		}
+	}
+	list_ns = bench_now_ns() - start;
+
+	if (tree_locked != list_locked) {
+		fprintf(stderr, "Mismatch with %" PRIu32 " ranges: %" PRIu64 " locked I/O in tree, "
+			"%" PRIu64 " in list\n", num_ranges, tree_locked, list_locked);
+		rc = -EINVAL;
+		goto out;
+	}
+
+	printf("%10" PRIu32 " %14.1f %14.1f %9.1f%%\n", num_ranges,
+	       (double)tree_ns / g_num_ios, (double)list_ns / g_num_ios,
+	       100.0 * tree_locked / g_num_ios);
+out:
+	free(offsets);
+	free(ranges);
+	free(bdev_io);
+	return rc;
+}
+
+static void
+usage(const char *program_name)
+{
+	printf("%s [options]\n", program_name);
+	printf("\t[-n number of I/O checked per run (default: %" PRIu64 ")]\n", g_num_ios);
+}
+
+int
+main(int argc, char **argv)
+{
+	uint32_t i;
+	int op;
+
+	while ((op = getopt(argc, argv, "n:h")) != -1) {
+		switch (op) {
+		case 'n':
+			g_num_ios = spdk_strtoll(optarg, 10);
+			if ((int64_t)g_num_ios <= 0) {
+				fprintf(stderr, "Invalid number of I/O: %s\n", optarg);
+				return 1;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return op == 'h' ? 0 : 1;
+		}
+	}
+
+	printf("%10s %14s %14s %10s\n", "ranges", "tree ns/io", "list ns/io", "locked");
+	for (i = 0; i < SPDK_COUNTOF(g_num_ranges); i++) {
+		if (bench_run(g_num_ranges[i]) != 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
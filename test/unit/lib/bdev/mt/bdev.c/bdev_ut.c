@@ -1278,6 +1278,118 @@ io_during_qos_queue(void)
 	teardown_test();
 }
 
+static void
+io_during_qos_distributed(void)
+{
+	struct spdk_io_channel *io_ch[2];
+	struct spdk_bdev_channel *bdev_ch[2];
+	struct spdk_bdev_qos_limit *limit;
+	struct spdk_bdev *bdev;
+	enum spdk_bdev_io_status status[19];
+	int i, rc;
+
+	setup_test();
+	MOCK_SET(spdk_get_ticks, 0);
+	g_bdev_opts.qos_distributed = true;
+
+	/* Enable QoS */
+	bdev = &g_bdev.bdev;
+	bdev->internal.qos = calloc(1, sizeof(*bdev->internal.qos));
+	SPDK_CU_ASSERT_FATAL(bdev->internal.qos != NULL);
+
+	/* 16000 read/write I/O per second, or 16 per millisecond */
+	bdev->internal.qos->rate_limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT].limit = 16000;
+	limit = &bdev->internal.qos->rate_limits[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT];
+
+	g_get_io_channel = true;
+
+	/* Create channels */
+	set_thread(0);
+	io_ch[0] = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch[0] = spdk_io_channel_get_ctx(io_ch[0]);
+	CU_ASSERT(bdev_ch[0]->flags == BDEV_CH_QOS_ENABLED);
+
+	set_thread(1);
+	io_ch[1] = spdk_bdev_get_io_channel(g_desc);
+	bdev_ch[1] = spdk_io_channel_get_ctx(io_ch[1]);
+	CU_ASSERT(bdev_ch[1]->flags == BDEV_CH_QOS_ENABLED);
+
+	CU_ASSERT(bdev->internal.qos->distributed == true);
+	CU_ASSERT(limit->max_per_timeslice == 16);
+	CU_ASSERT(limit->channel_quota == 2);
+
+	/* The first I/O on thread 0 draws a batch of two I/O from the shared budget */
+	set_thread(0);
+	status[0] = SPDK_BDEV_IO_STATUS_PENDING;
+	rc = spdk_bdev_read_blocks(g_desc, io_ch[0], NULL, 0, 1, io_during_io_done, &status[0]);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(bdev_ch[0]->io_outstanding == 1);
+	CU_ASSERT(bdev_ch[0]->qos_quota[SPDK_BDEV_QOS_RW_IOPS_RATE_LIMIT] == 1);
+	CU_ASSERT(limit->remaining_this_timeslice == 14);
+
+	/* Thread 1 uses up the rest of the budget and queues the last two I/O */
+	set_thread(1);
+	for (i = 1; i < 17; i++) {
+		status[i] = SPDK_BDEV_IO_STATUS_PENDING;
+		rc = spdk_bdev_read_blocks(g_desc, io_ch[1], NULL, 0, 1, io_during_io_done, &status[i]);
+		CU_ASSERT(rc == 0);
+	}
+	CU_ASSERT(bdev_ch[1]->io_outstanding == 14);
+	CU_ASSERT(bdev_io_tailq_cnt(&bdev_ch[1]->qos_queued_io) == 2);
+	CU_ASSERT(bdev_ch[1]->qos_poller != NULL);
+	CU_ASSERT(limit->remaining_this_timeslice == 0);
+
+	/* Thread 0 still has one I/O of local quota, the next one is queued */
+	set_thread(0);
+	status[17] = SPDK_BDEV_IO_STATUS_PENDING;
+	rc = spdk_bdev_read_blocks(g_desc, io_ch[0], NULL, 0, 1, io_during_io_done, &status[17]);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(bdev_ch[0]->io_outstanding == 2);
+	CU_ASSERT(bdev_ch[0]->qos_poller == NULL);
+
+	status[18] = SPDK_BDEV_IO_STATUS_PENDING;
+	rc = spdk_bdev_read_blocks(g_desc, io_ch[0], NULL, 0, 1, io_during_io_done, &status[18]);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(bdev_ch[0]->io_outstanding == 2);
+	CU_ASSERT(bdev_io_tailq_cnt(&bdev_ch[0]->qos_queued_io) == 1);
+	CU_ASSERT(bdev_ch[0]->qos_poller != NULL);
+
+	/* Nothing is submitted before the next timeslice */
+	poll_threads();
+	CU_ASSERT(bdev_ch[0]->io_outstanding == 2);
+	CU_ASSERT(bdev_ch[1]->io_outstanding == 14);
+
+	/* Advance in time by a millisecond, each channel submits its own queued I/O */
+	spdk_delay_us(1000);
+	poll_threads();
+	CU_ASSERT(bdev_ch[0]->io_outstanding == 3);
+	CU_ASSERT(bdev_ch[1]->io_outstanding == 16);
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch[0]->qos_queued_io));
+	CU_ASSERT(TAILQ_EMPTY(&bdev_ch[1]->qos_queued_io));
+	CU_ASSERT(bdev_ch[0]->qos_poller == NULL);
+	CU_ASSERT(bdev_ch[1]->qos_poller == NULL);
+
+	/* Complete the I/O */
+	set_thread(0);
+	stub_complete_io(g_bdev.io_target, 0);
+	set_thread(1);
+	stub_complete_io(g_bdev.io_target, 0);
+	poll_threads();
+	for (i = 0; i < 19; i++) {
+		CU_ASSERT(status[i] == SPDK_BDEV_IO_STATUS_SUCCESS);
+	}
+
+	/* Tear down the channels */
+	set_thread(1);
+	spdk_put_io_channel(io_ch[1]);
+	set_thread(0);
+	spdk_put_io_channel(io_ch[0]);
+	poll_threads();
+
+	g_bdev_opts.qos_distributed = false;
+	teardown_test();
+}
+
 static void
 io_during_qos_reset(void)
 {
@@ -2261,7 +2373,7 @@ lock_lba_range_then_submit_io(void)
 	 * write I/O.
 	 */
 	CU_ASSERT(g_lock_lba_range_done == true);
-	range = TAILQ_FIRST(&bdev_ch[0]->locked_ranges);
+	range = RB_MIN(lba_range_tree, &bdev_ch[0]->locked_ranges);
 	SPDK_CU_ASSERT_FATAL(range != NULL);
 	CU_ASSERT(range->offset == 20);
 	CU_ASSERT(range->length == 10);
@@ -2328,7 +2440,7 @@ lock_lba_range_then_submit_io(void)
 	rc = bdev_unlock_lba_range(desc, io_ch[0], 20, 10, unlock_lba_range_done, &ctx0);
 	CU_ASSERT(rc == 0);
 	poll_threads();
-	CU_ASSERT(TAILQ_EMPTY(&bdev_ch[0]->locked_ranges));
+	CU_ASSERT(RB_EMPTY(&bdev_ch[0]->locked_ranges));
 
 	/* The LBA range is unlocked, so the write IOs should now have started execution. */
 	CU_ASSERT(TAILQ_EMPTY(&bdev_ch[1]->io_locked));
@@ -2767,6 +2879,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, io_during_reset);
 	CU_ADD_TEST(suite, reset_completions);
 	CU_ADD_TEST(suite, io_during_qos_queue);
+	CU_ADD_TEST(suite, io_during_qos_distributed);
 	CU_ADD_TEST(suite, io_during_qos_reset);
 	CU_ADD_TEST(suite, enomem);
 	CU_ADD_TEST(suite, enomem_multi_bdev);
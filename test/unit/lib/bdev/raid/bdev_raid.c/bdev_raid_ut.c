@@ -59,6 +59,7 @@ bool g_bdev_io_defer_completion;
 TAILQ_HEAD(, spdk_bdev_io) g_deferred_ios = TAILQ_HEAD_INITIALIZER(g_deferred_ios);
 struct spdk_thread *g_app_thread;
 struct spdk_thread *g_latest_thread;
+int g_ut_raid_grow_rc;
 
 static int
 ut_raid_start(struct raid_bdev *raid_bdev)
@@ -125,6 +126,12 @@ ut_raid_submit_process_request(struct raid_bdev_process_request *process_req,
 	return process_req->num_blocks;
 }
 
+static int
+ut_raid_grow(struct raid_bdev *raid_bdev)
+{
+	return g_ut_raid_grow_rc;
+}
+
 static struct raid_bdev_module g_ut_raid_module = {
 	.level = 123,
 	.base_bdevs_min = 1,
@@ -132,6 +139,7 @@ static struct raid_bdev_module g_ut_raid_module = {
 	.submit_rw_request = ut_raid_submit_rw_request,
 	.submit_null_payload_request = ut_raid_submit_null_payload_request,
 	.submit_process_request = ut_raid_submit_process_request,
+	.grow = ut_raid_grow,
 };
 RAID_MODULE_REGISTER(&g_ut_raid_module)
 
@@ -187,6 +195,14 @@ DEFINE_STUB(spdk_json_write_named_uuid, int, (struct spdk_json_write_ctx *w, con
 DEFINE_STUB_V(raid_bdev_init_superblock, (struct raid_bdev *raid_bdev));
 DEFINE_STUB(raid_bdev_alloc_superblock, int, (struct raid_bdev *raid_bdev, uint32_t block_size), 0);
 DEFINE_STUB_V(raid_bdev_free_superblock, (struct raid_bdev *raid_bdev));
+DEFINE_STUB_V(raid_bdev_superblock_add_base_bdev, (struct raid_bdev *raid_bdev,
+		struct raid_base_bdev_info *base_info));
+DEFINE_STUB(raid_bdev_alloc_wi_bitmap, int, (struct raid_bdev *raid_bdev), -ENOTSUP);
+DEFINE_STUB_V(raid_bdev_free_wi_bitmap, (struct raid_bdev *raid_bdev));
+DEFINE_STUB_V(raid_bdev_load_wi_bitmap, (struct raid_bdev *raid_bdev, raid_bdev_wi_bitmap_cb cb,
+		void *cb_ctx));
+DEFINE_STUB_V(raid_bdev_write_wi_bitmap, (struct raid_bdev *raid_bdev, raid_bdev_wi_bitmap_cb cb,
+		void *cb_ctx));
 DEFINE_STUB(spdk_bdev_readv_blocks_ext, int, (struct spdk_bdev_desc *desc,
 		struct spdk_io_channel *ch, struct iovec *iov, int iovcnt, uint64_t offset_blocks,
 		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
@@ -1117,6 +1133,94 @@ test_io_channel(void)
 	reset_globals();
 }
 
+static void
+ut_raid_grow_cb(void *ctx, int status)
+{
+	*(int *)ctx = status;
+}
+
+static void
+test_raid_grow(void)
+{
+	struct rpc_bdev_raid_create req;
+	struct rpc_bdev_raid_delete destroy_req;
+	struct raid_bdev *pbdev;
+	struct spdk_io_channel *ch;
+	struct raid_bdev_io_channel *ch_ctx;
+	char name[16];
+	int status;
+
+	set_globals();
+	CU_ASSERT(raid_bdev_init() == 0);
+
+	create_raid_bdev_create_req(&req, "raid1", 0, true, 0, false);
+	rpc_bdev_raid_create(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev(&req, true, RAID_BDEV_STATE_ONLINE);
+	free_test_req(&req);
+
+	pbdev = raid_bdev_find_by_name("raid1");
+	SPDK_CU_ASSERT_FATAL(pbdev != NULL);
+
+	ch = spdk_get_io_channel(pbdev);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	ch_ctx = spdk_io_channel_get_ctx(ch);
+
+	create_base_bdevs(g_max_base_drives);
+	snprintf(name, sizeof(name), "Nvme%un1", g_max_base_drives);
+
+	/* Not existing base bdev */
+	status = 1;
+	CU_ASSERT(raid_bdev_grow_base_bdev(pbdev, "Nvme_none", ut_raid_grow_cb, &status) == 0);
+	poll_app_thread();
+	CU_ASSERT(status == -ENODEV);
+	CU_ASSERT(pbdev->num_base_bdevs == g_max_base_drives);
+	CU_ASSERT(pbdev->grow_started == false);
+
+	/* The module fails to grow, the base bdev is released */
+	g_ut_raid_grow_rc = -EIO;
+	status = 1;
+	CU_ASSERT(raid_bdev_grow_base_bdev(pbdev, name, ut_raid_grow_cb, &status) == 0);
+	CU_ASSERT(raid_bdev_grow_base_bdev(pbdev, name, ut_raid_grow_cb, &status) == -EBUSY);
+	poll_app_thread();
+	CU_ASSERT(status == -EIO);
+	CU_ASSERT(pbdev->num_base_bdevs == g_max_base_drives);
+	CU_ASSERT(pbdev->num_base_bdevs_discovered == g_max_base_drives);
+	CU_ASSERT(pbdev->base_bdev_info[g_max_base_drives].desc == NULL);
+	CU_ASSERT(ch_ctx->base_channel[g_max_base_drives] == NULL);
+
+	g_ut_raid_grow_rc = 0;
+	status = 1;
+	CU_ASSERT(raid_bdev_grow_base_bdev(pbdev, name, ut_raid_grow_cb, &status) == 0);
+	poll_app_thread();
+	CU_ASSERT(status == 0);
+	CU_ASSERT(pbdev->num_base_bdevs == g_max_base_drives + 1);
+	CU_ASSERT(pbdev->num_base_bdevs_discovered == g_max_base_drives + 1);
+	CU_ASSERT(pbdev->num_base_bdevs_operational == g_max_base_drives + 1);
+	CU_ASSERT(pbdev->base_bdev_info[g_max_base_drives].is_configured == true);
+	CU_ASSERT(strcmp(pbdev->base_bdev_info[g_max_base_drives].name, name) == 0);
+	CU_ASSERT(ch_ctx->num_base_channels == g_max_base_drives + 1);
+	CU_ASSERT(ch_ctx->base_channel[g_max_base_drives] != NULL);
+	CU_ASSERT(pbdev->reshape.num_base_bdevs_old == 0);
+
+	/* Modules that restripe require a superblock */
+	g_ut_raid_module.grow_restripe = true;
+	snprintf(name, sizeof(name), "Nvme%un1", g_max_base_drives + 1);
+	CU_ASSERT(raid_bdev_grow_base_bdev(pbdev, name, ut_raid_grow_cb, &status) == -EINVAL);
+	g_ut_raid_module.grow_restripe = false;
+
+	spdk_put_io_channel(ch);
+
+	create_raid_bdev_delete_req(&destroy_req, "raid1", 0);
+	rpc_bdev_raid_delete(NULL, NULL);
+	CU_ASSERT(g_rpc_err == 0);
+	verify_raid_bdev_present("raid1", false);
+
+	raid_bdev_exit();
+	base_bdevs_cleanup();
+	reset_globals();
+}
+
 /* Test reset IO */
 static void
 test_reset_io(void)
@@ -1331,6 +1435,29 @@ test_raid_level_conversions(void)
 	CU_ASSERT(raid_str != NULL && strcmp(raid_str, "raid0") == 0);
 }
 
+static void
+test_raid_read_policy_conversions(void)
+{
+	struct raid_bdev *raid_bdev;
+	struct spdk_uuid uuid = {};
+	const char *str;
+
+	CU_ASSERT(raid_bdev_str_to_read_policy("abcd123") == RAID_READ_POLICY_MAX);
+	CU_ASSERT(raid_bdev_str_to_read_policy("least_outstanding") == RAID_READ_POLICY_LEAST_OUTSTANDING);
+	CU_ASSERT(raid_bdev_str_to_read_policy("latency") == RAID_READ_POLICY_LATENCY);
+	CU_ASSERT(raid_bdev_str_to_read_policy("SEQUENTIAL") == RAID_READ_POLICY_SEQUENTIAL);
+
+	str = raid_bdev_read_policy_to_str(RAID_READ_POLICY_MAX);
+	CU_ASSERT(str != NULL && strlen(str) == 0);
+	str = raid_bdev_read_policy_to_str(RAID_READ_POLICY_LATENCY);
+	CU_ASSERT(str != NULL && strcmp(str, "latency") == 0);
+
+	/* read policy is only supported by raid1 */
+	CU_ASSERT(raid_bdev_create("raid1", 64, 2, g_ut_raid_module.level, false, &uuid,
+				   RAID_READ_POLICY_LATENCY, &raid_bdev) == -EINVAL);
+	CU_ASSERT(raid_bdev_find_by_name("raid1") == NULL);
+}
+
 static void
 test_create_raid_superblock(void)
 {
@@ -1787,12 +1914,14 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_create_raid_invalid_args);
 	CU_ADD_TEST(suite, test_delete_raid_invalid_args);
 	CU_ADD_TEST(suite, test_io_channel);
+	CU_ADD_TEST(suite, test_raid_grow);
 	CU_ADD_TEST(suite, test_reset_io);
 	CU_ADD_TEST(suite, test_multi_raid);
 	CU_ADD_TEST(suite, test_io_type_supported);
 	CU_ADD_TEST(suite, test_raid_json_dump_info);
 	CU_ADD_TEST(suite, test_context_size);
 	CU_ADD_TEST(suite, test_raid_level_conversions);
+	CU_ADD_TEST(suite, test_raid_read_policy_conversions);
 	CU_ADD_TEST(suite, test_raid_io_split);
 	CU_ADD_TEST(suite, test_raid_process);
 	CU_ADD_TEST(suite, test_raid_process_with_qos);
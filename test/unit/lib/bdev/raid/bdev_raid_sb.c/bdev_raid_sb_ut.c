@@ -159,6 +159,60 @@ spdk_bdev_write(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 	return 0;
 }
 
+#define TEST_WI_BITMAP_MAX_BLOCKS	8
+
+uint64_t g_wi_bitmap_buf[3][TEST_WI_BITMAP_MAX_BLOCKS * 512 / sizeof(uint64_t)];
+uint64_t g_wi_bitmap_offset_blocks;
+uint64_t g_wi_bitmap_num_blocks;
+
+int
+spdk_bdev_read_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		      void *buf, uint64_t offset_blocks, uint64_t num_blocks,
+		      spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+	uint64_t *src = g_wi_bitmap_buf[(uintptr_t)desc - 1];
+
+	g_read_counter++;
+	CU_ASSERT(offset_blocks == RAID_BDEV_WI_BITMAP_OFFSET / bdev->blocklen);
+	SPDK_CU_ASSERT_FATAL(num_blocks <= TEST_WI_BITMAP_MAX_BLOCKS);
+
+	memcpy(buf, src, num_blocks * bdev->blocklen);
+
+	cb(&g_bdev_io, true, cb_arg);
+	return 0;
+}
+
+int
+spdk_bdev_write_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       void *buf, uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct spdk_bdev *bdev = spdk_bdev_desc_get_bdev(desc);
+	uint64_t bitmap_offset_blocks = RAID_BDEV_WI_BITMAP_OFFSET / bdev->blocklen;
+	void *dest = g_wi_bitmap_buf[(uintptr_t)desc - 1];
+	struct spdk_bdev_io *bdev_io;
+
+	g_write_counter++;
+	SPDK_CU_ASSERT_FATAL(offset_blocks >= bitmap_offset_blocks);
+	SPDK_CU_ASSERT_FATAL(offset_blocks - bitmap_offset_blocks + num_blocks <=
+			     TEST_WI_BITMAP_MAX_BLOCKS);
+	g_wi_bitmap_offset_blocks = offset_blocks - bitmap_offset_blocks;
+	g_wi_bitmap_num_blocks = num_blocks;
+
+	memcpy(dest + g_wi_bitmap_offset_blocks * bdev->blocklen, buf, num_blocks * bdev->blocklen);
+
+	bdev_io = calloc(1, sizeof(*bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->internal.cb = cb;
+	bdev_io->internal.caller_ctx = cb_arg;
+	bdev_io->bdev = bdev;
+
+	TAILQ_INSERT_TAIL(&g_bdev_io_queue, bdev_io, internal.link);
+
+	return 0;
+}
+
 static void
 process_io_completions(void)
 {
@@ -377,6 +431,140 @@ test_raid_bdev_parse_superblock(void)
 	CU_ASSERT(raid_bdev_parse_superblock(&ctx) == -EINVAL);
 }
 
+static void
+wi_bitmap_cb(int status, struct raid_bdev *raid_bdev, void *ctx)
+{
+	int *status_out = ctx;
+
+	*status_out = status;
+}
+
+static void
+test_raid_bdev_wi_bitmap(void)
+{
+	const uint32_t data_block_size = spdk_bdev_get_data_block_size(&g_bdev);
+	const uint64_t region_size = RAID_BDEV_WI_BITMAP_REGION_SIZE_DEFAULT / data_block_size;
+	struct raid_base_bdev_info base_info[3] = {{0}};
+	struct raid_bdev raid_bdev = {
+		.num_base_bdevs = SPDK_COUNTOF(base_info),
+		.base_bdev_info = base_info,
+		.bdev = g_bdev,
+	};
+	struct raid_bdev_wi_bitmap *wi_bitmap;
+	struct raid_bdev_superblock *sb;
+	int status;
+	uint8_t i;
+
+	raid_bdev.bdev.blockcnt = region_size * 100 + 1;
+
+	for (i = 0; i < SPDK_COUNTOF(base_info); i++) {
+		base_info[i].raid_bdev = &raid_bdev;
+		base_info[i].desc = (struct spdk_bdev_desc *)(uintptr_t)(i + 1);
+		base_info[i].data_offset = RAID_BDEV_MIN_DATA_OFFSET_SIZE / data_block_size;
+		base_info[i].is_configured = true;
+	}
+	memset(g_wi_bitmap_buf, 0, sizeof(g_wi_bitmap_buf));
+
+	status = raid_bdev_alloc_superblock(&raid_bdev, data_block_size);
+	CU_ASSERT(status == 0);
+	raid_bdev_init_superblock(&raid_bdev);
+	sb = raid_bdev.sb;
+	/* the first base bdev is missing */
+	sb->base_bdevs[0].state = RAID_SB_BASE_BDEV_MISSING;
+	base_info[0].is_configured = false;
+
+	status = raid_bdev_alloc_wi_bitmap(&raid_bdev);
+	if (spdk_bdev_is_md_interleaved(&raid_bdev.bdev)) {
+		/* not supported with interleaved metadata */
+		CU_ASSERT(status == -ENOTSUP);
+		CU_ASSERT(raid_bdev.wi_bitmap == NULL);
+		CU_ASSERT((sb->flags & RAID_BDEV_SB_FLAG_WI_BITMAP) == 0);
+		raid_bdev_free_superblock(&raid_bdev);
+		return;
+	}
+	CU_ASSERT(status == 0);
+	wi_bitmap = raid_bdev.wi_bitmap;
+	SPDK_CU_ASSERT_FATAL(wi_bitmap != NULL);
+	CU_ASSERT(sb->flags & RAID_BDEV_SB_FLAG_WI_BITMAP);
+	CU_ASSERT(sb->wi_bitmap_offset == RAID_BDEV_WI_BITMAP_OFFSET / data_block_size);
+	CU_ASSERT(sb->wi_bitmap_region_size == region_size);
+	CU_ASSERT(sb->wi_bitmap_num_regions == 101);
+	CU_ASSERT((sb->base_bdevs[0].flags & RAID_SB_BASE_BDEV_FLAG_WI_BITMAP) == 0);
+	CU_ASSERT(sb->base_bdevs[1].flags & RAID_SB_BASE_BDEV_FLAG_WI_BITMAP);
+	CU_ASSERT(sb->base_bdevs[2].flags & RAID_SB_BASE_BDEV_FLAG_WI_BITMAP);
+	CU_ASSERT(wi_bitmap->region_shift == spdk_u64log2(region_size));
+	CU_ASSERT(wi_bitmap->num_blocks == 1);
+
+	/* the whole bitmap is written initially, only to the configured base bdevs */
+	memset(g_wi_bitmap_buf, 0xff, sizeof(g_wi_bitmap_buf));
+	status = INT_MAX;
+	g_write_counter = 0;
+	raid_bdev_write_wi_bitmap(&raid_bdev, wi_bitmap_cb, &status);
+	CU_ASSERT(g_write_counter == 2);
+	process_io_completions();
+	CU_ASSERT(status == 0);
+	CU_ASSERT(g_wi_bitmap_offset_blocks == 0);
+	CU_ASSERT(g_wi_bitmap_num_blocks == 1);
+	CU_ASSERT(g_wi_bitmap_buf[0][0] == UINT64_MAX);
+	CU_ASSERT(g_wi_bitmap_buf[1][0] == 0);
+	CU_ASSERT(g_wi_bitmap_buf[2][0] == 0);
+
+	/* nothing modified - no I/O */
+	status = INT_MAX;
+	g_write_counter = 0;
+	raid_bdev_write_wi_bitmap(&raid_bdev, wi_bitmap_cb, &status);
+	CU_ASSERT(g_write_counter == 0);
+	CU_ASSERT(status == 0);
+
+	/* bitmaps differ between the base bdevs - a region is dirty if set on any of them */
+	g_wi_bitmap_buf[0][0] = 1ULL << 3;
+	g_wi_bitmap_buf[1][0] = 1ULL << 5;
+	g_wi_bitmap_buf[2][1] = 1ULL << (100 - 64);
+	status = INT_MAX;
+	g_read_counter = 0;
+	raid_bdev_load_wi_bitmap(&raid_bdev, wi_bitmap_cb, &status);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(g_read_counter == 2);
+	CU_ASSERT(wi_bitmap->bits[0] == 1ULL << 5);
+	CU_ASSERT(wi_bitmap->bits[1] == 1ULL << (100 - 64));
+
+	raid_bdev_free_wi_bitmap(&raid_bdev);
+	CU_ASSERT(raid_bdev.wi_bitmap == NULL);
+
+	/* the bitmap parameters are taken from the superblock if already set */
+	sb->wi_bitmap_num_regions = TEST_WI_BITMAP_MAX_BLOCKS * data_block_size * 8;
+	status = raid_bdev_alloc_wi_bitmap(&raid_bdev);
+	CU_ASSERT(status == 0);
+	SPDK_CU_ASSERT_FATAL(raid_bdev.wi_bitmap != NULL);
+	CU_ASSERT(raid_bdev.wi_bitmap->num_blocks == 8);
+	raid_bdev_free_wi_bitmap(&raid_bdev);
+
+	/* invalid parameters in the superblock */
+	sb->wi_bitmap_region_size = region_size + 1;
+	status = raid_bdev_alloc_wi_bitmap(&raid_bdev);
+	CU_ASSERT(status == -EINVAL);
+	CU_ASSERT(raid_bdev.wi_bitmap == NULL);
+
+	/* the region size is increased to fit the maximum bitmap size */
+	sb->flags = 0;
+	sb->raid_size = region_size * RAID_BDEV_WI_BITMAP_MAX_SIZE * 8 * 3;
+	status = raid_bdev_alloc_wi_bitmap(&raid_bdev);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(sb->wi_bitmap_region_size == region_size * 4);
+	CU_ASSERT(sb->wi_bitmap_num_regions == RAID_BDEV_WI_BITMAP_MAX_SIZE * 8 * 3 / 4);
+	raid_bdev_free_wi_bitmap(&raid_bdev);
+
+	/* not enough space before the data region */
+	sb->flags = 0;
+	sb->base_bdevs[1].data_offset = RAID_BDEV_WI_BITMAP_OFFSET / data_block_size;
+	status = raid_bdev_alloc_wi_bitmap(&raid_bdev);
+	CU_ASSERT(status == -ENOSPC);
+	CU_ASSERT(raid_bdev.wi_bitmap == NULL);
+	CU_ASSERT((sb->flags & RAID_BDEV_SB_FLAG_WI_BITMAP) == 0);
+
+	raid_bdev_free_superblock(&raid_bdev);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -385,6 +573,7 @@ main(int argc, char **argv)
 		{ "test_raid_bdev_write_superblock", test_raid_bdev_write_superblock },
 		{ "test_raid_bdev_load_base_bdev_superblock", test_raid_bdev_load_base_bdev_superblock },
 		{ "test_raid_bdev_parse_superblock", test_raid_bdev_parse_superblock },
+		{ "test_raid_bdev_wi_bitmap", test_raid_bdev_wi_bitmap },
 		CU_TEST_INFO_NULL,
 	};
 	CU_SuiteInfo suites[] = {
@@ -184,6 +184,8 @@ raid_test_delete_raid_bdev(struct raid_bdev *raid_bdev)
 struct raid_bdev_io_channel {
 	struct spdk_io_channel **_base_channels;
 	struct spdk_io_channel *_module_channel;
+	/* route I/O to the new layout of a reshape */
+	bool _reshaped;
 };
 
 struct spdk_io_channel *
@@ -285,6 +287,18 @@ raid_bdev_io_complete_part(struct raid_bdev_io *raid_io, uint64_t completed,
 	}
 }
 
+uint8_t
+raid_bdev_io_get_num_base_bdevs(struct raid_bdev_io *raid_io)
+{
+	struct raid_bdev *raid_bdev = raid_io->raid_bdev;
+
+	if (raid_bdev->reshape.num_base_bdevs_old != 0 && !raid_io->raid_ch->_reshaped) {
+		return raid_bdev->reshape.num_base_bdevs_old;
+	}
+
+	return raid_bdev->num_base_bdevs;
+}
+
 struct raid_base_bdev_info *
 raid_bdev_channel_get_base_info(struct raid_bdev_io_channel *raid_ch, struct spdk_bdev *base_bdev)
 {
@@ -64,6 +64,13 @@ bool g_succeed;
 DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
 DEFINE_STUB_V(spdk_bdev_free_io, (struct spdk_bdev_io *bdev_io));
 
+int
+spdk_bdev_notify_blockcnt_change(struct spdk_bdev *bdev, uint64_t size)
+{
+	bdev->blockcnt = size;
+	return 0;
+}
+
 int
 spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 			   struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
@@ -454,6 +461,67 @@ test_concat_null_payload(void)
 	}
 }
 
+static void
+test_concat_grow(void)
+{
+	struct raid_bdev *raid_bdev;
+	struct raid_params *params;
+	struct raid_base_bdev_info *base_info;
+	struct concat_block_range *block_range;
+	struct raid_bdev_io *raid_io;
+	struct raid_bdev_io_channel *raid_ch;
+	struct spdk_bdev_desc *desc;
+	struct spdk_bdev *bdev;
+	uint64_t blockcnt;
+	uint8_t idx;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		raid_bdev = create_concat(params);
+		blockcnt = raid_bdev->bdev.blockcnt;
+
+		/* Append a base bdev twice the size of the others */
+		idx = raid_bdev->num_base_bdevs;
+		raid_bdev->base_bdev_info = realloc(raid_bdev->base_bdev_info,
+						    (idx + 1) * sizeof(*base_info));
+		SPDK_CU_ASSERT_FATAL(raid_bdev->base_bdev_info != NULL);
+		base_info = &raid_bdev->base_bdev_info[idx];
+		memset(base_info, 0, sizeof(*base_info));
+
+		bdev = calloc(1, sizeof(*bdev));
+		SPDK_CU_ASSERT_FATAL(bdev != NULL);
+		bdev->blockcnt = params->base_bdev_blockcnt * 2;
+		desc = calloc(1, sizeof(*desc));
+		SPDK_CU_ASSERT_FATAL(desc != NULL);
+		desc->bdev = bdev;
+
+		base_info->raid_bdev = raid_bdev;
+		base_info->desc = desc;
+		base_info->data_size = bdev->blockcnt;
+		raid_bdev->num_base_bdevs++;
+
+		CU_ASSERT(concat_grow(raid_bdev) == 0);
+		block_range = raid_bdev->module_private;
+		CU_ASSERT(block_range[idx].start == blockcnt);
+		CU_ASSERT(block_range[idx].length == params->base_bdev_blockcnt * 2);
+		CU_ASSERT(raid_bdev->bdev.blockcnt == blockcnt + params->base_bdev_blockcnt * 2);
+
+		/* The first block of the new range goes to the new base bdev */
+		init_globals();
+		raid_io = calloc(1, sizeof(*raid_io));
+		SPDK_CU_ASSERT_FATAL(raid_io != NULL);
+		raid_ch = raid_test_create_io_channel(raid_bdev);
+		raid_io_initialize(raid_io, raid_ch, raid_bdev, blockcnt, 1, SPDK_BDEV_IO_TYPE_WRITE);
+		concat_submit_rw_request(raid_io);
+		CU_ASSERT(g_req_records.count == 1);
+		CU_ASSERT(g_req_records.offset_blocks[0] == 0);
+		CU_ASSERT(g_req_records.num_blocks[0] == 1);
+
+		raid_io_cleanup(raid_io);
+		raid_test_destroy_io_channel(raid_ch);
+		delete_concat(raid_bdev);
+	}
+}
+
 int
 main(int argc, char **argv)
 {
@@ -466,6 +534,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_concat_start);
 	CU_ADD_TEST(suite, test_concat_rw);
 	CU_ADD_TEST(suite, test_concat_null_payload);
+	CU_ADD_TEST(suite, test_concat_grow);
 
 	allocate_threads(1);
 	set_thread(0);
@@ -58,6 +58,28 @@ DEFINE_STUB(spdk_bdev_flush_blocks, int, (struct spdk_bdev_desc *desc, struct sp
 DEFINE_STUB(spdk_bdev_is_dif_head_of_md, bool, (const struct spdk_bdev *bdev), false);
 DEFINE_STUB(spdk_bdev_notify_blockcnt_change, int, (struct spdk_bdev *bdev, uint64_t size), 0);
 
+int g_process_req_status;
+uint32_t g_process_req_completed;
+
+void
+raid_bdev_io_init(struct raid_bdev_io *raid_io, struct raid_bdev_io_channel *raid_ch,
+		  enum spdk_bdev_io_type type, uint64_t offset_blocks,
+		  uint64_t num_blocks, struct iovec *iovs, int iovcnt, void *md_buf,
+		  struct spdk_memory_domain *memory_domain, void *memory_domain_ctx)
+{
+	struct raid_bdev *raid_bdev = spdk_io_channel_get_io_device(spdk_io_channel_from_ctx(raid_ch));
+
+	raid_test_bdev_io_init(raid_io, raid_bdev, raid_ch, type, offset_blocks, num_blocks,
+			       iovs, iovcnt, md_buf);
+}
+
+void
+raid_bdev_process_request_complete(struct raid_bdev_process_request *process_req, int status)
+{
+	g_process_req_status = status;
+	g_process_req_completed++;
+}
+
 bool
 spdk_bdev_is_md_interleaved(const struct spdk_bdev *bdev)
 {
@@ -877,6 +899,153 @@ test_io_failure(void)
 	reset_globals();
 }
 
+static int
+reshape_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	struct raid_bdev *raid_bdev = io_device;
+	struct raid_bdev_io_channel *raid_ch = ctx_buf;
+	uint8_t i;
+
+	raid_ch->_base_channels = calloc(raid_bdev->num_base_bdevs, sizeof(struct spdk_io_channel *));
+	SPDK_CU_ASSERT_FATAL(raid_ch->_base_channels != NULL);
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		raid_ch->_base_channels[i] = (void *)1;
+	}
+
+	return 0;
+}
+
+static void
+reshape_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+	struct raid_bdev_io_channel *raid_ch = ctx_buf;
+
+	free(raid_ch->_base_channels);
+}
+
+static void
+verify_reshape_output(struct raid_bdev *raid_bdev, struct io_output *output,
+		      enum spdk_bdev_io_type iotype, uint8_t disk_idx, uint64_t offset_blocks)
+{
+	CU_ASSERT(output->iotype == iotype);
+	CU_ASSERT(output->desc == raid_bdev->base_bdev_info[disk_idx].desc);
+	CU_ASSERT(output->offset_blocks == offset_blocks);
+	CU_ASSERT(output->num_blocks == g_strip_size);
+}
+
+static void
+test_reshape(void)
+{
+	struct raid_bdev *raid_bdev;
+	struct raid_bdev_io *raid_io;
+	struct raid_bdev_io_channel *raid_ch;
+	struct raid_bdev_process_request *process_req;
+	struct spdk_io_channel *ch;
+	struct raid_params params = {
+		.num_base_bdevs = 3,
+		.base_bdev_blockcnt = BLOCK_CNT,
+		.base_bdev_blocklen = g_block_len,
+		.strip_size = g_strip_size,
+		.md_type = g_enable_dif ? RAID_PARAMS_MD_SEPARATE : RAID_PARAMS_MD_NONE,
+	};
+	int ret;
+
+	set_globals();
+
+	/* The third base bdev was added, the data is still laid out on the first two */
+	raid_bdev = raid_test_create_raid_bdev(&params, &g_raid0_module);
+	raid_bdev->reshape.num_base_bdevs_old = 2;
+	SPDK_CU_ASSERT_FATAL(raid0_start(raid_bdev) == 0);
+	CU_ASSERT(raid_bdev->bdev.blockcnt == BLOCK_CNT * 2);
+
+	/* Strip 3 is on the second base bdev in the old layout and on the first in the new one */
+	raid_ch = raid_test_create_io_channel(raid_bdev);
+	raid_io = calloc(1, sizeof(*raid_io));
+	SPDK_CU_ASSERT_FATAL(raid_io != NULL);
+	raid_io_initialize(raid_io, raid_ch, raid_bdev, g_strip_size * 3, 1, SPDK_BDEV_IO_TYPE_READ);
+	g_io_output_index = 0;
+	raid0_submit_rw_request(raid_io);
+	CU_ASSERT(g_io_output_index == 1);
+	CU_ASSERT(g_io_output[0].desc == raid_bdev->base_bdev_info[1].desc);
+	CU_ASSERT(g_io_output[0].offset_blocks == g_strip_size);
+
+	raid_ch->_reshaped = true;
+	g_io_output_index = 0;
+	raid0_submit_rw_request(raid_io);
+	CU_ASSERT(g_io_output_index == 1);
+	CU_ASSERT(g_io_output[0].desc == raid_bdev->base_bdev_info[0].desc);
+	CU_ASSERT(g_io_output[0].offset_blocks == g_strip_size);
+	raid_io_cleanup(raid_io);
+	raid_test_destroy_io_channel(raid_ch);
+
+	/* Process requests move each strip from the old to the new location */
+	spdk_io_device_register(raid_bdev, reshape_ch_create_cb, reshape_ch_destroy_cb,
+				sizeof(struct raid_bdev_io_channel), NULL);
+	ch = spdk_get_io_channel(raid_bdev);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	process_req = calloc(1, sizeof(*process_req));
+	SPDK_CU_ASSERT_FATAL(process_req != NULL);
+	process_req->iov.iov_base = calloc(4 * g_strip_size, g_block_len);
+	SPDK_CU_ASSERT_FATAL(process_req->iov.iov_base != NULL);
+	if (g_enable_dif) {
+		process_req->md_buf = calloc(4 * g_strip_size,
+					     spdk_bdev_get_md_size(&raid_bdev->bdev));
+		SPDK_CU_ASSERT_FATAL(process_req->md_buf != NULL);
+	}
+
+	/* The first row of the new layout can be moved at once */
+	process_req->offset_blocks = 0;
+	process_req->num_blocks = 4 * g_strip_size;
+	g_io_output_index = 0;
+	g_process_req_completed = 0;
+	ret = raid0_submit_process_request(process_req, spdk_io_channel_get_ctx(ch));
+	CU_ASSERT(ret == 3 * (int)g_strip_size);
+	CU_ASSERT(g_process_req_completed == 1);
+	CU_ASSERT(g_process_req_status == 0);
+	CU_ASSERT(g_io_output_index == 6);
+	verify_reshape_output(raid_bdev, &g_io_output[0], SPDK_BDEV_IO_TYPE_READ, 0, 0);
+	verify_reshape_output(raid_bdev, &g_io_output[1], SPDK_BDEV_IO_TYPE_WRITE, 0, 0);
+	verify_reshape_output(raid_bdev, &g_io_output[2], SPDK_BDEV_IO_TYPE_READ, 1, 0);
+	verify_reshape_output(raid_bdev, &g_io_output[3], SPDK_BDEV_IO_TYPE_WRITE, 1, 0);
+	verify_reshape_output(raid_bdev, &g_io_output[4], SPDK_BDEV_IO_TYPE_READ, 0, g_strip_size);
+	verify_reshape_output(raid_bdev, &g_io_output[5], SPDK_BDEV_IO_TYPE_WRITE, 2, 0);
+
+	/* Strip 3 overwrites the old location of strip 2, strip 4 would overwrite strip 3 */
+	process_req->offset_blocks = 3 * g_strip_size;
+	process_req->num_blocks = 4 * g_strip_size;
+	g_io_output_index = 0;
+	g_process_req_completed = 0;
+	ret = raid0_submit_process_request(process_req, spdk_io_channel_get_ctx(ch));
+	CU_ASSERT(ret == (int)g_strip_size);
+	CU_ASSERT(g_process_req_completed == 1);
+	CU_ASSERT(g_io_output_index == 2);
+	verify_reshape_output(raid_bdev, &g_io_output[0], SPDK_BDEV_IO_TYPE_READ, 1, g_strip_size);
+	verify_reshape_output(raid_bdev, &g_io_output[1], SPDK_BDEV_IO_TYPE_WRITE, 0, g_strip_size);
+
+	/* A failed base bdev I/O fails the request */
+	g_child_io_status_flag = false;
+	g_io_output_index = 0;
+	g_process_req_completed = 0;
+	ret = raid0_submit_process_request(process_req, spdk_io_channel_get_ctx(ch));
+	CU_ASSERT(ret == (int)g_strip_size);
+	CU_ASSERT(g_process_req_completed == 1);
+	CU_ASSERT(g_process_req_status == -EIO);
+	CU_ASSERT(g_io_output_index == 1);
+
+	free(process_req->iov.iov_base);
+	free(process_req->md_buf);
+	free(process_req);
+	spdk_put_io_channel(ch);
+	spdk_io_device_unregister(raid_bdev, NULL);
+	poll_threads();
+
+	delete_raid0(raid_bdev);
+
+	reset_globals();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -887,6 +1056,7 @@ main(int argc, char **argv)
 		{ "test_read_io", test_read_io },
 		{ "test_unmap_io", test_unmap_io },
 		{ "test_io_failure", test_io_failure },
+		{ "test_reshape", test_reshape },
 		CU_TEST_INFO_NULL,
 	};
 	CU_SuiteInfo suites[] = {
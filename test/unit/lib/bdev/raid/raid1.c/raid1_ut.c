@@ -502,6 +502,156 @@ test_raid1_read_error(void)
 	run_for_each_raid1_config(_test_raid1_read_error);
 }
 
+static void
+_test_raid1_read_policy_latency(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid1_info *r1_info = raid_bdev->module_private;
+	struct raid1_io_channel *raid1_ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	struct raid_bdev_io *raid_ios[3];
+	struct raid_bdev_io *raid_io;
+	struct spdk_bdev_io bdev_io = {};
+	uint8_t i;
+	int n;
+
+	raid_bdev->read_policy = RAID_READ_POLICY_LATENCY;
+
+	/* base bdevs without a latency sample are selected first */
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		raid_ios[i] = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, 4);
+		raid1_submit_read_request(raid_ios[i]);
+		CU_ASSERT(raid_ios[i]->base_bdev_io_submitted == i);
+	}
+
+	/* the first base bdev is 10 times faster than the others */
+	spdk_delay_us(10);
+	raid1_read_bdev_io_completion(&bdev_io, true, raid_ios[0]);
+	spdk_delay_us(90);
+	for (i = 1; i < raid_bdev->num_base_bdevs; i++) {
+		raid1_read_bdev_io_completion(&bdev_io, true, raid_ios[i]);
+	}
+
+	CU_ASSERT(raid1_ch->base_read[0].latency_ewma == 10);
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		CU_ASSERT(raid1_ch->base_read[i].reads_outstanding == 0);
+		CU_ASSERT(raid1_ch->base_read[i].stats.num_read_ops == 1);
+		CU_ASSERT(raid1_ch->base_read[i].stats.bytes_read == 4 * raid_bdev->bdev.blocklen);
+		CU_ASSERT(raid1_ch->base_read[i].stats.read_latency_ticks == (i == 0 ? 10 : 100));
+		if (i > 0) {
+			CU_ASSERT(raid1_ch->base_read[i].latency_ewma == 100);
+		}
+	}
+
+	/* the fast base bdev takes reads until its queue makes it slower than the others */
+	for (n = 0; n < 10; n++) {
+		raid_io = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, 4);
+		raid1_submit_read_request(raid_io);
+		CU_ASSERT(raid_io->base_bdev_io_submitted == 0);
+		put_raid_io(raid_io);
+	}
+
+	raid_io = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, 4);
+	raid1_submit_read_request(raid_io);
+	CU_ASSERT(raid_io->base_bdev_io_submitted == 1);
+
+	/* a new sample moves the average by 1/8 of the difference */
+	spdk_delay_us(180);
+	raid1_read_bdev_io_completion(&bdev_io, true, raid_io);
+	CU_ASSERT(raid1_ch->base_read[1].latency_ewma == 110);
+}
+
+static void
+test_raid1_read_policy_latency(void)
+{
+	run_for_each_raid1_config(_test_raid1_read_policy_latency);
+}
+
+static void
+submit_read_at(struct raid1_info *r1_info, struct raid_bdev_io_channel *raid_ch,
+	       uint64_t offset_blocks, uint64_t num_blocks, uint8_t expected_idx)
+{
+	struct raid_bdev_io *raid_io;
+
+	raid_io = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, num_blocks);
+	raid_io->offset_blocks = offset_blocks;
+	raid1_submit_read_request(raid_io);
+	CU_ASSERT(raid_io->base_bdev_io_submitted == expected_idx);
+	put_raid_io(raid_io);
+}
+
+static void
+_test_raid1_read_policy_sequential(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid1_info *r1_info = raid_bdev->module_private;
+	uint64_t window = r1_info->sequential_read_window;
+	const uint64_t stream_b = 1024 * 1024;
+
+	raid_bdev->read_policy = RAID_READ_POLICY_SEQUENTIAL;
+
+	/* two streams start on the least loaded base bdevs */
+	submit_read_at(r1_info, raid_ch, 0, 64, 0);
+	submit_read_at(r1_info, raid_ch, stream_b, 8, 1);
+
+	/* and stay there while sequential, even if the base bdev is more loaded */
+	submit_read_at(r1_info, raid_ch, 64, 64, 0);
+	submit_read_at(r1_info, raid_ch, stream_b + 8, 8, 1);
+	submit_read_at(r1_info, raid_ch, 128 + window, 8, 0);
+	submit_read_at(r1_info, raid_ch, stream_b + 16 - window, 8, 1);
+
+	/* a random read goes to the base bdev with the fewest outstanding blocks */
+	submit_read_at(r1_info, raid_ch, stream_b / 2, 8, raid_bdev->num_base_bdevs == 2 ? 1 : 2);
+}
+
+static void
+test_raid1_read_policy_sequential(void)
+{
+	run_for_each_raid1_config(_test_raid1_read_policy_sequential);
+}
+
+static void
+_test_raid1_read_stats(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid1_info *r1_info = raid_bdev->module_private;
+	struct raid_base_bdev_read_stats stats[3] = {};
+	struct raid_bdev_io_channel *raid_ch2;
+	struct raid_bdev_io *raid_io;
+	struct spdk_bdev_io bdev_io = {};
+
+	raid_io = get_raid_io(r1_info, raid_ch, SPDK_BDEV_IO_TYPE_READ, 8);
+	raid1_submit_read_request(raid_io);
+	CU_ASSERT(raid_io->base_bdev_io_submitted == 0);
+	spdk_delay_us(5);
+	raid1_read_bdev_io_completion(&bdev_io, true, raid_io);
+
+	/* statistics of a destroyed channel are retained */
+	set_thread(1);
+	raid_ch2 = raid_test_create_io_channel(raid_bdev);
+	raid_io = get_raid_io(r1_info, raid_ch2, SPDK_BDEV_IO_TYPE_READ, 16);
+	raid1_submit_read_request(raid_io);
+	CU_ASSERT(raid_io->base_bdev_io_submitted == 0);
+	spdk_delay_us(7);
+	raid1_read_bdev_io_completion(&bdev_io, true, raid_io);
+	raid_test_destroy_io_channel(raid_ch2);
+	set_thread(0);
+
+	raid1_get_read_stats(raid_bdev, raid_ch, stats);
+	CU_ASSERT(stats[0].num_read_ops == 1);
+	CU_ASSERT(stats[0].bytes_read == 8 * raid_bdev->bdev.blocklen);
+	CU_ASSERT(stats[0].read_latency_ticks == 5);
+
+	raid1_get_read_stats(raid_bdev, NULL, stats);
+	CU_ASSERT(stats[0].num_read_ops == 2);
+	CU_ASSERT(stats[0].bytes_read == 24 * raid_bdev->bdev.blocklen);
+	CU_ASSERT(stats[0].read_latency_ticks == 12);
+	CU_ASSERT(stats[1].num_read_ops == 0);
+	CU_ASSERT(stats[1].bytes_read == 0);
+}
+
+static void
+test_raid1_read_stats(void)
+{
+	run_for_each_raid1_config(_test_raid1_read_stats);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -515,8 +665,11 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_raid1_read_balancing);
 	CU_ADD_TEST(suite, test_raid1_write_error);
 	CU_ADD_TEST(suite, test_raid1_read_error);
+	CU_ADD_TEST(suite, test_raid1_read_policy_latency);
+	CU_ADD_TEST(suite, test_raid1_read_policy_sequential);
+	CU_ADD_TEST(suite, test_raid1_read_stats);
 
-	allocate_threads(1);
+	allocate_threads(2);
 	set_thread(0);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
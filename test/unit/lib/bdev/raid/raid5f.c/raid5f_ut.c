@@ -224,6 +224,10 @@ struct raid_io_info {
 	size_t parity_md_buf_size;
 	void *degraded_buf;
 	void *degraded_md_buf;
+	void *stripe_buf;
+	void *reference_stripe_buf;
+	void *stripe_md_buf;
+	void *reference_stripe_md_buf;
 	enum spdk_bdev_io_status status;
 	TAILQ_HEAD(, spdk_bdev_io) bdev_io_queue;
 	TAILQ_HEAD(, spdk_bdev_io_wait_entry) bdev_io_wait_queue;
@@ -397,6 +401,45 @@ process_io_completions(struct raid_io_info *io_info)
 	}
 }
 
+static int
+spdk_bdev_rw_blocks_partial_write(struct spdk_bdev_desc *desc, struct iovec *iov, int iovcnt,
+				  void *md_buf, uint64_t offset_blocks, uint64_t num_blocks,
+				  spdk_bdev_io_completion_cb cb, void *cb_arg, bool write)
+{
+	struct chunk *chunk = cb_arg;
+	struct stripe_request *stripe_req = raid5f_chunk_stripe_req(chunk);
+	struct test_raid_bdev_io *test_raid_bdev_io = SPDK_CONTAINEROF(stripe_req->raid_io,
+			struct test_raid_bdev_io, raid_io);
+	struct raid_io_info *io_info = test_raid_bdev_io->io_info;
+	struct raid_bdev *raid_bdev = io_info->r5f_info->raid_bdev;
+	uint64_t chunk_offset = offset_blocks % raid_bdev->strip_size;
+	uint64_t block = chunk->index * raid_bdev->strip_size + chunk_offset;
+	struct iovec buf;
+
+	CU_ASSERT(offset_blocks >> raid_bdev->strip_size_shift == stripe_req->stripe_index);
+	CU_ASSERT(chunk_offset + num_blocks <= raid_bdev->strip_size);
+	CU_ASSERT(raid_bdev_channel_get_base_channel(io_info->raid_ch, chunk->index) != NULL);
+
+	buf.iov_base = io_info->stripe_buf + block * raid_bdev->bdev.blocklen;
+	buf.iov_len = num_blocks * raid_bdev->bdev.blocklen;
+
+	if (write) {
+		spdk_iovcpy(iov, iovcnt, &buf, 1);
+		if (md_buf != NULL) {
+			memcpy(io_info->stripe_md_buf + block * raid_bdev->bdev.md_len, md_buf,
+			       num_blocks * raid_bdev->bdev.md_len);
+		}
+	} else {
+		spdk_iovcpy(&buf, 1, iov, iovcnt);
+		if (md_buf != NULL) {
+			memcpy(md_buf, io_info->stripe_md_buf + block * raid_bdev->bdev.md_len,
+			       num_blocks * raid_bdev->bdev.md_len);
+		}
+	}
+
+	return submit_io(io_info, desc, cb, cb_arg);
+}
+
 int
 spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
 				struct iovec *iov, int iovcnt, void *md_buf,
@@ -417,6 +460,11 @@ spdk_bdev_writev_blocks_with_md(struct spdk_bdev_desc *desc, struct spdk_io_chan
 	SPDK_CU_ASSERT_FATAL(cb == raid5f_chunk_complete_bdev_io);
 
 	stripe_req = raid5f_chunk_stripe_req(chunk);
+	if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+		return spdk_bdev_rw_blocks_partial_write(desc, iov, iovcnt, md_buf, offset_blocks,
+				num_blocks, cb, cb_arg, true);
+	}
+
 	test_raid_bdev_io = SPDK_CONTAINEROF(stripe_req->raid_io, struct test_raid_bdev_io, raid_io);
 	io_info = test_raid_bdev_io->io_info;
 	r5f_info = io_info->r5f_info;
@@ -468,6 +516,11 @@ spdk_bdev_readv_blocks_degraded(struct spdk_bdev_desc *desc, struct spdk_io_chan
 	SPDK_CU_ASSERT_FATAL(cb == raid5f_chunk_complete_bdev_io);
 
 	stripe_req = raid5f_chunk_stripe_req(chunk);
+	if (stripe_req->type == STRIPE_REQ_PARTIAL_WRITE) {
+		return spdk_bdev_rw_blocks_partial_write(desc, iov, iovcnt, md_buf, offset_blocks,
+				num_blocks, cb, cb_arg, false);
+	}
+
 	test_raid_bdev_io = SPDK_CONTAINEROF(stripe_req->raid_io, struct test_raid_bdev_io, raid_io);
 	io_info = test_raid_bdev_io->io_info;
 	raid_bdev = io_info->r5f_info->raid_bdev;
@@ -676,6 +729,10 @@ deinit_io_info(struct raid_io_info *io_info)
 	free(io_info->reference_md_parity);
 	free(io_info->degraded_buf);
 	free(io_info->degraded_md_buf);
+	free(io_info->stripe_buf);
+	free(io_info->reference_stripe_buf);
+	free(io_info->stripe_md_buf);
+	free(io_info->reference_stripe_md_buf);
 }
 
 static void
@@ -826,6 +883,163 @@ io_info_setup_degraded(struct raid_io_info *io_info)
 	}
 }
 
+static void
+stripe_calc_parity(struct raid_bdev *raid_bdev, uint64_t stripe_index, void *stripe, size_t strip_len)
+{
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, stripe_index);
+	void *parity = stripe + p_idx * strip_len;
+	uint8_t i;
+
+	memset(parity, 0, strip_len);
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (i != p_idx) {
+			xor_block(parity, stripe + i * strip_len, strip_len);
+		}
+	}
+}
+
+static void
+io_info_update_reference_stripe(struct raid_io_info *ref_io_info, struct raid_io_info *io_info)
+{
+	struct raid_bdev *raid_bdev = ref_io_info->r5f_info->raid_bdev;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	uint32_t md_len = raid_bdev->bdev.md_len;
+	uint8_t p_idx = raid5f_stripe_parity_chunk_index(raid_bdev, ref_io_info->stripe_index);
+	uint64_t block;
+
+	for (block = 0; block < io_info->num_blocks; block++) {
+		uint64_t stripe_block = io_info->stripe_offset_blocks + block;
+		uint8_t chunk_idx = stripe_block / raid_bdev->strip_size;
+		uint64_t base_block;
+
+		if (chunk_idx >= p_idx) {
+			chunk_idx++;
+		}
+		base_block = chunk_idx * raid_bdev->strip_size + stripe_block % raid_bdev->strip_size;
+
+		memcpy(ref_io_info->reference_stripe_buf + base_block * blocklen,
+		       io_info->src_buf + block * blocklen, blocklen);
+		if (io_info->src_md_buf != NULL) {
+			memcpy(ref_io_info->reference_stripe_md_buf + base_block * md_len,
+			       io_info->src_md_buf + block * md_len, md_len);
+		}
+	}
+
+	stripe_calc_parity(raid_bdev, ref_io_info->stripe_index, ref_io_info->reference_stripe_buf,
+			   raid_bdev->strip_size * blocklen);
+	if (ref_io_info->reference_stripe_md_buf != NULL) {
+		stripe_calc_parity(raid_bdev, ref_io_info->stripe_index, ref_io_info->reference_stripe_md_buf,
+				   raid_bdev->strip_size * md_len);
+	}
+}
+
+static void
+io_info_setup_stripe(struct raid_io_info *io_info)
+{
+	struct raid_bdev *raid_bdev = io_info->r5f_info->raid_bdev;
+	size_t strip_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	size_t strip_md_len = io_info->src_md_buf ? raid_bdev->strip_size * raid_bdev->bdev.md_len : 0;
+	size_t stripe_len = strip_len * raid_bdev->num_base_bdevs;
+	size_t stripe_md_len = strip_md_len * raid_bdev->num_base_bdevs;
+	size_t i;
+
+	io_info->stripe_buf = malloc(stripe_len);
+	SPDK_CU_ASSERT_FATAL(io_info->stripe_buf != NULL);
+
+	io_info->reference_stripe_buf = malloc(stripe_len);
+	SPDK_CU_ASSERT_FATAL(io_info->reference_stripe_buf != NULL);
+
+	for (i = 0; i < stripe_len; i++) {
+		*((uint8_t *)(io_info->stripe_buf + i)) = rand();
+	}
+	stripe_calc_parity(raid_bdev, io_info->stripe_index, io_info->stripe_buf, strip_len);
+	memcpy(io_info->reference_stripe_buf, io_info->stripe_buf, stripe_len);
+
+	if (stripe_md_len != 0) {
+		io_info->stripe_md_buf = malloc(stripe_md_len);
+		SPDK_CU_ASSERT_FATAL(io_info->stripe_md_buf != NULL);
+
+		io_info->reference_stripe_md_buf = malloc(stripe_md_len);
+		SPDK_CU_ASSERT_FATAL(io_info->reference_stripe_md_buf != NULL);
+
+		for (i = 0; i < stripe_md_len; i++) {
+			*((uint8_t *)(io_info->stripe_md_buf + i)) = rand();
+		}
+		stripe_calc_parity(raid_bdev, io_info->stripe_index, io_info->stripe_md_buf, strip_md_len);
+		memcpy(io_info->reference_stripe_md_buf, io_info->stripe_md_buf, stripe_md_len);
+	}
+
+	io_info_update_reference_stripe(io_info, io_info);
+
+	/* The missing base bdev's data must not be used */
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (!raid_bdev_channel_get_base_channel(io_info->raid_ch, i)) {
+			memset(io_info->stripe_buf + i * strip_len, 0xcd, strip_len);
+			if (stripe_md_len != 0) {
+				memset(io_info->stripe_md_buf + i * strip_md_len, 0xcd, strip_md_len);
+			}
+		}
+	}
+}
+
+static void
+io_info_verify_stripe(struct raid_io_info *io_info)
+{
+	struct raid_bdev *raid_bdev = io_info->r5f_info->raid_bdev;
+	size_t strip_len = raid_bdev->strip_size * raid_bdev->bdev.blocklen;
+	size_t strip_md_len = raid_bdev->strip_size * raid_bdev->bdev.md_len;
+	uint8_t i;
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		if (!raid_bdev_channel_get_base_channel(io_info->raid_ch, i)) {
+			continue;
+		}
+
+		CU_ASSERT(memcmp(io_info->stripe_buf + i * strip_len,
+				 io_info->reference_stripe_buf + i * strip_len, strip_len) == 0);
+		if (io_info->stripe_md_buf != NULL) {
+			CU_ASSERT(memcmp(io_info->stripe_md_buf + i * strip_md_len,
+					 io_info->reference_stripe_md_buf + i * strip_md_len, strip_md_len) == 0);
+		}
+	}
+}
+
+static void
+test_raid5f_partial_write_request(struct raid_io_info *io_info)
+{
+	struct raid_bdev_io *raid_io;
+	int i;
+
+	raid_io = get_raid_io(io_info);
+
+	raid5f_submit_rw_request(raid_io);
+
+	/* reads, xor (twice when reconstructing a missing chunk) and writes */
+	for (i = 0; i < 4 && io_info->status == SPDK_BDEV_IO_STATUS_PENDING; i++) {
+		process_io_completions(io_info);
+		poll_threads();
+	}
+}
+
+static void
+test_raid5f_submit_partial_write(struct raid5f_info *r5f_info, struct raid_bdev_io_channel *raid_ch,
+				 uint64_t stripe_index, uint64_t stripe_offset_blocks, uint64_t num_blocks)
+{
+	struct raid_io_info io_info;
+
+	init_io_info(&io_info, r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_WRITE, stripe_index,
+		     stripe_offset_blocks, num_blocks);
+	io_info_setup_stripe(&io_info);
+
+	test_raid5f_partial_write_request(&io_info);
+
+	CU_ASSERT(io_info.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	io_info_verify_stripe(&io_info);
+
+	deinit_io_info(&io_info);
+}
+
 static void
 test_raid5f_submit_rw_request(struct raid5f_info *r5f_info, struct raid_bdev_io_channel *raid_ch,
 			      enum spdk_bdev_io_type io_type, uint64_t stripe_index, uint64_t stripe_offset_blocks,
@@ -1004,6 +1218,161 @@ test_raid5f_submit_full_stripe_write_request(void)
 	run_for_each_raid5f_config(__test_raid5f_submit_full_stripe_write_request);
 }
 
+static void
+__test_raid5f_submit_partial_stripe_write_request(struct raid_bdev *raid_bdev,
+		struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	uint32_t strip_size = raid_bdev->strip_size;
+	uint64_t stripe_blocks = r5f_info->stripe_blocks;
+	uint64_t stripe_index;
+
+	RAID5F_TEST_FOR_EACH_STRIPE(raid_bdev, stripe_index) {
+		test_raid5f_submit_partial_write(r5f_info, raid_ch, stripe_index, 0, 1);
+		test_raid5f_submit_partial_write(r5f_info, raid_ch, stripe_index, stripe_blocks - 1, 1);
+		test_raid5f_submit_partial_write(r5f_info, raid_ch, stripe_index, 0, strip_size);
+		test_raid5f_submit_partial_write(r5f_info, raid_ch, stripe_index, strip_size,
+						 stripe_blocks - strip_size);
+		test_raid5f_submit_partial_write(r5f_info, raid_ch, stripe_index, 1, stripe_blocks - 1);
+		test_raid5f_submit_partial_write(r5f_info, raid_ch, stripe_index, 0, stripe_blocks - 1);
+		if (strip_size <= 2) {
+			continue;
+		}
+		test_raid5f_submit_partial_write(r5f_info, raid_ch, stripe_index, strip_size / 2,
+						 strip_size);
+		test_raid5f_submit_partial_write(r5f_info, raid_ch, stripe_index, 1, stripe_blocks - 2);
+	}
+}
+
+static void
+test_raid5f_submit_partial_stripe_write_request(void)
+{
+	run_for_each_raid5f_config(__test_raid5f_submit_partial_stripe_write_request);
+}
+
+static void
+__test_raid5f_partial_write_stripe_conflict(struct raid_bdev *raid_bdev,
+		struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_io_channel *r5ch = raid_bdev_channel_get_module_ctx(raid_ch);
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	struct raid_io_info io_info1, io_info2;
+	int i;
+
+	init_io_info(&io_info1, r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_WRITE, 0, 0, 1);
+	init_io_info(&io_info2, r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_WRITE, 0,
+		     r5f_info->stripe_blocks - 1, 1);
+	memset(io_info2.src_buf, 0x5a, io_info2.buf_size);
+
+	io_info_setup_stripe(&io_info1);
+	io_info2.stripe_buf = io_info1.stripe_buf;
+	io_info2.stripe_md_buf = io_info1.stripe_md_buf;
+	io_info_update_reference_stripe(&io_info1, &io_info2);
+
+	raid5f_submit_rw_request(get_raid_io(&io_info1));
+	raid5f_submit_rw_request(get_raid_io(&io_info2));
+
+	/* The second write must wait for the first one to complete */
+	CU_ASSERT(!TAILQ_EMPTY(&r5ch->stripe_wait_queue));
+	CU_ASSERT(TAILQ_EMPTY(&io_info2.bdev_io_queue));
+
+	for (i = 0; i < 8 && (io_info1.status == SPDK_BDEV_IO_STATUS_PENDING ||
+			      io_info2.status == SPDK_BDEV_IO_STATUS_PENDING); i++) {
+		process_io_completions(&io_info1);
+		process_io_completions(&io_info2);
+		poll_threads();
+	}
+
+	CU_ASSERT(io_info1.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(io_info2.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(TAILQ_EMPTY(&r5ch->stripe_wait_queue));
+	CU_ASSERT(TAILQ_EMPTY(&r5f_info->active_stripe_requests[0]));
+	io_info_verify_stripe(&io_info1);
+
+	io_info2.stripe_buf = NULL;
+	io_info2.stripe_md_buf = NULL;
+	deinit_io_info(&io_info1);
+	deinit_io_info(&io_info2);
+}
+static void
+test_raid5f_partial_write_stripe_conflict(void)
+{
+	run_for_each_raid5f_config(__test_raid5f_partial_write_stripe_conflict);
+}
+
+static void
+__test_raid5f_partial_write_stripe_conflict_channels(struct raid_bdev *raid_bdev,
+		struct raid_bdev_io_channel *raid_ch)
+{
+	struct raid5f_info *r5f_info = raid_bdev->module_private;
+	struct raid_bdev_io_channel *raid_ch2;
+	struct raid5f_io_channel *r5ch2;
+	struct raid_io_info io_info1, io_info2;
+	int i;
+
+	/* The second write goes through an io channel of another thread */
+	set_thread(1);
+	raid_ch2 = raid_test_create_io_channel(raid_bdev);
+	r5ch2 = raid_bdev_channel_get_module_ctx(raid_ch2);
+	set_thread(0);
+	/* Partial write stripe requests are allocated on first use */
+	CU_ASSERT(r5ch2->num_partial_write_reqs == 0);
+	CU_ASSERT(TAILQ_EMPTY(&r5ch2->free_stripe_requests.partial_write));
+
+	init_io_info(&io_info1, r5f_info, raid_ch, SPDK_BDEV_IO_TYPE_WRITE, 0, 0, 1);
+	init_io_info(&io_info2, r5f_info, raid_ch2, SPDK_BDEV_IO_TYPE_WRITE, 0,
+		     r5f_info->stripe_blocks - 1, 1);
+	memset(io_info2.src_buf, 0x5a, io_info2.buf_size);
+
+	io_info_setup_stripe(&io_info1);
+	io_info2.stripe_buf = io_info1.stripe_buf;
+	io_info2.stripe_md_buf = io_info1.stripe_md_buf;
+	io_info_update_reference_stripe(&io_info1, &io_info2);
+
+	raid5f_submit_rw_request(get_raid_io(&io_info1));
+	set_thread(1);
+	raid5f_submit_rw_request(get_raid_io(&io_info2));
+	set_thread(0);
+
+	/* The second write must wait for the first one to complete on the other channel */
+	CU_ASSERT(!TAILQ_EMPTY(&r5ch2->stripe_wait_queue));
+	CU_ASSERT(TAILQ_EMPTY(&io_info2.bdev_io_queue));
+	CU_ASSERT(r5ch2->stripe_waiting);
+	CU_ASSERT(TAILQ_FIRST(&r5f_info->stripe_waiters) == r5ch2);
+
+	for (i = 0; i < 8 && (io_info1.status == SPDK_BDEV_IO_STATUS_PENDING ||
+			      io_info2.status == SPDK_BDEV_IO_STATUS_PENDING); i++) {
+		process_io_completions(&io_info1);
+		set_thread(1);
+		process_io_completions(&io_info2);
+		set_thread(0);
+		poll_threads();
+	}
+
+	CU_ASSERT(io_info1.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(io_info2.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(TAILQ_EMPTY(&r5ch2->stripe_wait_queue));
+	CU_ASSERT(!r5ch2->stripe_waiting);
+	CU_ASSERT(TAILQ_EMPTY(&r5f_info->stripe_waiters));
+	CU_ASSERT(TAILQ_EMPTY(&r5f_info->active_stripe_requests[0]));
+	CU_ASSERT(r5ch2->num_partial_write_reqs == 1);
+	io_info_verify_stripe(&io_info1);
+
+	io_info2.stripe_buf = NULL;
+	io_info2.stripe_md_buf = NULL;
+	deinit_io_info(&io_info1);
+	deinit_io_info(&io_info2);
+
+	set_thread(1);
+	raid_test_destroy_io_channel(raid_ch2);
+	set_thread(0);
+}
+static void
+test_raid5f_partial_write_stripe_conflict_channels(void)
+{
+	run_for_each_raid5f_config(__test_raid5f_partial_write_stripe_conflict_channels);
+}
+
 static void
 __test_raid5f_chunk_write_error(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch)
 {
@@ -1115,6 +1484,13 @@ test_raid5f_submit_read_request_degraded(void)
 	run_for_each_raid5f_config(__test_raid5f_submit_read_request);
 }
 
+static void
+test_raid5f_submit_partial_stripe_write_request_degraded(void)
+{
+	g_test_degraded = true;
+	run_for_each_raid5f_config(__test_raid5f_submit_partial_stripe_write_request);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1133,8 +1509,12 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_raid5f_chunk_write_error_with_enomem);
 	CU_ADD_TEST(suite, test_raid5f_submit_full_stripe_write_request_degraded);
 	CU_ADD_TEST(suite, test_raid5f_submit_read_request_degraded);
+	CU_ADD_TEST(suite, test_raid5f_submit_partial_stripe_write_request);
+	CU_ADD_TEST(suite, test_raid5f_submit_partial_stripe_write_request_degraded);
+	CU_ADD_TEST(suite, test_raid5f_partial_write_stripe_conflict);
+	CU_ADD_TEST(suite, test_raid5f_partial_write_stripe_conflict_channels);
 
-	allocate_threads(1);
+	allocate_threads(2);
 	set_thread(0);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
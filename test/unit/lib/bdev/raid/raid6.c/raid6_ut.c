@@ -0,0 +1,629 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "spdk/env.h"
+
+#include "common/lib/ut_multithread.c"
+
+#include "bdev/raid/raid6.c"
+#include "../common.c"
+
+DEFINE_STUB_V(raid_bdev_module_list_add, (struct raid_bdev_module *raid_module));
+DEFINE_STUB(spdk_bdev_get_buf_align, size_t, (const struct spdk_bdev *bdev), 0);
+DEFINE_STUB_V(raid_bdev_module_stop_done, (struct raid_bdev *raid_bdev));
+DEFINE_STUB_V(raid_bdev_process_request_complete, (struct raid_bdev_process_request *process_req,
+		int status));
+DEFINE_STUB_V(raid_bdev_io_init, (struct raid_bdev_io *raid_io,
+				  struct raid_bdev_io_channel *raid_ch,
+				  enum spdk_bdev_io_type type, uint64_t offset_blocks,
+				  uint64_t num_blocks, struct iovec *iovs, int iovcnt, void *md_buf,
+				  struct spdk_memory_domain *memory_domain, void *memory_domain_ctx));
+DEFINE_STUB(raid_bdev_remap_dix_reftag, int, (void *md_buf, uint64_t num_blocks,
+		struct spdk_bdev *bdev, uint32_t remapped_offset), -1);
+
+/* Contents of the base bdevs */
+static void **g_base_bdev_data;
+static void **g_base_bdev_md;
+
+static TAILQ_HEAD(, spdk_bdev_io) g_bdev_io_queue = TAILQ_HEAD_INITIALIZER(g_bdev_io_queue);
+static enum spdk_bdev_io_status g_io_status;
+static int g_reconstruct_status;
+
+static int
+test_suite_init(void)
+{
+	uint8_t num_base_bdevs_values[] = { 4, 5, 6 };
+	uint64_t base_bdev_blockcnt_values[] = { 1, 64, 1024 };
+	uint32_t base_bdev_blocklen_values[] = { 512, 4096 };
+	uint32_t strip_size_kb_values[] = { 1, 4, 16 };
+	enum raid_params_md_type md_type_values[] = { RAID_PARAMS_MD_NONE, RAID_PARAMS_MD_SEPARATE, RAID_PARAMS_MD_INTERLEAVED };
+	uint8_t *num_base_bdevs;
+	uint64_t *base_bdev_blockcnt;
+	uint32_t *base_bdev_blocklen;
+	uint32_t *strip_size_kb;
+	enum raid_params_md_type *md_type;
+	uint64_t params_count;
+	int rc;
+
+	params_count = SPDK_COUNTOF(num_base_bdevs_values) *
+		       SPDK_COUNTOF(base_bdev_blockcnt_values) *
+		       SPDK_COUNTOF(base_bdev_blocklen_values) *
+		       SPDK_COUNTOF(strip_size_kb_values) *
+		       SPDK_COUNTOF(md_type_values);
+	rc = raid_test_params_alloc(params_count);
+	if (rc) {
+		return rc;
+	}
+
+	ARRAY_FOR_EACH(num_base_bdevs_values, num_base_bdevs) {
+		ARRAY_FOR_EACH(base_bdev_blockcnt_values, base_bdev_blockcnt) {
+			ARRAY_FOR_EACH(base_bdev_blocklen_values, base_bdev_blocklen) {
+				ARRAY_FOR_EACH(strip_size_kb_values, strip_size_kb) {
+					ARRAY_FOR_EACH(md_type_values, md_type) {
+						struct raid_params params = {
+							.num_base_bdevs = *num_base_bdevs,
+							.base_bdev_blockcnt = *base_bdev_blockcnt,
+							.base_bdev_blocklen = *base_bdev_blocklen,
+							.strip_size = *strip_size_kb * 1024 / *base_bdev_blocklen,
+							.md_type = *md_type,
+						};
+						if (params.strip_size == 0 ||
+						    params.strip_size > params.base_bdev_blockcnt) {
+							continue;
+						}
+						raid_test_params_add(&params);
+					}
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int
+test_suite_cleanup(void)
+{
+	raid_test_params_free();
+	return 0;
+}
+
+static struct raid6_info *
+create_raid6(struct raid_params *params)
+{
+	struct raid_bdev *raid_bdev = raid_test_create_raid_bdev(params, &g_raid6_module);
+	uint8_t i;
+
+	SPDK_CU_ASSERT_FATAL(raid6_start(raid_bdev) == 0);
+
+	g_base_bdev_data = calloc(raid_bdev->num_base_bdevs, sizeof(void *));
+	g_base_bdev_md = calloc(raid_bdev->num_base_bdevs, sizeof(void *));
+	SPDK_CU_ASSERT_FATAL(g_base_bdev_data != NULL && g_base_bdev_md != NULL);
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		g_base_bdev_data[i] = calloc(params->base_bdev_blockcnt, raid_bdev->bdev.blocklen);
+		SPDK_CU_ASSERT_FATAL(g_base_bdev_data[i] != NULL);
+		if (raid_bdev->bdev.md_len != 0 && !raid_bdev->bdev.md_interleave) {
+			g_base_bdev_md[i] = calloc(params->base_bdev_blockcnt, raid_bdev->bdev.md_len);
+			SPDK_CU_ASSERT_FATAL(g_base_bdev_md[i] != NULL);
+		}
+	}
+
+	return raid_bdev->module_private;
+}
+
+static void
+delete_raid6(struct raid6_info *r6_info)
+{
+	struct raid_bdev *raid_bdev = r6_info->raid_bdev;
+	uint8_t i;
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		free(g_base_bdev_data[i]);
+		free(g_base_bdev_md[i]);
+	}
+	free(g_base_bdev_data);
+	free(g_base_bdev_md);
+
+	raid6_stop(raid_bdev);
+
+	raid_test_delete_raid_bdev(raid_bdev);
+}
+
+static void
+test_raid6_start(void)
+{
+	struct raid_params *params;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		struct raid6_info *r6_info;
+
+		r6_info = create_raid6(params);
+
+		SPDK_CU_ASSERT_FATAL(r6_info != NULL);
+
+		CU_ASSERT_EQUAL(r6_info->stripe_blocks, params->strip_size * (params->num_base_bdevs - 2));
+		CU_ASSERT_EQUAL(r6_info->total_stripes, params->base_bdev_blockcnt / params->strip_size);
+		CU_ASSERT_EQUAL(r6_info->raid_bdev->bdev.blockcnt,
+				(params->base_bdev_blockcnt - params->base_bdev_blockcnt % params->strip_size) *
+				(params->num_base_bdevs - 2));
+		CU_ASSERT_EQUAL(r6_info->raid_bdev->bdev.optimal_io_boundary, params->strip_size);
+		CU_ASSERT_TRUE(r6_info->raid_bdev->bdev.split_on_optimal_io_boundary);
+		CU_ASSERT_EQUAL(r6_info->raid_bdev->bdev.write_unit_size, r6_info->stripe_blocks);
+		CU_ASSERT_TRUE(r6_info->raid_bdev->bdev.split_on_write_unit);
+
+		delete_raid6(r6_info);
+	}
+}
+
+void
+raid_bdev_queue_io_wait(struct raid_bdev_io *raid_io, struct spdk_bdev *bdev,
+			struct spdk_io_channel *ch, spdk_bdev_io_wait_cb cb_fn)
+{
+	CU_FAIL("unexpected raid_bdev_queue_io_wait");
+}
+
+void
+raid_test_bdev_io_complete(struct raid_bdev_io *raid_io, enum spdk_bdev_io_status status)
+{
+	g_io_status = status;
+
+	free(raid_io->iovs);
+	free(raid_io);
+}
+
+void
+spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
+{
+	free(bdev_io);
+}
+
+static void
+process_io_completions(void)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	while ((bdev_io = TAILQ_FIRST(&g_bdev_io_queue))) {
+		TAILQ_REMOVE(&g_bdev_io_queue, bdev_io, internal.link);
+
+		bdev_io->internal.cb(bdev_io, true, bdev_io->internal.caller_ctx);
+	}
+}
+
+static int
+base_bdev_rw(struct spdk_bdev_desc *desc, struct iovec *iov, int iovcnt, void *md_buf,
+	     uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
+	     bool write)
+{
+	struct spdk_bdev *bdev = desc->bdev;
+	struct raid_base_bdev_info *base_info = bdev->ctxt;
+	uint8_t slot = base_info - base_info->raid_bdev->base_bdev_info;
+	struct spdk_bdev_io *bdev_io;
+	struct iovec buf;
+
+	SPDK_CU_ASSERT_FATAL(offset_blocks + num_blocks <= bdev->blockcnt);
+
+	buf.iov_base = g_base_bdev_data[slot] + offset_blocks * bdev->blocklen;
+	buf.iov_len = num_blocks * bdev->blocklen;
+
+	if (write) {
+		CU_ASSERT(spdk_iovcpy(iov, iovcnt, &buf, 1) == buf.iov_len);
+		if (md_buf != NULL) {
+			memcpy(g_base_bdev_md[slot] + offset_blocks * bdev->md_len, md_buf,
+			       num_blocks * bdev->md_len);
+		}
+	} else {
+		CU_ASSERT(spdk_iovcpy(&buf, 1, iov, iovcnt) == buf.iov_len);
+		if (md_buf != NULL) {
+			memcpy(md_buf, g_base_bdev_md[slot] + offset_blocks * bdev->md_len,
+			       num_blocks * bdev->md_len);
+		}
+	}
+
+	bdev_io = calloc(1, sizeof(*bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->bdev = bdev;
+	bdev_io->internal.cb = cb;
+	bdev_io->internal.caller_ctx = cb_arg;
+
+	TAILQ_INSERT_TAIL(&g_bdev_io_queue, bdev_io, internal.link);
+
+	return 0;
+}
+
+int
+spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			    struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+			    uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
+			    struct spdk_bdev_ext_io_opts *opts)
+{
+	CU_ASSERT_PTR_NULL(opts->memory_domain);
+	CU_ASSERT_PTR_NULL(opts->memory_domain_ctx);
+	CU_ASSERT(ch != NULL);
+
+	return base_bdev_rw(desc, iov, iovcnt, opts->metadata, offset_blocks, num_blocks, cb, cb_arg,
+			    true);
+}
+
+int
+spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			   struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+			   uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg,
+			   struct spdk_bdev_ext_io_opts *opts)
+{
+	CU_ASSERT_PTR_NULL(opts->memory_domain);
+	CU_ASSERT_PTR_NULL(opts->memory_domain_ctx);
+	CU_ASSERT(ch != NULL);
+
+	return base_bdev_rw(desc, iov, iovcnt, opts->metadata, offset_blocks, num_blocks, cb, cb_arg,
+			    false);
+}
+
+static uint8_t
+test_gf_mul(uint8_t a, uint8_t b)
+{
+	uint8_t p = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		if (b & (1 << i)) {
+			p ^= a;
+		}
+		a = (a & 0x80) ? (a << 1) ^ 0x1d : a << 1;
+	}
+
+	return p;
+}
+
+static void
+fill_random(void *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		((uint8_t *)buf)[i] = rand();
+	}
+}
+
+static void
+submit_rw_request(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+		  enum spdk_bdev_io_type io_type, uint64_t offset_blocks, uint64_t num_blocks,
+		  void *buf, void *md_buf)
+{
+	struct raid_bdev_io *raid_io;
+	size_t len = num_blocks * raid_bdev->bdev.blocklen;
+	struct iovec *iovs;
+	int iovcnt = 3;
+	int i;
+
+	raid_io = calloc(1, sizeof(*raid_io));
+	iovs = calloc(iovcnt, sizeof(*iovs));
+	SPDK_CU_ASSERT_FATAL(raid_io != NULL && iovs != NULL);
+
+	/* split the buffer into iovecs not aligned to the chunks */
+	for (i = 0; i < iovcnt; i++) {
+		iovs[i].iov_base = buf + i * (len / iovcnt);
+		iovs[i].iov_len = len / iovcnt;
+	}
+	iovs[iovcnt - 1].iov_len += len % iovcnt;
+
+	raid_test_bdev_io_init(raid_io, raid_bdev, raid_ch, io_type, offset_blocks, num_blocks,
+			       iovs, iovcnt, md_buf);
+
+	g_io_status = SPDK_BDEV_IO_STATUS_PENDING;
+
+	raid6_submit_rw_request(raid_io);
+	process_io_completions();
+
+	CU_ASSERT(g_io_status == SPDK_BDEV_IO_STATUS_SUCCESS);
+}
+
+/* Compare a chunk on a base bdev with the expected contents, skipping missing base bdevs */
+static void
+verify_chunk(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch, uint8_t idx,
+	     uint64_t base_offset, void *data, void *md)
+{
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	uint32_t md_len = raid_bdev->bdev.md_len;
+
+	if (raid_ch->_base_channels[idx] == NULL) {
+		return;
+	}
+
+	CU_ASSERT(memcmp(g_base_bdev_data[idx] + base_offset * blocklen, data,
+			 raid_bdev->strip_size * blocklen) == 0);
+	if (md_len != 0 && !raid_bdev->bdev.md_interleave) {
+		CU_ASSERT(memcmp(g_base_bdev_md[idx] + base_offset * md_len, md,
+				 raid_bdev->strip_size * md_len) == 0);
+	}
+}
+
+/* Write a full stripe and verify the data and the P and Q chunks on the base bdevs */
+static void
+write_stripe(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+	     uint64_t stripe_index, void *stripe_buf, void *stripe_md_buf)
+{
+	struct raid6_info *r6_info = raid_bdev->module_private;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	uint32_t md_len = raid_bdev->bdev.md_len;
+	bool separate_md = md_len != 0 && !raid_bdev->bdev.md_interleave;
+	uint8_t n_data = raid6_stripe_data_chunks_num(raid_bdev);
+	uint8_t p_idx = raid6_stripe_p_chunk_index(raid_bdev, stripe_index);
+	uint8_t q_idx = raid6_stripe_q_chunk_index(raid_bdev, stripe_index);
+	size_t chunk_len = raid_bdev->strip_size * blocklen;
+	size_t chunk_md_len = raid_bdev->strip_size * md_len;
+	uint64_t base_offset = stripe_index * raid_bdev->strip_size;
+	uint8_t *p, *q, *p_md, *q_md;
+	uint8_t i, d = 0;
+	size_t b;
+
+	fill_random(stripe_buf, r6_info->stripe_blocks * blocklen);
+	if (separate_md) {
+		fill_random(stripe_md_buf, r6_info->stripe_blocks * md_len);
+	}
+
+	submit_rw_request(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_WRITE,
+			  stripe_index * r6_info->stripe_blocks, r6_info->stripe_blocks,
+			  stripe_buf, separate_md ? stripe_md_buf : NULL);
+
+	p = calloc(1, chunk_len);
+	q = calloc(1, chunk_len);
+	p_md = calloc(1, chunk_md_len + 1);
+	q_md = calloc(1, chunk_md_len + 1);
+	SPDK_CU_ASSERT_FATAL(p != NULL && q != NULL && p_md != NULL && q_md != NULL);
+
+	for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+		uint8_t coeff = 1;
+		uint8_t *data = stripe_buf + d * chunk_len;
+		uint8_t *md = stripe_md_buf + d * chunk_md_len;
+
+		if (i == p_idx || i == q_idx) {
+			continue;
+		}
+
+		verify_chunk(raid_bdev, raid_ch, i, base_offset, data, md);
+
+		for (b = 0; b < d; b++) {
+			coeff = test_gf_mul(coeff, 2);
+		}
+
+		for (b = 0; b < chunk_len; b++) {
+			p[b] ^= data[b];
+			q[b] ^= test_gf_mul(coeff, data[b]);
+		}
+		for (b = 0; separate_md && b < chunk_md_len; b++) {
+			p_md[b] ^= md[b];
+			q_md[b] ^= test_gf_mul(coeff, md[b]);
+		}
+		d++;
+	}
+	CU_ASSERT(d == n_data);
+
+	verify_chunk(raid_bdev, raid_ch, p_idx, base_offset, p, p_md);
+	verify_chunk(raid_bdev, raid_ch, q_idx, base_offset, q, q_md);
+
+	free(p);
+	free(q);
+	free(p_md);
+	free(q_md);
+}
+
+/* Read each strip of the stripe in two parts and compare it with the written data */
+static void
+verify_stripe(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+	      uint64_t stripe_index, void *stripe_buf, void *stripe_md_buf)
+{
+	struct raid6_info *r6_info = raid_bdev->module_private;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	uint32_t md_len = raid_bdev->bdev.md_len;
+	bool separate_md = md_len != 0 && !raid_bdev->bdev.md_interleave;
+	uint64_t strip_size = raid_bdev->strip_size;
+	void *buf, *md_buf;
+	uint64_t offset, num_blocks;
+	uint8_t d;
+
+	buf = malloc(strip_size * blocklen);
+	md_buf = malloc(strip_size * md_len + 1);
+	SPDK_CU_ASSERT_FATAL(buf != NULL && md_buf != NULL);
+
+	for (d = 0; d < raid6_stripe_data_chunks_num(raid_bdev); d++) {
+		for (offset = 0; offset < strip_size; offset += num_blocks) {
+			num_blocks = offset == 0 && strip_size > 1 ? strip_size / 2 : strip_size - offset;
+
+			memset(buf, 0, num_blocks * blocklen);
+			submit_rw_request(raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+					  stripe_index * r6_info->stripe_blocks + d * strip_size + offset,
+					  num_blocks, buf, separate_md ? md_buf : NULL);
+
+			CU_ASSERT(memcmp(buf, stripe_buf + (d * strip_size + offset) * blocklen,
+					 num_blocks * blocklen) == 0);
+			if (separate_md) {
+				CU_ASSERT(memcmp(md_buf, stripe_md_buf + (d * strip_size + offset) * md_len,
+						 num_blocks * md_len) == 0);
+			}
+		}
+	}
+
+	free(buf);
+	free(md_buf);
+}
+
+static void
+reconstruct_done(struct stripe_request *stripe_req, int status)
+{
+	raid6_stripe_request_release(stripe_req);
+
+	g_reconstruct_status = status;
+}
+
+/* Reconstruct a whole chunk, like the rebuild process does, and compare it with the base bdev */
+static void
+verify_reconstruct_chunk(struct raid_bdev *raid_bdev, struct raid_bdev_io_channel *raid_ch,
+			 uint64_t stripe_index, uint8_t chunk_idx)
+{
+	struct raid6_info *r6_info = raid_bdev->module_private;
+	uint32_t blocklen = raid_bdev->bdev.blocklen;
+	uint32_t md_len = raid_bdev->bdev.md_len;
+	bool separate_md = md_len != 0 && !raid_bdev->bdev.md_interleave;
+	uint64_t base_offset = stripe_index * raid_bdev->strip_size;
+	struct raid_bdev_io raid_io;
+	struct iovec iov;
+	void *md_buf;
+
+	iov.iov_len = raid_bdev->strip_size * blocklen;
+	iov.iov_base = calloc(1, iov.iov_len);
+	md_buf = calloc(raid_bdev->strip_size, md_len + 1);
+	SPDK_CU_ASSERT_FATAL(iov.iov_base != NULL && md_buf != NULL);
+
+	raid_test_bdev_io_init(&raid_io, raid_bdev, raid_ch, SPDK_BDEV_IO_TYPE_READ,
+			       stripe_index * r6_info->stripe_blocks, raid_bdev->strip_size,
+			       &iov, 1, separate_md ? md_buf : NULL);
+
+	g_reconstruct_status = INT_MAX;
+	CU_ASSERT(raid6_submit_reconstruct_read(&raid_io, stripe_index, chunk_idx, 0,
+						reconstruct_done) == 0);
+	process_io_completions();
+	CU_ASSERT(g_reconstruct_status == 0);
+
+	CU_ASSERT(memcmp(iov.iov_base, g_base_bdev_data[chunk_idx] + base_offset * blocklen,
+			 iov.iov_len) == 0);
+	if (separate_md) {
+		CU_ASSERT(memcmp(md_buf, g_base_bdev_md[chunk_idx] + base_offset * md_len,
+				 raid_bdev->strip_size * md_len) == 0);
+	}
+
+	free(iov.iov_base);
+	free(md_buf);
+}
+
+static void
+test_raid6_write_read(bool degraded)
+{
+	struct raid_params *params;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		struct raid6_info *r6_info = create_raid6(params);
+		struct raid_bdev *raid_bdev = r6_info->raid_bdev;
+		struct raid_bdev_io_channel *raid_ch = raid_test_create_io_channel(raid_bdev);
+		uint64_t num_stripes = spdk_min(raid_bdev->num_base_bdevs, r6_info->total_stripes);
+		void *stripe_buf, *stripe_md_buf;
+		uint64_t stripe_index;
+		uint8_t a, b, i;
+
+		stripe_buf = malloc(num_stripes * r6_info->stripe_blocks * raid_bdev->bdev.blocklen);
+		stripe_md_buf = malloc(num_stripes * r6_info->stripe_blocks * raid_bdev->bdev.md_len + 1);
+		SPDK_CU_ASSERT_FATAL(stripe_buf != NULL && stripe_md_buf != NULL);
+
+		/* Cover each parity chunk rotation */
+		for (stripe_index = 0; stripe_index < num_stripes; stripe_index++) {
+			write_stripe(raid_bdev, raid_ch, stripe_index,
+				     stripe_buf + stripe_index * r6_info->stripe_blocks * raid_bdev->bdev.blocklen,
+				     stripe_md_buf + stripe_index * r6_info->stripe_blocks * raid_bdev->bdev.md_len);
+		}
+
+		if (!degraded) {
+			for (stripe_index = 0; stripe_index < num_stripes; stripe_index++) {
+				verify_stripe(raid_bdev, raid_ch, stripe_index,
+					      stripe_buf + stripe_index * r6_info->stripe_blocks * raid_bdev->bdev.blocklen,
+					      stripe_md_buf + stripe_index * r6_info->stripe_blocks * raid_bdev->bdev.md_len);
+			}
+			goto out;
+		}
+
+		/* Every combination of one or two missing base bdevs */
+		for (a = 0; a < raid_bdev->num_base_bdevs; a++) {
+			for (b = a; b < raid_bdev->num_base_bdevs; b++) {
+				raid_ch->_base_channels[a] = NULL;
+				raid_ch->_base_channels[b] = NULL;
+
+				for (stripe_index = 0; stripe_index < num_stripes; stripe_index++) {
+					verify_stripe(raid_bdev, raid_ch, stripe_index,
+						      stripe_buf + stripe_index * r6_info->stripe_blocks * raid_bdev->bdev.blocklen,
+						      stripe_md_buf + stripe_index * r6_info->stripe_blocks * raid_bdev->bdev.md_len);
+					verify_reconstruct_chunk(raid_bdev, raid_ch, stripe_index, a);
+					verify_reconstruct_chunk(raid_bdev, raid_ch, stripe_index, b);
+				}
+
+				for (i = 0; i < raid_bdev->num_base_bdevs; i++) {
+					raid_ch->_base_channels[i] = (void *)1;
+				}
+			}
+		}
+out:
+		free(stripe_buf);
+		free(stripe_md_buf);
+		raid_test_destroy_io_channel(raid_ch);
+		delete_raid6(r6_info);
+	}
+}
+
+static void
+test_raid6_submit_rw_request(void)
+{
+	test_raid6_write_read(false);
+}
+
+static void
+test_raid6_submit_read_request_degraded(void)
+{
+	test_raid6_write_read(true);
+}
+
+static void
+test_raid6_submit_write_request_degraded(void)
+{
+	struct raid_params *params;
+
+	RAID_PARAMS_FOR_EACH(params) {
+		struct raid6_info *r6_info = create_raid6(params);
+		struct raid_bdev *raid_bdev = r6_info->raid_bdev;
+		struct raid_bdev_io_channel *raid_ch = raid_test_create_io_channel(raid_bdev);
+		size_t stripe_len = r6_info->stripe_blocks * raid_bdev->bdev.blocklen;
+		void *stripe_buf, *stripe_md_buf;
+		uint8_t missing = raid_bdev->num_base_bdevs - 1;
+
+		stripe_buf = malloc(stripe_len);
+		stripe_md_buf = malloc(r6_info->stripe_blocks * raid_bdev->bdev.md_len + 1);
+		SPDK_CU_ASSERT_FATAL(stripe_buf != NULL && stripe_md_buf != NULL);
+
+		/* Write with the stripe's Q chunk missing and read it back without a data chunk */
+		raid_ch->_base_channels[missing] = NULL;
+		write_stripe(raid_bdev, raid_ch, 0, stripe_buf, stripe_md_buf);
+		raid_ch->_base_channels[0] = NULL;
+		verify_stripe(raid_bdev, raid_ch, 0, stripe_buf, stripe_md_buf);
+
+		free(stripe_buf);
+		free(stripe_md_buf);
+		raid_test_destroy_io_channel(raid_ch);
+		delete_raid6(r6_info);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite suite = NULL;
+	unsigned int num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("raid6", test_suite_init, test_suite_cleanup);
+	CU_ADD_TEST(suite, test_raid6_start);
+	CU_ADD_TEST(suite, test_raid6_submit_rw_request);
+	CU_ADD_TEST(suite, test_raid6_submit_read_request_degraded);
+	CU_ADD_TEST(suite, test_raid6_submit_write_request_degraded);
+
+	allocate_threads(1);
+	set_thread(0);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+
+	free_threads();
+
+	return num_failures;
+}
@@ -0,0 +1,586 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "spdk/env.h"
+#include "spdk_internal/mock.h"
+#include "thread/thread_internal.h"
+#include "common/lib/test_env.c"
+#include "bdev/coalesce/vbdev_coalesce.c"
+#include "bdev/coalesce/vbdev_coalesce_rpc.c"
+
+#define BLOCK_CNT	1024
+#define BLOCK_SIZE	512
+#define MAX_CHILD_IOS	16
+
+struct child_io {
+	enum spdk_bdev_io_type		type;
+	uint64_t			offset_blocks;
+	uint64_t			num_blocks;
+	int				iovcnt;
+	struct iovec			iovs[VBDEV_COALESCE_MAX_IOVS];
+	spdk_bdev_io_completion_cb	cb;
+	void				*cb_arg;
+};
+
+static struct spdk_thread *g_thread;
+static struct spdk_bdev g_base_bdev;
+static struct spdk_bdev *g_coalesce_bdev;
+static struct spdk_io_channel *g_ch;
+static struct child_io g_child_ios[MAX_CHILD_IOS];
+static uint32_t g_num_child_ios;
+static struct vbdev_coalesce_stats g_stats;
+static int g_stats_rc;
+
+DEFINE_STUB_V(spdk_bdev_module_list_add, (struct spdk_bdev_module *bdev_module));
+DEFINE_STUB_V(spdk_bdev_close, (struct spdk_bdev_desc *desc));
+DEFINE_STUB_V(spdk_bdev_module_examine_done, (struct spdk_bdev_module *module));
+DEFINE_STUB_V(spdk_bdev_module_release_bdev, (struct spdk_bdev *bdev));
+DEFINE_STUB(spdk_bdev_module_claim_bdev, int, (struct spdk_bdev *bdev, struct spdk_bdev_desc *desc,
+		struct spdk_bdev_module *module), 0);
+DEFINE_STUB(spdk_bdev_io_type_supported, bool, (struct spdk_bdev *bdev,
+		enum spdk_bdev_io_type io_type), true);
+DEFINE_STUB(spdk_bdev_get_memory_domains, int, (struct spdk_bdev *bdev,
+		struct spdk_memory_domain **domains, int array_size), 0);
+DEFINE_STUB(spdk_bdev_queue_io_wait, int, (struct spdk_bdev *bdev, struct spdk_io_channel *ch,
+		struct spdk_bdev_io_wait_entry *entry), 0);
+DEFINE_STUB(spdk_bdev_write_zeroes_blocks, int, (struct spdk_bdev_desc *desc,
+		struct spdk_io_channel *ch, uint64_t offset_blocks, uint64_t num_blocks,
+		spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_unmap_blocks, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		uint64_t offset_blocks, uint64_t num_blocks, spdk_bdev_io_completion_cb cb,
+		void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_reset, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+				   spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_abort, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+				   void *bio_cb_arg, spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_copy_blocks, int, (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		uint64_t dst_offset_blocks, uint64_t src_offset_blocks, uint64_t num_blocks,
+		spdk_bdev_io_completion_cb cb, void *cb_arg), 0);
+DEFINE_STUB(spdk_bdev_get_uuid, const struct spdk_uuid *, (const struct spdk_bdev *bdev), NULL);
+DEFINE_STUB(spdk_json_decode_object, int, (const struct spdk_json_val *values,
+		const struct spdk_json_object_decoder *decoders, size_t num_decoders, void *out), 0);
+DEFINE_STUB(spdk_json_decode_string, int, (const struct spdk_json_val *val, void *out), 0);
+DEFINE_STUB(spdk_json_decode_uint32, int, (const struct spdk_json_val *val, void *out), 0);
+DEFINE_STUB(spdk_json_decode_uint64, int, (const struct spdk_json_val *val, void *out), 0);
+DEFINE_STUB(spdk_json_decode_uuid, int, (const struct spdk_json_val *val, void *out), 0);
+DEFINE_STUB(spdk_json_write_name, int, (struct spdk_json_write_ctx *w, const char *name), 0);
+DEFINE_STUB(spdk_json_write_string, int, (struct spdk_json_write_ctx *w, const char *val), 0);
+DEFINE_STUB(spdk_json_write_object_begin, int, (struct spdk_json_write_ctx *w), 0);
+DEFINE_STUB(spdk_json_write_object_end, int, (struct spdk_json_write_ctx *w), 0);
+DEFINE_STUB(spdk_json_write_named_object_begin, int, (struct spdk_json_write_ctx *w,
+		const char *name), 0);
+DEFINE_STUB(spdk_json_write_named_string, int, (struct spdk_json_write_ctx *w,
+		const char *name, const char *val), 0);
+DEFINE_STUB(spdk_json_write_named_uint32, int, (struct spdk_json_write_ctx *w,
+		const char *name, uint32_t val), 0);
+DEFINE_STUB(spdk_json_write_named_uint64, int, (struct spdk_json_write_ctx *w,
+		const char *name, uint64_t val), 0);
+DEFINE_STUB(spdk_json_write_named_double, int, (struct spdk_json_write_ctx *w,
+		const char *name, double val), 0);
+DEFINE_STUB(spdk_json_write_named_uuid, int, (struct spdk_json_write_ctx *w,
+		const char *name, const struct spdk_uuid *val), 0);
+DEFINE_STUB_V(spdk_rpc_register_method, (const char *method, spdk_rpc_method_handler func,
+		uint32_t state_mask));
+DEFINE_STUB(spdk_jsonrpc_begin_result, struct spdk_json_write_ctx *,
+	    (struct spdk_jsonrpc_request *request), NULL);
+DEFINE_STUB_V(spdk_jsonrpc_end_result, (struct spdk_jsonrpc_request *request,
+					struct spdk_json_write_ctx *w));
+DEFINE_STUB_V(spdk_jsonrpc_send_bool_response, (struct spdk_jsonrpc_request *request,
+		bool value));
+DEFINE_STUB_V(spdk_jsonrpc_send_error_response, (struct spdk_jsonrpc_request *request,
+		int error_code, const char *msg));
+
+const char *
+spdk_bdev_get_name(const struct spdk_bdev *bdev)
+{
+	return bdev->name;
+}
+
+int
+spdk_bdev_open_ext(const char *bdev_name, bool write, spdk_bdev_event_cb_t event_cb,
+		   void *event_ctx, struct spdk_bdev_desc **_desc)
+{
+	if (strcmp(bdev_name, g_base_bdev.name) != 0) {
+		return -ENODEV;
+	}
+
+	*_desc = (void *)&g_base_bdev;
+	return 0;
+}
+
+struct spdk_bdev *
+spdk_bdev_desc_get_bdev(struct spdk_bdev_desc *desc)
+{
+	return (void *)desc;
+}
+
+struct spdk_io_channel *
+spdk_bdev_get_io_channel(struct spdk_bdev_desc *desc)
+{
+	return spdk_get_io_channel(&g_base_bdev);
+}
+
+int
+spdk_bdev_register(struct spdk_bdev *bdev)
+{
+	CU_ASSERT(g_coalesce_bdev == NULL);
+	g_coalesce_bdev = bdev;
+	return 0;
+}
+
+void
+spdk_bdev_unregister(struct spdk_bdev *bdev, spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	CU_ASSERT(bdev == g_coalesce_bdev);
+	g_coalesce_bdev = NULL;
+
+	bdev->fn_table->destruct(bdev->ctxt);
+
+	if (cb_fn) {
+		cb_fn(cb_arg, 0);
+	}
+}
+
+int
+spdk_bdev_unregister_by_name(const char *bdev_name, struct spdk_bdev_module *module,
+			     spdk_bdev_unregister_cb cb_fn, void *cb_arg)
+{
+	CU_ASSERT(module == &coalesce_if);
+	SPDK_CU_ASSERT_FATAL(g_coalesce_bdev != NULL);
+	CU_ASSERT(strcmp(g_coalesce_bdev->name, bdev_name) == 0);
+
+	spdk_bdev_unregister(g_coalesce_bdev, cb_fn, cb_arg);
+
+	return 0;
+}
+
+void
+spdk_bdev_io_complete(struct spdk_bdev_io *bdev_io, enum spdk_bdev_io_status status)
+{
+	bdev_io->internal.status = status;
+}
+
+void
+spdk_bdev_io_complete_base_io_status(struct spdk_bdev_io *bdev_io,
+				     const struct spdk_bdev_io *base_io)
+{
+	bdev_io->internal.status = base_io->internal.status;
+}
+
+void
+spdk_bdev_io_get_buf(struct spdk_bdev_io *bdev_io, spdk_bdev_io_get_buf_cb cb, uint64_t len)
+{
+	cb(g_ch, bdev_io, true);
+}
+
+void
+spdk_bdev_free_io(struct spdk_bdev_io *bdev_io)
+{
+	free(bdev_io);
+}
+
+static int
+child_io_submit(enum spdk_bdev_io_type type, struct iovec *iov, int iovcnt, uint64_t offset_blocks,
+		uint64_t num_blocks, spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct child_io *child;
+
+	SPDK_CU_ASSERT_FATAL(g_num_child_ios < MAX_CHILD_IOS);
+	SPDK_CU_ASSERT_FATAL(iovcnt <= VBDEV_COALESCE_MAX_IOVS);
+
+	child = &g_child_ios[g_num_child_ios++];
+	child->type = type;
+	child->offset_blocks = offset_blocks;
+	child->num_blocks = num_blocks;
+	child->iovcnt = iovcnt;
+	memcpy(child->iovs, iov, iovcnt * sizeof(*iov));
+	child->cb = cb;
+	child->cb_arg = cb_arg;
+
+	return 0;
+}
+
+int
+spdk_bdev_readv_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return child_io_submit(SPDK_BDEV_IO_TYPE_READ, iov, iovcnt, offset_blocks, num_blocks,
+			       cb, cb_arg);
+}
+
+int
+spdk_bdev_writev_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return child_io_submit(SPDK_BDEV_IO_TYPE_WRITE, iov, iovcnt, offset_blocks, num_blocks,
+			       cb, cb_arg);
+}
+
+int
+spdk_bdev_readv_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			   struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			   spdk_bdev_io_completion_cb cb, void *cb_arg,
+			   struct spdk_bdev_ext_io_opts *opts)
+{
+	return child_io_submit(SPDK_BDEV_IO_TYPE_READ, iov, iovcnt, offset_blocks, num_blocks,
+			       cb, cb_arg);
+}
+
+int
+spdk_bdev_writev_blocks_ext(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+			    struct iovec *iov, int iovcnt, uint64_t offset_blocks, uint64_t num_blocks,
+			    spdk_bdev_io_completion_cb cb, void *cb_arg,
+			    struct spdk_bdev_ext_io_opts *opts)
+{
+	return child_io_submit(SPDK_BDEV_IO_TYPE_WRITE, iov, iovcnt, offset_blocks, num_blocks,
+			       cb, cb_arg);
+}
+
+int
+spdk_bdev_flush_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		       uint64_t offset_blocks, uint64_t num_blocks,
+		       spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	return child_io_submit(SPDK_BDEV_IO_TYPE_FLUSH, NULL, 0, offset_blocks, num_blocks,
+			       cb, cb_arg);
+}
+
+static void
+complete_child_io(uint32_t idx, bool success)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	SPDK_CU_ASSERT_FATAL(idx < g_num_child_ios);
+
+	bdev_io = calloc(1, sizeof(*bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+	bdev_io->internal.status = success ? SPDK_BDEV_IO_STATUS_SUCCESS : SPDK_BDEV_IO_STATUS_FAILED;
+
+	g_child_ios[idx].cb(bdev_io, success, g_child_ios[idx].cb_arg);
+}
+
+static int
+base_ch_create_cb(void *io_device, void *ctx_buf)
+{
+	return 0;
+}
+
+static void
+base_ch_destroy_cb(void *io_device, void *ctx_buf)
+{
+}
+
+static void
+poll_thread(void)
+{
+	while (spdk_thread_poll(g_thread, 0, 0) > 0) {}
+}
+
+static struct spdk_bdev_io *
+alloc_io(enum spdk_bdev_io_type type, uint64_t offset_blocks, uint64_t num_blocks, void *buf)
+{
+	struct spdk_bdev_io *bdev_io;
+
+	bdev_io = calloc(1, sizeof(*bdev_io) + sizeof(struct coalesce_bdev_io));
+	SPDK_CU_ASSERT_FATAL(bdev_io != NULL);
+
+	bdev_io->bdev = g_coalesce_bdev;
+	bdev_io->type = type;
+	bdev_io->internal.status = SPDK_BDEV_IO_STATUS_PENDING;
+	bdev_io->u.bdev.offset_blocks = offset_blocks;
+	bdev_io->u.bdev.num_blocks = num_blocks;
+	bdev_io->u.bdev.iovs = &bdev_io->iov;
+	bdev_io->u.bdev.iovcnt = 1;
+	bdev_io->iov.iov_base = buf;
+	bdev_io->iov.iov_len = num_blocks * BLOCK_SIZE;
+
+	return bdev_io;
+}
+
+static struct spdk_io_channel *
+test_setup(uint64_t max_delay_us, uint32_t max_ios, uint32_t max_io_size_kib)
+{
+	struct vbdev_coalesce_opts opts;
+	struct spdk_uuid uuid = {};
+	int rc;
+
+	g_base_bdev.name = "base";
+	g_base_bdev.blocklen = BLOCK_SIZE;
+	g_base_bdev.blockcnt = BLOCK_CNT;
+	g_num_child_ios = 0;
+
+	spdk_io_device_register(&g_base_bdev, base_ch_create_cb, base_ch_destroy_cb, 0, "base");
+
+	opts.max_delay_us = max_delay_us;
+	opts.max_ios = max_ios;
+	opts.max_io_size_kib = max_io_size_kib;
+	rc = bdev_coalesce_create_disk("base", "coalesce0", &uuid, &opts);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(g_coalesce_bdev != NULL);
+	CU_ASSERT(g_coalesce_bdev->blocklen == BLOCK_SIZE);
+	CU_ASSERT(g_coalesce_bdev->blockcnt == BLOCK_CNT);
+
+	g_ch = spdk_get_io_channel(g_coalesce_bdev->ctxt);
+	SPDK_CU_ASSERT_FATAL(g_ch != NULL);
+
+	return g_ch;
+}
+
+static void
+test_teardown(struct spdk_io_channel *ch)
+{
+	spdk_put_io_channel(ch);
+	g_ch = NULL;
+	poll_thread();
+
+	bdev_coalesce_delete_disk("coalesce0", NULL, NULL);
+	spdk_io_device_unregister(&g_base_bdev, NULL);
+	poll_thread();
+	CU_ASSERT(g_coalesce_bdev == NULL);
+}
+
+static void
+get_stats_cb(void *cb_arg, const struct vbdev_coalesce_stats *stats, int rc)
+{
+	g_stats = *stats;
+	g_stats_rc = rc;
+}
+
+static void
+get_stats(void)
+{
+	int rc;
+
+	memset(&g_stats, 0, sizeof(g_stats));
+	g_stats_rc = -1;
+	rc = bdev_coalesce_get_stats("coalesce0", get_stats_cb, NULL);
+	CU_ASSERT(rc == 0);
+	poll_thread();
+	CU_ASSERT(g_stats_rc == 0);
+}
+
+static void
+test_merge_adjacent(void)
+{
+	struct spdk_io_channel *ch;
+	struct spdk_bdev_io *ios[3];
+	char buf[3][8 * BLOCK_SIZE];
+	int i;
+
+	ch = test_setup(1000, 3, 128);
+
+	/* Two adjacent writes are held back */
+	for (i = 0; i < 2; i++) {
+		ios[i] = alloc_io(SPDK_BDEV_IO_TYPE_WRITE, 16 + i * 8, 8, buf[i]);
+		vbdev_coalesce_submit_request(ch, ios[i]);
+	}
+	CU_ASSERT(g_num_child_ios == 0);
+
+	/* The third one reaches max_ios and sends all of them as one write */
+	ios[2] = alloc_io(SPDK_BDEV_IO_TYPE_WRITE, 32, 8, buf[2]);
+	vbdev_coalesce_submit_request(ch, ios[2]);
+	SPDK_CU_ASSERT_FATAL(g_num_child_ios == 1);
+	CU_ASSERT(g_child_ios[0].type == SPDK_BDEV_IO_TYPE_WRITE);
+	CU_ASSERT(g_child_ios[0].offset_blocks == 16);
+	CU_ASSERT(g_child_ios[0].num_blocks == 24);
+	CU_ASSERT(g_child_ios[0].iovcnt == 3);
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(g_child_ios[0].iovs[i].iov_base == buf[i]);
+		CU_ASSERT(g_child_ios[0].iovs[i].iov_len == 8 * BLOCK_SIZE);
+		CU_ASSERT(ios[i]->internal.status == SPDK_BDEV_IO_STATUS_PENDING);
+	}
+
+	/* The completion is fanned out to all of them */
+	complete_child_io(0, true);
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(ios[i]->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+		free(ios[i]);
+	}
+
+	/* Reads are merged the same way and failures are fanned out too */
+	g_num_child_ios = 0;
+	for (i = 0; i < 3; i++) {
+		ios[i] = alloc_io(SPDK_BDEV_IO_TYPE_READ, 100 + i * 8, 8, buf[i]);
+		vbdev_coalesce_submit_request(ch, ios[i]);
+	}
+	SPDK_CU_ASSERT_FATAL(g_num_child_ios == 1);
+	CU_ASSERT(g_child_ios[0].type == SPDK_BDEV_IO_TYPE_READ);
+	CU_ASSERT(g_child_ios[0].offset_blocks == 100);
+	CU_ASSERT(g_child_ios[0].num_blocks == 24);
+	complete_child_io(0, false);
+	for (i = 0; i < 3; i++) {
+		CU_ASSERT(ios[i]->internal.status == SPDK_BDEV_IO_STATUS_FAILED);
+		free(ios[i]);
+	}
+
+	get_stats();
+	CU_ASSERT(g_stats.num_read_ops == 3);
+	CU_ASSERT(g_stats.num_write_ops == 3);
+	CU_ASSERT(g_stats.num_child_read_ops == 1);
+	CU_ASSERT(g_stats.num_child_write_ops == 1);
+
+	test_teardown(ch);
+}
+
+static void
+test_flush_conditions(void)
+{
+	struct spdk_io_channel *ch;
+	struct spdk_bdev_io *ios[4];
+	char buf[4][8 * BLOCK_SIZE];
+	int i;
+
+	/* 8 KiB limit, i.e. 16 blocks */
+	ch = test_setup(10, 32, 8);
+
+	/* A write that doesn't continue the open request sends that request */
+	ios[0] = alloc_io(SPDK_BDEV_IO_TYPE_WRITE, 0, 8, buf[0]);
+	vbdev_coalesce_submit_request(ch, ios[0]);
+	ios[1] = alloc_io(SPDK_BDEV_IO_TYPE_WRITE, 100, 8, buf[1]);
+	vbdev_coalesce_submit_request(ch, ios[1]);
+	SPDK_CU_ASSERT_FATAL(g_num_child_ios == 1);
+	CU_ASSERT(g_child_ios[0].offset_blocks == 0);
+	CU_ASSERT(g_child_ios[0].num_blocks == 8);
+
+	/* Reaching the size limit sends the request right away */
+	ios[2] = alloc_io(SPDK_BDEV_IO_TYPE_WRITE, 108, 8, buf[2]);
+	vbdev_coalesce_submit_request(ch, ios[2]);
+	SPDK_CU_ASSERT_FATAL(g_num_child_ios == 2);
+	CU_ASSERT(g_child_ios[1].offset_blocks == 100);
+	CU_ASSERT(g_child_ios[1].num_blocks == 16);
+
+	/* I/O not smaller than the limit are passed down on their own */
+	ios[3] = alloc_io(SPDK_BDEV_IO_TYPE_WRITE, 200, 16, buf[3]);
+	vbdev_coalesce_submit_request(ch, ios[3]);
+	SPDK_CU_ASSERT_FATAL(g_num_child_ios == 3);
+	CU_ASSERT(g_child_ios[2].cb_arg == ios[3]);
+	CU_ASSERT(g_child_ios[2].num_blocks == 16);
+
+	for (i = 0; i < 3; i++) {
+		complete_child_io(i, true);
+	}
+	for (i = 0; i < 4; i++) {
+		CU_ASSERT(ios[i]->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+		free(ios[i]);
+	}
+
+	/* A held I/O is sent once the delay expires */
+	g_num_child_ios = 0;
+	ios[0] = alloc_io(SPDK_BDEV_IO_TYPE_WRITE, 300, 8, buf[0]);
+	vbdev_coalesce_submit_request(ch, ios[0]);
+	poll_thread();
+	CU_ASSERT(g_num_child_ios == 0);
+	spdk_delay_us(10);
+	poll_thread();
+	SPDK_CU_ASSERT_FATAL(g_num_child_ios == 1);
+	complete_child_io(0, true);
+	CU_ASSERT(ios[0]->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	free(ios[0]);
+
+	get_stats();
+	CU_ASSERT(g_stats.num_write_ops == 4);
+	CU_ASSERT(g_stats.num_child_write_ops == 3);
+	CU_ASSERT(g_stats.max_added_latency_ticks == 10);
+	CU_ASSERT(g_stats.added_latency_ticks == 10);
+
+	/* Any other I/O type sends the held reads and writes first */
+	g_num_child_ios = 0;
+	ios[0] = alloc_io(SPDK_BDEV_IO_TYPE_WRITE, 400, 8, buf[0]);
+	vbdev_coalesce_submit_request(ch, ios[0]);
+	ios[1] = alloc_io(SPDK_BDEV_IO_TYPE_FLUSH, 0, BLOCK_CNT, NULL);
+	vbdev_coalesce_submit_request(ch, ios[1]);
+	SPDK_CU_ASSERT_FATAL(g_num_child_ios == 2);
+	CU_ASSERT(g_child_ios[0].type == SPDK_BDEV_IO_TYPE_WRITE);
+	CU_ASSERT(g_child_ios[1].type == SPDK_BDEV_IO_TYPE_FLUSH);
+	complete_child_io(0, true);
+	complete_child_io(1, true);
+	for (i = 0; i < 2; i++) {
+		CU_ASSERT(ios[i]->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+		free(ios[i]);
+	}
+
+	test_teardown(ch);
+}
+
+static void
+test_abort_queued(void)
+{
+	struct spdk_io_channel *ch;
+	struct spdk_bdev_io *ios[3], *abort_io;
+	char buf[3][8 * BLOCK_SIZE];
+	int i;
+
+	ch = test_setup(1000, 32, 128);
+
+	for (i = 0; i < 3; i++) {
+		ios[i] = alloc_io(SPDK_BDEV_IO_TYPE_WRITE, i * 8, 8, buf[i]);
+		vbdev_coalesce_submit_request(ch, ios[i]);
+	}
+	CU_ASSERT(g_num_child_ios == 0);
+
+	/* Aborting the middle one splits the rest into two requests */
+	abort_io = alloc_io(SPDK_BDEV_IO_TYPE_ABORT, 0, 0, NULL);
+	abort_io->u.abort.bio_to_abort = ios[1];
+	vbdev_coalesce_submit_request(ch, abort_io);
+	CU_ASSERT(abort_io->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(ios[1]->internal.status == SPDK_BDEV_IO_STATUS_ABORTED);
+	SPDK_CU_ASSERT_FATAL(g_num_child_ios == 1);
+	CU_ASSERT(g_child_ios[0].offset_blocks == 0);
+	CU_ASSERT(g_child_ios[0].num_blocks == 8);
+
+	spdk_delay_us(1000);
+	poll_thread();
+	SPDK_CU_ASSERT_FATAL(g_num_child_ios == 2);
+	CU_ASSERT(g_child_ios[1].offset_blocks == 16);
+	CU_ASSERT(g_child_ios[1].num_blocks == 8);
+
+	complete_child_io(0, true);
+	complete_child_io(1, true);
+	CU_ASSERT(ios[0]->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+	CU_ASSERT(ios[2]->internal.status == SPDK_BDEV_IO_STATUS_SUCCESS);
+
+	for (i = 0; i < 3; i++) {
+		free(ios[i]);
+	}
+	free(abort_io);
+
+	test_teardown(ch);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("vbdev_coalesce", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_merge_adjacent);
+	CU_ADD_TEST(suite, test_flush_conditions);
+	CU_ADD_TEST(suite, test_abort_queued);
+
+	spdk_thread_lib_init(NULL, 0);
+	g_thread = spdk_thread_create("test", NULL);
+	spdk_set_thread(g_thread);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+
+	spdk_thread_exit(g_thread);
+	while (!spdk_thread_is_exited(g_thread)) {
+		spdk_thread_poll(g_thread, 0, 0);
+	}
+	spdk_thread_destroy(g_thread);
+	spdk_thread_lib_fini();
+
+	CU_cleanup_registry();
+
+	return num_failures;
+}
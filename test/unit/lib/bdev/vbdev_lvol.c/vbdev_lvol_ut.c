@@ -863,6 +863,21 @@ spdk_lvol_create_snapshot(struct spdk_lvol *lvol, const char *snapshot_name,
 	cb_fn(cb_arg, snap, 0);
 }
 
+void
+spdk_lvol_create_snapshot_group(struct spdk_lvol **lvols, const char **snapshot_names,
+				uint32_t count, spdk_lvol_op_with_handles_complete cb_fn,
+				void *cb_arg)
+{
+	struct spdk_lvol *snaps[count];
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		snaps[i] = _lvol_create(lvols[i]->lvol_store);
+		snprintf(snaps[i]->name, sizeof(snaps[i]->name), "%s", snapshot_names[i]);
+	}
+	cb_fn(cb_arg, snaps, count, 0);
+}
+
 void
 spdk_lvol_create_clone(struct spdk_lvol *lvol, const char *clone_name,
 		       spdk_lvol_op_with_handle_complete cb_fn, void *cb_arg)
@@ -906,6 +921,19 @@ spdk_lvol_shallow_copy(struct spdk_lvol *lvol, struct spdk_bs_dev *ext_dev,
 	return 0;
 }
 
+int
+spdk_lvol_shallow_copy_incremental(struct spdk_lvol *lvol, struct spdk_lvol *ancestor,
+				   struct spdk_bs_dev *ext_dev,
+				   spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+				   spdk_lvol_op_complete cb_fn, void *cb_arg)
+{
+	if (ancestor == NULL) {
+		return -EINVAL;
+	}
+
+	return spdk_lvol_shallow_copy(lvol, ext_dev, status_cb_fn, status_cb_arg, cb_fn, cb_arg);
+}
+
 void
 spdk_lvol_set_external_parent(struct spdk_lvol *lvol, const void *esnap_id, uint32_t id_len,
 			      spdk_lvol_op_complete cb_fn, void *cb_arg)
@@ -935,6 +963,22 @@ vbdev_lvol_create_complete(void *cb_arg, struct spdk_lvol *lvol, int lvolerrno)
 	g_lvol = lvol;
 }
 
+static struct spdk_lvol *g_group_lvols[2];
+static uint32_t g_group_count;
+
+static void
+vbdev_lvol_create_group_complete(void *cb_arg, struct spdk_lvol **lvols, uint32_t count,
+				 int lvolerrno)
+{
+	uint32_t i;
+
+	g_lvolerrno = lvolerrno;
+	g_group_count = count;
+	for (i = 0; i < count; i++) {
+		g_group_lvols[i] = lvols[i];
+	}
+}
+
 static void
 vbdev_lvol_resize_complete(void *cb_arg, int lvolerrno)
 {
@@ -1106,6 +1150,56 @@ ut_lvol_snapshot(void)
 	CU_ASSERT(g_lvol_store == NULL);
 }
 
+static void
+ut_lvol_snapshot_group(void)
+{
+	struct spdk_lvol_store *lvs;
+	struct spdk_lvol *lvols[2];
+	const char *names[2] = { "snap0", "snap1" };
+	int rc;
+	int i;
+
+	ut_init_bdev(DEFAULT_BDEV_NAME, DEFAULT_BDEV_UUID);
+
+	rc = vbdev_lvs_create(DEFAULT_BDEV_NAME, "lvs", 0, LVS_CLEAR_WITH_UNMAP, 0,
+			      lvol_store_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+	lvs = g_lvol_store;
+
+	for (i = 0; i < 2; i++) {
+		g_lvolerrno = -1;
+		rc = vbdev_lvol_create(lvs, i == 0 ? "lvol0" : "lvol1", 10, false, LVOL_CLEAR_WITH_DEFAULT,
+				       vbdev_lvol_create_complete, NULL);
+		SPDK_CU_ASSERT_FATAL(rc == 0);
+		SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+		CU_ASSERT(g_lvolerrno == 0);
+		lvols[i] = g_lvol;
+	}
+
+	/* Successful group snapshot, a bdev is registered for every snapshot */
+	g_lvolerrno = -1;
+	g_group_count = 0;
+	vbdev_lvol_create_snapshot_group(lvols, names, 2, vbdev_lvol_create_group_complete, NULL);
+	CU_ASSERT(g_lvolerrno == 0);
+	CU_ASSERT(g_group_count == 2);
+	for (i = 0; i < 2; i++) {
+		SPDK_CU_ASSERT_FATAL(g_group_lvols[i] != NULL);
+		CU_ASSERT(strcmp(g_group_lvols[i]->name, names[i]) == 0);
+		CU_ASSERT(g_group_lvols[i]->bdev != NULL);
+	}
+
+	for (i = 0; i < 2; i++) {
+		vbdev_lvol_destroy(g_group_lvols[i], lvol_store_op_complete, NULL);
+		vbdev_lvol_destroy(lvols[i], lvol_store_op_complete, NULL);
+	}
+
+	vbdev_lvs_destruct(lvs, lvol_store_op_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(g_lvol_store == NULL);
+}
+
 static void
 ut_lvol_clone(void)
 {
@@ -2013,17 +2107,26 @@ ut_lvol_shallow_copy(void)
 	CU_ASSERT(g_lvolerrno == 0);
 
 	/* Shallow copy error with NULL lvol */
-	rc = vbdev_lvol_shallow_copy(NULL, "", NULL, NULL, vbdev_lvol_shallow_copy_complete, NULL);
+	rc = vbdev_lvol_shallow_copy(NULL, NULL, "", NULL, NULL, vbdev_lvol_shallow_copy_complete, NULL);
 	CU_ASSERT(rc == -EINVAL);
 
 	/* Shallow copy error with NULL bdev name */
-	rc = vbdev_lvol_shallow_copy(g_lvol, NULL, NULL, NULL, vbdev_lvol_shallow_copy_complete, NULL);
+	rc = vbdev_lvol_shallow_copy(g_lvol, NULL, NULL, NULL, NULL, vbdev_lvol_shallow_copy_complete,
+				     NULL);
 	CU_ASSERT(rc == -EINVAL);
 
 	/* Successful shallow copy */
 	g_lvolerrno = -1;
 	lvol_already_opened = false;
-	rc = vbdev_lvol_shallow_copy(g_lvol, DEFAULT_BDEV_NAME, NULL, NULL,
+	rc = vbdev_lvol_shallow_copy(g_lvol, NULL, DEFAULT_BDEV_NAME, NULL, NULL,
+				     vbdev_lvol_shallow_copy_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvolerrno == 0);
+
+	/* Successful incremental shallow copy */
+	g_lvolerrno = -1;
+	lvol_already_opened = false;
+	rc = vbdev_lvol_shallow_copy(g_lvol, g_lvol, DEFAULT_BDEV_NAME, NULL, NULL,
 				     vbdev_lvol_shallow_copy_complete, NULL);
 	CU_ASSERT(rc == 0);
 	CU_ASSERT(g_lvolerrno == 0);
@@ -2082,6 +2185,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, ut_lvs_init);
 	CU_ADD_TEST(suite, ut_lvol_init);
 	CU_ADD_TEST(suite, ut_lvol_snapshot);
+	CU_ADD_TEST(suite, ut_lvol_snapshot_group);
 	CU_ADD_TEST(suite, ut_lvol_clone);
 	CU_ADD_TEST(suite, ut_lvs_destroy);
 	CU_ADD_TEST(suite, ut_lvs_unload);
@@ -184,6 +184,21 @@ blob_op_with_id_complete(void *cb_arg, spdk_blob_id blobid, int bserrno)
 	g_bserrno = bserrno;
 }
 
+#define UT_SNAPSHOT_GROUP_SIZE 3
+static spdk_blob_id g_group_blobids[UT_SNAPSHOT_GROUP_SIZE];
+static uint32_t g_group_count;
+static bool g_group_done;
+
+static void
+blob_op_with_ids_complete(void *cb_arg, const spdk_blob_id *blobids, uint32_t count, int bserrno)
+{
+	SPDK_CU_ASSERT_FATAL(count <= UT_SNAPSHOT_GROUP_SIZE);
+	memcpy(g_group_blobids, blobids, count * sizeof(*blobids));
+	g_group_count = count;
+	g_group_done = true;
+	g_bserrno = bserrno;
+}
+
 static void
 blob_op_with_handle_complete(void *cb_arg, struct spdk_blob *blb, int bserrno)
 {
@@ -956,6 +971,143 @@ blob_snapshot_freeze_io(void)
 	ut_blob_close_and_delete(bs, blob);
 }
 
+static void
+ut_snapshot_group_get_xattr_value(void *arg, const char *name, const void **value,
+				  size_t *value_len)
+{
+	*value = arg;
+	*value_len = strlen(arg);
+}
+
+static void
+blob_snapshot_group(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_io_channel *channel;
+	struct spdk_blob_opts opts;
+	struct spdk_blob *blob[UT_SNAPSHOT_GROUP_SIZE];
+	spdk_blob_id blobid[UT_SNAPSHOT_GROUP_SIZE], ids[UT_SNAPSHOT_GROUP_SIZE];
+	struct spdk_blob_xattr_opts xattrs[UT_SNAPSHOT_GROUP_SIZE];
+	char *xattr_names[] = {"name"};
+	const char *names[UT_SNAPSHOT_GROUP_SIZE] = {"snap0", "snap1", "snap2"};
+	uint8_t payload[SPDK_BS_PAGE_SIZE];
+	uint32_t used_blobids, frozen, i;
+	bool was_frozen = false;
+	const void *value;
+	size_t value_len;
+	int rc;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = 4;
+	opts.thin_provision = true;
+
+	for (i = 0; i < UT_SNAPSHOT_GROUP_SIZE; i++) {
+		blob[i] = ut_blob_create_and_open(bs, &opts);
+		blobid[i] = spdk_blob_get_id(blob[i]);
+
+		memset(payload, i, sizeof(payload));
+		spdk_blob_io_write(blob[i], channel, payload, 0, 1, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+
+		xattrs[i].count = SPDK_COUNTOF(xattr_names);
+		xattrs[i].names = xattr_names;
+		xattrs[i].ctx = (void *)names[i];
+		xattrs[i].get_value = ut_snapshot_group_get_xattr_value;
+	}
+
+	/* A read only blob in the group fails the whole group and leaves no snapshot behind */
+	spdk_bs_create_snapshot(bs, blobid[2], NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	ids[0] = blobid[0];
+	ids[1] = blobid[1];
+	ids[2] = g_blobid;
+	used_blobids = spdk_bit_array_count_set(bs->used_blobids);
+
+	g_group_done = false;
+	spdk_bs_create_snapshot_group(bs, ids, UT_SNAPSHOT_GROUP_SIZE, NULL,
+				      blob_op_with_ids_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_group_done);
+	CU_ASSERT(g_bserrno == -EINVAL);
+	CU_ASSERT(g_group_count == UT_SNAPSHOT_GROUP_SIZE);
+	for (i = 0; i < UT_SNAPSHOT_GROUP_SIZE; i++) {
+		CU_ASSERT(g_group_blobids[i] == SPDK_BLOBID_INVALID);
+	}
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_blobids) == used_blobids);
+	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid[0]) == SPDK_BLOBID_INVALID);
+	CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid[1]) == SPDK_BLOBID_INVALID);
+	CU_ASSERT(blob[0]->frozen_refcnt == 0);
+	CU_ASSERT(blob[1]->frozen_refcnt == 0);
+
+	/* The same blob twice */
+	ids[2] = blobid[0];
+	g_group_done = false;
+	spdk_bs_create_snapshot_group(bs, ids, UT_SNAPSHOT_GROUP_SIZE, NULL,
+				      blob_op_with_ids_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_group_done);
+	CU_ASSERT(g_bserrno == -EBUSY);
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_blobids) == used_blobids);
+
+	/* Successful group, I/O to all blobs is frozen and unfrozen at the same time */
+	g_group_done = false;
+	spdk_bs_create_snapshot_group(bs, blobid, UT_SNAPSHOT_GROUP_SIZE, xattrs,
+				      blob_op_with_ids_complete, NULL);
+	while (!g_group_done) {
+		poll_thread_times(0, 1);
+		frozen = 0;
+		for (i = 0; i < UT_SNAPSHOT_GROUP_SIZE; i++) {
+			frozen += blob[i]->frozen_refcnt;
+		}
+		CU_ASSERT(frozen == 0 || frozen == UT_SNAPSHOT_GROUP_SIZE);
+		was_frozen |= frozen != 0;
+	}
+	CU_ASSERT(was_frozen);
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_group_count == UT_SNAPSHOT_GROUP_SIZE);
+
+	for (i = 0; i < UT_SNAPSHOT_GROUP_SIZE; i++) {
+		CU_ASSERT(g_group_blobids[i] != SPDK_BLOBID_INVALID);
+		CU_ASSERT(spdk_blob_get_parent_snapshot(bs, blobid[i]) == g_group_blobids[i]);
+		CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob[i]) == 0);
+
+		spdk_bs_open_blob(bs, g_group_blobids[i], blob_op_with_handle_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+		CU_ASSERT(spdk_blob_is_read_only(g_blob));
+		/* The cluster of the last blob already moved to the snapshot taken above */
+		CU_ASSERT(spdk_blob_get_num_allocated_clusters(g_blob) == (i == 2 ? 0 : 1));
+		rc = spdk_blob_get_xattr_value(g_blob, "name", &value, &value_len);
+		CU_ASSERT(rc == 0);
+		SPDK_CU_ASSERT_FATAL(value != NULL);
+		CU_ASSERT(value_len == strlen(names[i]));
+		CU_ASSERT(memcmp(value, names[i], value_len) == 0);
+		spdk_blob_close(g_blob, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+
+		/* Data written before the snapshot is read through it */
+		memset(payload, 0xff, sizeof(payload));
+		spdk_blob_io_read(blob[i], channel, payload, 0, 1, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(payload[0] == i);
+	}
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	for (i = 0; i < UT_SNAPSHOT_GROUP_SIZE; i++) {
+		ut_blob_close_and_delete(bs, blob[i]);
+	}
+}
+
 static void
 blob_clone(void)
 {
@@ -2193,6 +2345,98 @@ blob_iter(void)
 	CU_ASSERT(g_bserrno == -ENOENT);
 }
 
+struct iter_blobs_ctx {
+	spdk_blob_id	ids[16];
+	uint32_t	count;
+	uint32_t	stop_after;
+};
+
+static int
+iter_blobs_cb(void *cb_arg, struct spdk_blob *blob)
+{
+	struct iter_blobs_ctx *ctx = cb_arg;
+
+	SPDK_CU_ASSERT_FATAL(ctx->count < SPDK_COUNTOF(ctx->ids));
+	ctx->ids[ctx->count++] = spdk_blob_get_id(blob);
+
+	return ctx->count == ctx->stop_after ? -ECANCELED : 0;
+}
+
+static void
+blob_iter_blobs(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob *blob;
+	struct iter_blobs_ctx ctx = {};
+	spdk_blob_id blobids[10], snapshotid;
+	uint32_t i;
+
+	/* Empty blobstore */
+	spdk_bs_iter_blobs(bs, 4, iter_blobs_cb, blob_op_complete, &ctx);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(ctx.count == 0);
+
+	/* Keep the first blob open and create a snapshot of it, so that a clone and its
+	 * parent are part of the same batch. */
+	blob = ut_blob_create_and_open(bs, NULL);
+	blobids[0] = spdk_blob_get_id(blob);
+	for (i = 1; i < SPDK_COUNTOF(blobids); i++) {
+		g_blob = ut_blob_create_and_open(bs, NULL);
+		blobids[i] = spdk_blob_get_id(g_blob);
+		spdk_blob_close(g_blob, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	spdk_bs_create_snapshot(bs, blobids[0], NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid = g_blobid;
+
+	/* All blobs, including the snapshot, are passed in blob ID order */
+	spdk_bs_iter_blobs(bs, 4, iter_blobs_cb, blob_op_complete, &ctx);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(ctx.count == SPDK_COUNTOF(blobids) + 1);
+	for (i = 1; i < ctx.count; i++) {
+		CU_ASSERT(ctx.ids[i - 1] < ctx.ids[i]);
+	}
+	CU_ASSERT(ctx.ids[ctx.count - 1] == snapshotid);
+	CU_ASSERT(ctx.ids[0] == blobids[0]);
+
+	/* The blob that was already open stays open along with its snapshot, all the others
+	 * were closed */
+	CU_ASSERT(blob->open_ref == 1);
+	CU_ASSERT(spdk_bit_array_count_set(bs->open_blobids) == 2);
+
+	/* Queue depth of 1 opens a single blob at a time */
+	memset(&ctx, 0, sizeof(ctx));
+	spdk_bs_iter_blobs(bs, 1, iter_blobs_cb, blob_op_complete, &ctx);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(ctx.count == SPDK_COUNTOF(blobids) + 1);
+	CU_ASSERT(spdk_bit_array_count_set(bs->open_blobids) == 2);
+
+	/* Stop the iteration from the callback */
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.stop_after = 3;
+	spdk_bs_iter_blobs(bs, 4, iter_blobs_cb, blob_op_complete, &ctx);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -ECANCELED);
+	CU_ASSERT(ctx.count == 3);
+	CU_ASSERT(spdk_bit_array_count_set(bs->open_blobids) == 2);
+
+	ut_blob_close_and_delete(bs, blob);
+	for (i = 1; i < SPDK_COUNTOF(blobids); i++) {
+		spdk_bs_delete_blob(bs, blobids[i], blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+}
+
 static void
 blob_xattr(void)
 {
@@ -3023,6 +3267,129 @@ bs_test_recover_cluster_count(void)
 	g_bs = NULL;
 }
 
+static void
+bs_test_recover_scattered_md(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts opts;
+	struct spdk_blob *blob, *early, *late;
+	spdk_blob_id blobids[BS_REPLAY_WINDOW_PAGES + 64];
+	spdk_blob_id earlyid, lateid;
+	uint64_t free_clusters, used_md_pages;
+	size_t xattr_length, value_len;
+	const void *value;
+	char *xattr;
+	uint32_t i;
+	int rc;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&opts, sizeof(opts));
+	opts.num_md_pages = 2 * BS_REPLAY_WINDOW_PAGES;
+	spdk_bs_init(dev, &opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	/* Fill the first replay window with blobs, so that the last ones are in the second. */
+	for (i = 0; i < SPDK_COUNTOF(blobids); i++) {
+		spdk_bs_create_blob(bs, blob_op_with_id_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		blobids[i] = g_blobid;
+	}
+	earlyid = blobids[10];
+	lateid = blobids[SPDK_COUNTOF(blobids) - 1];
+	CU_ASSERT(bs_blobid_to_page(earlyid) < BS_REPLAY_WINDOW_PAGES);
+	CU_ASSERT(bs_blobid_to_page(lateid) >= BS_REPLAY_WINDOW_PAGES);
+
+	/* Free a page in the first window and have the extent page of the late blob take it,
+	 * so that it is referenced from a page scanned after it. */
+	spdk_bs_delete_blob(bs, blobids[5], blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_open_blob(bs, lateid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	late = g_blob;
+	spdk_blob_resize(late, 2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_sync_md(late, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(late->active.num_extent_pages == 1);
+	CU_ASSERT(late->active.extent_pages[0] < BS_REPLAY_WINDOW_PAGES);
+
+	/* The chain and extent pages of the early blob are in the second window. */
+	spdk_bs_open_blob(bs, earlyid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	early = g_blob;
+	xattr_length = 4072 - sizeof(struct spdk_blob_md_descriptor_xattr) - strlen("large_xattr");
+	xattr = calloc(xattr_length, sizeof(char));
+	SPDK_CU_ASSERT_FATAL(xattr != NULL);
+	memset(xattr, 0xA5, xattr_length);
+	rc = spdk_blob_set_xattr(early, "large_xattr", xattr, xattr_length);
+	CU_ASSERT(rc == 0);
+	spdk_blob_resize(early, 3, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_sync_md(early, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(early->active.num_pages > 1);
+	CU_ASSERT(early->active.pages[1] >= BS_REPLAY_WINDOW_PAGES);
+	SPDK_CU_ASSERT_FATAL(early->active.num_extent_pages == 1);
+	CU_ASSERT(early->active.extent_pages[0] >= BS_REPLAY_WINDOW_PAGES);
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	used_md_pages = spdk_bit_array_count_set(bs->used_md_pages);
+
+	spdk_blob_close(late, blob_op_complete, NULL);
+	poll_threads();
+	spdk_blob_close(early, blob_op_complete, NULL);
+	poll_threads();
+
+	/* Dirty shutdown */
+	ut_bs_dirty_load(&bs, &opts);
+
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_md_pages) == used_md_pages);
+	CU_ASSERT(spdk_bit_array_count_set(bs->used_blobids) == SPDK_COUNTOF(blobids) - 1);
+	CU_ASSERT(spdk_bit_array_get(bs->used_blobids, bs_blobid_to_page(blobids[5])) == false);
+
+	spdk_bs_open_blob(bs, earlyid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	blob = g_blob;
+	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 3);
+	rc = spdk_blob_get_xattr_value(blob, "large_xattr", &value, &value_len);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(value_len == xattr_length);
+	CU_ASSERT(value != NULL && memcmp(value, xattr, xattr_length) == 0);
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	free(xattr);
+
+	spdk_bs_open_blob(bs, lateid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	blob = g_blob;
+	CU_ASSERT(spdk_blob_get_num_clusters(blob) == 2);
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
 static void
 bs_grow_live_size(uint64_t new_blockcnt)
 {
@@ -4386,7 +4753,7 @@ blob_insert_cluster_msg_test(void)
 	CU_ASSERT(blob->active.clusters[cluster_num] == 0);
 	spdk_spin_unlock(&bs->used_lock);
 
-	blob_insert_cluster_on_md_thread(blob, cluster_num, new_cluster, extent_page, &page,
+	blob_insert_cluster_on_md_thread(blob, cluster_num, new_cluster, extent_page, &page, 0,
 					 blob_op_complete, NULL);
 	poll_threads();
 
@@ -4663,29 +5030,35 @@ blob_thin_prov_write_count_io(void)
 }
 
 static void
-blob_thin_prov_unmap_cluster(void)
+blob_thin_prov_reserved_clusters(void)
 {
 	struct spdk_blob_store *bs;
 	struct spdk_blob *blob;
-	struct spdk_io_channel *ch;
+	struct spdk_io_channel *ch0, *ch1;
+	struct spdk_bs_channel *bs_ch0, *bs_ch1;
 	struct spdk_bs_dev *dev;
 	struct spdk_bs_opts bs_opts;
 	struct spdk_blob_opts opts;
+	spdk_blob_id blobid;
 	uint64_t free_clusters;
 	uint64_t page_size;
+	uint64_t write_bytes;
 	uint8_t payload_write[4096];
-	uint8_t payload_read[4096];
-	const uint32_t CLUSTER_COUNT = 3;
+	const uint32_t CLUSTER_SZ = 8192;
+	struct spdk_blob_md_page pages[3] = {};
+	uint64_t new_cluster[3];
+	uint32_t extent_page = 0;
 	uint32_t pages_per_cluster;
+	uint32_t reserved;
+	uint32_t allocated = 4;
 	uint32_t i;
-	int err;
 
-	/* Use a very large cluster size for this test. Check how the unmap/release cluster code path behaves when
-	 * clusters are fully used.
-	 */
+	/* Use a small cluster size, so that there are enough free clusters for
+	 * the channels to reserve full batches of them. */
 	dev = init_dev();
 	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
-	bs_opts.cluster_sz = dev->blocklen * dev->blockcnt / (CLUSTER_COUNT + 1);
+	bs_opts.cluster_sz = CLUSTER_SZ;
+	bs_opts.num_md_pages = 128;
 
 	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
 	poll_threads();
@@ -4694,66 +5067,349 @@ blob_thin_prov_unmap_cluster(void)
 	bs = g_bs;
 
 	free_clusters = spdk_bs_free_cluster_count(bs);
+	SPDK_CU_ASSERT_FATAL(free_clusters / SPDK_BS_CHANNEL_RESERVE_FREE_DIVISOR >=
+			     SPDK_BS_CHANNEL_MAX_RESERVED_CLUSTERS);
 	page_size = spdk_bs_get_page_size(bs);
-	pages_per_cluster = bs_opts.cluster_sz / page_size;
+	pages_per_cluster = CLUSTER_SZ / page_size;
+	memset(payload_write, 0xE5, sizeof(payload_write));
 
-	ch = spdk_bs_alloc_io_channel(bs);
-	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	ch0 = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(ch0 != NULL);
+	bs_ch0 = spdk_io_channel_get_ctx(ch0);
+	set_thread(1);
+	ch1 = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(ch1 != NULL);
+	bs_ch1 = spdk_io_channel_get_ctx(ch1);
+	set_thread(0);
 
 	ut_spdk_blob_opts_init(&opts);
 	opts.thin_provision = true;
+	opts.num_clusters = SPDK_EXTENTS_PER_EP;
 
 	blob = ut_blob_create_and_open(bs, &opts);
-	CU_ASSERT(free_clusters == CLUSTER_COUNT);
+	blobid = spdk_blob_get_id(blob);
 	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
 
+	/* With extent table, the first write to the extent page allocates it together
+	 * with the cluster, without touching the reserve. */
 	g_bserrno = -1;
-	spdk_blob_resize(blob, CLUSTER_COUNT, blob_op_complete, NULL);
+	spdk_blob_io_write(blob, ch0, payload_write, 0, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 1);
+	reserved = g_use_extent_table ? 0 : SPDK_BS_CHANNEL_MAX_RESERVED_CLUSTERS - 1;
+	CU_ASSERT(bs_ch0->num_reserved_clusters == reserved);
 
+	/* Next write fills the reserve of the channel with a batch of clusters. */
 	g_bserrno = -1;
-	spdk_blob_sync_md(blob, blob_op_complete, NULL);
+	spdk_blob_io_write(blob, ch0, payload_write, pages_per_cluster, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
-	CU_ASSERT(blob->active.num_clusters == CLUSTER_COUNT);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 2);
+	reserved = SPDK_BS_CHANNEL_MAX_RESERVED_CLUSTERS - (g_use_extent_table ? 1 : 2);
+	CU_ASSERT(bs_ch0->num_reserved_clusters == reserved);
+	CU_ASSERT(bs->num_free_clusters == free_clusters - 2 - reserved);
+	CU_ASSERT(blob->active.clusters[1] == blob->active.clusters[0] + pages_per_cluster ||
+		  g_use_extent_table);
 
-	/* Fill all clusters */
-	for (i = 0; i < CLUSTER_COUNT; i++) {
-		memset(payload_write, i + 1, sizeof(payload_write));
+	/* Allocations from both channels come from their own reserves. */
+	g_bserrno = -1;
+	spdk_blob_io_write(blob, ch0, payload_write, pages_per_cluster * 2, 1, blob_op_complete, NULL);
+	set_thread(1);
+	spdk_blob_io_write(blob, ch1, payload_write, pages_per_cluster * 3, 1, blob_op_complete, NULL);
+	set_thread(0);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - 4);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 4);
+	CU_ASSERT(bs_ch0->num_reserved_clusters == reserved - 1);
+	CU_ASSERT(bs_ch1->num_reserved_clusters == SPDK_BS_CHANNEL_MAX_RESERVED_CLUSTERS - 1);
+
+	if (g_use_extent_table) {
+		/* Clusters inserted into an extent page while it is being written are
+		 * persisted together by a single subsequent write of the page. */
+		for (i = 0; i < 3; i++) {
+			spdk_spin_lock(&bs->used_lock);
+			bs_allocate_cluster(blob, 4 + i, &new_cluster[i], &extent_page, false);
+			spdk_spin_unlock(&bs->used_lock);
+			CU_ASSERT(extent_page == 0);
+		}
+
+		write_bytes = g_dev_write_bytes;
 		g_bserrno = -1;
-		spdk_blob_io_write(blob, ch, payload_write, pages_per_cluster * i, 1, blob_op_complete, NULL);
+		for (i = 0; i < 3; i++) {
+			blob_insert_cluster_on_md_thread(blob, 4 + i, new_cluster[i], 0, &pages[i], 0,
+							 blob_op_complete, NULL);
+		}
 		poll_threads();
 		CU_ASSERT(g_bserrno == 0);
-		CU_ASSERT(free_clusters - (i + 1) == spdk_bs_free_cluster_count(bs));
+		CU_ASSERT((g_dev_write_bytes - write_bytes) / page_size == 2);
+		allocated += 3;
+		CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == allocated);
+		CU_ASSERT(TAILQ_EMPTY(&bs->ep_persists));
 	}
-	CU_ASSERT(0 == spdk_bs_free_cluster_count(bs));
 
-	/* Unmap one whole cluster */
-	g_bserrno = -1;
-	spdk_blob_io_unmap(blob, ch, pages_per_cluster, pages_per_cluster, blob_op_complete, NULL);
+	/* Destroying the channel returns its reserve. */
+	set_thread(1);
+	spdk_bs_free_io_channel(ch1);
+	set_thread(0);
 	poll_threads();
-	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(1 == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - allocated);
+	CU_ASSERT(bs->num_free_clusters == free_clusters - allocated - bs_ch0->num_reserved_clusters);
 
-	/* Verify the data read from the cluster is zeroed out */
-	memset(payload_write, 0, sizeof(payload_write));
-	spdk_blob_io_read(blob, ch, payload_read, pages_per_cluster, 1, blob_op_complete, NULL);
+	spdk_blob_close(blob, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 4096) == 0);
 
-	/* Fill the same cluster with data */
-	memset(payload_write, 3, sizeof(payload_write));
+	/* Unloading with a channel still holding a reserve must not persist the
+	 * reserved clusters as used. */
 	g_bserrno = -1;
-	spdk_blob_io_write(blob, ch, payload_write, pages_per_cluster, 1, blob_op_complete, NULL);
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(bs_ch0->num_reserved_clusters == 0);
+	/* Unload completes once the last channel is released. */
+	spdk_bs_free_io_channel(ch0);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(0 == spdk_bs_free_cluster_count(bs));
+	g_bs = NULL;
 
-	/* Verify the data read from the cluster has the expected data */
-	spdk_blob_io_read(blob, ch, payload_read, pages_per_cluster, 1, blob_op_complete, NULL);
+	dev = init_dev();
+	spdk_bs_load(dev, NULL, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters - allocated);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == allocated);
+
+	ut_blob_close_and_delete(bs, blob);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == free_clusters);
+	g_blob = NULL;
+	g_blobid = 0;
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
+static void
+blob_thin_prov_reserved_clusters_reclaim(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_blob *blob, *thick;
+	struct spdk_io_channel *ch0, *ch1;
+	struct spdk_bs_channel *bs_ch0, *bs_ch1;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob_opts opts;
+	uint64_t pages_per_cluster;
+	uint64_t cluster = 0;
+	uint8_t payload_write[4096];
+	const uint32_t CLUSTER_SZ = 8192;
+	uint32_t reserved;
+	uint32_t i;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	bs_opts.cluster_sz = CLUSTER_SZ;
+	bs_opts.num_md_pages = 128;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	pages_per_cluster = CLUSTER_SZ / spdk_bs_get_page_size(bs);
+	memset(payload_write, 0xE5, sizeof(payload_write));
+
+	ch0 = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(ch0 != NULL);
+	bs_ch0 = spdk_io_channel_get_ctx(ch0);
+	set_thread(1);
+	ch1 = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(ch1 != NULL);
+	bs_ch1 = spdk_io_channel_get_ctx(ch1);
+	set_thread(0);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.num_clusters = SPDK_EXTENTS_PER_EP;
+	blob = ut_blob_create_and_open(bs, &opts);
+
+	/* The first write may allocate an extent page, so let both channels fill their
+	 * reserves with the next ones. */
+	for (i = 0; i < 3; i++) {
+		set_thread(i == 2 ? 1 : 0);
+		spdk_blob_io_write(blob, i == 2 ? ch1 : ch0, payload_write, cluster++ * pages_per_cluster, 1,
+				   blob_op_complete, NULL);
+		set_thread(0);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	CU_ASSERT(bs_ch0->num_reserved_clusters > 0);
+	CU_ASSERT(bs_ch1->num_reserved_clusters > 0);
+
+	/* Creating a thick blob that only fits with the reserved clusters takes them back. */
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = spdk_bs_free_cluster_count(bs);
+	thick = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(spdk_blob_get_num_clusters(thick) == opts.num_clusters);
+	CU_ASSERT(bs_ch0->num_reserved_clusters == 0);
+	CU_ASSERT(bs_ch1->num_reserved_clusters == 0);
+	CU_ASSERT(bs->num_reserved_clusters == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == 0);
+	ut_blob_close_and_delete(bs, thick);
+
+	/* Refill the reserves of both channels. */
+	for (i = 0; i < 2; i++) {
+		set_thread(i);
+		spdk_blob_io_write(blob, i == 0 ? ch0 : ch1, payload_write, cluster++ * pages_per_cluster, 1,
+				   blob_op_complete, NULL);
+		set_thread(0);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+	reserved = bs_ch1->num_reserved_clusters;
+	CU_ASSERT(bs_ch0->num_reserved_clusters > 0);
+	CU_ASSERT(reserved > 0);
+
+	/* Use up the free pool and the reserve of the first channel. */
+	ut_spdk_blob_opts_init(&opts);
+	opts.num_clusters = bs->num_free_clusters;
+	thick = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(bs->num_free_clusters == 0);
+	CU_ASSERT(bs_ch1->num_reserved_clusters == reserved);
+
+	while (bs_ch0->num_reserved_clusters > 0) {
+		spdk_blob_io_write(blob, ch0, payload_write, cluster++ * pages_per_cluster, 1,
+				   blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	/* The next allocation takes the clusters reserved by the other channel. */
+	g_bserrno = -1;
+	spdk_blob_io_write(blob, ch0, payload_write, cluster++ * pages_per_cluster, 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs_ch1->num_reserved_clusters == 0);
+	CU_ASSERT(spdk_bs_free_cluster_count(bs) == reserved - 1);
+
+	ut_blob_close_and_delete(bs, thick);
+	ut_blob_close_and_delete(bs, blob);
+
+	set_thread(1);
+	spdk_bs_free_io_channel(ch1);
+	set_thread(0);
+	spdk_bs_free_io_channel(ch0);
+	poll_threads();
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+}
+
+static void
+blob_thin_prov_unmap_cluster(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *ch;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob_opts opts;
+	uint64_t free_clusters;
+	uint64_t page_size;
+	uint8_t payload_write[4096];
+	uint8_t payload_read[4096];
+	const uint32_t CLUSTER_COUNT = 3;
+	uint32_t pages_per_cluster;
+	uint32_t i;
+	int err;
+
+	/* Use a very large cluster size for this test. Check how the unmap/release cluster code path behaves when
+	 * clusters are fully used.
+	 */
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	bs_opts.cluster_sz = dev->blocklen * dev->blockcnt / (CLUSTER_COUNT + 1);
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+
+	free_clusters = spdk_bs_free_cluster_count(bs);
+	page_size = spdk_bs_get_page_size(bs);
+	pages_per_cluster = bs_opts.cluster_sz / page_size;
+
+	ch = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	CU_ASSERT(free_clusters == CLUSTER_COUNT);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+
+	g_bserrno = -1;
+	spdk_blob_resize(blob, CLUSTER_COUNT, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	g_bserrno = -1;
+	spdk_blob_sync_md(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(free_clusters == spdk_bs_free_cluster_count(bs));
+	CU_ASSERT(blob->active.num_clusters == CLUSTER_COUNT);
+
+	/* Fill all clusters */
+	for (i = 0; i < CLUSTER_COUNT; i++) {
+		memset(payload_write, i + 1, sizeof(payload_write));
+		g_bserrno = -1;
+		spdk_blob_io_write(blob, ch, payload_write, pages_per_cluster * i, 1, blob_op_complete, NULL);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(free_clusters - (i + 1) == spdk_bs_free_cluster_count(bs));
+	}
+	CU_ASSERT(0 == spdk_bs_free_cluster_count(bs));
+
+	/* Unmap one whole cluster */
+	g_bserrno = -1;
+	spdk_blob_io_unmap(blob, ch, pages_per_cluster, pages_per_cluster, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(1 == spdk_bs_free_cluster_count(bs));
+
+	/* Verify the data read from the cluster is zeroed out */
+	memset(payload_write, 0, sizeof(payload_write));
+	spdk_blob_io_read(blob, ch, payload_read, pages_per_cluster, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 4096) == 0);
+
+	/* Fill the same cluster with data */
+	memset(payload_write, 3, sizeof(payload_write));
+	g_bserrno = -1;
+	spdk_blob_io_write(blob, ch, payload_write, pages_per_cluster, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(0 == spdk_bs_free_cluster_count(bs));
+
+	/* Verify the data read from the cluster has the expected data */
+	spdk_blob_io_read(blob, ch, payload_read, pages_per_cluster, 1, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
 	CU_ASSERT(memcmp(payload_write, payload_read, 4096) == 0);
@@ -5279,57 +5935,330 @@ blob_snapshot_rw_iov(void)
 	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
 	snapshotid = g_blobid;
 
-	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	spdk_bs_open_blob(bs, snapshotid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot = g_blob;
+	CU_ASSERT(snapshot->data_ro == true);
+	CU_ASSERT(snapshot->md_ro == true);
+	CU_ASSERT(spdk_blob_get_num_clusters(snapshot) == 5);
+
+	/* Payload should be all zeros from unallocated clusters */
+	memset(payload_read, 0xAA, sizeof(payload_read));
+	iov_read[0].iov_base = payload_read;
+	iov_read[0].iov_len = 3 * 4096;
+	iov_read[1].iov_base = payload_read + 3 * 4096;
+	iov_read[1].iov_len = 4 * 4096;
+	iov_read[2].iov_base = payload_read + 7 * 4096;
+	iov_read[2].iov_len = 3 * 4096;
+	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	iov_write[0].iov_base = payload_write;
+	iov_write[0].iov_len = 1 * 4096;
+	iov_write[1].iov_base = payload_write + 1 * 4096;
+	iov_write[1].iov_len = 5 * 4096;
+	iov_write[2].iov_base = payload_write + 6 * 4096;
+	iov_write[2].iov_len = 4 * 4096;
+
+	spdk_blob_io_writev(blob, channel, iov_write, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	memset(payload_read, 0xAA, sizeof(payload_read));
+	iov_read[0].iov_base = payload_read;
+	iov_read[0].iov_len = 3 * 4096;
+	iov_read[1].iov_base = payload_read + 3 * 4096;
+	iov_read[1].iov_len = 4 * 4096;
+	iov_read[2].iov_base = payload_read + 7 * 4096;
+	iov_read[2].iov_len = 3 * 4096;
+	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+	ut_blob_close_and_delete(bs, snapshot);
+}
+
+static void
+blob_partial_cow(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob_opts opts;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	spdk_blob_id blobid, snapshotid;
+	const uint32_t CLUSTER_SZ = 16 * 4096;
+	const uint32_t COW_UNIT_SZ = 2 * 4096;
+	uint8_t payload_read[16 * 4096];
+	uint8_t expected[16 * 4096];
+	uint8_t payload_write[4096];
+	uint64_t page_size;
+	uint64_t write_bytes_start, read_bytes_start, copy_bytes_start;
+	uint64_t write_bytes, read_bytes, copy_bytes;
+	uint64_t i;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	bs_opts.cluster_sz = CLUSTER_SZ;
+	bs_opts.cow_unit_size = COW_UNIT_SZ;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	page_size = spdk_bs_get_page_size(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	/* Partial copy-on-write needs extent pages to persist the bitmaps in */
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.use_extent_table = true;
+	opts.num_clusters = 2;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+	CU_ASSERT(blob->invalid_flags & SPDK_BLOB_PARTIAL_COW);
+
+	for (i = 0; i < CLUSTER_SZ / page_size; i++) {
+		memset(expected + i * page_size, i + 1, page_size);
+	}
+	spdk_blob_io_write(blob, channel, expected, 0, CLUSTER_SZ / page_size, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_blobid != SPDK_BLOBID_INVALID);
+	snapshotid = g_blobid;
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 0);
+
+	/* First write to the cluster of the clone copies only the unit it touches,
+	 * then writes the payload, a new extent page and metadata page. */
+	write_bytes_start = g_dev_write_bytes;
+	read_bytes_start = g_dev_read_bytes;
+	copy_bytes_start = g_dev_copy_bytes;
+
+	memset(payload_write, 0xE5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 3, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	memcpy(expected + 3 * page_size, payload_write, page_size);
+
+	write_bytes = g_dev_write_bytes - write_bytes_start;
+	read_bytes = g_dev_read_bytes - read_bytes_start;
+	copy_bytes = g_dev_copy_bytes - copy_bytes_start;
+	CU_ASSERT(read_bytes + copy_bytes == COW_UNIT_SZ);
+	CU_ASSERT(write_bytes + copy_bytes == COW_UNIT_SZ + page_size * 3);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 1);
+	CU_ASSERT(blob_cluster_cow_bitmap(blob, 0) == 0x2);
+
+	/* Rest of the cluster is still read from the snapshot */
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 0, CLUSTER_SZ / page_size, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, expected, CLUSTER_SZ) == 0);
+	CU_ASSERT(spdk_blob_get_next_allocated_io_unit(blob, 0) == 2);
+	CU_ASSERT(spdk_blob_get_next_unallocated_io_unit(blob, 2) == 4);
+
+	/* Write to another unit copies it into the allocated cluster and updates its extent page */
+	write_bytes_start = g_dev_write_bytes;
+	read_bytes_start = g_dev_read_bytes;
+	copy_bytes_start = g_dev_copy_bytes;
+
+	memset(payload_write, 0xA5, sizeof(payload_write));
+	spdk_blob_io_write(blob, channel, payload_write, 10, 1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	memcpy(expected + 10 * page_size, payload_write, page_size);
+
+	write_bytes = g_dev_write_bytes - write_bytes_start;
+	read_bytes = g_dev_read_bytes - read_bytes_start;
+	copy_bytes = g_dev_copy_bytes - copy_bytes_start;
+	CU_ASSERT(read_bytes + copy_bytes == COW_UNIT_SZ);
+	CU_ASSERT(write_bytes + copy_bytes == COW_UNIT_SZ + page_size * 2);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 1);
+	CU_ASSERT(blob_cluster_cow_bitmap(blob, 0) == 0x22);
+
+	/* Bitmaps are persisted in the extent page */
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+	spdk_blob_close(blob, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+
+	ut_bs_reload(&bs, NULL);
+	CU_ASSERT(bs->cow_unit_size == COW_UNIT_SZ);
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	spdk_bs_open_blob(bs, blobid, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	blob = g_blob;
+	CU_ASSERT(blob_cluster_cow_bitmap(blob, 0) == 0x22);
+
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 0, CLUSTER_SZ / page_size, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, expected, CLUSTER_SZ) == 0);
+
+	/* Deleting the snapshot completes the partially copied cluster of the clone */
+	spdk_bs_delete_blob(bs, snapshotid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob->parent_id == SPDK_BLOBID_INVALID);
+	CU_ASSERT(blob_cluster_cow_bitmap(blob, 0) == 0);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 1);
+
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 0, CLUSTER_SZ / page_size, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(payload_read, expected, CLUSTER_SZ) == 0);
+
+	spdk_bs_free_io_channel(channel);
+	poll_threads();
+
+	ut_blob_close_and_delete(bs, blob);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
+}
+
+/* Check that a copy-on-write unit of a cluster is never marked present before its data is */
+static void
+ut_check_cow_unit_data(struct spdk_blob *blob, uint64_t cluster_num, uint32_t unit,
+		       const uint8_t *data)
+{
+	struct spdk_blob_store *bs = blob->bs;
+	uint64_t bitmap = blob_cluster_cow_bitmap(blob, cluster_num);
+	uint64_t lba = blob->active.clusters[cluster_num];
+
+	if (lba == 0 || (bitmap != 0 && (bitmap & (1ULL << unit)) == 0)) {
+		return;
+	}
+
+	CU_ASSERT(memcmp(&g_dev_buffer[lba * bs->dev->blocklen + (uint64_t)unit * bs->cow_unit_size],
+			 data, bs->cow_unit_size) == 0);
+}
+
+static void
+blob_partial_cow_covered_units(void)
+{
+	struct spdk_blob_store *bs;
+	struct spdk_bs_dev *dev;
+	struct spdk_bs_opts bs_opts;
+	struct spdk_blob_opts opts;
+	struct spdk_blob *blob;
+	struct spdk_io_channel *channel;
+	spdk_blob_id blobid;
+	const uint32_t CLUSTER_SZ = 16 * 4096;
+	const uint32_t COW_UNIT_SZ = 2 * 4096;
+	uint8_t payload_read[16 * 4096];
+	uint8_t expected[16 * 4096];
+	uint8_t payload_write[2 * 4096];
+	uint64_t page_size;
+	uint64_t i;
+
+	dev = init_dev();
+	spdk_bs_opts_init(&bs_opts, sizeof(bs_opts));
+	bs_opts.cluster_sz = CLUSTER_SZ;
+	bs_opts.cow_unit_size = COW_UNIT_SZ;
+
+	spdk_bs_init(dev, &bs_opts, bs_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_bs != NULL);
+	bs = g_bs;
+	page_size = spdk_bs_get_page_size(bs);
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&opts);
+	opts.thin_provision = true;
+	opts.use_extent_table = true;
+	opts.num_clusters = 1;
+
+	blob = ut_blob_create_and_open(bs, &opts);
+	blobid = spdk_blob_get_id(blob);
+
+	for (i = 0; i < CLUSTER_SZ / page_size; i++) {
+		memset(expected + i * page_size, i + 1, page_size);
+	}
+	spdk_blob_io_write(blob, channel, expected, 0, CLUSTER_SZ / page_size, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
-	snapshot = g_blob;
-	CU_ASSERT(snapshot->data_ro == true);
-	CU_ASSERT(snapshot->md_ro == true);
-	CU_ASSERT(spdk_blob_get_num_clusters(snapshot) == 5);
 
-	/* Payload should be all zeros from unallocated clusters */
-	memset(payload_read, 0xAA, sizeof(payload_read));
-	iov_read[0].iov_base = payload_read;
-	iov_read[0].iov_len = 3 * 4096;
-	iov_read[1].iov_base = payload_read + 3 * 4096;
-	iov_read[1].iov_len = 4 * 4096;
-	iov_read[2].iov_base = payload_read + 7 * 4096;
-	iov_read[2].iov_len = 3 * 4096;
-	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(zero, payload_read, 10 * 4096) == 0);
+	CU_ASSERT(spdk_blob_get_num_allocated_clusters(blob) == 0);
 
+	/* The write covers unit 2 whole, so it is not copied from the snapshot. Reads must
+	 * keep going to the snapshot until the written data is on disk. */
 	memset(payload_write, 0xE5, sizeof(payload_write));
-	iov_write[0].iov_base = payload_write;
-	iov_write[0].iov_len = 1 * 4096;
-	iov_write[1].iov_base = payload_write + 1 * 4096;
-	iov_write[1].iov_len = 5 * 4096;
-	iov_write[2].iov_base = payload_write + 6 * 4096;
-	iov_write[2].iov_len = 4 * 4096;
+	g_bserrno = -1;
+	spdk_blob_io_write(blob, channel, payload_write, 4, 2, blob_op_complete, NULL);
+	while (g_bserrno == -1) {
+		poll_thread_times(0, 1);
+		ut_check_cow_unit_data(blob, 0, 2, payload_write);
+	}
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob_cluster_cow_bitmap(blob, 0) == 0x4);
+	memcpy(expected + 4 * page_size, payload_write, sizeof(payload_write));
 
-	spdk_blob_io_writev(blob, channel, iov_write, 3, 250, 10, blob_op_complete, NULL);
-	poll_threads();
+	/* Same for a unit filled into the partially copied cluster */
+	memset(payload_write, 0xA5, sizeof(payload_write));
+	g_bserrno = -1;
+	spdk_blob_io_write(blob, channel, payload_write, 10, 2, blob_op_complete, NULL);
+	while (g_bserrno == -1) {
+		poll_thread_times(0, 1);
+		ut_check_cow_unit_data(blob, 0, 5, payload_write);
+	}
 	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(blob_cluster_cow_bitmap(blob, 0) == 0x24);
+	memcpy(expected + 10 * page_size, payload_write, sizeof(payload_write));
 
-	memset(payload_read, 0xAA, sizeof(payload_read));
-	iov_read[0].iov_base = payload_read;
-	iov_read[0].iov_len = 3 * 4096;
-	iov_read[1].iov_base = payload_read + 3 * 4096;
-	iov_read[1].iov_len = 4 * 4096;
-	iov_read[2].iov_base = payload_read + 7 * 4096;
-	iov_read[2].iov_len = 3 * 4096;
-	spdk_blob_io_readv(blob, channel, iov_read, 3, 250, 10, blob_op_complete, NULL);
+	memset(payload_read, 0, sizeof(payload_read));
+	spdk_blob_io_read(blob, channel, payload_read, 0, CLUSTER_SZ / page_size, blob_op_complete, NULL);
 	poll_threads();
 	CU_ASSERT(g_bserrno == 0);
-	CU_ASSERT(memcmp(payload_write, payload_read, 10 * 4096) == 0);
+	CU_ASSERT(memcmp(payload_read, expected, CLUSTER_SZ) == 0);
 
 	spdk_bs_free_io_channel(channel);
 	poll_threads();
 
 	ut_blob_close_and_delete(bs, blob);
-	ut_blob_close_and_delete(bs, snapshot);
+
+	spdk_bs_unload(bs, bs_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	g_bs = NULL;
+	g_blob = NULL;
+	g_blobid = 0;
 }
 
 /**
@@ -9530,6 +10459,338 @@ blob_shallow_copy(void)
 	poll_threads();
 }
 
+static void
+ut_blob_write_cluster(struct spdk_blob *blob, struct spdk_io_channel *channel, uint64_t cluster,
+		      uint8_t pattern)
+{
+	uint8_t buf[DEV_BUFFER_BLOCKLEN];
+
+	memset(buf, pattern, sizeof(buf));
+	spdk_blob_io_write(blob, channel, buf, cluster * bs_io_units_per_cluster(blob), 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+}
+
+static void
+ut_check_changed_clusters(struct spdk_blob *blob, spdk_blob_id ancestor_id, const char *expected)
+{
+	struct spdk_bit_array *changed = NULL;
+	uint32_t i;
+	int rc;
+
+	rc = spdk_blob_get_changed_clusters(blob, ancestor_id, &changed);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(changed != NULL);
+	CU_ASSERT(spdk_bit_array_capacity(changed) == strlen(expected));
+	for (i = 0; i < strlen(expected); i++) {
+		CU_ASSERT(spdk_bit_array_get(changed, i) == (expected[i] == '1'));
+	}
+	spdk_bit_array_free(&changed);
+}
+
+static void
+blob_changed_clusters(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob_opts blob_opts;
+	struct spdk_blob *blob, *snapshot1, *snapshot2;
+	struct spdk_bit_array *changed = NULL;
+	spdk_blob_id blobid, snapshotid1, snapshotid2;
+	uint64_t num_clusters = 4;
+	struct spdk_bs_dev *ext_dev;
+	struct spdk_bs_dev_cb_args ext_args;
+	struct spdk_io_channel *bdev_ch, *blob_ch;
+	uint8_t buf1[DEV_BUFFER_BLOCKLEN];
+	uint8_t buf2[DEV_BUFFER_BLOCKLEN];
+	uint64_t io_units_per_cluster;
+	uint64_t cluster;
+	int rc;
+
+	blob_ch = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(blob_ch != NULL);
+
+	ut_spdk_blob_opts_init(&blob_opts);
+	blob_opts.thin_provision = true;
+	blob_opts.num_clusters = num_clusters;
+
+	blob = ut_blob_create_and_open(bs, &blob_opts);
+	SPDK_CU_ASSERT_FATAL(blob != NULL);
+	blobid = spdk_blob_get_id(blob);
+	io_units_per_cluster = bs_io_units_per_cluster(blob);
+
+	/* Build the chain snapshot1 <- snapshot2 <- blob with
+	 * snapshot1 owning cluster 0, snapshot2 clusters 1 and 2 and blob clusters 2 and 3 */
+	ut_blob_write_cluster(blob, blob_ch, 0, 0x10);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid1 = g_blobid;
+
+	ut_blob_write_cluster(blob, blob_ch, 1, 0x21);
+	ut_blob_write_cluster(blob, blob_ch, 2, 0x22);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid2 = g_blobid;
+
+	ut_blob_write_cluster(blob, blob_ch, 2, 0x32);
+	ut_blob_write_cluster(blob, blob_ch, 3, 0x33);
+
+	spdk_bs_open_blob(bs, snapshotid1, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot1 = g_blob;
+
+	spdk_bs_open_blob(bs, snapshotid2, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot2 = g_blob;
+
+	ut_check_changed_clusters(blob, snapshotid2, "0011");
+	ut_check_changed_clusters(blob, snapshotid1, "0111");
+	ut_check_changed_clusters(blob, SPDK_BLOBID_INVALID, "1111");
+	ut_check_changed_clusters(snapshot2, snapshotid1, "0110");
+	ut_check_changed_clusters(snapshot1, SPDK_BLOBID_INVALID, "1000");
+
+	/* Only ancestors can be compared against */
+	rc = spdk_blob_get_changed_clusters(snapshot1, snapshotid2, &changed);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(changed == NULL);
+	rc = spdk_blob_get_changed_clusters(blob, blobid, &changed);
+	CU_ASSERT(rc == -EINVAL);
+	CU_ASSERT(changed == NULL);
+
+	/* Incremental shallow copy against a blob which is not an ancestor */
+	ext_dev = init_ext_dev(num_clusters * 1024 * 1024, DEV_BUFFER_BLOCKLEN);
+	rc = spdk_bs_blob_shallow_copy_incremental(bs, blob_ch, snapshotid1, snapshotid2, ext_dev,
+			blob_shallow_copy_status_cb, NULL,
+			blob_op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(g_bserrno == -EINVAL);
+	ext_dev->destroy(ext_dev);
+
+	ext_dev = init_ext_dev(num_clusters * 1024 * 1024, DEV_BUFFER_BLOCKLEN);
+	bdev_ch = ext_dev->create_channel(ext_dev);
+	SPDK_CU_ASSERT_FATAL(bdev_ch != NULL);
+	ext_args.cb_fn = bs_dev_io_complete_cb;
+	memset(buf2, 0xff, DEV_BUFFER_BLOCKLEN);
+	for (cluster = 0; cluster < num_clusters; cluster++) {
+		ext_dev->write(ext_dev, bdev_ch, buf2, cluster * io_units_per_cluster, 1, &ext_args);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+	}
+
+	/* Copy only what snapshot2 changed on top of snapshot1 */
+	g_copied_clusters_count = 0;
+	rc = spdk_bs_blob_shallow_copy_incremental(bs, blob_ch, snapshotid2, snapshotid1, ext_dev,
+			blob_shallow_copy_status_cb, NULL,
+			blob_op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(g_copied_clusters_count == 2);
+
+	/* Clusters 1 and 2 hold the data of snapshot2, the others were not touched */
+	for (cluster = 0; cluster < num_clusters; cluster++) {
+		if (cluster == 1 || cluster == 2) {
+			memset(buf1, 0x20 + cluster, DEV_BUFFER_BLOCKLEN);
+		} else {
+			memset(buf1, 0xff, DEV_BUFFER_BLOCKLEN);
+		}
+		ext_dev->read(ext_dev, bdev_ch, buf2, cluster * io_units_per_cluster, 1, &ext_args);
+		poll_threads();
+		CU_ASSERT(g_bserrno == 0);
+		CU_ASSERT(memcmp(buf1, buf2, DEV_BUFFER_BLOCKLEN) == 0);
+	}
+
+	ext_dev->destroy_channel(ext_dev, bdev_ch);
+	ext_dev->destroy(ext_dev);
+	spdk_blob_close(snapshot2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_close(snapshot1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_free_io_channel(blob_ch);
+	ut_blob_close_and_delete(bs, blob);
+	poll_threads();
+}
+
+static void
+ut_blob_check_cluster(struct spdk_blob *blob, struct spdk_io_channel *channel, uint64_t cluster,
+		      uint8_t pattern)
+{
+	uint8_t expected[DEV_BUFFER_BLOCKLEN];
+	uint8_t buf[DEV_BUFFER_BLOCKLEN];
+	struct iovec iov = { .iov_base = buf, .iov_len = sizeof(buf) };
+
+	memset(expected, pattern, sizeof(expected));
+
+	memset(buf, 0xaa, sizeof(buf));
+	spdk_blob_io_read(blob, channel, buf, cluster * bs_io_units_per_cluster(blob), 1,
+			  blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(buf, expected, sizeof(buf)) == 0);
+
+	memset(buf, 0xaa, sizeof(buf));
+	spdk_blob_io_readv(blob, channel, &iov, 1, cluster * bs_io_units_per_cluster(blob), 1,
+			   blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(memcmp(buf, expected, sizeof(buf)) == 0);
+}
+
+static struct spdk_bs_chain_cache_entry *
+ut_chain_cache_find(struct spdk_io_channel *channel, struct spdk_blob *blob, uint64_t cluster)
+{
+	struct spdk_bs_channel *ch = spdk_io_channel_get_ctx(channel);
+	uint32_t i;
+
+	for (i = 0; i < SPDK_BS_CHANNEL_CHAIN_CACHE_SIZE; i++) {
+		if (ch->chain_cache[i].gen == blob->bs->chain_gen &&
+		    ch->chain_cache[i].blobid == blob->id && ch->chain_cache[i].cluster == cluster) {
+			return &ch->chain_cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void
+blob_chain_cache(void)
+{
+	struct spdk_blob_store *bs = g_bs;
+	struct spdk_blob_opts blob_opts;
+	struct spdk_blob *blob, *snapshot1, *snapshot3;
+	struct spdk_bs_chain_cache_entry *entry;
+	spdk_blob_id blobid, snapshotid1, snapshotid2, snapshotid3;
+	struct spdk_io_channel *channel;
+	uint64_t gen;
+
+	channel = spdk_bs_alloc_io_channel(bs);
+	SPDK_CU_ASSERT_FATAL(channel != NULL);
+
+	ut_spdk_blob_opts_init(&blob_opts);
+	blob_opts.thin_provision = true;
+	blob_opts.num_clusters = 4;
+
+	blob = ut_blob_create_and_open(bs, &blob_opts);
+	SPDK_CU_ASSERT_FATAL(blob != NULL);
+	blobid = spdk_blob_get_id(blob);
+
+	/* Build the chain snapshot1 <- snapshot2 <- snapshot3 <- blob with snapshot1 owning
+	 * cluster 0, snapshot2 cluster 1, snapshot3 cluster 2 and cluster 3 not allocated at all */
+	ut_blob_write_cluster(blob, channel, 0, 0x10);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid1 = g_blobid;
+
+	ut_blob_write_cluster(blob, channel, 1, 0x21);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid2 = g_blobid;
+
+	ut_blob_write_cluster(blob, channel, 2, 0x32);
+	spdk_bs_create_snapshot(bs, blobid, NULL, blob_op_with_id_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	snapshotid3 = g_blobid;
+
+	spdk_bs_open_blob(bs, snapshotid1, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot1 = g_blob;
+
+	spdk_bs_open_blob(bs, snapshotid3, blob_op_with_handle_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_blob != NULL);
+	snapshot3 = g_blob;
+
+	/* Reads resolve each cluster to the snapshot owning it and cache the result */
+	ut_blob_check_cluster(blob, channel, 0, 0x10);
+	ut_blob_check_cluster(blob, channel, 1, 0x21);
+	ut_blob_check_cluster(blob, channel, 2, 0x32);
+	ut_blob_check_cluster(blob, channel, 3, 0x00);
+
+	entry = ut_chain_cache_find(channel, blob, 0);
+	SPDK_CU_ASSERT_FATAL(entry != NULL);
+	CU_ASSERT(entry->lba == snapshot1->active.clusters[0]);
+	entry = ut_chain_cache_find(channel, blob, 2);
+	SPDK_CU_ASSERT_FATAL(entry != NULL);
+	CU_ASSERT(entry->lba == snapshot3->active.clusters[2]);
+	entry = ut_chain_cache_find(channel, blob, 3);
+	SPDK_CU_ASSERT_FATAL(entry != NULL);
+	CU_ASSERT(entry->lba == SPDK_BS_CHAIN_CACHE_LBA_ZEROES);
+
+	/* Deleting a snapshot from the middle of the chain invalidates the cache */
+	gen = bs->chain_gen;
+	spdk_bs_delete_blob(bs, snapshotid2, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->chain_gen != gen);
+	CU_ASSERT(ut_chain_cache_find(channel, blob, 1) == NULL);
+
+	ut_blob_check_cluster(blob, channel, 0, 0x10);
+	ut_blob_check_cluster(blob, channel, 1, 0x21);
+	ut_blob_check_cluster(blob, channel, 2, 0x32);
+	ut_blob_check_cluster(blob, channel, 3, 0x00);
+	entry = ut_chain_cache_find(channel, blob, 1);
+	SPDK_CU_ASSERT_FATAL(entry != NULL);
+	CU_ASSERT(entry->lba == snapshot3->active.clusters[1]);
+
+	/* Switching to another parent does as well */
+	gen = bs->chain_gen;
+	spdk_bs_blob_set_parent(bs, blobid, snapshotid1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->chain_gen != gen);
+
+	ut_blob_check_cluster(blob, channel, 0, 0x10);
+	ut_blob_check_cluster(blob, channel, 1, 0x00);
+	ut_blob_check_cluster(blob, channel, 2, 0x00);
+	entry = ut_chain_cache_find(channel, blob, 1);
+	SPDK_CU_ASSERT_FATAL(entry != NULL);
+	CU_ASSERT(entry->lba == SPDK_BS_CHAIN_CACHE_LBA_ZEROES);
+
+	/* And decoupling the blob from its parent */
+	gen = bs->chain_gen;
+	spdk_bs_blob_decouple_parent(bs, channel, blobid, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	CU_ASSERT(bs->chain_gen != gen);
+	CU_ASSERT(ut_chain_cache_find(channel, blob, 0) == NULL);
+
+	ut_blob_check_cluster(blob, channel, 0, 0x10);
+	ut_blob_check_cluster(blob, channel, 1, 0x00);
+	/* Without a snapshot parent there is no chain left to cache */
+	CU_ASSERT(ut_chain_cache_find(channel, blob, 1) == NULL);
+
+	spdk_blob_close(snapshot3, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_blob_close(snapshot1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_free_io_channel(channel);
+	ut_blob_close_and_delete(bs, blob);
+	poll_threads();
+	spdk_bs_delete_blob(bs, snapshotid3, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+	spdk_bs_delete_blob(bs, snapshotid1, blob_op_complete, NULL);
+	poll_threads();
+	CU_ASSERT(g_bserrno == 0);
+}
+
 static void
 blob_set_parent(void)
 {
@@ -10025,6 +11286,7 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite_blob, blob_rw_iov_read_only);
 		CU_ADD_TEST(suite_bs, blob_unmap);
 		CU_ADD_TEST(suite_bs, blob_iter);
+		CU_ADD_TEST(suite_bs, blob_iter_blobs);
 		CU_ADD_TEST(suite_blob, blob_xattr);
 		CU_ADD_TEST(suite_bs, blob_parse_md);
 		CU_ADD_TEST(suite, bs_load);
@@ -10039,6 +11301,7 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite, bs_type);
 		CU_ADD_TEST(suite, bs_super_block);
 		CU_ADD_TEST(suite, bs_test_recover_cluster_count);
+		CU_ADD_TEST(suite, bs_test_recover_scattered_md);
 		CU_ADD_TEST(suite, bs_grow_live);
 		CU_ADD_TEST(suite, bs_grow_live_no_space);
 		CU_ADD_TEST(suite, bs_test_grow);
@@ -10053,12 +11316,16 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite_bs, blob_insert_cluster_msg_test);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_rw);
 		CU_ADD_TEST(suite, blob_thin_prov_write_count_io);
+		CU_ADD_TEST(suite, blob_thin_prov_reserved_clusters);
+		CU_ADD_TEST(suite, blob_thin_prov_reserved_clusters_reclaim);
 		CU_ADD_TEST(suite, blob_thin_prov_unmap_cluster);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_rle);
 		CU_ADD_TEST(suite_bs, blob_thin_prov_rw_iov);
 		CU_ADD_TEST(suite, bs_load_iter_test);
 		CU_ADD_TEST(suite_bs, blob_snapshot_rw);
 		CU_ADD_TEST(suite_bs, blob_snapshot_rw_iov);
+		CU_ADD_TEST(suite, blob_partial_cow);
+		CU_ADD_TEST(suite, blob_partial_cow_covered_units);
 		CU_ADD_TEST(suite, blob_relations);
 		CU_ADD_TEST(suite, blob_relations2);
 		CU_ADD_TEST(suite, blob_relations3);
@@ -10067,6 +11334,7 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite, blob_create_snapshot_power_failure);
 		CU_ADD_TEST(suite_bs, blob_inflate_rw);
 		CU_ADD_TEST(suite_bs, blob_snapshot_freeze_io);
+		CU_ADD_TEST(suite_bs, blob_snapshot_group);
 		CU_ADD_TEST(suite_bs, blob_operation_split_rw);
 		CU_ADD_TEST(suite_bs, blob_operation_split_rw_iov);
 		CU_ADD_TEST(suite, blob_io_unit);
@@ -10092,6 +11360,8 @@ main(int argc, char **argv)
 		CU_ADD_TEST(suite_bs, blob_clone_resize);
 		CU_ADD_TEST(suite, blob_esnap_clone_resize);
 		CU_ADD_TEST(suite_bs, blob_shallow_copy);
+		CU_ADD_TEST(suite_bs, blob_changed_clusters);
+		CU_ADD_TEST(suite_bs, blob_chain_cache);
 		CU_ADD_TEST(suite_esnap_bs, blob_set_parent);
 		CU_ADD_TEST(suite_esnap_bs, blob_set_external_parent);
 	}
@@ -722,6 +722,115 @@ test_scheduler(void)
 	free_cores();
 }
 
+static void
+test_scheduler_reactive(void)
+{
+	struct spdk_cpuset cpuset = {};
+	struct spdk_thread *thread[2];
+	struct spdk_reactor *reactor;
+	struct spdk_poller *busy;
+	uint64_t current_time = 100;
+	int i, j;
+
+	MOCK_SET(spdk_env_get_current_core, 0);
+
+	allocate_cores(2);
+
+	CU_ASSERT(spdk_reactors_init(SPDK_DEFAULT_MSG_MEMPOOL_SIZE) == 0);
+
+	spdk_scheduler_set("dynamic");
+	/* Windows of 200 ticks, a core has to be overloaded for two of them */
+	g_reactive.period_tsc = 200;
+	g_scheduler_reactive_count = 2;
+
+	for (i = 0; i < 2; i++) {
+		spdk_cpuset_set_cpu(&g_reactor_core_mask, i, true);
+	}
+	g_next_core = 0;
+
+	/* Create both threads on core 0, but allow them to run on any core. */
+	spdk_cpuset_set_cpu(&cpuset, 0, true);
+	for (i = 0; i < 2; i++) {
+		thread[i] = spdk_thread_create(NULL, &cpuset);
+		SPDK_CU_ASSERT_FATAL(thread[i] != NULL);
+		spdk_cpuset_set_cpu(spdk_thread_get_cpumask(thread[i]), 1, true);
+	}
+	reactor = spdk_reactor_get(0);
+	event_queue_run_batch(reactor);
+	CU_ASSERT(reactor->thread_count == 2);
+
+	g_reactor_state = SPDK_REACTOR_STATE_RUNNING;
+
+	for (i = 0; i < 2; i++) {
+		reactor = spdk_reactor_get(i);
+		reactor->tsc_last = current_time;
+	}
+	MOCK_SET(spdk_get_ticks, current_time);
+	CU_ASSERT(check_balance(current_time) == false);
+
+	/* Both threads keep core 0 fully busy, while core 1 is idle. */
+	for (j = 0; j < 2; j++) {
+		reactor = spdk_reactor_get(0);
+		for (i = 0; i < 2; i++) {
+			spdk_set_thread(thread[i]);
+			busy = spdk_poller_register(poller_run_busy, (void *)100, 0);
+			_reactor_run(reactor);
+			spdk_poller_unregister(&busy);
+		}
+		spdk_set_thread(NULL);
+		current_time += 200;
+		CU_ASSERT(spdk_get_ticks() == current_time);
+		_reactor_run(spdk_reactor_get(1));
+
+		/* Only the second overloaded window triggers balancing. */
+		CU_ASSERT(check_balance(current_time) == (j == 1));
+	}
+	CU_ASSERT(g_reactive.balances == 1);
+	CU_ASSERT(g_reactive.balance_pending == true);
+
+	/* Only the heaviest thread is moved to the least busy core. */
+	MOCK_SET(spdk_env_get_current_core, 0);
+	_reactors_scheduler_gather_metrics(NULL, NULL);
+	_run_events_till_completion(2);
+	CU_ASSERT(g_reactive.balance_pending == false);
+	CU_ASSERT(g_reactive.moves == 1);
+	CU_ASSERT(g_reactive.last_src_core == 0);
+	CU_ASSERT(g_reactive.last_dst_core == 1);
+
+	for (i = 0; i < 2; i++) {
+		MOCK_SET(spdk_env_get_current_core, i);
+		_reactor_run(spdk_reactor_get(i));
+	}
+	_run_events_till_completion(2);
+
+	CU_ASSERT(spdk_reactor_get(0)->thread_count == 1);
+	CU_ASSERT(spdk_reactor_get(1)->thread_count == 1);
+
+	/* The counting starts over after balancing. */
+	CU_ASSERT(check_balance(current_time + 200) == false);
+
+	g_reactor_state = SPDK_REACTOR_STATE_INITIALIZED;
+
+	for (i = 0; i < 2; i++) {
+		spdk_set_thread(thread[i]);
+		spdk_thread_exit(thread[i]);
+	}
+	for (i = 0; i < 2; i++) {
+		reactor = spdk_reactor_get(i);
+		reactor_run(reactor);
+	}
+
+	spdk_set_thread(NULL);
+
+	MOCK_CLEAR(spdk_env_get_current_core);
+	MOCK_CLEAR(spdk_get_ticks);
+	g_scheduler_reactive_count = 3;
+
+	spdk_reactors_fini();
+
+	free_cores();
+}
+
 static void
 test_bind_thread(void)
 {
@@ -1143,6 +1252,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_for_each_reactor);
 	CU_ADD_TEST(suite, test_reactor_stats);
 	CU_ADD_TEST(suite, test_scheduler);
+	CU_ADD_TEST(suite, test_scheduler_reactive);
 #ifndef __FreeBSD__
 	/* governor is only supported on Linux, so don't run this specific unit test on FreeBSD */
 	CU_ADD_TEST(suite, test_governor);
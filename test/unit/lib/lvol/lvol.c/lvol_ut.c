@@ -105,38 +105,28 @@ spdk_bs_blob_decouple_parent(struct spdk_blob_store *bs, struct spdk_io_channel
 	cb_fn(cb_arg, g_inflate_rc);
 }
 
-void
-spdk_bs_iter_next(struct spdk_blob_store *bs, struct spdk_blob *b,
-		  spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
-{
-	struct spdk_blob *next;
-	int _errno = 0;
-
-	next = TAILQ_NEXT(b, link);
-	if (next == NULL) {
-		_errno = -ENOENT;
-	} else if (next->load_status != 0) {
-		_errno = next->load_status;
-	}
-
-	cb_fn(cb_arg, next, _errno);
-}
+uint32_t g_iter_queue_depth;
 
 void
-spdk_bs_iter_first(struct spdk_blob_store *bs,
-		   spdk_blob_op_with_handle_complete cb_fn, void *cb_arg)
+spdk_bs_iter_blobs(struct spdk_blob_store *bs, uint32_t queue_depth,
+		   spdk_blob_iter_cb iter_fn, spdk_bs_op_complete cb_fn, void *cb_arg)
 {
-	struct spdk_blob *first;
-	int _errno = 0;
+	struct spdk_blob *blob;
+	int rc = 0;
 
-	first = TAILQ_FIRST(&bs->blobs);
-	if (first == NULL) {
-		_errno = -ENOENT;
-	} else if (first->load_status != 0) {
-		_errno = first->load_status;
+	g_iter_queue_depth = queue_depth;
+
+	TAILQ_FOREACH(blob, &bs->blobs, link) {
+		rc = blob->load_status;
+		if (rc == 0) {
+			rc = iter_fn(cb_arg, blob);
+		}
+		if (rc != 0) {
+			break;
+		}
 	}
 
-	cb_fn(cb_arg, first, _errno);
+	cb_fn(cb_arg, rc);
 }
 
 uint64_t
@@ -263,6 +253,20 @@ spdk_bs_blob_shallow_copy(struct spdk_blob_store *bs, struct spdk_io_channel *ch
 	return 0;
 }
 
+int
+spdk_bs_blob_shallow_copy_incremental(struct spdk_blob_store *bs,
+				      struct spdk_io_channel *channel, spdk_blob_id blobid,
+				      spdk_blob_id ancestor_id, struct spdk_bs_dev *ext_dev,
+				      spdk_blob_shallow_copy_status status_cb_fn, void *status_cb_arg,
+				      spdk_blob_op_complete cb_fn, void *cb_arg)
+{
+	cb_fn(cb_arg, 0);
+	return 0;
+}
+
+DEFINE_STUB(spdk_blob_get_changed_clusters, int, (struct spdk_blob *blob, spdk_blob_id ancestor_id,
+		struct spdk_bit_array **changed), 0);
+
 bool
 spdk_blob_is_snapshot(struct spdk_blob *blob)
 {
@@ -545,6 +549,34 @@ spdk_bs_create_snapshot(struct spdk_blob_store *bs, spdk_blob_id blobid,
 	spdk_bs_create_blob_ext(bs, NULL, cb_fn, cb_arg);
 }
 
+static void
+ut_snapshot_group_blob_created(void *cb_arg, spdk_blob_id blobid, int bserrno)
+{
+	spdk_blob_id *id = cb_arg;
+
+	*id = bserrno == 0 ? blobid : SPDK_BLOBID_INVALID;
+}
+
+static int g_snapshot_group_errno;
+
+void
+spdk_bs_create_snapshot_group(struct spdk_blob_store *bs, const spdk_blob_id *blobids,
+			      uint32_t count, const struct spdk_blob_xattr_opts *snapshot_xattrs,
+			      spdk_blob_op_with_ids_complete cb_fn, void *cb_arg)
+{
+	spdk_blob_id ids[count];
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		ids[i] = SPDK_BLOBID_INVALID;
+		if (g_snapshot_group_errno == 0) {
+			spdk_bs_create_blob_ext(bs, NULL, ut_snapshot_group_blob_created, &ids[i]);
+		}
+	}
+
+	cb_fn(cb_arg, ids, count, g_snapshot_group_errno);
+}
+
 void
 spdk_bs_create_clone(struct spdk_blob_store *bs, spdk_blob_id blobid,
 		     const struct spdk_blob_xattr_opts *clone_xattrs,
@@ -1318,6 +1350,8 @@ lvols_load(void)
 	struct spdk_lvs_with_handle_req *req;
 	struct spdk_bs_opts bs_opts;
 	struct spdk_blob *super_blob, *blob1, *blob2, *blob3;
+	struct spdk_lvs_opts opts;
+	struct spdk_lvol *lvol;
 
 	req = calloc(1, sizeof(*req));
 	SPDK_CU_ASSERT_FATAL(req != NULL);
@@ -1403,6 +1437,8 @@ lvols_load(void)
 	CU_ASSERT(g_lvserrno == 0);
 	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
 	CU_ASSERT(!TAILQ_EMPTY(&g_lvol_store->lvols));
+	CU_ASSERT(g_lvol_store->lvol_count == 3);
+	CU_ASSERT(g_iter_queue_depth == SPDK_LVS_LOAD_QUEUE_DEPTH_DEFAULT);
 
 	g_lvserrno = -1;
 	/* rc = */ spdk_lvs_unload(g_lvol_store, op_complete, NULL);
@@ -1413,6 +1449,22 @@ lvols_load(void)
 	/* CU_ASSERT(rc == 0); */
 	/* CU_ASSERT(g_lvserrno == 0); */
 
+	/* Load lvs again with a custom load queue depth */
+	g_lvol_store = NULL;
+	g_lvserrno = -1;
+	spdk_lvs_opts_init(&opts);
+	opts.load_queue_depth = 8;
+	spdk_lvs_load_ext(&dev.bs_dev, &opts, lvol_store_op_with_handle_complete, req);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+	CU_ASSERT(g_lvol_store->lvol_count == 3);
+	CU_ASSERT(g_iter_queue_depth == 8);
+	lvol = TAILQ_FIRST(&g_lvol_store->lvols);
+	SPDK_CU_ASSERT_FATAL(lvol != NULL);
+	CU_ASSERT(strcmp(lvol->name, "lvol1") == 0);
+
+	spdk_lvs_unload(g_lvol_store, op_complete, NULL);
+
 	free(req);
 	free_dev(&dev);
 }
@@ -1561,6 +1613,105 @@ lvol_snapshot(void)
 	free_dev(&dev);
 }
 
+static struct spdk_lvol *g_group_lvols[2];
+static uint32_t g_group_count;
+
+static void
+lvol_op_with_handles_complete(void *cb_arg, struct spdk_lvol **lvols, uint32_t count,
+			      int lvolerrno)
+{
+	SPDK_CU_ASSERT_FATAL(count <= SPDK_COUNTOF(g_group_lvols));
+	memcpy(g_group_lvols, lvols, count * sizeof(*lvols));
+	g_group_count = count;
+	g_lvserrno = lvolerrno;
+}
+
+static void
+lvol_snapshot_group(void)
+{
+	struct lvol_ut_bs_dev dev;
+	struct spdk_lvol *lvols[2], *dup_lvols[2];
+	struct spdk_lvs_opts opts;
+	const char *names[2];
+	uint32_t i;
+	int rc = 0;
+
+	init_dev(&dev);
+
+	spdk_lvs_opts_init(&opts);
+	snprintf(opts.name, sizeof(opts.name), "lvs");
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_init(&dev.bs_dev, &opts, lvol_store_op_with_handle_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol_store != NULL);
+
+	spdk_lvol_create(g_lvol_store, "lvol0", 10, true, LVOL_CLEAR_WITH_DEFAULT,
+			 lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	lvols[0] = g_lvol;
+
+	spdk_lvol_create(g_lvol_store, "lvol1", 10, true, LVOL_CLEAR_WITH_DEFAULT,
+			 lvol_op_with_handle_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	SPDK_CU_ASSERT_FATAL(g_lvol != NULL);
+	lvols[1] = g_lvol;
+
+	/* Same name twice within the group */
+	names[0] = "snap";
+	names[1] = "snap";
+	g_lvserrno = -1;
+	spdk_lvol_create_snapshot_group(lvols, names, 2, lvol_op_with_handles_complete, NULL);
+	CU_ASSERT(g_lvserrno == -EEXIST);
+	CU_ASSERT(TAILQ_EMPTY(&g_lvol_store->pending_lvols));
+
+	/* Same lvol twice within the group */
+	names[1] = "snap1";
+	dup_lvols[0] = lvols[0];
+	dup_lvols[1] = lvols[0];
+	g_lvserrno = -1;
+	spdk_lvol_create_snapshot_group(dup_lvols, names, 2, lvol_op_with_handles_complete, NULL);
+	CU_ASSERT(g_lvserrno == -EINVAL);
+	CU_ASSERT(TAILQ_EMPTY(&g_lvol_store->pending_lvols));
+
+	/* Blobstore failure releases all snapshot lvols */
+	g_snapshot_group_errno = -EIO;
+	g_lvserrno = -1;
+	spdk_lvol_create_snapshot_group(lvols, names, 2, lvol_op_with_handles_complete, NULL);
+	CU_ASSERT(g_lvserrno == -EIO);
+	CU_ASSERT(g_group_count == 2);
+	CU_ASSERT(g_group_lvols[0] == NULL);
+	CU_ASSERT(g_group_lvols[1] == NULL);
+	CU_ASSERT(TAILQ_EMPTY(&g_lvol_store->pending_lvols));
+	g_snapshot_group_errno = 0;
+
+	g_lvserrno = -1;
+	spdk_lvol_create_snapshot_group(lvols, names, 2, lvol_op_with_handles_complete, NULL);
+	CU_ASSERT(g_lvserrno == 0);
+	CU_ASSERT(g_group_count == 2);
+	SPDK_CU_ASSERT_FATAL(g_group_lvols[0] != NULL);
+	SPDK_CU_ASSERT_FATAL(g_group_lvols[1] != NULL);
+	CU_ASSERT_STRING_EQUAL(g_group_lvols[0]->name, "snap");
+	CU_ASSERT_STRING_EQUAL(g_group_lvols[1]->name, "snap1");
+
+	for (i = 0; i < 2; i++) {
+		spdk_lvol_close(g_group_lvols[i], op_complete, NULL);
+		CU_ASSERT(g_lvserrno == 0);
+		spdk_lvol_close(lvols[i], op_complete, NULL);
+		CU_ASSERT(g_lvserrno == 0);
+	}
+
+	g_lvserrno = -1;
+	rc = spdk_lvs_unload(g_lvol_store, op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+	g_lvol_store = NULL;
+
+	free_dev(&dev);
+}
+
 static void
 lvol_snapshot_fail(void)
 {
@@ -3385,6 +3536,16 @@ lvol_shallow_copy(void)
 	rc = spdk_lvol_shallow_copy(g_lvol, NULL, NULL, NULL, op_complete, NULL);
 	CU_ASSERT(rc == -EINVAL);
 
+	/* Successful incremental shallow copy */
+	g_lvserrno = -1;
+	rc = spdk_lvol_shallow_copy_incremental(g_lvol, g_lvol, &ext_dev, NULL, NULL, op_complete, NULL);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(g_lvserrno == 0);
+
+	/* Incremental shallow copy with null ancestor */
+	rc = spdk_lvol_shallow_copy_incremental(g_lvol, NULL, &ext_dev, NULL, NULL, op_complete, NULL);
+	CU_ASSERT(rc == -EINVAL);
+
 	spdk_lvol_close(g_lvol, op_complete, NULL);
 	CU_ASSERT(g_lvserrno == 0);
 	spdk_lvol_destroy(g_lvol, op_complete, NULL);
@@ -3581,6 +3742,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, lvols_load);
 	CU_ADD_TEST(suite, lvol_open);
 	CU_ADD_TEST(suite, lvol_snapshot);
+	CU_ADD_TEST(suite, lvol_snapshot_group);
 	CU_ADD_TEST(suite, lvol_snapshot_fail);
 	CU_ADD_TEST(suite, lvol_clone);
 	CU_ADD_TEST(suite, lvol_clone_fail);
@@ -124,6 +124,8 @@ rdma_create_event_channel(void)
 	return NULL;
 }
 
+#define UT_MAX_SRQ_WR 128
+
 DEFINE_RETURN_MOCK(ibv_query_device, int);
 int
 ibv_query_device(struct ibv_context *context,
@@ -131,6 +133,7 @@ ibv_query_device(struct ibv_context *context,
 {
 	if (device_attr) {
 		device_attr->max_sge = NVME_RDMA_MAX_SGL_DESCRIPTORS;
+		device_attr->max_srq_wr = UT_MAX_SRQ_WR;
 	}
 	HANDLE_RETURN_MOCK(ibv_query_device);
 
@@ -1368,6 +1371,150 @@ test_nvme_rdma_qpair_set_poller(void)
 	CU_ASSERT(rc == 0);
 }
 
+static void
+test_nvme_rdma_poller_srq(void)
+{
+	struct spdk_nvme_transport_poll_group *tgroup;
+	struct spdk_nvme_transport_poll_group_stat *stats = NULL;
+	struct nvme_rdma_poll_group *group;
+	struct nvme_rdma_poller *poller;
+	struct nvme_rdma_qpair rqpair[3] = {};
+	struct ibv_device dev = { .name = "/dev/test" };
+	struct ibv_context context = { .device = &dev };
+	struct rdma_cm_id cm_id = { .verbs = &context };
+	uint32_t i;
+	int rc;
+
+	g_spdk_nvme_transport_opts.rdma_srq_size = 96;
+	MOCK_SET(spdk_rdma_utils_get_pd, (struct ibv_pd *)0xDEADBEEF);
+	MOCK_SET(spdk_rdma_utils_create_mem_map, (struct spdk_rdma_utils_mem_map *)0xBAADBEEF);
+
+	tgroup = nvme_rdma_poll_group_create();
+	SPDK_CU_ASSERT_FATAL(tgroup != NULL);
+	group = nvme_rdma_poll_group(tgroup);
+
+	for (i = 0; i < SPDK_COUNTOF(rqpair); i++) {
+		rqpair[i].qpair.poll_group = tgroup;
+		rqpair[i].qpair.trtype = SPDK_NVME_TRANSPORT_RDMA;
+		rqpair[i].cm_id = &cm_id;
+		rqpair[i].num_entries = 32;
+	}
+	rqpair[2].num_entries = 64;
+
+	/* Test1: The response buffers are allocated as qpairs are added */
+	rc = nvme_rdma_qpair_set_poller(&rqpair[0].qpair);
+	CU_ASSERT(rc == 0);
+	poller = STAILQ_FIRST(&group->pollers);
+	SPDK_CU_ASSERT_FATAL(poller != NULL);
+	SPDK_CU_ASSERT_FATAL(poller->srq != NULL);
+	CU_ASSERT(rqpair[0].srq == poller->srq);
+	CU_ASSERT(rqpair[0].rsps == NULL);
+	CU_ASSERT(poller->srq_size == 96);
+	CU_ASSERT(poller->num_rsps == 32);
+	CU_ASSERT(poller->required_num_rsps == 32);
+	CU_ASSERT(poller->current_num_recvs == 32);
+
+	rc = nvme_rdma_qpair_set_poller(&rqpair[1].qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(rqpair[1].poller == poller);
+	CU_ASSERT(poller->num_rsps == 64);
+	CU_ASSERT(poller->required_num_rsps == 64);
+	CU_ASSERT(poller->current_num_recvs == 64);
+	CU_ASSERT(STAILQ_FIRST(&poller->rsps) != STAILQ_LAST(&poller->rsps, nvme_rdma_rsps, link));
+
+	/* Test2: The buffers of a destroyed qpair are reused for the next one */
+	rqpair[0].cm_id = NULL;
+	nvme_rdma_qpair_destroy(&rqpair[0]);
+	CU_ASSERT(rqpair[0].poller == NULL);
+	CU_ASSERT(rqpair[0].srq == NULL);
+	CU_ASSERT(poller->num_rsps == 64);
+	CU_ASSERT(poller->required_num_rsps == 32);
+	rqpair[0].cm_id = &cm_id;
+
+	/* Test3: The number of buffers is limited by the SRQ size */
+	rc = nvme_rdma_qpair_set_poller(&rqpair[2].qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(poller->num_rsps == 96);
+	CU_ASSERT(poller->required_num_rsps == 96);
+
+	rc = nvme_rdma_qpair_set_poller(&rqpair[0].qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(poller->num_rsps == 96);
+	CU_ASSERT(poller->required_num_rsps == 128);
+	CU_ASSERT(poller->current_num_recvs == 96);
+
+	/* Test4: Statistics */
+	poller->stats.srq_reclaimed_recvs = 7;
+	rc = nvme_rdma_poll_group_get_stats(tgroup, &stats);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(stats != NULL);
+	CU_ASSERT(stats->rdma.num_devices == 1);
+	CU_ASSERT(stats->rdma.device_stats[0].srq_size == 96);
+	CU_ASSERT(stats->rdma.device_stats[0].srq_rsps == 96);
+	CU_ASSERT(stats->rdma.device_stats[0].srq_queue_depth == 128);
+	CU_ASSERT(stats->rdma.device_stats[0].srq_reclaimed_recvs == 7);
+	nvme_rdma_poll_group_free_stats(tgroup, stats);
+
+	/* Test5: The poller goes away together with the last qpair */
+	for (i = 0; i < SPDK_COUNTOF(rqpair); i++) {
+		rqpair[i].cm_id = NULL;
+		nvme_rdma_qpair_destroy(&rqpair[i]);
+	}
+	CU_ASSERT(STAILQ_EMPTY(&group->pollers));
+
+	/* Test6: Failing to create the first response buffers fails the qpair */
+	rqpair[0].cm_id = &cm_id;
+	MOCK_SET(spdk_rdma_utils_get_translation, -EINVAL);
+	rc = nvme_rdma_qpair_set_poller(&rqpair[0].qpair);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(rqpair[0].poller == NULL);
+	CU_ASSERT(STAILQ_EMPTY(&group->pollers));
+	MOCK_CLEAR(spdk_rdma_utils_get_translation);
+
+	/* Test7: Failing to post the buffers of a new poller fails the qpair and frees them
+	 * together with the poller */
+	MOCK_SET(spdk_rdma_provider_srq_flush_recv_wrs, EIO);
+	rc = nvme_rdma_qpair_set_poller(&rqpair[0].qpair);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(rqpair[0].poller == NULL);
+	CU_ASSERT(STAILQ_EMPTY(&group->pollers));
+
+	/* Test8: When growing, the buffers stay with the poller and are posted later */
+	MOCK_SET(spdk_rdma_provider_srq_flush_recv_wrs, 0);
+	rc = nvme_rdma_qpair_set_poller(&rqpair[0].qpair);
+	CU_ASSERT(rc == 0);
+	poller = rqpair[0].poller;
+	SPDK_CU_ASSERT_FATAL(poller != NULL);
+
+	rqpair[1].cm_id = &cm_id;
+	MOCK_SET(spdk_rdma_provider_srq_flush_recv_wrs, EIO);
+	rc = nvme_rdma_qpair_set_poller(&rqpair[1].qpair);
+	CU_ASSERT(rc == -ENOMEM);
+	CU_ASSERT(rqpair[1].poller == NULL);
+	CU_ASSERT(poller->num_rsps == 64);
+	CU_ASSERT(poller->required_num_rsps == 32);
+	CU_ASSERT(poller->current_num_recvs == 64);
+	MOCK_SET(spdk_rdma_provider_srq_flush_recv_wrs, 0);
+
+	rc = nvme_rdma_qpair_set_poller(&rqpair[1].qpair);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(poller->num_rsps == 64);
+	CU_ASSERT(poller->required_num_rsps == 64);
+
+	for (i = 0; i < 2; i++) {
+		rqpair[i].cm_id = NULL;
+		nvme_rdma_qpair_destroy(&rqpair[i]);
+	}
+	CU_ASSERT(STAILQ_EMPTY(&group->pollers));
+
+	rc = nvme_rdma_poll_group_destroy(tgroup);
+	CU_ASSERT(rc == 0);
+
+	MOCK_CLEAR(spdk_rdma_utils_get_pd);
+	MOCK_SET(spdk_rdma_utils_create_mem_map, NULL);
+	g_spdk_nvme_transport_opts.rdma_srq_size = 0;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -1398,6 +1545,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvme_rdma_ctrlr_get_max_sges);
 	CU_ADD_TEST(suite, test_nvme_rdma_poll_group_get_stats);
 	CU_ADD_TEST(suite, test_nvme_rdma_qpair_set_poller);
+	CU_ADD_TEST(suite, test_nvme_rdma_poller_srq);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
@@ -218,6 +218,12 @@ DEFINE_STUB(spdk_nvmf_subsystem_is_discovery, bool, (struct spdk_nvmf_subsystem
 DEFINE_STUB(nvmf_subsystem_host_auth_required, bool, (struct spdk_nvmf_subsystem *s, const char *n),
 	    false);
 DEFINE_STUB(nvmf_qpair_auth_init, int, (struct spdk_nvmf_qpair *q), 0);
+DEFINE_STUB(nvmf_subsystem_get_host_weight, uint32_t,
+	    (struct spdk_nvmf_subsystem *s, const char *n), 1);
+DEFINE_STUB(nvmf_io_sched_submit, bool, (struct spdk_nvmf_request *r), true);
+DEFINE_STUB_V(nvmf_io_sched_complete, (struct spdk_nvmf_poll_group *g,
+				       struct spdk_nvmf_io_sched_flow *f));
+DEFINE_STUB(nvmf_io_sched_abort_request, bool, (struct spdk_nvmf_qpair *q, uint16_t c), false);
 DEFINE_STUB(nvmf_auth_request_exec, int, (struct spdk_nvmf_request *r),
 	    SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
 
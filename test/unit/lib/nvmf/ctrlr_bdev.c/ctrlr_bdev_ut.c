@@ -17,7 +17,14 @@
 
 SPDK_LOG_REGISTER_COMPONENT(nvmf)
 
-DEFINE_STUB(spdk_nvmf_request_complete, int, (struct spdk_nvmf_request *req), -1);
+static int g_request_complete_called;
+
+int
+spdk_nvmf_request_complete(struct spdk_nvmf_request *req)
+{
+	g_request_complete_called++;
+	return -1;
+}
 
 DEFINE_STUB(spdk_bdev_get_name, const char *, (const struct spdk_bdev *bdev), "test");
 
@@ -217,11 +224,51 @@ DEFINE_STUB(spdk_bdev_zcopy_end, int,
 	     spdk_bdev_io_completion_cb cb, void *cb_arg),
 	    0);
 
-DEFINE_STUB(spdk_bdev_copy_blocks, int,
-	    (struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
-	     uint64_t dst_offset_blocks, uint64_t src_offset_blocks, uint64_t num_blocks,
-	     spdk_bdev_io_completion_cb cb, void *cb_arg),
-	    0);
+struct ut_copy_io {
+	uint64_t			dst_offset_blocks;
+	uint64_t			src_offset_blocks;
+	uint64_t			num_blocks;
+	spdk_bdev_io_completion_cb	cb;
+	void				*cb_arg;
+};
+
+static struct ut_copy_io g_copy_ios[8];
+static int g_num_copy_ios;
+
+DEFINE_RETURN_MOCK(spdk_bdev_copy_blocks, int);
+int
+spdk_bdev_copy_blocks(struct spdk_bdev_desc *desc, struct spdk_io_channel *ch,
+		      uint64_t dst_offset_blocks, uint64_t src_offset_blocks, uint64_t num_blocks,
+		      spdk_bdev_io_completion_cb cb, void *cb_arg)
+{
+	struct ut_copy_io *copy_io;
+
+	HANDLE_RETURN_MOCK(spdk_bdev_copy_blocks);
+
+	SPDK_CU_ASSERT_FATAL(g_num_copy_ios < (int)SPDK_COUNTOF(g_copy_ios));
+	copy_io = &g_copy_ios[g_num_copy_ios++];
+	copy_io->dst_offset_blocks = dst_offset_blocks;
+	copy_io->src_offset_blocks = src_offset_blocks;
+	copy_io->num_blocks = num_blocks;
+	copy_io->cb = cb;
+	copy_io->cb_arg = cb_arg;
+
+	return 0;
+}
+
+/* Complete the copy submitted first */
+static void
+complete_copy_io(bool success)
+{
+	struct spdk_bdev_io bdev_io = {};
+	struct ut_copy_io copy_io;
+
+	SPDK_CU_ASSERT_FATAL(g_num_copy_ios > 0);
+	copy_io = g_copy_ios[0];
+	memmove(&g_copy_ios[0], &g_copy_ios[1], --g_num_copy_ios * sizeof(g_copy_ios[0]));
+
+	copy_io.cb(&bdev_io, success, copy_io.cb_arg);
+}
 
 DEFINE_STUB(spdk_bdev_get_max_copy, uint32_t, (const struct spdk_bdev *bdev), 0);
 
@@ -767,6 +814,7 @@ test_nvmf_bdev_ctrlr_cmd(void)
 	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INTERNAL_DEVICE_ERROR);
 
 	/* Copy blocks status asynchronous */
+	bdev.blockcnt = 2048;
 	MOCK_SET(spdk_bdev_io_type_supported, true);
 	cmd.nvme_cmd.cdw10 = 1024;
 	cmd.nvme_cmd.cdw11 = 0;
@@ -776,21 +824,27 @@ test_nvmf_bdev_ctrlr_cmd(void)
 	range.nlb = 511;
 	req.length = 32;
 	SPDK_IOV_ONE(req.iov, &req.iovcnt, &range, req.length);
+	g_request_complete_called = 0;
 	rc = nvmf_bdev_ctrlr_copy_cmd(&bdev, NULL, &ch, &req);
 	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(g_num_copy_ios == 1);
+	complete_copy_io(true);
+	CU_ASSERT(g_request_complete_called == 1);
 
-	/* Copy command not supported */
+	/* Copy command not supported, the bdev layer emulates it */
 	MOCK_SET(spdk_bdev_io_type_supported, false);
 	memset(&rsp, 0, sizeof(rsp));
 
 	rc = nvmf_bdev_ctrlr_copy_cmd(&bdev, NULL, &ch, &req);
 	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	complete_copy_io(true);
+	CU_ASSERT(g_request_complete_called == 2);
 
 	MOCK_SET(spdk_bdev_io_type_supported, true);
 
 	/* Unsupported number of source ranges */
-	cmd.nvme_cmd.cdw12_bits.copy.nr = 1;
-	req.length = 64;
+	cmd.nvme_cmd.cdw12_bits.copy.nr = NVMF_BDEV_CTRLR_MAX_COPY_RANGES;
+	req.length = (NVMF_BDEV_CTRLR_MAX_COPY_RANGES + 1) * 32;
 	memset(&rsp, 0, sizeof(rsp));
 
 	rc = nvmf_bdev_ctrlr_copy_cmd(&bdev, NULL, &ch, &req);
@@ -825,6 +879,134 @@ test_nvmf_bdev_ctrlr_cmd(void)
 	MOCK_CLEAR(spdk_bdev_io_type_supported);
 }
 
+static void
+test_nvmf_bdev_ctrlr_copy_cmd(void)
+{
+	int rc;
+	struct spdk_bdev bdev = {};
+	struct spdk_io_channel ch = {};
+	struct spdk_nvmf_request req = {};
+	struct spdk_nvmf_qpair qpair = {};
+	struct spdk_nvmf_poll_group group = {};
+	union nvmf_h2c_msg cmd = {};
+	union nvmf_c2h_msg rsp = {};
+	struct spdk_nvme_scc_source_range ranges[3] = {};
+
+	req.cmd = &cmd;
+	req.rsp = &rsp;
+	req.qpair = &qpair;
+	qpair.group = &group;
+	bdev.blocklen = 512;
+	bdev.blockcnt = 1024;
+
+	ranges[0].slba = 0;
+	ranges[0].nlb = 7;
+	ranges[1].slba = 100;
+	ranges[1].nlb = 3;
+	ranges[2].slba = 200;
+	ranges[2].nlb = 15;
+	cmd.nvme_cmd.cdw10 = 512;
+	cmd.nvme_cmd.cdw12_bits.copy.nr = 2;
+	req.length = sizeof(ranges);
+	SPDK_IOV_ONE(req.iov, &req.iovcnt, ranges, req.length);
+
+	/* The ranges don't overlap the destination, they are copied in parallel
+	 * to consecutive destination LBAs */
+	g_request_complete_called = 0;
+	rc = nvmf_bdev_ctrlr_copy_cmd(&bdev, NULL, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	SPDK_CU_ASSERT_FATAL(g_num_copy_ios == 3);
+	CU_ASSERT(g_copy_ios[0].dst_offset_blocks == 512);
+	CU_ASSERT(g_copy_ios[0].src_offset_blocks == 0);
+	CU_ASSERT(g_copy_ios[0].num_blocks == 8);
+	CU_ASSERT(g_copy_ios[1].dst_offset_blocks == 520);
+	CU_ASSERT(g_copy_ios[1].src_offset_blocks == 100);
+	CU_ASSERT(g_copy_ios[1].num_blocks == 4);
+	CU_ASSERT(g_copy_ios[2].dst_offset_blocks == 524);
+	CU_ASSERT(g_copy_ios[2].src_offset_blocks == 200);
+	CU_ASSERT(g_copy_ios[2].num_blocks == 16);
+	complete_copy_io(true);
+	complete_copy_io(true);
+	CU_ASSERT(g_request_complete_called == 0);
+	complete_copy_io(true);
+	CU_ASSERT(g_request_complete_called == 1);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS);
+
+	/* The destination overlaps the last range, the ranges are copied one by one */
+	cmd.nvme_cmd.cdw10 = 196;
+	g_request_complete_called = 0;
+	rc = nvmf_bdev_ctrlr_copy_cmd(&bdev, NULL, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	SPDK_CU_ASSERT_FATAL(g_num_copy_ios == 1);
+	CU_ASSERT(g_copy_ios[0].dst_offset_blocks == 196);
+	complete_copy_io(true);
+	SPDK_CU_ASSERT_FATAL(g_num_copy_ios == 1);
+	CU_ASSERT(g_copy_ios[0].dst_offset_blocks == 204);
+	complete_copy_io(true);
+	SPDK_CU_ASSERT_FATAL(g_num_copy_ios == 1);
+	CU_ASSERT(g_copy_ios[0].dst_offset_blocks == 208);
+	CU_ASSERT(g_request_complete_called == 0);
+	complete_copy_io(true);
+	CU_ASSERT(g_num_copy_ios == 0);
+	CU_ASSERT(g_request_complete_called == 1);
+
+	/* A failed range stops the remaining ones */
+	g_request_complete_called = 0;
+	g_bdev_nvme_status_sc = SPDK_NVME_SC_INTERNAL_DEVICE_ERROR;
+	rc = nvmf_bdev_ctrlr_copy_cmd(&bdev, NULL, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	complete_copy_io(false);
+	CU_ASSERT(g_num_copy_ios == 0);
+	CU_ASSERT(g_request_complete_called == 1);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_INTERNAL_DEVICE_ERROR);
+	reset_bdev_nvme_status();
+
+	/* No bdev_io available, the remaining ranges are submitted once one is */
+	cmd.nvme_cmd.cdw10 = 512;
+	g_request_complete_called = 0;
+	MOCK_SET(spdk_bdev_copy_blocks, -ENOMEM);
+	rc = nvmf_bdev_ctrlr_copy_cmd(&bdev, NULL, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
+	CU_ASSERT(g_num_copy_ios == 0);
+	CU_ASSERT(group.stat.pending_bdev_io == 1);
+	MOCK_CLEAR(spdk_bdev_copy_blocks);
+	req.bdev_io_wait.cb_fn(req.bdev_io_wait.cb_arg);
+	CU_ASSERT(g_num_copy_ios == 3);
+	complete_copy_io(true);
+	complete_copy_io(true);
+	complete_copy_io(true);
+	CU_ASSERT(g_request_complete_called == 1);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_SUCCESS);
+
+	/* Range longer than MSSRL */
+	MOCK_SET(spdk_bdev_get_max_copy, 8);
+	memset(&rsp, 0, sizeof(rsp));
+	rc = nvmf_bdev_ctrlr_copy_cmd(&bdev, NULL, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_COMMAND_SPECIFIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_CMD_SIZE_LIMIT_SIZE_EXCEEDED);
+	MOCK_SET(spdk_bdev_get_max_copy, 0);
+
+	/* Source range out of the namespace */
+	ranges[2].slba = 1020;
+	memset(&rsp, 0, sizeof(rsp));
+	rc = nvmf_bdev_ctrlr_copy_cmd(&bdev, NULL, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_LBA_OUT_OF_RANGE);
+	ranges[2].slba = 200;
+
+	/* Destination out of the namespace */
+	cmd.nvme_cmd.cdw10 = 1000;
+	memset(&rsp, 0, sizeof(rsp));
+	rc = nvmf_bdev_ctrlr_copy_cmd(&bdev, NULL, &ch, &req);
+	CU_ASSERT(rc == SPDK_NVMF_REQUEST_EXEC_STATUS_COMPLETE);
+	CU_ASSERT(rsp.nvme_cpl.status.sct == SPDK_NVME_SCT_GENERIC);
+	CU_ASSERT(rsp.nvme_cpl.status.sc == SPDK_NVME_SC_LBA_OUT_OF_RANGE);
+	CU_ASSERT(g_num_copy_ios == 0);
+}
+
 static void
 test_nvmf_bdev_ctrlr_read_write_cmd(void)
 {
@@ -980,6 +1162,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_spdk_nvmf_bdev_ctrlr_compare_and_write_cmd);
 	CU_ADD_TEST(suite, test_nvmf_bdev_ctrlr_zcopy_start);
 	CU_ADD_TEST(suite, test_nvmf_bdev_ctrlr_cmd);
+	CU_ADD_TEST(suite, test_nvmf_bdev_ctrlr_copy_cmd);
 	CU_ADD_TEST(suite, test_nvmf_bdev_ctrlr_read_write_cmd);
 	CU_ADD_TEST(suite, test_nvmf_bdev_ctrlr_nvme_passthru);
 
@@ -0,0 +1,426 @@
+/*   SPDX-License-Identifier: BSD-3-Clause
+ *   Copyright (C) 2024 simplyblock GmbH.
+ *   All rights reserved.
+ */
+
+#include "spdk/stdinc.h"
+#include "spdk_internal/cunit.h"
+#include "common/lib/test_env.c"
+#include "nvmf/io_sched.c"
+
+#define UT_NUM_REQS 16
+
+static struct spdk_nvmf_request *g_executed[UT_NUM_REQS * 2];
+static uint32_t g_num_executed;
+static struct spdk_nvmf_request *g_aborted[UT_NUM_REQS];
+static uint32_t g_num_aborted;
+static bool g_complete_sync;
+static union nvmf_h2c_msg g_cmd;
+
+#define UT_HOSTNQN_HEAVY "nqn.2024-01.io.spdk:heavy"
+
+uint32_t
+nvmf_subsystem_get_host_weight(struct spdk_nvmf_subsystem *subsystem, const char *hostnqn)
+{
+	return strcmp(hostnqn, UT_HOSTNQN_HEAVY) == 0 ? 3 : 1;
+}
+
+static void
+ut_complete(struct spdk_nvmf_request *req)
+{
+	struct spdk_nvmf_qpair *qpair = req->qpair;
+
+	CU_ASSERT(req->io_sched == 1);
+	req->io_sched = 0;
+	nvmf_io_sched_complete(qpair->group, qpair->io_sched_flow);
+}
+
+void
+nvmf_ctrlr_exec_scheduled_io(struct spdk_nvmf_request *req)
+{
+	SPDK_CU_ASSERT_FATAL(g_num_executed < SPDK_COUNTOF(g_executed));
+	g_executed[g_num_executed++] = req;
+
+	if (g_complete_sync) {
+		ut_complete(req);
+	}
+}
+
+void
+nvmf_ctrlr_abort_scheduled_io(struct spdk_nvmf_request *req)
+{
+	SPDK_CU_ASSERT_FATAL(g_num_aborted < SPDK_COUNTOF(g_aborted));
+	CU_ASSERT(req->io_sched == 0);
+	g_aborted[g_num_aborted++] = req;
+}
+
+static void
+ut_init_req(struct spdk_nvmf_request *req, struct spdk_nvmf_qpair *qpair, uint32_t length)
+{
+	memset(req, 0, sizeof(*req));
+	req->qpair = qpair;
+	req->cmd = &g_cmd;
+	req->length = length;
+}
+
+static void
+test_io_sched_depth(void)
+{
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ctrlr ctrlr = { .subsys = &subsystem };
+	struct spdk_nvmf_qpair qpair = { .ctrlr = &ctrlr, .group = &group };
+	struct spdk_nvmf_request req[6];
+	struct spdk_nvmf_io_sched_flow *flow;
+	uint32_t i;
+	int rc;
+
+	g_num_executed = 0;
+
+	rc = nvmf_io_sched_create(&group, 4);
+	CU_ASSERT(rc == 0);
+	SPDK_CU_ASSERT_FATAL(group.io_sched != NULL);
+
+	/* Commands are executed right away as long as there are free slots */
+	for (i = 0; i < 4; i++) {
+		ut_init_req(&req[i], &qpair, 4096);
+		CU_ASSERT(nvmf_io_sched_submit(&req[i]));
+		CU_ASSERT(req[i].io_sched == 1);
+	}
+	flow = qpair.io_sched_flow;
+	SPDK_CU_ASSERT_FATAL(flow != NULL);
+	CU_ASSERT(flow->num_qpairs == 1);
+	CU_ASSERT(flow->weight == 1);
+	CU_ASSERT(group.io_sched->outstanding == 4);
+
+	/* The following ones are queued */
+	for (i = 4; i < 6; i++) {
+		ut_init_req(&req[i], &qpair, 4096);
+		CU_ASSERT(!nvmf_io_sched_submit(&req[i]));
+		CU_ASSERT(req[i].io_sched == 0);
+	}
+	CU_ASSERT(flow->num_queued == 2);
+	CU_ASSERT(flow->delayed == 2);
+	CU_ASSERT(g_num_executed == 0);
+
+	/* Each completion dispatches one queued command, in order */
+	ut_complete(&req[0]);
+	CU_ASSERT(g_num_executed == 1);
+	CU_ASSERT(g_executed[0] == &req[4]);
+	CU_ASSERT(req[4].io_sched == 1);
+	CU_ASSERT(group.io_sched->outstanding == 4);
+
+	ut_complete(&req[1]);
+	CU_ASSERT(g_num_executed == 2);
+	CU_ASSERT(g_executed[1] == &req[5]);
+	CU_ASSERT(flow->num_queued == 0);
+	CU_ASSERT(!flow->active);
+	CU_ASSERT(TAILQ_EMPTY(&group.io_sched->active));
+
+	ut_complete(&req[2]);
+	ut_complete(&req[3]);
+	ut_complete(&req[4]);
+	ut_complete(&req[5]);
+	CU_ASSERT(g_num_executed == 2);
+	CU_ASSERT(group.io_sched->outstanding == 0);
+	CU_ASSERT(flow->outstanding == 0);
+	CU_ASSERT(flow->dispatched == 6);
+
+	nvmf_io_sched_qpair_remove(&qpair);
+	CU_ASSERT(qpair.io_sched_flow == NULL);
+	CU_ASSERT(TAILQ_EMPTY(&group.io_sched->flows));
+
+	nvmf_io_sched_destroy(&group);
+	CU_ASSERT(group.io_sched == NULL);
+}
+
+static void
+test_io_sched_weight(void)
+{
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ctrlr ctrlr[2] = {
+		{ .subsys = &subsystem },
+		{ .subsys = &subsystem, .hostnqn = UT_HOSTNQN_HEAVY },
+	};
+	struct spdk_nvmf_qpair qpair[2] = {
+		{ .ctrlr = &ctrlr[0], .group = &group },
+		{ .ctrlr = &ctrlr[1], .group = &group },
+	};
+	struct spdk_nvmf_request first, req[2][UT_NUM_REQS];
+	struct spdk_nvmf_request *prev;
+	uint32_t i, count[2] = {};
+	int rc;
+
+	g_num_executed = 0;
+
+	rc = nvmf_io_sched_create(&group, 1);
+	CU_ASSERT(rc == 0);
+
+	ut_init_req(&first, &qpair[0], 0);
+	CU_ASSERT(nvmf_io_sched_submit(&first));
+
+	/* Both controllers queue the same number of equally sized commands */
+	for (i = 0; i < UT_NUM_REQS; i++) {
+		ut_init_req(&req[0][i], &qpair[0], NVMF_IO_SCHED_QUANTUM);
+		CU_ASSERT(!nvmf_io_sched_submit(&req[0][i]));
+		ut_init_req(&req[1][i], &qpair[1], NVMF_IO_SCHED_QUANTUM);
+		CU_ASSERT(!nvmf_io_sched_submit(&req[1][i]));
+	}
+	CU_ASSERT(qpair[0].io_sched_flow != qpair[1].io_sched_flow);
+	CU_ASSERT(qpair[1].io_sched_flow->weight == 3);
+
+	/* Execute them one by one, the controller with weight 3 gets three commands executed for
+	 * every command of the other one */
+	prev = &first;
+	for (i = 0; i < UT_NUM_REQS; i++) {
+		ut_complete(prev);
+		SPDK_CU_ASSERT_FATAL(g_num_executed == i + 1);
+		prev = g_executed[i];
+		count[prev->qpair == &qpair[1]]++;
+		CU_ASSERT(prev->qpair == &qpair[i % 4 == 0 ? 0 : 1]);
+	}
+	CU_ASSERT(count[0] == UT_NUM_REQS / 4);
+	CU_ASSERT(count[1] == UT_NUM_REQS * 3 / 4);
+
+	/* Once the controller with weight 3 is out of commands, the other one gets all the slots */
+	while (g_num_executed < UT_NUM_REQS * 2) {
+		ut_complete(prev);
+		prev = g_executed[g_num_executed - 1];
+	}
+	ut_complete(prev);
+	CU_ASSERT(TAILQ_EMPTY(&group.io_sched->active));
+	CU_ASSERT(group.io_sched->outstanding == 0);
+	CU_ASSERT(qpair[0].io_sched_flow->delayed == UT_NUM_REQS);
+	CU_ASSERT(qpair[0].io_sched_flow->dispatched == UT_NUM_REQS + 1);
+	CU_ASSERT(qpair[1].io_sched_flow->dispatched == UT_NUM_REQS);
+	CU_ASSERT(qpair[1].io_sched_flow->max_queued == UT_NUM_REQS);
+
+	nvmf_io_sched_qpair_remove(&qpair[0]);
+	nvmf_io_sched_qpair_remove(&qpair[1]);
+	nvmf_io_sched_destroy(&group);
+}
+
+static void
+test_io_sched_shared_flow(void)
+{
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ctrlr ctrlr = { .subsys = &subsystem };
+	struct spdk_nvmf_qpair qpair[2] = {
+		{ .ctrlr = &ctrlr, .group = &group },
+		{ .ctrlr = &ctrlr, .group = &group },
+	};
+	struct spdk_nvmf_request req[4];
+	struct spdk_nvmf_io_sched_flow *flow;
+	uint32_t i;
+	int rc;
+
+	g_num_executed = 0;
+
+	rc = nvmf_io_sched_create(&group, 1);
+	CU_ASSERT(rc == 0);
+
+	/* The qpairs of a controller share its flow */
+	for (i = 0; i < 4; i++) {
+		ut_init_req(&req[i], &qpair[i % 2], 4096);
+		CU_ASSERT(nvmf_io_sched_submit(&req[i]) == (i == 0));
+	}
+	flow = qpair[0].io_sched_flow;
+	CU_ASSERT(qpair[1].io_sched_flow == flow);
+	CU_ASSERT(flow->num_qpairs == 2);
+	CU_ASSERT(flow->num_queued == 3);
+
+	/* Commands completing synchronously don't recurse into the scheduler, but all queued ones
+	 * still get executed */
+	g_complete_sync = true;
+	ut_complete(&req[0]);
+	g_complete_sync = false;
+	CU_ASSERT(g_num_executed == 3);
+	CU_ASSERT(g_executed[0] == &req[1]);
+	CU_ASSERT(g_executed[1] == &req[2]);
+	CU_ASSERT(g_executed[2] == &req[3]);
+	CU_ASSERT(group.io_sched->outstanding == 0);
+	CU_ASSERT(!group.io_sched->dispatching);
+
+	/* The flow is freed together with the last qpair */
+	nvmf_io_sched_qpair_remove(&qpair[0]);
+	CU_ASSERT(TAILQ_FIRST(&group.io_sched->flows) == flow);
+	CU_ASSERT(flow->num_qpairs == 1);
+	nvmf_io_sched_qpair_remove(&qpair[1]);
+	CU_ASSERT(TAILQ_EMPTY(&group.io_sched->flows));
+
+	nvmf_io_sched_destroy(&group);
+}
+
+static void
+test_io_sched_fused(void)
+{
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ctrlr ctrlr[2] = {
+		{ .subsys = &subsystem },
+		{ .subsys = &subsystem },
+	};
+	struct spdk_nvmf_qpair qpair[2] = {
+		{ .ctrlr = &ctrlr[0], .group = &group },
+		{ .ctrlr = &ctrlr[1], .group = &group },
+	};
+	union nvmf_h2c_msg cmd_first = {}, cmd_second = {};
+	struct spdk_nvmf_request req, other, compare, write;
+	int rc;
+
+	g_num_executed = 0;
+	cmd_first.nvme_cmd.opc = SPDK_NVME_OPC_COMPARE;
+	cmd_first.nvme_cmd.fuse = SPDK_NVME_CMD_FUSE_FIRST;
+	cmd_second.nvme_cmd.opc = SPDK_NVME_OPC_WRITE;
+	cmd_second.nvme_cmd.fuse = SPDK_NVME_CMD_FUSE_SECOND;
+
+	rc = nvmf_io_sched_create(&group, 1);
+	CU_ASSERT(rc == 0);
+
+	/* The compare takes the only slot and waits for the write, which is executed right
+	 * away even though there are no free slots and another controller has a command queued */
+	ut_init_req(&compare, &qpair[0], 4096);
+	compare.cmd = &cmd_first;
+	CU_ASSERT(nvmf_io_sched_submit(&compare));
+	CU_ASSERT(compare.io_sched == 1);
+
+	ut_init_req(&other, &qpair[1], 4096);
+	CU_ASSERT(!nvmf_io_sched_submit(&other));
+
+	ut_init_req(&write, &qpair[0], 4096);
+	write.cmd = &cmd_second;
+	CU_ASSERT(nvmf_io_sched_submit(&write));
+	CU_ASSERT(write.io_sched == 0);
+	CU_ASSERT(group.io_sched->outstanding == 1);
+
+	/* Completing the fused operation releases the slot */
+	ut_complete(&compare);
+	CU_ASSERT(g_num_executed == 1);
+	CU_ASSERT(g_executed[0] == &other);
+	ut_complete(&other);
+	CU_ASSERT(group.io_sched->outstanding == 0);
+
+	/* Both fused commands get queued behind a command of the same controller, and are
+	 * dispatched together using one slot */
+	g_num_executed = 0;
+	ut_init_req(&req, &qpair[0], 4096);
+	CU_ASSERT(nvmf_io_sched_submit(&req));
+
+	ut_init_req(&compare, &qpair[0], 4096);
+	compare.cmd = &cmd_first;
+	CU_ASSERT(!nvmf_io_sched_submit(&compare));
+
+	ut_init_req(&write, &qpair[0], 4096);
+	write.cmd = &cmd_second;
+	CU_ASSERT(!nvmf_io_sched_submit(&write));
+	CU_ASSERT(qpair[0].io_sched_flow->num_queued == 2);
+
+	ut_complete(&req);
+	CU_ASSERT(g_num_executed == 2);
+	CU_ASSERT(g_executed[0] == &compare);
+	CU_ASSERT(g_executed[1] == &write);
+	CU_ASSERT(compare.io_sched == 1);
+	CU_ASSERT(write.io_sched == 0);
+	CU_ASSERT(qpair[0].io_sched_flow->num_queued == 0);
+	CU_ASSERT(group.io_sched->outstanding == 1);
+
+	ut_complete(&compare);
+	CU_ASSERT(group.io_sched->outstanding == 0);
+	CU_ASSERT(TAILQ_EMPTY(&group.io_sched->active));
+
+	nvmf_io_sched_qpair_remove(&qpair[0]);
+	nvmf_io_sched_qpair_remove(&qpair[1]);
+	nvmf_io_sched_destroy(&group);
+}
+
+static void
+test_io_sched_abort(void)
+{
+	struct spdk_nvmf_poll_group group = {};
+	struct spdk_nvmf_subsystem subsystem = {};
+	struct spdk_nvmf_ctrlr ctrlr = { .subsys = &subsystem };
+	struct spdk_nvmf_qpair qpair = { .ctrlr = &ctrlr, .group = &group };
+	union nvmf_h2c_msg cmd[5] = {};
+	struct spdk_nvmf_request req[5];
+	struct spdk_nvmf_io_sched_flow *flow;
+	uint32_t i;
+	int rc;
+
+	g_num_executed = 0;
+	g_num_aborted = 0;
+
+	rc = nvmf_io_sched_create(&group, 1);
+	CU_ASSERT(rc == 0);
+
+	/* req[0] takes the only slot, the rest are queued: a plain command, a fused compare
+	 * and write, and another plain command */
+	cmd[2].nvme_cmd.opc = SPDK_NVME_OPC_COMPARE;
+	cmd[2].nvme_cmd.fuse = SPDK_NVME_CMD_FUSE_FIRST;
+	cmd[3].nvme_cmd.opc = SPDK_NVME_OPC_WRITE;
+	cmd[3].nvme_cmd.fuse = SPDK_NVME_CMD_FUSE_SECOND;
+	for (i = 0; i < 5; i++) {
+		ut_init_req(&req[i], &qpair, 4096);
+		cmd[i].nvme_cmd.cid = i;
+		req[i].cmd = &cmd[i];
+		CU_ASSERT(nvmf_io_sched_submit(&req[i]) == (i == 0));
+	}
+	flow = qpair.io_sched_flow;
+	SPDK_CU_ASSERT_FATAL(flow != NULL);
+	CU_ASSERT(flow->num_queued == 4);
+
+	/* Commands that aren't queued are left alone */
+	CU_ASSERT(!nvmf_io_sched_abort_request(&qpair, 0));
+	CU_ASSERT(!nvmf_io_sched_abort_request(&qpair, 7));
+	CU_ASSERT(g_num_aborted == 0);
+
+	CU_ASSERT(nvmf_io_sched_abort_request(&qpair, 1));
+	CU_ASSERT(g_num_aborted == 1);
+	CU_ASSERT(g_aborted[0] == &req[1]);
+	CU_ASSERT(flow->num_queued == 3);
+	CU_ASSERT(flow->active);
+
+	/* Aborting either half of a fused operation aborts both */
+	CU_ASSERT(nvmf_io_sched_abort_request(&qpair, 3));
+	CU_ASSERT(g_num_aborted == 3);
+	CU_ASSERT(g_aborted[1] == &req[2]);
+	CU_ASSERT(g_aborted[2] == &req[3]);
+	CU_ASSERT(flow->num_queued == 1);
+	CU_ASSERT(STAILQ_FIRST(&flow->queued) == &req[4]);
+
+	/* Removing the last queued command deactivates the flow */
+	CU_ASSERT(nvmf_io_sched_abort_request(&qpair, 4));
+	CU_ASSERT(g_num_aborted == 4);
+	CU_ASSERT(flow->num_queued == 0);
+	CU_ASSERT(!flow->active);
+	CU_ASSERT(TAILQ_EMPTY(&group.io_sched->active));
+
+	ut_complete(&req[0]);
+	CU_ASSERT(g_num_executed == 0);
+	CU_ASSERT(group.io_sched->outstanding == 0);
+
+	nvmf_io_sched_qpair_remove(&qpair);
+	nvmf_io_sched_destroy(&group);
+}
+
+int
+main(int argc, char **argv)
+{
+	CU_pSuite	suite = NULL;
+	unsigned int	num_failures;
+
+	CU_initialize_registry();
+
+	suite = CU_add_suite("io_sched", NULL, NULL);
+
+	CU_ADD_TEST(suite, test_io_sched_depth);
+	CU_ADD_TEST(suite, test_io_sched_weight);
+	CU_ADD_TEST(suite, test_io_sched_shared_flow);
+	CU_ADD_TEST(suite, test_io_sched_fused);
+	CU_ADD_TEST(suite, test_io_sched_abort);
+
+	num_failures = spdk_ut_run_tests(argc, argv, NULL);
+	CU_cleanup_registry();
+	return num_failures;
+}
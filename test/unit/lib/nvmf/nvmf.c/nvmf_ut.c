@@ -116,6 +116,11 @@ DEFINE_STUB(nvmf_nqn_is_discovery, bool, (const char *nqn), true);
 DEFINE_STUB(spdk_key_get_name, const char *, (struct spdk_key *k), NULL);
 DEFINE_STUB(nvmf_qpair_auth_init, int, (struct spdk_nvmf_qpair *q), 0);
 DEFINE_STUB_V(nvmf_qpair_auth_destroy, (struct spdk_nvmf_qpair *q));
+DEFINE_STUB(nvmf_io_sched_create, int, (struct spdk_nvmf_poll_group *g, uint32_t d), 0);
+DEFINE_STUB_V(nvmf_io_sched_destroy, (struct spdk_nvmf_poll_group *g));
+DEFINE_STUB_V(nvmf_io_sched_qpair_remove, (struct spdk_nvmf_qpair *q));
+DEFINE_STUB_V(nvmf_io_sched_dump_stat, (struct spdk_nvmf_poll_group *g,
+					struct spdk_json_write_ctx *w));
 
 struct spdk_io_channel {
 	struct spdk_thread		*thread;
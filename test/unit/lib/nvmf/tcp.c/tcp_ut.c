@@ -256,6 +256,12 @@ DEFINE_STUB(nvmf_ns_is_ptpl_capable, bool, (const struct spdk_nvmf_ns *ns), fals
 DEFINE_STUB(nvmf_subsystem_host_auth_required, bool, (struct spdk_nvmf_subsystem *s, const char *n),
 	    false);
 DEFINE_STUB(nvmf_qpair_auth_init, int, (struct spdk_nvmf_qpair *q), 0);
+DEFINE_STUB(nvmf_subsystem_get_host_weight, uint32_t,
+	    (struct spdk_nvmf_subsystem *s, const char *n), 1);
+DEFINE_STUB(nvmf_io_sched_submit, bool, (struct spdk_nvmf_request *r), true);
+DEFINE_STUB_V(nvmf_io_sched_complete, (struct spdk_nvmf_poll_group *g,
+				       struct spdk_nvmf_io_sched_flow *f));
+DEFINE_STUB(nvmf_io_sched_abort_request, bool, (struct spdk_nvmf_qpair *q, uint16_t c), false);
 DEFINE_STUB(nvmf_auth_request_exec, int, (struct spdk_nvmf_request *r),
 	    SPDK_NVMF_REQUEST_EXEC_STATUS_ASYNCHRONOUS);
 DEFINE_STUB(nvmf_request_get_buffers_abort, bool, (struct spdk_nvmf_request *r), false);
@@ -1286,6 +1292,99 @@ test_nvmf_tcp_pdu_ch_handle(void)
 			  struct spdk_nvme_tcp_common_pdu_hdr));
 }
 
+static void
+test_nvmf_tcp_recv_next(void)
+{
+	struct spdk_nvmf_tcp_poll_group tgroup = {};
+	struct spdk_nvmf_tcp_provided_buf pbuf = {};
+	struct spdk_nvmf_tcp_qpair tqpair = {};
+	struct spdk_nvmf_tcp_req tcp_req = {};
+	struct nvme_tcp_pdu pdu = {};
+	struct spdk_sock_group grp = {};
+	uint8_t buf[256], icd[64], hdr[8];
+	struct iovec iov;
+	int rc;
+
+	memset(buf, 0xa5, sizeof(buf));
+	tgroup.sock_group = &grp;
+	tgroup.provided_buf_size = sizeof(buf);
+	TAILQ_INIT(&tgroup.recv_pending);
+	pbuf.buf = buf;
+	pbuf.group = &tgroup;
+	pbuf.ref = 1;
+
+	tqpair.group = &tgroup;
+	tqpair.recv_next = true;
+	tqpair.recv_buf = &pbuf;
+	tqpair.recv_data = buf;
+	tqpair.recv_len = 8 + 32 + SPDK_NVME_TCP_DIGEST_LEN;
+	tqpair.host_ddgst_enable = true;
+
+	/* Headers are copied out of the provided buffer */
+	rc = nvmf_tcp_read_data(&tqpair, sizeof(hdr), hdr);
+	CU_ASSERT(rc == sizeof(hdr));
+	CU_ASSERT(tqpair.recv_data == buf + sizeof(hdr));
+	CU_ASSERT(tqpair.recv_len == 32 + SPDK_NVME_TCP_DIGEST_LEN);
+
+	/* In-capsule data in the buffer is handed to the request without a copy */
+	tcp_req.buf = icd;
+	tcp_req.req.iov[0].iov_base = icd;
+	tcp_req.req.iov[0].iov_len = 32;
+	tcp_req.req.iovcnt = 1;
+	tcp_req.req.length = 32;
+	pdu.req = &tcp_req;
+	pdu.hdr.common.pdu_type = SPDK_NVME_TCP_PDU_TYPE_CAPSULE_CMD;
+	pdu.ddgst_enable = true;
+	nvme_tcp_pdu_set_data_buf(&pdu, tcp_req.req.iov, tcp_req.req.iovcnt, 0, 32);
+
+	rc = nvmf_tcp_recv_next_payload_zcopy(&tqpair, &pdu, 32 + SPDK_NVME_TCP_DIGEST_LEN);
+	CU_ASSERT(rc == 32 + SPDK_NVME_TCP_DIGEST_LEN);
+	CU_ASSERT(tcp_req.req.iov[0].iov_base == buf + sizeof(hdr));
+	CU_ASSERT(tcp_req.req.iov[0].iov_len == 32);
+	CU_ASSERT(tcp_req.provided_buf == &pbuf);
+	CU_ASSERT(pdu.data_iov[0].iov_base == buf + sizeof(hdr));
+	CU_ASSERT(pbuf.ref == 2);
+	CU_ASSERT(tqpair.recv_len == 0);
+
+	/* A payload that isn't completely in the buffer is copied */
+	tcp_req.provided_buf = NULL;
+	tcp_req.req.iov[0].iov_base = icd;
+	tqpair.recv_data = buf;
+	tqpair.recv_len = 16;
+	nvme_tcp_pdu_set_data_buf(&pdu, tcp_req.req.iov, tcp_req.req.iovcnt, 0, 32);
+	rc = nvmf_tcp_recv_next_payload_zcopy(&tqpair, &pdu, 32 + SPDK_NVME_TCP_DIGEST_LEN);
+	CU_ASSERT(rc == 0);
+	CU_ASSERT(tcp_req.provided_buf == NULL);
+	CU_ASSERT(tcp_req.req.iov[0].iov_base == icd);
+
+	/* The data that is there is copied, the buffer is released once it's consumed */
+	MOCK_SET(spdk_sock_recv_next, -1);
+	errno = EAGAIN;
+	memset(icd, 0, sizeof(icd));
+	iov.iov_base = icd;
+	iov.iov_len = 32;
+	rc = nvmf_tcp_recv_next_readv(&tqpair, &iov, 1);
+	CU_ASSERT(rc == 16);
+	CU_ASSERT(icd[0] == 0xa5 && icd[15] == 0xa5 && icd[16] == 0);
+	CU_ASSERT(tqpair.recv_buf == NULL);
+	CU_ASSERT(tqpair.recv_len == 0);
+	CU_ASSERT(pbuf.ref == 1);
+
+	/* Nothing left to read */
+	rc = nvmf_tcp_recv_next_readv(&tqpair, &iov, 1);
+	CU_ASSERT(rc == 0);
+
+	/* Connection closed */
+	MOCK_SET(spdk_sock_recv_next, 0);
+	rc = nvmf_tcp_recv_next_readv(&tqpair, &iov, 1);
+	CU_ASSERT(rc == NVME_TCP_CONNECTION_FATAL);
+	MOCK_CLEAR(spdk_sock_recv_next);
+
+	/* The request returns its reference when it completes */
+	nvmf_tcp_provided_buf_put(&pbuf);
+	CU_ASSERT(pbuf.ref == 0);
+}
+
 static void
 test_nvmf_tcp_tls_add_remove_credentials(void)
 {
@@ -1515,6 +1614,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, test_nvmf_tcp_check_xfer_type);
 	CU_ADD_TEST(suite, test_nvmf_tcp_invalid_sgl);
 	CU_ADD_TEST(suite, test_nvmf_tcp_pdu_ch_handle);
+	CU_ADD_TEST(suite, test_nvmf_tcp_recv_next);
 	CU_ADD_TEST(suite, test_nvmf_tcp_tls_add_remove_credentials);
 	CU_ADD_TEST(suite, test_nvmf_tcp_tls_generate_psk_id);
 	CU_ADD_TEST(suite, test_nvmf_tcp_tls_generate_retained_psk);
@@ -720,6 +720,130 @@ iobuf_priority(void)
 	free_cores();
 }
 
+static struct spdk_iobuf_node_stats g_ut_node_stats[2];
+static uint32_t g_ut_num_node_stats;
+
+static void
+ut_iobuf_get_node_stats_cb(struct spdk_iobuf_module_stats *modules, uint32_t num_modules,
+			   void *cb_arg)
+{
+	SPDK_CU_ASSERT_FATAL(num_modules == 1);
+	SPDK_CU_ASSERT_FATAL(modules[0].num_nodes <= SPDK_COUNTOF(g_ut_node_stats));
+
+	memcpy(g_ut_node_stats, modules[0].nodes, modules[0].num_nodes * sizeof(*modules[0].nodes));
+	g_ut_num_node_stats = modules[0].num_nodes;
+}
+
+static void
+iobuf_numa(void)
+{
+	struct spdk_iobuf_opts opts = {
+		.small_pool_count = 2,
+		.large_pool_count = 2,
+		.small_bufsize = SMALL_BUFSIZE,
+		.large_bufsize = LARGE_BUFSIZE,
+		.enable_numa = true,
+	};
+	struct spdk_iobuf_channel ch[2] = {};
+	struct ut_iobuf_entry entry = {};
+	void *buf[3], *tmp, *base0;
+	int rc, finish = 0;
+	uint32_t i;
+
+	allocate_cores(2);
+	allocate_threads(2);
+	set_thread(0);
+
+	/* All cores of the test environment are on node 0, add node 1 by hand */
+	MOCK_SET(spdk_env_get_socket_id, 0);
+	g_iobuf.opts = opts;
+	rc = spdk_iobuf_initialize();
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_iobuf.numa_mask, 0x1);
+	rc = iobuf_node_init(1, SPDK_ENV_SOCKET_ID_ANY);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT_EQUAL(g_iobuf.num_nodes, 2);
+	base0 = g_iobuf.node[0].small_pool_base;
+
+	rc = spdk_iobuf_register_module("ut_module0");
+	CU_ASSERT_EQUAL(rc, 0);
+
+	/* The channels take buffers from the pools of the node of their core */
+	MOCK_SET(spdk_env_get_current_core, 0);
+	MOCK_SET(spdk_env_get_socket_id, 1);
+	set_thread(0);
+	rc = spdk_iobuf_channel_init(&ch[0], "ut_module0", 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT(ch[0].small.pool == g_iobuf.node[1].small_pool);
+
+	MOCK_SET(spdk_env_get_socket_id, 0);
+	set_thread(1);
+	rc = spdk_iobuf_channel_init(&ch[1], "ut_module0", 0, 0);
+	CU_ASSERT_EQUAL(rc, 0);
+	CU_ASSERT(ch[1].small.pool == g_iobuf.node[0].small_pool);
+	MOCK_CLEAR(spdk_env_get_current_core);
+	MOCK_CLEAR(spdk_env_get_socket_id);
+
+	/* Once the local pool is empty, buffers are taken from the other node */
+	set_thread(0);
+	for (i = 0; i < 3; i++) {
+		buf[i] = spdk_iobuf_get(&ch[0], SMALL_BUFSIZE, NULL, NULL);
+		SPDK_CU_ASSERT_FATAL(buf[i] != NULL);
+	}
+	CU_ASSERT(buf[2] >= base0 && (char *)buf[2] < (char *)base0 + 2 * SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(ch[0].small.stats.main, 2);
+	CU_ASSERT_EQUAL(ch[0].small.stats.remote, 1);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.node[0].small_pool), 1);
+
+	/* Only if both are empty, the request is queued */
+	set_thread(1);
+	tmp = spdk_iobuf_get(&ch[1], SMALL_BUFSIZE, NULL, NULL);
+	CU_ASSERT_PTR_NOT_NULL(tmp);
+	entry.buf = spdk_iobuf_get(&ch[1], SMALL_BUFSIZE, &entry.iobuf, ut_iobuf_get_buf_cb);
+	CU_ASSERT_PTR_NULL(entry.buf);
+	CU_ASSERT_EQUAL(ch[1].small.stats.retry, 1);
+	spdk_iobuf_put(&ch[1], tmp, SMALL_BUFSIZE);
+	CU_ASSERT_PTR_EQUAL(entry.buf, tmp);
+	spdk_iobuf_put(&ch[1], entry.buf, SMALL_BUFSIZE);
+
+	/* Buffers go back to the pool of the node they belong to */
+	set_thread(0);
+	spdk_iobuf_put(&ch[0], buf[2], SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.node[0].small_pool), 2);
+	spdk_iobuf_put(&ch[0], buf[1], SMALL_BUFSIZE);
+	spdk_iobuf_put(&ch[0], buf[0], SMALL_BUFSIZE);
+	CU_ASSERT_EQUAL(spdk_ring_count(g_iobuf.node[1].small_pool), 2);
+
+	/* Statistics are broken down by node */
+	rc = spdk_iobuf_get_stats(ut_iobuf_get_node_stats_cb, NULL);
+	CU_ASSERT_EQUAL(rc, 0);
+	poll_threads();
+	CU_ASSERT_EQUAL(g_ut_num_node_stats, 2);
+	CU_ASSERT_EQUAL(g_ut_node_stats[0].numa_id, 0);
+	CU_ASSERT_EQUAL(g_ut_node_stats[0].small_pool.main, 1);
+	CU_ASSERT_EQUAL(g_ut_node_stats[0].small_pool.retry, 1);
+	CU_ASSERT_EQUAL(g_ut_node_stats[0].small_pool.remote, 0);
+	CU_ASSERT_EQUAL(g_ut_node_stats[1].numa_id, 1);
+	CU_ASSERT_EQUAL(g_ut_node_stats[1].small_pool.main, 2);
+	CU_ASSERT_EQUAL(g_ut_node_stats[1].small_pool.remote, 1);
+
+	set_thread(0);
+	spdk_iobuf_channel_fini(&ch[0]);
+	poll_threads();
+	set_thread(1);
+	spdk_iobuf_channel_fini(&ch[1]);
+	poll_threads();
+
+	spdk_iobuf_finish(ut_iobuf_finish_cb, &finish);
+	poll_threads();
+
+	CU_ASSERT_EQUAL(finish, 1);
+	CU_ASSERT_EQUAL(g_iobuf.numa_mask, 0);
+
+	free_threads();
+	free_cores();
+}
+
 int
 main(int argc, char **argv)
 {
@@ -732,6 +856,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, iobuf);
 	CU_ADD_TEST(suite, iobuf_cache);
 	CU_ADD_TEST(suite, iobuf_priority);
+	CU_ADD_TEST(suite, iobuf_numa);
 
 	num_failures = spdk_ut_run_tests(argc, argv, NULL);
 	CU_cleanup_registry();
@@ -146,6 +146,89 @@ thread_send_msg(void)
 	free_threads();
 }
 
+#define UT_MSG_RINGS_NUM_SENDERS	5
+#define UT_MSG_RINGS_NUM_MSGS		10
+
+struct ut_msg_rings_msg {
+	uint32_t	sender;
+	uint32_t	seq;
+};
+
+static struct ut_msg_rings_msg g_msg_rings_msgs[UT_MSG_RINGS_NUM_SENDERS][UT_MSG_RINGS_NUM_MSGS];
+static uint32_t g_msg_rings_next[UT_MSG_RINGS_NUM_SENDERS];
+
+static void
+send_msg_rings_cb(void *ctx)
+{
+	struct ut_msg_rings_msg *msg = ctx;
+
+	/* Messages of each sender are executed in the order they were sent */
+	CU_ASSERT(g_msg_rings_next[msg->sender] == msg->seq);
+	g_msg_rings_next[msg->sender]++;
+}
+
+static void
+thread_send_msg_rings(void)
+{
+	struct spdk_thread *thread0;
+	uint32_t i, j;
+	int rc;
+
+	/* Invalid numbers of rings */
+	CU_ASSERT(spdk_thread_lib_set_msg_ring_count(0) == -EINVAL);
+	CU_ASSERT(spdk_thread_lib_set_msg_ring_count(3) == -EINVAL);
+	CU_ASSERT(spdk_thread_lib_set_msg_ring_count(SPDK_THREAD_MAX_MSG_RINGS * 2) == -EINVAL);
+
+	rc = spdk_thread_lib_set_msg_ring_count(4);
+	CU_ASSERT(rc == 0);
+
+	allocate_threads(UT_MSG_RINGS_NUM_SENDERS + 1);
+	set_thread(0);
+	thread0 = spdk_get_thread();
+	CU_ASSERT(thread0->num_msg_rings == 4);
+
+	/* Too late once the library is initialized */
+	CU_ASSERT(spdk_thread_lib_set_msg_ring_count(2) == -EBUSY);
+
+	memset(g_msg_rings_next, 0, sizeof(g_msg_rings_next));
+	for (j = 0; j < UT_MSG_RINGS_NUM_MSGS; j++) {
+		for (i = 0; i < UT_MSG_RINGS_NUM_SENDERS; i++) {
+			g_msg_rings_msgs[i][j].sender = i;
+			g_msg_rings_msgs[i][j].seq = j;
+			set_thread(i + 1);
+			rc = spdk_thread_send_msg(thread0, send_msg_rings_cb, &g_msg_rings_msgs[i][j]);
+			CU_ASSERT(rc == 0);
+		}
+	}
+
+	/* Every sender always uses the same ring and the senders are spread over the rings */
+	for (i = 0; i < thread0->num_msg_rings; i++) {
+		CU_ASSERT(spdk_ring_count(thread0->messages[i]) != 0);
+	}
+	CU_ASSERT(!spdk_thread_is_idle(thread0));
+
+	/* A batch is filled from more than one ring if needed, starting from a different one
+	 * each time */
+	set_thread(0);
+	CU_ASSERT(msg_queue_run_batch(thread0, 0) == SPDK_MSG_BATCH_SIZE);
+	CU_ASSERT(thread0->next_msg_ring == 1);
+	CU_ASSERT(msg_queue_count(thread0) == UT_MSG_RINGS_NUM_SENDERS * UT_MSG_RINGS_NUM_MSGS -
+		  SPDK_MSG_BATCH_SIZE);
+	poll_thread(0);
+	CU_ASSERT(msg_queue_count(thread0) == 0);
+	for (i = 0; i < UT_MSG_RINGS_NUM_SENDERS; i++) {
+		CU_ASSERT(g_msg_rings_next[i] == UT_MSG_RINGS_NUM_MSGS);
+	}
+
+	free_threads();
+
+	/* The library is back to a single ring */
+	allocate_threads(1);
+	set_thread(0);
+	CU_ASSERT(spdk_get_thread()->num_msg_rings == 1);
+	free_threads();
+}
+
 static int
 poller_run_done(void *ctx)
 {
@@ -584,6 +667,108 @@ for_each_channel_remove(void)
 	free_threads();
 }
 
+struct parallel_ctx {
+	struct spdk_io_channel		*ch[3];
+	struct spdk_io_channel_iter	*iters[3];
+	int				calls;
+	int				cpl_status;
+	bool				cpl_done;
+};
+
+static void
+parallel_ch_msg(struct spdk_io_channel_iter *i)
+{
+	struct parallel_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+	struct spdk_io_channel *ch = spdk_io_channel_iter_get_channel(i);
+	int j;
+
+	SPDK_CU_ASSERT_FATAL(ch != NULL);
+	CU_ASSERT(spdk_io_channel_get_thread(ch) == spdk_get_thread());
+	/* Complete later, to check that the other channels don't wait for this one */
+	for (j = 0; j < 3; j++) {
+		if (ctx->ch[j] == ch) {
+			ctx->iters[j] = i;
+		}
+	}
+	ctx->calls++;
+}
+
+static void
+parallel_ch_cpl(struct spdk_io_channel_iter *i, int status)
+{
+	struct parallel_ctx *ctx = spdk_io_channel_iter_get_ctx(i);
+
+	CU_ASSERT(spdk_io_channel_iter_get_channel(i) == NULL);
+	ctx->cpl_status = status;
+	ctx->cpl_done = true;
+}
+
+static void
+for_each_channel_parallel(void)
+{
+	struct parallel_ctx ctx = {};
+	int ch_count = 0;
+	int i;
+
+	allocate_threads(3);
+	for (i = 0; i < 3; i++) {
+		set_thread(i);
+		if (i == 0) {
+			spdk_io_device_register(&ch_count, channel_create, channel_destroy, sizeof(int), NULL);
+		}
+		ctx.ch[i] = spdk_get_io_channel(&ch_count);
+	}
+	CU_ASSERT(ch_count == 3);
+
+	/* All channels are visited without waiting for the previous ones to continue */
+	set_thread(0);
+	spdk_for_each_channel_parallel(&ch_count, parallel_ch_msg, &ctx, parallel_ch_cpl);
+	poll_threads();
+	CU_ASSERT(ctx.calls == 3);
+	CU_ASSERT(ctx.cpl_done == false);
+
+	/* The device can't go away while the iteration is in progress */
+	spdk_io_device_unregister(&ch_count, NULL);
+	poll_threads();
+	CU_ASSERT(!RB_EMPTY(&g_io_devices));
+
+	/* A failure doesn't stop the other channels and the first one is reported */
+	set_thread(2);
+	spdk_for_each_channel_continue(ctx.iters[2], -ENOMEM);
+	set_thread(0);
+	spdk_for_each_channel_continue(ctx.iters[0], 0);
+	poll_threads();
+	CU_ASSERT(ctx.cpl_done == false);
+	set_thread(1);
+	spdk_for_each_channel_continue(ctx.iters[1], -EIO);
+	poll_threads();
+	CU_ASSERT(ctx.cpl_done == true);
+	CU_ASSERT(ctx.cpl_status == -ENOMEM);
+	CU_ASSERT(RB_EMPTY(&g_io_devices));
+
+	for (i = 0; i < 3; i++) {
+		set_thread(i);
+		spdk_put_io_channel(ctx.ch[i]);
+	}
+	poll_threads();
+	CU_ASSERT(ch_count == 0);
+
+	/* Without any channels, only the completion is called */
+	set_thread(0);
+	spdk_io_device_register(&ch_count, channel_create, channel_destroy, sizeof(int), NULL);
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.cpl_status = -1;
+	spdk_for_each_channel_parallel(&ch_count, parallel_ch_msg, &ctx, parallel_ch_cpl);
+	poll_threads();
+	CU_ASSERT(ctx.calls == 0);
+	CU_ASSERT(ctx.cpl_done == true);
+	CU_ASSERT(ctx.cpl_status == 0);
+	spdk_io_device_unregister(&ch_count, NULL);
+	poll_threads();
+
+	free_threads();
+}
+
 struct unreg_ctx {
 	bool	ch_done;
 	bool	foreach_done;
@@ -1652,6 +1837,140 @@ multi_timed_pollers_have_same_expiration(void)
 	free_threads();
 }
 
+static int
+poller_count_runs(void *ctx)
+{
+	uint32_t *count = ctx;
+
+	(*count)++;
+
+	return SPDK_POLLER_BUSY;
+}
+
+static uint32_t
+ut_num_timed_pollers(struct spdk_thread *thread)
+{
+	struct spdk_poller *poller;
+	uint32_t count = 0;
+
+	for (poller = spdk_thread_get_first_timed_poller(thread); poller != NULL;
+	     poller = spdk_thread_get_next_timed_poller(poller)) {
+		count++;
+	}
+
+	return count;
+}
+
+static void
+timer_wheel_pollers(void)
+{
+	struct spdk_thread *thread;
+	struct spdk_poller *poller1, *poller2, *poller3, *poller4, *poller5;
+	uint32_t count1 = 0, count2 = 0, count3 = 0, count4 = 0, count5 = 0;
+	uint64_t start_ticks, i;
+
+	CU_ASSERT(spdk_thread_lib_set_timer_wheel(true) == 0);
+
+	allocate_threads(1);
+	set_thread(0);
+	thread = spdk_get_thread();
+	SPDK_CU_ASSERT_FATAL(thread->timer_wheel != NULL);
+
+	/* Too late once the library is initialized */
+	CU_ASSERT(spdk_thread_lib_set_timer_wheel(false) == -EBUSY);
+
+	start_ticks = spdk_get_ticks();
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == 0);
+
+	/* Pollers ending up on different levels of the wheel */
+	poller1 = spdk_poller_register(poller_count_runs, &count1, 10);
+	poller2 = spdk_poller_register(poller_count_runs, &count2, 100);
+	poller3 = spdk_poller_register(poller_count_runs, &count3, 5000);
+	poller4 = spdk_poller_register(poller_count_runs, &count4, 30 * SPDK_SEC_TO_USEC);
+	SPDK_CU_ASSERT_FATAL(poller1 != NULL && poller2 != NULL && poller3 != NULL && poller4 != NULL);
+
+	CU_ASSERT(ut_num_timed_pollers(thread) == 4);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == start_ticks + 10);
+
+	spdk_delay_us(9);
+	poll_threads();
+	CU_ASSERT(count1 == 0);
+
+	spdk_delay_us(1);
+	poll_threads();
+	CU_ASSERT(count1 == 1);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == start_ticks + 20);
+
+	/* Every poller runs exactly when it expires */
+	for (i = 1; i < 500; i++) {
+		spdk_delay_us(10);
+		poll_threads();
+		CU_ASSERT(count1 == i + 1);
+		CU_ASSERT(count2 == (i + 1) / 10);
+		CU_ASSERT(count3 == (i + 1) / 500);
+	}
+	CU_ASSERT(count3 == 1);
+	CU_ASSERT(count4 == 0);
+
+	/* Jump far ahead, all pollers expired once, cascading the slots of the higher levels */
+	spdk_delay_us(30 * SPDK_SEC_TO_USEC);
+	poll_threads();
+	CU_ASSERT(count1 == 501);
+	CU_ASSERT(count2 == 51);
+	CU_ASSERT(count3 == 2);
+	CU_ASSERT(count4 == 1);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == spdk_get_ticks() + 10);
+
+	/* Unregistered and paused pollers leave the wheel once they expire */
+	spdk_poller_unregister(&poller1);
+	spdk_poller_pause(poller2);
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(count1 == 501);
+	CU_ASSERT(count2 == 51);
+	CU_ASSERT(ut_num_timed_pollers(thread) == 2);
+
+	spdk_poller_resume(poller2);
+	poll_threads();
+	CU_ASSERT(ut_num_timed_pollers(thread) == 3);
+	spdk_delay_us(100);
+	poll_threads();
+	CU_ASSERT(count2 == 52);
+
+	/* A poller expiring beyond the range of the wheel is parked and placed again */
+	start_ticks = spdk_get_ticks();
+	poller5 = spdk_poller_register(poller_count_runs, &count5, 1ULL << 38);
+	SPDK_CU_ASSERT_FATAL(poller5 != NULL);
+	for (i = 0; i < (1ULL << 38) - 1; i += UINT32_MAX) {
+		spdk_delay_us(spdk_min(UINT32_MAX, (1ULL << 38) - 1 - i));
+		poll_threads();
+	}
+	CU_ASSERT(spdk_get_ticks() == start_ticks + (1ULL << 38) - 1);
+	CU_ASSERT(count5 == 0);
+	spdk_delay_us(1);
+	poll_threads();
+	CU_ASSERT(count5 == 1);
+
+	spdk_poller_unregister(&poller2);
+	spdk_poller_unregister(&poller3);
+	spdk_poller_unregister(&poller4);
+	spdk_poller_unregister(&poller5);
+	for (i = 0; i <= (1ULL << 38) / UINT32_MAX; i++) {
+		spdk_delay_us(UINT32_MAX);
+		poll_threads();
+	}
+	CU_ASSERT(ut_num_timed_pollers(thread) == 0);
+	CU_ASSERT(spdk_thread_next_poller_expiration(thread) == 0);
+
+	free_threads();
+
+	/* The library is back to the tree */
+	allocate_threads(1);
+	set_thread(0);
+	CU_ASSERT(spdk_get_thread()->timer_wheel == NULL);
+	free_threads();
+}
+
 static int
 dummy_create_cb(void *io_device, void *ctx_buf)
 {
@@ -2182,11 +2501,13 @@ main(int argc, char **argv)
 
 	CU_ADD_TEST(suite, thread_alloc);
 	CU_ADD_TEST(suite, thread_send_msg);
+	CU_ADD_TEST(suite, thread_send_msg_rings);
 	CU_ADD_TEST(suite, thread_poller);
 	CU_ADD_TEST(suite, poller_pause);
 	CU_ADD_TEST(suite, thread_for_each);
 	CU_ADD_TEST(suite, for_each_channel_remove);
 	CU_ADD_TEST(suite, for_each_channel_unreg);
+	CU_ADD_TEST(suite, for_each_channel_parallel);
 	CU_ADD_TEST(suite, thread_name);
 	CU_ADD_TEST(suite, channel);
 	CU_ADD_TEST(suite, channel_destroy_races);
@@ -2196,6 +2517,7 @@ main(int argc, char **argv)
 	CU_ADD_TEST(suite, device_unregister_and_thread_exit_race);
 	CU_ADD_TEST(suite, cache_closest_timed_poller);
 	CU_ADD_TEST(suite, multi_timed_pollers_have_same_expiration);
+	CU_ADD_TEST(suite, timer_wheel_pollers);
 	CU_ADD_TEST(suite, io_device_lookup);
 	CU_ADD_TEST(suite, spdk_spin);
 	CU_ADD_TEST(suite, for_each_channel_and_thread_exit_race);
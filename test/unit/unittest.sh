@@ -24,12 +24,14 @@ function unittest_bdev() {
 	$valgrind $testdir/lib/bdev/raid/concat.c/concat_ut
 	$valgrind $testdir/lib/bdev/raid/raid0.c/raid0_ut
 	$valgrind $testdir/lib/bdev/raid/raid1.c/raid1_ut
+	$valgrind $testdir/lib/bdev/raid/raid6.c/raid6_ut
 	$valgrind $testdir/lib/bdev/bdev_zone.c/bdev_zone_ut
 	$valgrind $testdir/lib/bdev/gpt/gpt.c/gpt_ut
 	$valgrind $testdir/lib/bdev/part.c/part_ut
 	$valgrind $testdir/lib/bdev/scsi_nvme.c/scsi_nvme_ut
 	$valgrind $testdir/lib/bdev/vbdev_lvol.c/vbdev_lvol_ut
 	$valgrind $testdir/lib/bdev/vbdev_zone_block.c/vbdev_zone_block_ut
+	$valgrind $testdir/lib/bdev/vbdev_coalesce.c/vbdev_coalesce_ut
 	$valgrind $testdir/lib/bdev/mt/bdev.c/bdev_ut
 }
 
@@ -111,6 +113,7 @@ function unittest_nvmf() {
 	$valgrind $testdir/lib/nvmf/subsystem.c/subsystem_ut
 	$valgrind $testdir/lib/nvmf/tcp.c/tcp_ut
 	$valgrind $testdir/lib/nvmf/nvmf.c/nvmf_ut
+	$valgrind $testdir/lib/nvmf/io_sched.c/io_sched_ut
 }
 
 function unittest_scsi() {